@@ -1,5 +1,7 @@
 #cmakedefine HAVE_LIBINTL_H
 #cmakedefine HAVE_SYS_RESOURCE_H
+#cmakedefine HAVE_SYS_SENDFILE_H
+#cmakedefine HAVE_SPAWN_H
 #cmakedefine HAVE_FLOCK
 #cmakedefine HAVE_LANGINFO_CODESET
 #cmakedefine HAVE_BACKTRACE
@@ -141,6 +141,8 @@ SET(WEECHAT_SOURCES
 ./src/gui/gui-nick.h
 ./src/gui/gui-nicklist.c
 ./src/gui/gui-nicklist.h
+./src/gui/gui-search.c
+./src/gui/gui-search.h
 ./src/gui/gui-window.c
 ./src/gui/gui-window.h
 ./src/plugins/alias/alias.c
@@ -0,0 +1,389 @@
+/*
+ * wee-hook-batch.c - WeeChat batch of events for print/signal hooks
+ *
+ * Copyright (C) 2003-2020 Sébastien Helleu <flashcode@flashtux.org>
+ *
+ * This file is part of WeeChat, the extensible chat client.
+ *
+ * WeeChat is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WeeChat is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WeeChat.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+/*
+ * A print or signal hook can deliver its events by batches: instead of
+ * calling the callback of hook for each event, events are accumulated in an
+ * infolist (one item by event, with same variables as arguments of the
+ * callback), and the batch callback is called once with all events.
+ *
+ * A batch is delivered when it reaches the max size, or at the end of the
+ * main loop iteration where its first event is older than the max latency
+ * (with a latency of 0, events are delivered at the end of the main loop
+ * iteration where they happened).
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "../weechat.h"
+#include "../wee-hook.h"
+#include "../wee-infolist.h"
+#include "../wee-log.h"
+#include "../wee-util.h"
+#include "../../plugins/plugin.h"
+
+
+int hook_batch_pending = 0;            /* number of batches with events     */
+
+
+/*
+ * Enables delivery of events by batches in a print or signal hook.
+ *
+ * Argument max_size is the max number of events in a batch (0 = no limit)
+ * and max_latency the max delay (in milliseconds) before delivery of the
+ * first event of a batch.
+ *
+ * If callback is NULL, batches are disabled and the hook callback is called
+ * again for each event (pending events are delivered before).
+ *
+ * Argument callback_data (if not NULL) must have been allocated by malloc,
+ * it is freed when batches are disabled or when the hook is removed.
+ *
+ * Returns:
+ *   1: OK
+ *   0: error
+ */
+
+int
+hook_batch (struct t_weechat_plugin *plugin, struct t_hook *hook,
+            int max_size, int max_latency,
+            t_hook_callback_batch *callback,
+            const void *callback_pointer,
+            void *callback_data)
+{
+    struct t_hook_batch *new_batch;
+
+    if (!hook_valid (hook) || hook->deleted || (hook->plugin != plugin)
+        || ((hook->type != HOOK_TYPE_PRINT)
+            && (hook->type != HOOK_TYPE_SIGNAL))
+        || (max_size < 0) || (max_latency < 0))
+    {
+        if (callback_data)
+            free (callback_data);
+        return 0;
+    }
+
+    if (!callback)
+    {
+        if (callback_data)
+            free (callback_data);
+        if (hook->batch)
+        {
+            hook_exec_start ();
+            hook_batch_flush (hook);
+            hook_batch_free (hook);
+            hook_exec_end ();
+        }
+        return 1;
+    }
+
+    if (!hook->batch)
+    {
+        new_batch = malloc (sizeof (*new_batch));
+        if (!new_batch)
+        {
+            if (callback_data)
+                free (callback_data);
+            return 0;
+        }
+        new_batch->callback_data = NULL;
+        new_batch->events = NULL;
+        new_batch->count = 0;
+        new_batch->time_first.tv_sec = 0;
+        new_batch->time_first.tv_usec = 0;
+        hook->batch = new_batch;
+    }
+
+    if (hook->batch->callback_data
+        && (hook->batch->callback_data != callback_data))
+    {
+        free (hook->batch->callback_data);
+    }
+    hook->batch->callback = callback;
+    hook->batch->callback_pointer = callback_pointer;
+    hook->batch->callback_data = callback_data;
+    hook->batch->max_size = max_size;
+    hook->batch->max_latency = max_latency;
+
+    return 1;
+}
+
+/*
+ * Adds an event in the batch of a hook: the caller must then add variables
+ * in the item returned and call hook_batch_add_event_end.
+ *
+ * Returns pointer to new infolist item, NULL if error.
+ */
+
+struct t_infolist_item *
+hook_batch_add_event (struct t_hook *hook)
+{
+    struct t_infolist_item *ptr_item;
+
+    if (!hook->batch)
+        return NULL;
+
+    if (!hook->batch->events)
+    {
+        hook->batch->events = infolist_new (hook->plugin);
+        if (!hook->batch->events)
+            return NULL;
+    }
+
+    ptr_item = infolist_new_item (hook->batch->events);
+    if (!ptr_item)
+        return NULL;
+
+    if (hook->batch->count == 0)
+    {
+        gettimeofday (&hook->batch->time_first, NULL);
+        hook_batch_pending++;
+    }
+    hook->batch->count++;
+
+    return ptr_item;
+}
+
+/*
+ * Delivers the batch of events of a hook (if it has events).
+ *
+ * This function must be called between hook_exec_start and hook_exec_end.
+ */
+
+void
+hook_batch_flush (struct t_hook *hook)
+{
+    struct t_hook_exec_cb hook_exec_cb;
+    struct t_infolist *events;
+
+    if (!hook->batch || (hook->batch->count == 0))
+        return;
+
+    events = hook->batch->events;
+    hook->batch->events = NULL;
+    hook->batch->count = 0;
+    hook_batch_pending--;
+
+    /* infolist may have been freed with all infolists of plugin */
+    if (!infolist_valid (events))
+        return;
+
+    hook_callback_start (hook, &hook_exec_cb);
+    (void) (hook->batch->callback) (hook->batch->callback_pointer,
+                                    hook->batch->callback_data,
+                                    events);
+    hook_callback_end (hook, &hook_exec_cb);
+
+    /* the callback is allowed to free infolist */
+    if (infolist_valid (events))
+        infolist_free (events);
+}
+
+/*
+ * Ends the add of an event in the batch of a hook: delivers the batch if its
+ * max size is reached.
+ */
+
+void
+hook_batch_add_event_end (struct t_hook *hook)
+{
+    if (hook->batch
+        && (hook->batch->max_size > 0)
+        && (hook->batch->count >= hook->batch->max_size))
+    {
+        hook_batch_flush (hook);
+    }
+}
+
+/*
+ * Checks if the batch of a hook must be delivered now.
+ *
+ * Returns:
+ *   1: batch must be delivered
+ *   0: batch must not be delivered now
+ */
+
+int
+hook_batch_is_due (struct t_hook *hook, struct timeval *tv_now)
+{
+    return (!hook->deleted
+            && !hook->running
+            && hook->batch
+            && (hook->batch->count > 0)
+            && (util_timeval_diff (&hook->batch->time_first,
+                                   tv_now) >= (long long)hook->batch->max_latency * 1000));
+}
+
+/*
+ * Delivers batches of events for which the max latency is reached (called at
+ * the end of each main loop iteration).
+ */
+
+void
+hook_batch_exec ()
+{
+    struct t_hook *ptr_hook;
+    struct t_hook_iterator hook_iterator;
+    struct timeval tv_now;
+    int i, types[2] = { HOOK_TYPE_PRINT, HOOK_TYPE_SIGNAL };
+
+    if (hook_batch_pending <= 0)
+        return;
+
+    gettimeofday (&tv_now, NULL);
+
+    hook_exec_start ();
+
+    for (i = 0; i < 2; i++)
+    {
+        hook_iterator_init (&hook_iterator, types[i]);
+        while ((ptr_hook = hook_iterator_next (&hook_iterator)))
+        {
+            if (hook_batch_is_due (ptr_hook, &tv_now))
+                hook_batch_flush (ptr_hook);
+        }
+    }
+
+    hook_exec_end ();
+}
+
+/*
+ * Returns the timeout for the poll of main loop (in milliseconds), lowered
+ * if a batch of events must be delivered before.
+ */
+
+int
+hook_batch_get_time_to_next (int timeout)
+{
+    struct t_hook *ptr_hook;
+    struct timeval tv_now;
+    long long diff;
+    int i, remaining, types[2] = { HOOK_TYPE_PRINT, HOOK_TYPE_SIGNAL };
+
+    if ((hook_batch_pending <= 0) || (timeout == 0))
+        return timeout;
+
+    gettimeofday (&tv_now, NULL);
+
+    for (i = 0; i < 2; i++)
+    {
+        for (ptr_hook = weechat_hooks[types[i]]; ptr_hook;
+             ptr_hook = ptr_hook->next_hook)
+        {
+            if (ptr_hook->deleted || !ptr_hook->batch
+                || (ptr_hook->batch->count == 0))
+            {
+                continue;
+            }
+            diff = util_timeval_diff (&ptr_hook->batch->time_first, &tv_now);
+            remaining = ptr_hook->batch->max_latency - (int)(diff / 1000);
+            if (remaining < 0)
+                remaining = 0;
+            if ((timeout < 0) || (remaining < timeout))
+                timeout = remaining;
+        }
+    }
+
+    return timeout;
+}
+
+/*
+ * Frees batch of a hook (events not delivered are lost).
+ */
+
+void
+hook_batch_free (struct t_hook *hook)
+{
+    if (!hook || !hook->batch)
+        return;
+
+    if (hook->batch->count > 0)
+        hook_batch_pending--;
+    if (hook->batch->events && infolist_valid (hook->batch->events))
+        infolist_free (hook->batch->events);
+    if (hook->batch->callback_data)
+        free (hook->batch->callback_data);
+
+    free (hook->batch);
+    hook->batch = NULL;
+}
+
+/*
+ * Adds batch data of a hook in the infolist item.
+ *
+ * Returns:
+ *   1: OK
+ *   0: error
+ */
+
+int
+hook_batch_add_to_infolist (struct t_infolist_item *item,
+                            struct t_hook *hook)
+{
+    if (!item || !hook)
+        return 0;
+
+    if (!infolist_new_var_integer (item, "batch", (hook->batch) ? 1 : 0))
+        return 0;
+    if (!hook->batch)
+        return 1;
+
+    if (!infolist_new_var_pointer (item, "batch_callback", hook->batch->callback))
+        return 0;
+    if (!infolist_new_var_pointer (item, "batch_callback_pointer", (void *)hook->batch->callback_pointer))
+        return 0;
+    if (!infolist_new_var_pointer (item, "batch_callback_data", hook->batch->callback_data))
+        return 0;
+    if (!infolist_new_var_integer (item, "batch_max_size", hook->batch->max_size))
+        return 0;
+    if (!infolist_new_var_integer (item, "batch_max_latency", hook->batch->max_latency))
+        return 0;
+    if (!infolist_new_var_integer (item, "batch_count", hook->batch->count))
+        return 0;
+
+    return 1;
+}
+
+/*
+ * Prints batch data of a hook in WeeChat log file (usually for crash dump).
+ */
+
+void
+hook_batch_print_log (struct t_hook *hook)
+{
+    if (!hook || !hook->batch)
+        return;
+
+    log_printf ("  batch:");
+    log_printf ("    callback. . . . . . . : 0x%lx", hook->batch->callback);
+    log_printf ("    callback_pointer. . . : 0x%lx", hook->batch->callback_pointer);
+    log_printf ("    callback_data . . . . : 0x%lx", hook->batch->callback_data);
+    log_printf ("    max_size. . . . . . . : %d",    hook->batch->max_size);
+    log_printf ("    max_latency . . . . . : %d",    hook->batch->max_latency);
+    log_printf ("    events. . . . . . . . : 0x%lx", hook->batch->events);
+    log_printf ("    count . . . . . . . . : %d",    hook->batch->count);
+}
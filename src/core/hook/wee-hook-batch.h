@@ -0,0 +1,63 @@
+/*
+ * Copyright (C) 2003-2020 Sébastien Helleu <flashcode@flashtux.org>
+ *
+ * This file is part of WeeChat, the extensible chat client.
+ *
+ * WeeChat is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WeeChat is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WeeChat.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef WEECHAT_HOOK_BATCH_H
+#define WEECHAT_HOOK_BATCH_H
+
+#include <sys/time.h>
+
+struct t_weechat_plugin;
+struct t_hook;
+struct t_infolist;
+struct t_infolist_item;
+
+typedef int (t_hook_callback_batch)(const void *pointer, void *data,
+                                    struct t_infolist *events);
+
+struct t_hook_batch
+{
+    t_hook_callback_batch *callback;   /* batch callback                    */
+    const void *callback_pointer;      /* pointer sent to batch callback    */
+    void *callback_data;               /* data sent to batch callback       */
+    int max_size;                      /* max number of events in a batch   */
+    int max_latency;                   /* max delay before delivery of the  */
+                                       /* first event of batch (in ms)      */
+    struct t_infolist *events;         /* events not yet delivered          */
+    int count;                         /* number of events in batch         */
+    struct timeval time_first;         /* time of first event in batch      */
+};
+
+extern int hook_batch_pending;
+
+extern int hook_batch (struct t_weechat_plugin *plugin, struct t_hook *hook,
+                       int max_size, int max_latency,
+                       t_hook_callback_batch *callback,
+                       const void *callback_pointer,
+                       void *callback_data);
+extern struct t_infolist_item *hook_batch_add_event (struct t_hook *hook);
+extern void hook_batch_flush (struct t_hook *hook);
+extern void hook_batch_add_event_end (struct t_hook *hook);
+extern void hook_batch_exec ();
+extern int hook_batch_get_time_to_next (int timeout);
+extern void hook_batch_free (struct t_hook *hook);
+extern int hook_batch_add_to_infolist (struct t_infolist_item *item,
+                                       struct t_hook *hook);
+extern void hook_batch_print_log (struct t_hook *hook);
+
+#endif /* WEECHAT_HOOK_BATCH_H */
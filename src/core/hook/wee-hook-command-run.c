@@ -75,7 +75,11 @@ hook_command_run (struct t_weechat_plugin *plugin,
     new_hook_command_run->command = strdup ((ptr_command) ? ptr_command :
                                             ((command) ? command : ""));
 
-    hook_add_to_list (new_hook);
+    if (!hook_add_to_list (new_hook))
+    {
+        hook_free_new (new_hook);
+        return NULL;
+    }
 
     return new_hook;
 }
@@ -87,7 +91,9 @@ hook_command_run (struct t_weechat_plugin *plugin,
 int
 hook_command_run_exec (struct t_gui_buffer *buffer, const char *command)
 {
-    struct t_hook *ptr_hook, *next_hook;
+    struct t_hook *ptr_hook;
+    struct t_hook_iterator hook_iterator;
+    struct t_hook_exec_cb hook_exec_cb;
     int rc, hook_matching, length;
     char *command2;
     const char *ptr_command;
@@ -109,13 +115,12 @@ hook_command_run_exec (struct t_gui_buffer *buffer, const char *command)
         }
     }
 
-    ptr_hook = weechat_hooks[HOOK_TYPE_COMMAND_RUN];
-    while (ptr_hook)
-    {
-        next_hook = ptr_hook->next_hook;
+    hook_exec_start ();
 
-        if (!ptr_hook->deleted
-            && !ptr_hook->running
+    hook_iterator_init (&hook_iterator, HOOK_TYPE_COMMAND_RUN);
+    while ((ptr_hook = hook_iterator_next (&hook_iterator)))
+    {
+        if (!ptr_hook->running
             && HOOK_COMMAND_RUN(ptr_hook, command))
         {
             hook_matching = string_match (ptr_command,
@@ -135,28 +140,29 @@ hook_command_run_exec (struct t_gui_buffer *buffer, const char *command)
 
             if (hook_matching)
             {
-                ptr_hook->running = 1;
+                hook_callback_start (ptr_hook, &hook_exec_cb);
                 rc = (HOOK_COMMAND_RUN(ptr_hook, callback)) (
                     ptr_hook->callback_pointer,
                     ptr_hook->callback_data,
                     buffer,
                     ptr_command);
-                ptr_hook->running = 0;
+                hook_callback_end (ptr_hook, &hook_exec_cb);
                 if (rc == WEECHAT_RC_OK_EAT)
                 {
                     if (command2)
                         free (command2);
+                    hook_exec_end ();
                     return rc;
                 }
             }
         }
-
-        ptr_hook = next_hook;
     }
 
     if (command2)
         free (command2);
 
+    hook_exec_end ();
+
     return WEECHAT_RC_OK;
 }
 
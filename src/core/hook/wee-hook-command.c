@@ -320,7 +320,11 @@ hook_command (struct t_weechat_plugin *plugin, const char *command,
     new_hook_command->cplt_template_args_concat = NULL;
     hook_command_build_completion (new_hook_command);
 
-    hook_add_to_list (new_hook);
+    if (!hook_add_to_list (new_hook))
+    {
+        hook_free_new (new_hook);
+        return NULL;
+    }
 
     return new_hook;
 }
@@ -343,7 +347,9 @@ int
 hook_command_exec (struct t_gui_buffer *buffer, int any_plugin,
                    struct t_weechat_plugin *plugin, const char *string)
 {
-    struct t_hook *ptr_hook, *next_hook;
+    struct t_hook *ptr_hook;
+    struct t_hook_iterator hook_iterator;
+    struct t_hook_exec_cb hook_exec_cb;
     struct t_hook *hook_plugin, *hook_other_plugin, *hook_other_plugin2;
     struct t_hook *hook_incomplete_command;
     char **argv, **argv_eol;
@@ -386,44 +392,37 @@ hook_command_exec (struct t_gui_buffer *buffer, int any_plugin,
     count_other_plugin = 0;
     allow_incomplete_commands = CONFIG_BOOLEAN(config_look_command_incomplete);
     count_incomplete_commands = 0;
-    ptr_hook = weechat_hooks[HOOK_TYPE_COMMAND];
-    while (ptr_hook)
+    hook_iterator_init (&hook_iterator, HOOK_TYPE_COMMAND);
+    while ((ptr_hook = hook_iterator_next (&hook_iterator)))
     {
-        next_hook = ptr_hook->next_hook;
-
-        if (!ptr_hook->deleted)
+        if (string_strcasecmp (ptr_command_name,
+                               HOOK_COMMAND(ptr_hook, command)) == 0)
         {
-            if (string_strcasecmp (ptr_command_name,
-                                   HOOK_COMMAND(ptr_hook, command)) == 0)
+            if (ptr_hook->plugin == plugin)
             {
-                if (ptr_hook->plugin == plugin)
-                {
-                    if (!hook_plugin)
-                        hook_plugin = ptr_hook;
-                }
-                else
-                {
-                    if (any_plugin)
-                    {
-                        if (!hook_other_plugin)
-                            hook_other_plugin = ptr_hook;
-                        else if (!hook_other_plugin2)
-                            hook_other_plugin2 = ptr_hook;
-                        count_other_plugin++;
-                    }
-                }
+                if (!hook_plugin)
+                    hook_plugin = ptr_hook;
             }
-            else if (allow_incomplete_commands
-                     && (string_strncasecmp (ptr_command_name,
-                                             HOOK_COMMAND(ptr_hook, command),
-                                             length_command_name) == 0))
+            else
             {
-                hook_incomplete_command = ptr_hook;
-                count_incomplete_commands++;
+                if (any_plugin)
+                {
+                    if (!hook_other_plugin)
+                        hook_other_plugin = ptr_hook;
+                    else if (!hook_other_plugin2)
+                        hook_other_plugin2 = ptr_hook;
+                    count_other_plugin++;
+                }
             }
         }
-
-        ptr_hook = next_hook;
+        else if (allow_incomplete_commands
+                 && (string_strncasecmp (ptr_command_name,
+                                         HOOK_COMMAND(ptr_hook, command),
+                                         length_command_name) == 0))
+        {
+            hook_incomplete_command = ptr_hook;
+            count_incomplete_commands++;
+        }
     }
 
     rc = HOOK_COMMAND_EXEC_NOT_FOUND;
@@ -483,7 +482,7 @@ hook_command_exec (struct t_gui_buffer *buffer, int any_plugin,
         else
         {
             /* execute the command! */
-            ptr_hook->running++;
+            hook_callback_start (ptr_hook, &hook_exec_cb);
             rc = (int) (HOOK_COMMAND(ptr_hook, callback))
                 (ptr_hook->callback_pointer,
                  ptr_hook->callback_data,
@@ -491,7 +490,7 @@ hook_command_exec (struct t_gui_buffer *buffer, int any_plugin,
                  argc,
                  argv,
                  argv_eol);
-            ptr_hook->running--;
+            hook_callback_end (ptr_hook, &hook_exec_cb);
             if (rc == WEECHAT_RC_ERROR)
                 rc = HOOK_COMMAND_EXEC_ERROR;
             else
@@ -77,7 +77,11 @@ hook_completion (struct t_weechat_plugin *plugin, const char *completion_item,
     new_hook_completion->description = strdup ((description) ?
                                                description : "");
 
-    hook_add_to_list (new_hook);
+    if (!hook_add_to_list (new_hook))
+    {
+        hook_free_new (new_hook);
+        return NULL;
+    }
 
     return new_hook;
 }
@@ -115,7 +119,9 @@ hook_completion_exec (struct t_weechat_plugin *plugin,
                       struct t_gui_buffer *buffer,
                       struct t_gui_completion *completion)
 {
-    struct t_hook *ptr_hook, *next_hook;
+    struct t_hook *ptr_hook;
+    struct t_hook_iterator hook_iterator;
+    struct t_hook_exec_cb hook_exec_cb;
     const char *pos;
     char *item;
 
@@ -134,27 +140,22 @@ hook_completion_exec (struct t_weechat_plugin *plugin,
     if (!item)
         return;
 
-    ptr_hook = weechat_hooks[HOOK_TYPE_COMPLETION];
-    while (ptr_hook)
+    hook_iterator_init (&hook_iterator, HOOK_TYPE_COMPLETION);
+    while ((ptr_hook = hook_iterator_next (&hook_iterator)))
     {
-        next_hook = ptr_hook->next_hook;
-
-        if (!ptr_hook->deleted
-            && !ptr_hook->running
+        if (!ptr_hook->running
             && (string_strcasecmp (HOOK_COMPLETION(ptr_hook, completion_item),
                                    item) == 0))
         {
-            ptr_hook->running = 1;
+            hook_callback_start (ptr_hook, &hook_exec_cb);
             (void) (HOOK_COMPLETION(ptr_hook, callback))
                 (ptr_hook->callback_pointer,
                  ptr_hook->callback_data,
                  completion_item,
                  buffer,
                  completion);
-            ptr_hook->running = 0;
+            hook_callback_end (ptr_hook, &hook_exec_cb);
         }
-
-        ptr_hook = next_hook;
     }
 
     free (item);
@@ -72,7 +72,11 @@ hook_config (struct t_weechat_plugin *plugin, const char *option,
     new_hook_config->option = strdup ((ptr_option) ? ptr_option :
                                       ((option) ? option : ""));
 
-    hook_add_to_list (new_hook);
+    if (!hook_add_to_list (new_hook))
+    {
+        hook_free_new (new_hook);
+        return NULL;
+    }
 
     return new_hook;
 }
@@ -84,30 +88,27 @@ hook_config (struct t_weechat_plugin *plugin, const char *option,
 void
 hook_config_exec (const char *option, const char *value)
 {
-    struct t_hook *ptr_hook, *next_hook;
+    struct t_hook *ptr_hook;
+    struct t_hook_iterator hook_iterator;
+    struct t_hook_exec_cb hook_exec_cb;
 
     hook_exec_start ();
 
-    ptr_hook = weechat_hooks[HOOK_TYPE_CONFIG];
-    while (ptr_hook)
+    hook_iterator_init (&hook_iterator, HOOK_TYPE_CONFIG);
+    while ((ptr_hook = hook_iterator_next (&hook_iterator)))
     {
-        next_hook = ptr_hook->next_hook;
-
-        if (!ptr_hook->deleted
-            && !ptr_hook->running
+        if (!ptr_hook->running
             && (!HOOK_CONFIG(ptr_hook, option)
                 || (string_match (option, HOOK_CONFIG(ptr_hook, option), 0))))
         {
-            ptr_hook->running = 1;
+            hook_callback_start (ptr_hook, &hook_exec_cb);
             (void) (HOOK_CONFIG(ptr_hook, callback))
                 (ptr_hook->callback_pointer,
                  ptr_hook->callback_data,
                  option,
                  value);
-            ptr_hook->running = 0;
+            hook_callback_end (ptr_hook, &hook_exec_cb);
         }
-
-        ptr_hook = next_hook;
     }
 
     hook_exec_end ();
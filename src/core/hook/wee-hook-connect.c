@@ -39,7 +39,7 @@
 
 
 /*
- * Hooks a connection to a peer (using fork).
+ * Hooks a connection to a peer (using a worker thread or fork).
  *
  * Returns pointer to new hook, NULL if error.
  */
@@ -103,6 +103,7 @@ hook_connect (struct t_weechat_plugin *plugin, const char *proxy,
     new_hook_connect->child_recv = -1;
     new_hook_connect->child_send = -1;
     new_hook_connect->child_pid = 0;
+    new_hook_connect->connect_job = NULL;
     new_hook_connect->hook_child_timer = NULL;
     new_hook_connect->hook_fd = NULL;
     new_hook_connect->handshake_hook_fd = NULL;
@@ -118,9 +119,13 @@ hook_connect (struct t_weechat_plugin *plugin, const char *proxy,
         }
     }
 
-    hook_add_to_list (new_hook);
+    if (!hook_add_to_list (new_hook))
+    {
+        hook_free_new (new_hook);
+        return NULL;
+    }
 
-    network_connect_with_fork (new_hook);
+    network_connect_start (new_hook);
 
     return new_hook;
 }
@@ -268,6 +273,11 @@ hook_connect_free_data (struct t_hook *hook)
         waitpid (HOOK_CONNECT(hook, child_pid), NULL, 0);
         HOOK_CONNECT(hook, child_pid) = 0;
     }
+    if (HOOK_CONNECT(hook, connect_job))
+    {
+        network_connect_job_cancel (HOOK_CONNECT(hook, connect_job));
+        HOOK_CONNECT(hook, connect_job) = NULL;
+    }
     if (HOOK_CONNECT(hook, child_read) != -1)
     {
         close (HOOK_CONNECT(hook, child_read));
@@ -356,6 +366,8 @@ hook_connect_add_to_infolist (struct t_infolist_item *item,
         return 0;
     if (!infolist_new_var_integer (item, "child_pid", HOOK_CONNECT(hook, child_pid)))
         return 0;
+    if (!infolist_new_var_pointer (item, "connect_job", HOOK_CONNECT(hook, connect_job)))
+        return 0;
     if (!infolist_new_var_pointer (item, "hook_child_timer", HOOK_CONNECT(hook, hook_child_timer)))
         return 0;
     if (!infolist_new_var_pointer (item, "hook_fd", HOOK_CONNECT(hook, hook_fd)))
@@ -404,6 +416,7 @@ hook_connect_print_log (struct t_hook *hook)
     log_printf ("    child_recv. . . . . . : %d", HOOK_CONNECT(hook, child_recv));
     log_printf ("    child_send. . . . . . : %d", HOOK_CONNECT(hook, child_send));
     log_printf ("    child_pid . . . . . . : %d", HOOK_CONNECT(hook, child_pid));
+    log_printf ("    connect_job . . . . . : 0x%lx", HOOK_CONNECT(hook, connect_job));
     log_printf ("    hook_child_timer. . . : 0x%lx", HOOK_CONNECT(hook, hook_child_timer));
     log_printf ("    hook_fd . . . . . . . : 0x%lx", HOOK_CONNECT(hook, hook_fd));
     log_printf ("    handshake_hook_fd . . : 0x%lx", HOOK_CONNECT(hook, handshake_hook_fd));
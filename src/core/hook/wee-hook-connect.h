@@ -27,6 +27,7 @@
 
 struct t_weechat_plugin;
 struct t_infolist_item;
+struct t_network_connect_job;
 
 #define HOOK_CONNECT(hook, var) (((struct t_hook_connect *)hook->hook_data)->var)
 
@@ -73,6 +74,7 @@ struct t_hook_connect
     int child_recv;                    /* to read data from child socket    */
     int child_send;                    /* to write data to child socket     */
     pid_t child_pid;                   /* pid of child process (connecting) */
+    struct t_network_connect_job *connect_job; /* job (connecting in thread) */
     struct t_hook *hook_child_timer;   /* timer for child process timeout   */
     struct t_hook *hook_fd;            /* pointer to fd hook                */
     struct t_hook *handshake_hook_fd;  /* fd hook for handshake             */
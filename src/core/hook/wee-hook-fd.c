@@ -29,11 +29,13 @@
 #include <errno.h>
 
 #include "../weechat.h"
+#include "../wee-debug.h"
 #include "../wee-hook.h"
 #include "../wee-infolist.h"
 #include "../wee-log.h"
 #include "../wee-util.h"
 #include "../../gui/gui-chat.h"
+#include "../../gui/gui-window.h"
 
 
 struct pollfd *hook_fd_pollfd = NULL;  /* file descriptors for poll()       */
@@ -167,7 +169,11 @@ hook_fd (struct t_weechat_plugin *plugin, int fd, int flag_read,
     if (flag_exception)
         new_hook_fd->flags |= HOOK_FD_FLAG_EXCEPTION;
 
-    hook_add_to_list (new_hook);
+    if (!hook_add_to_list (new_hook))
+    {
+        hook_free_new (new_hook);
+        return NULL;
+    }
 
     return new_hook;
 }
@@ -182,7 +188,9 @@ void
 hook_fd_exec ()
 {
     int i, num_fd, timeout, ready, found;
-    struct t_hook *ptr_hook, *next_hook;
+    struct t_hook *ptr_hook;
+    struct t_hook_iterator hook_iterator;
+    struct t_hook_exec_cb hook_exec_cb;
 
     if (!weechat_hooks[HOOK_TYPE_FD])
         return;
@@ -230,20 +238,20 @@ hook_fd_exec ()
     timeout = hook_timer_get_time_to_next ();
     if (hook_process_pending)
         timeout = 0;
+    timeout = hook_batch_get_time_to_next (timeout);
+    timeout = gui_window_frame_get_time_to_next (timeout);
     ready = poll (hook_fd_pollfd, num_fd, timeout);
+    debug_loop_mark (DEBUG_LOOP_PHASE_POLL);
     if (ready <= 0)
         return;
 
     /* execute callbacks for file descriptors with activity */
     hook_exec_start ();
 
-    ptr_hook = weechat_hooks[HOOK_TYPE_FD];
-    while (ptr_hook)
+    hook_iterator_init (&hook_iterator, HOOK_TYPE_FD);
+    while ((ptr_hook = hook_iterator_next (&hook_iterator)))
     {
-        next_hook = ptr_hook->next_hook;
-
-        if (!ptr_hook->deleted
-            && !ptr_hook->running)
+        if (!ptr_hook->running)
         {
             found = 0;
             for (i = 0; i < num_fd; i++)
@@ -257,16 +265,14 @@ hook_fd_exec ()
             }
             if (found)
             {
-                ptr_hook->running = 1;
+                hook_callback_start (ptr_hook, &hook_exec_cb);
                 (void) (HOOK_FD(ptr_hook, callback)) (
                     ptr_hook->callback_pointer,
                     ptr_hook->callback_data,
                     HOOK_FD(ptr_hook, fd));
-                ptr_hook->running = 0;
+                hook_callback_end (ptr_hook, &hook_exec_cb);
             }
         }
-
-        ptr_hook = next_hook;
     }
 
     hook_exec_end ();
@@ -74,7 +74,11 @@ hook_focus (struct t_weechat_plugin *plugin,
     new_hook_focus->callback = callback;
     new_hook_focus->area = strdup ((ptr_area) ? ptr_area : area);
 
-    hook_add_to_list (new_hook);
+    if (!hook_add_to_list (new_hook))
+    {
+        hook_free_new (new_hook);
+        return NULL;
+    }
 
     return new_hook;
 }
@@ -139,7 +143,9 @@ struct t_hashtable *
 hook_focus_get_data (struct t_hashtable *hashtable_focus1,
                      struct t_hashtable *hashtable_focus2)
 {
-    struct t_hook *ptr_hook, *next_hook;
+    struct t_hook *ptr_hook;
+    struct t_hook_iterator hook_iterator;
+    struct t_hook_exec_cb hook_exec_cb;
     struct t_hashtable *hashtable1, *hashtable2, *hashtable_ret;
     const char *focus1_chat, *focus1_bar_item_name, *keys;
     char **list_keys, *new_key;
@@ -159,25 +165,22 @@ hook_focus_get_data (struct t_hashtable *hashtable_focus1,
 
     hook_exec_start ();
 
-    ptr_hook = weechat_hooks[HOOK_TYPE_FOCUS];
-    while (ptr_hook)
+    hook_iterator_init (&hook_iterator, HOOK_TYPE_FOCUS);
+    while ((ptr_hook = hook_iterator_next (&hook_iterator)))
     {
-        next_hook = ptr_hook->next_hook;
-
-        if (!ptr_hook->deleted
-            && !ptr_hook->running
+        if (!ptr_hook->running
             && ((focus1_is_chat
                  && (strcmp (HOOK_FOCUS(ptr_hook, area), "chat") == 0))
                 || (focus1_bar_item_name && focus1_bar_item_name[0]
                     && (strcmp (HOOK_FOCUS(ptr_hook, area), focus1_bar_item_name) == 0))))
         {
             /* run callback for focus #1 */
-            ptr_hook->running = 1;
+            hook_callback_start (ptr_hook, &hook_exec_cb);
             hashtable_ret = (HOOK_FOCUS(ptr_hook, callback))
                 (ptr_hook->callback_pointer,
                  ptr_hook->callback_data,
                  hashtable1);
-            ptr_hook->running = 0;
+            hook_callback_end (ptr_hook, &hook_exec_cb);
             if (hashtable_ret)
             {
                 if (hashtable_ret != hashtable1)
@@ -196,12 +199,12 @@ hook_focus_get_data (struct t_hashtable *hashtable_focus1,
             /* run callback for focus #2 */
             if (hashtable2)
             {
-                ptr_hook->running = 1;
+                hook_callback_start (ptr_hook, &hook_exec_cb);
                 hashtable_ret = (HOOK_FOCUS(ptr_hook, callback))
                     (ptr_hook->callback_pointer,
                      ptr_hook->callback_data,
                      hashtable2);
-                ptr_hook->running = 0;
+                hook_callback_end (ptr_hook, &hook_exec_cb);
                 if (hashtable_ret)
                 {
                     if (hashtable_ret != hashtable2)
@@ -218,8 +221,6 @@ hook_focus_get_data (struct t_hashtable *hashtable_focus1,
                 }
             }
         }
-
-        ptr_hook = next_hook;
     }
 
     if (hashtable2)
@@ -75,7 +75,11 @@ hook_hdata (struct t_weechat_plugin *plugin, const char *hdata_name,
                                          ptr_hdata_name : hdata_name);
     new_hook_hdata->description = strdup ((description) ? description : "");
 
-    hook_add_to_list (new_hook);
+    if (!hook_add_to_list (new_hook))
+    {
+        hook_free_new (new_hook);
+        return NULL;
+    }
 
     return new_hook;
 }
@@ -87,7 +91,9 @@ hook_hdata (struct t_weechat_plugin *plugin, const char *hdata_name,
 struct t_hdata *
 hook_hdata_get (struct t_weechat_plugin *plugin, const char *hdata_name)
 {
-    struct t_hook *ptr_hook, *next_hook;
+    struct t_hook *ptr_hook;
+    struct t_hook_iterator hook_iterator;
+    struct t_hook_exec_cb hook_exec_cb;
     struct t_hdata *value;
 
     /* make C compiler happy */
@@ -105,27 +111,22 @@ hook_hdata_get (struct t_weechat_plugin *plugin, const char *hdata_name)
 
     hook_exec_start ();
 
-    ptr_hook = weechat_hooks[HOOK_TYPE_HDATA];
-    while (ptr_hook)
+    hook_iterator_init (&hook_iterator, HOOK_TYPE_HDATA);
+    while ((ptr_hook = hook_iterator_next (&hook_iterator)))
     {
-        next_hook = ptr_hook->next_hook;
-
-        if (!ptr_hook->deleted
-            && !ptr_hook->running
+        if (!ptr_hook->running
             && (strcmp (HOOK_HDATA(ptr_hook, hdata_name), hdata_name) == 0))
         {
-            ptr_hook->running = 1;
+            hook_callback_start (ptr_hook, &hook_exec_cb);
             value = (HOOK_HDATA(ptr_hook, callback))
                 (ptr_hook->callback_pointer,
                  ptr_hook->callback_data,
                  HOOK_HDATA(ptr_hook, hdata_name));
-            ptr_hook->running = 0;
+            hook_callback_end (ptr_hook, &hook_exec_cb);
 
             hook_exec_end ();
             return value;
         }
-
-        ptr_hook = next_hook;
     }
 
     hook_exec_end ();
@@ -79,7 +79,11 @@ hook_info_hashtable (struct t_weechat_plugin *plugin, const char *info_name,
     new_hook_info_hashtable->output_description = strdup ((output_description) ?
                                                           output_description : "");
 
-    hook_add_to_list (new_hook);
+    if (!hook_add_to_list (new_hook))
+    {
+        hook_free_new (new_hook);
+        return NULL;
+    }
 
     return new_hook;
 }
@@ -92,7 +96,9 @@ struct t_hashtable *
 hook_info_get_hashtable (struct t_weechat_plugin *plugin, const char *info_name,
                          struct t_hashtable *hashtable)
 {
-    struct t_hook *ptr_hook, *next_hook;
+    struct t_hook *ptr_hook;
+    struct t_hook_iterator hook_iterator;
+    struct t_hook_exec_cb hook_exec_cb;
     struct t_hashtable *value;
 
     /* make C compiler happy */
@@ -103,29 +109,24 @@ hook_info_get_hashtable (struct t_weechat_plugin *plugin, const char *info_name,
 
     hook_exec_start ();
 
-    ptr_hook = weechat_hooks[HOOK_TYPE_INFO_HASHTABLE];
-    while (ptr_hook)
+    hook_iterator_init (&hook_iterator, HOOK_TYPE_INFO_HASHTABLE);
+    while ((ptr_hook = hook_iterator_next (&hook_iterator)))
     {
-        next_hook = ptr_hook->next_hook;
-
-        if (!ptr_hook->deleted
-            && !ptr_hook->running
+        if (!ptr_hook->running
             && (string_strcasecmp (HOOK_INFO_HASHTABLE(ptr_hook, info_name),
                                    info_name) == 0))
         {
-            ptr_hook->running = 1;
+            hook_callback_start (ptr_hook, &hook_exec_cb);
             value = (HOOK_INFO_HASHTABLE(ptr_hook, callback))
                 (ptr_hook->callback_pointer,
                  ptr_hook->callback_data,
                  info_name,
                  hashtable);
-            ptr_hook->running = 0;
+            hook_callback_end (ptr_hook, &hook_exec_cb);
 
             hook_exec_end ();
             return value;
         }
-
-        ptr_hook = next_hook;
     }
 
     hook_exec_end ();
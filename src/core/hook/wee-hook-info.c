@@ -76,7 +76,11 @@ hook_info (struct t_weechat_plugin *plugin, const char *info_name,
     new_hook_info->args_description = strdup ((args_description) ?
                                               args_description : "");
 
-    hook_add_to_list (new_hook);
+    if (!hook_add_to_list (new_hook))
+    {
+        hook_free_new (new_hook);
+        return NULL;
+    }
 
     return new_hook;
 }
@@ -91,7 +95,9 @@ char *
 hook_info_get (struct t_weechat_plugin *plugin, const char *info_name,
                const char *arguments)
 {
-    struct t_hook *ptr_hook, *next_hook;
+    struct t_hook *ptr_hook;
+    struct t_hook_iterator hook_iterator;
+    struct t_hook_exec_cb hook_exec_cb;
     char *value;
 
     /* make C compiler happy */
@@ -102,29 +108,24 @@ hook_info_get (struct t_weechat_plugin *plugin, const char *info_name,
 
     hook_exec_start ();
 
-    ptr_hook = weechat_hooks[HOOK_TYPE_INFO];
-    while (ptr_hook)
+    hook_iterator_init (&hook_iterator, HOOK_TYPE_INFO);
+    while ((ptr_hook = hook_iterator_next (&hook_iterator)))
     {
-        next_hook = ptr_hook->next_hook;
-
-        if (!ptr_hook->deleted
-            && !ptr_hook->running
+        if (!ptr_hook->running
             && (string_strcasecmp (HOOK_INFO(ptr_hook, info_name),
                                    info_name) == 0))
         {
-            ptr_hook->running = 1;
+            hook_callback_start (ptr_hook, &hook_exec_cb);
             value = (HOOK_INFO(ptr_hook, callback))
                 (ptr_hook->callback_pointer,
                  ptr_hook->callback_data,
                  info_name,
                  arguments);
-            ptr_hook->running = 0;
+            hook_callback_end (ptr_hook, &hook_exec_cb);
 
             hook_exec_end ();
             return value;
         }
-
-        ptr_hook = next_hook;
     }
 
     hook_exec_end ();
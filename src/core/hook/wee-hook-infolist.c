@@ -79,7 +79,11 @@ hook_infolist (struct t_weechat_plugin *plugin, const char *infolist_name,
     new_hook_infolist->args_description = strdup ((args_description) ?
                                                   args_description : "");
 
-    hook_add_to_list (new_hook);
+    if (!hook_add_to_list (new_hook))
+    {
+        hook_free_new (new_hook);
+        return NULL;
+    }
 
     return new_hook;
 }
@@ -92,7 +96,9 @@ struct t_infolist *
 hook_infolist_get (struct t_weechat_plugin *plugin, const char *infolist_name,
                    void *pointer, const char *arguments)
 {
-    struct t_hook *ptr_hook, *next_hook;
+    struct t_hook *ptr_hook;
+    struct t_hook_iterator hook_iterator;
+    struct t_hook_exec_cb hook_exec_cb;
     struct t_infolist *value;
 
     /* make C compiler happy */
@@ -103,30 +109,25 @@ hook_infolist_get (struct t_weechat_plugin *plugin, const char *infolist_name,
 
     hook_exec_start ();
 
-    ptr_hook = weechat_hooks[HOOK_TYPE_INFOLIST];
-    while (ptr_hook)
+    hook_iterator_init (&hook_iterator, HOOK_TYPE_INFOLIST);
+    while ((ptr_hook = hook_iterator_next (&hook_iterator)))
     {
-        next_hook = ptr_hook->next_hook;
-
-        if (!ptr_hook->deleted
-            && !ptr_hook->running
+        if (!ptr_hook->running
             && (string_strcasecmp (HOOK_INFOLIST(ptr_hook, infolist_name),
                                    infolist_name) == 0))
         {
-            ptr_hook->running = 1;
+            hook_callback_start (ptr_hook, &hook_exec_cb);
             value = (HOOK_INFOLIST(ptr_hook, callback))
                 (ptr_hook->callback_pointer,
                  ptr_hook->callback_data,
                  infolist_name,
                  pointer,
                  arguments);
-            ptr_hook->running = 0;
+            hook_callback_end (ptr_hook, &hook_exec_cb);
 
             hook_exec_end ();
             return value;
         }
-
-        ptr_hook = next_hook;
     }
 
     hook_exec_end ();
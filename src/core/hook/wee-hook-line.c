@@ -88,7 +88,11 @@ hook_line (struct t_weechat_plugin *plugin, const char *buffer_type,
     new_hook_line->tags_array = string_split_tags (tags,
                                                    &new_hook_line->tags_count);
 
-    hook_add_to_list (new_hook);
+    if (!hook_add_to_list (new_hook))
+    {
+        hook_free_new (new_hook);
+        return NULL;
+    }
 
     return new_hook;
 }
@@ -100,7 +104,9 @@ hook_line (struct t_weechat_plugin *plugin, const char *buffer_type,
 void
 hook_line_exec (struct t_gui_line *line)
 {
-    struct t_hook *ptr_hook, *next_hook;
+    struct t_hook *ptr_hook;
+    struct t_hook_iterator hook_iterator;
+    struct t_hook_exec_cb hook_exec_cb;
     struct t_hashtable *hashtable, *hashtable2;
     char str_value[128], *str_tags;
 
@@ -111,12 +117,10 @@ hook_line_exec (struct t_gui_line *line)
 
     hook_exec_start ();
 
-    ptr_hook = weechat_hooks[HOOK_TYPE_LINE];
-    while (ptr_hook)
+    hook_iterator_init (&hook_iterator, HOOK_TYPE_LINE);
+    while ((ptr_hook = hook_iterator_next (&hook_iterator)))
     {
-        next_hook = ptr_hook->next_hook;
-
-        if (!ptr_hook->deleted && !ptr_hook->running
+        if (!ptr_hook->running
             && ((HOOK_LINE(ptr_hook, buffer_type) == -1)
                 || ((int)(line->data->buffer->type) == (HOOK_LINE(ptr_hook, buffer_type))))
             && string_match_list (line->data->buffer->full_name,
@@ -158,12 +162,12 @@ hook_line_exec (struct t_gui_line *line)
             HASHTABLE_SET_STR_NOT_NULL("message", line->data->message);
 
             /* run callback */
-            ptr_hook->running = 1;
+            hook_callback_start (ptr_hook, &hook_exec_cb);
             hashtable2 = (HOOK_LINE(ptr_hook, callback))
                 (ptr_hook->callback_pointer,
                  ptr_hook->callback_data,
                  hashtable);
-            ptr_hook->running = 0;
+            hook_callback_end (ptr_hook, &hook_exec_cb);
 
             if (hashtable2)
             {
@@ -173,8 +177,6 @@ hook_line_exec (struct t_gui_line *line)
                     break;
             }
         }
-
-        ptr_hook = next_hook;
     }
 
     hook_exec_end ();
@@ -71,7 +71,11 @@ hook_modifier (struct t_weechat_plugin *plugin, const char *modifier,
     new_hook_modifier->callback = callback;
     new_hook_modifier->modifier = strdup ((ptr_modifier) ? ptr_modifier : modifier);
 
-    hook_add_to_list (new_hook);
+    if (!hook_add_to_list (new_hook))
+    {
+        hook_free_new (new_hook);
+        return NULL;
+    }
 
     return new_hook;
 }
@@ -86,7 +90,9 @@ char *
 hook_modifier_exec (struct t_weechat_plugin *plugin, const char *modifier,
                     const char *modifier_data, const char *string)
 {
-    struct t_hook *ptr_hook, *next_hook;
+    struct t_hook *ptr_hook;
+    struct t_hook_iterator hook_iterator;
+    struct t_hook_exec_cb hook_exec_cb;
     char *new_msg, *message_modified;
 
     /* make C compiler happy */
@@ -102,24 +108,21 @@ hook_modifier_exec (struct t_weechat_plugin *plugin, const char *modifier,
 
     hook_exec_start ();
 
-    ptr_hook = weechat_hooks[HOOK_TYPE_MODIFIER];
-    while (ptr_hook)
+    hook_iterator_init (&hook_iterator, HOOK_TYPE_MODIFIER);
+    while ((ptr_hook = hook_iterator_next (&hook_iterator)))
     {
-        next_hook = ptr_hook->next_hook;
-
-        if (!ptr_hook->deleted
-            && !ptr_hook->running
+        if (!ptr_hook->running
             && (string_strcasecmp (HOOK_MODIFIER(ptr_hook, modifier),
                                    modifier) == 0))
         {
-            ptr_hook->running = 1;
+            hook_callback_start (ptr_hook, &hook_exec_cb);
             new_msg = (HOOK_MODIFIER(ptr_hook, callback))
                 (ptr_hook->callback_pointer,
                  ptr_hook->callback_data,
                  modifier,
                  modifier_data,
                  message_modified);
-            ptr_hook->running = 0;
+            hook_callback_end (ptr_hook, &hook_exec_cb);
 
             /* empty string returned => message dropped */
             if (new_msg && !new_msg[0])
@@ -136,8 +139,6 @@ hook_modifier_exec (struct t_weechat_plugin *plugin, const char *modifier,
                 message_modified = new_msg;
             }
         }
-
-        ptr_hook = next_hook;
     }
 
     hook_exec_end ();
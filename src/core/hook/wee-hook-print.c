@@ -75,11 +75,54 @@ hook_print (struct t_weechat_plugin *plugin, struct t_gui_buffer *buffer,
     new_hook_print->message = (message) ? strdup (message) : NULL;
     new_hook_print->strip_colors = strip_colors;
 
-    hook_add_to_list (new_hook);
+    if (!hook_add_to_list (new_hook))
+    {
+        hook_free_new (new_hook);
+        return NULL;
+    }
 
     return new_hook;
 }
 
+/*
+ * Adds a printed line in the batch of a print hook.
+ */
+
+void
+hook_print_batch_add (struct t_hook *hook, struct t_gui_buffer *buffer,
+                      struct t_gui_line *line,
+                      const char *prefix_no_color,
+                      const char *message_no_color)
+{
+    struct t_infolist_item *ptr_item;
+    char *tags;
+
+    ptr_item = hook_batch_add_event (hook);
+    if (!ptr_item)
+        return;
+
+    tags = (line->data->tags_array) ?
+        string_build_with_split_string (
+            (const char **)line->data->tags_array, ",") : NULL;
+
+    infolist_new_var_pointer (ptr_item, "buffer", buffer);
+    infolist_new_var_time (ptr_item, "date", line->data->date);
+    infolist_new_var_string (ptr_item, "tags", tags);
+    infolist_new_var_integer (ptr_item, "displayed", (int)line->data->displayed);
+    infolist_new_var_integer (ptr_item, "highlight", (int)line->data->highlight);
+    infolist_new_var_string (
+        ptr_item, "prefix",
+        (HOOK_PRINT(hook, strip_colors)) ? prefix_no_color : line->data->prefix);
+    infolist_new_var_string (
+        ptr_item, "message",
+        (HOOK_PRINT(hook, strip_colors)) ? message_no_color : line->data->message);
+
+    if (tags)
+        free (tags);
+
+    hook_batch_add_event_end (hook);
+}
+
 /*
  * Executes a print hook.
  */
@@ -87,7 +130,9 @@ hook_print (struct t_weechat_plugin *plugin, struct t_gui_buffer *buffer,
 void
 hook_print_exec (struct t_gui_buffer *buffer, struct t_gui_line *line)
 {
-    struct t_hook *ptr_hook, *next_hook;
+    struct t_hook *ptr_hook;
+    struct t_hook_iterator hook_iterator;
+    struct t_hook_exec_cb hook_exec_cb;
     char *prefix_no_color, *message_no_color;
 
     if (!weechat_hooks[HOOK_TYPE_PRINT])
@@ -109,13 +154,10 @@ hook_print_exec (struct t_gui_buffer *buffer, struct t_gui_line *line)
 
     hook_exec_start ();
 
-    ptr_hook = weechat_hooks[HOOK_TYPE_PRINT];
-    while (ptr_hook)
+    hook_iterator_init (&hook_iterator, HOOK_TYPE_PRINT);
+    while ((ptr_hook = hook_iterator_next (&hook_iterator)))
     {
-        next_hook = ptr_hook->next_hook;
-
-        if (!ptr_hook->deleted
-            && !ptr_hook->running
+        if (!ptr_hook->running
             && (!HOOK_PRINT(ptr_hook, buffer)
                 || (buffer == HOOK_PRINT(ptr_hook, buffer)))
             && (!HOOK_PRINT(ptr_hook, message)
@@ -127,8 +169,15 @@ hook_print_exec (struct t_gui_buffer *buffer, struct t_gui_line *line)
                                         HOOK_PRINT(ptr_hook, tags_count),
                                         HOOK_PRINT(ptr_hook, tags_array))))
         {
+            if (ptr_hook->batch)
+            {
+                hook_print_batch_add (ptr_hook, buffer, line,
+                                      prefix_no_color, message_no_color);
+                continue;
+            }
+
             /* run callback */
-            ptr_hook->running = 1;
+            hook_callback_start (ptr_hook, &hook_exec_cb);
             (void) (HOOK_PRINT(ptr_hook, callback))
                 (ptr_hook->callback_pointer,
                  ptr_hook->callback_data,
@@ -139,10 +188,8 @@ hook_print_exec (struct t_gui_buffer *buffer, struct t_gui_line *line)
                  (int)line->data->displayed, (int)line->data->highlight,
                  (HOOK_PRINT(ptr_hook, strip_colors)) ? prefix_no_color : line->data->prefix,
                  (HOOK_PRINT(ptr_hook, strip_colors)) ? message_no_color : line->data->message);
-            ptr_hook->running = 0;
+            hook_callback_end (ptr_hook, &hook_exec_cb);
         }
-
-        ptr_hook = next_hook;
     }
 
     if (prefix_no_color)
@@ -30,6 +30,12 @@
 #include <poll.h>
 #include <fcntl.h>
 #include <errno.h>
+#ifdef HAVE_SPAWN_H
+#include <spawn.h>
+#endif
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
 
 #include "../weechat.h"
 #include "../wee-hashtable.h"
@@ -46,11 +52,13 @@ int hook_process_pending = 0;          /* 1 if there are some process to    */
                                        /* run (via fork)                    */
 
 
+extern char **environ;
+
 void hook_process_run (struct t_hook *hook_process);
 
 
 /*
- * Hooks a process (using fork) with options in hashtable.
+ * Hooks a process (using posix_spawn or fork) with options in hashtable.
  *
  * Returns pointer to new hook, NULL if error.
  */
@@ -111,10 +119,13 @@ hook_process_hashtable (struct t_weechat_plugin *plugin,
     new_hook_process->child_write[HOOK_PROCESS_STDOUT] = -1;
     new_hook_process->child_write[HOOK_PROCESS_STDERR] = -1;
     new_hook_process->child_pid = 0;
+    new_hook_process->child_pidfd = -1;
     new_hook_process->hook_fd[HOOK_PROCESS_STDIN] = NULL;
     new_hook_process->hook_fd[HOOK_PROCESS_STDOUT] = NULL;
     new_hook_process->hook_fd[HOOK_PROCESS_STDERR] = NULL;
+    new_hook_process->hook_pidfd = NULL;
     new_hook_process->hook_timer = NULL;
+    new_hook_process->url_transfer = NULL;
     new_hook_process->buffer[HOOK_PROCESS_STDIN] = NULL;
     new_hook_process->buffer[HOOK_PROCESS_STDOUT] = stdout_buffer;
     new_hook_process->buffer[HOOK_PROCESS_STDERR] = stderr_buffer;
@@ -136,7 +147,11 @@ hook_process_hashtable (struct t_weechat_plugin *plugin,
         }
     }
 
-    hook_add_to_list (new_hook);
+    if (!hook_add_to_list (new_hook))
+    {
+        hook_free_new (new_hook);
+        return NULL;
+    }
 
     if (weechat_debug_core >= 1)
     {
@@ -149,8 +164,11 @@ hook_process_hashtable (struct t_weechat_plugin *plugin,
                          new_hook_process->timeout);
     }
 
-    if (strncmp (new_hook_process->command, "func:", 5) == 0)
+    if ((strncmp (new_hook_process->command, "func:", 5) == 0)
+        || (strncmp (new_hook_process->command, "url:", 4) == 0))
+    {
         hook_process_pending = 1;
+    }
     else
         hook_process_run (new_hook);
 
@@ -169,7 +187,7 @@ error:
 }
 
 /*
- * Hooks a process (using fork).
+ * Hooks a process (using posix_spawn or fork).
  *
  * Returns pointer to new hook, NULL if error.
  */
@@ -186,6 +204,91 @@ hook_process (struct t_weechat_plugin *plugin,
                                    callback, callback_pointer, callback_data);
 }
 
+/*
+ * Builds arguments to execute the command of a process hook: arguments are
+ * read in options "arg1", "arg2", ... if given, otherwise the command is
+ * split like the shell does.
+ *
+ * Note: result must be freed after use with function string_free_split.
+ */
+
+char **
+hook_process_get_exec_args (struct t_hook *hook_process)
+{
+    char **exec_args, *arg0, str_arg[64];
+    const char *ptr_arg;
+    int i, num_args;
+
+    num_args = 0;
+    if (HOOK_PROCESS(hook_process, options))
+    {
+        /*
+         * count number of arguments given in the hashtable options,
+         * keys are: "arg1", "arg2", ...
+         */
+        while (1)
+        {
+            snprintf (str_arg, sizeof (str_arg), "arg%d", num_args + 1);
+            ptr_arg = hashtable_get (HOOK_PROCESS(hook_process, options),
+                                     str_arg);
+            if (!ptr_arg)
+                break;
+            num_args++;
+        }
+    }
+    if (num_args > 0)
+    {
+        /*
+         * if at least one argument was found in hashtable option, the
+         * "command" contains only path to binary (without arguments), and
+         * the arguments are in hashtable
+         */
+        exec_args = malloc ((num_args + 2) * sizeof (exec_args[0]));
+        if (exec_args)
+        {
+            exec_args[0] = strdup (HOOK_PROCESS(hook_process, command));
+            for (i = 1; i <= num_args; i++)
+            {
+                snprintf (str_arg, sizeof (str_arg), "arg%d", i);
+                ptr_arg = hashtable_get (HOOK_PROCESS(hook_process, options),
+                                         str_arg);
+                exec_args[i] = (ptr_arg) ? strdup (ptr_arg) : NULL;
+            }
+            exec_args[num_args + 1] = NULL;
+        }
+    }
+    else
+    {
+        /*
+         * if no arguments were found in hashtable, make an automatic split
+         * of command, like the shell does
+         */
+        exec_args = string_split_shell (HOOK_PROCESS(hook_process, command),
+                                        NULL);
+    }
+
+    if (exec_args)
+    {
+        arg0 = string_expand_home (exec_args[0]);
+        if (arg0)
+        {
+            free (exec_args[0]);
+            exec_args[0] = arg0;
+        }
+        if (weechat_debug_core >= 1)
+        {
+            log_printf ("hook_process, command='%s'",
+                        HOOK_PROCESS(hook_process, command));
+            for (i = 0; exec_args[i]; i++)
+            {
+                log_printf ("  args[%02d] == '%s'", i, exec_args[i]);
+            }
+        }
+    }
+
+    return exec_args;
+}
+
 /*
  * Child process for hook process: executes command and returns string result
  * into pipe for WeeChat process.
@@ -194,9 +297,8 @@ hook_process (struct t_weechat_plugin *plugin,
 void
 hook_process_child (struct t_hook *hook_process)
 {
-    char **exec_args, *arg0, str_arg[64];
-    const char *ptr_url, *ptr_arg;
-    int rc, i, num_args;
+    char **exec_args;
+    int rc;
     FILE *f;
 
     /* read stdin from parent, if a pipe was defined */
@@ -251,17 +353,7 @@ hook_process_child (struct t_hook *hook_process)
 
     rc = EXIT_FAILURE;
 
-    if (strncmp (HOOK_PROCESS(hook_process, command), "url:", 4) == 0)
-    {
-        /* get URL output (on stdout or file, depending on options) */
-        ptr_url = HOOK_PROCESS(hook_process, command) + 4;
-        while (ptr_url[0] == ' ')
-        {
-            ptr_url++;
-        }
-        rc = weeurl_download (ptr_url, HOOK_PROCESS(hook_process, options));
-    }
-    else if (strncmp (HOOK_PROCESS(hook_process, command), "func:", 5) == 0)
+    if (strncmp (HOOK_PROCESS(hook_process, command), "func:", 5) == 0)
     {
         /* run a function (via the hook callback) */
         rc = (int) (HOOK_PROCESS(hook_process, callback))
@@ -274,73 +366,9 @@ hook_process_child (struct t_hook *hook_process)
     else
     {
         /* launch command */
-        num_args = 0;
-        if (HOOK_PROCESS(hook_process, options))
-        {
-            /*
-             * count number of arguments given in the hashtable options,
-             * keys are: "arg1", "arg2", ...
-             */
-            while (1)
-            {
-                snprintf (str_arg, sizeof (str_arg), "arg%d", num_args + 1);
-                ptr_arg = hashtable_get (HOOK_PROCESS(hook_process, options),
-                                         str_arg);
-                if (!ptr_arg)
-                    break;
-                num_args++;
-            }
-        }
-        if (num_args > 0)
-        {
-            /*
-             * if at least one argument was found in hashtable option, the
-             * "command" contains only path to binary (without arguments), and
-             * the arguments are in hashtable
-             */
-            exec_args = malloc ((num_args + 2) * sizeof (exec_args[0]));
-            if (exec_args)
-            {
-                exec_args[0] = strdup (HOOK_PROCESS(hook_process, command));
-                for (i = 1; i <= num_args; i++)
-                {
-                    snprintf (str_arg, sizeof (str_arg), "arg%d", i);
-                    ptr_arg = hashtable_get (HOOK_PROCESS(hook_process, options),
-                                             str_arg);
-                    exec_args[i] = (ptr_arg) ? strdup (ptr_arg) : NULL;
-                }
-                exec_args[num_args + 1] = NULL;
-            }
-        }
-        else
-        {
-            /*
-             * if no arguments were found in hashtable, make an automatic split
-             * of command, like the shell does
-             */
-            exec_args = string_split_shell (HOOK_PROCESS(hook_process, command),
-                                            NULL);
-        }
-
+        exec_args = hook_process_get_exec_args (hook_process);
         if (exec_args)
-        {
-            arg0 = string_expand_home (exec_args[0]);
-            if (arg0)
-            {
-                free (exec_args[0]);
-                exec_args[0] = arg0;
-            }
-            if (weechat_debug_core >= 1)
-            {
-                log_printf ("hook_process, command='%s'",
-                            HOOK_PROCESS(hook_process, command));
-                for (i = 0; exec_args[i]; i++)
-                {
-                    log_printf ("  args[%02d] == '%s'", i, exec_args[i]);
-                }
-            }
             execvp (exec_args[0], exec_args);
-        }
 
         /* should not be executed if execvp was OK */
         if (exec_args)
@@ -355,6 +383,95 @@ hook_process_child (struct t_hook *hook_process)
     _exit (rc);
 }
 
+/*
+ * Executes command of process hook with posix_spawn (faster than fork, which
+ * has to duplicate the page tables of WeeChat process).
+ *
+ * This is used only for commands (not for "func:", which needs a copy of
+ * WeeChat process).
+ *
+ * Returns pid of child process, -1 if error.
+ */
+
+#ifdef HAVE_SPAWN_H
+pid_t
+hook_process_spawn (struct t_hook *hook_process)
+{
+    posix_spawn_file_actions_t file_actions;
+    posix_spawnattr_t attr;
+    char **exec_args;
+    int i, rc;
+    pid_t pid;
+
+    exec_args = hook_process_get_exec_args (hook_process);
+    if (!exec_args)
+        return -1;
+
+    if (posix_spawn_file_actions_init (&file_actions) != 0)
+    {
+        string_free_split (exec_args);
+        return -1;
+    }
+    if (posix_spawnattr_init (&attr) != 0)
+    {
+        posix_spawn_file_actions_destroy (&file_actions);
+        string_free_split (exec_args);
+        return -1;
+    }
+
+    /* same as setuid (getuid ()) in forked child */
+    posix_spawnattr_setflags (&attr, POSIX_SPAWN_RESETIDS);
+
+    /* stdin: pipe from parent (if given) or "/dev/null" */
+    if (HOOK_PROCESS(hook_process, child_read[HOOK_PROCESS_STDIN]) >= 0)
+    {
+        posix_spawn_file_actions_adddup2 (
+            &file_actions,
+            HOOK_PROCESS(hook_process, child_read[HOOK_PROCESS_STDIN]),
+            STDIN_FILENO);
+        posix_spawn_file_actions_addclose (
+            &file_actions,
+            HOOK_PROCESS(hook_process, child_write[HOOK_PROCESS_STDIN]));
+    }
+    else
+    {
+        posix_spawn_file_actions_addopen (&file_actions, STDIN_FILENO,
+                                          "/dev/null", O_RDONLY, 0);
+    }
+
+    /* stdout/stderr: pipes to parent, or "/dev/null" in detached mode */
+    for (i = HOOK_PROCESS_STDOUT; i <= HOOK_PROCESS_STDERR; i++)
+    {
+        if (HOOK_PROCESS(hook_process, child_read[i]) >= 0)
+        {
+            posix_spawn_file_actions_addclose (
+                &file_actions,
+                HOOK_PROCESS(hook_process, child_read[i]));
+            posix_spawn_file_actions_adddup2 (
+                &file_actions,
+                HOOK_PROCESS(hook_process, child_write[i]),
+                (i == HOOK_PROCESS_STDOUT) ? STDOUT_FILENO : STDERR_FILENO);
+        }
+        else
+        {
+            posix_spawn_file_actions_addopen (
+                &file_actions,
+                (i == HOOK_PROCESS_STDOUT) ? STDOUT_FILENO : STDERR_FILENO,
+                "/dev/null", O_WRONLY, 0);
+        }
+    }
+
+    rc = posix_spawnp (&pid, exec_args[0], &file_actions, &attr,
+                       exec_args, environ);
+
+    posix_spawnattr_destroy (&attr);
+    posix_spawn_file_actions_destroy (&file_actions);
+    string_free_split (exec_args);
+
+    return (rc == 0) ? pid : -1;
+}
+#endif /* HAVE_SPAWN_H */
+
 /*
  * Sends buffers (stdout/stderr) to callback.
  */
@@ -553,14 +670,80 @@ hook_process_child_read_until_eof (struct t_hook *hook_process)
 }
 
 /*
- * Checks if child process is still alive.
+ * Checks if child process has ended: if so, reads its last output, sends
+ * buffers to callback and removes the hook.
+ *
+ * If the child process does not exist any more (already reaped, waitpid
+ * fails with ECHILD), it is considered as ended with an error.
+ */
+
+void
+hook_process_check_child_end (struct t_hook *hook_process)
+{
+    pid_t pid;
+    int status, rc;
+
+    pid = waitpid (HOOK_PROCESS(hook_process, child_pid), &status, WNOHANG);
+    if ((pid < 0) && (errno == ECHILD))
+    {
+        /* child already reaped: its exit status is unknown */
+        hook_process_child_read_until_eof (hook_process);
+        hook_process_send_buffers (hook_process, WEECHAT_HOOK_PROCESS_ERROR);
+        unhook (hook_process);
+    }
+    else if (pid > 0)
+    {
+        if (WIFEXITED(status))
+        {
+            /* child terminated normally */
+            rc = WEXITSTATUS(status);
+            hook_process_child_read_until_eof (hook_process);
+            hook_process_send_buffers (hook_process, rc);
+            unhook (hook_process);
+        }
+        else if (WIFSIGNALED(status))
+        {
+            /* child terminated by a signal */
+            hook_process_child_read_until_eof (hook_process);
+            hook_process_send_buffers (hook_process,
+                                       WEECHAT_HOOK_PROCESS_ERROR);
+            unhook (hook_process);
+        }
+    }
+}
+
+/*
+ * Callback called when the pidfd of child process is readable
+ * (child process has ended).
+ */
+
+int
+hook_process_child_pidfd_cb (const void *pointer, void *data, int fd)
+{
+    struct t_hook *hook_process;
+
+    /* make C compiler happy */
+    (void) data;
+    (void) fd;
+
+    hook_process = (struct t_hook *)pointer;
+
+    if (hook_process->deleted)
+        return WEECHAT_RC_OK;
+
+    hook_process_check_child_end (hook_process);
+
+    return WEECHAT_RC_OK;
+}
+
+/*
+ * Checks if child process is still alive (or kills it if timeout is reached).
  */
 
 int
 hook_process_timer_cb (const void *pointer, void *data, int remaining_calls)
 {
     struct t_hook *hook_process;
-    int status, rc;
 
     /* make C compiler happy */
     (void) data;
@@ -581,40 +764,151 @@ hook_process_timer_cb (const void *pointer, void *data, int remaining_calls)
                              HOOK_PROCESS(hook_process, command),
                              ((float)HOOK_PROCESS(hook_process, timeout)) / 1000);
         }
-        kill (HOOK_PROCESS(hook_process, child_pid), SIGKILL);
-        usleep (1000);
+        if (HOOK_PROCESS(hook_process, child_pid) > 0)
+        {
+            kill (HOOK_PROCESS(hook_process, child_pid), SIGKILL);
+            usleep (1000);
+        }
         unhook (hook_process);
     }
-    else
+    else if (!HOOK_PROCESS(hook_process, hook_pidfd)
+             && !HOOK_PROCESS(hook_process, url_transfer))
     {
-        if (waitpid (HOOK_PROCESS(hook_process, child_pid),
-                     &status, WNOHANG) > 0)
+        hook_process_check_child_end (hook_process);
+    }
+
+    return WEECHAT_RC_OK;
+}
+
+/*
+ * Adds output of URL transfer to stdout buffer (callback called by URL
+ * transfer).
+ */
+
+void
+hook_process_url_write_cb (void *data, const char *buffer, int size)
+{
+    struct t_hook *hook_process;
+    int length;
+
+    hook_process = (struct t_hook *)data;
+
+    while (size > 0)
+    {
+        length = (size > HOOK_PROCESS_BUFFER_SIZE / 8) ?
+            HOOK_PROCESS_BUFFER_SIZE / 8 : size;
+        hook_process_add_to_buffer (hook_process, HOOK_PROCESS_STDOUT,
+                                    buffer, length);
+        if (HOOK_PROCESS(hook_process, buffer_size[HOOK_PROCESS_STDOUT]) >=
+            HOOK_PROCESS(hook_process, buffer_flush))
         {
-            if (WIFEXITED(status))
-            {
-                /* child terminated normally */
-                rc = WEXITSTATUS(status);
-                hook_process_child_read_until_eof (hook_process);
-                hook_process_send_buffers (hook_process, rc);
-                unhook (hook_process);
-            }
-            else if (WIFSIGNALED(status))
-            {
-                /* child terminated by a signal */
-                hook_process_child_read_until_eof (hook_process);
-                hook_process_send_buffers (hook_process,
-                                           WEECHAT_HOOK_PROCESS_ERROR);
-                unhook (hook_process);
-            }
+            hook_process_send_buffers (hook_process,
+                                       WEECHAT_HOOK_PROCESS_RUNNING);
         }
+        if (hook_process->deleted)
+            return;
+        buffer += length;
+        size -= length;
     }
+}
 
-    return WEECHAT_RC_OK;
+/*
+ * Sends end of URL transfer to callback and removes the hook (callback called
+ * by URL transfer).
+ */
+
+void
+hook_process_url_end_cb (void *data, int return_code, const char *error)
+{
+    struct t_hook *hook_process;
+
+    hook_process = (struct t_hook *)data;
+
+    /* the transfer is freed after this call */
+    HOOK_PROCESS(hook_process, url_transfer) = NULL;
+
+    if (hook_process->deleted)
+        return;
+
+    if (error)
+    {
+        hook_process_add_to_buffer (hook_process, HOOK_PROCESS_STDERR,
+                                    error, strlen (error));
+    }
+    hook_process_send_buffers (hook_process, return_code);
+    unhook (hook_process);
+}
+
+/*
+ * Downloads URL (command "url:xxx") in WeeChat process, without blocking:
+ * output is read with callbacks.
+ */
+
+void
+hook_process_run_url (struct t_hook *hook_process)
+{
+    const char *ptr_url;
+    int rc;
+
+    ptr_url = HOOK_PROCESS(hook_process, command) + 4;
+    while (ptr_url[0] == ' ')
+    {
+        ptr_url++;
+    }
+
+    HOOK_PROCESS(hook_process, url_transfer) = weeurl_transfer_new (
+        ptr_url,
+        HOOK_PROCESS(hook_process, options),
+        &hook_process_url_write_cb,
+        &hook_process_url_end_cb,
+        hook_process,
+        &rc);
+    if (!HOOK_PROCESS(hook_process, url_transfer))
+    {
+        hook_process_send_buffers (hook_process, rc);
+        unhook (hook_process);
+        return;
+    }
+
+    if (HOOK_PROCESS(hook_process, timeout) > 0)
+    {
+        HOOK_PROCESS(hook_process, hook_timer) = hook_timer (
+            hook_process->plugin,
+            HOOK_PROCESS(hook_process, timeout),
+            0, 1,
+            &hook_process_timer_cb,
+            hook_process,
+            NULL);
+    }
+}
+
+/*
+ * Opens a file descriptor referring to the child process, which becomes
+ * readable when the process ends (Linux >= 5.3 only).
+ *
+ * Returns the file descriptor, -1 if not supported.
+ */
+
+int
+hook_process_pidfd_open (pid_t pid)
+{
+#if defined(__linux__) && defined(SYS_pidfd_open)
+    return (int)syscall (SYS_pidfd_open, pid, 0);
+#else
+    /* make C compiler happy */
+    (void) pid;
+
+    return -1;
+#endif
 }
 
 /*
  * Executes process command in child, and read data in current process,
  * with fd hook.
+ *
+ * Commands are started with posix_spawn (if available), "func:" is executed
+ * in a forked process and "url:" in WeeChat process (see
+ * hook_process_run_url).
  */
 
 void
@@ -625,6 +919,12 @@ hook_process_run (struct t_hook *hook_process)
     long interval;
     pid_t pid;
 
+    if (strncmp (HOOK_PROCESS(hook_process, command), "url:", 4) == 0)
+    {
+        hook_process_run_url (hook_process);
+        return;
+    }
+
     for (i = 0; i < 3; i++)
     {
         pipes[i][0] = -1;
@@ -659,30 +959,46 @@ hook_process_run (struct t_hook *hook_process)
     fflush (stdout);
     fflush (stderr);
 
-    /* fork */
-    switch (pid = fork ())
-    {
-        /* fork failed */
-        case -1:
-            snprintf (str_error, sizeof (str_error),
-                      "fork error: %s",
-                      strerror (errno));
-            (void) (HOOK_PROCESS(hook_process, callback))
-                (hook_process->callback_pointer,
-                 hook_process->callback_data,
-                 HOOK_PROCESS(hook_process, command),
-                 WEECHAT_HOOK_PROCESS_ERROR,
-                 NULL, str_error);
-            unhook (hook_process);
-            return;
-        /* child process */
-        case 0:
-            rc = setuid (getuid ());
-            (void) rc;
-            hook_process_child (hook_process);
-            /* never executed */
-            _exit (EXIT_SUCCESS);
-            break;
+    pid = -1;
+
+#ifdef HAVE_SPAWN_H
+    if (strncmp (HOOK_PROCESS(hook_process, command), "func:", 5) != 0)
+    {
+        /*
+         * spawn command; if it fails (for example command not found), the
+         * fork below will display the error in child process
+         */
+        pid = hook_process_spawn (hook_process);
+    }
+#endif /* HAVE_SPAWN_H */
+
+    if (pid < 0)
+    {
+        /* fork */
+        switch (pid = fork ())
+        {
+            /* fork failed */
+            case -1:
+                snprintf (str_error, sizeof (str_error),
+                          "fork error: %s",
+                          strerror (errno));
+                (void) (HOOK_PROCESS(hook_process, callback))
+                    (hook_process->callback_pointer,
+                     hook_process->callback_data,
+                     HOOK_PROCESS(hook_process, command),
+                     WEECHAT_HOOK_PROCESS_ERROR,
+                     NULL, str_error);
+                unhook (hook_process);
+                return;
+            /* child process */
+            case 0:
+                rc = setuid (getuid ());
+                (void) rc;
+                hook_process_child (hook_process);
+                /* never executed */
+                _exit (EXIT_SUCCESS);
+                break;
+        }
     }
 
     /* parent process */
@@ -723,10 +1039,30 @@ hook_process_run (struct t_hook *hook_process)
                      hook_process, NULL);
     }
 
+    /* get notified when child ends (if pidfd is supported) */
+    HOOK_PROCESS(hook_process, child_pidfd) = hook_process_pidfd_open (pid);
+    if (HOOK_PROCESS(hook_process, child_pidfd) >= 0)
+    {
+        HOOK_PROCESS(hook_process, hook_pidfd) =
+            hook_fd (hook_process->plugin,
+                     HOOK_PROCESS(hook_process, child_pidfd),
+                     1, 0, 0,
+                     &hook_process_child_pidfd_cb,
+                     hook_process, NULL);
+    }
+
     timeout = HOOK_PROCESS(hook_process, timeout);
     interval = 100;
     max_calls = 0;
-    if (timeout > 0)
+    if (HOOK_PROCESS(hook_process, hook_pidfd))
+    {
+        /* timer is used only for the timeout */
+        if (timeout <= 0)
+            return;
+        interval = timeout;
+        max_calls = 1;
+    }
+    else if (timeout > 0)
     {
         if (timeout <= 100)
         {
@@ -772,25 +1108,23 @@ error:
 void
 hook_process_exec ()
 {
-    struct t_hook *ptr_hook, *next_hook;
+    struct t_hook *ptr_hook;
+    struct t_hook_iterator hook_iterator;
+    struct t_hook_exec_cb hook_exec_cb;
 
     hook_exec_start ();
 
-    ptr_hook = weechat_hooks[HOOK_TYPE_PROCESS];
-    while (ptr_hook)
+    hook_iterator_init (&hook_iterator, HOOK_TYPE_PROCESS);
+    while ((ptr_hook = hook_iterator_next (&hook_iterator)))
     {
-        next_hook = ptr_hook->next_hook;
-
-        if (!ptr_hook->deleted
-            && !ptr_hook->running
-            && (HOOK_PROCESS(ptr_hook, child_pid) == 0))
+        if (!ptr_hook->running
+            && (HOOK_PROCESS(ptr_hook, child_pid) == 0)
+            && !HOOK_PROCESS(ptr_hook, url_transfer))
         {
-            ptr_hook->running = 1;
+            hook_callback_start (ptr_hook, &hook_exec_cb);
             hook_process_run (ptr_hook);
-            ptr_hook->running = 0;
+            hook_callback_end (ptr_hook, &hook_exec_cb);
         }
-
-        ptr_hook = next_hook;
     }
 
     hook_exec_end ();
@@ -833,17 +1167,32 @@ hook_process_free_data (struct t_hook *hook)
         unhook (HOOK_PROCESS(hook, hook_fd[HOOK_PROCESS_STDERR]));
         HOOK_PROCESS(hook, hook_fd[HOOK_PROCESS_STDERR]) = NULL;
     }
+    if (HOOK_PROCESS(hook, hook_pidfd))
+    {
+        unhook (HOOK_PROCESS(hook, hook_pidfd));
+        HOOK_PROCESS(hook, hook_pidfd) = NULL;
+    }
     if (HOOK_PROCESS(hook, hook_timer))
     {
         unhook (HOOK_PROCESS(hook, hook_timer));
         HOOK_PROCESS(hook, hook_timer) = NULL;
     }
+    if (HOOK_PROCESS(hook, url_transfer))
+    {
+        weeurl_transfer_cancel (HOOK_PROCESS(hook, url_transfer));
+        HOOK_PROCESS(hook, url_transfer) = NULL;
+    }
     if (HOOK_PROCESS(hook, child_pid) > 0)
     {
         kill (HOOK_PROCESS(hook, child_pid), SIGKILL);
         waitpid (HOOK_PROCESS(hook, child_pid), NULL, 0);
         HOOK_PROCESS(hook, child_pid) = 0;
     }
+    if (HOOK_PROCESS(hook, child_pidfd) != -1)
+    {
+        close (HOOK_PROCESS(hook, child_pidfd));
+        HOOK_PROCESS(hook, child_pidfd) = -1;
+    }
     if (HOOK_PROCESS(hook, child_read[HOOK_PROCESS_STDIN]) != -1)
     {
         close (HOOK_PROCESS(hook, child_read[HOOK_PROCESS_STDIN]));
@@ -933,14 +1282,20 @@ hook_process_add_to_infolist (struct t_infolist_item *item,
         return 0;
     if (!infolist_new_var_integer (item, "child_pid", HOOK_PROCESS(hook, child_pid)))
         return 0;
+    if (!infolist_new_var_integer (item, "child_pidfd", HOOK_PROCESS(hook, child_pidfd)))
+        return 0;
     if (!infolist_new_var_pointer (item, "hook_fd_stdin", HOOK_PROCESS(hook, hook_fd[HOOK_PROCESS_STDIN])))
         return 0;
     if (!infolist_new_var_pointer (item, "hook_fd_stdout", HOOK_PROCESS(hook, hook_fd[HOOK_PROCESS_STDOUT])))
         return 0;
     if (!infolist_new_var_pointer (item, "hook_fd_stderr", HOOK_PROCESS(hook, hook_fd[HOOK_PROCESS_STDERR])))
         return 0;
+    if (!infolist_new_var_pointer (item, "hook_pidfd", HOOK_PROCESS(hook, hook_pidfd)))
+        return 0;
     if (!infolist_new_var_pointer (item, "hook_timer", HOOK_PROCESS(hook, hook_timer)))
         return 0;
+    if (!infolist_new_var_pointer (item, "url_transfer", HOOK_PROCESS(hook, url_transfer)))
+        return 0;
 
     return 1;
 }
@@ -971,8 +1326,11 @@ hook_process_print_log (struct t_hook *hook)
     log_printf ("    child_read[stderr]. . : %d", HOOK_PROCESS(hook, child_read[HOOK_PROCESS_STDERR]));
     log_printf ("    child_write[stderr] . : %d", HOOK_PROCESS(hook, child_write[HOOK_PROCESS_STDERR]));
     log_printf ("    child_pid . . . . . . : %d", HOOK_PROCESS(hook, child_pid));
+    log_printf ("    child_pidfd . . . . . : %d", HOOK_PROCESS(hook, child_pidfd));
     log_printf ("    hook_fd[stdin]. . . . : 0x%lx", HOOK_PROCESS(hook, hook_fd[HOOK_PROCESS_STDIN]));
     log_printf ("    hook_fd[stdout] . . . : 0x%lx", HOOK_PROCESS(hook, hook_fd[HOOK_PROCESS_STDOUT]));
     log_printf ("    hook_fd[stderr] . . . : 0x%lx", HOOK_PROCESS(hook, hook_fd[HOOK_PROCESS_STDERR]));
+    log_printf ("    hook_pidfd. . . . . . : 0x%lx", HOOK_PROCESS(hook, hook_pidfd));
     log_printf ("    hook_timer. . . . . . : 0x%lx", HOOK_PROCESS(hook, hook_timer));
+    log_printf ("    url_transfer. . . . . : 0x%lx", HOOK_PROCESS(hook, url_transfer));
 }
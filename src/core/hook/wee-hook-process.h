@@ -23,6 +23,7 @@
 struct t_weechat_plugin;
 struct t_infolist_item;
 struct t_hashtable;
+struct t_url_transfer;
 
 #define HOOK_PROCESS(hook, var) (((struct t_hook_process *)hook->hook_data)->var)
 
@@ -47,8 +48,11 @@ struct t_hook_process
     int child_read[3];                 /* read stdin/out/err data from child*/
     int child_write[3];                /* write stdin/out/err data for child*/
     pid_t child_pid;                   /* pid of child process              */
+    int child_pidfd;                   /* pidfd (readable when child ends)  */
     struct t_hook *hook_fd[3];         /* hook fd for stdin/out/err         */
+    struct t_hook *hook_pidfd;         /* hook fd for child pidfd           */
     struct t_hook *hook_timer;         /* timer to check if child has died  */
+    struct t_url_transfer *url_transfer; /* transfer (for "url:" command)   */
     char *buffer[3];                   /* buffers for child stdin/out/err   */
     int buffer_size[3];                /* size of child stdin/out/err       */
     int buffer_flush;                  /* bytes to flush output buffers     */
@@ -69,6 +73,7 @@ extern struct t_hook *hook_process_hashtable (struct t_weechat_plugin *plugin,
                                               t_hook_callback_process *callback,
                                               const void *callback_pointer,
                                               void *callback_data);
+extern void hook_process_check_child_end (struct t_hook *hook_process);
 extern void hook_process_exec ();
 extern void hook_process_free_data (struct t_hook *hook);
 extern int hook_process_add_to_infolist (struct t_infolist_item *item,
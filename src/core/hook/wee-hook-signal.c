@@ -72,11 +72,49 @@ hook_signal (struct t_weechat_plugin *plugin, const char *signal,
     new_hook_signal->callback = callback;
     new_hook_signal->signal = strdup ((ptr_signal) ? ptr_signal : signal);
 
-    hook_add_to_list (new_hook);
+    if (!hook_add_to_list (new_hook))
+    {
+        hook_free_new (new_hook);
+        return NULL;
+    }
 
     return new_hook;
 }
 
+/*
+ * Adds a signal in the batch of a signal hook.
+ */
+
+void
+hook_signal_batch_add (struct t_hook *hook, const char *signal,
+                       const char *type_data, void *signal_data)
+{
+    struct t_infolist_item *ptr_item;
+
+    ptr_item = hook_batch_add_event (hook);
+    if (!ptr_item)
+        return;
+
+    infolist_new_var_string (ptr_item, "signal", signal);
+    infolist_new_var_string (ptr_item, "type_data", type_data);
+    if (type_data && (strcmp (type_data, WEECHAT_HOOK_SIGNAL_STRING) == 0))
+    {
+        infolist_new_var_string (ptr_item, "signal_data",
+                                 (const char *)signal_data);
+    }
+    else if (type_data && (strcmp (type_data, WEECHAT_HOOK_SIGNAL_INT) == 0))
+    {
+        infolist_new_var_integer (ptr_item, "signal_data",
+                                  (signal_data) ? *((int *)signal_data) : 0);
+    }
+    else
+    {
+        infolist_new_var_pointer (ptr_item, "signal_data", signal_data);
+    }
+
+    hook_batch_add_event_end (hook);
+}
+
 /*
  * Sends a signal.
  */
@@ -84,36 +122,40 @@ hook_signal (struct t_weechat_plugin *plugin, const char *signal,
 int
 hook_signal_send (const char *signal, const char *type_data, void *signal_data)
 {
-    struct t_hook *ptr_hook, *next_hook;
+    struct t_hook *ptr_hook;
+    struct t_hook_iterator hook_iterator;
+    struct t_hook_exec_cb hook_exec_cb;
     int rc;
 
     rc = WEECHAT_RC_OK;
 
     hook_exec_start ();
 
-    ptr_hook = weechat_hooks[HOOK_TYPE_SIGNAL];
-    while (ptr_hook)
+    hook_iterator_init (&hook_iterator, HOOK_TYPE_SIGNAL);
+    while ((ptr_hook = hook_iterator_next (&hook_iterator)))
     {
-        next_hook = ptr_hook->next_hook;
-
-        if (!ptr_hook->deleted
-            && !ptr_hook->running
+        if (!ptr_hook->running
             && (string_match (signal, HOOK_SIGNAL(ptr_hook, signal), 0)))
         {
-            ptr_hook->running = 1;
+            if (ptr_hook->batch)
+            {
+                hook_signal_batch_add (ptr_hook, signal, type_data,
+                                       signal_data);
+                continue;
+            }
+
+            hook_callback_start (ptr_hook, &hook_exec_cb);
             rc = (HOOK_SIGNAL(ptr_hook, callback))
                 (ptr_hook->callback_pointer,
                  ptr_hook->callback_data,
                  signal,
                  type_data,
                  signal_data);
-            ptr_hook->running = 0;
+            hook_callback_end (ptr_hook, &hook_exec_cb);
 
             if (rc == WEECHAT_RC_OK_EAT)
                 break;
         }
-
-        ptr_hook = next_hook;
     }
 
     hook_exec_end ();
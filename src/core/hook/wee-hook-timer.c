@@ -132,7 +132,11 @@ hook_timer (struct t_weechat_plugin *plugin, long interval, int align_second,
 
     hook_timer_init (new_hook);
 
-    hook_add_to_list (new_hook);
+    if (!hook_add_to_list (new_hook))
+    {
+        hook_free_new (new_hook);
+        return NULL;
+    }
 
     return new_hook;
 }
@@ -265,7 +269,9 @@ void
 hook_timer_exec ()
 {
     struct timeval tv_time;
-    struct t_hook *ptr_hook, *next_hook;
+    struct t_hook *ptr_hook;
+    struct t_hook_iterator hook_iterator;
+    struct t_hook_exec_cb hook_exec_cb;
 
     if (!weechat_hooks[HOOK_TYPE_TIMER])
         return;
@@ -276,23 +282,20 @@ hook_timer_exec ()
 
     hook_exec_start ();
 
-    ptr_hook = weechat_hooks[HOOK_TYPE_TIMER];
-    while (ptr_hook)
+    hook_iterator_init (&hook_iterator, HOOK_TYPE_TIMER);
+    while ((ptr_hook = hook_iterator_next (&hook_iterator)))
     {
-        next_hook = ptr_hook->next_hook;
-
-        if (!ptr_hook->deleted
-            && !ptr_hook->running
+        if (!ptr_hook->running
             && (util_timeval_cmp (&HOOK_TIMER(ptr_hook, next_exec),
                                   &tv_time) <= 0))
         {
-            ptr_hook->running = 1;
+            hook_callback_start (ptr_hook, &hook_exec_cb);
             (void) (HOOK_TIMER(ptr_hook, callback))
                 (ptr_hook->callback_pointer,
                  ptr_hook->callback_data,
                  (HOOK_TIMER(ptr_hook, remaining_calls) > 0) ?
                   HOOK_TIMER(ptr_hook, remaining_calls) - 1 : -1);
-            ptr_hook->running = 0;
+            hook_callback_end (ptr_hook, &hook_exec_cb);
             if (!ptr_hook->deleted)
             {
                 HOOK_TIMER(ptr_hook, last_exec).tv_sec = tv_time.tv_sec;
@@ -310,8 +313,6 @@ hook_timer_exec ()
                 }
             }
         }
-
-        ptr_hook = next_hook;
     }
 
     hook_exec_end ();
@@ -52,6 +52,7 @@
 #include "wee-input.h"
 #include "wee-list.h"
 #include "wee-log.h"
+#include "wee-network.h"
 #include "wee-proxy.h"
 #include "wee-secure.h"
 #include "wee-secure-buffer.h"
@@ -76,6 +77,7 @@
 #include "../gui/gui-line.h"
 #include "../gui/gui-main.h"
 #include "../gui/gui-mouse.h"
+#include "../gui/gui-search.h"
 #include "../gui/gui-window.h"
 #include "../plugins/plugin.h"
 #include "../plugins/plugin-config.h"
@@ -1743,6 +1745,8 @@ COMMAND_CALLBACK(debug)
     struct t_config_option *ptr_option;
     struct t_weechat_plugin *ptr_plugin;
     struct timeval time_start, time_end;
+    char *error;
+    long number;
     int debug;
 
     /* make C compiler happy */
@@ -1825,6 +1829,39 @@ COMMAND_CALLBACK(debug)
         return WEECHAT_RC_OK;
     }
 
+    if (string_strcasecmp (argv[1], "hooks_profile") == 0)
+    {
+        if (argc > 2)
+        {
+            if (string_strcasecmp (argv[2], "enable") == 0)
+            {
+                hook_profile_enable (1);
+                gui_chat_printf (NULL, _("Profiling of hooks enabled"));
+                return WEECHAT_RC_OK;
+            }
+            if (string_strcasecmp (argv[2], "disable") == 0)
+            {
+                hook_profile_enable (0);
+                gui_chat_printf (NULL, _("Profiling of hooks disabled"));
+                return WEECHAT_RC_OK;
+            }
+            if (string_strcasecmp (argv[2], "reset") == 0)
+            {
+                hook_profile_reset ();
+                gui_chat_printf (NULL, _("Profiling of hooks reset"));
+                return WEECHAT_RC_OK;
+            }
+            error = NULL;
+            number = strtol (argv[2], &error, 10);
+            if (!error || error[0] || (number < 1))
+                COMMAND_ERROR;
+            debug_hooks_profile ((int)number);
+        }
+        else
+            debug_hooks_profile (20);
+        return WEECHAT_RC_OK;
+    }
+
     if (string_strcasecmp (argv[1], "infolists") == 0)
     {
         debug_infolists ();
@@ -1839,6 +1876,27 @@ COMMAND_CALLBACK(debug)
         return WEECHAT_RC_OK;
     }
 
+    if (string_strcasecmp (argv[1], "startup") == 0)
+    {
+        gui_chat_printf (NULL, "");
+        gui_chat_printf (NULL, "Startup:");
+        (void) hook_signal_send ("debug_startup",
+                                 WEECHAT_HOOK_SIGNAL_STRING, NULL);
+        return WEECHAT_RC_OK;
+    }
+
+    if (string_strcasecmp (argv[1], "loop") == 0)
+    {
+        if ((argc > 2) && (string_strcasecmp (argv[2], "reset") == 0))
+        {
+            debug_loop_reset ();
+            gui_chat_printf (NULL, _("Statistics on main loop reset"));
+        }
+        else
+            debug_loop_display ();
+        return WEECHAT_RC_OK;
+    }
+
     if (string_strcasecmp (argv[1], "memory") == 0)
     {
         debug_memory ();
@@ -1868,6 +1926,7 @@ COMMAND_CALLBACK(debug)
     if (string_strcasecmp (argv[1], "term") == 0)
     {
         gui_window_term_display_infos ();
+        gui_window_frame_display_infos ();
         weechat_term_check ();
         return WEECHAT_RC_OK;
     }
@@ -5418,6 +5477,109 @@ COMMAND_CALLBACK(save)
     return WEECHAT_RC_OK;
 }
 
+/*
+ * Callback for command "/search": search text in lines of buffers.
+ */
+
+COMMAND_CALLBACK(search)
+{
+    struct t_gui_buffer *ptr_buffer;
+    int i, exact, regex, in_prefix, where;
+    long number;
+    char *error;
+
+    /* make C compiler happy */
+    (void) pointer;
+    (void) data;
+
+    if (argc < 2)
+        COMMAND_ERROR;
+
+    if (string_strcasecmp (argv[1], "-stop") == 0)
+    {
+        gui_search_cancel (gui_search_current);
+        return WEECHAT_RC_OK;
+    }
+
+    if (string_strcasecmp (argv[1], "-jump") == 0)
+    {
+        COMMAND_MIN_ARGS(3, "-jump");
+        error = NULL;
+        number = strtol (argv[2], &error, 10);
+        if (!error || error[0] || !gui_search_jump ((int)number))
+        {
+            gui_chat_printf (NULL,
+                             _("%sLine #%s not found"),
+                             gui_chat_prefix[GUI_CHAT_PREFIX_ERROR],
+                             argv[2]);
+            return WEECHAT_RC_ERROR;
+        }
+        return WEECHAT_RC_OK;
+    }
+
+    /* default values come from options used for search in buffer */
+    ptr_buffer = buffer;
+    exact = CONFIG_BOOLEAN(config_look_buffer_search_case_sensitive);
+    regex = CONFIG_BOOLEAN(config_look_buffer_search_regex);
+    where = CONFIG_INTEGER(config_look_buffer_search_where);
+    in_prefix = ((where == CONFIG_LOOK_BUFFER_SEARCH_PREFIX)
+                 || (where == CONFIG_LOOK_BUFFER_SEARCH_PREFIX_MESSAGE)) ?
+        1 : 0;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (string_strcasecmp (argv[i], "-all") == 0)
+        {
+            ptr_buffer = NULL;
+        }
+        else if (string_strcasecmp (argv[i], "-buffer") == 0)
+        {
+            if (i + 1 >= argc)
+                COMMAND_ERROR;
+            i++;
+            ptr_buffer = gui_buffer_search_by_number_or_name (argv[i]);
+            if (!ptr_buffer)
+                COMMAND_ERROR;
+        }
+        else if (string_strcasecmp (argv[i], "-exact") == 0)
+        {
+            exact = 1;
+        }
+        else if (string_strcasecmp (argv[i], "-regex") == 0)
+        {
+            regex = 1;
+        }
+        else if (string_strcasecmp (argv[i], "-prefix") == 0)
+        {
+            in_prefix = 1;
+        }
+        else
+        {
+            /* end of arguments, the text starts here */
+            break;
+        }
+    }
+
+    if (i >= argc)
+        COMMAND_ERROR;
+
+    /* searching in search buffer: search in all buffers */
+    if (ptr_buffer && (ptr_buffer == gui_search_buffer))
+        ptr_buffer = NULL;
+
+    if (!gui_search_run (argv_eol[i], exact, regex, in_prefix, ptr_buffer))
+    {
+        gui_chat_printf (NULL,
+                         _("%sUnable to search \"%s\"%s"),
+                         gui_chat_prefix[GUI_CHAT_PREFIX_ERROR],
+                         argv_eol[i],
+                         (regex) ? _(" (invalid regular expression?)") : "");
+        return WEECHAT_RC_ERROR;
+    }
+
+    return WEECHAT_RC_OK;
+}
+
 /*
  * Callback for command "/secure": manage secured data
  */
@@ -6315,6 +6477,7 @@ COMMAND_CALLBACK(upgrade)
     /* store layout, unload plugins, save config, then upgrade */
     gui_layout_store_on_exit ();
     plugin_end ();
+    network_connect_threads_end ();
     if (CONFIG_BOOLEAN(config_look_save_config_on_exit))
         (void) config_weechat_write ();
     gui_main_end (1);
@@ -7291,31 +7454,45 @@ command_init ()
         N_("list"
            " || set <plugin> <level>"
            " || dump [<plugin>]"
-           " || buffer|color|infolists|memory|tags|term|windows"
+           " || buffer|color|infolists|memory|startup|tags|term|windows"
            " || mouse|cursor [verbose]"
            " || hdata [free]"
+           " || hooks_profile [enable|disable|reset|<count>]"
+           " || loop [reset]"
            " || time <command>"),
-        N_("     list: list plugins with debug levels\n"
-           "      set: set debug level for plugin\n"
-           "   plugin: name of plugin (\"core\" for WeeChat core)\n"
-           "    level: debug level for plugin (0 = disable debug)\n"
-           "     dump: save memory dump in WeeChat log file (same dump is "
+        N_("         list: list plugins with debug levels\n"
+           "          set: set debug level for plugin\n"
+           "       plugin: name of plugin (\"core\" for WeeChat core)\n"
+           "        level: debug level for plugin (0 = disable debug)\n"
+           "         dump: save memory dump in WeeChat log file (same dump is "
            "written when WeeChat crashes)\n"
-           "   buffer: dump buffer content with hexadecimal values in log file\n"
-           "    color: display infos about current color pairs\n"
-           "   cursor: toggle debug for cursor mode\n"
-           "     dirs: display directories\n"
-           "    hdata: display infos about hdata (with free: remove all hdata "
+           "       buffer: dump buffer content with hexadecimal values in log file\n"
+           "        color: display infos about current color pairs\n"
+           "       cursor: toggle debug for cursor mode\n"
+           "         dirs: display directories\n"
+           "        hdata: display infos about hdata (with free: remove all hdata "
            "in memory)\n"
-           "    hooks: display infos about hooks\n"
-           "infolists: display infos about infolists\n"
-           "     libs: display infos about external libraries used\n"
-           "   memory: display infos about memory usage\n"
-           "    mouse: toggle debug for mouse\n"
-           "     tags: display tags for lines\n"
-           "     term: display infos about terminal\n"
-           "  windows: display windows tree\n"
-           "     time: measure time to execute a command or to send text to "
+           "        hooks: display infos about hooks\n"
+           "hooks_profile: display time spent in callbacks of hooks, by hook "
+           "and by plugin/script (with enable/disable: start/stop profiling, "
+           "reset: reset counters, count: max number of hooks and "
+           "plugins/scripts displayed, default is 20)\n"
+           "    infolists: display infos about infolists\n"
+           "         libs: display infos about external libraries used\n"
+           "         loop: display time spent in each phase of the main loop "
+           "(percentiles in microseconds), with reset: reset statistics "
+           "(see also option weechat.look.loop_stall_threshold)\n"
+           "       memory: display infos about memory usage\n"
+           "        mouse: toggle debug for mouse\n"
+           "      startup: display time spent to start WeeChat, to initialize "
+           "each plugin and to load each script (with time spent to "
+           "precompile it in threads)\n"
+           "         tags: display tags for lines\n"
+           "         term: display infos about terminal and statistics on "
+           "screen updates (see options weechat.look.refresh_max_fps and "
+           "weechat.look.refresh_inactive_windows)\n"
+           "      windows: display windows tree\n"
+           "         time: measure time to execute a command or to send text to "
            "the current buffer"),
         "list"
         " || set %(plugins_names)|" PLUGIN_CORE
@@ -7326,10 +7503,13 @@ command_init ()
         " || dirs"
         " || hdata free"
         " || hooks"
+        " || hooks_profile enable|disable|reset"
         " || infolists"
         " || libs"
+        " || loop reset"
         " || memory"
         " || mouse verbose"
+        " || startup"
         " || tags"
         " || term"
         " || windows"
@@ -7996,6 +8176,43 @@ command_init ()
            "command (see option \"weechat.look.save_config_on_exit\")."),
         "%(config_files)|%*",
         &command_save, NULL, NULL);
+    hook_command (
+        NULL, "search",
+        N_("search text in lines of buffers (in background)"),
+        N_("[-all|-buffer <number>|<name>] [-exact] [-regex] [-prefix] <text>"
+           " || -jump <number>"
+           " || -stop"),
+        N_("    -all: search in all buffers (default: current buffer)\n"
+           " -buffer: search in this buffer\n"
+           "  -exact: case sensitive search\n"
+           "  -regex: text is a POSIX extended regular expression\n"
+           " -prefix: search in prefix of lines too (default: message only)\n"
+           "    text: text to search\n"
+           "   -jump: jump to line found with this number\n"
+           "   -stop: stop current search\n"
+           "\n"
+           "Default values of -exact, -regex and -prefix are taken from "
+           "options weechat.look.buffer_search_case_sensitive, "
+           "weechat.look.buffer_search_regex and "
+           "weechat.look.buffer_search_where.\n"
+           "\n"
+           "Lines displayed in buffers are copied, then searched in threads: "
+           "lines found are displayed in buffer \"search\" as soon as they "
+           "are found.\n"
+           "In this buffer, input a number to jump to the line found, "
+           "any other text to start a new search (the current search is "
+           "stopped) or \"q\" to close the buffer.\n"
+           "\n"
+           "Examples:\n"
+           "  search \"weechat\" in all buffers:\n"
+           "    /search -all weechat\n"
+           "  search lines with an URL in current buffer:\n"
+           "    /search -regex https?://\n"
+           "  jump to first line found:\n"
+           "    /search -jump 1"),
+        "-all|-buffer|-exact|-regex|-prefix|-jump|-stop"
+        " || -buffer %(buffers_plugins_names)",
+        &command_search, NULL, NULL);
     hook_command (
         NULL, "secure",
         N_("manage secured data (passwords or private data encrypted in file "
@@ -36,11 +36,13 @@
 #include "weechat.h"
 #include "wee-config-file.h"
 #include "wee-config.h"
+#include "wee-hashtable.h"
 #include "wee-hdata.h"
 #include "wee-hook.h"
 #include "wee-infolist.h"
 #include "wee-log.h"
 #include "wee-string.h"
+#include "wee-utf8.h"
 #include "wee-version.h"
 #include "../gui/gui-color.h"
 #include "../gui/gui-chat.h"
@@ -171,6 +173,7 @@ config_file_new (struct t_weechat_plugin *plugin, const char *name,
         else
             config_files = new_config_file;
         last_config_file = new_config_file;
+        hdata_registry_add ("config_file", new_config_file);
     }
 
     return new_config_file;
@@ -201,6 +204,53 @@ config_file_section_find_pos (struct t_config_file *config_file,
     return NULL;
 }
 
+/*
+ * Hashes an option name (case insensitive, like function string_strcasecmp).
+ *
+ * Chars are read and lowered exactly like in function utf8_charcasecmp, so
+ * that two names equal for string_strcasecmp always have the same hash.
+ */
+
+unsigned long long
+config_file_option_name_hash_key_cb (struct t_hashtable *hashtable,
+                                     const void *key)
+{
+    const char *ptr_key;
+    unsigned long long hash;
+    wint_t wchar;
+
+    /* make C compiler happy */
+    (void) hashtable;
+
+    /* variant of djb2 hash, on lower case chars */
+    hash = 5381;
+    ptr_key = (const char *)key;
+    while (ptr_key[0])
+    {
+        wchar = utf8_wide_char (ptr_key);
+        if ((wchar >= 'A') && (wchar <= 'Z'))
+            wchar += ('a' - 'A');
+        hash ^= (hash << 5) + (hash >> 2) + (unsigned long long)wchar;
+        ptr_key = utf8_next_char (ptr_key);
+    }
+
+    return hash;
+}
+
+/*
+ * Compares two option names (case insensitive).
+ */
+
+int
+config_file_option_name_keycmp_cb (struct t_hashtable *hashtable,
+                                   const void *key1, const void *key2)
+{
+    /* make C compiler happy */
+    (void) hashtable;
+
+    return string_strcasecmp ((const char *)key1, (const char *)key2);
+}
+
 /*
  * Creates a new section in a configuration file.
  *
@@ -283,6 +333,12 @@ config_file_new_section (struct t_config_file *config_file, const char *name,
         new_section->callback_delete_option_data = callback_delete_option_data;
         new_section->options = NULL;
         new_section->last_option = NULL;
+        new_section->options_hash = hashtable_new (
+            128,
+            WEECHAT_HASHTABLE_STRING,
+            WEECHAT_HASHTABLE_POINTER,
+            &config_file_option_name_hash_key_cb,
+            &config_file_option_name_keycmp_cb);
 
         new_section->prev_section = config_file->last_section;
         new_section->next_section = NULL;
@@ -473,6 +529,9 @@ config_file_option_insert_in_section (struct t_config_option *option)
         (option->section)->options = option;
         (option->section)->last_option = option;
     }
+
+    if (option->section->options_hash)
+        hashtable_set (option->section->options_hash, option->name, option);
 }
 
 /*
@@ -835,8 +894,13 @@ config_file_search_option (struct t_config_file *config_file,
     struct t_config_option *ptr_option;
     int rc;
 
+    if (!option_name)
+        return NULL;
+
     if (section)
     {
+        if (section->options_hash)
+            return hashtable_get (section->options_hash, option_name);
         for (ptr_option = section->last_option; ptr_option;
              ptr_option = ptr_option->prev_option)
         {
@@ -852,15 +916,10 @@ config_file_search_option (struct t_config_file *config_file,
         for (ptr_section = config_file->sections; ptr_section;
              ptr_section = ptr_section->next_section)
         {
-            for (ptr_option = ptr_section->last_option; ptr_option;
-                 ptr_option = ptr_option->prev_option)
-            {
-                rc = string_strcasecmp (ptr_option->name, option_name);
-                if (rc == 0)
-                    return ptr_option;
-                else if (rc < 0)
-                    return NULL;
-            }
+            ptr_option = config_file_search_option (config_file, ptr_section,
+                                                    option_name);
+            if (ptr_option)
+                return ptr_option;
         }
     }
 
@@ -1665,6 +1724,11 @@ config_file_option_rename (struct t_config_option *option,
         /* remove option from list */
         if (option->section)
         {
+            if (option->section->options_hash)
+            {
+                hashtable_remove (option->section->options_hash,
+                                  option->name);
+            }
             if (option->prev_option)
                 (option->prev_option)->next_option = option->next_option;
             if (option->next_option)
@@ -2917,6 +2981,9 @@ config_file_option_free (struct t_config_option *option, int run_callback)
 
     ptr_section = option->section;
 
+    if (ptr_section && ptr_section->options_hash)
+        hashtable_remove (ptr_section->options_hash, option->name);
+
     /* free data */
     config_file_option_free_data (option);
 
@@ -2979,6 +3046,8 @@ config_file_section_free (struct t_config_section *section)
 
     /* free data */
     config_file_section_free_options (section);
+    if (section->options_hash)
+        hashtable_free (section->options_hash);
     if (section->name)
         free (section->name);
     if (section->callback_read_data)
@@ -3047,6 +3116,8 @@ config_file_free (struct t_config_file *config_file)
     if (config_file->next_config)
         (config_file->next_config)->prev_config = config_file->prev_config;
 
+    hdata_registry_remove ("config_file", config_file);
+
     /* free data */
     if (config_file->callback_reload_data)
         free (config_file->callback_reload_data);
@@ -3457,6 +3528,7 @@ config_file_print_log ()
             log_printf ("      callback_delete_option_data . : 0x%lx", ptr_section->callback_delete_option_data);
             log_printf ("      options . . . . . . . . . . . : 0x%lx", ptr_section->options);
             log_printf ("      last_option . . . . . . . . . : 0x%lx", ptr_section->last_option);
+            log_printf ("      options_hash. . . . . . . . . : 0x%lx", ptr_section->options_hash);
             log_printf ("      prev_section. . . . . . . . . : 0x%lx", ptr_section->prev_section);
             log_printf ("      next_section. . . . . . . . . : 0x%lx", ptr_section->next_section);
 
@@ -39,6 +39,7 @@
 #define CONFIG_BOOLEAN_TRUE   1
 
 struct t_weelist;
+struct t_hashtable;
 struct t_infolist;
 
 struct t_config_option;
@@ -110,6 +111,7 @@ struct t_config_section
     void *callback_delete_option_data;     /* data sent to delete callback  */
     struct t_config_option *options;       /* options in section            */
     struct t_config_option *last_option;   /* last option in section        */
+    struct t_hashtable *options_hash;      /* options by name (for search)  */
     struct t_config_section *prev_section; /* link to previous section      */
     struct t_config_section *next_section; /* link to next section          */
 };
@@ -47,6 +47,7 @@
 #include "wee-list.h"
 #include "wee-proxy.h"
 #include "wee-string.h"
+#include "wee-url.h"
 #include "wee-version.h"
 #include "../gui/gui-bar.h"
 #include "../gui/gui-bar-item.h"
@@ -149,6 +150,7 @@ struct t_config_option *config_look_jump_previous_buffer_when_closing;
 struct t_config_option *config_look_jump_smart_back_to_buffer;
 struct t_config_option *config_look_key_bind_safe;
 struct t_config_option *config_look_key_grab_delay;
+struct t_config_option *config_look_loop_stall_threshold;
 struct t_config_option *config_look_mouse;
 struct t_config_option *config_look_mouse_timer_delay;
 struct t_config_option *config_look_nick_color_force;
@@ -180,6 +182,8 @@ struct t_config_option *config_look_quote_time_format;
 struct t_config_option *config_look_read_marker;
 struct t_config_option *config_look_read_marker_always_show;
 struct t_config_option *config_look_read_marker_string;
+struct t_config_option *config_look_refresh_inactive_windows;
+struct t_config_option *config_look_refresh_max_fps;
 struct t_config_option *config_look_save_config_on_exit;
 struct t_config_option *config_look_save_config_with_fsync;
 struct t_config_option *config_look_save_layout_on_exit;
@@ -288,10 +292,13 @@ struct t_config_option *config_history_max_visited_buffers;
 
 /* config, network section */
 
+struct t_config_option *config_network_connect_threads;
 struct t_config_option *config_network_connection_timeout;
+struct t_config_option *config_network_dns_cache_ttl;
 struct t_config_option *config_network_gnutls_ca_file;
 struct t_config_option *config_network_gnutls_handshake_timeout;
 struct t_config_option *config_network_proxy_curl;
+struct t_config_option *config_network_url_max_connections;
 
 /* config, plugin section */
 
@@ -1076,6 +1083,22 @@ config_change_read_marker (const void *pointer, void *data,
     gui_window_ask_refresh (1);
 }
 
+/*
+ * Callback for changes on option "weechat.look.refresh_inactive_windows".
+ */
+
+void
+config_change_refresh_inactive_windows (const void *pointer, void *data,
+                                        struct t_config_option *option)
+{
+    /* make C compiler happy */
+    (void) pointer;
+    (void) data;
+    (void) option;
+
+    gui_window_ask_refresh (1);
+}
+
 /*
  * Callback for changes on a prefix option.
  */
@@ -1284,6 +1307,22 @@ config_change_network_gnutls_ca_file (const void *pointer, void *data,
         network_set_gnutls_ca_file ();
 }
 
+/*
+ * Callback for changes on option "weechat.network.url_max_connections".
+ */
+
+void
+config_change_network_url_max_connections (const void *pointer, void *data,
+                                           struct t_config_option *option)
+{
+    /* make C compiler happy */
+    (void) pointer;
+    (void) data;
+    (void) option;
+
+    weeurl_set_max_connections ();
+}
+
 /*
  * Checks option "weechat.network.proxy_curl".
  */
@@ -3209,6 +3248,16 @@ config_weechat_init_options ()
            "/help input)"),
         NULL, 1, 10000, "800", NULL, 0,
         NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
+    config_look_loop_stall_threshold = config_file_new_option (
+        weechat_config_file, ptr_section,
+        "loop_stall_threshold", "integer",
+        N_("threshold (in milliseconds) to detect a stall of the main loop: "
+           "if an iteration of the main loop (timers, refresh, callbacks of "
+           "file descriptors and processes) takes more time, it is written "
+           "in WeeChat log file, with the slowest hook callback; 0 = "
+           "disable detection (see also command /debug loop)"),
+        NULL, 0, INT_MAX, "0", NULL, 0,
+        NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
     config_look_mouse = config_file_new_option (
         weechat_config_file, ptr_section,
         "mouse", "boolean",
@@ -3524,6 +3573,26 @@ config_weechat_init_options ()
         NULL, NULL, NULL,
         &config_change_read_marker, NULL, NULL,
         NULL, NULL, NULL);
+    config_look_refresh_inactive_windows = config_file_new_option (
+        weechat_config_file, ptr_section,
+        "refresh_inactive_windows", "boolean",
+        N_("refresh the chat area of windows which are not the current "
+           "window; if disabled, the chat area of an inactive window is "
+           "refreshed only when it becomes the current window (this reduces "
+           "the data sent to the terminal when many messages are displayed "
+           "in inactive windows)"),
+        NULL, 0, 0, "on", NULL, 0,
+        NULL, NULL, NULL,
+        &config_change_refresh_inactive_windows, NULL, NULL,
+        NULL, NULL, NULL);
+    config_look_refresh_max_fps = config_file_new_option (
+        weechat_config_file, ptr_section,
+        "refresh_max_fps", "integer",
+        N_("max number of screen updates per second: all changes on windows "
+           "and bars are sent to the terminal in a single update, at most "
+           "this number of times per second (0 = no limit)"),
+        NULL, 0, 1000, "60", NULL, 0,
+        NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
     config_look_save_config_on_exit = config_file_new_option (
         weechat_config_file, ptr_section,
         "save_config_on_exit", "boolean",
@@ -4465,13 +4534,29 @@ config_weechat_init_options ()
         return 0;
     }
 
+    config_network_connect_threads = config_file_new_option (
+        weechat_config_file, ptr_section,
+        "connect_threads", "integer",
+        N_("max number of threads used to connect to remote hosts (threads "
+           "are started when needed); 0 = connect in a child process (fork) "
+           "for each connection"),
+        NULL, 0, 64, "4", NULL, 0,
+        NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
     config_network_connection_timeout = config_file_new_option (
         weechat_config_file, ptr_section,
         "connection_timeout", "integer",
         N_("timeout (in seconds) for connection to a remote host (made in a "
-           "child process)"),
+           "thread or a child process)"),
         NULL, 1, INT_MAX, "60", NULL, 0,
         NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
+    config_network_dns_cache_ttl = config_file_new_option (
+        weechat_config_file, ptr_section,
+        "dns_cache_ttl", "integer",
+        N_("time (in seconds) to keep resolved addresses in cache, used when "
+           "connecting in threads (see option weechat.network.connect_threads); "
+           "0 = disable cache"),
+        NULL, 0, 86400, "60", NULL, 0,
+        NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
     config_network_gnutls_ca_file = config_file_new_option (
         weechat_config_file, ptr_section,
         "gnutls_ca_file", "string",
@@ -4497,6 +4582,17 @@ config_weechat_init_options ()
         &config_check_proxy_curl, NULL, NULL,
         NULL, NULL, NULL,
         NULL, NULL, NULL);
+    config_network_url_max_connections = config_file_new_option (
+        weechat_config_file, ptr_section,
+        "url_max_connections", "integer",
+        N_("max number of simultaneous connections used to download URLs "
+           "(transfers are made in WeeChat process, connections are reused "
+           "and multiplexed with HTTP/2 when possible; other transfers wait "
+           "for a free connection); 0 = no limit"),
+        NULL, 0, 1024, "16", NULL, 0,
+        NULL, NULL, NULL,
+        &config_change_network_url_max_connections, NULL, NULL,
+        NULL, NULL, NULL);
 
     /* plugin */
     ptr_section = config_file_new_section (weechat_config_file, "plugin",
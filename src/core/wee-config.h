@@ -202,6 +202,7 @@ extern struct t_config_option *config_look_jump_previous_buffer_when_closing;
 extern struct t_config_option *config_look_jump_smart_back_to_buffer;
 extern struct t_config_option *config_look_key_bind_safe;
 extern struct t_config_option *config_look_key_grab_delay;
+extern struct t_config_option *config_look_loop_stall_threshold;
 extern struct t_config_option *config_look_mouse;
 extern struct t_config_option *config_look_mouse_timer_delay;
 extern struct t_config_option *config_look_nick_color_force;
@@ -233,6 +234,8 @@ extern struct t_config_option *config_look_quote_time_format;
 extern struct t_config_option *config_look_read_marker;
 extern struct t_config_option *config_look_read_marker_always_show;
 extern struct t_config_option *config_look_read_marker_string;
+extern struct t_config_option *config_look_refresh_inactive_windows;
+extern struct t_config_option *config_look_refresh_max_fps;
 extern struct t_config_option *config_look_save_config_on_exit;
 extern struct t_config_option *config_look_save_config_with_fsync;
 extern struct t_config_option *config_look_save_layout_on_exit;
@@ -333,10 +336,13 @@ extern struct t_config_option *config_history_max_buffer_lines_number;
 extern struct t_config_option *config_history_max_commands;
 extern struct t_config_option *config_history_max_visited_buffers;
 
+extern struct t_config_option *config_network_connect_threads;
 extern struct t_config_option *config_network_connection_timeout;
+extern struct t_config_option *config_network_dns_cache_ttl;
 extern struct t_config_option *config_network_gnutls_ca_file;
 extern struct t_config_option *config_network_gnutls_handshake_timeout;
 extern struct t_config_option *config_network_proxy_curl;
+extern struct t_config_option *config_network_url_max_connections;
 
 extern struct t_config_option *config_plugin_autoload;
 extern struct t_config_option *config_plugin_debug;
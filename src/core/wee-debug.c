@@ -39,8 +39,11 @@
 #endif
 
 #include "weechat.h"
+#include "wee-arraylist.h"
 #include "wee-backtrace.h"
+#include "wee-config.h"
 #include "wee-config-file.h"
+#include "wee-debug.h"
 #include "wee-hashtable.h"
 #include "wee-hdata.h"
 #include "wee-hook.h"
@@ -59,12 +62,29 @@
 #include "../gui/gui-key.h"
 #include "../gui/gui-layout.h"
 #include "../gui/gui-main.h"
+#include "../gui/gui-search.h"
 #include "../gui/gui-window.h"
 #include "../plugins/plugin.h"
 
 
 int debug_dump_active = 0;
 
+char *debug_loop_phase_string[DEBUG_LOOP_NUM_PHASES] =
+{ "timers", "refresh", "poll", "fd", "process" };
+struct t_debug_histogram debug_loop_histogram[DEBUG_LOOP_NUM_PHASES];
+struct t_debug_histogram debug_loop_histogram_busy; /* all except poll     */
+long debug_loop_stalls = 0;            /* number of stalls detected         */
+int debug_loop_stall_threshold = 0;    /* stall threshold (ms), 0 = disabled*/
+int debug_loop_running = 0;            /* 1 if an iteration is running      */
+struct timeval debug_loop_time_mark;   /* time of last mark in iteration    */
+long debug_loop_phase_time[DEBUG_LOOP_NUM_PHASES]; /* time of phases (µs)   */
+long debug_loop_slowest_time = 0;      /* slowest callback in iteration (µs)*/
+char debug_loop_slowest_hook[1024];    /* slowest callback in iteration     */
+
+long debug_startup_time = -1;          /* time until first loop (µs)        */
+struct t_debug_startup_plugin *debug_startup_plugins = NULL;
+struct t_debug_startup_plugin *last_debug_startup_plugin = NULL;
+
 
 /*
  * Writes dump of data to WeeChat log file.
@@ -95,6 +115,7 @@ debug_dump (int crash)
     gui_layout_print_log ();
     gui_key_print_log (NULL);
     gui_filter_print_log ();
+    gui_search_print_log ();
     gui_bar_print_log ();
     gui_bar_item_print_log ();
     gui_hotlist_print_log ();
@@ -413,6 +434,146 @@ debug_hooks ()
     gui_chat_printf (NULL, "%17s:%5d", "total", hooks_count_total);
 }
 
+/*
+ * Compares two hooks by total time spent in callback (descending order).
+ */
+
+int
+debug_hooks_profile_hook_cmp_cb (void *data, struct t_arraylist *arraylist,
+                                 void *pointer1, void *pointer2)
+{
+    struct t_hook *ptr_hook1, *ptr_hook2;
+
+    /* make C compiler happy */
+    (void) data;
+    (void) arraylist;
+
+    ptr_hook1 = (struct t_hook *)pointer1;
+    ptr_hook2 = (struct t_hook *)pointer2;
+
+    if (ptr_hook1->profile_time_total > ptr_hook2->profile_time_total)
+        return -1;
+    if (ptr_hook1->profile_time_total < ptr_hook2->profile_time_total)
+        return 1;
+    return 0;
+}
+
+/*
+ * Compares two plugins/scripts by total time spent in callbacks
+ * (descending order).
+ */
+
+int
+debug_hooks_profile_plugin_cmp_cb (void *data, struct t_arraylist *arraylist,
+                                   void *pointer1, void *pointer2)
+{
+    struct t_hook_profile *ptr_profile1, *ptr_profile2;
+
+    /* make C compiler happy */
+    (void) data;
+    (void) arraylist;
+
+    ptr_profile1 = (struct t_hook_profile *)pointer1;
+    ptr_profile2 = (struct t_hook_profile *)pointer2;
+
+    if (ptr_profile1->time_total > ptr_profile2->time_total)
+        return -1;
+    if (ptr_profile1->time_total < ptr_profile2->time_total)
+        return 1;
+    return 0;
+}
+
+/*
+ * Displays profiling of hook callbacks: hooks and plugins/scripts which
+ * spent the most time in callbacks (at most "count" of each).
+ */
+
+void
+debug_hooks_profile (int count)
+{
+    struct t_arraylist *list;
+    struct t_hook *ptr_hook;
+    struct t_hook_profile *ptr_profile;
+    int i, type;
+
+    gui_chat_printf (NULL, "");
+    gui_chat_printf (NULL, "hooks profiling (%s):",
+                     (hook_profile_enabled) ? "enabled" : "disabled");
+
+    /* hooks */
+    list = arraylist_new (64, 1, 1,
+                          &debug_hooks_profile_hook_cmp_cb, NULL, NULL, NULL);
+    if (!list)
+        return;
+    for (type = 0; type < HOOK_NUM_TYPES; type++)
+    {
+        for (ptr_hook = weechat_hooks[type]; ptr_hook;
+             ptr_hook = ptr_hook->next_hook)
+        {
+            if (!ptr_hook->deleted && (ptr_hook->profile_calls > 0))
+                arraylist_add (list, ptr_hook);
+        }
+    }
+    gui_chat_printf (NULL, "  hooks (%d with calls):",
+                     arraylist_size (list));
+    if (arraylist_size (list) > 0)
+    {
+        gui_chat_printf (NULL,
+                         "    %10s %12s %10s %10s  %s",
+                         "calls", "total (ms)", "avg (µs)", "max (µs)",
+                         "hook");
+    }
+    for (i = 0; (i < arraylist_size (list)) && (i < count); i++)
+    {
+        ptr_hook = (struct t_hook *)arraylist_get (list, i);
+        gui_chat_printf (NULL,
+                         "    %10ld %12.3f %10ld %10ld  %s %s%s%s: %s",
+                         ptr_hook->profile_calls,
+                         ((double)ptr_hook->profile_time_total) / 1000,
+                         ptr_hook->profile_time_total / ptr_hook->profile_calls,
+                         ptr_hook->profile_time_max,
+                         hook_type_string[ptr_hook->type],
+                         plugin_get_name (ptr_hook->plugin),
+                         (ptr_hook->subplugin) ? "/" : "",
+                         (ptr_hook->subplugin) ? ptr_hook->subplugin : "",
+                         hook_get_description (ptr_hook));
+    }
+    arraylist_free (list);
+
+    /* plugins/scripts */
+    list = arraylist_new (16, 1, 1,
+                          &debug_hooks_profile_plugin_cmp_cb, NULL, NULL, NULL);
+    if (!list)
+        return;
+    for (ptr_profile = hook_profiles; ptr_profile;
+         ptr_profile = ptr_profile->next_profile)
+    {
+        if (ptr_profile->calls > 0)
+            arraylist_add (list, ptr_profile);
+    }
+    gui_chat_printf (NULL, "  plugins/scripts (%d with calls):",
+                     arraylist_size (list));
+    if (arraylist_size (list) > 0)
+    {
+        gui_chat_printf (NULL,
+                         "    %10s %12s %10s %10s  %s",
+                         "calls", "total (ms)", "avg (µs)", "max (µs)",
+                         "plugin/script");
+    }
+    for (i = 0; (i < arraylist_size (list)) && (i < count); i++)
+    {
+        ptr_profile = (struct t_hook_profile *)arraylist_get (list, i);
+        gui_chat_printf (NULL,
+                         "    %10ld %12.3f %10ld %10ld  %s",
+                         ptr_profile->calls,
+                         ((double)ptr_profile->time_total) / 1000,
+                         ptr_profile->time_total / ptr_profile->calls,
+                         ptr_profile->time_max,
+                         ptr_profile->name);
+    }
+    arraylist_free (list);
+}
+
 /*
  * Displays a list of infolists in memory.
  */
@@ -568,6 +729,57 @@ debug_libs_cb (const void *pointer, void *data,
     return WEECHAT_RC_OK;
 }
 
+/*
+ * Callback for signal "debug_startup": displays time spent to start WeeChat
+ * and to initialize each plugin (called when command "/debug startup" is
+ * issued).
+ *
+ * Note: this function displays times for WeeChat core only: script plugins
+ * catch this signal to display time spent to load each script.
+ */
+
+int
+debug_startup_cb (const void *pointer, void *data,
+                  const char *signal, const char *type_data,
+                  void *signal_data)
+{
+    struct t_debug_startup_plugin *ptr_plugin;
+    long total;
+
+    /* make C compiler happy */
+    (void) pointer;
+    (void) data;
+    (void) signal;
+    (void) type_data;
+    (void) signal_data;
+
+    gui_chat_printf (NULL, "  core:");
+
+    if (debug_startup_time >= 0)
+    {
+        gui_chat_printf (NULL, "    %12.3f ms  until main loop",
+                         ((double)debug_startup_time) / 1000);
+    }
+
+    total = 0;
+    for (ptr_plugin = debug_startup_plugins; ptr_plugin;
+         ptr_plugin = ptr_plugin->next_plugin)
+    {
+        total += ptr_plugin->time_init;
+    }
+    gui_chat_printf (NULL, "    %12.3f ms  init of plugins",
+                     ((double)total) / 1000);
+    for (ptr_plugin = debug_startup_plugins; ptr_plugin;
+         ptr_plugin = ptr_plugin->next_plugin)
+    {
+        gui_chat_printf (NULL, "      %12.3f ms  %s",
+                         ((double)ptr_plugin->time_init) / 1000,
+                         ptr_plugin->name);
+    }
+
+    return WEECHAT_RC_OK;
+}
+
 /*
  * Displays WeeChat directories.
  */
@@ -631,6 +843,411 @@ debug_display_time_elapsed (struct timeval *time1, struct timeval *time2,
     }
 }
 
+/*
+ * Returns bucket index of a value in a histogram.
+ */
+
+int
+debug_histogram_bucket (long value)
+{
+    int shift;
+
+    if (value < 0)
+        value = 0;
+
+    shift = 0;
+    while ((value >> shift) >= (DEBUG_HISTOGRAM_SUB_COUNT * 2))
+    {
+        shift++;
+    }
+
+    return (shift * DEBUG_HISTOGRAM_SUB_COUNT) + (int)(value >> shift);
+}
+
+/*
+ * Returns the highest value that is counted in a bucket of a histogram.
+ */
+
+long
+debug_histogram_bucket_max (int bucket)
+{
+    int shift;
+    long sub_bucket;
+
+    if (bucket < 0)
+        return 0;
+
+    shift = (bucket < DEBUG_HISTOGRAM_SUB_COUNT * 2) ?
+        0 : (bucket / DEBUG_HISTOGRAM_SUB_COUNT) - 1;
+    sub_bucket = bucket - (shift * DEBUG_HISTOGRAM_SUB_COUNT);
+
+    return ((sub_bucket + 1) << shift) - 1;
+}
+
+/*
+ * Adds a value in a histogram.
+ */
+
+void
+debug_histogram_add (struct t_debug_histogram *histogram, long value)
+{
+    int bucket;
+
+    if (!histogram)
+        return;
+
+    if (value < 0)
+        value = 0;
+
+    bucket = debug_histogram_bucket (value);
+    if (bucket >= DEBUG_HISTOGRAM_NUM_BUCKETS)
+        bucket = DEBUG_HISTOGRAM_NUM_BUCKETS - 1;
+
+    histogram->count++;
+    histogram->sum += value;
+    if (value > histogram->max)
+        histogram->max = value;
+    histogram->buckets[bucket]++;
+}
+
+/*
+ * Returns the value at a given percentile (between 0 and 100) in a histogram
+ * (this is an upper bound of the value, with the precision of a bucket).
+ */
+
+long
+debug_histogram_percentile (struct t_debug_histogram *histogram,
+                            double percentile)
+{
+    long long target, total;
+    long value;
+    int i;
+
+    if (!histogram || (histogram->count == 0))
+        return 0;
+
+    if (percentile < 0)
+        percentile = 0;
+    if (percentile > 100)
+        percentile = 100;
+
+    target = (long long)((((double)histogram->count) * percentile / 100) + 0.999999);
+    if (target < 1)
+        target = 1;
+
+    total = 0;
+    for (i = 0; i < DEBUG_HISTOGRAM_NUM_BUCKETS; i++)
+    {
+        total += histogram->buckets[i];
+        if (total >= target)
+        {
+            value = debug_histogram_bucket_max (i);
+            return (value < histogram->max) ? value : histogram->max;
+        }
+    }
+
+    return histogram->max;
+}
+
+/*
+ * Saves time spent to initialize a plugin (displayed with "/debug startup").
+ *
+ * If the plugin was already initialized (for example after a reload), its
+ * time is replaced.
+ */
+
+void
+debug_startup_add_plugin (const char *name, long time_init)
+{
+    struct t_debug_startup_plugin *ptr_plugin;
+
+    if (!name)
+        return;
+
+    for (ptr_plugin = debug_startup_plugins; ptr_plugin;
+         ptr_plugin = ptr_plugin->next_plugin)
+    {
+        if (strcmp (ptr_plugin->name, name) == 0)
+        {
+            ptr_plugin->time_init = time_init;
+            return;
+        }
+    }
+
+    ptr_plugin = malloc (sizeof (*ptr_plugin));
+    if (!ptr_plugin)
+        return;
+    ptr_plugin->name = strdup (name);
+    if (!ptr_plugin->name)
+    {
+        free (ptr_plugin);
+        return;
+    }
+    ptr_plugin->time_init = time_init;
+
+    ptr_plugin->prev_plugin = last_debug_startup_plugin;
+    ptr_plugin->next_plugin = NULL;
+    if (last_debug_startup_plugin)
+        last_debug_startup_plugin->next_plugin = ptr_plugin;
+    else
+        debug_startup_plugins = ptr_plugin;
+    last_debug_startup_plugin = ptr_plugin;
+}
+
+/*
+ * Starts an iteration of main loop.
+ */
+
+void
+debug_loop_start ()
+{
+    int i;
+
+    for (i = 0; i < DEBUG_LOOP_NUM_PHASES; i++)
+    {
+        debug_loop_phase_time[i] = 0;
+    }
+    debug_loop_slowest_time = 0;
+    debug_loop_slowest_hook[0] = '\0';
+
+    gettimeofday (&debug_loop_time_mark, NULL);
+    debug_loop_running = 1;
+
+    /* first iteration: save time spent to start WeeChat */
+    if (debug_startup_time < 0)
+    {
+        debug_startup_time = (long)util_timeval_diff (
+            &weechat_current_start_timeval, &debug_loop_time_mark);
+    }
+}
+
+/*
+ * Adds time elapsed since the previous mark to a phase of current iteration
+ * of main loop.
+ */
+
+void
+debug_loop_mark (enum t_debug_loop_phase phase)
+{
+    struct timeval tv_now;
+
+    if (!debug_loop_running)
+        return;
+
+    gettimeofday (&tv_now, NULL);
+    debug_loop_phase_time[phase] += (long)util_timeval_diff (
+        &debug_loop_time_mark, &tv_now);
+    memcpy (&debug_loop_time_mark, &tv_now, sizeof (tv_now));
+}
+
+/*
+ * Records time of a hook callback: the slowest callback of the iteration is
+ * logged if the iteration is a stall.
+ */
+
+void
+debug_loop_callback (struct t_hook *hook, long time_diff)
+{
+    if (!debug_loop_running || (time_diff <= debug_loop_slowest_time))
+        return;
+
+    debug_loop_slowest_time = time_diff;
+    snprintf (debug_loop_slowest_hook, sizeof (debug_loop_slowest_hook),
+              "%s %s%s%s: %s",
+              hook_type_string[hook->type],
+              plugin_get_name (hook->plugin),
+              (hook->subplugin) ? "/" : "",
+              (hook->subplugin) ? hook->subplugin : "",
+              hook_get_description (hook));
+}
+
+/*
+ * Ends an iteration of main loop: adds time of phases in histograms and
+ * logs the iteration if it took more time than the stall threshold (option
+ * weechat.look.loop_stall_threshold).
+ */
+
+void
+debug_loop_end ()
+{
+    long busy;
+    int i, phase_max;
+
+    if (!debug_loop_running)
+        return;
+
+    debug_loop_running = 0;
+
+    busy = 0;
+    phase_max = DEBUG_LOOP_PHASE_TIMERS;
+    for (i = 0; i < DEBUG_LOOP_NUM_PHASES; i++)
+    {
+        debug_histogram_add (&debug_loop_histogram[i],
+                             debug_loop_phase_time[i]);
+        if (i == DEBUG_LOOP_PHASE_POLL)
+            continue;
+        busy += debug_loop_phase_time[i];
+        if (debug_loop_phase_time[i] > debug_loop_phase_time[phase_max])
+            phase_max = i;
+    }
+    debug_histogram_add (&debug_loop_histogram_busy, busy);
+
+    debug_loop_stall_threshold = (config_look_loop_stall_threshold) ?
+        CONFIG_INTEGER(config_look_loop_stall_threshold) : 0;
+
+    if ((debug_loop_stall_threshold > 0)
+        && (busy >= (long)debug_loop_stall_threshold * 1000))
+    {
+        debug_loop_stalls++;
+        log_printf ("main loop stall: %.3f ms, mostly in %s "
+                    "(timers: %.3f, refresh: %.3f, fd: %.3f, "
+                    "process: %.3f), slowest callback: %s (%.3f ms)",
+                    ((double)busy) / 1000,
+                    debug_loop_phase_string[phase_max],
+                    ((double)debug_loop_phase_time[DEBUG_LOOP_PHASE_TIMERS]) / 1000,
+                    ((double)debug_loop_phase_time[DEBUG_LOOP_PHASE_REFRESH]) / 1000,
+                    ((double)debug_loop_phase_time[DEBUG_LOOP_PHASE_FD]) / 1000,
+                    ((double)debug_loop_phase_time[DEBUG_LOOP_PHASE_PROCESS]) / 1000,
+                    (debug_loop_slowest_hook[0]) ? debug_loop_slowest_hook : "-",
+                    ((double)debug_loop_slowest_time) / 1000);
+    }
+}
+
+/*
+ * Resets statistics on main loop.
+ */
+
+void
+debug_loop_reset ()
+{
+    memset (debug_loop_histogram, 0, sizeof (debug_loop_histogram));
+    memset (&debug_loop_histogram_busy, 0, sizeof (debug_loop_histogram_busy));
+    debug_loop_stalls = 0;
+}
+
+/*
+ * Displays statistics of a histogram of main loop (this function must not
+ * be called directly).
+ */
+
+void
+debug_loop_display_histogram (const char *name,
+                              struct t_debug_histogram *histogram)
+{
+    gui_chat_printf (NULL,
+                     "  %-8s %10lld %10ld %10ld %10ld %10ld %10ld",
+                     name,
+                     (histogram->count > 0) ?
+                     histogram->sum / histogram->count : 0,
+                     debug_histogram_percentile (histogram, 50),
+                     debug_histogram_percentile (histogram, 90),
+                     debug_histogram_percentile (histogram, 99),
+                     debug_histogram_percentile (histogram, 99.9),
+                     histogram->max);
+}
+
+/*
+ * Displays statistics on main loop: time spent in each phase of iterations.
+ */
+
+void
+debug_loop_display ()
+{
+    int i;
+
+    gui_chat_printf (NULL, "");
+    gui_chat_printf (NULL,
+                     "main loop: %ld iterations, %ld stalls "
+                     "(threshold: %d ms)",
+                     debug_loop_histogram_busy.count,
+                     debug_loop_stalls,
+                     debug_loop_stall_threshold);
+    gui_chat_printf (NULL,
+                     "  %-8s %10s %10s %10s %10s %10s %10s",
+                     "(µs)", "avg", "p50", "p90", "p99", "p99.9", "max");
+    for (i = 0; i < DEBUG_LOOP_NUM_PHASES; i++)
+    {
+        debug_loop_display_histogram (debug_loop_phase_string[i],
+                                      &debug_loop_histogram[i]);
+    }
+    debug_loop_display_histogram ("busy", &debug_loop_histogram_busy);
+}
+
+/*
+ * Adds statistics of a histogram in a hashtable (this function must not be
+ * called directly).
+ */
+
+void
+debug_loop_hashtable_add (struct t_hashtable *hashtable, const char *name,
+                          struct t_debug_histogram *histogram)
+{
+    char str_key[64], str_value[64];
+
+    snprintf (str_key, sizeof (str_key), "%s_avg", name);
+    snprintf (str_value, sizeof (str_value), "%lld",
+              (histogram->count > 0) ? histogram->sum / histogram->count : 0);
+    hashtable_set (hashtable, str_key, str_value);
+
+    snprintf (str_key, sizeof (str_key), "%s_p50", name);
+    snprintf (str_value, sizeof (str_value), "%ld",
+              debug_histogram_percentile (histogram, 50));
+    hashtable_set (hashtable, str_key, str_value);
+
+    snprintf (str_key, sizeof (str_key), "%s_p90", name);
+    snprintf (str_value, sizeof (str_value), "%ld",
+              debug_histogram_percentile (histogram, 90));
+    hashtable_set (hashtable, str_key, str_value);
+
+    snprintf (str_key, sizeof (str_key), "%s_p99", name);
+    snprintf (str_value, sizeof (str_value), "%ld",
+              debug_histogram_percentile (histogram, 99));
+    hashtable_set (hashtable, str_key, str_value);
+
+    snprintf (str_key, sizeof (str_key), "%s_max", name);
+    snprintf (str_value, sizeof (str_value), "%ld", histogram->max);
+    hashtable_set (hashtable, str_key, str_value);
+}
+
+/*
+ * Returns statistics on main loop in a hashtable (times are in
+ * microseconds).
+ *
+ * Note: hashtable must be freed after use.
+ */
+
+struct t_hashtable *
+debug_loop_stats_hashtable ()
+{
+    struct t_hashtable *hashtable;
+    char str_value[64];
+    int i;
+
+    hashtable = hashtable_new (64,
+                               WEECHAT_HASHTABLE_STRING,
+                               WEECHAT_HASHTABLE_STRING,
+                               NULL, NULL);
+    if (!hashtable)
+        return NULL;
+
+    snprintf (str_value, sizeof (str_value), "%ld",
+              debug_loop_histogram_busy.count);
+    hashtable_set (hashtable, "iterations", str_value);
+    snprintf (str_value, sizeof (str_value), "%ld", debug_loop_stalls);
+    hashtable_set (hashtable, "stalls", str_value);
+    snprintf (str_value, sizeof (str_value), "%d", debug_loop_stall_threshold);
+    hashtable_set (hashtable, "stall_threshold", str_value);
+
+    for (i = 0; i < DEBUG_LOOP_NUM_PHASES; i++)
+    {
+        debug_loop_hashtable_add (hashtable, debug_loop_phase_string[i],
+                                  &debug_loop_histogram[i]);
+    }
+    debug_loop_hashtable_add (hashtable, "busy", &debug_loop_histogram_busy);
+
+    return hashtable;
+}
+
 /*
  * Initializes debug.
  */
@@ -645,6 +1262,7 @@ debug_init ()
      */
     hook_signal (NULL, "2000|debug_dump", &debug_dump_cb, NULL, NULL);
     hook_signal (NULL, "2000|debug_libs", &debug_libs_cb, NULL, NULL);
+    hook_signal (NULL, "2000|debug_startup", &debug_startup_cb, NULL, NULL);
 }
 
 /*
@@ -654,4 +1272,14 @@ debug_init ()
 void
 debug_end ()
 {
+    struct t_debug_startup_plugin *ptr_next_plugin;
+
+    while (debug_startup_plugins)
+    {
+        ptr_next_plugin = debug_startup_plugins->next_plugin;
+        free (debug_startup_plugins->name);
+        free (debug_startup_plugins);
+        debug_startup_plugins = ptr_next_plugin;
+    }
+    last_debug_startup_plugin = NULL;
 }
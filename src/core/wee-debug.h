@@ -21,18 +21,81 @@
 #define WEECHAT_DEBUG_H
 
 struct t_gui_window_tree;
+struct t_hashtable;
+struct t_hook;
+
+/* phases of an iteration of main loop */
+
+enum t_debug_loop_phase
+{
+    DEBUG_LOOP_PHASE_TIMERS = 0,       /* timer hooks                       */
+    DEBUG_LOOP_PHASE_REFRESH,          /* refresh of screen                 */
+    DEBUG_LOOP_PHASE_POLL,             /* waiting in poll() (idle)          */
+    DEBUG_LOOP_PHASE_FD,               /* fd hooks                          */
+    DEBUG_LOOP_PHASE_PROCESS,          /* process hooks (run of processes)  */
+    /* number of phases */
+    DEBUG_LOOP_NUM_PHASES,
+};
+
+/*
+ * histogram with HDR-style buckets (values in microseconds): exact values
+ * up to 15, then 8 buckets per power of 2 (max relative error: 12.5%)
+ */
+
+#define DEBUG_HISTOGRAM_SUB_BITS    3
+#define DEBUG_HISTOGRAM_SUB_COUNT   (1 << DEBUG_HISTOGRAM_SUB_BITS)
+#define DEBUG_HISTOGRAM_NUM_BUCKETS (64 * DEBUG_HISTOGRAM_SUB_COUNT)
+
+struct t_debug_histogram
+{
+    long count;                        /* number of values                  */
+    long long sum;                     /* sum of values                     */
+    long max;                          /* max value                         */
+    long buckets[DEBUG_HISTOGRAM_NUM_BUCKETS]; /* count of values by bucket */
+};
+
+struct t_debug_startup_plugin
+{
+    char *name;                        /* plugin name                       */
+    long time_init;                    /* time to initialize plugin (µs)    */
+    struct t_debug_startup_plugin *prev_plugin; /* link to previous plugin  */
+    struct t_debug_startup_plugin *next_plugin; /* link to next plugin      */
+};
+
+extern char *debug_loop_phase_string[];
+extern struct t_debug_histogram debug_loop_histogram[];
+extern struct t_debug_histogram debug_loop_histogram_busy;
+extern long debug_loop_stalls;
+extern int debug_loop_stall_threshold;
+extern long debug_startup_time;
+extern struct t_debug_startup_plugin *debug_startup_plugins;
 
 extern void debug_sigsegv ();
 extern void debug_windows_tree ();
 extern void debug_memory ();
 extern void debug_hdata ();
 extern void debug_hooks ();
+extern void debug_hooks_profile (int count);
 extern void debug_infolists ();
 extern void debug_directories ();
 extern void debug_display_time_elapsed (struct timeval *time1,
                                         struct timeval *time2,
                                         const char *message,
                                         int display);
+extern int debug_histogram_bucket (long value);
+extern long debug_histogram_bucket_max (int bucket);
+extern void debug_histogram_add (struct t_debug_histogram *histogram,
+                                 long value);
+extern long debug_histogram_percentile (struct t_debug_histogram *histogram,
+                                        double percentile);
+extern void debug_startup_add_plugin (const char *name, long time_init);
+extern void debug_loop_start ();
+extern void debug_loop_mark (enum t_debug_loop_phase phase);
+extern void debug_loop_callback (struct t_hook *hook, long time_diff);
+extern void debug_loop_end ();
+extern void debug_loop_reset ();
+extern void debug_loop_display ();
+extern struct t_hashtable *debug_loop_stats_hashtable ();
 extern void debug_init ();
 extern void debug_end ();
 
@@ -88,6 +88,29 @@ hashtable_hash_key_djb2 (const char *string)
     return hash;
 }
 
+/*
+ * Mixes bits of a hash, so that all bits of hash have an effect on the
+ * lower bits, used to find an entry in htable (this is the finalizer of
+ * MurmurHash3).
+ *
+ * Returns the mixed hash.
+ */
+
+unsigned long long
+hashtable_hash_mix (unsigned long long hash)
+{
+    uint64_t value;
+
+    value = (uint64_t)hash;
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdULL;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ULL;
+    value ^= value >> 33;
+
+    return (unsigned long long)value;
+}
+
 /*
  * Hashes a key (default callback).
  *
@@ -179,10 +202,10 @@ hashtable_keycmp_default_cb (struct t_hashtable *hashtable,
 /*
  * Creates a new hashtable.
  *
- * The size is NOT a limit for number of items in hashtable. It is the size of
- * internal array to store hashed keys: a high value uses more memory, but has
- * better performance because this reduces the collisions of hashed keys and
- * then reduces length of linked lists.
+ * The size is NOT a limit for number of items in hashtable. It is the initial
+ * size of internal array to store hashed keys (rounded to a power of 2): the
+ * array is automatically enlarged when items are added (and reduced when
+ * items are removed, but never below this size).
  *
  * Returns pointer to new hashtable, NULL if error.
  */
@@ -194,11 +217,17 @@ hashtable_new (int size,
                t_hashtable_keycmp *callback_keycmp)
 {
     struct t_hashtable *new_hashtable;
-    int i, type_keys_int, type_values_int;
+    int i, size_pow2, type_keys_int, type_values_int;
 
-    if (size <= 0)
+    if ((size <= 0) || (size > HASHTABLE_SIZE_MAX))
         return NULL;
 
+    size_pow2 = 1;
+    while (size_pow2 < size)
+    {
+        size_pow2 <<= 1;
+    }
+
     type_keys_int = hashtable_get_type (type_keys);
     if (type_keys_int < 0)
         return NULL;
@@ -213,21 +242,24 @@ hashtable_new (int size,
     new_hashtable = malloc (sizeof (*new_hashtable));
     if (new_hashtable)
     {
-        new_hashtable->size = size;
+        new_hashtable->size = size_pow2;
+        new_hashtable->size_min = size_pow2;
         new_hashtable->type_keys = type_keys_int;
         new_hashtable->type_values = type_values_int;
-        new_hashtable->htable = malloc (size * sizeof (*(new_hashtable->htable)));
+        new_hashtable->htable = malloc (size_pow2 * sizeof (*(new_hashtable->htable)));
         new_hashtable->keys_values = NULL;
         if (!new_hashtable->htable)
         {
             free (new_hashtable);
             return NULL;
         }
-        for (i = 0; i < size; i++)
+        for (i = 0; i < size_pow2; i++)
         {
             new_hashtable->htable[i] = NULL;
         }
         new_hashtable->items_count = 0;
+        new_hashtable->items = NULL;
+        new_hashtable->last_item = NULL;
 
         new_hashtable->callback_hash_key = (callback_hash_key) ?
             callback_hash_key : &hashtable_hash_key_default_cb;
@@ -305,6 +337,10 @@ void
 hashtable_free_key (struct t_hashtable *hashtable,
                     struct t_hashtable_item *item)
 {
+    /* key stored in same allocation as item: nothing to free */
+    if (item->key == (void *)(item + 1))
+        return;
+
     if (hashtable->callback_free_key)
     {
         (void) (hashtable->callback_free_key) (hashtable,
@@ -362,6 +398,130 @@ hashtable_free_value (struct t_hashtable *hashtable,
     }
 }
 
+/*
+ * Returns size of key to store in same allocation as item (0 if key must be
+ * allocated separately).
+ *
+ * Keys are stored with item only if they are copied in hashtable and if there
+ * is no callback to free keys.
+ */
+
+int
+hashtable_key_inline_size (struct t_hashtable *hashtable,
+                           const void *key, int key_size)
+{
+    if (hashtable->callback_free_key)
+        return 0;
+
+    switch (hashtable->type_keys)
+    {
+        case HASHTABLE_INTEGER:
+            return sizeof (int);
+        case HASHTABLE_STRING:
+            return strlen ((const char *)key) + 1;
+        case HASHTABLE_POINTER:
+            return 0;
+        case HASHTABLE_BUFFER:
+            return key_size;
+        case HASHTABLE_TIME:
+            return sizeof (time_t);
+        case HASHTABLE_NUM_TYPES:
+            break;
+    }
+
+    return 0;
+}
+
+/*
+ * Adds an item in htable (in first free entry from its hash).
+ */
+
+void
+hashtable_htable_add (struct t_hashtable_item **htable, int size,
+                      struct t_hashtable_item *item)
+{
+    unsigned long long index;
+
+    index = item->hash & (size - 1);
+    while (htable[index])
+    {
+        index = (index + 1) & (size - 1);
+    }
+    htable[index] = item;
+}
+
+/*
+ * Resizes htable: all items are added again in a new htable.
+ *
+ * Returns:
+ *   1: OK
+ *   0: error (hashtable is unchanged)
+ */
+
+int
+hashtable_resize (struct t_hashtable *hashtable, int new_size)
+{
+    struct t_hashtable_item **new_htable, *ptr_item;
+    int i;
+
+    if ((new_size < hashtable->size_min) || (new_size > HASHTABLE_SIZE_MAX)
+        || (new_size == hashtable->size))
+    {
+        return 0;
+    }
+
+    new_htable = malloc (new_size * sizeof (*new_htable));
+    if (!new_htable)
+        return 0;
+    for (i = 0; i < new_size; i++)
+    {
+        new_htable[i] = NULL;
+    }
+
+    for (ptr_item = hashtable->items; ptr_item;
+         ptr_item = ptr_item->next_item)
+    {
+        hashtable_htable_add (new_htable, new_size, ptr_item);
+    }
+
+    free (hashtable->htable);
+    hashtable->htable = new_htable;
+    hashtable->size = new_size;
+
+    return 1;
+}
+
+/*
+ * Searches for an item in hashtable, using the hashed key (mixed).
+ *
+ * If index is non NULL, then it is set with index of item in htable (if key
+ * is not found: index of the free entry where the key would be added).
+ */
+
+struct t_hashtable_item *
+hashtable_search_item (struct t_hashtable *hashtable, const void *key,
+                       unsigned long long hash, unsigned long long *index)
+{
+    unsigned long long ptr_index;
+    struct t_hashtable_item *ptr_item;
+
+    ptr_index = hash & (hashtable->size - 1);
+    while ((ptr_item = hashtable->htable[ptr_index]))
+    {
+        if ((ptr_item->hash == hash)
+            && (hashtable->callback_keycmp (hashtable, key, ptr_item->key) == 0))
+        {
+            break;
+        }
+        ptr_index = (ptr_index + 1) & (hashtable->size - 1);
+    }
+
+    if (index)
+        *index = ptr_index;
+
+    return ptr_item;
+}
+
 /*
  * Sets value for a key in hashtable.
  *
@@ -376,7 +536,8 @@ hashtable_set_with_size (struct t_hashtable *hashtable,
                          const void *value, int value_size)
 {
     unsigned long long hash;
-    struct t_hashtable_item *ptr_item, *pos_item, *new_item;
+    struct t_hashtable_item *ptr_item, *new_item;
+    int key_inline_size;
 
     if (!hashtable || !key
         || ((hashtable->type_keys == HASHTABLE_BUFFER) && (key_size <= 0))
@@ -385,19 +546,11 @@ hashtable_set_with_size (struct t_hashtable *hashtable,
         return NULL;
     }
 
-    /* search position for item in hashtable */
-    hash = hashtable->callback_hash_key (hashtable, key) % hashtable->size;
-    pos_item = NULL;
-    for (ptr_item = hashtable->htable[hash];
-         ptr_item
-             && ((int)(hashtable->callback_keycmp) (hashtable, key, ptr_item->key) > 0);
-         ptr_item = ptr_item->next_item)
-    {
-        pos_item = ptr_item;
-    }
+    hash = hashtable_hash_mix (hashtable->callback_hash_key (hashtable, key));
 
     /* replace value if item is already in hashtable */
-    if (ptr_item && (hashtable->callback_keycmp (hashtable, key, ptr_item->key) == 0))
+    ptr_item = hashtable_search_item (hashtable, key, hash, NULL);
+    if (ptr_item)
     {
         hashtable_free_value (hashtable, ptr_item);
         hashtable_alloc_type (hashtable->type_values,
@@ -406,38 +559,51 @@ hashtable_set_with_size (struct t_hashtable *hashtable,
         return ptr_item;
     }
 
+    /* enlarge htable if it would be more than 3/4 full */
+    if ((hashtable->items_count + 1) * 4 > hashtable->size * 3)
+    {
+        if (!hashtable_resize (hashtable, hashtable->size * 2)
+            && (hashtable->items_count + 1 >= hashtable->size))
+        {
+            return NULL;
+        }
+    }
+
     /* create new item */
-    new_item = malloc (sizeof (*new_item));
+    key_inline_size = hashtable_key_inline_size (hashtable, key, key_size);
+    new_item = malloc (sizeof (*new_item) + key_inline_size);
     if (!new_item)
         return NULL;
 
     /* set key and value */
-    hashtable_alloc_type (hashtable->type_keys,
-                          key, key_size,
-                          &new_item->key, &new_item->key_size);
-    hashtable_alloc_type (hashtable->type_values,
-                          value, value_size,
-                          &new_item->value, &new_item->value_size);
-
-    /* add item */
-    if (pos_item)
+    if (key_inline_size > 0)
     {
-        /* insert item after position found */
-        new_item->prev_item = pos_item;
-        new_item->next_item = pos_item->next_item;
-        if (pos_item->next_item)
-            (pos_item->next_item)->prev_item = new_item;
-        pos_item->next_item = new_item;
+        memcpy (new_item + 1, key, key_inline_size);
+        new_item->key = (void *)(new_item + 1);
+        new_item->key_size = key_inline_size;
     }
     else
     {
-        /* insert item at beginning of list */
-        new_item->prev_item = NULL;
-        new_item->next_item = hashtable->htable[hash];
-        if (hashtable->htable[hash])
-            (hashtable->htable[hash])->prev_item = new_item;
-        hashtable->htable[hash] = new_item;
+        hashtable_alloc_type (hashtable->type_keys,
+                              key, key_size,
+                              &new_item->key, &new_item->key_size);
     }
+    hashtable_alloc_type (hashtable->type_values,
+                          value, value_size,
+                          &new_item->value, &new_item->value_size);
+    new_item->hash = hash;
+
+    /* add item in htable */
+    hashtable_htable_add (hashtable->htable, hashtable->size, new_item);
+
+    /* add item at the end of list */
+    new_item->prev_item = hashtable->last_item;
+    new_item->next_item = NULL;
+    if (hashtable->last_item)
+        (hashtable->last_item)->next_item = new_item;
+    else
+        hashtable->items = new_item;
+    hashtable->last_item = new_item;
 
     hashtable->items_count++;
 
@@ -463,36 +629,22 @@ hashtable_set (struct t_hashtable *hashtable,
 /*
  * Searches for an item in hashtable.
  *
- * If hash is non NULL, then it is set with hash value of key (even if key is
- * not found).
+ * If hash is non NULL, then it is set with index of item in htable (if key
+ * is not found: index of the free entry where the key would be added).
  */
 
 struct t_hashtable_item *
 hashtable_get_item (struct t_hashtable *hashtable, const void *key,
                     unsigned long long *hash)
 {
-    unsigned long long key_hash;
-    struct t_hashtable_item *ptr_item;
-
     if (!hashtable || !key)
         return NULL;
 
-    key_hash = hashtable->callback_hash_key (hashtable, key) % hashtable->size;
-    if (hash)
-        *hash = key_hash;
-    for (ptr_item = hashtable->htable[key_hash];
-         ptr_item && hashtable->callback_keycmp (hashtable, key, ptr_item->key) > 0;
-         ptr_item = ptr_item->next_item)
-    {
-    }
-
-    if (ptr_item
-        && (hashtable->callback_keycmp (hashtable, key, ptr_item->key) == 0))
-    {
-        return ptr_item;
-    }
-
-    return NULL;
+    return hashtable_search_item (
+        hashtable,
+        key,
+        hashtable_hash_mix (hashtable->callback_hash_key (hashtable, key)),
+        hash);
 }
 
 /*
@@ -574,26 +726,22 @@ hashtable_map (struct t_hashtable *hashtable,
                t_hashtable_map *callback_map,
                void *callback_map_data)
 {
-    int i;
     struct t_hashtable_item *ptr_item, *ptr_next_item;
 
     if (!hashtable)
         return;
 
-    for (i = 0; i < hashtable->size; i++)
+    ptr_item = hashtable->items;
+    while (ptr_item)
     {
-        ptr_item = hashtable->htable[i];
-        while (ptr_item)
-        {
-            ptr_next_item = ptr_item->next_item;
+        ptr_next_item = ptr_item->next_item;
 
-            (void) (callback_map) (callback_map_data,
-                                   hashtable,
-                                   ptr_item->key,
-                                   ptr_item->value);
+        (void) (callback_map) (callback_map_data,
+                               hashtable,
+                               ptr_item->key,
+                               ptr_item->value);
 
-            ptr_item = ptr_next_item;
-        }
+        ptr_item = ptr_next_item;
     }
 }
 
@@ -606,7 +754,6 @@ hashtable_map_string (struct t_hashtable *hashtable,
                       t_hashtable_map_string *callback_map,
                       void *callback_map_data)
 {
-    int i;
     struct t_hashtable_item *ptr_item, *ptr_next_item;
     const char *str_key, *str_value;
     char *key, *value;
@@ -614,33 +761,30 @@ hashtable_map_string (struct t_hashtable *hashtable,
     if (!hashtable)
         return;
 
-    for (i = 0; i < hashtable->size; i++)
+    ptr_item = hashtable->items;
+    while (ptr_item)
     {
-        ptr_item = hashtable->htable[i];
-        while (ptr_item)
-        {
-            ptr_next_item = ptr_item->next_item;
+        ptr_next_item = ptr_item->next_item;
 
-            str_key = hashtable_to_string (hashtable->type_keys,
-                                           ptr_item->key);
-            key = (str_key) ? strdup (str_key) : NULL;
+        str_key = hashtable_to_string (hashtable->type_keys,
+                                       ptr_item->key);
+        key = (str_key) ? strdup (str_key) : NULL;
 
-            str_value = hashtable_to_string (hashtable->type_values,
-                                             ptr_item->value);
-            value = (str_value) ? strdup (str_value) : NULL;
+        str_value = hashtable_to_string (hashtable->type_values,
+                                         ptr_item->value);
+        value = (str_value) ? strdup (str_value) : NULL;
 
-            (void) (callback_map) (callback_map_data,
-                                   hashtable,
-                                   key,
-                                   value);
+        (void) (callback_map) (callback_map_data,
+                               hashtable,
+                               key,
+                               value);
 
-            if (key)
-                free (key);
-            if (value)
-                free (value);
+        if (key)
+            free (key);
+        if (value)
+            free (value);
 
-            ptr_item = ptr_next_item;
-        }
+        ptr_item = ptr_next_item;
     }
 }
 
@@ -675,13 +819,15 @@ hashtable_dup (struct t_hashtable *hashtable)
 {
     struct t_hashtable *new_hashtable;
 
-    new_hashtable = hashtable_new (hashtable->size,
+    new_hashtable = hashtable_new (hashtable->size_min,
                                    hashtable_type_string[hashtable->type_keys],
                                    hashtable_type_string[hashtable->type_values],
                                    hashtable->callback_hash_key,
                                    hashtable->callback_keycmp);
     if (new_hashtable)
     {
+        /* allocate htable with same size, to prevent resizes during copy */
+        hashtable_resize (new_hashtable, hashtable->size);
         new_hashtable->callback_free_key = hashtable->callback_free_key;
         new_hashtable->callback_free_value = hashtable->callback_free_value;
         hashtable_map (hashtable,
@@ -1044,7 +1190,7 @@ hashtable_add_to_infolist (struct t_hashtable *hashtable,
                            struct t_infolist_item *infolist_item,
                            const char *prefix)
 {
-    int i, item_number;
+    int item_number;
     struct t_hashtable_item *ptr_item;
     char option_name[128];
 
@@ -1052,52 +1198,49 @@ hashtable_add_to_infolist (struct t_hashtable *hashtable,
         return 0;
 
     item_number = 0;
-    for (i = 0; i < hashtable->size; i++)
+    for (ptr_item = hashtable->items; ptr_item;
+         ptr_item = ptr_item->next_item)
     {
-        for (ptr_item = hashtable->htable[i]; ptr_item;
-             ptr_item = ptr_item->next_item)
+        snprintf (option_name, sizeof (option_name),
+                  "%s_name_%05d", prefix, item_number);
+        if (!infolist_new_var_string (infolist_item, option_name,
+                                      hashtable_to_string (hashtable->type_keys,
+                                                           ptr_item->key)))
+            return 0;
+        snprintf (option_name, sizeof (option_name),
+                  "%s_value_%05d", prefix, item_number);
+        switch (hashtable->type_values)
         {
-            snprintf (option_name, sizeof (option_name),
-                      "%s_name_%05d", prefix, item_number);
-            if (!infolist_new_var_string (infolist_item, option_name,
-                                          hashtable_to_string (hashtable->type_keys,
-                                                               ptr_item->key)))
-                return 0;
-            snprintf (option_name, sizeof (option_name),
-                      "%s_value_%05d", prefix, item_number);
-            switch (hashtable->type_values)
-            {
-                case HASHTABLE_INTEGER:
-                    if (!infolist_new_var_integer (infolist_item, option_name,
-                                                   *((int *)ptr_item->value)))
-                        return 0;
-                    break;
-                case HASHTABLE_STRING:
-                    if (!infolist_new_var_string (infolist_item, option_name,
-                                                  (const char *)ptr_item->value))
-                        return 0;
-                    break;
-                case HASHTABLE_POINTER:
-                    if (!infolist_new_var_pointer (infolist_item, option_name,
-                                                   ptr_item->value))
-                        return 0;
-                    break;
-                case HASHTABLE_BUFFER:
-                    if (!infolist_new_var_buffer (infolist_item, option_name,
-                                                  ptr_item->value,
-                                                  ptr_item->value_size))
-                        return 0;
-                    break;
-                case HASHTABLE_TIME:
-                    if (!infolist_new_var_time (infolist_item, option_name,
-                                                *((time_t *)ptr_item->value)))
-                        return 0;
-                    break;
-                case HASHTABLE_NUM_TYPES:
-                    break;
-            }
-            item_number++;
+            case HASHTABLE_INTEGER:
+                if (!infolist_new_var_integer (infolist_item, option_name,
+                                               *((int *)ptr_item->value)))
+                    return 0;
+                break;
+            case HASHTABLE_STRING:
+                if (!infolist_new_var_string (infolist_item, option_name,
+                                              (const char *)ptr_item->value))
+                    return 0;
+                break;
+            case HASHTABLE_POINTER:
+                if (!infolist_new_var_pointer (infolist_item, option_name,
+                                               ptr_item->value))
+                    return 0;
+                break;
+            case HASHTABLE_BUFFER:
+                if (!infolist_new_var_buffer (infolist_item, option_name,
+                                              ptr_item->value,
+                                              ptr_item->value_size))
+                    return 0;
+                break;
+            case HASHTABLE_TIME:
+                if (!infolist_new_var_time (infolist_item, option_name,
+                                            *((time_t *)ptr_item->value)))
+                    return 0;
+                break;
+            case HASHTABLE_NUM_TYPES:
+                break;
         }
+        item_number++;
     }
     return 1;
 }
@@ -1188,14 +1331,20 @@ hashtable_add_from_infolist (struct t_hashtable *hashtable,
 }
 
 /*
- * Removes an item from hashtable.
+ * Removes an item from hashtable (index is the index of item in htable).
+ *
+ * The following items with same hashed key (or other keys hashed to entries
+ * between) are moved back in htable, so that a search of these items does
+ * not stop on a free entry.
  */
 
 void
 hashtable_remove_item (struct t_hashtable *hashtable,
                        struct t_hashtable_item *item,
-                       unsigned long long hash)
+                       unsigned long long index)
 {
+    unsigned long long mask, next_index, index_item;
+
     if (!hashtable || !item)
         return;
 
@@ -1203,17 +1352,45 @@ hashtable_remove_item (struct t_hashtable *hashtable,
     hashtable_free_value (hashtable, item);
     hashtable_free_key (hashtable, item);
 
+    /* remove item from htable */
+    mask = hashtable->size - 1;
+    hashtable->htable[index] = NULL;
+    next_index = (index + 1) & mask;
+    while (hashtable->htable[next_index])
+    {
+        index_item = hashtable->htable[next_index]->hash & mask;
+        /* move item if its entry is not between free entry and its index */
+        if ((index <= next_index) ?
+            ((index_item <= index) || (index_item > next_index)) :
+            ((index_item <= index) && (index_item > next_index)))
+        {
+            hashtable->htable[index] = hashtable->htable[next_index];
+            hashtable->htable[next_index] = NULL;
+            index = next_index;
+        }
+        next_index = (next_index + 1) & mask;
+    }
+
     /* remove item from list */
     if (item->prev_item)
         (item->prev_item)->next_item = item->next_item;
     if (item->next_item)
         (item->next_item)->prev_item = item->prev_item;
-    if (hashtable->htable[hash] == item)
-        hashtable->htable[hash] = item->next_item;
+    if (hashtable->items == item)
+        hashtable->items = item->next_item;
+    if (hashtable->last_item == item)
+        hashtable->last_item = item->prev_item;
 
     free (item);
 
     hashtable->items_count--;
+
+    /* reduce htable if it is less than 1/8 full */
+    if ((hashtable->size > hashtable->size_min)
+        && (hashtable->items_count * 8 < hashtable->size))
+    {
+        hashtable_resize (hashtable, hashtable->size / 2);
+    }
 }
 
 /*
@@ -1224,14 +1401,14 @@ void
 hashtable_remove (struct t_hashtable *hashtable, const void *key)
 {
     struct t_hashtable_item *ptr_item;
-    unsigned long long hash;
+    unsigned long long index;
 
     if (!hashtable || !key)
         return;
 
-    ptr_item = hashtable_get_item (hashtable, key, &hash);
+    ptr_item = hashtable_get_item (hashtable, key, &index);
     if (ptr_item)
-        hashtable_remove_item (hashtable, ptr_item, hash);
+        hashtable_remove_item (hashtable, ptr_item, index);
 }
 
 /*
@@ -1241,18 +1418,30 @@ hashtable_remove (struct t_hashtable *hashtable, const void *key)
 void
 hashtable_remove_all (struct t_hashtable *hashtable)
 {
+    struct t_hashtable_item *ptr_item, *ptr_next_item;
     int i;
 
     if (!hashtable)
         return;
 
+    ptr_item = hashtable->items;
+    while (ptr_item)
+    {
+        ptr_next_item = ptr_item->next_item;
+        hashtable_free_value (hashtable, ptr_item);
+        hashtable_free_key (hashtable, ptr_item);
+        free (ptr_item);
+        ptr_item = ptr_next_item;
+    }
+    hashtable->items = NULL;
+    hashtable->last_item = NULL;
+    hashtable->items_count = 0;
+
     for (i = 0; i < hashtable->size; i++)
     {
-        while (hashtable->htable[i])
-        {
-            hashtable_remove_item (hashtable, hashtable->htable[i], i);
-        }
+        hashtable->htable[i] = NULL;
     }
+    hashtable_resize (hashtable, hashtable->size_min);
 }
 
 /*
@@ -1285,8 +1474,11 @@ hashtable_print_log (struct t_hashtable *hashtable, const char *name)
     log_printf ("");
     log_printf ("[hashtable %s (addr:0x%lx)]", name, hashtable);
     log_printf ("  size . . . . . . . . . : %d",    hashtable->size);
+    log_printf ("  size_min . . . . . . . : %d",    hashtable->size_min);
     log_printf ("  htable . . . . . . . . : 0x%lx", hashtable->htable);
     log_printf ("  items_count. . . . . . : %d",    hashtable->items_count);
+    log_printf ("  items. . . . . . . . . : 0x%lx", hashtable->items);
+    log_printf ("  last_item. . . . . . . : 0x%lx", hashtable->last_item);
     log_printf ("  type_keys. . . . . . . : %d (%s)",
                 hashtable->type_keys,
                 hashtable_type_string[hashtable->type_keys]);
@@ -1301,55 +1493,57 @@ hashtable_print_log (struct t_hashtable *hashtable, const char *name)
 
     for (i = 0; i < hashtable->size; i++)
     {
-        log_printf ("  htable[%06d] . . . . : 0x%lx", i, hashtable->htable[i]);
-        for (ptr_item = hashtable->htable[i]; ptr_item;
-             ptr_item = ptr_item->next_item)
+        if (hashtable->htable[i])
+            log_printf ("  htable[%06d] . . . . : 0x%lx", i, hashtable->htable[i]);
+    }
+    for (ptr_item = hashtable->items; ptr_item;
+         ptr_item = ptr_item->next_item)
+    {
+        log_printf ("    [item 0x%lx]", ptr_item);
+        switch (hashtable->type_keys)
         {
-            log_printf ("    [item 0x%lx]", hashtable->htable);
-            switch (hashtable->type_keys)
-            {
-                case HASHTABLE_INTEGER:
-                    log_printf ("      key (integer). . . : %d", *((int *)ptr_item->key));
-                    break;
-                case HASHTABLE_STRING:
-                    log_printf ("      key (string) . . . : '%s'", (char *)ptr_item->key);
-                    break;
-                case HASHTABLE_POINTER:
-                    log_printf ("      key (pointer). . . : 0x%lx", ptr_item->key);
-                    break;
-                case HASHTABLE_BUFFER:
-                    log_printf ("      key (buffer) . . . : 0x%lx", ptr_item->key);
-                    break;
-                case HASHTABLE_TIME:
-                    log_printf ("      key (time) . . . . : %lld", (long long)(*((time_t *)ptr_item->key)));
-                    break;
-                case HASHTABLE_NUM_TYPES:
-                    break;
-            }
-            log_printf ("      key_size . . . . . : %d", ptr_item->key_size);
-            switch (hashtable->type_values)
-            {
-                case HASHTABLE_INTEGER:
-                    log_printf ("      value (integer). . : %d", *((int *)ptr_item->value));
-                    break;
-                case HASHTABLE_STRING:
-                    log_printf ("      value (string) . . : '%s'", (char *)ptr_item->value);
-                    break;
-                case HASHTABLE_POINTER:
-                    log_printf ("      value (pointer). . : 0x%lx", ptr_item->value);
-                    break;
-                case HASHTABLE_BUFFER:
-                    log_printf ("      value (buffer) . . : 0x%lx", ptr_item->value);
-                    break;
-                case HASHTABLE_TIME:
-                    log_printf ("      value (time) . . . : %lld", (long long)(*((time_t *)ptr_item->value)));
-                    break;
-                case HASHTABLE_NUM_TYPES:
-                    break;
-            }
-            log_printf ("      value_size . . . . : %d",    ptr_item->value_size);
-            log_printf ("      prev_item. . . . . : 0x%lx", ptr_item->prev_item);
-            log_printf ("      next_item. . . . . : 0x%lx", ptr_item->next_item);
+            case HASHTABLE_INTEGER:
+                log_printf ("      key (integer). . . : %d", *((int *)ptr_item->key));
+                break;
+            case HASHTABLE_STRING:
+                log_printf ("      key (string) . . . : '%s'", (char *)ptr_item->key);
+                break;
+            case HASHTABLE_POINTER:
+                log_printf ("      key (pointer). . . : 0x%lx", ptr_item->key);
+                break;
+            case HASHTABLE_BUFFER:
+                log_printf ("      key (buffer) . . . : 0x%lx", ptr_item->key);
+                break;
+            case HASHTABLE_TIME:
+                log_printf ("      key (time) . . . . : %lld", (long long)(*((time_t *)ptr_item->key)));
+                break;
+            case HASHTABLE_NUM_TYPES:
+                break;
+        }
+        log_printf ("      key_size . . . . . : %d", ptr_item->key_size);
+        switch (hashtable->type_values)
+        {
+            case HASHTABLE_INTEGER:
+                log_printf ("      value (integer). . : %d", *((int *)ptr_item->value));
+                break;
+            case HASHTABLE_STRING:
+                log_printf ("      value (string) . . : '%s'", (char *)ptr_item->value);
+                break;
+            case HASHTABLE_POINTER:
+                log_printf ("      value (pointer). . : 0x%lx", ptr_item->value);
+                break;
+            case HASHTABLE_BUFFER:
+                log_printf ("      value (buffer) . . : 0x%lx", ptr_item->value);
+                break;
+            case HASHTABLE_TIME:
+                log_printf ("      value (time) . . . : %lld", (long long)(*((time_t *)ptr_item->value)));
+                break;
+            case HASHTABLE_NUM_TYPES:
+                break;
         }
+        log_printf ("      value_size . . . . : %d",    ptr_item->value_size);
+        log_printf ("      hash . . . . . . . : %llu",  ptr_item->hash);
+        log_printf ("      prev_item. . . . . : 0x%lx", ptr_item->prev_item);
+        log_printf ("      next_item. . . . . : 0x%lx", ptr_item->next_item);
     }
 }
@@ -24,6 +24,9 @@ struct t_hashtable;
 struct t_infolist;
 struct t_infolist_item;
 
+/* max size of htable in a hashtable */
+#define HASHTABLE_SIZE_MAX (1 << 30)
+
 /*
  * Macros to set various values as string value in the hashtable;
  * variable hashtable must be defined and str_value must be a static
@@ -68,15 +71,22 @@ typedef void (t_hashtable_map_string)(void *data,
                                       const char *key, const char *value);
 
 /*
- * Hashtable is a structure with an array "htable", each entry is a pointer
- * to a linked list, and it is read with hashed key (as unsigned long long).
- * Keys with same hashed key are grouped in a linked list pointed by htable.
- * The htable is not sorted, the linked list is sorted.
+ * Hashtable is a structure with an array "htable" (size is a power of 2),
+ * each entry is NULL or a pointer to an item, and it is read with hashed key
+ * (as unsigned long long, mixed to spread all bits): an item is stored in
+ * the first free entry found from hash % size (open addressing with linear
+ * probing).
+ * The array is resized when items are added or removed, so that it is never
+ * more than 3/4 full (and it is never smaller than size given on creation).
+ *
+ * All items are also in a linked list (in order of creation), used to
+ * iterate on hashtable: a callback of hashtable_map can safely remove the
+ * current item or add items in hashtable.
  *
  * Example of a hashtable with size 8 and 6 items added inside, items are:
  * "weechat", "fast", "light", "extensible", "chat", "client"
- * Keys "fast" and "light" have same hashed value, so they are together in
- * linked list.
+ * Keys "fast" and "light" have same hashed value, so "light" is in the next
+ * free entry.
  *
  * Result is:
  * +-----+
@@ -86,9 +96,9 @@ typedef void (t_hashtable_map_string)(void *data,
  * +-----+
  * |   2 | --> "extensible"
  * +-----+
- * |   3 | --> "fast" --> "light"
+ * |   3 | --> "fast"
  * +-----+
- * |   4 |
+ * |   4 | --> "light"
  * +-----+
  * |   5 | --> "chat"
  * +-----+
@@ -96,6 +106,9 @@ typedef void (t_hashtable_map_string)(void *data,
  * +-----+
  * |   7 | --> "weechat"
  * +-----+
+ *
+ * Linked list: "weechat" <-> "fast" <-> "light" <-> "extensible"
+ *              <-> "chat" <-> "client"
  */
 
 enum t_hashtable_type
@@ -111,20 +124,24 @@ enum t_hashtable_type
 
 struct t_hashtable_item
 {
-    void *key;                          /* item key                         */
+    void *key;                          /* item key (copied keys are stored */
+                                        /* in same allocation as item)      */
     int key_size;                       /* size of key (in bytes)           */
     void *value;                        /* pointer to value                 */
     int value_size;                     /* size of value (in bytes)         */
+    unsigned long long hash;            /* hashed key (mixed)               */
     struct t_hashtable_item *prev_item; /* link to previous item            */
     struct t_hashtable_item *next_item; /* link to next item                */
 };
 
 struct t_hashtable
 {
-    int size;                          /* hashtable size                    */
-    struct t_hashtable_item **htable;  /* table to map hashes with linked   */
-                                       /* lists                             */
+    int size;                          /* hashtable size (power of 2)       */
+    int size_min;                      /* min size (size on creation)       */
+    struct t_hashtable_item **htable;  /* table to map hashes with items    */
     int items_count;                   /* number of items in hashtable      */
+    struct t_hashtable_item *items;    /* items (in order of creation)      */
+    struct t_hashtable_item *last_item; /* last item                        */
 
     /* type for keys and values */
     enum t_hashtable_type type_keys;   /* type for keys: int/str/pointer    */
@@ -142,6 +159,7 @@ struct t_hashtable
 };
 
 extern unsigned long long hashtable_hash_key_djb2 (const char *string);
+extern unsigned long long hashtable_hash_mix (unsigned long long hash);
 extern struct t_hashtable *hashtable_new (int size,
                                           const char *type_keys,
                                           const char *type_values,
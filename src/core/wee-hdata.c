@@ -42,6 +42,9 @@ struct t_hashtable *hdata_search_pointers = NULL;
 struct t_hashtable *hdata_search_extra_vars = NULL;
 struct t_hashtable *hdata_search_options = NULL;
 
+/* registries of live objects, by hdata name (used to check pointers) */
+struct t_hashtable *hdata_registries = NULL;
+
 char *hdata_type_string[9] =
 { "other", "char", "integer", "long", "string", "pointer", "time",
   "hashtable", "shared_string" };
@@ -436,6 +439,107 @@ hdata_get_list (struct t_hdata *hdata, const char *name)
     return NULL;
 }
 
+/*
+ * Adds a pointer in the registry of live objects for a hdata.
+ *
+ * The registry must contain all objects of this hdata, which are all in the
+ * list(s) of hdata with flag "check_pointers". It is used by
+ * hdata_check_pointer() to check a pointer without walking the list.
+ */
+
+void
+hdata_registry_add (const char *hdata_name, void *pointer)
+{
+    struct t_hashtable *ptr_registry;
+
+    if (!hdata_name || !pointer)
+        return;
+
+    if (!hdata_registries)
+    {
+        hdata_registries = hashtable_new (32,
+                                          WEECHAT_HASHTABLE_STRING,
+                                          WEECHAT_HASHTABLE_POINTER,
+                                          NULL,
+                                          NULL);
+        if (!hdata_registries)
+            return;
+    }
+
+    ptr_registry = hashtable_get (hdata_registries, hdata_name);
+    if (!ptr_registry)
+    {
+        ptr_registry = hashtable_new (64,
+                                      WEECHAT_HASHTABLE_POINTER,
+                                      WEECHAT_HASHTABLE_POINTER,
+                                      NULL,
+                                      NULL);
+        if (!ptr_registry)
+            return;
+        hashtable_set (hdata_registries, hdata_name, ptr_registry);
+    }
+
+    hashtable_set (ptr_registry, pointer, NULL);
+}
+
+/*
+ * Removes a pointer from the registry of live objects for a hdata.
+ */
+
+void
+hdata_registry_remove (const char *hdata_name, void *pointer)
+{
+    struct t_hashtable *ptr_registry;
+
+    if (!hdata_registries || !hdata_name || !pointer)
+        return;
+
+    ptr_registry = hashtable_get (hdata_registries, hdata_name);
+    if (ptr_registry)
+        hashtable_remove (ptr_registry, pointer);
+}
+
+/*
+ * Frees a registry of live objects.
+ */
+
+void
+hdata_registry_free_map_cb (void *data, struct t_hashtable *hashtable,
+                            const void *key, const void *value)
+{
+    /* make C compiler happy */
+    (void) data;
+    (void) hashtable;
+    (void) key;
+
+    hashtable_free ((struct t_hashtable *)value);
+}
+
+/*
+ * Checks if a list is a list of hdata with flag "check_pointers".
+ */
+
+void
+hdata_check_pointers_list_map_cb (void *data, struct t_hashtable *hashtable,
+                                  const void *key, const void *value)
+{
+    void **pointers;
+    struct t_hdata_list *ptr_list;
+
+    /* make C compiler happy */
+    (void) hashtable;
+    (void) key;
+
+    pointers = (void **)data;
+    ptr_list = (struct t_hdata_list *)value;
+
+    if (ptr_list && (ptr_list->flags & WEECHAT_HDATA_LIST_CHECK_POINTERS)
+        && (*((void **)(ptr_list->pointer)) == pointers[0]))
+    {
+        pointers[1] = (void *)1;
+    }
+}
+
 /*
  * Checks if a pointer is in the list.
  *
@@ -511,6 +615,11 @@ hdata_check_pointer_map_cb (void *data, struct t_hashtable *hashtable,
  * the pointer is considered valid (so this function returns 1); if the
  * pointer is not found in any list, this function returns 0.
  *
+ * If a registry of live objects exists for this hdata (see function
+ * hdata_registry_add), the check is made in the registry (without walking
+ * the list), except if the given list is not a list with flag
+ * "check_pointers" and the pointer is a live object.
+ *
  * Returns:
  *   1: pointer exists in the given list (or a list with check_pointers flag)
  *   0: pointer does not exist
@@ -519,16 +628,39 @@ hdata_check_pointer_map_cb (void *data, struct t_hashtable *hashtable,
 int
 hdata_check_pointer (struct t_hdata *hdata, void *list, void *pointer)
 {
+    struct t_hashtable *ptr_registry;
     void *pointers[4];
 
     if (!hdata || !pointer)
         return 0;
 
+    ptr_registry = (hdata_registries) ?
+        hashtable_get (hdata_registries, hdata->name) : NULL;
+
     if (list)
     {
+        if (ptr_registry)
+        {
+            /* not a live object: it can not be in any list */
+            if (!hashtable_has_key (ptr_registry, pointer))
+                return 0;
+            /* all live objects are in lists with flag "check_pointers" */
+            pointers[0] = list;
+            pointers[1] = NULL;
+            hashtable_map (hdata->hash_list,
+                           &hdata_check_pointers_list_map_cb,
+                           pointers);
+            if (pointers[1])
+                return 1;
+        }
         /* search pointer in the given list */
         return hdata_check_pointer_in_list (hdata, list, pointer);
     }
+    else if (ptr_registry)
+    {
+        /* search pointer in registry of live objects */
+        return hashtable_has_key (ptr_registry, pointer);
+    }
     else
     {
         /* search pointer in all lists with flag "check_pointers" */
@@ -1349,4 +1481,10 @@ hdata_end ()
         hashtable_free (hdata_search_options);
         hdata_search_options = NULL;
     }
+    if (hdata_registries)
+    {
+        hashtable_map (hdata_registries, &hdata_registry_free_map_cb, NULL);
+        hashtable_free (hdata_registries);
+        hdata_registries = NULL;
+    }
 }
@@ -27,16 +27,20 @@
 #include <unistd.h>
 #include <string.h>
 #include <time.h>
+#include <sys/time.h>
 #include <sys/socket.h>
 #include <errno.h>
 
 #include "weechat.h"
 #include "wee-hook.h"
+#include "wee-debug.h"
 #include "wee-hashtable.h"
+#include "wee-hdata.h"
 #include "wee-infolist.h"
 #include "wee-log.h"
 #include "wee-string.h"
 #include "wee-util.h"
+#include "../gui/gui-buffer.h"
 #include "../gui/gui-chat.h"
 #include "../plugins/plugin.h"
 
@@ -49,11 +53,18 @@ struct t_hook *weechat_hooks[HOOK_NUM_TYPES];     /* list of hooks          */
 struct t_hook *last_weechat_hook[HOOK_NUM_TYPES]; /* last hook              */
 int hooks_count[HOOK_NUM_TYPES];                  /* number of hooks        */
 int hooks_count_total = 0;                        /* total number of hooks  */
+struct t_hook_array hook_arrays[HOOK_NUM_TYPES];  /* sorted arrays of hooks */
+long long hook_generation = 0;         /* incremented for each new hook     */
 int hook_exec_recursion = 0;           /* 1 when a hook is executed         */
 int real_delete_pending = 0;           /* 1 if some hooks must be deleted   */
 
 int hook_socketpair_ok = 0;            /* 1 if socketpair() is OK           */
 
+int hook_profile_enabled = 0;          /* 1 if callbacks are profiled       */
+struct t_hook_profile *hook_profiles = NULL; /* profiling by plugin/script  */
+struct t_hook_profile *last_hook_profile = NULL; /* last profile            */
+struct t_hashtable *hook_profile_names = NULL; /* name -> profile           */
+
 /* hook callbacks */
 t_callback_hook *hook_callback_add[HOOK_NUM_TYPES] =
 { NULL, NULL, NULL, &hook_fd_add_cb, NULL, NULL, NULL, NULL, NULL, NULL,
@@ -108,6 +119,10 @@ hook_init ()
         weechat_hooks[type] = NULL;
         last_weechat_hook[type] = NULL;
         hooks_count[type] = 0;
+        hook_arrays[type].hooks = NULL;
+        hook_arrays[type].size = 0;
+        hook_arrays[type].size_alloc = 0;
+        hook_arrays[type].deleted = 0;
     }
     hooks_count_total = 0;
     hook_last_system_time = time (NULL);
@@ -174,160 +189,311 @@ hook_search_type (const char *type)
 }
 
 /*
- * Searches for position of hook in list (to keep hooks sorted).
+ * Compares two hooks of same type (to keep hooks sorted).
  *
  * Hooks are sorted by priority, except commands which are sorted by command
  * name, and then priority.
+ *
+ * Returns:
+ *   < 0: hook1 is before hook2
+ *     0: hook1 and hook2 have same position
+ *   > 0: hook1 is after hook2
  */
 
-struct t_hook *
-hook_find_pos (struct t_hook *hook)
+int
+hook_cmp (struct t_hook *hook1, struct t_hook *hook2)
 {
-    struct t_hook *ptr_hook;
     int rc_cmp;
 
-    if (hook->type == HOOK_TYPE_COMMAND)
+    if (hook1->type == HOOK_TYPE_COMMAND)
     {
         /* for command hook, sort on command name + priority */
-        for (ptr_hook = weechat_hooks[hook->type]; ptr_hook;
-             ptr_hook = ptr_hook->next_hook)
-        {
-            if (!ptr_hook->deleted)
-            {
-                rc_cmp = string_strcasecmp (HOOK_COMMAND(hook, command),
-                                            HOOK_COMMAND(ptr_hook, command));
-                if (rc_cmp < 0)
-                    return ptr_hook;
-                if ((rc_cmp == 0) && (hook->priority > ptr_hook->priority))
-                    return ptr_hook;
-            }
-        }
+        rc_cmp = string_strcasecmp (HOOK_COMMAND(hook1, command),
+                                    HOOK_COMMAND(hook2, command));
+        if (rc_cmp != 0)
+            return rc_cmp;
     }
-    else
+
+    if (hook1->priority > hook2->priority)
+        return -1;
+    if (hook1->priority < hook2->priority)
+        return 1;
+    return 0;
+}
+
+/*
+ * Searches for position of a new hook in array of hooks (binary search).
+ *
+ * The hook is inserted after hooks with the same position, so that hooks
+ * with same priority are kept in order of creation.
+ *
+ * Hooks marked as "deleted" are skipped, since their data may be already
+ * freed.
+ *
+ * Returns index where the hook must be inserted.
+ */
+
+int
+hook_find_pos (struct t_hook *hook)
+{
+    struct t_hook_array *ptr_array;
+    int low, high, middle, probe;
+
+    ptr_array = &hook_arrays[hook->type];
+
+    low = 0;
+    high = ptr_array->size;
+    while (low < high)
     {
-        /* for other types, sort on priority */
-        for (ptr_hook = weechat_hooks[hook->type]; ptr_hook;
-             ptr_hook = ptr_hook->next_hook)
+        middle = low + ((high - low) / 2);
+        probe = middle;
+        while ((probe < high) && ptr_array->hooks[probe]->deleted)
         {
-            if (!ptr_hook->deleted && (hook->priority > ptr_hook->priority))
-                return ptr_hook;
+            probe++;
         }
+        if ((probe >= high) || (hook_cmp (hook, ptr_array->hooks[probe]) < 0))
+            high = middle;
+        else
+            low = probe + 1;
     }
 
-    /* position not found, add at the end */
-    return NULL;
+    return low;
 }
 
 /*
  * Adds a hook to list.
+ *
+ * The hook is inserted in array of hooks (sorted), and in linked list of
+ * hooks, which is kept for hdata and infolists.
+ *
+ * Returns:
+ *   1: OK
+ *   0: error (not enough memory), the hook must be freed by the caller with
+ *      hook_free_new()
  */
 
-void
+int
 hook_add_to_list (struct t_hook *new_hook)
 {
-    struct t_hook *pos_hook;
+    struct t_hook_array *ptr_array;
+    struct t_hook **new_hooks;
+    int pos, new_size_alloc;
+
+    ptr_array = &hook_arrays[new_hook->type];
 
-    if (weechat_hooks[new_hook->type])
+    if (ptr_array->size >= ptr_array->size_alloc)
     {
-        pos_hook = hook_find_pos (new_hook);
-        if (pos_hook)
-        {
-            /* add hook before "pos_hook" */
-            new_hook->prev_hook = pos_hook->prev_hook;
-            new_hook->next_hook = pos_hook;
-            if (pos_hook->prev_hook)
-                (pos_hook->prev_hook)->next_hook = new_hook;
-            else
-                weechat_hooks[new_hook->type] = new_hook;
-            pos_hook->prev_hook = new_hook;
-        }
-        else
-        {
-            /* add hook to end of list */
-            new_hook->prev_hook = last_weechat_hook[new_hook->type];
-            new_hook->next_hook = NULL;
-            last_weechat_hook[new_hook->type]->next_hook = new_hook;
-            last_weechat_hook[new_hook->type] = new_hook;
-        }
+        new_size_alloc = (ptr_array->size_alloc < HOOK_ARRAY_SIZE_MIN) ?
+            HOOK_ARRAY_SIZE_MIN : ptr_array->size_alloc * 2;
+        new_hooks = realloc (ptr_array->hooks,
+                             new_size_alloc * sizeof (*new_hooks));
+        if (!new_hooks)
+            return 0;
+        ptr_array->hooks = new_hooks;
+        ptr_array->size_alloc = new_size_alloc;
     }
-    else
+
+    pos = hook_find_pos (new_hook);
+
+    /* insert hook in array */
+    if (pos < ptr_array->size)
     {
-        new_hook->prev_hook = NULL;
-        new_hook->next_hook = NULL;
+        memmove (&ptr_array->hooks[pos + 1],
+                 &ptr_array->hooks[pos],
+                 (ptr_array->size - pos) * sizeof (*ptr_array->hooks));
+    }
+    ptr_array->hooks[pos] = new_hook;
+    ptr_array->size++;
+
+    new_hook->generation = ++hook_generation;
+
+    /* insert hook in linked list, at same position */
+    new_hook->prev_hook = (pos > 0) ? ptr_array->hooks[pos - 1] : NULL;
+    new_hook->next_hook = (pos < ptr_array->size - 1) ?
+        ptr_array->hooks[pos + 1] : NULL;
+    if (new_hook->prev_hook)
+        (new_hook->prev_hook)->next_hook = new_hook;
+    else
         weechat_hooks[new_hook->type] = new_hook;
+    if (new_hook->next_hook)
+        (new_hook->next_hook)->prev_hook = new_hook;
+    else
         last_weechat_hook[new_hook->type] = new_hook;
-    }
 
     hooks_count[new_hook->type]++;
     hooks_count_total++;
 
     if (hook_callback_add[new_hook->type])
         (hook_callback_add[new_hook->type]) (new_hook);
+
+    return 1;
 }
 
 /*
- * Removes a hook from list.
+ * Frees a new hook which could not be added to list of hooks.
+ *
+ * The callback data is not freed: like for other errors in hook functions,
+ * it is still owned by the caller.
+ */
+
+void
+hook_free_new (struct t_hook *hook)
+{
+    if (!hook)
+        return;
+
+    (hook_callback_free_data[hook->type]) (hook);
+    free (hook);
+}
+
+/*
+ * Removes a hook from linked list and frees it.
+ *
+ * The hook must have been removed from array of hooks before calling this
+ * function.
  */
 
 void
 hook_remove_from_list (struct t_hook *hook)
 {
-    struct t_hook *new_hooks;
     int type;
 
     type = hook->type;
 
-    if (last_weechat_hook[hook->type] == hook)
-        last_weechat_hook[hook->type] = hook->prev_hook;
     if (hook->prev_hook)
-    {
         (hook->prev_hook)->next_hook = hook->next_hook;
-        new_hooks = weechat_hooks[hook->type];
-    }
     else
-        new_hooks = hook->next_hook;
-
+        weechat_hooks[type] = hook->next_hook;
     if (hook->next_hook)
         (hook->next_hook)->prev_hook = hook->prev_hook;
-
-    weechat_hooks[type] = new_hooks;
+    else
+        last_weechat_hook[type] = hook->prev_hook;
 
     hooks_count[type]--;
     hooks_count_total--;
 
-    if (hook_callback_remove[hook->type])
-        (hook_callback_remove[hook->type]) (hook);
+    if (hook_callback_remove[type])
+        (hook_callback_remove[type]) (hook);
 
     free (hook);
 }
 
 /*
- * Removes hooks marked as "deleted" from list.
+ * Removes hooks marked as "deleted" from arrays and lists.
+ *
+ * Each array of hooks is compacted in a single pass.
+ *
+ * If force == 0, an array is compacted only if the hooks marked as "deleted"
+ * are at least 1/HOOK_ARRAY_COMPACT_RATIO of the array (so that many calls to
+ * unhook don't compact the array each time); the other arrays are compacted
+ * at the end of main loop iteration (with force == 1).
+ *
+ * Nothing is done if a hook exec is pending.
  */
 
 void
-hook_remove_deleted ()
+hook_remove_deleted (int force)
 {
-    int type;
-    struct t_hook *ptr_hook, *next_hook;
+    struct t_hook_array *ptr_array;
+    struct t_hook *ptr_hook;
+    int type, i, j, pending;
 
-    if (real_delete_pending)
+    if (!real_delete_pending || (hook_exec_recursion > 0))
+        return;
+
+    pending = 0;
+
+    for (type = 0; type < HOOK_NUM_TYPES; type++)
     {
-        for (type = 0; type < HOOK_NUM_TYPES; type++)
+        ptr_array = &hook_arrays[type];
+        if (ptr_array->deleted == 0)
+            continue;
+        if (!force
+            && (ptr_array->deleted * HOOK_ARRAY_COMPACT_RATIO < ptr_array->size))
         {
-            ptr_hook = weechat_hooks[type];
-            while (ptr_hook)
-            {
-                next_hook = ptr_hook->next_hook;
+            pending = 1;
+            continue;
+        }
+        j = 0;
+        for (i = 0; i < ptr_array->size; i++)
+        {
+            ptr_hook = ptr_array->hooks[i];
+            if (ptr_hook->deleted)
+                hook_remove_from_list (ptr_hook);
+            else
+                ptr_array->hooks[j++] = ptr_hook;
+        }
+        ptr_array->size = j;
+        ptr_array->deleted = 0;
+        if (ptr_array->size == 0)
+        {
+            free (ptr_array->hooks);
+            ptr_array->hooks = NULL;
+            ptr_array->size_alloc = 0;
+        }
+    }
 
-                if (ptr_hook->deleted)
-                    hook_remove_from_list (ptr_hook);
+    real_delete_pending = pending;
+}
 
-                ptr_hook = next_hook;
-            }
+/*
+ * Initializes an iterator on hooks of a type.
+ *
+ * The iterator can be safely used while hooks are added or removed by
+ * callbacks: removed hooks are skipped, and hooks created after the
+ * initialization of iterator are skipped as well.
+ *
+ * The iterator must be used between calls to hook_exec_start() and
+ * hook_exec_end(), so that the array is not compacted during iteration.
+ */
+
+void
+hook_iterator_init (struct t_hook_iterator *iterator, int type)
+{
+    iterator->type = type;
+    iterator->index = 0;
+    iterator->generation = hook_generation;
+    iterator->last_hook = NULL;
+}
+
+/*
+ * Returns next hook of an iterator, NULL if there are no more hooks.
+ */
+
+struct t_hook *
+hook_iterator_next (struct t_hook_iterator *iterator)
+{
+    struct t_hook_array *ptr_array;
+    struct t_hook *ptr_hook;
+
+    ptr_array = &hook_arrays[iterator->type];
+
+    /*
+     * if hooks were inserted before the last hook visited, it has moved in
+     * array: search it again (hooks can only move to the right)
+     */
+    if (iterator->last_hook)
+    {
+        while ((iterator->index <= ptr_array->size)
+               && (ptr_array->hooks[iterator->index - 1] != iterator->last_hook))
+        {
+            iterator->index++;
         }
-        real_delete_pending = 0;
     }
+
+    while (iterator->index < ptr_array->size)
+    {
+        ptr_hook = ptr_array->hooks[iterator->index];
+        iterator->index++;
+        iterator->last_hook = ptr_hook;
+        if (!ptr_hook->deleted
+            && (ptr_hook->generation <= iterator->generation))
+        {
+            return ptr_hook;
+        }
+    }
+
+    return NULL;
 }
 
 /*
@@ -389,6 +555,11 @@ hook_init_data (struct t_hook *hook, struct t_weechat_plugin *plugin,
     hook->priority = priority;
     hook->callback_pointer = callback_pointer;
     hook->callback_data = callback_data;
+    hook->generation = 0;
+    hook->profile_calls = 0;
+    hook->profile_time_total = 0;
+    hook->profile_time_max = 0;
+    hook->batch = NULL;
     hook->hook_data = NULL;
 
     if (weechat_debug_core >= 2)
@@ -455,7 +626,296 @@ hook_exec_end ()
         hook_exec_recursion--;
 
     if (hook_exec_recursion == 0)
-        hook_remove_deleted ();
+        hook_remove_deleted (0);
+}
+
+/*
+ * Searches for profiling data of a plugin/script by name, creates it if not
+ * found.
+ *
+ * Returns pointer to profile, NULL if error.
+ */
+
+struct t_hook_profile *
+hook_profile_search_or_add (const char *name)
+{
+    struct t_hook_profile *new_profile;
+
+    if (!hook_profile_names)
+    {
+        hook_profile_names = hashtable_new (32,
+                                            WEECHAT_HASHTABLE_STRING,
+                                            WEECHAT_HASHTABLE_POINTER,
+                                            NULL, NULL);
+        if (!hook_profile_names)
+            return NULL;
+    }
+
+    new_profile = hashtable_get (hook_profile_names, name);
+    if (new_profile)
+        return new_profile;
+
+    new_profile = malloc (sizeof (*new_profile));
+    if (!new_profile)
+        return NULL;
+
+    new_profile->name = strdup (name);
+    new_profile->calls = 0;
+    new_profile->time_total = 0;
+    new_profile->time_max = 0;
+
+    new_profile->prev_profile = last_hook_profile;
+    new_profile->next_profile = NULL;
+    if (last_hook_profile)
+        last_hook_profile->next_profile = new_profile;
+    else
+        hook_profiles = new_profile;
+    last_hook_profile = new_profile;
+
+    hashtable_set (hook_profile_names, name, new_profile);
+
+    return new_profile;
+}
+
+/*
+ * Starts execution of a hook callback.
+ *
+ * If profiling or detection of main loop stalls is enabled, the start time
+ * is saved in hook_exec_cb.
+ */
+
+void
+hook_callback_start (struct t_hook *hook, struct t_hook_exec_cb *hook_exec_cb)
+{
+    hook->running++;
+
+    hook_exec_cb->profile = (hook_profile_enabled
+                             || (debug_loop_stall_threshold > 0));
+    if (hook_exec_cb->profile)
+        gettimeofday (&(hook_exec_cb->start_time), NULL);
+}
+
+/*
+ * Ends execution of a hook callback.
+ *
+ * If profiling is enabled, the time spent in callback is added to the hook
+ * and to the plugin/script which created the hook.
+ *
+ * The time is also sent to the detection of main loop stalls.
+ *
+ * Note: the hook may have been removed in the callback (it is then marked
+ * as "deleted" and still in memory until the end of hook exec).
+ */
+
+void
+hook_callback_end (struct t_hook *hook, struct t_hook_exec_cb *hook_exec_cb)
+{
+    struct timeval end_time;
+    struct t_hook_profile *ptr_profile;
+    char name[1024];
+    long time_diff;
+
+    if (hook->running > 0)
+        hook->running--;
+
+    if (!hook_exec_cb->profile)
+        return;
+
+    gettimeofday (&end_time, NULL);
+    time_diff = (long)util_timeval_diff (&(hook_exec_cb->start_time),
+                                         &end_time);
+
+    debug_loop_callback (hook, time_diff);
+
+    if (!hook_profile_enabled)
+        return;
+
+    hook->profile_calls++;
+    hook->profile_time_total += time_diff;
+    if (time_diff > hook->profile_time_max)
+        hook->profile_time_max = time_diff;
+
+    snprintf (name, sizeof (name),
+              "%s%s%s",
+              plugin_get_name (hook->plugin),
+              (hook->subplugin) ? "/" : "",
+              (hook->subplugin) ? hook->subplugin : "");
+    ptr_profile = hook_profile_search_or_add (name);
+    if (ptr_profile)
+    {
+        ptr_profile->calls++;
+        ptr_profile->time_total += time_diff;
+        if (time_diff > ptr_profile->time_max)
+            ptr_profile->time_max = time_diff;
+    }
+}
+
+/*
+ * Returns a short description of a hook (command name, signal, ...).
+ *
+ * Note: result must be used immediately (static buffer).
+ */
+
+const char *
+hook_get_description (struct t_hook *hook)
+{
+    static char description[1024];
+
+    description[0] = '\0';
+
+    if (!hook || hook->deleted || !hook->hook_data)
+        return description;
+
+    switch (hook->type)
+    {
+        case HOOK_TYPE_COMMAND:
+            snprintf (description, sizeof (description),
+                      "/%s", HOOK_COMMAND(hook, command));
+            break;
+        case HOOK_TYPE_COMMAND_RUN:
+            snprintf (description, sizeof (description),
+                      "%s", HOOK_COMMAND_RUN(hook, command));
+            break;
+        case HOOK_TYPE_TIMER:
+            snprintf (description, sizeof (description),
+                      "%ld ms", HOOK_TIMER(hook, interval));
+            break;
+        case HOOK_TYPE_FD:
+            snprintf (description, sizeof (description),
+                      "fd %d", HOOK_FD(hook, fd));
+            break;
+        case HOOK_TYPE_PROCESS:
+            snprintf (description, sizeof (description),
+                      "%s", HOOK_PROCESS(hook, command));
+            break;
+        case HOOK_TYPE_CONNECT:
+            snprintf (description, sizeof (description),
+                      "%s/%d",
+                      HOOK_CONNECT(hook, address),
+                      HOOK_CONNECT(hook, port));
+            break;
+        case HOOK_TYPE_LINE:
+            snprintf (description, sizeof (description),
+                      "%d buffer(s)", HOOK_LINE(hook, num_buffers));
+            break;
+        case HOOK_TYPE_PRINT:
+            snprintf (description, sizeof (description),
+                      "%s",
+                      (HOOK_PRINT(hook, buffer)) ?
+                      HOOK_PRINT(hook, buffer)->full_name : "*");
+            break;
+        case HOOK_TYPE_SIGNAL:
+            snprintf (description, sizeof (description),
+                      "%s", HOOK_SIGNAL(hook, signal));
+            break;
+        case HOOK_TYPE_HSIGNAL:
+            snprintf (description, sizeof (description),
+                      "%s", HOOK_HSIGNAL(hook, signal));
+            break;
+        case HOOK_TYPE_CONFIG:
+            snprintf (description, sizeof (description),
+                      "%s",
+                      (HOOK_CONFIG(hook, option)) ?
+                      HOOK_CONFIG(hook, option) : "*");
+            break;
+        case HOOK_TYPE_COMPLETION:
+            snprintf (description, sizeof (description),
+                      "%s", HOOK_COMPLETION(hook, completion_item));
+            break;
+        case HOOK_TYPE_MODIFIER:
+            snprintf (description, sizeof (description),
+                      "%s", HOOK_MODIFIER(hook, modifier));
+            break;
+        case HOOK_TYPE_INFO:
+            snprintf (description, sizeof (description),
+                      "%s", HOOK_INFO(hook, info_name));
+            break;
+        case HOOK_TYPE_INFO_HASHTABLE:
+            snprintf (description, sizeof (description),
+                      "%s", HOOK_INFO_HASHTABLE(hook, info_name));
+            break;
+        case HOOK_TYPE_INFOLIST:
+            snprintf (description, sizeof (description),
+                      "%s", HOOK_INFOLIST(hook, infolist_name));
+            break;
+        case HOOK_TYPE_HDATA:
+            snprintf (description, sizeof (description),
+                      "%s", HOOK_HDATA(hook, hdata_name));
+            break;
+        case HOOK_TYPE_FOCUS:
+            snprintf (description, sizeof (description),
+                      "%s", HOOK_FOCUS(hook, area));
+            break;
+        case HOOK_NUM_TYPES:
+            /*
+             * this constant is used to count types only,
+             * it is never used as type
+             */
+            break;
+    }
+
+    return description;
+}
+
+/*
+ * Enables or disables profiling of hook callbacks.
+ */
+
+void
+hook_profile_enable (int enable)
+{
+    hook_profile_enabled = (enable) ? 1 : 0;
+}
+
+/*
+ * Frees all profiling data by plugin/script.
+ */
+
+void
+hook_profile_free_all ()
+{
+    struct t_hook_profile *next_profile;
+
+    while (hook_profiles)
+    {
+        next_profile = hook_profiles->next_profile;
+        if (hook_profiles->name)
+            free (hook_profiles->name);
+        free (hook_profiles);
+        hook_profiles = next_profile;
+    }
+    last_hook_profile = NULL;
+
+    if (hook_profile_names)
+    {
+        hashtable_free (hook_profile_names);
+        hook_profile_names = NULL;
+    }
+}
+
+/*
+ * Resets profiling data: counters in all hooks and profiling by
+ * plugin/script.
+ */
+
+void
+hook_profile_reset ()
+{
+    int type;
+    struct t_hook *ptr_hook;
+
+    for (type = 0; type < HOOK_NUM_TYPES; type++)
+    {
+        for (ptr_hook = weechat_hooks[type]; ptr_hook;
+             ptr_hook = ptr_hook->next_hook)
+        {
+            ptr_hook->profile_calls = 0;
+            ptr_hook->profile_time_total = 0;
+            ptr_hook->profile_time_max = 0;
+        }
+    }
+
+    hook_profile_free_all ();
 }
 
 /*
@@ -561,6 +1021,7 @@ unhook (struct t_hook *hook)
     (hook_callback_free_data[hook->type]) (hook);
 
     /* free data common to all hooks */
+    hook_batch_free (hook);
     if (hook->subplugin)
     {
         free (hook->subplugin);
@@ -572,17 +1033,15 @@ unhook (struct t_hook *hook)
         hook->callback_data = NULL;
     }
 
-    /* remove hook from list (if there's no hook exec pending) */
-    if (hook_exec_recursion == 0)
-    {
-        hook_remove_from_list (hook);
-    }
-    else
-    {
-        /* there is one or more hook exec, then delete later */
-        hook->deleted = 1;
-        real_delete_pending = 1;
-    }
+    /*
+     * mark hook as deleted, it is removed from array and list later: when
+     * enough hooks are deleted in the array (if there's no hook exec pending)
+     * or at the end of main loop iteration
+     */
+    hook->deleted = 1;
+    hook_arrays[hook->type].deleted++;
+    real_delete_pending = 1;
+    hook_remove_deleted (0);
 }
 
 /*
@@ -595,6 +1054,9 @@ unhook_all_plugin (struct t_weechat_plugin *plugin, const char *subplugin)
     int type;
     struct t_hook *ptr_hook, *next_hook;
 
+    /* hooks are removed from arrays all at once, at the end */
+    hook_exec_start ();
+
     for (type = 0; type < HOOK_NUM_TYPES; type++)
     {
         ptr_hook = weechat_hooks[type];
@@ -613,6 +1075,8 @@ unhook_all_plugin (struct t_weechat_plugin *plugin, const char *subplugin)
             ptr_hook = next_hook;
         }
     }
+
+    hook_exec_end ();
 }
 
 /*
@@ -625,6 +1089,9 @@ unhook_all ()
     int type;
     struct t_hook *ptr_hook, *next_hook;
 
+    /* hooks are removed from arrays all at once, at the end */
+    hook_exec_start ();
+
     for (type = 0; type < HOOK_NUM_TYPES; type++)
     {
         ptr_hook = weechat_hooks[type];
@@ -635,6 +1102,8 @@ unhook_all ()
             ptr_hook = next_hook;
         }
     }
+
+    hook_exec_end ();
 }
 
 /*
@@ -676,6 +1145,12 @@ hook_add_to_infolist_pointer (struct t_infolist *infolist, struct t_hook *hook)
         return 0;
     if (!infolist_new_var_pointer (ptr_item, "callback_data", (void *)hook->callback_data))
         return 0;
+    if (!infolist_new_var_integer (ptr_item, "profile_calls", hook->profile_calls))
+        return 0;
+    if (!infolist_new_var_integer (ptr_item, "profile_time_total_ms", hook->profile_time_total / 1000))
+        return 0;
+    if (!infolist_new_var_integer (ptr_item, "profile_time_max_us", hook->profile_time_max))
+        return 0;
 
     /* hook deleted? return only hook info above */
     if (hook->deleted)
@@ -684,6 +1159,8 @@ hook_add_to_infolist_pointer (struct t_infolist *infolist, struct t_hook *hook)
     /* hook not deleted: add extra hook info */
     if (!(hook_callback_add_to_infolist[hook->type]) (ptr_item, hook))
         return 0;
+    if (!hook_batch_add_to_infolist (ptr_item, hook))
+        return 0;
 
     return 1;
 }
@@ -781,6 +1258,80 @@ hook_add_to_infolist (struct t_infolist *infolist, struct t_hook *pointer,
     return 1;
 }
 
+/*
+ * Returns hdata for profiling of hooks by plugin/script.
+ */
+
+struct t_hdata *
+hook_hdata_hook_profile_cb (const void *pointer, void *data,
+                            const char *hdata_name)
+{
+    struct t_hdata *hdata;
+
+    /* make C compiler happy */
+    (void) pointer;
+    (void) data;
+
+    hdata = hdata_new (NULL, hdata_name, "prev_profile", "next_profile",
+                       0, 0, NULL, NULL);
+    if (hdata)
+    {
+        HDATA_VAR(struct t_hook_profile, name, STRING, 0, NULL, NULL);
+        HDATA_VAR(struct t_hook_profile, calls, LONG, 0, NULL, NULL);
+        HDATA_VAR(struct t_hook_profile, time_total, LONG, 0, NULL, NULL);
+        HDATA_VAR(struct t_hook_profile, time_max, LONG, 0, NULL, NULL);
+        HDATA_VAR(struct t_hook_profile, prev_profile, POINTER, 0, NULL, hdata_name);
+        HDATA_VAR(struct t_hook_profile, next_profile, POINTER, 0, NULL, hdata_name);
+        HDATA_LIST(hook_profiles, WEECHAT_HDATA_LIST_CHECK_POINTERS);
+        HDATA_LIST(last_hook_profile, 0);
+    }
+    return hdata;
+}
+
+/*
+ * Adds profiling data by plugin/script in an infolist.
+ *
+ * Argument "arguments" is an optional name (wildcard "*" is allowed).
+ *
+ * Returns:
+ *   1: OK
+ *   0: error
+ */
+
+int
+hook_profile_add_to_infolist (struct t_infolist *infolist,
+                              const char *arguments)
+{
+    struct t_hook_profile *ptr_profile;
+    struct t_infolist_item *ptr_item;
+
+    if (!infolist)
+        return 0;
+
+    for (ptr_profile = hook_profiles; ptr_profile;
+         ptr_profile = ptr_profile->next_profile)
+    {
+        if (arguments && arguments[0]
+            && !string_match (ptr_profile->name, arguments, 0))
+        {
+            continue;
+        }
+        ptr_item = infolist_new_item (infolist);
+        if (!ptr_item)
+            return 0;
+        if (!infolist_new_var_string (ptr_item, "name", ptr_profile->name))
+            return 0;
+        if (!infolist_new_var_integer (ptr_item, "calls", ptr_profile->calls))
+            return 0;
+        if (!infolist_new_var_integer (ptr_item, "time_total_ms", ptr_profile->time_total / 1000))
+            return 0;
+        if (!infolist_new_var_integer (ptr_item, "time_max_us", ptr_profile->time_max))
+            return 0;
+    }
+
+    return 1;
+}
+
 /*
  * Prints hooks in WeeChat log file (usually for crash dump).
  */
@@ -808,10 +1359,15 @@ hook_print_log ()
             log_printf ("  priority. . . . . . . . : %d",    ptr_hook->priority);
             log_printf ("  callback_pointer. . . . : 0x%lx", ptr_hook->callback_pointer);
             log_printf ("  callback_data . . . . . : 0x%lx", ptr_hook->callback_data);
+            log_printf ("  generation. . . . . . . : %lld",  ptr_hook->generation);
+            log_printf ("  profile_calls . . . . . : %ld",   ptr_hook->profile_calls);
+            log_printf ("  profile_time_total. . . : %ld",   ptr_hook->profile_time_total);
+            log_printf ("  profile_time_max. . . . : %ld",   ptr_hook->profile_time_max);
             if (ptr_hook->deleted)
                 continue;
 
             (hook_callback_print_log[ptr_hook->type]) (ptr_hook);
+            hook_batch_print_log (ptr_hook);
 
             log_printf ("  prev_hook . . . . . . . : 0x%lx", ptr_hook->prev_hook);
             log_printf ("  next_hook . . . . . . . : 0x%lx", ptr_hook->next_hook);
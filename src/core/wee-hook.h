@@ -20,6 +20,7 @@
 #ifndef WEECHAT_HOOK_H
 #define WEECHAT_HOOK_H
 
+#include "hook/wee-hook-batch.h"
 #include "hook/wee-hook-command-run.h"
 #include "hook/wee-hook-command.h"
 #include "hook/wee-hook-completion.h"
@@ -49,6 +50,7 @@ struct t_weelist;
 struct t_hashtable;
 struct t_infolist;
 struct t_infolist_item;
+struct t_hdata;
 
 /* hook types */
 
@@ -82,10 +84,27 @@ enum t_hook_type
  */
 #define HOOK_PRIORITY_DEFAULT   1000
 
+/* min number of hooks allocated in array of hooks */
+#define HOOK_ARRAY_SIZE_MIN     16
+
+/*
+ * an array of hooks is compacted on unhook when at least 1/ratio of hooks
+ * are deleted (otherwise at the end of main loop iteration)
+ */
+#define HOOK_ARRAY_COMPACT_RATIO 4
+
 typedef void (t_callback_hook)(struct t_hook *hook);
 typedef int (t_callback_hook_infolist)(struct t_infolist_item *item,
                                        struct t_hook *hook);
 
+/* data used during execution of a hook callback */
+
+struct t_hook_exec_cb
+{
+    int profile;                       /* 1 if callback is timed            */
+    struct timeval start_time;         /* callback start time               */
+};
+
 struct t_hook
 {
     /* data common to all hooks */
@@ -101,6 +120,15 @@ struct t_hook
     int priority;                      /* priority (to sort hooks)          */
     const void *callback_pointer;      /* pointer sent to callback          */
     void *callback_data;               /* data sent to callback             */
+    long long generation;              /* creation number of hook           */
+
+    /* profiling of callback (when enabled with /debug hooks_profile) */
+    long profile_calls;                /* number of calls to callback       */
+    long profile_time_total;           /* total time in callback (in µs)    */
+    long profile_time_max;             /* max time of one call (in µs)      */
+
+    /* delivery of events by batches (only for print/signal hooks) */
+    struct t_hook_batch *batch;        /* batch data (NULL if disabled)     */
 
     /* hook data (depends on hook type) */
     void *hook_data;                   /* hook specific data                */
@@ -108,6 +136,38 @@ struct t_hook
     struct t_hook *next_hook;          /* link to next hook                 */
 };
 
+/* hooks of one type, sorted like the linked list of hooks */
+
+struct t_hook_array
+{
+    struct t_hook **hooks;             /* hooks (sorted)                    */
+    int size;                          /* number of hooks in array          */
+    int size_alloc;                    /* number of allocated hooks         */
+    int deleted;                       /* number of hooks marked deleted    */
+};
+
+/* iterator on hooks of one type (used to run callbacks) */
+
+struct t_hook_iterator
+{
+    int type;                          /* hook type                         */
+    int index;                         /* index of next hook in array       */
+    long long generation;              /* skip hooks created after this one */
+    struct t_hook *last_hook;          /* last hook visited                 */
+};
+
+/* profiling of hook callbacks, by plugin/script */
+
+struct t_hook_profile
+{
+    char *name;                        /* "plugin" or "plugin/script"       */
+    long calls;                        /* number of calls to callbacks      */
+    long time_total;                   /* total time in callbacks (in µs)   */
+    long time_max;                     /* max time of one call (in µs)      */
+    struct t_hook_profile *prev_profile; /* link to previous profile        */
+    struct t_hook_profile *next_profile; /* link to next profile            */
+};
+
 /* hook variables */
 
 extern char *hook_type_string[];
@@ -115,12 +175,19 @@ extern struct t_hook *weechat_hooks[];
 extern struct t_hook *last_weechat_hook[];
 extern int hooks_count[];
 extern int hooks_count_total;
+extern struct t_hook_array hook_arrays[];
+extern long long hook_generation;
 extern int hook_socketpair_ok;
+extern int hook_profile_enabled;
+extern struct t_hook_profile *hook_profiles;
+extern struct t_hook_profile *last_hook_profile;
 
 /* hook functions */
 
 extern void hook_init ();
-extern void hook_add_to_list (struct t_hook *new_hook);
+extern int hook_add_to_list (struct t_hook *new_hook);
+extern void hook_free_new (struct t_hook *hook);
+extern void hook_remove_deleted (int force);
 extern void hook_get_priority_and_name (const char *string, int *priority,
                                         const char **name);
 extern void hook_init_data (struct t_hook *hook,
@@ -128,8 +195,23 @@ extern void hook_init_data (struct t_hook *hook,
                             int type, int priority,
                             const void *callback_pointer, void *callback_data);
 extern int hook_valid (struct t_hook *hook);
+extern void hook_iterator_init (struct t_hook_iterator *iterator, int type);
+extern struct t_hook *hook_iterator_next (struct t_hook_iterator *iterator);
 extern void hook_exec_start ();
 extern void hook_exec_end ();
+extern void hook_callback_start (struct t_hook *hook,
+                                 struct t_hook_exec_cb *hook_exec_cb);
+extern void hook_callback_end (struct t_hook *hook,
+                               struct t_hook_exec_cb *hook_exec_cb);
+extern const char *hook_get_description (struct t_hook *hook);
+extern void hook_profile_enable (int enable);
+extern void hook_profile_reset ();
+extern void hook_profile_free_all ();
+extern struct t_hdata *hook_hdata_hook_profile_cb (const void *pointer,
+                                                   void *data,
+                                                   const char *hdata_name);
+extern int hook_profile_add_to_infolist (struct t_infolist *infolist,
+                                         const char *arguments);
 extern void hook_set (struct t_hook *hook, const char *property,
                       const char *value);
 extern void unhook (struct t_hook *hook);
@@ -27,14 +27,19 @@
 #include <string.h>
 
 #include "weechat.h"
+#include "wee-hashtable.h"
 #include "wee-log.h"
 #include "wee-string.h"
 #include "wee-infolist.h"
+#include "../plugins/plugin.h"
 
 
 struct t_infolist *weechat_infolists = NULL;
 struct t_infolist *last_weechat_infolist = NULL;
 
+/* alignment of memory allocated in infolist blocks */
+#define INFOLIST_ARENA_ALIGN(__size) (((__size) + 7) & ~((size_t)7))
+
 
 /*
  * Creates a new infolist.
@@ -54,6 +59,8 @@ infolist_new (struct t_weechat_plugin *plugin)
         new_infolist->items = NULL;
         new_infolist->last_item = NULL;
         new_infolist->ptr_item = NULL;
+        new_infolist->arena = NULL;
+        new_infolist->names = NULL;
 
         new_infolist->prev_infolist = last_weechat_infolist;
         new_infolist->next_infolist = NULL;
@@ -67,6 +74,106 @@ infolist_new (struct t_weechat_plugin *plugin)
     return new_infolist;
 }
 
+/*
+ * Allocates memory in the blocks of an infolist.
+ *
+ * Memory is never freed individually: all blocks are freed at once when the
+ * infolist is freed (so building a large infolist costs only a few calls to
+ * malloc, and freeing it only a few calls to free).
+ *
+ * Returns pointer to allocated memory, NULL if error.
+ */
+
+void *
+infolist_arena_alloc (struct t_infolist *infolist, size_t size)
+{
+    struct t_infolist_arena *new_arena;
+    size_t header_size, block_size;
+    void *ptr;
+
+    header_size = INFOLIST_ARENA_ALIGN(sizeof (*new_arena));
+    size = INFOLIST_ARENA_ALIGN(size);
+
+    if (!infolist->arena
+        || (infolist->arena->used + size > infolist->arena->size))
+    {
+        if (infolist->arena)
+        {
+            block_size = infolist->arena->size * 2;
+            if (block_size > INFOLIST_ARENA_BLOCK_SIZE_MAX)
+                block_size = INFOLIST_ARENA_BLOCK_SIZE_MAX;
+        }
+        else
+        {
+            block_size = INFOLIST_ARENA_BLOCK_SIZE;
+        }
+        if (block_size < size)
+            block_size = size;
+        new_arena = malloc (header_size + block_size);
+        if (!new_arena)
+            return NULL;
+        new_arena->size = block_size;
+        new_arena->used = 0;
+        new_arena->next_arena = infolist->arena;
+        infolist->arena = new_arena;
+    }
+
+    ptr = (char *)infolist->arena + header_size + infolist->arena->used;
+    infolist->arena->used += size;
+
+    return ptr;
+}
+
+/*
+ * Duplicates a string in the blocks of an infolist.
+ *
+ * Returns pointer to copy of string, NULL if error.
+ */
+
+char *
+infolist_arena_strdup (struct t_infolist *infolist, const char *string)
+{
+    char *new_string;
+    size_t length;
+
+    length = strlen (string) + 1;
+    new_string = infolist_arena_alloc (infolist, length);
+    if (new_string)
+        memcpy (new_string, string, length);
+
+    return new_string;
+}
+
+/*
+ * Gets an interned variable name: the same string is shared by all variables
+ * with this name in the infolist.
+ *
+ * Returns pointer to name, NULL if error.
+ */
+
+char *
+infolist_intern_name (struct t_infolist *infolist, const char *name)
+{
+    struct t_hashtable_item *ptr_item;
+
+    if (!infolist->names)
+    {
+        infolist->names = hashtable_new (32,
+                                         WEECHAT_HASHTABLE_STRING,
+                                         WEECHAT_HASHTABLE_POINTER,
+                                         NULL, NULL);
+        if (!infolist->names)
+            return NULL;
+    }
+
+    /* the name is stored once, as key in the hashtable */
+    ptr_item = hashtable_get_item (infolist->names, name, NULL);
+    if (!ptr_item)
+        ptr_item = hashtable_set (infolist->names, name, NULL);
+
+    return (ptr_item) ? (char *)ptr_item->key : NULL;
+}
+
 /*
  * Checks if an infolist pointer is valid.
  *
@@ -105,9 +212,13 @@ infolist_new_item (struct t_infolist *infolist)
 {
     struct t_infolist_item *new_item;
 
-    new_item = malloc (sizeof (*new_item));
+    if (!infolist)
+        return NULL;
+
+    new_item = infolist_arena_alloc (infolist, sizeof (*new_item));
     if (new_item)
     {
+        new_item->infolist = infolist;
         new_item->vars = NULL;
         new_item->last_var = NULL;
         new_item->fields = NULL;
@@ -124,6 +235,41 @@ infolist_new_item (struct t_infolist *infolist)
     return new_item;
 }
 
+/*
+ * Creates a new variable in an item, with a value already allocated in the
+ * infolist blocks (or a pointer for type "pointer").
+ *
+ * Returns pointer to new variable, NULL if error.
+ */
+
+struct t_infolist_var *
+infolist_new_var (struct t_infolist_item *item, const char *name,
+                  enum t_infolist_type type, void *value, int size)
+{
+    struct t_infolist_var *new_var;
+
+    new_var = infolist_arena_alloc (item->infolist, sizeof (*new_var));
+    if (!new_var)
+        return NULL;
+
+    new_var->name = infolist_intern_name (item->infolist, name);
+    if (!new_var->name)
+        return NULL;
+    new_var->type = type;
+    new_var->value = value;
+    new_var->size = size;
+
+    new_var->prev_var = item->last_var;
+    new_var->next_var = NULL;
+    if (item->last_var)
+        item->last_var->next_var = new_var;
+    else
+        item->vars = new_var;
+    item->last_var = new_var;
+
+    return new_var;
+}
+
 /*
  * Creates a new integer variable in an item.
  *
@@ -134,31 +280,18 @@ struct t_infolist_var *
 infolist_new_var_integer (struct t_infolist_item *item,
                           const char *name, int value)
 {
-    struct t_infolist_var *new_var;
+    int *ptr_value;
 
     if (!item || !name || !name[0])
         return NULL;
 
-    new_var = malloc (sizeof (*new_var));
-    if (new_var)
-    {
-        new_var->name = strdup (name);
-        new_var->type = INFOLIST_INTEGER;
-        new_var->value = malloc (sizeof (int));
-        if (new_var->value)
-            *((int *)new_var->value) = value;
-        new_var->size = 0;  /* not used for an integer */
-
-        new_var->prev_var = item->last_var;
-        new_var->next_var = NULL;
-        if (item->last_var)
-            item->last_var->next_var = new_var;
-        else
-            item->vars = new_var;
-        item->last_var = new_var;
-    }
+    ptr_value = infolist_arena_alloc (item->infolist, sizeof (*ptr_value));
+    if (!ptr_value)
+        return NULL;
+    *ptr_value = value;
 
-    return new_var;
+    /* size is not used for an integer */
+    return infolist_new_var (item, name, INFOLIST_INTEGER, ptr_value, 0);
 }
 
 /*
@@ -171,29 +304,21 @@ struct t_infolist_var *
 infolist_new_var_string (struct t_infolist_item *item,
                          const char *name, const char *value)
 {
-    struct t_infolist_var *new_var;
+    char *ptr_value;
 
     if (!item || !name || !name[0])
         return NULL;
 
-    new_var = malloc (sizeof (*new_var));
-    if (new_var)
+    ptr_value = NULL;
+    if (value)
     {
-        new_var->name = strdup (name);
-        new_var->type = INFOLIST_STRING;
-        new_var->value = (value) ? strdup (value) : NULL;
-        new_var->size = 0;  /* not used for a string */
-
-        new_var->prev_var = item->last_var;
-        new_var->next_var = NULL;
-        if (item->last_var)
-            item->last_var->next_var = new_var;
-        else
-            item->vars = new_var;
-        item->last_var = new_var;
+        ptr_value = infolist_arena_strdup (item->infolist, value);
+        if (!ptr_value)
+            return NULL;
     }
 
-    return new_var;
+    /* size is not used for a string */
+    return infolist_new_var (item, name, INFOLIST_STRING, ptr_value, 0);
 }
 
 /*
@@ -206,29 +331,11 @@ struct t_infolist_var *
 infolist_new_var_pointer (struct t_infolist_item *item,
                           const char *name, void *pointer)
 {
-    struct t_infolist_var *new_var;
-
     if (!item || !name || !name[0])
         return NULL;
 
-    new_var = malloc (sizeof (*new_var));
-    if (new_var)
-    {
-        new_var->name = strdup (name);
-        new_var->type = INFOLIST_POINTER;
-        new_var->value = pointer;
-        new_var->size = 0;  /* not used for a pointer */
-
-        new_var->prev_var = item->last_var;
-        new_var->next_var = NULL;
-        if (item->last_var)
-            item->last_var->next_var = new_var;
-        else
-            item->vars = new_var;
-        item->last_var = new_var;
-    }
-
-    return new_var;
+    /* size is not used for a pointer */
+    return infolist_new_var (item, name, INFOLIST_POINTER, pointer, 0);
 }
 
 /*
@@ -241,31 +348,17 @@ struct t_infolist_var *
 infolist_new_var_buffer (struct t_infolist_item *item,
                          const char *name, void *pointer, int size)
 {
-    struct t_infolist_var *new_var;
+    void *ptr_value;
 
     if (!item || !name || !name[0] || (size <= 0))
         return NULL;
 
-    new_var = malloc (sizeof (*new_var));
-    if (new_var)
-    {
-        new_var->name = strdup (name);
-        new_var->type = INFOLIST_BUFFER;
-        new_var->value = malloc (size);
-        if (new_var->value)
-            memcpy (new_var->value, pointer, size);
-        new_var->size = size;
-
-        new_var->prev_var = item->last_var;
-        new_var->next_var = NULL;
-        if (item->last_var)
-            item->last_var->next_var = new_var;
-        else
-            item->vars = new_var;
-        item->last_var = new_var;
-    }
+    ptr_value = infolist_arena_alloc (item->infolist, size);
+    if (!ptr_value)
+        return NULL;
+    memcpy (ptr_value, pointer, size);
 
-    return new_var;
+    return infolist_new_var (item, name, INFOLIST_BUFFER, ptr_value, size);
 }
 
 /*
@@ -278,31 +371,18 @@ struct t_infolist_var *
 infolist_new_var_time (struct t_infolist_item *item,
                        const char *name, time_t time)
 {
-    struct t_infolist_var *new_var;
+    time_t *ptr_value;
 
     if (!item || !name || !name[0])
         return NULL;
 
-    new_var = malloc (sizeof (*new_var));
-    if (new_var)
-    {
-        new_var->name = strdup (name);
-        new_var->type = INFOLIST_TIME;
-        new_var->value = malloc (sizeof (time_t));
-        if (new_var->value)
-            *((time_t *)new_var->value) = time;
-        new_var->size = 0;  /* not used for a time */
-
-        new_var->prev_var = item->last_var;
-        new_var->next_var = NULL;
-        if (item->last_var)
-            item->last_var->next_var = new_var;
-        else
-            item->vars = new_var;
-        item->last_var = new_var;
-    }
+    ptr_value = infolist_arena_alloc (item->infolist, sizeof (*ptr_value));
+    if (!ptr_value)
+        return NULL;
+    *ptr_value = time;
 
-    return new_var;
+    /* size is not used for a time */
+    return infolist_new_var (item, name, INFOLIST_TIME, ptr_value, 0);
 }
 
 /*
@@ -398,7 +478,7 @@ infolist_fields (struct t_infolist *infolist)
         length += strlen (ptr_var->name) + 3;
     }
 
-    infolist->ptr_item->fields = malloc (length + 1);
+    infolist->ptr_item->fields = infolist_arena_alloc (infolist, length + 1);
     if (!infolist->ptr_item->fields)
         return NULL;
 
@@ -578,90 +658,6 @@ infolist_time (struct t_infolist *infolist, const char *var)
     return 0;
 }
 
-/*
- * Frees a variable in item.
- */
-
-void
-infolist_var_free (struct t_infolist_item *item,
-                   struct t_infolist_var *var)
-{
-    struct t_infolist_var *new_vars;
-
-    if (!item || !var)
-        return;
-
-    /* remove var */
-    if (item->last_var == var)
-        item->last_var = var->prev_var;
-    if (var->prev_var)
-    {
-        (var->prev_var)->next_var = var->next_var;
-        new_vars = item->vars;
-    }
-    else
-        new_vars = var->next_var;
-
-    if (var->next_var)
-        (var->next_var)->prev_var = var->prev_var;
-
-    /* free data */
-    if (var->name)
-        free (var->name);
-    if (((var->type == INFOLIST_INTEGER)
-         || (var->type == INFOLIST_STRING)
-         || (var->type == INFOLIST_BUFFER)
-         || (var->type == INFOLIST_TIME))
-        && var->value)
-    {
-        free (var->value);
-    }
-
-    free (var);
-
-    item->vars = new_vars;
-}
-
-/*
- * Frees an item in infolist.
- */
-
-void
-infolist_item_free (struct t_infolist *infolist,
-                    struct t_infolist_item *item)
-{
-    struct t_infolist_item *new_items;
-
-    if (!infolist || !item)
-        return;
-
-    /* remove var */
-    if (infolist->last_item == item)
-        infolist->last_item = item->prev_item;
-    if (item->prev_item)
-    {
-        (item->prev_item)->next_item = item->next_item;
-        new_items = infolist->items;
-    }
-    else
-        new_items = item->next_item;
-
-    if (item->next_item)
-        (item->next_item)->prev_item = item->prev_item;
-
-    /* free data */
-    while (item->vars)
-    {
-        infolist_var_free (item, item->vars);
-    }
-    if (item->fields)
-        free (item->fields);
-
-    free (item);
-
-    infolist->items = new_items;
-}
-
 /*
  * Frees an infolist.
  */
@@ -670,6 +666,7 @@ void
 infolist_free (struct t_infolist *infolist)
 {
     struct t_infolist *new_weechat_infolists;
+    struct t_infolist_arena *ptr_arena;
 
     if (!infolist)
         return;
@@ -689,10 +686,14 @@ infolist_free (struct t_infolist *infolist)
         (infolist->next_infolist)->prev_infolist = infolist->prev_infolist;
 
     /* free data */
-    while (infolist->items)
+    while (infolist->arena)
     {
-        infolist_item_free (infolist, infolist->items);
+        ptr_arena = infolist->arena->next_arena;
+        free (infolist->arena);
+        infolist->arena = ptr_arena;
     }
+    if (infolist->names)
+        hashtable_free (infolist->names);
 
     free (infolist);
 
@@ -738,6 +739,8 @@ infolist_print_log ()
         log_printf ("  items. . . . . . . . . : 0x%lx", ptr_infolist->items);
         log_printf ("  last_item. . . . . . . : 0x%lx", ptr_infolist->last_item);
         log_printf ("  ptr_item . . . . . . . : 0x%lx", ptr_infolist->ptr_item);
+        log_printf ("  arena. . . . . . . . . : 0x%lx", ptr_infolist->arena);
+        log_printf ("  names. . . . . . . . . : 0x%lx", ptr_infolist->names);
         log_printf ("  prev_infolist. . . . . : 0x%lx", ptr_infolist->prev_infolist);
         log_printf ("  next_infolist. . . . . : 0x%lx", ptr_infolist->next_infolist);
 
@@ -746,6 +749,7 @@ infolist_print_log ()
         {
             log_printf ("");
             log_printf ("    [item (addr:0x%lx)]", ptr_item);
+            log_printf ("      infolist . . . . . . . : 0x%lx", ptr_item->infolist);
             log_printf ("      vars . . . . . . . . . : 0x%lx", ptr_item->vars);
             log_printf ("      last_var . . . . . . . : 0x%lx", ptr_item->last_var);
             log_printf ("      prev_item. . . . . . . : 0x%lx", ptr_item->prev_item);
@@ -23,6 +23,11 @@
 #include <time.h>
 
 struct t_weechat_plugin;
+struct t_hashtable;
+
+/* size of first memory block in an infolist (doubled for next blocks) */
+#define INFOLIST_ARENA_BLOCK_SIZE     4096
+#define INFOLIST_ARENA_BLOCK_SIZE_MAX (1024 * 1024)
 
 /* list structures */
 
@@ -45,8 +50,16 @@ struct t_infolist_var
     struct t_infolist_var *next_var;   /* link to next variable             */
 };
 
+struct t_infolist_arena
+{
+    struct t_infolist_arena *next_arena; /* link to next (older) block      */
+    size_t size;                       /* size of data in this block        */
+    size_t used;                       /* bytes already used in block       */
+};
+
 struct t_infolist_item
 {
+    struct t_infolist *infolist;       /* infolist containing this item     */
     struct t_infolist_var *vars;       /* item variables                    */
     struct t_infolist_var *last_var;   /* last variable                     */
     char *fields;                      /* fields list (NULL if never asked) */
@@ -61,6 +74,8 @@ struct t_infolist
     struct t_infolist_item *items;     /* link to items                     */
     struct t_infolist_item *last_item; /* last variable                     */
     struct t_infolist_item *ptr_item;  /* pointer to current item           */
+    struct t_infolist_arena *arena;    /* memory blocks for items/variables */
+    struct t_hashtable *names;         /* interned names of variables       */
     struct t_infolist *prev_infolist;  /* link to previous list             */
     struct t_infolist *next_infolist;  /* link to next list                 */
 };
@@ -73,8 +88,17 @@ extern struct t_infolist *last_weechat_infolist;
 /* list functions */
 
 extern struct t_infolist *infolist_new (struct t_weechat_plugin *plugin);
+extern void *infolist_arena_alloc (struct t_infolist *infolist, size_t size);
+extern char *infolist_arena_strdup (struct t_infolist *infolist,
+                                    const char *string);
+extern char *infolist_intern_name (struct t_infolist *infolist,
+                                   const char *name);
 extern int infolist_valid (struct t_infolist *infolist);
 extern struct t_infolist_item *infolist_new_item (struct t_infolist *infolist);
+extern struct t_infolist_var *infolist_new_var (struct t_infolist_item *item,
+                                                const char *name,
+                                                enum t_infolist_type type,
+                                                void *value, int size);
 extern struct t_infolist_var *infolist_new_var_integer (struct t_infolist_item *item,
                                                         const char *name,
                                                         int value);
@@ -46,6 +46,9 @@
 #include <netdb.h>
 #include <resolv.h>
 #include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <pthread.h>
 #include <gcrypt.h>
 #include <sys/time.h>
 #if defined(__OpenBSD__)
@@ -63,15 +66,43 @@
 #include "wee-config.h"
 #include "wee-proxy.h"
 #include "wee-string.h"
+#include "wee-util.h"
 #include "../plugins/plugin.h"
 
 
+/* delay (in ms) before starting connection to next address (happy eyeballs) */
+#define NETWORK_CONNECT_ATTEMPT_DELAY 250
+
+/* entry in DNS cache */
+
+struct t_network_dns_cache
+{
+    char *key;                         /* "flags/family/node/service"       */
+    struct addrinfo *res;              /* addresses (copy)                  */
+    time_t expire;                     /* date/time of expiration           */
+    struct t_network_dns_cache *next_entry; /* link to next entry           */
+};
+
 int network_init_gnutls_ok = 0;
 
 #ifdef HAVE_GNUTLS
 gnutls_certificate_credentials_t gnutls_xcred; /* GnuTLS client credentials */
 #endif /* HAVE_GNUTLS */
 
+/*
+ * worker threads used to connect: the mutex protects the queue of jobs,
+ * the DNS cache and the fields "sock", "cancelled" and "done" of jobs
+ */
+pthread_mutex_t network_mutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t network_cond = PTHREAD_COND_INITIALIZER;
+pthread_t *network_threads = NULL;     /* worker threads (to join them)     */
+int network_num_threads = 0;           /* number of worker threads          */
+int network_num_threads_idle = 0;      /* number of threads waiting for job */
+int network_threads_stop = 0;          /* 1 if threads must stop            */
+struct t_network_connect_job *network_jobs = NULL; /* queue of jobs         */
+struct t_network_connect_job *last_network_job = NULL; /* last job in queue */
+struct t_network_dns_cache *network_dns_cache = NULL; /* DNS cache          */
+
 
 /*
  * Initializes gcrypt.
@@ -165,13 +196,16 @@ network_end ()
 #endif /* HAVE_GNUTLS */
         network_init_gnutls_ok = 0;
     }
+
+    network_connect_threads_end ();
+    network_dns_cache_free_all ();
 }
 
 /*
  * Sends data on a socket with retry.
  *
  * WARNING: this function is blocking, it must be called only in a forked
- * process.
+ * process or in a worker thread.
  *
  * Returns number of bytes sent, -1 if error.
  */
@@ -203,7 +237,7 @@ network_send_with_retry (int sock, const void *buffer, int length, int flags)
  * Receives data on a socket with retry.
  *
  * WARNING: this function is blocking, it must be called only in a forked
- * process.
+ * process or in a worker thread.
  *
  * Returns number of bytes received, -1 if error.
  */
@@ -231,11 +265,312 @@ network_recv_with_retry (int sock, void *buffer, int length, int flags)
     return total_recv;
 }
 
+/*
+ * Duplicates a list of addresses (returned by getaddrinfo).
+ *
+ * Note: result must be freed by function network_addrinfo_free (and not
+ * freeaddrinfo).
+ *
+ * Returns pointer to first address of the new list, NULL if error.
+ */
+
+struct addrinfo *
+network_addrinfo_dup (const struct addrinfo *res)
+{
+    struct addrinfo *new_res, *last_res, *new_addr;
+
+    new_res = NULL;
+    last_res = NULL;
+
+    for (; res; res = res->ai_next)
+    {
+        new_addr = malloc (sizeof (*new_addr) + res->ai_addrlen);
+        if (!new_addr)
+        {
+            network_addrinfo_free (new_res);
+            return NULL;
+        }
+        memcpy (new_addr, res, sizeof (*new_addr));
+        new_addr->ai_addr = (struct sockaddr *)(new_addr + 1);
+        memcpy (new_addr->ai_addr, res->ai_addr, res->ai_addrlen);
+        new_addr->ai_canonname = (res->ai_canonname) ?
+            strdup (res->ai_canonname) : NULL;
+        new_addr->ai_next = NULL;
+        if (last_res)
+            last_res->ai_next = new_addr;
+        else
+            new_res = new_addr;
+        last_res = new_addr;
+    }
+
+    return new_res;
+}
+
+/*
+ * Frees a list of addresses returned by network_addrinfo_dup.
+ */
+
+void
+network_addrinfo_free (struct addrinfo *res)
+{
+    struct addrinfo *next_res;
+
+    while (res)
+    {
+        next_res = res->ai_next;
+        if (res->ai_canonname)
+            free (res->ai_canonname);
+        free (res);
+        res = next_res;
+    }
+}
+
+/*
+ * Frees an entry of DNS cache.
+ */
+
+void
+network_dns_cache_free (struct t_network_dns_cache *entry)
+{
+    if (!entry)
+        return;
+
+    if (entry->key)
+        free (entry->key);
+    network_addrinfo_free (entry->res);
+    free (entry);
+}
+
+/*
+ * Frees all entries of DNS cache.
+ */
+
+void
+network_dns_cache_free_all ()
+{
+    struct t_network_dns_cache *ptr_entry, *next_entry;
+
+    pthread_mutex_lock (&network_mutex);
+    ptr_entry = network_dns_cache;
+    network_dns_cache = NULL;
+    pthread_mutex_unlock (&network_mutex);
+
+    while (ptr_entry)
+    {
+        next_entry = ptr_entry->next_entry;
+        network_dns_cache_free (ptr_entry);
+        ptr_entry = next_entry;
+    }
+}
+
+/*
+ * Searches addresses in DNS cache and removes expired entries.
+ *
+ * Note: the mutex "network_mutex" must be locked by caller.
+ *
+ * Returns pointer to entry found, NULL if not found.
+ */
+
+struct t_network_dns_cache *
+network_dns_cache_search (const char *key)
+{
+    struct t_network_dns_cache *ptr_entry, *prev_entry, *next_entry;
+    struct t_network_dns_cache *entry_found;
+    time_t now;
+
+    now = time (NULL);
+    entry_found = NULL;
+    prev_entry = NULL;
+    ptr_entry = network_dns_cache;
+    while (ptr_entry)
+    {
+        next_entry = ptr_entry->next_entry;
+        if (ptr_entry->expire <= now)
+        {
+            if (prev_entry)
+                prev_entry->next_entry = next_entry;
+            else
+                network_dns_cache = next_entry;
+            network_dns_cache_free (ptr_entry);
+        }
+        else
+        {
+            if (!entry_found && (strcmp (ptr_entry->key, key) == 0))
+                entry_found = ptr_entry;
+            prev_entry = ptr_entry;
+        }
+        ptr_entry = next_entry;
+    }
+
+    return entry_found;
+}
+
+/*
+ * Gets addresses for a node/service (like getaddrinfo), using the DNS cache
+ * if cache_ttl > 0: the resolver is called only once per node/service during
+ * cache_ttl seconds.
+ *
+ * Note: result must be freed by function network_addrinfo_free (and not
+ * freeaddrinfo).
+ *
+ * WARNING: this function is blocking, it must be called only in a forked
+ * process or in a worker thread.
+ *
+ * Returns 0 if OK, error code of getaddrinfo if error.
+ */
+
+int
+network_getaddrinfo (const char *node, const char *service,
+                     const struct addrinfo *hints, int cache_ttl,
+                     struct addrinfo **res)
+{
+    struct t_network_dns_cache *ptr_entry, *new_entry;
+    struct addrinfo *res_resolver;
+    char *key;
+    int rc, length;
+
+    *res = NULL;
+    key = NULL;
+
+    if (cache_ttl > 0)
+    {
+        length = 64 + strlen (node) + 1 + strlen (service) + 1;
+        key = malloc (length);
+        if (key)
+        {
+            snprintf (key, length, "%d/%d/%s/%s",
+                      hints->ai_flags, hints->ai_family, node, service);
+            pthread_mutex_lock (&network_mutex);
+            ptr_entry = network_dns_cache_search (key);
+            if (ptr_entry)
+                *res = network_addrinfo_dup (ptr_entry->res);
+            pthread_mutex_unlock (&network_mutex);
+            if (*res)
+            {
+                free (key);
+                return 0;
+            }
+        }
+    }
+
+    res_init ();
+    res_resolver = NULL;
+    rc = getaddrinfo (node, service, hints, &res_resolver);
+    if (rc == 0)
+    {
+        *res = network_addrinfo_dup (res_resolver);
+        if (!*res)
+            rc = EAI_MEMORY;
+        freeaddrinfo (res_resolver);
+    }
+
+    if ((rc == 0) && key)
+    {
+        new_entry = malloc (sizeof (*new_entry));
+        if (new_entry)
+        {
+            new_entry->key = key;
+            key = NULL;
+            new_entry->res = network_addrinfo_dup (*res);
+            new_entry->expire = time (NULL) + cache_ttl;
+            pthread_mutex_lock (&network_mutex);
+            /* replace entry added by another thread (if any) */
+            ptr_entry = network_dns_cache_search (new_entry->key);
+            if (ptr_entry)
+                ptr_entry->expire = 0;
+            new_entry->next_entry = network_dns_cache;
+            network_dns_cache = new_entry;
+            pthread_mutex_unlock (&network_mutex);
+        }
+    }
+
+    if (key)
+        free (key);
+
+    return rc;
+}
+
+/*
+ * Creates proxy settings with the options of a proxy, evaluating username
+ * and password.
+ *
+ * This function must be called in main thread (the settings can then be used
+ * in a forked process or in a worker thread).
+ *
+ * Returns pointer to proxy settings, NULL if proxy is not found or error.
+ */
+
+struct t_network_proxy *
+network_proxy_new (const char *proxy)
+{
+    struct t_proxy *ptr_proxy;
+    struct t_network_proxy *new_proxy;
+
+    ptr_proxy = (proxy) ? proxy_search (proxy) : NULL;
+    if (!ptr_proxy)
+        return NULL;
+
+    new_proxy = malloc (sizeof (*new_proxy));
+    if (!new_proxy)
+        return NULL;
+
+    new_proxy->type = CONFIG_INTEGER(ptr_proxy->options[PROXY_OPTION_TYPE]);
+    new_proxy->ipv6 = CONFIG_BOOLEAN(ptr_proxy->options[PROXY_OPTION_IPV6]);
+    new_proxy->address = strdup (
+        CONFIG_STRING(ptr_proxy->options[PROXY_OPTION_ADDRESS]));
+    new_proxy->port = CONFIG_INTEGER(ptr_proxy->options[PROXY_OPTION_PORT]);
+    new_proxy->username = NULL;
+    new_proxy->password = NULL;
+    if ((new_proxy->type == PROXY_TYPE_SOCKS4)
+        || (CONFIG_STRING(ptr_proxy->options[PROXY_OPTION_USERNAME])
+            && CONFIG_STRING(ptr_proxy->options[PROXY_OPTION_USERNAME])[0]))
+    {
+        new_proxy->username = eval_expression (
+            CONFIG_STRING(ptr_proxy->options[PROXY_OPTION_USERNAME]),
+            NULL, NULL, NULL);
+        new_proxy->password = eval_expression (
+            CONFIG_STRING(ptr_proxy->options[PROXY_OPTION_PASSWORD]),
+            NULL, NULL, NULL);
+        if (!new_proxy->username || !new_proxy->password)
+        {
+            network_proxy_free (new_proxy);
+            return NULL;
+        }
+    }
+
+    if (!new_proxy->address)
+    {
+        network_proxy_free (new_proxy);
+        return NULL;
+    }
+
+    return new_proxy;
+}
+
+/*
+ * Frees proxy settings.
+ */
+
+void
+network_proxy_free (struct t_network_proxy *proxy)
+{
+    if (!proxy)
+        return;
+
+    if (proxy->address)
+        free (proxy->address);
+    if (proxy->username)
+        free (proxy->username);
+    if (proxy->password)
+        free (proxy->password);
+    free (proxy);
+}
+
 /*
  * Establishes a connection and authenticates with a HTTP proxy.
  *
  * WARNING: this function is blocking, it must be called only in a forked
- * process.
+ * process or in a worker thread.
  *
  * Returns:
  *   1: OK
@@ -243,30 +578,17 @@ network_recv_with_retry (int sock, void *buffer, int length, int flags)
  */
 
 int
-network_pass_httpproxy (struct t_proxy *proxy, int sock, const char *address,
-                        int port)
+network_pass_httpproxy (struct t_network_proxy *proxy, int sock,
+                        const char *address, int port)
 {
-    char buffer[256], authbuf[128], authbuf_base64[512], *username, *password;
+    char buffer[256], authbuf[128], authbuf_base64[512];
     int length;
 
-    if (CONFIG_STRING(proxy->options[PROXY_OPTION_USERNAME])
-        && CONFIG_STRING(proxy->options[PROXY_OPTION_USERNAME])[0])
+    if (proxy->username)
     {
         /* authentication */
-        username = eval_expression (CONFIG_STRING(proxy->options[PROXY_OPTION_USERNAME]),
-                                    NULL, NULL, NULL);
-        if (!username)
-            return 0;
-        password = eval_expression (CONFIG_STRING(proxy->options[PROXY_OPTION_PASSWORD]),
-                                    NULL, NULL, NULL);
-        if (!password)
-        {
-            free (username);
-            return 0;
-        }
-        snprintf (authbuf, sizeof (authbuf), "%s:%s", username, password);
-        free (username);
-        free (password);
+        snprintf (authbuf, sizeof (authbuf),
+                  "%s:%s", proxy->username, proxy->password);
         if (string_base64_encode (authbuf, strlen (authbuf), authbuf_base64) < 0)
             return 0;
         length = snprintf (buffer, sizeof (buffer),
@@ -348,7 +670,7 @@ network_resolve (const char *hostname, char *ip, int *version)
  * The socks4 protocol is explained here: https://en.wikipedia.org/wiki/SOCKS
  *
  * WARNING: this function is blocking, it must be called only in a forked
- * process.
+ * process or in a worker thread.
  *
  * Returns:
  *   1: OK
@@ -356,27 +678,24 @@ network_resolve (const char *hostname, char *ip, int *version)
  */
 
 int
-network_pass_socks4proxy (struct t_proxy *proxy, int sock, const char *address,
-                          int port)
+network_pass_socks4proxy (struct t_network_proxy *proxy, int sock,
+                          const char *address, int port)
 {
     struct t_network_socks4 socks4;
     unsigned char buffer[24];
-    char ip_addr[NI_MAXHOST], *username;
+    char ip_addr[NI_MAXHOST];
     int length;
 
-    username = eval_expression (CONFIG_STRING(proxy->options[PROXY_OPTION_USERNAME]),
-                                NULL, NULL, NULL);
-    if (!username)
+    if (!proxy->username)
         return 0;
 
+    memset (&socks4, 0, sizeof (socks4));
     socks4.version = 4;
     socks4.method = 1;
     socks4.port = htons (port);
     network_resolve (address, ip_addr, NULL);
     socks4.address = inet_addr (ip_addr);
-    strncpy (socks4.user, username, sizeof (socks4.user) - 1);
-
-    free (username);
+    strncpy (socks4.user, proxy->username, sizeof (socks4.user) - 1);
 
     length = 8 + strlen (socks4.user) + 1;
     if (network_send_with_retry (sock, (char *) &socks4, length, 0) != length)
@@ -400,7 +719,7 @@ network_pass_socks4proxy (struct t_proxy *proxy, int sock, const char *address,
  * The socks5 authentication with username/pass is explained in RFC 1929.
  *
  * WARNING: this function is blocking, it must be called only in a forked
- * process.
+ * process or in a worker thread.
  *
  * Returns:
  *   1: OK
@@ -408,20 +727,18 @@ network_pass_socks4proxy (struct t_proxy *proxy, int sock, const char *address,
  */
 
 int
-network_pass_socks5proxy (struct t_proxy *proxy, int sock, const char *address,
-                          int port)
+network_pass_socks5proxy (struct t_network_proxy *proxy, int sock,
+                          const char *address, int port)
 {
     struct t_network_socks5 socks5;
     unsigned char buffer[288];
     int username_len, password_len, addr_len, addr_buffer_len;
     unsigned char *addr_buffer;
-    char *username, *password;
 
     socks5.version = 5;
     socks5.nmethods = 1;
 
-    if (CONFIG_STRING(proxy->options[PROXY_OPTION_USERNAME])
-        && CONFIG_STRING(proxy->options[PROXY_OPTION_USERNAME])[0])
+    if (proxy->username)
         socks5.method = 2; /* with authentication */
     else
         socks5.method = 0; /* without authentication */
@@ -433,8 +750,7 @@ network_pass_socks5proxy (struct t_proxy *proxy, int sock, const char *address,
     if (network_recv_with_retry (sock, buffer, 2, 0) < 2)
         return 0;
 
-    if (CONFIG_STRING(proxy->options[PROXY_OPTION_USERNAME])
-        && CONFIG_STRING(proxy->options[PROXY_OPTION_USERNAME])[0])
+    if (proxy->username)
     {
         /*
          * with authentication
@@ -447,29 +763,15 @@ network_pass_socks5proxy (struct t_proxy *proxy, int sock, const char *address,
             return 0;
 
         /* authentication as in RFC 1929 */
-        username = eval_expression (CONFIG_STRING(proxy->options[PROXY_OPTION_USERNAME]),
-                                    NULL, NULL, NULL);
-        if (!username)
-            return 0;
-        password = eval_expression (CONFIG_STRING(proxy->options[PROXY_OPTION_PASSWORD]),
-                                    NULL, NULL, NULL);
-        if (!password)
-        {
-            free (username);
-            return 0;
-        }
-        username_len = strlen (username);
-        password_len = strlen (password);
+        username_len = strlen (proxy->username);
+        password_len = strlen (proxy->password);
 
         /* make username/password buffer */
         buffer[0] = 1;
         buffer[1] = (unsigned char) username_len;
-        memcpy (buffer + 2, username, username_len);
+        memcpy (buffer + 2, proxy->username, username_len);
         buffer[2 + username_len] = (unsigned char) password_len;
-        memcpy (buffer + 3 + username_len, password, password_len);
-
-        free (username);
-        free (password);
+        memcpy (buffer + 3 + username_len, proxy->password, password_len);
 
         if (network_send_with_retry (sock, buffer, 3 + username_len + password_len, 0) < 3 + username_len + password_len)
             return 0;
@@ -564,6 +866,38 @@ network_pass_socks5proxy (struct t_proxy *proxy, int sock, const char *address,
     return 1;
 }
 
+/*
+ * Establishes a connection and authenticates with a proxy (using proxy
+ * settings).
+ *
+ * WARNING: this function is blocking, it must be called only in a forked
+ * process or in a worker thread.
+ *
+ * Returns:
+ *   1: OK
+ *   0: error
+ */
+
+int
+network_pass_proxy_settings (struct t_network_proxy *proxy, int sock,
+                             const char *address, int port)
+{
+    if (!proxy)
+        return 0;
+
+    switch (proxy->type)
+    {
+        case PROXY_TYPE_HTTP:
+            return network_pass_httpproxy (proxy, sock, address, port);
+        case PROXY_TYPE_SOCKS4:
+            return network_pass_socks4proxy (proxy, sock, address, port);
+        case PROXY_TYPE_SOCKS5:
+            return network_pass_socks5proxy (proxy, sock, address, port);
+    }
+
+    return 0;
+}
+
 /*
  * Establishes a connection and authenticates with a proxy.
  *
@@ -578,27 +912,17 @@ network_pass_socks5proxy (struct t_proxy *proxy, int sock, const char *address,
 int
 network_pass_proxy (const char *proxy, int sock, const char *address, int port)
 {
+    struct t_network_proxy *ptr_proxy;
     int rc;
-    struct t_proxy *ptr_proxy;
 
-    rc = 0;
+    ptr_proxy = network_proxy_new (proxy);
+    if (!ptr_proxy)
+        return 0;
+
+    rc = network_pass_proxy_settings (ptr_proxy, sock, address, port);
+
+    network_proxy_free (ptr_proxy);
 
-    ptr_proxy = proxy_search (proxy);
-    if (ptr_proxy)
-    {
-        switch (CONFIG_INTEGER(ptr_proxy->options[PROXY_OPTION_TYPE]))
-        {
-            case PROXY_TYPE_HTTP:
-                rc = network_pass_httpproxy (ptr_proxy, sock, address, port);
-                break;
-            case PROXY_TYPE_SOCKS4:
-                rc = network_pass_socks4proxy (ptr_proxy, sock, address, port);
-                break;
-            case PROXY_TYPE_SOCKS5:
-                rc = network_pass_socks5proxy (ptr_proxy, sock, address, port);
-                break;
-        }
-    }
     return rc;
 }
 
@@ -744,135 +1068,592 @@ error:
 }
 
 /*
- * Connects to peer in a child process.
+ * Creates a job to connect (in a forked process or a worker thread), using
+ * data of a connect hook.
+ *
+ * This function must be called in main thread: all data needed is copied
+ * in the job, so that hook and options are never used by the worker thread.
+ *
+ * Returns pointer to new job, NULL if error.
+ */
+
+struct t_network_connect_job *
+network_connect_job_new (struct t_hook *hook_connect, int thread)
+{
+    struct t_network_connect_job *new_job;
+
+    new_job = malloc (sizeof (*new_job));
+    if (!new_job)
+        return NULL;
+
+    new_job->address = strdup (HOOK_CONNECT(hook_connect, address));
+    new_job->port = HOOK_CONNECT(hook_connect, port);
+    new_job->ipv6 = HOOK_CONNECT(hook_connect, ipv6);
+    new_job->retry = HOOK_CONNECT(hook_connect, retry);
+    new_job->local_hostname = (HOOK_CONNECT(hook_connect, local_hostname)) ?
+        strdup (HOOK_CONNECT(hook_connect, local_hostname)) : NULL;
+    new_job->proxy_error = 0;
+    new_job->proxy = NULL;
+    if (HOOK_CONNECT(hook_connect, proxy)
+        && HOOK_CONNECT(hook_connect, proxy)[0])
+    {
+        new_job->proxy = network_proxy_new (HOOK_CONNECT(hook_connect, proxy));
+        if (!new_job->proxy)
+            new_job->proxy_error = 1;
+    }
+    new_job->timeout = CONFIG_INTEGER(config_network_connection_timeout);
+    /* the DNS cache is shared by threads only (useless in a child process) */
+    new_job->dns_cache_ttl = (thread) ?
+        CONFIG_INTEGER(config_network_dns_cache_ttl) : 0;
+    new_job->sock_v4 = NULL;
+    new_job->sock_v6 = NULL;
+    new_job->write_fd = -1;
+    new_job->send_fd = -1;
+    new_job->thread = thread;
+    new_job->sock = -1;
+    new_job->cancelled = 0;
+    new_job->done = 0;
+    new_job->next_job = NULL;
+
+    if (!new_job->address)
+    {
+        network_connect_job_free (new_job);
+        return NULL;
+    }
+
+    return new_job;
+}
+
+/*
+ * Frees a job.
  */
 
 void
-network_connect_child (struct t_hook *hook_connect)
+network_connect_job_free (struct t_network_connect_job *job)
 {
-    struct t_proxy *ptr_proxy;
-    struct addrinfo hints, *res_local, *res_remote, *ptr_res, *ptr_loc;
-    char port[NI_MAXSERV + 1];
-    char status_str[2], *ptr_address, *status_with_string;
-    char remote_address[NI_MAXHOST + 1];
-    char status_without_string[1 + 5 + 1];
-    const char *error;
-    int rc, length, num_written;
-    int sock, set, flags, j;
-    struct msghdr msg;
-    struct cmsghdr *cmsg;
-    char msg_buf[CMSG_SPACE(sizeof (sock))];
-    struct iovec iov[1];
-    char iov_data[1] = { 0 };
-    /*
-     * indicates that something is wrong with whichever group of
-     * servers is being tried first after connecting, so start at
-     * a different offset to increase the chance of success
-     */
-    int retry, rand_num, i;
-    int num_groups, tmp_num_groups, num_hosts, tmp_host;
-    struct addrinfo **res_reorder;
-    int last_af;
-    struct timeval tv_time;
+    if (!job)
+        return;
 
-    res_local = NULL;
-    res_remote = NULL;
-    res_reorder = NULL;
-    port[0] = '\0';
+    if (job->address)
+        free (job->address);
+    if (job->local_hostname)
+        free (job->local_hostname);
+    network_proxy_free (job->proxy);
+    if (job->sock >= 0)
+        close (job->sock);
+    free (job);
+}
 
-    status_str[1] = '\0';
-    status_with_string = NULL;
+/*
+ * Gets the socket connected by a worker thread (the socket is then owned by
+ * the caller).
+ *
+ * Returns the socket, -1 if not connected.
+ */
 
-    ptr_address = NULL;
+int
+network_connect_job_get_sock (struct t_network_connect_job *job)
+{
+    int sock;
 
-    gettimeofday (&tv_time, NULL);
-    srand ((tv_time.tv_sec * tv_time.tv_usec) ^ getpid ());
+    if (!job)
+        return -1;
 
-    ptr_proxy = NULL;
-    if (HOOK_CONNECT(hook_connect, proxy)
-        && HOOK_CONNECT(hook_connect, proxy)[0])
-    {
-        ptr_proxy = proxy_search (HOOK_CONNECT(hook_connect, proxy));
-        if (!ptr_proxy)
-        {
-            /* proxy not found */
-            snprintf (status_without_string, sizeof (status_without_string),
-                      "%c00000", '0' + WEECHAT_HOOK_CONNECT_PROXY_ERROR);
-            num_written = write (HOOK_CONNECT(hook_connect, child_write),
-                                 status_without_string, strlen (status_without_string));
-            (void) num_written;
-            goto end;
-        }
-    }
+    pthread_mutex_lock (&network_mutex);
+    sock = job->sock;
+    job->sock = -1;
+    pthread_mutex_unlock (&network_mutex);
 
-    /* get info about peer */
-    memset (&hints, 0, sizeof (hints));
-    hints.ai_socktype = SOCK_STREAM;
-#ifdef AI_ADDRCONFIG
-    hints.ai_flags = AI_ADDRCONFIG;
-#endif /* AI_ADDRCONFIG */
-    res_init ();
-    if (ptr_proxy)
-    {
-        hints.ai_family = (CONFIG_BOOLEAN(ptr_proxy->options[PROXY_OPTION_IPV6])) ?
-            AF_UNSPEC : AF_INET;
-        snprintf (port, sizeof (port), "%d", CONFIG_INTEGER(ptr_proxy->options[PROXY_OPTION_PORT]));
-        rc = getaddrinfo (CONFIG_STRING(ptr_proxy->options[PROXY_OPTION_ADDRESS]),
-                          port, &hints, &res_remote);
-    }
-    else
+    return sock;
+}
+
+/*
+ * Cancels a job running in a worker thread (called when the connect hook is
+ * removed): the job is freed now if the thread has finished, otherwise it
+ * will be freed by the thread.
+ */
+
+void
+network_connect_job_cancel (struct t_network_connect_job *job)
+{
+    int free_job;
+
+    if (!job)
+        return;
+
+    pthread_mutex_lock (&network_mutex);
+    if (job->sock >= 0)
     {
-        hints.ai_family = HOOK_CONNECT(hook_connect, ipv6) ? AF_UNSPEC : AF_INET;
-        snprintf (port, sizeof (port), "%d", HOOK_CONNECT(hook_connect, port));
-        rc = getaddrinfo (HOOK_CONNECT(hook_connect, address), port, &hints, &res_remote);
+        close (job->sock);
+        job->sock = -1;
     }
+    free_job = job->done;
+    job->cancelled = 1;
+    pthread_mutex_unlock (&network_mutex);
 
-    if (rc != 0)
-    {
-        /* address not found */
-        status_with_string = NULL;
-        error = gai_strerror (rc);
-        if (error)
-        {
-            length = 1 + 5 + strlen (error) + 1;
-            status_with_string = malloc (length);
-            if (status_with_string)
+    if (free_job)
+        network_connect_job_free (job);
+}
+
+/*
+ * Checks if a job has been cancelled.
+ *
+ * Returns:
+ *   1: job cancelled
+ *   0: job not cancelled
+ */
+
+int
+network_connect_job_is_cancelled (struct t_network_connect_job *job)
+{
+    int cancelled;
+
+    if (!job->thread)
+        return 0;
+
+    pthread_mutex_lock (&network_mutex);
+    cancelled = job->cancelled;
+    pthread_mutex_unlock (&network_mutex);
+
+    return cancelled;
+}
+
+/*
+ * Sends status of connection (with an optional string: IP address or error)
+ * to the main thread/process.
+ */
+
+void
+network_connect_child_send_status (struct t_network_connect_job *job,
+                                   int status, const char *string)
+{
+    char *status_with_string, status_without_string[1 + 5 + 1];
+    int length, num_written;
+
+    status_with_string = NULL;
+    if (string)
+    {
+        length = 1 + 5 + strlen (string) + 1;
+        status_with_string = malloc (length);
+        if (status_with_string)
+        {
+            snprintf (status_with_string, length, "%c%05d%s",
+                      '0' + status, (int)strlen (string), string);
+        }
+    }
+
+    if (status_with_string)
+    {
+        num_written = write (job->write_fd,
+                             status_with_string, strlen (status_with_string));
+        free (status_with_string);
+    }
+    else
+    {
+        snprintf (status_without_string, sizeof (status_without_string),
+                  "%c00000", '0' + status);
+        num_written = write (job->write_fd,
+                             status_without_string,
+                             strlen (status_without_string));
+    }
+    (void) num_written;
+}
+
+/*
+ * Sends the connected socket to the main thread/process.
+ */
+
+void
+network_connect_child_send_sock (struct t_network_connect_job *job, int sock)
+{
+    int num_written;
+    struct msghdr msg;
+    struct cmsghdr *cmsg;
+    char msg_buf[CMSG_SPACE(sizeof (sock))];
+    struct iovec iov[1];
+    char iov_data[1] = { 0 };
+
+    if (job->thread)
+    {
+        /* same process: just give the socket to the job */
+        pthread_mutex_lock (&network_mutex);
+        if (job->cancelled)
+            close (sock);
+        else
+            job->sock = sock;
+        pthread_mutex_unlock (&network_mutex);
+    }
+    else if (job->send_fd >= 0)
+    {
+        memset (&msg, 0, sizeof (msg));
+        msg.msg_control = msg_buf;
+        msg.msg_controllen = sizeof (msg_buf);
+
+        /*
+         * send 1 byte of data
+         * (not required on Linux, required by BSD/macOS)
+         */
+        memset (iov, 0, sizeof (iov));
+        iov[0].iov_base = iov_data;
+        iov[0].iov_len = 1;
+        msg.msg_iov = iov;
+        msg.msg_iovlen = 1;
+
+        cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof (sock));
+        memcpy (CMSG_DATA(cmsg), &sock, sizeof (sock));
+        msg.msg_controllen = cmsg->cmsg_len;
+        num_written = sendmsg (job->send_fd, &msg, 0);
+        (void) num_written;
+    }
+    else
+    {
+        num_written = write (job->write_fd, &sock, sizeof (sock));
+        (void) num_written;
+    }
+}
+
+/*
+ * Starts connection to an address: creates socket, binds local address (if
+ * needed) and calls connect (non-blocking).
+ *
+ * Returns:
+ *   1: connected
+ *   0: connection in progress (*sock is set)
+ *  -1: error (*status is set, except if no pre-created socket is available)
+ */
+
+int
+network_connect_child_start (struct t_network_connect_job *job,
+                             struct addrinfo *res,
+                             struct addrinfo *res_local,
+                             int *sock, int *status)
+{
+    struct addrinfo *ptr_loc;
+    int rc, set, flags, j;
+
+    *sock = -1;
+
+    if (!job->sock_v4)
+    {
+        /* create a socket */
+        *sock = socket (res->ai_family, res->ai_socktype, res->ai_protocol);
+    }
+    else
+    {
+        /* use pre-created socket pool */
+        for (j = 0; j < HOOK_CONNECT_MAX_SOCKETS; j++)
+        {
+            if (res->ai_family == AF_INET)
+            {
+                *sock = job->sock_v4[j];
+                if (*sock != -1)
+                {
+                    job->sock_v4[j] = -1;
+                    break;
+                }
+            }
+            else if (res->ai_family == AF_INET6)
             {
-                snprintf (status_with_string, length, "%c%05d%s",
-                          '0' + WEECHAT_HOOK_CONNECT_ADDRESS_NOT_FOUND,
-                          (int)strlen (error), error);
+                *sock = job->sock_v6[j];
+                if (*sock != -1)
+                {
+                    job->sock_v6[j] = -1;
+                    break;
+                }
             }
         }
-        if (status_with_string)
+        if (*sock < 0)
+            return -1;
+    }
+    if (*sock < 0)
+    {
+        *status = WEECHAT_HOOK_CONNECT_SOCKET_ERROR;
+        return -1;
+    }
+
+    /* set SO_REUSEADDR option for socket */
+    set = 1;
+    setsockopt (*sock, SOL_SOCKET, SO_REUSEADDR, (void *) &set, sizeof (set));
+
+    /* set SO_KEEPALIVE option for socket */
+    set = 1;
+    setsockopt (*sock, SOL_SOCKET, SO_KEEPALIVE, (void *) &set, sizeof (set));
+
+    /* set flag O_NONBLOCK on socket */
+    flags = fcntl (*sock, F_GETFL);
+    if (flags == -1)
+        flags = 0;
+    fcntl (*sock, F_SETFL, flags | O_NONBLOCK);
+
+    if (res_local)
+    {
+        rc = -1;
+
+        /* bind local hostname/IP if asked by user */
+        for (ptr_loc = res_local; ptr_loc; ptr_loc = ptr_loc->ai_next)
         {
-            num_written = write (HOOK_CONNECT(hook_connect, child_write),
-                                 status_with_string, strlen (status_with_string));
+            if (ptr_loc->ai_family != res->ai_family)
+                continue;
+
+            rc = bind (*sock, ptr_loc->ai_addr, ptr_loc->ai_addrlen);
+            if (rc == 0)
+                break;
         }
-        else
+
+        if (rc < 0)
         {
-            snprintf (status_without_string, sizeof (status_without_string),
-                      "%c00000", '0' + WEECHAT_HOOK_CONNECT_ADDRESS_NOT_FOUND);
-            num_written = write (HOOK_CONNECT(hook_connect, child_write),
-                                 status_without_string, strlen (status_without_string));
+            *status = WEECHAT_HOOK_CONNECT_LOCAL_HOSTNAME_ERROR;
+            close (*sock);
+            *sock = -1;
+            return -1;
         }
-        (void) num_written;
+    }
+
+    /* connect to peer */
+    if (connect (*sock, res->ai_addr, res->ai_addrlen) == 0)
+        return 1;
+
+    if (errno == EINPROGRESS)
+        return 0;
+
+    *status = WEECHAT_HOOK_CONNECT_CONNECTION_REFUSED;
+    close (*sock);
+    *sock = -1;
+    return -1;
+}
+
+/*
+ * Connects to one of the addresses: a new connection is started every
+ * 250ms (or immediately if previous attempt failed) until one is
+ * successful ("happy eyeballs", RFC 8305).
+ *
+ * Returns connected socket, -1 if error (*status is set).
+ */
+
+int
+network_connect_child_race (struct t_network_connect_job *job,
+                            struct addrinfo **res_list, int num_res,
+                            struct addrinfo *res_local,
+                            int *status, struct addrinfo **res_connected)
+{
+    struct pollfd *poll_fds;
+    struct addrinfo **poll_res;
+    struct timeval tv_start, tv_last_attempt, tv_now;
+    long long diff;
+    int num_active, next, i, sock, rc, value, timeout;
+    socklen_t len;
+
+    *res_connected = NULL;
+
+    poll_fds = malloc (num_res * sizeof (*poll_fds));
+    poll_res = malloc (num_res * sizeof (*poll_res));
+    if (!poll_fds || !poll_res)
+    {
+        *status = WEECHAT_HOOK_CONNECT_MEMORY_ERROR;
+        if (poll_fds)
+            free (poll_fds);
+        if (poll_res)
+            free (poll_res);
+        return -1;
+    }
+
+    gettimeofday (&tv_start, NULL);
+    tv_last_attempt = tv_start;
+    num_active = 0;
+    next = 0;
+    sock = -1;
+
+    while (1)
+    {
+        gettimeofday (&tv_now, NULL);
+
+        /* stop if the hook has been removed or after timeout */
+        if (network_connect_job_is_cancelled (job))
+            break;
+        if (util_timeval_diff (&tv_start, &tv_now) / 1000000 >= job->timeout)
+        {
+            *status = WEECHAT_HOOK_CONNECT_TIMEOUT;
+            break;
+        }
+
+        timeout = 1000;
+        if (next < num_res)
+        {
+            diff = (num_active > 0) ?
+                util_timeval_diff (&tv_last_attempt, &tv_now) / 1000 :
+                NETWORK_CONNECT_ATTEMPT_DELAY;
+            if (diff >= NETWORK_CONNECT_ATTEMPT_DELAY)
+            {
+                /* start connection to next address */
+                tv_last_attempt = tv_now;
+                rc = network_connect_child_start (job, res_list[next],
+                                                  res_local, &sock, status);
+                if (rc == 1)
+                {
+                    *res_connected = res_list[next];
+                    goto end;
+                }
+                if (rc == 0)
+                {
+                    poll_fds[num_active].fd = sock;
+                    poll_fds[num_active].events = POLLOUT;
+                    poll_res[num_active] = res_list[next];
+                    num_active++;
+                }
+                sock = -1;
+                next++;
+                continue;
+            }
+            timeout = NETWORK_CONNECT_ATTEMPT_DELAY - diff;
+        }
+        else if (num_active == 0)
+        {
+            /* all connections failed */
+            break;
+        }
+
+        /*
+         * for non-blocking sockets, the connect() may fail with EINPROGRESS,
+         * if this happens, we wait for writability on socket and check
+         * the option SO_ERROR, which is 0 if connect is OK (see man connect)
+         */
+        for (i = 0; i < num_active; i++)
+        {
+            poll_fds[i].revents = 0;
+        }
+        rc = poll (poll_fds, num_active, timeout);
+        if (rc < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            *status = WEECHAT_HOOK_CONNECT_CONNECTION_REFUSED;
+            break;
+        }
+        i = 0;
+        while (i < num_active)
+        {
+            if (poll_fds[i].revents)
+            {
+                len = sizeof (value);
+                if ((getsockopt (poll_fds[i].fd, SOL_SOCKET, SO_ERROR,
+                                 &value, &len) == 0)
+                    && (value == 0))
+                {
+                    sock = poll_fds[i].fd;
+                    *res_connected = poll_res[i];
+                    poll_fds[i] = poll_fds[num_active - 1];
+                    num_active--;
+                    goto end;
+                }
+                *status = WEECHAT_HOOK_CONNECT_CONNECTION_REFUSED;
+                close (poll_fds[i].fd);
+                poll_fds[i] = poll_fds[num_active - 1];
+                poll_res[i] = poll_res[num_active - 1];
+                num_active--;
+            }
+            else
+                i++;
+        }
+    }
+
+end:
+    /* close connections still in progress */
+    for (i = 0; i < num_active; i++)
+    {
+        close (poll_fds[i].fd);
+    }
+    free (poll_fds);
+    free (poll_res);
+
+    return sock;
+}
+
+/*
+ * Connects to peer in a child process or a worker thread.
+ */
+
+void
+network_connect_child (struct t_network_connect_job *job)
+{
+    struct addrinfo hints, *res_local, *res_remote, *ptr_res;
+    char port[NI_MAXSERV + 1];
+    char *ptr_address;
+    char remote_address[NI_MAXHOST + 1];
+    int status, rc, sock;
+    /*
+     * indicates that something is wrong with whichever group of
+     * servers is being tried first after connecting, so start at
+     * a different offset to increase the chance of success
+     */
+    int retry, rand_num, i, j, k;
+    int num_groups, tmp_num_groups, num_hosts, tmp_host;
+    struct addrinfo **res_reorder, **res_list;
+    int last_af;
+    unsigned int seed;
+    struct timeval tv_time;
+
+    res_local = NULL;
+    res_remote = NULL;
+    res_reorder = NULL;
+    res_list = NULL;
+    port[0] = '\0';
+
+    ptr_address = NULL;
+
+    gettimeofday (&tv_time, NULL);
+    seed = ((tv_time.tv_sec * tv_time.tv_usec) ^ getpid ())
+        + (unsigned int)((unsigned long)job & 0xFFFFFFFF);
+
+    if (job->proxy_error)
+    {
+        /* proxy not found */
+        network_connect_child_send_status (
+            job, WEECHAT_HOOK_CONNECT_PROXY_ERROR, NULL);
+        goto end;
+    }
+
+    /* get info about peer */
+    memset (&hints, 0, sizeof (hints));
+    hints.ai_socktype = SOCK_STREAM;
+#ifdef AI_ADDRCONFIG
+    hints.ai_flags = AI_ADDRCONFIG;
+#endif /* AI_ADDRCONFIG */
+    if (job->proxy)
+    {
+        hints.ai_family = (job->proxy->ipv6) ? AF_UNSPEC : AF_INET;
+        snprintf (port, sizeof (port), "%d", job->proxy->port);
+        rc = network_getaddrinfo (job->proxy->address, port, &hints,
+                                  job->dns_cache_ttl, &res_remote);
+    }
+    else
+    {
+        hints.ai_family = (job->ipv6) ? AF_UNSPEC : AF_INET;
+        snprintf (port, sizeof (port), "%d", job->port);
+        rc = network_getaddrinfo (job->address, port, &hints,
+                                  job->dns_cache_ttl, &res_remote);
+    }
+
+    if (rc != 0)
+    {
+        /* address not found */
+        network_connect_child_send_status (
+            job, WEECHAT_HOOK_CONNECT_ADDRESS_NOT_FOUND, gai_strerror (rc));
         goto end;
     }
 
     if (!res_remote)
     {
         /* address not found */
-        snprintf (status_without_string, sizeof (status_without_string),
-                  "%c00000", '0' + WEECHAT_HOOK_CONNECT_ADDRESS_NOT_FOUND);
-        num_written = write (HOOK_CONNECT(hook_connect, child_write),
-                             status_without_string, strlen (status_without_string));
-        (void) num_written;
+        network_connect_child_send_status (
+            job, WEECHAT_HOOK_CONNECT_ADDRESS_NOT_FOUND, NULL);
         goto end;
     }
 
     /* set local hostname/IP if asked by user */
-    if (HOOK_CONNECT(hook_connect, local_hostname)
-        && HOOK_CONNECT(hook_connect, local_hostname[0]))
+    if (job->local_hostname && job->local_hostname[0])
     {
         memset (&hints, 0, sizeof (hints));
         hints.ai_family = AF_UNSPEC;
@@ -880,48 +1661,21 @@ network_connect_child (struct t_hook *hook_connect)
 #ifdef AI_ADDRCONFIG
         hints.ai_flags = AI_ADDRCONFIG;
 #endif /* AI_ADDRCONFIG */
-        rc = getaddrinfo (HOOK_CONNECT(hook_connect, local_hostname),
-                          NULL, &hints, &res_local);
+        rc = getaddrinfo (job->local_hostname, NULL, &hints, &res_local);
         if (rc != 0)
         {
             /* address not found */
-            status_with_string = NULL;
-            error = gai_strerror (rc);
-            if (error)
-            {
-                length = 1 + 5 + strlen (error) + 1;
-                status_with_string = malloc (length);
-                if (status_with_string)
-                {
-                    snprintf (status_with_string, length, "%c%05d%s",
-                              '0' + WEECHAT_HOOK_CONNECT_LOCAL_HOSTNAME_ERROR,
-                              (int)strlen (error), error);
-                }
-            }
-            if (status_with_string)
-            {
-                num_written = write (HOOK_CONNECT(hook_connect, child_write),
-                                     status_with_string, strlen (status_with_string));
-            }
-            else
-            {
-                snprintf (status_without_string, sizeof (status_without_string),
-                          "%c00000", '0' + WEECHAT_HOOK_CONNECT_LOCAL_HOSTNAME_ERROR);
-                num_written = write (HOOK_CONNECT(hook_connect, child_write),
-                                     status_without_string, strlen (status_without_string));
-            }
-            (void) num_written;
+            network_connect_child_send_status (
+                job, WEECHAT_HOOK_CONNECT_LOCAL_HOSTNAME_ERROR,
+                gai_strerror (rc));
             goto end;
         }
 
         if (!res_local)
         {
             /* address not found */
-            snprintf (status_without_string, sizeof (status_without_string),
-                      "%c00000", '0' + WEECHAT_HOOK_CONNECT_LOCAL_HOSTNAME_ERROR);
-            num_written = write (HOOK_CONNECT(hook_connect, child_write),
-                                 status_without_string, strlen (status_without_string));
-            (void) num_written;
+            network_connect_child_send_status (
+                job, WEECHAT_HOOK_CONNECT_LOCAL_HOSTNAME_ERROR, NULL);
             goto end;
         }
     }
@@ -950,18 +1704,16 @@ network_connect_child (struct t_hook *hook_connect)
         num_groups++;
 
     res_reorder = malloc (sizeof (*res_reorder) * num_hosts);
-    if (!res_reorder)
+    res_list = malloc (sizeof (*res_list) * num_hosts);
+    if (!res_reorder || !res_list)
     {
-        snprintf (status_without_string, sizeof (status_without_string),
-                  "%c00000", '0' + WEECHAT_HOOK_CONNECT_MEMORY_ERROR);
-        num_written = write (HOOK_CONNECT(hook_connect, child_write),
-                             status_without_string, strlen (status_without_string));
-        (void) num_written;
+        network_connect_child_send_status (
+            job, WEECHAT_HOOK_CONNECT_MEMORY_ERROR, NULL);
         goto end;
     }
 
     /* reorder groups */
-    retry = HOOK_CONNECT(hook_connect, retry);
+    retry = job->retry;
     if (num_groups > 0)
     {
         retry %= num_groups;
@@ -985,7 +1737,7 @@ network_connect_child (struct t_hook *hook_connect)
             if (tmp_num_groups >= retry)
             {
                 /* shuffle while adding */
-                rand_num = tmp_host + (rand () % ((i + 1) - tmp_host));
+                rand_num = tmp_host + (rand_r (&seed) % ((i + 1) - tmp_host));
                 if (rand_num == i)
                     res_reorder[i++] = ptr_res;
                 else
@@ -1016,7 +1768,7 @@ network_connect_child (struct t_hook *hook_connect)
             if (tmp_num_groups < retry)
             {
                 /* shuffle while adding */
-                rand_num = tmp_host + (rand () % ((i + 1) - tmp_host));
+                rand_num = tmp_host + (rand_r (&seed) % ((i + 1) - tmp_host));
                 if (rand_num == i)
                     res_reorder[i++] = ptr_res;
                 else
@@ -1034,213 +1786,84 @@ network_connect_child (struct t_hook *hook_connect)
     else
     {
         /* no IP addresses found (all AF_UNSPEC) */
-        snprintf (status_without_string, sizeof (status_without_string),
-                  "%c00000", '0' + WEECHAT_HOOK_CONNECT_IP_ADDRESS_NOT_FOUND);
-        num_written = write (HOOK_CONNECT(hook_connect, child_write),
-                             status_without_string, strlen (status_without_string));
-        (void) num_written;
+        network_connect_child_send_status (
+            job, WEECHAT_HOOK_CONNECT_IP_ADDRESS_NOT_FOUND, NULL);
         goto end;
     }
 
-    status_str[0] = '0' + WEECHAT_HOOK_CONNECT_IP_ADDRESS_NOT_FOUND;
-
-    /* try all IP addresses found, stop when connection is OK */
-    sock = -1;
-    for (i = 0; i < num_hosts; i++)
+    /*
+     * interleave address families, starting with family of first address
+     * (for example: IPv6, IPv4, IPv6, IPv4, ...), so that a connection with
+     * the other family is tried quickly if the first one is not reachable
+     */
+    i = 0;
+    j = 0;
+    k = 0;
+    while (k < num_hosts)
     {
-        ptr_res = res_reorder[i];
-
-        if (hook_socketpair_ok)
+        while ((i < num_hosts)
+               && (res_reorder[i]->ai_family != res_reorder[0]->ai_family))
         {
-            /* create a socket */
-            sock = socket (ptr_res->ai_family,
-                           ptr_res->ai_socktype,
-                           ptr_res->ai_protocol);
+            i++;
         }
-        else
+        if (i < num_hosts)
+            res_list[k++] = res_reorder[i++];
+        while ((j < num_hosts)
+               && (res_reorder[j]->ai_family == res_reorder[0]->ai_family))
         {
-            /* use pre-created socket pool */
-            sock = -1;
-            for (j = 0; j < HOOK_CONNECT_MAX_SOCKETS; j++)
-            {
-                if (ptr_res->ai_family == AF_INET)
-                {
-                    sock = HOOK_CONNECT(hook_connect, sock_v4[j]);
-                    if (sock != -1)
-                    {
-                        HOOK_CONNECT(hook_connect, sock_v4[j]) = -1;
-                        break;
-                    }
-                }
-                else if (ptr_res->ai_family == AF_INET6)
-                {
-                    sock = HOOK_CONNECT(hook_connect, sock_v6[j]);
-                    if (sock != -1)
-                    {
-                        HOOK_CONNECT(hook_connect, sock_v6[j]) = -1;
-                        break;
-                    }
-                }
-            }
-            if (sock < 0)
-                continue;
-        }
-        if (sock < 0)
-        {
-            status_str[0] = '0' + WEECHAT_HOOK_CONNECT_SOCKET_ERROR;
-            continue;
-        }
-
-        /* set SO_REUSEADDR option for socket */
-        set = 1;
-        setsockopt (sock, SOL_SOCKET, SO_REUSEADDR, (void *) &set, sizeof (set));
-
-        /* set SO_KEEPALIVE option for socket */
-        set = 1;
-        setsockopt (sock, SOL_SOCKET, SO_KEEPALIVE, (void *) &set, sizeof (set));
-
-        /* set flag O_NONBLOCK on socket */
-        flags = fcntl (sock, F_GETFL);
-        if (flags == -1)
-            flags = 0;
-        fcntl (sock, F_SETFL, flags | O_NONBLOCK);
-
-        if (res_local)
-        {
-            rc = -1;
-
-            /* bind local hostname/IP if asked by user */
-            for (ptr_loc = res_local; ptr_loc; ptr_loc = ptr_loc->ai_next)
-            {
-                if (ptr_loc->ai_family != ptr_res->ai_family)
-                    continue;
-
-                rc = bind (sock, ptr_loc->ai_addr, ptr_loc->ai_addrlen);
-                if (rc < 0)
-                    continue;
-            }
-
-            if (rc < 0)
-            {
-                status_str[0] = '0' + WEECHAT_HOOK_CONNECT_LOCAL_HOSTNAME_ERROR;
-                close (sock);
-                sock = -1;
-                continue;
-            }
-        }
-
-        /* connect to peer */
-        if (network_connect (sock, ptr_res->ai_addr, ptr_res->ai_addrlen))
-        {
-            status_str[0] = '0' + WEECHAT_HOOK_CONNECT_OK;
-            rc = getnameinfo (ptr_res->ai_addr, ptr_res->ai_addrlen,
-                              remote_address, sizeof (remote_address),
-                              NULL, 0, NI_NUMERICHOST);
-            if (rc == 0)
-                ptr_address = remote_address;
-            break;
-        }
-        else
-        {
-            status_str[0] = '0' + WEECHAT_HOOK_CONNECT_CONNECTION_REFUSED;
-            close (sock);
-            sock = -1;
+            j++;
         }
+        if (j < num_hosts)
+            res_list[k++] = res_reorder[j++];
     }
 
-    HOOK_CONNECT(hook_connect, sock) = sock;
-
-    if (ptr_proxy && status_str[0] == '0' + WEECHAT_HOOK_CONNECT_OK)
+    /* try all IP addresses found, stop when connection is OK */
+    status = WEECHAT_HOOK_CONNECT_IP_ADDRESS_NOT_FOUND;
+    sock = network_connect_child_race (job, res_list, num_hosts, res_local,
+                                       &status, &ptr_res);
+    if (sock >= 0)
     {
-        if (!network_pass_proxy (HOOK_CONNECT(hook_connect, proxy),
-                                 HOOK_CONNECT(hook_connect, sock),
-                                 HOOK_CONNECT(hook_connect, address),
-                                 HOOK_CONNECT(hook_connect, port)))
+        status = WEECHAT_HOOK_CONNECT_OK;
+        rc = getnameinfo (ptr_res->ai_addr, ptr_res->ai_addrlen,
+                          remote_address, sizeof (remote_address),
+                          NULL, 0, NI_NUMERICHOST);
+        if (rc == 0)
+            ptr_address = remote_address;
+
+        if (job->proxy
+            && !network_pass_proxy_settings (job->proxy, sock,
+                                             job->address, job->port))
         {
             /* proxy fails to connect to peer */
-            status_str[0] = '0' + WEECHAT_HOOK_CONNECT_PROXY_ERROR;
+            status = WEECHAT_HOOK_CONNECT_PROXY_ERROR;
+            close (sock);
+            sock = -1;
         }
     }
 
-    if (status_str[0] == '0' + WEECHAT_HOOK_CONNECT_OK)
+    if (status == WEECHAT_HOOK_CONNECT_OK)
     {
-        status_with_string = NULL;
-        if (ptr_address)
-        {
-            length = strlen (status_str) + 5 + strlen (ptr_address) + 1;
-            status_with_string = malloc (length);
-            if (status_with_string)
-            {
-                snprintf (status_with_string, length, "%s%05d%s",
-                          status_str, (int)strlen (ptr_address), ptr_address);
-            }
-        }
-
-        if (status_with_string)
-        {
-            num_written = write (HOOK_CONNECT(hook_connect, child_write),
-                                 status_with_string, strlen (status_with_string));
-            (void) num_written;
-        }
-        else
-        {
-            snprintf (status_without_string, sizeof (status_without_string),
-                      "%s00000", status_str);
-            num_written = write (HOOK_CONNECT(hook_connect, child_write),
-                                 status_without_string, strlen (status_without_string));
-            (void) num_written;
-        }
-
-        /* send the socket to the parent process */
-        if (hook_socketpair_ok)
-        {
-            memset (&msg, 0, sizeof (msg));
-            msg.msg_control = msg_buf;
-            msg.msg_controllen = sizeof (msg_buf);
-
-            /*
-             * send 1 byte of data
-             * (not required on Linux, required by BSD/macOS)
-             */
-            memset (iov, 0, sizeof (iov));
-            iov[0].iov_base = iov_data;
-            iov[0].iov_len = 1;
-            msg.msg_iov = iov;
-            msg.msg_iovlen = 1;
-
-            cmsg = CMSG_FIRSTHDR(&msg);
-            cmsg->cmsg_level = SOL_SOCKET;
-            cmsg->cmsg_type = SCM_RIGHTS;
-            cmsg->cmsg_len = CMSG_LEN(sizeof (sock));
-            memcpy (CMSG_DATA(cmsg), &sock, sizeof (sock));
-            msg.msg_controllen = cmsg->cmsg_len;
-            num_written = sendmsg (HOOK_CONNECT(hook_connect, child_send), &msg, 0);
-            (void) num_written;
-        }
-        else
-        {
-            num_written = write (HOOK_CONNECT(hook_connect, child_write), &sock, sizeof (sock));
-            (void) num_written;
-        }
+        /* the socket must be given before the status in a thread */
+        if (job->thread)
+            network_connect_child_send_sock (job, sock);
+        network_connect_child_send_status (job, status, ptr_address);
+        if (!job->thread)
+            network_connect_child_send_sock (job, sock);
     }
     else
     {
-        snprintf (status_without_string, sizeof (status_without_string),
-                  "%s00000", status_str);
-        num_written = write (HOOK_CONNECT(hook_connect, child_write),
-                             status_without_string, strlen (status_without_string));
-        (void) num_written;
+        network_connect_child_send_status (job, status, NULL);
     }
 
 end:
-    if (status_with_string)
-        free (status_with_string);
     if (res_reorder)
         free (res_reorder);
+    if (res_list)
+        free (res_list);
     if (res_local)
         freeaddrinfo (res_local);
     if (res_remote)
-        freeaddrinfo (res_remote);
+        network_addrinfo_free (res_remote);
 }
 
 /*
@@ -1455,7 +2078,13 @@ network_connect_child_read_cb (const void *pointer, void *data, int fd)
                 }
             }
 
-            if (hook_socketpair_ok)
+            if (HOOK_CONNECT(hook_connect, connect_job))
+            {
+                /* get the socket connected by the worker thread */
+                sock = network_connect_job_get_sock (
+                    HOOK_CONNECT(hook_connect, connect_job));
+            }
+            else if (hook_socketpair_ok)
             {
                 /* receive the socket from the child process */
                 memset (&msg, 0, sizeof (msg));
@@ -1642,68 +2271,38 @@ network_connect_child_read_cb (const void *pointer, void *data, int fd)
 }
 
 /*
- * Connects with fork (called by hook_connect() only!).
+ * Adds timer and fd hooks to wait for result of connection (made in a child
+ * process or a worker thread).
+ */
+
+void
+network_connect_hook_child (struct t_hook *hook_connect)
+{
+    HOOK_CONNECT(hook_connect, hook_child_timer) = hook_timer (hook_connect->plugin,
+                                                               CONFIG_INTEGER(config_network_connection_timeout) * 1000,
+                                                               0, 1,
+                                                               &network_connect_child_timer_cb,
+                                                               hook_connect,
+                                                               NULL);
+    HOOK_CONNECT(hook_connect, hook_fd) = hook_fd (hook_connect->plugin,
+                                                   HOOK_CONNECT(hook_connect, child_read),
+                                                   1, 0, 0,
+                                                   &network_connect_child_read_cb,
+                                                   hook_connect, NULL);
+}
+
+/*
+ * Connects with fork.
  */
 
 void
 network_connect_with_fork (struct t_hook *hook_connect)
 {
+    struct t_network_connect_job *job;
     int child_pipe[2], child_socket[2], rc, i;
     char str_error[1024];
-#ifdef HAVE_GNUTLS
-    const char *pos_error;
-#endif /* HAVE_GNUTLS */
     pid_t pid;
 
-#ifdef HAVE_GNUTLS
-    /* initialize GnuTLS if SSL asked */
-    if (HOOK_CONNECT(hook_connect, gnutls_sess))
-    {
-        if (gnutls_init (HOOK_CONNECT(hook_connect, gnutls_sess), GNUTLS_CLIENT) != GNUTLS_E_SUCCESS)
-        {
-            (void) (HOOK_CONNECT(hook_connect, callback))
-                (hook_connect->callback_pointer,
-                 hook_connect->callback_data,
-                 WEECHAT_HOOK_CONNECT_GNUTLS_INIT_ERROR,
-                 0, -1, NULL, NULL);
-            unhook (hook_connect);
-            return;
-        }
-        rc = gnutls_server_name_set (*HOOK_CONNECT(hook_connect, gnutls_sess),
-                                     GNUTLS_NAME_DNS,
-                                     HOOK_CONNECT(hook_connect, address),
-                                     strlen (HOOK_CONNECT(hook_connect, address)));
-        if (rc != GNUTLS_E_SUCCESS)
-        {
-            (void) (HOOK_CONNECT(hook_connect, callback))
-                (hook_connect->callback_pointer,
-                 hook_connect->callback_data,
-                 WEECHAT_HOOK_CONNECT_GNUTLS_INIT_ERROR,
-                 0, -1, _("set server name indication (SNI) failed"), NULL);
-            unhook (hook_connect);
-            return;
-        }
-        rc = gnutls_priority_set_direct (*HOOK_CONNECT(hook_connect, gnutls_sess),
-                                         HOOK_CONNECT(hook_connect, gnutls_priorities),
-                                         &pos_error);
-        if (rc != GNUTLS_E_SUCCESS)
-        {
-            (void) (HOOK_CONNECT(hook_connect, callback))
-                (hook_connect->callback_pointer,
-                 hook_connect->callback_data,
-                 WEECHAT_HOOK_CONNECT_GNUTLS_INIT_ERROR,
-                 0, -1, _("invalid priorities"), NULL);
-            unhook (hook_connect);
-            return;
-        }
-        gnutls_credentials_set (*HOOK_CONNECT(hook_connect, gnutls_sess),
-                                GNUTLS_CRD_CERTIFICATE,
-                                gnutls_xcred);
-        gnutls_transport_set_ptr (*HOOK_CONNECT(hook_connect, gnutls_sess),
-                                  (gnutls_transport_ptr_t) ((unsigned long) HOOK_CONNECT(hook_connect, sock)));
-    }
-#endif /* HAVE_GNUTLS */
-
     /* create pipe for child process */
     if (pipe (child_pipe) < 0)
     {
@@ -1743,10 +2342,33 @@ network_connect_with_fork (struct t_hook *hook_connect)
         }
     }
 
+    job = network_connect_job_new (hook_connect, 0);
+    if (!job)
+    {
+        (void) (HOOK_CONNECT(hook_connect, callback))
+            (hook_connect->callback_pointer,
+             hook_connect->callback_data,
+             WEECHAT_HOOK_CONNECT_MEMORY_ERROR,
+             0, -1, "job", NULL);
+        unhook (hook_connect);
+        return;
+    }
+    job->write_fd = HOOK_CONNECT(hook_connect, child_write);
+    if (hook_socketpair_ok)
+    {
+        job->send_fd = HOOK_CONNECT(hook_connect, child_send);
+    }
+    else
+    {
+        job->sock_v4 = HOOK_CONNECT(hook_connect, sock_v4);
+        job->sock_v6 = HOOK_CONNECT(hook_connect, sock_v6);
+    }
+
     switch (pid = fork ())
     {
         /* fork failed */
         case -1:
+            network_connect_job_free (job);
             snprintf (str_error, sizeof (str_error),
                       "fork error: %s",
                       strerror (errno));
@@ -1764,10 +2386,11 @@ network_connect_with_fork (struct t_hook *hook_connect)
             close (HOOK_CONNECT(hook_connect, child_read));
             if (hook_socketpair_ok)
                 close (HOOK_CONNECT(hook_connect, child_recv));
-            network_connect_child (hook_connect);
+            network_connect_child (job);
             _exit (EXIT_SUCCESS);
     }
     /* parent process */
+    network_connect_job_free (job);
     HOOK_CONNECT(hook_connect, child_pid) = pid;
     close (HOOK_CONNECT(hook_connect, child_write));
     HOOK_CONNECT(hook_connect, child_write) = -1;
@@ -1776,15 +2399,283 @@ network_connect_with_fork (struct t_hook *hook_connect)
         close (HOOK_CONNECT(hook_connect, child_send));
         HOOK_CONNECT(hook_connect, child_send) = -1;
     }
-    HOOK_CONNECT(hook_connect, hook_child_timer) = hook_timer (hook_connect->plugin,
-                                                               CONFIG_INTEGER(config_network_connection_timeout) * 1000,
-                                                               0, 1,
-                                                               &network_connect_child_timer_cb,
-                                                               hook_connect,
-                                                               NULL);
-    HOOK_CONNECT(hook_connect, hook_fd) = hook_fd (hook_connect->plugin,
-                                                   HOOK_CONNECT(hook_connect, child_read),
-                                                   1, 0, 0,
-                                                   &network_connect_child_read_cb,
-                                                   hook_connect, NULL);
+    network_connect_hook_child (hook_connect);
+}
+
+/*
+ * Worker thread: connects to peers, using jobs in the queue.
+ *
+ * Threads wait for new jobs when the queue is empty, until they are stopped
+ * by network_connect_threads_end.
+ */
+
+void *
+network_connect_thread (void *arg)
+{
+    struct t_network_connect_job *job;
+    int cancelled;
+
+    /* make C compiler happy */
+    (void) arg;
+
+    pthread_mutex_lock (&network_mutex);
+    while (1)
+    {
+        while (!network_jobs && !network_threads_stop)
+        {
+            network_num_threads_idle++;
+            pthread_cond_wait (&network_cond, &network_mutex);
+            network_num_threads_idle--;
+        }
+
+        if (network_threads_stop)
+            break;
+
+        /* remove first job from queue */
+        job = network_jobs;
+        network_jobs = job->next_job;
+        if (!network_jobs)
+            last_network_job = NULL;
+        cancelled = job->cancelled;
+        pthread_mutex_unlock (&network_mutex);
+
+        if (!cancelled)
+            network_connect_child (job);
+        close (job->write_fd);
+        job->write_fd = -1;
+
+        pthread_mutex_lock (&network_mutex);
+        job->done = 1;
+        if (job->cancelled)
+        {
+            pthread_mutex_unlock (&network_mutex);
+            network_connect_job_free (job);
+            pthread_mutex_lock (&network_mutex);
+        }
+    }
+    pthread_mutex_unlock (&network_mutex);
+
+    return NULL;
+}
+
+/*
+ * Stops and joins all worker threads (called on exit and before /upgrade).
+ *
+ * Jobs still in queue are not started: they are freed if their hook has been
+ * removed, otherwise the end of job is sent to the hook (the pipe is closed)
+ * and the job is freed when the hook is removed.
+ */
+
+void
+network_connect_threads_end ()
+{
+    struct t_network_connect_job *ptr_job, *next_job;
+    int i;
+
+    if (network_num_threads == 0)
+        return;
+
+    pthread_mutex_lock (&network_mutex);
+    network_threads_stop = 1;
+    pthread_cond_broadcast (&network_cond);
+    pthread_mutex_unlock (&network_mutex);
+
+    for (i = 0; i < network_num_threads; i++)
+    {
+        pthread_join (network_threads[i], NULL);
+    }
+    free (network_threads);
+    network_threads = NULL;
+    network_num_threads = 0;
+    network_num_threads_idle = 0;
+    network_threads_stop = 0;
+
+    ptr_job = network_jobs;
+    network_jobs = NULL;
+    last_network_job = NULL;
+    while (ptr_job)
+    {
+        next_job = ptr_job->next_job;
+        close (ptr_job->write_fd);
+        ptr_job->write_fd = -1;
+        if (ptr_job->cancelled)
+            network_connect_job_free (ptr_job);
+        else
+            ptr_job->done = 1;
+        ptr_job = next_job;
+    }
+}
+
+/*
+ * Connects with a worker thread: the job is added in the queue and a new
+ * thread is started if all threads are busy (up to the number of threads
+ * defined in option weechat.network.connect_threads).
+ *
+ * Returns:
+ *   1: OK (job added in queue)
+ *   0: error (no thread is available)
+ */
+
+int
+network_connect_with_thread (struct t_hook *hook_connect)
+{
+    struct t_network_connect_job *job, *ptr_job;
+    int child_pipe[2], num_jobs;
+    pthread_t *new_threads;
+    sigset_t set, old_set;
+
+    job = network_connect_job_new (hook_connect, 1);
+    if (!job)
+        return 0;
+
+    if (pipe (child_pipe) < 0)
+    {
+        network_connect_job_free (job);
+        return 0;
+    }
+    job->write_fd = child_pipe[1];
+
+    pthread_mutex_lock (&network_mutex);
+
+    num_jobs = 0;
+    for (ptr_job = network_jobs; ptr_job; ptr_job = ptr_job->next_job)
+    {
+        num_jobs++;
+    }
+    if ((num_jobs >= network_num_threads_idle)
+        && (network_num_threads < CONFIG_INTEGER(config_network_connect_threads)))
+    {
+        /* all threads are busy: start a new one (signals are blocked in it) */
+        new_threads = realloc (network_threads,
+                               (network_num_threads + 1) *
+                               sizeof (network_threads[0]));
+        if (new_threads)
+        {
+            network_threads = new_threads;
+            sigfillset (&set);
+            pthread_sigmask (SIG_SETMASK, &set, &old_set);
+            if (pthread_create (&network_threads[network_num_threads], NULL,
+                                &network_connect_thread, NULL) == 0)
+            {
+                network_num_threads++;
+            }
+            pthread_sigmask (SIG_SETMASK, &old_set, NULL);
+        }
+    }
+
+    if (network_num_threads == 0)
+    {
+        pthread_mutex_unlock (&network_mutex);
+        close (child_pipe[0]);
+        close (child_pipe[1]);
+        job->write_fd = -1;
+        network_connect_job_free (job);
+        return 0;
+    }
+
+    /* add job in queue */
+    if (last_network_job)
+        last_network_job->next_job = job;
+    else
+        network_jobs = job;
+    last_network_job = job;
+    pthread_cond_signal (&network_cond);
+
+    pthread_mutex_unlock (&network_mutex);
+
+    HOOK_CONNECT(hook_connect, child_read) = child_pipe[0];
+    HOOK_CONNECT(hook_connect, connect_job) = job;
+    network_connect_hook_child (hook_connect);
+
+    return 1;
+}
+
+/*
+ * Initializes GnuTLS session of a connect hook (if SSL asked).
+ *
+ * Returns:
+ *   1: OK
+ *   0: error (callback has been called and hook removed)
+ */
+
+int
+network_connect_init_gnutls (struct t_hook *hook_connect)
+{
+#ifdef HAVE_GNUTLS
+    int rc;
+    const char *pos_error;
+
+    /* initialize GnuTLS if SSL asked */
+    if (HOOK_CONNECT(hook_connect, gnutls_sess))
+    {
+        if (gnutls_init (HOOK_CONNECT(hook_connect, gnutls_sess), GNUTLS_CLIENT) != GNUTLS_E_SUCCESS)
+        {
+            (void) (HOOK_CONNECT(hook_connect, callback))
+                (hook_connect->callback_pointer,
+                 hook_connect->callback_data,
+                 WEECHAT_HOOK_CONNECT_GNUTLS_INIT_ERROR,
+                 0, -1, NULL, NULL);
+            unhook (hook_connect);
+            return 0;
+        }
+        rc = gnutls_server_name_set (*HOOK_CONNECT(hook_connect, gnutls_sess),
+                                     GNUTLS_NAME_DNS,
+                                     HOOK_CONNECT(hook_connect, address),
+                                     strlen (HOOK_CONNECT(hook_connect, address)));
+        if (rc != GNUTLS_E_SUCCESS)
+        {
+            (void) (HOOK_CONNECT(hook_connect, callback))
+                (hook_connect->callback_pointer,
+                 hook_connect->callback_data,
+                 WEECHAT_HOOK_CONNECT_GNUTLS_INIT_ERROR,
+                 0, -1, _("set server name indication (SNI) failed"), NULL);
+            unhook (hook_connect);
+            return 0;
+        }
+        rc = gnutls_priority_set_direct (*HOOK_CONNECT(hook_connect, gnutls_sess),
+                                         HOOK_CONNECT(hook_connect, gnutls_priorities),
+                                         &pos_error);
+        if (rc != GNUTLS_E_SUCCESS)
+        {
+            (void) (HOOK_CONNECT(hook_connect, callback))
+                (hook_connect->callback_pointer,
+                 hook_connect->callback_data,
+                 WEECHAT_HOOK_CONNECT_GNUTLS_INIT_ERROR,
+                 0, -1, _("invalid priorities"), NULL);
+            unhook (hook_connect);
+            return 0;
+        }
+        gnutls_credentials_set (*HOOK_CONNECT(hook_connect, gnutls_sess),
+                                GNUTLS_CRD_CERTIFICATE,
+                                gnutls_xcred);
+        gnutls_transport_set_ptr (*HOOK_CONNECT(hook_connect, gnutls_sess),
+                                  (gnutls_transport_ptr_t) ((unsigned long) HOOK_CONNECT(hook_connect, sock)));
+    }
+#else
+    /* make C compiler happy */
+    (void) hook_connect;
+#endif /* HAVE_GNUTLS */
+
+    return 1;
+}
+
+/*
+ * Connects to peer (called by hook_connect() only!): the connection is made
+ * in a worker thread, or in a child process if option
+ * weechat.network.connect_threads is set to 0.
+ */
+
+void
+network_connect_start (struct t_hook *hook_connect)
+{
+    if (!network_connect_init_gnutls (hook_connect))
+        return;
+
+    if ((CONFIG_INTEGER(config_network_connect_threads) > 0)
+        && network_connect_with_thread (hook_connect))
+    {
+        return;
+    }
+
+    network_connect_with_fork (hook_connect);
 }
@@ -24,6 +24,7 @@
 #include <sys/socket.h>
 
 struct t_hook;
+struct addrinfo;
 
 struct t_network_socks4
 {
@@ -43,16 +44,70 @@ struct t_network_socks5
                           /*              auth(user/pass) (2), ...          */
 };
 
+/* proxy settings, copied from proxy options (used in forked process/thread) */
+
+struct t_network_proxy
+{
+    int type;                          /* proxy type (PROXY_TYPE_xxx)       */
+    int ipv6;                          /* connect to proxy in IPv6?         */
+    char *address;                     /* proxy address                     */
+    int port;                          /* proxy port                        */
+    char *username;                    /* username (evaluated), NULL if none*/
+    char *password;                    /* password (evaluated)              */
+};
+
+/* connection made in a forked process or in a worker thread */
+
+struct t_network_connect_job
+{
+    char *address;                     /* peer address                      */
+    int port;                          /* peer port                         */
+    int ipv6;                          /* use IPv6                          */
+    int retry;                         /* retry count                       */
+    char *local_hostname;              /* force local hostname (optional)   */
+    int proxy_error;                   /* 1 if proxy was not found          */
+    struct t_network_proxy *proxy;     /* proxy (NULL if no proxy)          */
+    int timeout;                       /* timeout for connection (seconds)  */
+    int dns_cache_ttl;                 /* TTL of DNS cache (0 = no cache)   */
+    int *sock_v4;                      /* pre-created IPv4 sockets (fork)   */
+    int *sock_v6;                      /* pre-created IPv6 sockets (fork)   */
+    int write_fd;                      /* pipe to send status of connection */
+    int send_fd;                       /* socket to send connected socket   */
+    int thread;                        /* 1 if running in a worker thread   */
+    int sock;                          /* connected socket (worker thread)  */
+    int cancelled;                     /* 1 if hook has been removed        */
+    int done;                          /* 1 if worker thread has finished   */
+    struct t_network_connect_job *next_job; /* link to next job in queue    */
+};
+
 extern int network_init_gnutls_ok;
 
 extern void network_init_gcrypt ();
 extern void network_set_gnutls_ca_file ();
 extern void network_init_gnutls ();
 extern void network_end ();
+extern struct addrinfo *network_addrinfo_dup (const struct addrinfo *res);
+extern void network_addrinfo_free (struct addrinfo *res);
+extern int network_getaddrinfo (const char *node, const char *service,
+                                const struct addrinfo *hints, int cache_ttl,
+                                struct addrinfo **res);
+extern void network_dns_cache_free_all ();
+extern struct t_network_proxy *network_proxy_new (const char *proxy);
+extern void network_proxy_free (struct t_network_proxy *proxy);
 extern int network_pass_proxy (const char *proxy, int sock,
                                const char *address, int port);
 extern int network_connect_to (const char *proxy, struct sockaddr *address,
                                socklen_t address_length);
-extern void network_connect_with_fork (struct t_hook *hook_connect);
+extern void network_connect_job_free (struct t_network_connect_job *job);
+extern int network_connect_job_get_sock (struct t_network_connect_job *job);
+extern void network_connect_job_cancel (struct t_network_connect_job *job);
+extern int network_connect_child_race (struct t_network_connect_job *job,
+                                       struct addrinfo **res_list,
+                                       int num_res,
+                                       struct addrinfo *res_local,
+                                       int *status,
+                                       struct addrinfo **res_connected);
+extern void network_connect_threads_end ();
+extern void network_connect_start (struct t_hook *hook_connect);
 
 #endif /* WEECHAT_NETWORK_H */
@@ -66,6 +66,25 @@
 
 struct t_hashtable *string_hashtable_shared = NULL;
 
+#ifdef HAVE_ICONV
+/* cache of iconv descriptors, by charsets "from" and "to" */
+struct t_string_iconv_cd
+{
+    char *from_code;                   /* charset "from"                    */
+    char *to_code;                     /* charset "to"                      */
+    iconv_t cd;                        /* iconv descriptor                  */
+};
+struct t_string_iconv_cd string_iconv_cd_cache[STRING_ICONV_CD_CACHE_SIZE];
+int string_iconv_cd_cache_count = 0;   /* number of descriptors in cache    */
+int string_iconv_cd_cache_next = 0;    /* next index to replace             */
+#endif /* HAVE_ICONV */
+
+/* charsets (prefixes) where the ASCII chars are encoded as in ASCII */
+char *string_charset_ascii_compatible[] =
+{ "UTF-8", "UTF8", "ISO-8859", "ISO8859", "ISO_8859", "LATIN", "CP125",
+  "WINDOWS-125", "KOI8", "ASCII", "US-ASCII", "ANSI_X3.4", "EUC-", "GBK",
+  "GB2312", "GB18030", "BIG5", NULL };
+
 
 /*
  * Defines a "strndup" function for systems where this function does not exist
@@ -2631,6 +2650,166 @@ string_free_split_tags (char ***split_tags)
     }
 }
 
+/*
+ * Checks if a string has only ASCII chars (< 128).
+ *
+ * If length is negative, the whole string is checked (up to the final '\0').
+ *
+ * Returns:
+ *   1: string has only ASCII chars
+ *   0: string has at least one char >= 128
+ */
+
+int
+string_is_ascii (const char *string, int length)
+{
+    if (!string)
+        return 1;
+
+    if (length < 0)
+        length = strlen (string);
+
+    return (utf8_ascii_length (string, length) == length) ? 1 : 0;
+}
+
+/*
+ * Checks if a charset is UTF-8.
+ *
+ * Returns:
+ *   1: charset is UTF-8
+ *   0: charset is not UTF-8
+ */
+
+int
+string_charset_is_utf8 (const char *charset)
+{
+    if (!charset)
+        return 0;
+
+    return ((string_strcasecmp (charset, "UTF-8") == 0)
+            || (string_strcasecmp (charset, "UTF8") == 0)) ? 1 : 0;
+}
+
+/*
+ * Checks if a charset encodes ASCII chars like ASCII (so that a string with
+ * only ASCII chars is the same in this charset).
+ *
+ * Returns:
+ *   1: charset is compatible with ASCII
+ *   0: charset is not compatible with ASCII (or unknown)
+ */
+
+int
+string_charset_is_ascii_compatible (const char *charset)
+{
+    int i;
+
+    if (!charset)
+        return 0;
+
+    for (i = 0; string_charset_ascii_compatible[i]; i++)
+    {
+        if (string_strncasecmp (charset,
+                                string_charset_ascii_compatible[i],
+                                strlen (string_charset_ascii_compatible[i])) == 0)
+        {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+#ifdef HAVE_ICONV
+/*
+ * Gets an iconv descriptor to convert from a charset to another.
+ *
+ * Descriptors are kept in a cache (and are reused for next conversions with
+ * same charsets); the conversion state of descriptor returned is reset.
+ *
+ * Returns iconv descriptor, (iconv_t)(-1) if error.
+ */
+
+iconv_t
+string_iconv_get_cd (const char *from_code, const char *to_code)
+{
+    struct t_string_iconv_cd *ptr_cache;
+    iconv_t cd;
+    char *from_code2, *to_code2;
+    int i;
+
+    for (i = 0; i < string_iconv_cd_cache_count; i++)
+    {
+        ptr_cache = &string_iconv_cd_cache[i];
+        if ((strcmp (ptr_cache->from_code, from_code) == 0)
+            && (strcmp (ptr_cache->to_code, to_code) == 0))
+        {
+            /* reset conversion state */
+            iconv (ptr_cache->cd, NULL, NULL, NULL, NULL);
+            return ptr_cache->cd;
+        }
+    }
+
+    cd = iconv_open (to_code, from_code);
+    if (cd == (iconv_t)(-1))
+        return cd;
+
+    from_code2 = strdup (from_code);
+    to_code2 = strdup (to_code);
+    if (!from_code2 || !to_code2)
+    {
+        if (from_code2)
+            free (from_code2);
+        if (to_code2)
+            free (to_code2);
+        iconv_close (cd);
+        return (iconv_t)(-1);
+    }
+
+    /* add descriptor in cache (replace the oldest one if cache is full) */
+    if (string_iconv_cd_cache_count < STRING_ICONV_CD_CACHE_SIZE)
+    {
+        ptr_cache = &string_iconv_cd_cache[string_iconv_cd_cache_count];
+        string_iconv_cd_cache_count++;
+    }
+    else
+    {
+        ptr_cache = &string_iconv_cd_cache[string_iconv_cd_cache_next];
+        string_iconv_cd_cache_next = (string_iconv_cd_cache_next + 1)
+            % STRING_ICONV_CD_CACHE_SIZE;
+        free (ptr_cache->from_code);
+        free (ptr_cache->to_code);
+        iconv_close (ptr_cache->cd);
+    }
+    ptr_cache->from_code = from_code2;
+    ptr_cache->to_code = to_code2;
+    ptr_cache->cd = cd;
+
+    return cd;
+}
+#endif /* HAVE_ICONV */
+
+/*
+ * Frees all iconv descriptors in cache.
+ */
+
+void
+string_iconv_free_cache ()
+{
+#ifdef HAVE_ICONV
+    int i;
+
+    for (i = 0; i < string_iconv_cd_cache_count; i++)
+    {
+        free (string_iconv_cd_cache[i].from_code);
+        free (string_iconv_cd_cache[i].to_code);
+        iconv_close (string_iconv_cd_cache[i].cd);
+    }
+    string_iconv_cd_cache_count = 0;
+    string_iconv_cd_cache_next = 0;
+#endif /* HAVE_ICONV */
+}
+
 /*
  * Converts a string to another charset.
  *
@@ -2658,7 +2837,22 @@ string_iconv (int from_utf8, const char *from_code, const char *to_code,
     if (from_code && from_code[0] && to_code && to_code[0]
         && (string_strcasecmp (from_code, to_code) != 0))
     {
-        cd = iconv_open (to_code, from_code);
+        /*
+         * no conversion needed for a string with only ASCII chars if both
+         * charsets are compatible with ASCII, or for a valid UTF-8 string
+         * converted from UTF-8 to UTF-8
+         */
+        if ((string_charset_is_ascii_compatible (from_code)
+             && string_charset_is_ascii_compatible (to_code)
+             && string_is_ascii (string, -1))
+            || (string_charset_is_utf8 (from_code)
+                && string_charset_is_utf8 (to_code)
+                && utf8_is_valid (string, -1, NULL)))
+        {
+            return strdup (string);
+        }
+
+        cd = string_iconv_get_cd (from_code, to_code);
         if (cd == (iconv_t)(-1))
             outbuf = strdup (string);
         else
@@ -2731,7 +2925,6 @@ string_iconv (int from_utf8, const char *from_code, const char *to_code,
                 ptr_inbuf = ptr_inbuf_shift;
             ptr_outbuf[0] = '\0';
             free (inbuf);
-            iconv_close (cd);
         }
     }
     else
@@ -4031,6 +4224,8 @@ string_dyn_free (char **string, int free_string)
 void
 string_end ()
 {
+    string_iconv_free_cache ();
+
     if (string_hashtable_shared)
     {
         hashtable_free (string_hashtable_shared);
@@ -43,6 +43,7 @@
 #include "../gui/gui-layout.h"
 #include "../gui/gui-line.h"
 #include "../gui/gui-nicklist.h"
+#include "../gui/gui-search.h"
 #include "../gui/gui-window.h"
 #include "../plugins/plugin.h"
 
@@ -210,6 +211,7 @@ upgrade_weechat_save_misc (struct t_upgrade_file *upgrade_file)
 {
     struct t_infolist *ptr_infolist;
     struct t_infolist_item *ptr_item;
+    char str_id[64];
     int rc;
 
     ptr_infolist = infolist_new (NULL);
@@ -237,6 +239,12 @@ upgrade_weechat_save_misc (struct t_upgrade_file *upgrade_file)
         infolist_free (ptr_infolist);
         return 0;
     }
+    snprintf (str_id, sizeof (str_id), "%ld", gui_line_last_id);
+    if (!infolist_new_var_string (ptr_item, "line_last_id", str_id))
+    {
+        infolist_free (ptr_infolist);
+        return 0;
+    }
 
     rc = upgrade_file_write_object (upgrade_file,
                                     UPGRADE_WEECHAT_TYPE_MISC,
@@ -385,9 +393,10 @@ upgrade_weechat_save ()
         return 0;
 
     rc = 1;
+    /* misc is saved first: id of last line is restored before lines */
+    rc &= upgrade_weechat_save_misc (upgrade_file);
     rc &= upgrade_weechat_save_history (upgrade_file, last_gui_history);
     rc &= upgrade_weechat_save_buffers (upgrade_file);
-    rc &= upgrade_weechat_save_misc (upgrade_file);
     rc &= upgrade_weechat_save_hotlist (upgrade_file);
     rc &= upgrade_weechat_save_layout_window (upgrade_file);
 
@@ -622,6 +631,36 @@ upgrade_weechat_read_buffer (struct t_infolist *infolist)
     }
 }
 
+/*
+ * Restores the id of a line read from infolist.
+ *
+ * The id of last line is restored with misc info, before any line is read;
+ * it is also adjusted here for upgrade files saved by older versions (where
+ * misc info was saved after lines).
+ */
+
+void
+upgrade_weechat_read_line_id (struct t_infolist *infolist,
+                              struct t_gui_line *line)
+{
+    const char *ptr_id;
+    char *error;
+    long id;
+
+    ptr_id = infolist_string (infolist, "id");
+    if (!ptr_id)
+        return;
+
+    error = NULL;
+    id = strtol (ptr_id, &error, 10);
+    if (!error || error[0] || (id <= 0))
+        return;
+
+    line->data->id = id;
+    if (id > gui_line_last_id)
+        gui_line_last_id = id;
+}
+
 /*
  * Reads a buffer line from infolist.
  */
@@ -647,6 +686,7 @@ upgrade_weechat_read_buffer_line (struct t_infolist *infolist)
             if (new_line)
             {
                 gui_line_add (new_line);
+                upgrade_weechat_read_line_id (infolist, new_line);
                 new_line->data->highlight = infolist_integer (infolist,
                                                               "highlight");
                 if (infolist_integer (infolist, "last_read_line"))
@@ -659,7 +699,10 @@ upgrade_weechat_read_buffer_line (struct t_infolist *infolist)
                                      0, 0, NULL, NULL,
                                      infolist_string (infolist, "message"));
             if (new_line)
+            {
                 gui_line_add_y (new_line);
+                upgrade_weechat_read_line_id (infolist, new_line);
+            }
             break;
         case GUI_BUFFER_NUM_TYPES:
             break;
@@ -770,6 +813,31 @@ upgrade_weechat_read_hotlist (struct t_infolist *infolist)
     }
 }
 
+/*
+ * Reads miscellaneous info from infolist.
+ */
+
+void
+upgrade_weechat_read_misc (struct t_infolist *infolist)
+{
+    const char *ptr_id;
+    char *error;
+    long id;
+
+    weechat_first_start_time = infolist_time (infolist, "start_time");
+    weechat_upgrade_count = infolist_integer (infolist, "upgrade_count");
+    upgrade_set_current_window = infolist_integer (infolist, "current_window_number");
+
+    ptr_id = infolist_string (infolist, "line_last_id");
+    if (ptr_id)
+    {
+        error = NULL;
+        id = strtol (ptr_id, &error, 10);
+        if (error && !error[0] && (id > gui_line_last_id))
+            gui_line_last_id = id;
+    }
+}
+
 /*
  * Reads WeeChat upgrade file.
  */
@@ -811,9 +879,7 @@ upgrade_weechat_read_cb (const void *pointer, void *data,
                 upgrade_weechat_read_nicklist (infolist);
                 break;
             case UPGRADE_WEECHAT_TYPE_MISC:
-                weechat_first_start_time = infolist_time (infolist, "start_time");
-                weechat_upgrade_count = infolist_integer (infolist, "upgrade_count");
-                upgrade_set_current_window = infolist_integer (infolist, "current_window_number");
+                upgrade_weechat_read_misc (infolist);
                 break;
             case UPGRADE_WEECHAT_TYPE_HOTLIST:
                 upgrade_weechat_read_hotlist (infolist);
@@ -870,6 +936,8 @@ upgrade_weechat_load ()
     secure_buffer_assign ();
     secure_buffer_display ();
 
+    gui_search_buffer_assign ();
+
     if (upgrade_layout->layout_buffers)
         gui_layout_buffer_apply (upgrade_layout);
     if (upgrade_layout->layout_windows)
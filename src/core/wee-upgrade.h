@@ -37,7 +37,12 @@ enum t_upgrade_weechat_type
     UPGRADE_WEECHAT_TYPE_LAYOUT_WINDOW,
 };
 
+int upgrade_weechat_save_misc (struct t_upgrade_file *upgrade_file);
 int upgrade_weechat_save ();
+int upgrade_weechat_read_cb (const void *pointer, void *data,
+                             struct t_upgrade_file *upgrade_file,
+                             int object_id,
+                             struct t_infolist *infolist);
 int upgrade_weechat_load ();
 void upgrade_weechat_end ();
 
@@ -32,6 +32,7 @@
 #include "wee-url.h"
 #include "wee-config.h"
 #include "wee-hashtable.h"
+#include "wee-hook.h"
 #include "wee-infolist.h"
 #include "wee-proxy.h"
 #include "wee-string.h"
@@ -890,7 +891,11 @@ struct t_url_option url_options[] =
     { NULL, 0, 0, NULL },
 };
 
-char url_error[CURL_ERROR_SIZE + 1];
+CURLM *url_multi = NULL;               /* curl multi handle (transfers)     */
+struct t_hook *url_hook_timer = NULL;  /* timer requested by curl           */
+struct t_url_transfer *url_transfers = NULL; /* list of transfers           */
+struct t_url_transfer *last_url_transfer = NULL; /* last transfer in list   */
+int url_transfers_processing = 0;      /* > 0 when calling callbacks        */
 
 
 /*
@@ -1000,8 +1005,8 @@ weeurl_write (void *buffer, size_t size, size_t nmemb, void *stream)
 }
 
 /*
- * Sets option in CURL easy handle (callback called for each option in hashtable
- * "options").
+ * Sets option in CURL easy handle of a transfer (callback called for each
+ * option in hashtable "options").
  */
 
 void
@@ -1009,20 +1014,23 @@ weeurl_option_map_cb (void *data,
                       struct t_hashtable *hashtable,
                       const void *key, const void *value)
 {
+    struct t_url_transfer *transfer;
     CURL *curl;
     int i, index, index_constant, rc, num_items;
     long long_value;
     long long long_long_value;
-    struct curl_slist *slist;
+    struct curl_slist *slist, **new_slists;
     char **items;
 
     /* make C compiler happy */
     (void) hashtable;
 
-    curl = (CURL *)data;
-    if (!curl)
+    transfer = (struct t_url_transfer *)data;
+    if (!transfer || !transfer->curl)
         return;
 
+    curl = transfer->curl;
+
     index = weeurl_search_option ((const char *)key);
     if (index >= 0)
     {
@@ -1100,6 +1108,16 @@ weeurl_option_map_cb (void *data,
                                       url_options[index].option,
                                       slist);
                     string_free_split (items);
+                    /* keep list, it must be freed after the transfer */
+                    new_slists = realloc (
+                        transfer->slists,
+                        (transfer->num_slists + 1) * sizeof (transfer->slists[0]));
+                    if (new_slists)
+                    {
+                        transfer->slists = new_slists;
+                        transfer->slists[transfer->num_slists] = slist;
+                        transfer->num_slists++;
+                    }
                 }
                 break;
         }
@@ -1169,53 +1187,467 @@ weeurl_set_proxy (CURL *curl, struct t_proxy *proxy)
 }
 
 /*
- * Downloads URL using options.
+ * Writes data received in output of a transfer (callback called by curl when
+ * no output file is given).
+ *
+ * Output is sent later to the transfer callback, outside curl callbacks.
+ */
+
+size_t
+weeurl_transfer_write_output (void *buffer, size_t size, size_t nmemb,
+                              void *data)
+{
+    struct t_url_transfer *transfer;
+    char *new_output;
+    int length, new_alloc;
+
+    transfer = (struct t_url_transfer *)data;
+    length = (int)(size * nmemb);
+
+    if (transfer->output_size + length > transfer->output_alloc)
+    {
+        new_alloc = (transfer->output_alloc > 0) ?
+            transfer->output_alloc * 2 : 4096;
+        while (new_alloc < transfer->output_size + length)
+        {
+            new_alloc *= 2;
+        }
+        new_output = realloc (transfer->output, new_alloc);
+        if (!new_output)
+            return 0;
+        transfer->output = new_output;
+        transfer->output_alloc = new_alloc;
+    }
+    memcpy (transfer->output + transfer->output_size, buffer, length);
+    transfer->output_size += length;
+
+    return (size_t)length;
+}
+
+/*
+ * Closes files used by a transfer.
+ */
+
+void
+weeurl_transfer_close_files (struct t_url_transfer *transfer)
+{
+    int i;
+
+    for (i = 0; i < 2; i++)
+    {
+        if (transfer->file[i].stream)
+        {
+            fclose (transfer->file[i].stream);
+            transfer->file[i].stream = NULL;
+        }
+    }
+}
+
+/*
+ * Frees a transfer and removes it from list.
+ */
+
+void
+weeurl_transfer_free (struct t_url_transfer *transfer)
+{
+    int i;
+
+    if (!transfer)
+        return;
+
+    /* remove transfer from list */
+    if (last_url_transfer == transfer)
+        last_url_transfer = transfer->prev_transfer;
+    if (transfer->prev_transfer)
+        (transfer->prev_transfer)->next_transfer = transfer->next_transfer;
+    else
+        url_transfers = transfer->next_transfer;
+    if (transfer->next_transfer)
+        (transfer->next_transfer)->prev_transfer = transfer->prev_transfer;
+
+    /* free data */
+    if (transfer->curl)
+    {
+        if (url_multi && !transfer->done)
+            curl_multi_remove_handle (url_multi, transfer->curl);
+        curl_easy_cleanup (transfer->curl);
+    }
+    for (i = 0; i < transfer->num_slists; i++)
+    {
+        curl_slist_free_all (transfer->slists[i]);
+    }
+    if (transfer->slists)
+        free (transfer->slists);
+    weeurl_transfer_close_files (transfer);
+    if (transfer->url)
+        free (transfer->url);
+    if (transfer->error)
+        free (transfer->error);
+    if (transfer->output)
+        free (transfer->output);
+
+    free (transfer);
+}
+
+/*
+ * Frees all cancelled transfers (must not be called when callbacks are
+ * running).
+ */
+
+void
+weeurl_transfer_free_cancelled ()
+{
+    struct t_url_transfer *ptr_transfer, *next_transfer;
+
+    ptr_transfer = url_transfers;
+    while (ptr_transfer)
+    {
+        next_transfer = ptr_transfer->next_transfer;
+        if (ptr_transfer->cancelled)
+            weeurl_transfer_free (ptr_transfer);
+        ptr_transfer = next_transfer;
+    }
+}
+
+/*
+ * Sends output and end of transfers to callbacks, after a call to
+ * curl_multi_socket_action().
+ */
+
+void
+weeurl_transfer_check ()
+{
+    struct t_url_transfer *ptr_transfer;
+    t_url_transfer_end_cb *callback_end;
+    CURLMsg *msg;
+    CURL *curl;
+    CURLcode curl_rc;
+    char *ptr_private, *error;
+    int msgs_left, length, rc;
+
+    /* flag transfers finished (and remove them from multi handle) */
+    while ((msg = curl_multi_info_read (url_multi, &msgs_left)))
+    {
+        if (msg->msg != CURLMSG_DONE)
+            continue;
+        curl = msg->easy_handle;
+        curl_rc = msg->data.result;
+        ptr_private = NULL;
+        curl_easy_getinfo (curl, CURLINFO_PRIVATE, &ptr_private);
+        curl_multi_remove_handle (url_multi, curl);
+        ptr_transfer = (struct t_url_transfer *)ptr_private;
+        if (ptr_transfer)
+        {
+            ptr_transfer->done = 1;
+            ptr_transfer->curl_rc = curl_rc;
+        }
+    }
+
+    /*
+     * send output and end of transfers to callbacks (transfers cancelled
+     * by callbacks are freed at the end)
+     */
+    url_transfers_processing++;
+    for (ptr_transfer = url_transfers; ptr_transfer;
+         ptr_transfer = ptr_transfer->next_transfer)
+    {
+        if (!ptr_transfer->cancelled && (ptr_transfer->output_size > 0))
+        {
+            length = ptr_transfer->output_size;
+            ptr_transfer->output_size = 0;
+            if (ptr_transfer->callback_write)
+            {
+                (void) (ptr_transfer->callback_write) (
+                    ptr_transfer->callback_data,
+                    ptr_transfer->output,
+                    length);
+            }
+        }
+        if (!ptr_transfer->cancelled && ptr_transfer->done)
+        {
+            /* files are closed before callback, so that they are complete */
+            weeurl_transfer_close_files (ptr_transfer);
+            rc = 0;
+            error = NULL;
+            if (ptr_transfer->curl_rc != CURLE_OK)
+            {
+                rc = 2;
+                length = 128 + strlen (ptr_transfer->error)
+                    + strlen (ptr_transfer->url) + 1;
+                error = malloc (length);
+                if (error)
+                {
+                    snprintf (error, length,
+                              _("curl error %d (%s) (URL: \"%s\")\n"),
+                              ptr_transfer->curl_rc, ptr_transfer->error,
+                              ptr_transfer->url);
+                }
+            }
+            callback_end = ptr_transfer->callback_end;
+            ptr_transfer->cancelled = 1;
+            if (callback_end)
+            {
+                (void) (callback_end) (ptr_transfer->callback_data,
+                                       rc, error);
+            }
+            if (error)
+                free (error);
+        }
+    }
+    url_transfers_processing--;
+
+    if (url_transfers_processing == 0)
+        weeurl_transfer_free_cancelled ();
+}
+
+/*
+ * Callback for timer requested by curl.
+ */
+
+int
+weeurl_timer_cb (const void *pointer, void *data, int remaining_calls)
+{
+    int running;
+
+    /* make C compiler happy */
+    (void) pointer;
+    (void) data;
+    (void) remaining_calls;
+
+    /* timer is removed after this call (only one call) */
+    url_hook_timer = NULL;
+
+    curl_multi_socket_action (url_multi, CURL_SOCKET_TIMEOUT, 0, &running);
+    weeurl_transfer_check ();
+
+    return WEECHAT_RC_OK;
+}
+
+/*
+ * Callback for activity on a socket used by curl.
+ */
+
+int
+weeurl_fd_cb (const void *pointer, void *data, int fd)
+{
+    int running;
+
+    /* make C compiler happy */
+    (void) pointer;
+    (void) data;
+
+    /* curl checks itself what happened on the socket */
+    curl_multi_socket_action (url_multi, fd, 0, &running);
+    weeurl_transfer_check ();
+
+    return WEECHAT_RC_OK;
+}
+
+/*
+ * Sets timer requested by curl (callback called by curl).
+ */
+
+int
+weeurl_multi_timer_cb (CURLM *multi, long timeout_ms, void *userp)
+{
+    /* make C compiler happy */
+    (void) multi;
+    (void) userp;
+
+    if (url_hook_timer)
+    {
+        unhook (url_hook_timer);
+        url_hook_timer = NULL;
+    }
+
+    if (timeout_ms >= 0)
+    {
+        url_hook_timer = hook_timer (NULL, (timeout_ms > 0) ? timeout_ms : 1,
+                                     0, 1,
+                                     &weeurl_timer_cb, NULL, NULL);
+    }
+
+    return 0;
+}
+
+/*
+ * Adds/updates/removes fd hook for a socket used by curl (callback called by
+ * curl).
+ */
+
+int
+weeurl_multi_socket_cb (CURL *curl, curl_socket_t sock, int what,
+                        void *userp, void *socketp)
+{
+    struct t_hook *ptr_hook;
+    int flags;
+
+    /* make C compiler happy */
+    (void) curl;
+    (void) userp;
+
+    ptr_hook = (struct t_hook *)socketp;
+
+    if (what == CURL_POLL_REMOVE)
+    {
+        if (ptr_hook)
+        {
+            unhook (ptr_hook);
+            curl_multi_assign (url_multi, sock, NULL);
+        }
+        return 0;
+    }
+
+    flags = 0;
+    if ((what == CURL_POLL_IN) || (what == CURL_POLL_INOUT))
+        flags |= HOOK_FD_FLAG_READ;
+    if ((what == CURL_POLL_OUT) || (what == CURL_POLL_INOUT))
+        flags |= HOOK_FD_FLAG_WRITE;
+
+    if (ptr_hook)
+    {
+        HOOK_FD(ptr_hook, flags) = flags;
+    }
+    else
+    {
+        ptr_hook = hook_fd (NULL, sock,
+                            flags & HOOK_FD_FLAG_READ,
+                            flags & HOOK_FD_FLAG_WRITE,
+                            0,
+                            &weeurl_fd_cb, NULL, NULL);
+        curl_multi_assign (url_multi, sock, ptr_hook);
+    }
+
+    return 0;
+}
+
+/*
+ * Sets max number of simultaneous connections for transfers, using option
+ * weechat.network.url_max_connections.
+ */
+
+void
+weeurl_set_max_connections ()
+{
+    if (!url_multi)
+        return;
+
+#if LIBCURL_VERSION_NUM >= 0x071E00 /* 7.30.0 */
+    curl_multi_setopt (url_multi, CURLMOPT_MAX_TOTAL_CONNECTIONS,
+                       (long)CONFIG_INTEGER(config_network_url_max_connections));
+#endif /* LIBCURL_VERSION_NUM >= 0x071E00 */
+}
+
+/*
+ * Creates the curl multi handle (if not already created).
  *
  * Returns:
- *   0: OK
+ *   1: OK
+ *   0: error
+ */
+
+int
+weeurl_multi_init ()
+{
+    if (url_multi)
+        return 1;
+
+    url_multi = curl_multi_init ();
+    if (!url_multi)
+        return 0;
+
+    curl_multi_setopt (url_multi, CURLMOPT_SOCKETFUNCTION,
+                       &weeurl_multi_socket_cb);
+    curl_multi_setopt (url_multi, CURLMOPT_TIMERFUNCTION,
+                       &weeurl_multi_timer_cb);
+#if LIBCURL_VERSION_NUM >= 0x072B00 /* 7.43.0 */
+    /* use HTTP/2 multiplexing when possible */
+    curl_multi_setopt (url_multi, CURLMOPT_PIPELINING,
+                       (long)CURLPIPE_MULTIPLEX);
+#endif /* LIBCURL_VERSION_NUM >= 0x072B00 */
+    weeurl_set_max_connections ();
+
+    return 1;
+}
+
+/*
+ * Starts a transfer using options (the transfer is made in WeeChat process,
+ * without blocking: output is sent to callback "callback_write" and end of
+ * transfer to "callback_end").
+ *
+ * If the transfer can not be started, NULL is returned and the return code
+ * is set in "return_code":
  *   1: invalid URL
- *   2: error downloading URL
  *   3: not enough memory
  *   4: file error
+ *
+ * At end of transfer, return code sent to callback is:
+ *   0: OK
+ *   2: error downloading URL (the error is given in callback)
+ *
+ * Returns pointer to new transfer, NULL if error.
  */
 
-int
-weeurl_download (const char *url, struct t_hashtable *options)
+struct t_url_transfer *
+weeurl_transfer_new (const char *url, struct t_hashtable *options,
+                     t_url_transfer_write_cb *callback_write,
+                     t_url_transfer_end_cb *callback_end,
+                     void *callback_data,
+                     int *return_code)
 {
-    CURL *curl;
-    struct t_url_file url_file[2];
+    struct t_url_transfer *new_transfer;
     char *url_file_option[2] = { "file_in", "file_out" };
     char *url_file_mode[2] = { "rb", "wb" };
     CURLoption url_file_opt_func[2] = { CURLOPT_READFUNCTION, CURLOPT_WRITEFUNCTION };
     CURLoption url_file_opt_data[2] = { CURLOPT_READDATA, CURLOPT_WRITEDATA };
     void *url_file_opt_cb[2] = { &weeurl_read, &weeurl_write };
     struct t_proxy *ptr_proxy;
-    int rc, curl_rc, i;
-
-    rc = 0;
+    const char *ptr_filename;
+    int i;
 
-    for (i = 0; i < 2; i++)
-    {
-        url_file[i].filename = NULL;
-        url_file[i].stream = NULL;
-    }
+    if (return_code)
+        *return_code = 0;
 
     if (!url || !url[0])
     {
-        rc = 1;
-        goto end;
+        if (return_code)
+            *return_code = 1;
+        return NULL;
     }
 
-    curl = curl_easy_init ();
-    if (!curl)
+    new_transfer = calloc (1, sizeof (*new_transfer));
+    if (!new_transfer)
+        goto error_memory;
+
+    /* add transfer to list (it is removed by weeurl_transfer_free) */
+    new_transfer->prev_transfer = last_url_transfer;
+    if (last_url_transfer)
+        last_url_transfer->next_transfer = new_transfer;
+    else
+        url_transfers = new_transfer;
+    last_url_transfer = new_transfer;
+
+    new_transfer->url = strdup (url);
+    new_transfer->error = calloc (1, CURL_ERROR_SIZE + 1);
+    new_transfer->curl = curl_easy_init ();
+    if (!new_transfer->url || !new_transfer->error || !new_transfer->curl
+        || !weeurl_multi_init ())
     {
-        rc = 3;
-        goto end;
+        goto error_memory;
     }
 
     /* set default options */
-    curl_easy_setopt (curl, CURLOPT_URL, url);
-    curl_easy_setopt (curl, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt (new_transfer->curl, CURLOPT_URL, url);
+    curl_easy_setopt (new_transfer->curl, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt (new_transfer->curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt (new_transfer->curl, CURLOPT_PRIVATE, new_transfer);
+    curl_easy_setopt (new_transfer->curl, CURLOPT_WRITEFUNCTION,
+                      &weeurl_transfer_write_output);
+    curl_easy_setopt (new_transfer->curl, CURLOPT_WRITEDATA, new_transfer);
+#if LIBCURL_VERSION_NUM >= 0x072B00 /* 7.43.0 */
+    /* wait for a connection to multiplex instead of opening a new one */
+    curl_easy_setopt (new_transfer->curl, CURLOPT_PIPEWAIT, 1L);
+#endif /* LIBCURL_VERSION_NUM >= 0x072B00 */
 
     /* set proxy (if option weechat.network.proxy_curl is set) */
     if (CONFIG_STRING(config_network_proxy_curl)
@@ -1223,7 +1655,7 @@ weeurl_download (const char *url, struct t_hashtable *options)
     {
         ptr_proxy = proxy_search (CONFIG_STRING(config_network_proxy_curl));
         if (ptr_proxy)
-            weeurl_set_proxy (curl, ptr_proxy);
+            weeurl_set_proxy (new_transfer->curl, ptr_proxy);
     }
 
     /* set file in/out from options in hashtable */
@@ -1231,47 +1663,105 @@ weeurl_download (const char *url, struct t_hashtable *options)
     {
         for (i = 0; i < 2; i++)
         {
-            url_file[i].filename = hashtable_get (options, url_file_option[i]);
-            if (url_file[i].filename)
+            ptr_filename = hashtable_get (options, url_file_option[i]);
+            if (ptr_filename)
             {
-                url_file[i].stream = fopen (url_file[i].filename, url_file_mode[i]);
-                if (!url_file[i].stream)
+                new_transfer->file[i].stream = fopen (ptr_filename,
+                                                      url_file_mode[i]);
+                if (!new_transfer->file[i].stream)
                 {
-                    rc = 4;
-                    goto end;
+                    /* transfer was not added to multi handle */
+                    new_transfer->done = 1;
+                    weeurl_transfer_free (new_transfer);
+                    if (return_code)
+                        *return_code = 4;
+                    return NULL;
                 }
-                curl_easy_setopt (curl, url_file_opt_func[i], url_file_opt_cb[i]);
-                curl_easy_setopt (curl, url_file_opt_data[i], url_file[i].stream);
+                curl_easy_setopt (new_transfer->curl,
+                                  url_file_opt_func[i], url_file_opt_cb[i]);
+                curl_easy_setopt (new_transfer->curl,
+                                  url_file_opt_data[i],
+                                  new_transfer->file[i].stream);
             }
         }
     }
 
     /* set other options in hashtable */
-    hashtable_map (options, &weeurl_option_map_cb, curl);
+    hashtable_map (options, &weeurl_option_map_cb, new_transfer);
 
     /* set error buffer */
-    curl_easy_setopt (curl, CURLOPT_ERRORBUFFER, url_error);
+    curl_easy_setopt (new_transfer->curl, CURLOPT_ERRORBUFFER,
+                      new_transfer->error);
 
-    /* perform action! */
-    curl_rc = curl_easy_perform (curl);
-    if (curl_rc != CURLE_OK)
+    new_transfer->callback_write = callback_write;
+    new_transfer->callback_end = callback_end;
+    new_transfer->callback_data = callback_data;
+
+    /* start transfer (curl will ask for a timer to start it) */
+    if (curl_multi_add_handle (url_multi, new_transfer->curl) != CURLM_OK)
+        goto error_memory;
+
+    return new_transfer;
+
+error_memory:
+    if (new_transfer)
     {
-        fprintf (stderr,
-                 _("curl error %d (%s) (URL: \"%s\")\n"),
-                 curl_rc, url_error, url);
-        rc = 2;
+        /* transfer was not added to multi handle */
+        new_transfer->done = 1;
+        weeurl_transfer_free (new_transfer);
     }
+    if (return_code)
+        *return_code = 3;
+    return NULL;
+}
 
-    /* cleanup */
-    curl_easy_cleanup (curl);
+/*
+ * Cancels a transfer: callbacks will not be called any more and the transfer
+ * is freed (now or after callbacks of other transfers).
+ */
 
-end:
-    for (i = 0; i < 2; i++)
+void
+weeurl_transfer_cancel (struct t_url_transfer *transfer)
+{
+    if (!transfer)
+        return;
+
+    transfer->cancelled = 1;
+    transfer->callback_write = NULL;
+    transfer->callback_end = NULL;
+
+    if (url_transfers_processing == 0)
+        weeurl_transfer_free (transfer);
+}
+
+/*
+ * Ends URL transfers: frees all transfers and curl multi handle.
+ *
+ * Note: it must be called after unhook_all(), so the fd/timer hooks used by
+ * curl have already been removed.
+ */
+
+void
+weeurl_end ()
+{
+    if (url_multi)
+    {
+        /* hooks are already removed, don't let curl use them */
+        curl_multi_setopt (url_multi, CURLMOPT_SOCKETFUNCTION, NULL);
+        curl_multi_setopt (url_multi, CURLMOPT_TIMERFUNCTION, NULL);
+    }
+    url_hook_timer = NULL;
+
+    while (url_transfers)
+    {
+        weeurl_transfer_free (url_transfers);
+    }
+
+    if (url_multi)
     {
-        if (url_file[i].stream)
-            fclose (url_file[i].stream);
+        curl_multi_cleanup (url_multi);
+        url_multi = NULL;
     }
-    return rc;
 }
 
 /*
@@ -24,6 +24,7 @@
 
 struct t_hashtable;
 struct t_infolist;
+struct curl_slist;
 
 enum t_url_type
 {
@@ -54,9 +55,45 @@ struct t_url_file
     FILE *stream;                      /* file stream                       */
 };
 
+typedef void (t_url_transfer_write_cb)(void *data, const char *buffer,
+                                      int size);
+typedef void (t_url_transfer_end_cb)(void *data, int return_code,
+                                    const char *error);
+
+/* URL transfer (made in WeeChat process, with curl multi interface) */
+
+struct t_url_transfer
+{
+    char *url;                         /* URL                               */
+    void *curl;                        /* curl easy handle                  */
+    struct t_url_file file[2];         /* file in/out (optional)            */
+    struct curl_slist **slists;        /* lists given to curl options       */
+    int num_slists;                    /* number of lists                   */
+    char *error;                       /* curl error buffer                 */
+    char *output;                      /* output received (not yet sent)    */
+    int output_size;                   /* size of output                    */
+    int output_alloc;                  /* allocated size for output         */
+    int done;                          /* 1 if transfer is finished         */
+    int curl_rc;                       /* curl return code (if done)        */
+    int cancelled;                     /* 1 if transfer must be freed       */
+    t_url_transfer_write_cb *callback_write; /* called to send output       */
+    t_url_transfer_end_cb *callback_end; /* called at end of transfer       */
+    void *callback_data;               /* data for callbacks                */
+    struct t_url_transfer *prev_transfer; /* link to previous transfer      */
+    struct t_url_transfer *next_transfer; /* link to next transfer          */
+};
+
 extern struct t_url_option url_options[];
 
-extern int weeurl_download (const char *url, struct t_hashtable *options);
+extern struct t_url_transfer *weeurl_transfer_new (const char *url,
+                                                   struct t_hashtable *options,
+                                                   t_url_transfer_write_cb *callback_write,
+                                                   t_url_transfer_end_cb *callback_end,
+                                                   void *callback_data,
+                                                   int *return_code);
+extern void weeurl_transfer_cancel (struct t_url_transfer *transfer);
+extern void weeurl_set_max_connections ();
+extern void weeurl_end ();
 extern int weeurl_option_add_to_infolist (struct t_infolist *infolist,
                                           struct t_url_option *option);
 
@@ -25,9 +25,18 @@
 #endif
 
 #include <stdlib.h>
+#include <stdint.h>
 #include <string.h>
 #include <wctype.h>
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define UTF8_SIMD_X86
+#include <immintrin.h>
+#elif defined(__GNUC__) && defined(__aarch64__) && defined(__ARM_NEON)
+#define UTF8_SIMD_NEON
+#include <arm_neon.h>
+#endif
+
 #include "weechat.h"
 #include "wee-utf8.h"
 #include "wee-config.h"
@@ -36,6 +45,265 @@
 
 int local_utf8 = 0;
 
+/* masks used to check 8 bytes at once */
+#define UTF8_BLOCK_ONES  0x0101010101010101ULL
+#define UTF8_BLOCK_HIGH  0x8080808080808080ULL
+
+char *utf8_simd_string[UTF8_NUM_SIMD] =
+{ "none", "sse2", "avx2", "neon" };
+int utf8_simd = UTF8_SIMD_NONE;        /* SIMD instructions used to check   */
+                                       /* ASCII chars                       */
+
+/*
+ * functions checking ASCII chars by blocks of 16/32 bytes (SIMD); only the
+ * ASCII prefix of strings is checked with them, non-ASCII chars are still
+ * checked one by one
+ */
+int (*utf8_simd_ascii_length) (const char *string, int bytes) = NULL;
+int (*utf8_simd_ascii_printable_length) (const char *string, int bytes) = NULL;
+
+
+#ifdef UTF8_SIMD_X86
+
+/*
+ * Gets number of ASCII chars (< 128) at beginning of string, by blocks of
+ * 16 bytes (SSE2).
+ *
+ * Returns number of bytes checked (multiple of 16), the remaining bytes must
+ * be checked by caller.
+ */
+
+__attribute__((target("sse2"))) int
+utf8_ascii_length_sse2 (const char *string, int bytes)
+{
+    __m128i block;
+    int i;
+
+    i = 0;
+    while (i + 16 <= bytes)
+    {
+        block = _mm_loadu_si128 ((const __m128i *)(string + i));
+        if (_mm_movemask_epi8 (block))
+            break;
+        i += 16;
+    }
+
+    return i;
+}
+
+/*
+ * Gets number of printable ASCII chars (from 32 to 126) at beginning of
+ * string, by blocks of 16 bytes (SSE2).
+ *
+ * Bytes are compared as signed chars, so bytes >= 128 are lower than 32.
+ *
+ * Returns number of bytes checked (multiple of 16), the remaining bytes must
+ * be checked by caller.
+ */
+
+__attribute__((target("sse2"))) int
+utf8_ascii_printable_length_sse2 (const char *string, int bytes)
+{
+    __m128i block, space, del;
+    int i;
+
+    space = _mm_set1_epi8 (32);
+    del = _mm_set1_epi8 (127);
+
+    i = 0;
+    while (i + 16 <= bytes)
+    {
+        block = _mm_loadu_si128 ((const __m128i *)(string + i));
+        if (_mm_movemask_epi8 (_mm_or_si128 (_mm_cmplt_epi8 (block, space),
+                                             _mm_cmpeq_epi8 (block, del))))
+        {
+            break;
+        }
+        i += 16;
+    }
+
+    return i;
+}
+
+/*
+ * Gets number of ASCII chars (< 128) at beginning of string, by blocks of
+ * 32 bytes (AVX2).
+ *
+ * Returns number of bytes checked (multiple of 32), the remaining bytes must
+ * be checked by caller.
+ */
+
+__attribute__((target("avx2"))) int
+utf8_ascii_length_avx2 (const char *string, int bytes)
+{
+    __m256i block;
+    int i;
+
+    i = 0;
+    while (i + 32 <= bytes)
+    {
+        block = _mm256_loadu_si256 ((const __m256i *)(string + i));
+        if (_mm256_movemask_epi8 (block))
+            break;
+        i += 32;
+    }
+
+    return i;
+}
+
+/*
+ * Gets number of printable ASCII chars (from 32 to 126) at beginning of
+ * string, by blocks of 32 bytes (AVX2).
+ *
+ * Bytes are compared as signed chars, so bytes >= 128 are lower than 32.
+ *
+ * Returns number of bytes checked (multiple of 32), the remaining bytes must
+ * be checked by caller.
+ */
+
+__attribute__((target("avx2"))) int
+utf8_ascii_printable_length_avx2 (const char *string, int bytes)
+{
+    __m256i block, space, del;
+    int i;
+
+    space = _mm256_set1_epi8 (32);
+    del = _mm256_set1_epi8 (127);
+
+    i = 0;
+    while (i + 32 <= bytes)
+    {
+        block = _mm256_loadu_si256 ((const __m256i *)(string + i));
+        if (_mm256_movemask_epi8 (
+                _mm256_or_si256 (_mm256_cmpgt_epi8 (space, block),
+                                 _mm256_cmpeq_epi8 (block, del))))
+        {
+            break;
+        }
+        i += 32;
+    }
+
+    return i;
+}
+
+#endif /* UTF8_SIMD_X86 */
+
+#ifdef UTF8_SIMD_NEON
+
+/*
+ * Gets number of ASCII chars (< 128) at beginning of string, by blocks of
+ * 16 bytes (NEON).
+ *
+ * Returns number of bytes checked (multiple of 16), the remaining bytes must
+ * be checked by caller.
+ */
+
+int
+utf8_ascii_length_neon (const char *string, int bytes)
+{
+    uint8x16_t block;
+    int i;
+
+    i = 0;
+    while (i + 16 <= bytes)
+    {
+        block = vld1q_u8 ((const uint8_t *)(string + i));
+        if (vmaxvq_u8 (block) >= 128)
+            break;
+        i += 16;
+    }
+
+    return i;
+}
+
+/*
+ * Gets number of printable ASCII chars (from 32 to 126) at beginning of
+ * string, by blocks of 16 bytes (NEON).
+ *
+ * Returns number of bytes checked (multiple of 16), the remaining bytes must
+ * be checked by caller.
+ */
+
+int
+utf8_ascii_printable_length_neon (const char *string, int bytes)
+{
+    uint8x16_t block;
+    int i;
+
+    i = 0;
+    while (i + 16 <= bytes)
+    {
+        block = vld1q_u8 ((const uint8_t *)(string + i));
+        if ((vminvq_u8 (block) < 32) || (vmaxvq_u8 (block) > 126))
+            break;
+        i += 16;
+    }
+
+    return i;
+}
+
+#endif /* UTF8_SIMD_NEON */
+
+/*
+ * Sets SIMD instructions used to check ASCII chars in UTF-8 functions.
+ *
+ * If simd is negative, the best instructions supported by the CPU are used.
+ *
+ * Returns:
+ *   1: OK
+ *   0: instructions not supported by the CPU (or not compiled)
+ */
+
+int
+utf8_simd_set (int simd)
+{
+#ifdef UTF8_SIMD_X86
+    __builtin_cpu_init ();
+#endif /* UTF8_SIMD_X86 */
+
+    if (simd < 0)
+    {
+        for (simd = UTF8_NUM_SIMD - 1; simd > UTF8_SIMD_NONE; simd--)
+        {
+            if (utf8_simd_set (simd))
+                return 1;
+        }
+    }
+
+    switch (simd)
+    {
+        case UTF8_SIMD_NONE:
+            utf8_simd_ascii_length = NULL;
+            utf8_simd_ascii_printable_length = NULL;
+            break;
+#ifdef UTF8_SIMD_X86
+        case UTF8_SIMD_SSE2:
+            if (!__builtin_cpu_supports ("sse2"))
+                return 0;
+            utf8_simd_ascii_length = &utf8_ascii_length_sse2;
+            utf8_simd_ascii_printable_length = &utf8_ascii_printable_length_sse2;
+            break;
+        case UTF8_SIMD_AVX2:
+            if (!__builtin_cpu_supports ("avx2"))
+                return 0;
+            utf8_simd_ascii_length = &utf8_ascii_length_avx2;
+            utf8_simd_ascii_printable_length = &utf8_ascii_printable_length_avx2;
+            break;
+#endif /* UTF8_SIMD_X86 */
+#ifdef UTF8_SIMD_NEON
+        case UTF8_SIMD_NEON:
+            utf8_simd_ascii_length = &utf8_ascii_length_neon;
+            utf8_simd_ascii_printable_length = &utf8_ascii_printable_length_neon;
+            break;
+#endif /* UTF8_SIMD_NEON */
+        default:
+            return 0;
+    }
+
+    utf8_simd = simd;
+
+    return 1;
+}
 
 /*
  * Initializes UTF-8 in WeeChat.
@@ -45,6 +313,8 @@ void
 utf8_init ()
 {
     local_utf8 = (string_strcasecmp (weechat_local_charset, "UTF-8") == 0);
+
+    utf8_simd_set (-1);
 }
 
 /*
@@ -58,13 +328,96 @@ utf8_init ()
 int
 utf8_has_8bits (const char *string)
 {
-    while (string && string[0])
+    int length;
+
+    if (!string)
+        return 0;
+
+    length = strlen (string);
+    return (utf8_ascii_length (string, length) < length) ? 1 : 0;
+}
+
+/*
+ * Gets number of ASCII chars (< 128) at beginning of string, checking at most
+ * "bytes" bytes (the string must have at least "bytes" bytes readable).
+ *
+ * The string is checked with SIMD instructions (if available), then by blocks
+ * of 8 bytes, then byte by byte.
+ *
+ * Returns number of ASCII chars (>= 0).
+ */
+
+int
+utf8_ascii_length (const char *string, int bytes)
+{
+    uint64_t block;
+    int i;
+
+    if (!string || (bytes <= 0))
+        return 0;
+
+    i = (utf8_simd_ascii_length) ?
+        utf8_simd_ascii_length (string, bytes) : 0;
+    while (i + (int)sizeof (block) <= bytes)
     {
-        if (string[0] & 0x80)
-            return 1;
-        string++;
+        memcpy (&block, string + i, sizeof (block));
+        if (block & UTF8_BLOCK_HIGH)
+            break;
+        i += sizeof (block);
     }
-    return 0;
+    while ((i < bytes) && !(string[i] & 0x80))
+    {
+        i++;
+    }
+
+    return i;
+}
+
+/*
+ * Gets number of printable ASCII chars (from 32 to 126) at beginning of
+ * string, checking at most "bytes" bytes (the string must have at least
+ * "bytes" bytes readable).
+ *
+ * The string is checked with SIMD instructions (if available), then by blocks
+ * of 8 bytes, then byte by byte.
+ *
+ * Returns number of printable ASCII chars (>= 0).
+ */
+
+int
+utf8_ascii_printable_length (const char *string, int bytes)
+{
+    uint64_t block, del;
+    int i;
+
+    if (!string || (bytes <= 0))
+        return 0;
+
+    i = (utf8_simd_ascii_printable_length) ?
+        utf8_simd_ascii_printable_length (string, bytes) : 0;
+    while (i + (int)sizeof (block) <= bytes)
+    {
+        memcpy (&block, string + i, sizeof (block));
+        /* stop on a byte >= 128 */
+        if (block & UTF8_BLOCK_HIGH)
+            break;
+        /* stop on a byte < 32 */
+        if ((block - (UTF8_BLOCK_ONES * 0x20)) & ~block & UTF8_BLOCK_HIGH)
+            break;
+        /* stop on a byte == 127 */
+        del = block ^ (UTF8_BLOCK_ONES * 0x7F);
+        if ((del - UTF8_BLOCK_ONES) & ~del & UTF8_BLOCK_HIGH)
+            break;
+        i += sizeof (block);
+    }
+    while ((i < bytes)
+           && ((unsigned char)(string[i]) >= 32)
+           && ((unsigned char)(string[i]) < 127))
+    {
+        i++;
+    }
+
+    return i;
 }
 
 /*
@@ -82,13 +435,33 @@ utf8_has_8bits (const char *string)
 int
 utf8_is_valid (const char *string, int length, char **error)
 {
-    int code_point, current_char;
+    const char *end;
+    int code_point, current_char, ascii;
+
+    if (!string)
+    {
+        if (error)
+            *error = NULL;
+        return 1;
+    }
 
+    end = NULL;
     current_char = 0;
 
-    while (string && string[0]
-           && ((length <= 0) || (current_char < length)))
+    while (string[0] && ((length <= 0) || (current_char < length)))
     {
+        /* UTF-8, 1 byte, should be: 0vvvvvvv (skip all ASCII chars at once) */
+        if (!((unsigned char)(string[0]) & 0x80))
+        {
+            if (!end)
+                end = string + strlen (string);
+            ascii = utf8_ascii_length (string, end - string);
+            if ((length > 0) && (ascii > length - current_char))
+                ascii = length - current_char;
+            string += ascii;
+            current_char += ascii;
+            continue;
+        }
         /*
          * UTF-8, 2 bytes, should be: 110vvvvv 10vvvvvv
          * and in range: U+0080 - U+07FF
@@ -143,11 +516,8 @@ utf8_is_valid (const char *string, int length, char **error)
                 goto invalid;
             string += 4;
         }
-        /* UTF-8, 1 byte, should be: 0vvvvvvv */
-        else if ((unsigned char)(string[0]) >= 0x80)
-            goto invalid;
         else
-            string++;
+            goto invalid;
         current_char++;
     }
     if (error)
@@ -168,14 +538,29 @@ invalid:
 void
 utf8_normalize (char *string, char replacement)
 {
-    char *error;
+    char *end;
+
+    if (!string)
+        return;
+
+    end = string + strlen (string);
 
-    while (string && string[0])
+    while (string[0])
     {
-        if (utf8_is_valid (string, -1, &error))
-            return;
-        error[0] = replacement;
-        string = error + 1;
+        if (!((unsigned char)(string[0]) & 0x80))
+        {
+            /* skip all ASCII chars at once */
+            string += utf8_ascii_length (string, end - string);
+        }
+        else if (utf8_is_valid (string, 1, NULL))
+        {
+            string = (char *)utf8_next_char (string);
+        }
+        else
+        {
+            string[0] = replacement;
+            string++;
+        }
     }
 }
 
@@ -441,16 +826,28 @@ utf8_char_size (const char *string)
 int
 utf8_strlen (const char *string)
 {
-    int length;
+    const char *end;
+    int length, ascii;
 
     if (!string)
         return 0;
 
+    end = string + strlen (string);
     length = 0;
-    while (string && string[0])
+    while (string[0])
     {
-        string = utf8_next_char (string);
-        length++;
+        if (!((unsigned char)(string[0]) & 0x80))
+        {
+            /* skip all ASCII chars at once */
+            ascii = utf8_ascii_length (string, end - string);
+            string += ascii;
+            length += ascii;
+        }
+        else
+        {
+            string = utf8_next_char (string);
+            length++;
+        }
     }
     return length;
 }
@@ -465,17 +862,29 @@ int
 utf8_strnlen (const char *string, int bytes)
 {
     char *start;
-    int length;
+    const char *end;
+    int length, ascii;
 
-    if (!string)
+    if (!string || (bytes <= 0))
         return 0;
 
     start = (char *)string;
+    end = string + strnlen (string, bytes);
     length = 0;
-    while (string && string[0] && (string - start < bytes))
+    while (string[0] && (string - start < bytes))
     {
-        string = utf8_next_char (string);
-        length++;
+        if (!((unsigned char)(string[0]) & 0x80))
+        {
+            /* skip all ASCII chars at once */
+            ascii = utf8_ascii_length (string, end - string);
+            string += ascii;
+            length += ascii;
+        }
+        else
+        {
+            string = utf8_next_char (string);
+            length++;
+        }
     }
     return length;
 }
@@ -496,6 +905,11 @@ utf8_strlen_screen (const char *string)
     if (!string || !string[0])
         return 0;
 
+    /* fast path: string with only printable ASCII chars */
+    length = strlen (string);
+    if (utf8_ascii_printable_length (string, length) == length)
+        return length;
+
     if (!local_utf8)
         return utf8_strlen (string);
 
@@ -26,10 +26,25 @@
 
 #include <wchar.h>
 
+enum t_utf8_simd
+{
+    UTF8_SIMD_NONE = 0,
+    UTF8_SIMD_SSE2,
+    UTF8_SIMD_AVX2,
+    UTF8_SIMD_NEON,
+    /* number of SIMD instructions sets */
+    UTF8_NUM_SIMD,
+};
+
 extern int local_utf8;
+extern char *utf8_simd_string[];
+extern int utf8_simd;
 
+extern int utf8_simd_set (int simd);
 extern void utf8_init ();
 extern int utf8_has_8bits (const char *string);
+extern int utf8_ascii_length (const char *string, int bytes);
+extern int utf8_ascii_printable_length (const char *string, int bytes);
 extern int utf8_is_valid (const char *string, int length, char **error);
 extern void utf8_normalize (char *string, char replacement);
 extern const char *utf8_prev_char (const char *string_start,
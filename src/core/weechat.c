@@ -70,6 +70,7 @@
 #include "wee-secure-config.h"
 #include "wee-string.h"
 #include "wee-upgrade.h"
+#include "wee-url.h"
 #include "wee-utf8.h"
 #include "wee-util.h"
 #include "wee-version.h"
@@ -850,6 +851,8 @@ weechat_end (void (*gui_end_cb)(int clean_exit))
     config_file_free_all ();            /* free all configuration files     */
     gui_key_end ();                     /* remove all keys                  */
     unhook_all ();                      /* remove all hooks                 */
+    weeurl_end ();                      /* end URL transfers                */
+    hook_profile_free_all ();           /* free profiling of hooks          */
     hdata_end ();                       /* end hdata                        */
     secure_end ();                      /* end secured data                 */
     string_end ();                      /* end string                       */
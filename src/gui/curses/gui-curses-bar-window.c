@@ -759,7 +759,7 @@ gui_bar_window_draw (struct t_gui_bar_window *bar_window,
         if (x > bar_window->width - 2)
             x = bar_window->width - 2;
         wmove (GUI_BAR_WINDOW_OBJECTS(bar_window)->win_bar, y, x);
-        wrefresh (GUI_BAR_WINDOW_OBJECTS(bar_window)->win_bar);
+        wnoutrefresh (GUI_BAR_WINDOW_OBJECTS(bar_window)->win_bar);
         if (!gui_cursor_mode)
         {
             gui_window_cursor_x = bar_window->cursor_x;
@@ -808,7 +808,7 @@ gui_bar_window_draw (struct t_gui_bar_window *bar_window,
         wnoutrefresh (GUI_BAR_WINDOW_OBJECTS(bar_window)->win_separator);
     }
 
-    refresh ();
+    gui_window_frame_stage ();
 }
 
 /*
@@ -1293,100 +1293,26 @@ gui_chat_display_time_to_prefix (struct t_gui_window *window,
 }
 
 /*
- * Displays a line in the chat window.
- *
- * If count == 0, display whole line.
- * If count > 0, display 'count' lines (beginning from the end).
- * If simulate == 1, nothing is displayed (for counting how many lines would
- * have been displayed).
- *
- * Returns number of lines displayed (or simulated).
+ * Displays time, prefix and message of a line in the chat window (without
+ * the day change messages before/after the line).
  */
 
-int
-gui_chat_display_line (struct t_gui_window *window, struct t_gui_line *line,
-                       int count, int simulate)
+void
+gui_chat_display_line_message (struct t_gui_window *window,
+                               struct t_gui_line *line,
+                               int num_lines, int count,
+                               int pre_lines_displayed, int *lines_displayed,
+                               int simulate)
 {
-    int num_lines, x, y, pre_lines_displayed, lines_displayed, line_align;
-    int read_marker_x, read_marker_y;
+    int line_align;
     int word_start_offset, word_end_offset;
     int word_length_with_spaces, word_length;
     char *message_with_tags, *message_with_search;
     const char *ptr_data, *ptr_end_offset, *ptr_style, *next_char;
-    struct t_gui_line *ptr_prev_line, *ptr_next_line;
-    struct tm local_time, local_time2;
-    struct timeval tv_time;
-    time_t seconds, *ptr_time;
-
-    if (!line)
-        return 0;
-
-    if (simulate)
-    {
-        x = window->win_chat_cursor_x;
-        y = window->win_chat_cursor_y;
-        window->win_chat_cursor_x = 0;
-        window->win_chat_cursor_y = 0;
-        num_lines = 0;
-    }
-    else
-    {
-        if (window->win_chat_cursor_y > window->win_chat_height - 1)
-            return 0;
-        x = window->win_chat_cursor_x;
-        y = window->win_chat_cursor_y;
-        num_lines = gui_chat_display_line (window, line, 0, 1);
-        window->win_chat_cursor_x = x;
-        window->win_chat_cursor_y = y;
-        gui_window_current_emphasis = 0;
-    }
-
-    pre_lines_displayed = 0;
-    lines_displayed = 0;
-
-    /* display message before first line of buffer if date is not today */
-    if ((line->data->date != 0)
-        && CONFIG_BOOLEAN(config_look_day_change)
-        && window->buffer->day_change)
-    {
-        ptr_time = NULL;
-        ptr_prev_line = gui_line_get_prev_displayed (line);
-        if (ptr_prev_line)
-        {
-            while (ptr_prev_line && (ptr_prev_line->data->date == 0))
-            {
-                ptr_prev_line = gui_line_get_prev_displayed (ptr_prev_line);
-            }
-        }
-        if (!ptr_prev_line)
-        {
-            gettimeofday (&tv_time, NULL);
-            seconds = tv_time.tv_sec;
-            localtime_r (&seconds, &local_time);
-            localtime_r (&line->data->date, &local_time2);
-            if ((local_time.tm_mday != local_time2.tm_mday)
-                || (local_time.tm_mon != local_time2.tm_mon)
-                || (local_time.tm_year != local_time2.tm_year))
-            {
-                gui_chat_display_day_changed (window, NULL, &local_time2,
-                                              simulate);
-                gui_chat_display_new_line (window, num_lines, count,
-                                           &lines_displayed, simulate);
-                pre_lines_displayed++;
-            }
-        }
-    }
-
-    /* calculate marker position (maybe not used for this line!) */
-    if (window->buffer->time_for_each_line && line->data->str_time)
-        read_marker_x = x + gui_chat_strlen_screen (line->data->str_time);
-    else
-        read_marker_x = x;
-    read_marker_y = y;
 
     /* display time and prefix */
     gui_chat_display_time_to_prefix (window, line, num_lines, count,
-                                     pre_lines_displayed, &lines_displayed,
+                                     pre_lines_displayed, lines_displayed,
                                      simulate);
     if (!simulate && !gui_chat_display_tags)
     {
@@ -1461,13 +1387,13 @@ gui_chat_display_line (struct t_gui_window *window, struct t_gui_line *line,
             if (word_length >= 0)
             {
                 line_align = gui_line_get_align (window->buffer, line, 1,
-                                                 (lines_displayed == 0) ? 1 : 0);
+                                                 (*lines_displayed == 0) ? 1 : 0);
                 if ((window->win_chat_cursor_x + word_length_with_spaces > gui_chat_get_real_width (window))
                     && (word_length <= gui_chat_get_real_width (window) - line_align))
                 {
                     /* spaces + word too long for current line but OK for next line */
                     gui_chat_display_new_line (window, num_lines, count,
-                                               &lines_displayed, simulate);
+                                               lines_displayed, simulate);
                     /* apply styles before jumping to start of word */
                     if (!simulate && (word_start_offset > 0))
                     {
@@ -1493,7 +1419,7 @@ gui_chat_display_line (struct t_gui_window *window, struct t_gui_line *line,
                 gui_chat_display_word (window, line, ptr_data,
                                        ptr_end_offset + 1,
                                        0, num_lines, count,
-                                       pre_lines_displayed, &lines_displayed,
+                                       pre_lines_displayed, lines_displayed,
                                        simulate,
                                        CONFIG_BOOLEAN(config_look_color_inactive_message),
                                        0);
@@ -1526,7 +1452,7 @@ gui_chat_display_line (struct t_gui_window *window, struct t_gui_line *line,
             else
             {
                 gui_chat_display_new_line (window, num_lines, count,
-                                           &lines_displayed, simulate);
+                                           lines_displayed, simulate);
                 ptr_data = NULL;
             }
         }
@@ -1535,13 +1461,232 @@ gui_chat_display_line (struct t_gui_window *window, struct t_gui_line *line,
     {
         /* no message */
         gui_chat_display_new_line (window, num_lines, count,
-                                   &lines_displayed, simulate);
+                                   lines_displayed, simulate);
     }
 
     if (message_with_tags)
         free (message_with_tags);
     if (message_with_search)
         free (message_with_search);
+}
+
+/*
+ * Returns flags used to compute layout of a line in a window: if one of these
+ * flags changes, the number of lines displayed on screen may be different.
+ */
+
+int
+gui_chat_line_layout_flags (struct t_gui_window *window,
+                            struct t_gui_line *line,
+                            int pre_lines_displayed)
+{
+    int flags;
+
+    flags = 0;
+
+    if (window->buffer->time_for_each_line)
+        flags |= GUI_LINE_LAYOUT_TIME;
+    if (gui_chat_display_tags)
+        flags |= GUI_LINE_LAYOUT_TAGS;
+    if (window->buffer->mixed_lines && (window->buffer->active != 2))
+        flags |= GUI_LINE_LAYOUT_MIXED;
+    if (line->data->buffer->mixed_lines && (line->data->buffer->active != 2))
+        flags |= GUI_LINE_LAYOUT_MIXED_LINE;
+    if (CONFIG_STRING(config_look_buffer_time_same)
+        && CONFIG_STRING(config_look_buffer_time_same)[0]
+        && gui_chat_line_time_is_same_as_previous (line))
+    {
+        flags |= GUI_LINE_LAYOUT_TIME_SAME;
+    }
+    if (CONFIG_STRING(config_look_prefix_same_nick)
+        && CONFIG_STRING(config_look_prefix_same_nick)[0]
+        && gui_line_prefix_is_same_nick (line, -1))
+    {
+        flags |= GUI_LINE_LAYOUT_SAME_NICK_PREV;
+        if (CONFIG_STRING(config_look_prefix_same_nick_middle)
+            && CONFIG_STRING(config_look_prefix_same_nick_middle)[0]
+            && gui_line_prefix_is_same_nick (line, 1))
+        {
+            flags |= GUI_LINE_LAYOUT_SAME_NICK_NEXT;
+        }
+    }
+    if (pre_lines_displayed > 0)
+        flags |= GUI_LINE_LAYOUT_DAY_CHANGE;
+
+    return flags;
+}
+
+/*
+ * Gets number of lines on screen for time, prefix and message of a line,
+ * using the layout cached in the line.
+ *
+ * Returns number of lines, -1 if the layout is not cached or if it has been
+ * computed with different settings.
+ */
+
+int
+gui_chat_line_layout_get (struct t_gui_window *window,
+                          struct t_gui_line *line, int flags)
+{
+    struct t_gui_line_data *line_data;
+
+    line_data = line->data;
+
+    if ((line_data->layout_generation != gui_chat_layout_generation)
+        || (line_data->layout_width != gui_chat_get_real_width (window))
+        || (line_data->layout_prefix_max_length != window->buffer->lines->prefix_max_length)
+        || (line_data->layout_buffer_max_length != ((window->buffer->mixed_lines) ?
+                                                    window->buffer->mixed_lines->buffer_max_length : 0))
+        || (line_data->layout_flags != flags))
+    {
+        return -1;
+    }
+
+    return line_data->layout_num_lines;
+}
+
+/*
+ * Saves number of lines on screen for time, prefix and message of a line
+ * (layout cached in the line).
+ */
+
+void
+gui_chat_line_layout_set (struct t_gui_window *window,
+                          struct t_gui_line *line, int flags, int num_lines)
+{
+    struct t_gui_line_data *line_data;
+
+    line_data = line->data;
+
+    line_data->layout_generation = gui_chat_layout_generation;
+    line_data->layout_width = gui_chat_get_real_width (window);
+    line_data->layout_prefix_max_length = window->buffer->lines->prefix_max_length;
+    line_data->layout_buffer_max_length = (window->buffer->mixed_lines) ?
+        window->buffer->mixed_lines->buffer_max_length : 0;
+    line_data->layout_flags = flags;
+    line_data->layout_num_lines = num_lines;
+}
+
+/*
+ * Displays a line in the chat window.
+ *
+ * If count == 0, display whole line.
+ * If count > 0, display 'count' lines (beginning from the end).
+ * If simulate == 1, nothing is displayed (for counting how many lines would
+ * have been displayed).
+ *
+ * Returns number of lines displayed (or simulated).
+ */
+
+int
+gui_chat_display_line (struct t_gui_window *window, struct t_gui_line *line,
+                       int count, int simulate)
+{
+    int num_lines, x, y, pre_lines_displayed, lines_displayed;
+    int read_marker_x, read_marker_y, layout_flags, layout_num_lines;
+    struct t_gui_line *ptr_prev_line, *ptr_next_line;
+    struct tm local_time, local_time2;
+    struct timeval tv_time;
+    time_t seconds, *ptr_time;
+
+    if (!line)
+        return 0;
+
+    if (simulate)
+    {
+        x = window->win_chat_cursor_x;
+        y = window->win_chat_cursor_y;
+        window->win_chat_cursor_x = 0;
+        window->win_chat_cursor_y = 0;
+        num_lines = 0;
+    }
+    else
+    {
+        if (window->win_chat_cursor_y > window->win_chat_height - 1)
+            return 0;
+        x = window->win_chat_cursor_x;
+        y = window->win_chat_cursor_y;
+        num_lines = gui_chat_display_line (window, line, 0, 1);
+        window->win_chat_cursor_x = x;
+        window->win_chat_cursor_y = y;
+        gui_window_current_emphasis = 0;
+    }
+
+    pre_lines_displayed = 0;
+    lines_displayed = 0;
+
+    /* display message before first line of buffer if date is not today */
+    if ((line->data->date != 0)
+        && CONFIG_BOOLEAN(config_look_day_change)
+        && window->buffer->day_change)
+    {
+        ptr_time = NULL;
+        ptr_prev_line = gui_line_get_prev_displayed (line);
+        if (ptr_prev_line)
+        {
+            while (ptr_prev_line && (ptr_prev_line->data->date == 0))
+            {
+                ptr_prev_line = gui_line_get_prev_displayed (ptr_prev_line);
+            }
+        }
+        if (!ptr_prev_line)
+        {
+            gettimeofday (&tv_time, NULL);
+            seconds = tv_time.tv_sec;
+            localtime_r (&seconds, &local_time);
+            localtime_r (&line->data->date, &local_time2);
+            if ((local_time.tm_mday != local_time2.tm_mday)
+                || (local_time.tm_mon != local_time2.tm_mon)
+                || (local_time.tm_year != local_time2.tm_year))
+            {
+                gui_chat_display_day_changed (window, NULL, &local_time2,
+                                              simulate);
+                gui_chat_display_new_line (window, num_lines, count,
+                                           &lines_displayed, simulate);
+                pre_lines_displayed++;
+            }
+        }
+    }
+
+    /* calculate marker position (maybe not used for this line!) */
+    if (window->buffer->time_for_each_line && line->data->str_time)
+        read_marker_x = x + gui_chat_strlen_screen (line->data->str_time);
+    else
+        read_marker_x = x;
+    read_marker_y = y;
+
+    /*
+     * display time, prefix and message; when simulating, the number of lines
+     * is taken from the layout cached in the line if it is still valid
+     */
+    if (simulate)
+    {
+        layout_flags = gui_chat_line_layout_flags (window, line,
+                                                   pre_lines_displayed);
+        layout_num_lines = gui_chat_line_layout_get (window, line,
+                                                     layout_flags);
+        if (layout_num_lines >= 0)
+        {
+            lines_displayed += layout_num_lines;
+            window->win_chat_cursor_y += layout_num_lines;
+            window->win_chat_cursor_x = 0;
+        }
+        else
+        {
+            layout_num_lines = lines_displayed;
+            gui_chat_display_line_message (window, line, num_lines, count,
+                                           pre_lines_displayed,
+                                           &lines_displayed, simulate);
+            gui_chat_line_layout_set (window, line, layout_flags,
+                                      lines_displayed - layout_num_lines);
+        }
+    }
+    else
+    {
+        gui_chat_display_line_message (window, line, num_lines, count,
+                                       pre_lines_displayed, &lines_displayed,
+                                       simulate);
+    }
 
     /* display message if day has changed after this line */
     if ((line->data->date != 0)
@@ -2146,6 +2291,13 @@ gui_chat_draw (struct t_gui_buffer *buffer, int clear_chat)
             && (ptr_win->win_chat_x >= 0) && (ptr_win->win_chat_y >= 0)
             && (GUI_WINDOW_OBJECTS(ptr_win)->win_chat))
         {
+            /* inactive window: refresh it when it becomes current window */
+            if (!gui_window_chat_refresh_allowed (ptr_win))
+            {
+                ptr_win->refresh_needed = 1;
+                continue;
+            }
+
             gui_window_coords_alloc (ptr_win);
 
             gui_chat_reset_style (ptr_win, NULL, 0, 1,
@@ -2186,7 +2338,7 @@ gui_chat_draw (struct t_gui_buffer *buffer, int clear_chat)
         }
     }
 
-    refresh ();
+    gui_window_frame_stage ();
 
     if (buffer->type == GUI_BUFFER_TYPE_FREE)
     {
@@ -33,6 +33,7 @@
 #include "../../core/weechat.h"
 #include "../../core/wee-command.h"
 #include "../../core/wee-config.h"
+#include "../../core/wee-debug.h"
 #include "../../core/wee-hook.h"
 #include "../../core/wee-log.h"
 #include "../../core/wee-string.h"
@@ -56,6 +57,7 @@
 #include "../gui-history.h"
 #include "../gui-mouse.h"
 #include "../gui-nicklist.h"
+#include "../gui-search.h"
 #include "../gui-window.h"
 #include "gui-curses.h"
 
@@ -405,7 +407,8 @@ gui_main_refreshes ()
     /* refresh windows if needed */
     for (ptr_win = gui_windows; ptr_win; ptr_win = ptr_win->next_window)
     {
-        if (ptr_win->refresh_needed)
+        if (ptr_win->refresh_needed
+            && gui_window_chat_refresh_allowed (ptr_win))
         {
             gui_window_switch_to_buffer (ptr_win, ptr_win->buffer, 0);
             gui_chat_draw (ptr_win->buffer, 1);
@@ -472,8 +475,11 @@ gui_main_loop ()
 
     while (!weechat_quit)
     {
+        debug_loop_start ();
+
         /* execute timer hooks */
         hook_timer_exec ();
+        debug_loop_mark (DEBUG_LOOP_PHASE_TIMERS);
 
         /* auto reset of color pairs */
         if (gui_color_pairs_auto_reset)
@@ -491,9 +497,23 @@ gui_main_loop ()
             send_signal_sigwinch = 1;
         }
 
-        gui_main_refreshes ();
-        if (gui_window_refresh_needed && !gui_window_bare_display)
+        /*
+         * refresh screen (changes are sent to terminal in a single update,
+         * delayed if the max number of updates per second is reached)
+         */
+        if (gui_window_frame_get_delay () == 0)
+        {
+            gui_window_frame_delayed = 0;
             gui_main_refreshes ();
+            if (gui_window_refresh_needed && !gui_window_bare_display)
+                gui_main_refreshes ();
+            gui_window_frame_update ();
+        }
+        else
+        {
+            gui_window_frame_delayed = 1;
+            gui_window_frame_delayed_count++;
+        }
 
         if (send_signal_sigwinch)
         {
@@ -503,12 +523,23 @@ gui_main_loop ()
         }
 
         gui_color_pairs_auto_reset_pending = 0;
+        debug_loop_mark (DEBUG_LOOP_PHASE_REFRESH);
 
         /* execute fd hooks */
         hook_fd_exec ();
 
+        /* deliver batches of print/signal events */
+        hook_batch_exec ();
+        debug_loop_mark (DEBUG_LOOP_PHASE_FD);
+
         /* run process (with fork) */
         hook_process_exec ();
+        debug_loop_mark (DEBUG_LOOP_PHASE_PROCESS);
+
+        /* remove hooks marked as deleted (not yet removed by unhook) */
+        hook_remove_deleted (1);
+
+        debug_loop_end ();
 
         /* handle signals received */
         if (weechat_quit_signal > 0)
@@ -556,6 +587,9 @@ gui_main_end (int clean_exit)
         /* remove filters */
         gui_filter_free_all ();
 
+        /* stop searches */
+        gui_search_end ();
+
         /* free clipboard buffer */
         if (gui_input_clipboard)
             free (gui_input_clipboard);
@@ -31,6 +31,7 @@
 #include <stdarg.h>
 #include <libgen.h>
 #include <sys/ioctl.h>
+#include <sys/time.h>
 #include <termios.h>
 
 #include "../../core/weechat.h"
@@ -2631,8 +2632,93 @@ gui_window_move_cursor ()
     if (gui_cursor_mode)
     {
         move (gui_cursor_y, gui_cursor_x);
-        refresh ();
+        gui_window_frame_stage ();
+    }
+}
+
+/*
+ * Stages changes done on the screen: they are sent to the terminal on next
+ * screen update (see function gui_window_frame_update).
+ */
+
+void
+gui_window_frame_stage ()
+{
+    wnoutrefresh (stdscr);
+    gui_window_frame_pending = 1;
+}
+
+/*
+ * Returns the number of bytes written by WeeChat process since its start,
+ * -1 if unknown (read in file /proc/self/io, available only on Linux).
+ */
+
+long long
+gui_window_get_bytes_written ()
+{
+    FILE *file;
+    char line[128];
+    long long bytes;
+
+    file = fopen ("/proc/self/io", "r");
+    if (!file)
+        return -1;
+
+    bytes = -1;
+    while (fgets (line, sizeof (line), file))
+    {
+        if (strncmp (line, "wchar:", 6) == 0)
+        {
+            bytes = atoll (line + 6);
+            break;
+        }
     }
+
+    fclose (file);
+
+    return bytes;
+}
+
+/*
+ * Sends all changes staged on the screen to the terminal (if there are some),
+ * in a single update.
+ *
+ * The bytes sent to the terminal are measured only if debug is enabled for
+ * core (two reads of /proc/self/io per update).
+ */
+
+void
+gui_window_frame_update ()
+{
+    long long bytes_before, bytes_after;
+
+    if (!gui_window_frame_pending)
+        return;
+
+    bytes_before = -1;
+    if (!weechat_headless && (weechat_debug_core >= 1)
+        && (gui_window_frame_bytes >= 0))
+    {
+        bytes_before = gui_window_get_bytes_written ();
+        if (bytes_before < 0)
+            gui_window_frame_bytes = -1;
+    }
+
+    doupdate ();
+
+    if (bytes_before >= 0)
+    {
+        bytes_after = gui_window_get_bytes_written ();
+        if (bytes_after >= bytes_before)
+        {
+            gui_window_frame_bytes += bytes_after - bytes_before;
+            gui_window_frame_bytes_count++;
+        }
+    }
+
+    gui_window_frame_count++;
+    gettimeofday (&gui_window_frame_last, NULL);
+    gui_window_frame_pending = 0;
 }
 
 /*
@@ -144,5 +144,6 @@ extern void gui_window_hline (WINDOW *window, int x, int y, int width,
 extern void gui_window_vline (WINDOW *window, int x, int y, int height,
                               const char *string);
 extern void gui_window_set_title (const char *title);
+extern long long gui_window_get_bytes_written ();
 
 #endif /* WEECHAT_GUI_CURSES_H */
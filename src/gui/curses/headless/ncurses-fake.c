@@ -208,6 +208,12 @@ wnoutrefresh (WINDOW *win)
     return OK;
 }
 
+int
+doupdate ()
+{
+    return OK;
+}
+
 int
 wclrtoeol (WINDOW *win)
 {
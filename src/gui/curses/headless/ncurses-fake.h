@@ -101,6 +101,7 @@ extern int wclrtobot (WINDOW *win);
 extern int refresh ();
 extern int wrefresh (WINDOW *win);
 extern int wnoutrefresh (WINDOW *win);
+extern int doupdate ();
 extern int wclrtoeol (WINDOW *win);
 extern int mvwprintw (WINDOW *win, int y, int x, const char *fmt, ...);
 extern int init_pair (short pair, short f, short b);
@@ -563,6 +563,7 @@ gui_bar_item_new (struct t_weechat_plugin *plugin, const char *name,
             gui_bar_items = new_bar_item;
         last_gui_bar_item = new_bar_item;
         new_bar_item->next_item = NULL;
+        hdata_registry_add ("bar_item", new_bar_item);
 
         return new_bar_item;
     }
@@ -685,6 +686,7 @@ gui_bar_item_free (struct t_gui_bar_item *item)
         gui_bar_items = item->next_item;
     if (last_gui_bar_item == item)
         last_gui_bar_item = item->prev_item;
+    hdata_registry_remove ("bar_item", item);
 
     /* free data */
     if (item->name)
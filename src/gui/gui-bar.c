@@ -290,6 +290,7 @@ gui_bar_insert (struct t_gui_bar *bar)
         gui_bars = bar;
         last_gui_bar = bar;
     }
+    hdata_registry_add ("bar", bar);
 }
 
 /*
@@ -2175,6 +2176,7 @@ gui_bar_free (struct t_gui_bar *bar)
         gui_bars = bar->next_bar;
     if (last_gui_bar == bar)
         last_gui_bar = bar->prev_bar;
+    hdata_registry_remove ("bar", bar);
 
     /* free data */
     if (bar->name)
@@ -224,6 +224,9 @@ gui_buffer_build_full_name (struct t_gui_buffer *buffer)
         snprintf (buffer->full_name, length, "%s.%s",
                   gui_buffer_get_plugin_name (buffer), buffer->name);
     }
+
+    /* filters matching the buffer may be different with the new name */
+    buffer->filters_cache_generation = 0;
 }
 
 /*
@@ -704,6 +707,8 @@ gui_buffer_new (struct t_weechat_plugin *plugin,
     new_buffer->day_change = 1;
     new_buffer->clear = 1;
     new_buffer->filter = 1;
+    new_buffer->filters_cache = NULL;
+    new_buffer->filters_cache_generation = 0;
 
     /* close callback */
     new_buffer->close_callback = close_callback;
@@ -731,6 +736,7 @@ gui_buffer_new (struct t_weechat_plugin *plugin,
     new_buffer->nicklist_groups_count = 0;
     new_buffer->nicklist_nicks_count = 0;
     new_buffer->nicklist_visible_count = 0;
+    new_buffer->nicklist_last_id = 0;
     new_buffer->nickcmp_callback = NULL;
     new_buffer->nickcmp_callback_pointer = NULL;
     new_buffer->nickcmp_callback_data = NULL;
@@ -815,6 +821,7 @@ gui_buffer_new (struct t_weechat_plugin *plugin,
     /* add buffer to buffers list */
     first_buffer_creation = (gui_buffers == NULL);
     gui_buffer_insert (new_buffer);
+    hdata_registry_add ("buffer", new_buffer);
 
     gui_buffers_count++;
 
@@ -1315,6 +1322,10 @@ gui_buffer_set_name (struct t_gui_buffer *buffer, const char *name)
 
     gui_buffer_build_full_name (buffer);
 
+    /* name is displayed on merged buffers if there's no short name */
+    if (buffer->mixed_lines && !buffer->short_name)
+        gui_chat_layout_changed ();
+
     gui_buffer_local_var_add (buffer, "name", name);
 
     (void) hook_signal_send ("buffer_renamed",
@@ -1354,7 +1365,10 @@ gui_buffer_set_short_name (struct t_gui_buffer *buffer, const char *short_name)
         strdup (short_name) : NULL;
 
     if (buffer->mixed_lines)
+    {
         buffer->mixed_lines->buffer_max_length_refresh = 1;
+        gui_chat_layout_changed ();
+    }
     gui_buffer_ask_chat_refresh (buffer, 1);
 
     (void) hook_signal_send ("buffer_renamed",
@@ -2905,6 +2919,8 @@ gui_buffer_close (struct t_gui_buffer *buffer)
         free (buffer->full_name);
     if (buffer->old_full_name)
         free (buffer->old_full_name);
+    if (buffer->filters_cache)
+        free (buffer->filters_cache);
     if (buffer->short_name)
         free (buffer->short_name);
     if (buffer->title)
@@ -2953,6 +2969,7 @@ gui_buffer_close (struct t_gui_buffer *buffer)
         gui_buffers = buffer->next_buffer;
     if (last_gui_buffer == buffer)
         last_gui_buffer = buffer->prev_buffer;
+    hdata_registry_remove ("buffer", buffer);
 
     for (ptr_window = gui_windows; ptr_window;
          ptr_window = ptr_window->next_window)
@@ -4281,6 +4298,7 @@ gui_buffer_hdata_buffer_cb (const void *pointer, void *data,
         HDATA_VAR(struct t_gui_buffer, nicklist_groups_count, INTEGER, 0, NULL, NULL);
         HDATA_VAR(struct t_gui_buffer, nicklist_nicks_count, INTEGER, 0, NULL, NULL);
         HDATA_VAR(struct t_gui_buffer, nicklist_visible_count, INTEGER, 0, NULL, NULL);
+        HDATA_VAR(struct t_gui_buffer, nicklist_last_id, LONG, 0, NULL, NULL);
         HDATA_VAR(struct t_gui_buffer, nickcmp_callback, POINTER, 0, NULL, NULL);
         HDATA_VAR(struct t_gui_buffer, nickcmp_callback_pointer, POINTER, 0, NULL, NULL);
         HDATA_VAR(struct t_gui_buffer, nickcmp_callback_data, POINTER, 0, NULL, NULL);
@@ -4582,7 +4600,8 @@ gui_buffer_dump_hexa (struct t_gui_buffer *buffer)
             free (message_without_colors);
         tags = string_build_with_split_string ((const char **)ptr_line->data->tags_array,
                                                ",");
-        log_printf ("  tags: '%s', displayed: %d, highlight: %d",
+        log_printf ("  id: %ld, tags: '%s', displayed: %d, highlight: %d",
+                    ptr_line->data->id,
                     (tags) ? tags : "(none)",
                     ptr_line->data->displayed,
                     ptr_line->data->highlight);
@@ -4675,6 +4694,8 @@ gui_buffer_print_log ()
         log_printf ("  day_change. . . . . . . : %d",    ptr_buffer->day_change);
         log_printf ("  clear . . . . . . . . . : %d",    ptr_buffer->clear);
         log_printf ("  filter. . . . . . . . . : %d",    ptr_buffer->filter);
+        log_printf ("  filters_cache . . . . . : 0x%lx", ptr_buffer->filters_cache);
+        log_printf ("  filters_cache_generation: %d",    ptr_buffer->filters_cache_generation);
         log_printf ("  close_callback. . . . . : 0x%lx", ptr_buffer->close_callback);
         log_printf ("  close_callback_pointer. : 0x%lx", ptr_buffer->close_callback_pointer);
         log_printf ("  close_callback_data . . : 0x%lx", ptr_buffer->close_callback_data);
@@ -4696,6 +4717,7 @@ gui_buffer_print_log ()
         log_printf ("  nicklist_groups_count . : %d",    ptr_buffer->nicklist_groups_count);
         log_printf ("  nicklist_nicks_count. . : %d",    ptr_buffer->nicklist_nicks_count);
         log_printf ("  nicklist_visible_count. : %d",    ptr_buffer->nicklist_visible_count);
+        log_printf ("  nicklist_last_id. . . . : %ld",   ptr_buffer->nicklist_last_id);
         log_printf ("  nickcmp_callback. . . . : 0x%lx", ptr_buffer->nickcmp_callback);
         log_printf ("  nickcmp_callback_pointer: 0x%lx", ptr_buffer->nickcmp_callback_pointer);
         log_printf ("  nickcmp_callback_data . : 0x%lx", ptr_buffer->nickcmp_callback_data);
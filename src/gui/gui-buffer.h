@@ -25,6 +25,7 @@
 
 struct t_hashtable;
 struct t_gui_window;
+struct t_gui_filter;
 struct t_infolist;
 
 enum t_gui_buffer_type
@@ -105,6 +106,10 @@ struct t_gui_buffer
     int clear;                         /* 1 if clear of buffer is allowed   */
                                        /* with command /buffer clear        */
     int filter;                        /* 1 if filters enabled for buffer   */
+    struct t_gui_filter **filters_cache; /* filters matching buffer name    */
+                                       /* (NULL-terminated array)           */
+    int filters_cache_generation;      /* generation of filters when cache  */
+                                       /* was built (0 = cache invalid)     */
 
     /* close callback */
     int (*close_callback)(const void *pointer, /* called when buffer is     */
@@ -136,6 +141,8 @@ struct t_gui_buffer
     int nicklist_groups_count;         /* number of groups                  */
     int nicklist_nicks_count;          /* number of nicks                   */
     int nicklist_visible_count;        /* number of nicks/groups to display */
+    long nicklist_last_id;             /* id of last line when nicklist was */
+                                       /* changed                           */
     int (*nickcmp_callback)(const void *pointer, /* called to compare nicks */
                             void *data,          /* (search in nicklist)    */
                             struct t_gui_buffer *buffer,
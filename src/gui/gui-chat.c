@@ -57,6 +57,8 @@ struct t_gui_buffer *gui_chat_mute_buffer = NULL; /* mute buffer            */
 int gui_chat_display_tags = 0;                  /* display tags?            */
 char **gui_chat_lines_waiting_buffer = NULL;    /* lines waiting for core   */
                                                 /* buffer                   */
+int gui_chat_layout_generation = 1;             /* generation of layout of  */
+                                                /* lines (cached in lines)  */
 
 
 /*
@@ -88,6 +90,10 @@ gui_chat_init ()
                   &gui_chat_hsignal_quote_line_cb, NULL, NULL);
     hook_hsignal (NULL, "chat_quote_message",
                   &gui_chat_hsignal_quote_line_cb, NULL, NULL);
+
+    /* invalidate layout of lines when a "look" option is changed */
+    hook_config (NULL, "weechat.look.*",
+                 &gui_chat_config_look_cb, NULL, NULL);
 }
 
 /*
@@ -1129,6 +1135,38 @@ end:
     free (vbuffer);
 }
 
+/*
+ * Invalidates the layout cached in all lines (number of lines on screen for
+ * each line), so that it is computed again on next display.
+ */
+
+void
+gui_chat_layout_changed ()
+{
+    gui_chat_layout_generation++;
+    if (gui_chat_layout_generation <= 0)
+        gui_chat_layout_generation = 1;
+}
+
+/*
+ * Callback for changes on options "weechat.look.*".
+ */
+
+int
+gui_chat_config_look_cb (const void *pointer, void *data,
+                         const char *option, const char *value)
+{
+    /* make C compiler happy */
+    (void) pointer;
+    (void) data;
+    (void) option;
+    (void) value;
+
+    gui_chat_layout_changed ();
+
+    return WEECHAT_RC_OK;
+}
+
 /*
  * Quotes a line.
  */
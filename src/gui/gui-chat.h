@@ -63,6 +63,7 @@ extern int gui_chat_time_length;
 extern int gui_chat_mute;
 extern struct t_gui_buffer *gui_chat_mute_buffer;
 extern int gui_chat_display_tags;
+extern int gui_chat_layout_generation;
 
 /* chat functions */
 
@@ -95,6 +96,9 @@ extern void gui_chat_printf_date_tags (struct t_gui_buffer *buffer,
 extern void gui_chat_printf_y (struct t_gui_buffer *buffer, int y,
                                const char *message, ...);
 extern void gui_chat_print_lines_waiting_buffer (FILE *f);
+extern void gui_chat_layout_changed ();
+extern int gui_chat_config_look_cb (const void *pointer, void *data,
+                                    const char *option, const char *value);
 extern int gui_chat_hsignal_quote_line_cb (const void *pointer, void *data,
                                            const char *signal,
                                            struct t_hashtable *hashtable);
@@ -27,6 +27,8 @@
 #include <stddef.h>
 #include <string.h>
 #include <regex.h>
+#include <signal.h>
+#include <pthread.h>
 
 #include "../core/weechat.h"
 #include "../core/wee-config.h"
@@ -46,11 +48,155 @@
 struct t_gui_filter *gui_filters = NULL;           /* first filter          */
 struct t_gui_filter *last_gui_filter = NULL;       /* last filter           */
 int gui_filters_enabled = 1;                       /* filters enabled?      */
+int gui_filters_generation = 1;                    /* incremented when      */
+                                                   /* filters are changed   */
 
+/* queue of lines to check in threads */
+struct t_gui_filter_queue
+{
+    struct t_gui_line_data **lines;      /* lines to check                  */
+    char *displayed;                     /* result for each line            */
+    int count;                           /* number of lines                 */
+    int next;                            /* next line to check              */
+    pthread_mutex_t mutex;               /* mutex to get next lines         */
+};
+
+
+/*
+ * Updates the cache of filters matching a buffer (if filters or buffer name
+ * have changed since the cache was built).
+ *
+ * Returns:
+ *   1: cache is OK
+ *   0: cache can not be used (not enough memory)
+ */
+
+int
+gui_filter_buffer_update_cache (struct t_gui_buffer *buffer)
+{
+    struct t_gui_filter *ptr_filter, **new_cache;
+    int count;
+
+    if (buffer->filters_cache
+        && (buffer->filters_cache_generation == gui_filters_generation))
+    {
+        return 1;
+    }
+
+    count = 0;
+    for (ptr_filter = gui_filters; ptr_filter;
+         ptr_filter = ptr_filter->next_filter)
+    {
+        count++;
+    }
+
+    new_cache = realloc (buffer->filters_cache,
+                         (count + 1) * sizeof (buffer->filters_cache[0]));
+    if (!new_cache)
+    {
+        buffer->filters_cache_generation = 0;
+        return 0;
+    }
+    buffer->filters_cache = new_cache;
+
+    count = 0;
+    for (ptr_filter = gui_filters; ptr_filter;
+         ptr_filter = ptr_filter->next_filter)
+    {
+        if (string_match_list (buffer->full_name,
+                               (const char **)ptr_filter->buffers,
+                               0))
+        {
+            buffer->filters_cache[count++] = ptr_filter;
+        }
+    }
+    buffer->filters_cache[count] = NULL;
+    buffer->filters_cache_generation = gui_filters_generation;
+
+    return 1;
+}
+
+/*
+ * Checks if a filter matches a buffer.
+ *
+ * If filter is NULL, any buffer is matching.
+ *
+ * Returns:
+ *   1: filter matches buffer
+ *   0: filter does not match buffer
+ */
+
+int
+gui_filter_match_buffer (struct t_gui_filter *filter,
+                         struct t_gui_buffer *buffer)
+{
+    int i;
+
+    if (!filter)
+        return 1;
+
+    if (!gui_filter_buffer_update_cache (buffer))
+    {
+        return string_match_list (buffer->full_name,
+                                  (const char **)filter->buffers, 0);
+    }
+
+    for (i = 0; buffer->filters_cache[i]; i++)
+    {
+        if (buffer->filters_cache[i] == filter)
+            return 1;
+    }
+
+    return 0;
+}
+
+/*
+ * Checks if a line is hidden by a filter (buffer is not checked).
+ *
+ * Returns:
+ *   1: line is hidden by filter
+ *   0: line is not hidden by filter
+ */
+
+int
+gui_filter_hides_line (struct t_gui_filter *filter,
+                       struct t_gui_line_data *line_data)
+{
+    int rc;
+
+    if (!filter->enabled)
+        return 0;
+
+    if ((strcmp (filter->tags, "*") != 0)
+        && !gui_line_match_tags (line_data,
+                                 filter->tags_count,
+                                 filter->tags_array))
+    {
+        return 0;
+    }
+
+    /* check line with regex */
+    rc = 1;
+    if (!filter->regex_prefix && !filter->regex_message)
+        rc = 0;
+    if (gui_line_match_regex (line_data,
+                              filter->regex_prefix,
+                              filter->regex_message))
+    {
+        rc = 0;
+    }
+    if (filter->regex && (filter->regex[0] == '!'))
+        rc ^= 1;
+
+    return (rc == 0) ? 1 : 0;
+}
 
 /*
  * Checks if a line must be displayed or not (filtered).
  *
+ * Only filters matching the buffer are checked (they are cached in the
+ * buffer, see function gui_filter_buffer_update_cache).
+ *
  * Returns:
  *   1: line must be displayed (not filtered)
  *   0: line must be hidden (filtered)
@@ -60,7 +206,7 @@ int
 gui_filter_check_line (struct t_gui_line_data *line_data)
 {
     struct t_gui_filter *ptr_filter;
-    int rc;
+    int i;
 
     /* line is always displayed if filters are disabled (globally or in buffer) */
     if (!gui_filters_enabled || !line_data->buffer->filter)
@@ -69,36 +215,28 @@ gui_filter_check_line (struct t_gui_line_data *line_data)
     if (gui_line_has_tag_no_filter (line_data))
         return 1;
 
-    for (ptr_filter = gui_filters; ptr_filter;
-         ptr_filter = ptr_filter->next_filter)
+    if (gui_filter_buffer_update_cache (line_data->buffer))
     {
-        if (ptr_filter->enabled)
+        for (i = 0; line_data->buffer->filters_cache[i]; i++)
+        {
+            if (gui_filter_hides_line (line_data->buffer->filters_cache[i],
+                                       line_data))
+            {
+                return 0;
+            }
+        }
+    }
+    else
+    {
+        for (ptr_filter = gui_filters; ptr_filter;
+             ptr_filter = ptr_filter->next_filter)
         {
-            /* check buffer */
             if (string_match_list (line_data->buffer->full_name,
                                    (const char **)ptr_filter->buffers,
-                                   0))
+                                   0)
+                && gui_filter_hides_line (ptr_filter, line_data))
             {
-                if ((strcmp (ptr_filter->tags, "*") == 0)
-                    || (gui_line_match_tags (line_data,
-                                             ptr_filter->tags_count,
-                                             ptr_filter->tags_array)))
-                {
-                    /* check line with regex */
-                    rc = 1;
-                    if (!ptr_filter->regex_prefix && !ptr_filter->regex_message)
-                        rc = 0;
-                    if (gui_line_match_regex (line_data,
-                                              ptr_filter->regex_prefix,
-                                              ptr_filter->regex_message))
-                    {
-                        rc = 0;
-                    }
-                    if (ptr_filter->regex && (ptr_filter->regex[0] == '!'))
-                        rc ^= 1;
-                    if (rc == 0)
-                        return 0;
-                }
+                return 0;
             }
         }
     }
@@ -108,34 +246,131 @@ gui_filter_check_line (struct t_gui_line_data *line_data)
 }
 
 /*
- * Filters a buffer, using message filters.
+ * Checks lines of the queue, until the queue is empty.
+ *
+ * This function runs in threads (and in main thread): it must only read
+ * lines and filters (cache of filters in buffers must be up-to-date before
+ * threads are started).
+ */
+
+void *
+gui_filter_check_lines_thread (void *data)
+{
+    struct t_gui_filter_queue *queue;
+    int index, end;
+
+    queue = (struct t_gui_filter_queue *)data;
+
+    while (1)
+    {
+        pthread_mutex_lock (&queue->mutex);
+        index = queue->next;
+        queue->next += GUI_FILTER_THREADS_CHUNK_LINES;
+        pthread_mutex_unlock (&queue->mutex);
+
+        if (index >= queue->count)
+            break;
+
+        end = index + GUI_FILTER_THREADS_CHUNK_LINES;
+        if (end > queue->count)
+            end = queue->count;
+        for (; index < end; index++)
+        {
+            queue->displayed[index] = (char)gui_filter_check_line (
+                queue->lines[index]);
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * Checks lines of the queue in threads (at most GUI_FILTER_THREADS_MAX
+ * threads, including main thread).
+ */
+
+void
+gui_filter_check_lines (struct t_gui_filter_queue *queue)
+{
+    pthread_t threads[GUI_FILTER_THREADS_MAX];
+    sigset_t set, old_set;
+    int i, num_threads;
+
+    queue->next = 0;
+    pthread_mutex_init (&queue->mutex, NULL);
+
+    /* start threads (signals are blocked in them), main thread works too */
+    num_threads = 0;
+    sigfillset (&set);
+    pthread_sigmask (SIG_SETMASK, &set, &old_set);
+    for (i = 1;
+         (i < GUI_FILTER_THREADS_MAX)
+             && (i * GUI_FILTER_THREADS_CHUNK_LINES < queue->count);
+         i++)
+    {
+        if (pthread_create (&threads[num_threads], NULL,
+                            &gui_filter_check_lines_thread, queue) == 0)
+        {
+            num_threads++;
+        }
+    }
+    pthread_sigmask (SIG_SETMASK, &old_set, NULL);
+
+    gui_filter_check_lines_thread (queue);
+
+    for (i = 0; i < num_threads; i++)
+    {
+        pthread_join (threads[i], NULL);
+    }
+
+    pthread_mutex_destroy (&queue->mutex);
+}
+
+/*
+ * Sets flag "displayed" in lines of a buffer, using message filters.
  *
  * If line_data is NULL, filters all lines in buffer.
  * If line_data is not NULL, filters only this line_data.
+ *
+ * If displayed is not NULL, it contains the result of the check for each
+ * line of buffer (lines are not checked again).
+ *
+ * Flags "lines_changed" and "hidden_changed" are set to 1 if at least one
+ * line has changed and if the number of hidden lines has changed.
+ *
+ * No callback is called by this function (see function
+ * gui_filter_buffer_refresh).
+ *
+ * Returns the number of lines filtered.
  */
 
-void
-gui_filter_buffer (struct t_gui_buffer *buffer,
-                   struct t_gui_line_data *line_data)
+int
+gui_filter_buffer_lines (struct t_gui_buffer *buffer,
+                         struct t_gui_line_data *line_data,
+                         const char *displayed,
+                         int *lines_changed, int *hidden_changed)
 {
     struct t_gui_line *ptr_line;
     struct t_gui_line_data *ptr_line_data;
-    struct t_gui_window *ptr_window;
-    int lines_changed, line_displayed, lines_hidden;
+    int line_displayed, lines_hidden, count;
 
-    lines_changed = 0;
+    *lines_changed = 0;
+    *hidden_changed = 0;
     lines_hidden = buffer->lines->lines_hidden;
+    count = 0;
 
     ptr_line = buffer->lines->first_line;
     while (ptr_line || line_data)
     {
         ptr_line_data = (line_data) ? line_data : ptr_line->data;
 
-        line_displayed = gui_filter_check_line (ptr_line_data);
+        line_displayed = (displayed) ?
+            displayed[count] : gui_filter_check_line (ptr_line_data);
+        count++;
 
         if (ptr_line_data->displayed != line_displayed)
         {
-            lines_changed = 1;
+            *lines_changed = 1;
             lines_hidden += (line_displayed) ? -1 : 1;
         }
 
@@ -155,6 +390,24 @@ gui_filter_buffer (struct t_gui_buffer *buffer,
     if (buffer->lines->lines_hidden != lines_hidden)
     {
         buffer->lines->lines_hidden = lines_hidden;
+        *hidden_changed = 1;
+    }
+
+    return count;
+}
+
+/*
+ * Refreshes a buffer after lines have been filtered.
+ */
+
+void
+gui_filter_buffer_refresh (struct t_gui_buffer *buffer,
+                           int lines_changed, int hidden_changed)
+{
+    struct t_gui_window *ptr_window;
+
+    if (hidden_changed)
+    {
         (void) hook_signal_send ("buffer_lines_hidden",
                                  WEECHAT_HOOK_SIGNAL_POINTER, buffer);
     }
@@ -184,28 +437,141 @@ gui_filter_buffer (struct t_gui_buffer *buffer,
     }
 }
 
+/*
+ * Filters a buffer, using message filters.
+ *
+ * If line_data is NULL, filters all lines in buffer.
+ * If line_data is not NULL, filters only this line_data.
+ */
+
+void
+gui_filter_buffer (struct t_gui_buffer *buffer,
+                   struct t_gui_line_data *line_data)
+{
+    int lines_changed, hidden_changed;
+
+    gui_filter_buffer_lines (buffer, line_data, NULL,
+                             &lines_changed, &hidden_changed);
+    gui_filter_buffer_refresh (buffer, lines_changed, hidden_changed);
+}
+
 /*
  * Filters all buffers, using message filters.
  *
  * If filter is NULL, filters all buffers.
  * If filter is not NULL, filters only buffers matched by this filter.
+ *
+ * If there are many lines to check, they are checked in threads (by chunks
+ * of lines), then the result is applied on all buffers in main thread,
+ * before buffers are refreshed (and signals sent).
  */
 
 void
 gui_filter_all_buffers (struct t_gui_filter *filter)
 {
-    struct t_gui_buffer *ptr_buffer;
+    struct t_gui_buffer *ptr_buffer, **buffers;
+    struct t_gui_line *ptr_line;
+    struct t_gui_filter_queue queue;
+    char *changed;
+    int i, index, num_buffers, lines_changed, hidden_changed;
 
+    /* count lines to check (and update cache of filters in buffers) */
+    memset (&queue, 0, sizeof (queue));
+    num_buffers = 0;
     for (ptr_buffer = gui_buffers; ptr_buffer;
          ptr_buffer = ptr_buffer->next_buffer)
     {
-        if (!filter
-            || string_match_list (ptr_buffer->full_name,
-                                  (const char **)filter->buffers, 0))
+        if (gui_filter_match_buffer (filter, ptr_buffer))
+        {
+            gui_filter_buffer_update_cache (ptr_buffer);
+            queue.count += ptr_buffer->lines->lines_count;
+            num_buffers++;
+        }
+    }
+
+    buffers = NULL;
+    changed = NULL;
+    if (queue.count >= GUI_FILTER_THREADS_MIN_LINES)
+    {
+        queue.lines = malloc (queue.count * sizeof (queue.lines[0]));
+        queue.displayed = malloc (queue.count * sizeof (queue.displayed[0]));
+        buffers = malloc (num_buffers * sizeof (buffers[0]));
+        changed = malloc (num_buffers * 2 * sizeof (changed[0]));
+    }
+
+    if (!queue.lines || !queue.displayed || !buffers || !changed)
+    {
+        for (ptr_buffer = gui_buffers; ptr_buffer;
+             ptr_buffer = ptr_buffer->next_buffer)
         {
-            gui_filter_buffer (ptr_buffer, NULL);
+            if (gui_filter_match_buffer (filter, ptr_buffer))
+                gui_filter_buffer (ptr_buffer, NULL);
         }
+        goto end;
     }
+
+    /* build list of lines (in same order as they are filtered below) */
+    index = 0;
+    num_buffers = 0;
+    for (ptr_buffer = gui_buffers; ptr_buffer;
+         ptr_buffer = ptr_buffer->next_buffer)
+    {
+        if (gui_filter_match_buffer (filter, ptr_buffer))
+        {
+            for (ptr_line = ptr_buffer->lines->first_line;
+                 ptr_line && (index < queue.count);
+                 ptr_line = ptr_line->next_line)
+            {
+                queue.lines[index++] = ptr_line->data;
+            }
+            buffers[num_buffers++] = ptr_buffer;
+        }
+    }
+    queue.count = index;
+
+    /* check lines in threads */
+    gui_filter_check_lines (&queue);
+
+    /* apply result on lines */
+    index = 0;
+    for (i = 0; i < num_buffers; i++)
+    {
+        if (index + buffers[i]->lines->lines_count <= queue.count)
+        {
+            index += gui_filter_buffer_lines (buffers[i], NULL,
+                                              queue.displayed + index,
+                                              &lines_changed,
+                                              &hidden_changed);
+        }
+        else
+        {
+            gui_filter_buffer_lines (buffers[i], NULL, NULL,
+                                     &lines_changed, &hidden_changed);
+        }
+        changed[i * 2] = (char)lines_changed;
+        changed[(i * 2) + 1] = (char)hidden_changed;
+    }
+
+    /* refresh buffers (callbacks may close buffers) */
+    for (i = 0; i < num_buffers; i++)
+    {
+        if (gui_buffer_valid (buffers[i]))
+        {
+            gui_filter_buffer_refresh (buffers[i],
+                                       changed[i * 2],
+                                       changed[(i * 2) + 1]);
+        }
+    }
+
+end:
+    if (queue.lines)
+        free (queue.lines);
+    if (queue.displayed)
+        free (queue.displayed);
+    if (buffers)
+        free (buffers);
+    if (changed)
+        free (changed);
 }
 
 /*
@@ -420,6 +786,8 @@ gui_filter_new (int enabled, const char *name, const char *buffer_name,
         last_gui_filter = new_filter;
         new_filter->next_filter = NULL;
 
+        gui_filters_generation++;
+
         (void) hook_signal_send ("filter_added",
                                  WEECHAT_HOOK_SIGNAL_POINTER, new_filter);
     }
@@ -451,6 +819,8 @@ gui_filter_rename (struct t_gui_filter *filter, const char *new_name)
     free (filter->name);
     filter->name = strdup (new_name);
 
+    gui_filters_generation++;
+
     return 1;
 }
 
@@ -503,6 +873,8 @@ gui_filter_free (struct t_gui_filter *filter)
 
     free (filter);
 
+    gui_filters_generation++;
+
     (void) hook_signal_send ("filter_removed", WEECHAT_HOOK_SIGNAL_STRING, NULL);
 }
 
@@ -622,6 +994,7 @@ gui_filter_print_log ()
 
     log_printf ("");
     log_printf ("gui_filters_enabled = %d", gui_filters_enabled);
+    log_printf ("gui_filters_generation = %d", gui_filters_generation);
 
     for (ptr_filter = gui_filters; ptr_filter;
          ptr_filter = ptr_filter->next_filter)
@@ -24,8 +24,14 @@
 
 #define GUI_FILTER_TAG_NO_FILTER "no_filter"
 
+/* lines are filtered in threads if there are at least this number of lines */
+#define GUI_FILTER_THREADS_MIN_LINES 4096
+#define GUI_FILTER_THREADS_CHUNK_LINES 512
+#define GUI_FILTER_THREADS_MAX 4
+
 /* filter structures */
 
+struct t_gui_buffer;
 struct t_gui_line_data;
 
 struct t_gui_filter
@@ -50,9 +56,13 @@ struct t_gui_filter
 extern struct t_gui_filter *gui_filters;
 extern struct t_gui_filter *last_gui_filter;
 extern int gui_filters_enabled;
+extern int gui_filters_generation;
 
 /* filter functions */
 
+extern int gui_filter_buffer_update_cache (struct t_gui_buffer *buffer);
+extern int gui_filter_match_buffer (struct t_gui_filter *filter,
+                                    struct t_gui_buffer *buffer);
 extern int gui_filter_check_line (struct t_gui_line_data *line_data);
 extern void gui_filter_buffer (struct t_gui_buffer *buffer,
                                struct t_gui_line_data *line_data);
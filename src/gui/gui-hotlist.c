@@ -114,6 +114,7 @@ gui_hotlist_free (struct t_gui_hotlist **hotlist,
 
     if (ptr_hotlist->next_hotlist)
         (ptr_hotlist->next_hotlist)->prev_hotlist = ptr_hotlist->prev_hotlist;
+    hdata_registry_remove ("hotlist", ptr_hotlist);
 
     free (ptr_hotlist);
     *hotlist = new_hotlist;
@@ -281,6 +282,7 @@ gui_hotlist_add_hotlist (struct t_gui_hotlist **hotlist,
         *hotlist = new_hotlist;
         *last_hotlist = new_hotlist;
     }
+    hdata_registry_add ("hotlist", new_hotlist);
 }
 
 /*
@@ -47,6 +47,9 @@
 #include "gui-window.h"
 
 
+long gui_line_last_id = 0;             /* id of last line created           */
+
+
 /*
  * Allocates structure "t_gui_lines" and initializes it.
  *
@@ -468,6 +471,40 @@ gui_line_get_next_displayed (struct t_gui_line *line)
     return line;
 }
 
+/*
+ * Searches for text in a string (without color codes): with a regex if regex
+ * is not NULL, otherwise with a substring (case sensitive if exact is 1).
+ *
+ * Like functions strstr and string_strcasestr, an empty text is found in
+ * any string if exact is 1, and never found if exact is 0.
+ *
+ * This function can be called in threads (it does not use any global
+ * variable).
+ *
+ * Returns:
+ *   1: text found in string
+ *   0: text not found in string
+ */
+
+int
+gui_line_search_string (const char *string, const char *text, int exact,
+                        regex_t *regex)
+{
+    if (!string)
+        return 0;
+
+    if (regex)
+        return (regexec (regex, string, 0, NULL, 0) == 0) ? 1 : 0;
+
+    if (!text)
+        return 0;
+
+    if (exact)
+        return (strstr (string, text)) ? 1 : 0;
+
+    return (string_strcasestr (string, text)) ? 1 : 0;
+}
+
 /*
  * Searches for text in a line.
  *
@@ -480,6 +517,7 @@ int
 gui_line_search_text (struct t_gui_buffer *buffer, struct t_gui_line *line)
 {
     char *prefix, *message;
+    regex_t *regex;
     int rc;
 
     if (!line || !line->data->message
@@ -488,6 +526,14 @@ gui_line_search_text (struct t_gui_buffer *buffer, struct t_gui_line *line)
         return 0;
     }
 
+    regex = NULL;
+    if (buffer->text_search_regex)
+    {
+        if (!buffer->text_search_regex_compiled)
+            return 0;
+        regex = buffer->text_search_regex_compiled;
+    }
+
     rc = 0;
 
     if ((buffer->text_search_where & GUI_TEXT_SEARCH_IN_PREFIX)
@@ -496,24 +542,8 @@ gui_line_search_text (struct t_gui_buffer *buffer, struct t_gui_line *line)
         prefix = gui_color_decode (line->data->prefix, NULL);
         if (prefix)
         {
-            if (buffer->text_search_regex)
-            {
-                if (buffer->text_search_regex_compiled)
-                {
-                    if (regexec (buffer->text_search_regex_compiled,
-                                 prefix, 0, NULL, 0) == 0)
-                    {
-                        rc = 1;
-                    }
-                }
-            }
-            else if ((buffer->text_search_exact
-                      && (strstr (prefix, buffer->input_buffer)))
-                     || (!buffer->text_search_exact
-                         && (string_strcasestr (prefix, buffer->input_buffer))))
-            {
-                rc = 1;
-            }
+            rc = gui_line_search_string (prefix, buffer->input_buffer,
+                                         buffer->text_search_exact, regex);
             free (prefix);
         }
     }
@@ -523,24 +553,8 @@ gui_line_search_text (struct t_gui_buffer *buffer, struct t_gui_line *line)
         message = gui_color_decode (line->data->message, NULL);
         if (message)
         {
-            if (buffer->text_search_regex)
-            {
-                if (buffer->text_search_regex_compiled)
-                {
-                    if (regexec (buffer->text_search_regex_compiled,
-                                 message, 0, NULL, 0) == 0)
-                    {
-                        rc = 1;
-                    }
-                }
-            }
-            else if ((buffer->text_search_exact
-                      && (strstr (message, buffer->input_buffer)))
-                     || (!buffer->text_search_exact
-                         && (string_strcasestr (message, buffer->input_buffer))))
-            {
-                rc = 1;
-            }
+            rc = gui_line_search_string (message, buffer->input_buffer,
+                                         buffer->text_search_exact, regex);
             free (message);
         }
     }
@@ -1029,6 +1043,7 @@ gui_line_free_data (struct t_gui_line *line)
         string_shared_free (line->data->prefix);
     if (line->data->message)
         free (line->data->message);
+    hdata_registry_remove ("line_data", line->data);
     free (line->data);
 
     line->data = NULL;
@@ -1330,6 +1345,7 @@ gui_line_new (struct t_gui_buffer *buffer, int y, time_t date,
 
     /* fill data in new line */
     new_line->data->buffer = buffer;
+    new_line->data->id = ++gui_line_last_id;
     new_line->data->message = (message) ? strdup (message) : strdup ("");
 
     if (buffer->type == GUI_BUFFER_TYPE_FORMATTED)
@@ -1362,6 +1378,14 @@ gui_line_new (struct t_gui_buffer *buffer, int y, time_t date,
         new_line->data->highlight = 0;
     }
 
+    /* no layout computed yet for the line */
+    new_line->data->layout_generation = 0;
+    new_line->data->layout_width = 0;
+    new_line->data->layout_prefix_max_length = 0;
+    new_line->data->layout_buffer_max_length = 0;
+    new_line->data->layout_flags = 0;
+    new_line->data->layout_num_lines = 0;
+
     /* set display flag (check if line is filtered or not) */
     new_line->data->displayed = gui_filter_check_line (new_line->data);
 
@@ -1541,6 +1565,9 @@ gui_line_hook_update (struct t_gui_line *line,
 
     if ((tags_updated || notify_level_updated) && !highlight_updated)
         line->data->highlight = gui_line_get_highlight (line);
+
+    /* layout must be computed again */
+    line->data->layout_generation = 0;
 }
 
 /*
@@ -1577,6 +1604,7 @@ gui_line_add (struct t_gui_line *line)
 
     /* add line to lines list */
     gui_line_add_to_list (line->data->buffer->own_lines, line);
+    hdata_registry_add ("line_data", line->data);
 
     /* update hotlist and/or send signals for line */
     if (line->data->displayed)
@@ -1692,6 +1720,7 @@ gui_line_add_y (struct t_gui_line *line)
         /* replace ptr_line by line in list */
         gui_line_free_data (ptr_line);
         ptr_line->data = line->data;
+        hdata_registry_add ("line_data", ptr_line->data);
         free (line);
     }
     else
@@ -1721,6 +1750,7 @@ gui_line_add_y (struct t_gui_line *line)
             line->next_line = NULL;
         }
         ptr_line = line;
+        hdata_registry_add ("line_data", line->data);
 
         line->data->buffer->own_lines->lines_count++;
     }
@@ -1853,6 +1883,201 @@ gui_line_mix_buffers (struct t_gui_buffer *buffer)
     }
 }
 
+/*
+ * Exports lines of a buffer by columns: one array for each field of lines
+ * (dates, tags, prefixes, messages, ...), oldest line first.
+ *
+ * Lines are read from the end of buffer, until a line has an id lower or
+ * equal to "id_min", or when "max_lines" lines (if > 0) have been exported.
+ * Lines with a date lower than "date_min" (if > 0) are skipped: dates are not
+ * always increasing (a line can be printed with a date in the past), so the
+ * read does not stop on these lines.
+ *
+ * Strings and tags are not copied: they point to data in lines, so the
+ * export must be used immediately (before lines are changed or removed).
+ *
+ * Note: result must be freed after use with function gui_line_export_free.
+ *
+ * Returns pointer to lines exported, NULL if error.
+ */
+
+struct t_gui_lines_export *
+gui_line_export (struct t_gui_buffer *buffer, long id_min, time_t date_min,
+                 int max_lines)
+{
+    struct t_gui_lines_export *lines_export;
+    struct t_gui_line *ptr_line, *ptr_first_line;
+    char *ptr_column;
+    int count, i;
+
+    if (!buffer || !buffer->own_lines)
+        return NULL;
+
+    /* search first line to export, from last line of buffer */
+    count = 0;
+    ptr_first_line = NULL;
+    for (ptr_line = buffer->own_lines->last_line; ptr_line;
+         ptr_line = ptr_line->prev_line)
+    {
+        if (((max_lines > 0) && (count >= max_lines))
+            || (ptr_line->data->id <= id_min))
+        {
+            break;
+        }
+        if ((date_min > 0) && (ptr_line->data->date < date_min))
+            continue;
+        ptr_first_line = ptr_line;
+        count++;
+    }
+
+    lines_export = calloc (1, sizeof (*lines_export));
+    if (!lines_export)
+        return NULL;
+
+    if (count == 0)
+        return lines_export;
+
+    /*
+     * allocate all columns in a single block (biggest types first, so that
+     * all columns are aligned)
+     */
+    lines_export->columns = malloc (
+        count * ((2 * sizeof (*lines_export->date))
+                 + sizeof (*lines_export->line_data)
+                 + sizeof (*lines_export->tags_array)
+                 + sizeof (*lines_export->prefix)
+                 + sizeof (*lines_export->message)
+                 + sizeof (*lines_export->id)
+                 + sizeof (*lines_export->tags_count)
+                 + sizeof (*lines_export->displayed)
+                 + sizeof (*lines_export->highlight)));
+    if (!lines_export->columns)
+    {
+        free (lines_export);
+        return NULL;
+    }
+    lines_export->count = count;
+    ptr_column = lines_export->columns;
+    lines_export->date = (time_t *)ptr_column;
+    ptr_column += count * sizeof (*lines_export->date);
+    lines_export->date_printed = (time_t *)ptr_column;
+    ptr_column += count * sizeof (*lines_export->date_printed);
+    lines_export->line_data = (struct t_gui_line_data **)ptr_column;
+    ptr_column += count * sizeof (*lines_export->line_data);
+    lines_export->tags_array = (char ***)ptr_column;
+    ptr_column += count * sizeof (*lines_export->tags_array);
+    lines_export->prefix = (char **)ptr_column;
+    ptr_column += count * sizeof (*lines_export->prefix);
+    lines_export->message = (char **)ptr_column;
+    ptr_column += count * sizeof (*lines_export->message);
+    lines_export->id = (long *)ptr_column;
+    ptr_column += count * sizeof (*lines_export->id);
+    lines_export->tags_count = (int *)ptr_column;
+    ptr_column += count * sizeof (*lines_export->tags_count);
+    lines_export->displayed = ptr_column;
+    ptr_column += count * sizeof (*lines_export->displayed);
+    lines_export->highlight = ptr_column;
+
+    /* fill columns, from first line found to last line of buffer */
+    i = 0;
+    for (ptr_line = ptr_first_line; ptr_line && (i < count);
+         ptr_line = ptr_line->next_line)
+    {
+        if ((date_min > 0) && (ptr_line->data->date < date_min))
+            continue;
+        lines_export->date[i] = ptr_line->data->date;
+        lines_export->date_printed[i] = ptr_line->data->date_printed;
+        lines_export->line_data[i] = ptr_line->data;
+        lines_export->tags_array[i] = ptr_line->data->tags_array;
+        lines_export->prefix[i] = ptr_line->data->prefix;
+        lines_export->message[i] = ptr_line->data->message;
+        lines_export->id[i] = ptr_line->data->id;
+        lines_export->tags_count[i] = ptr_line->data->tags_count;
+        lines_export->displayed[i] = ptr_line->data->displayed;
+        lines_export->highlight[i] = ptr_line->data->highlight;
+        i++;
+    }
+
+    return lines_export;
+}
+
+/*
+ * Gets a column of lines exported (array with one item per line).
+ *
+ * Columns and types of items are:
+ *   line_data     struct t_gui_line_data *
+ *   id            long
+ *   date          time_t
+ *   date_printed  time_t
+ *   tags_count    int
+ *   tags_array    char **
+ *   displayed     char
+ *   highlight     char
+ *   prefix        char *
+ *   message       char *
+ *
+ * If not NULL, "count" is set to the number of items in array.
+ *
+ * Returns pointer to array, NULL if column is not found or if there are no
+ * lines.
+ */
+
+void *
+gui_line_export_get (struct t_gui_lines_export *lines_export,
+                     const char *column, int *count)
+{
+    if (count)
+        *count = 0;
+
+    if (!lines_export || !column || (lines_export->count == 0))
+        return NULL;
+
+    if (count)
+        *count = lines_export->count;
+
+    if (strcmp (column, "line_data") == 0)
+        return lines_export->line_data;
+    else if (strcmp (column, "id") == 0)
+        return lines_export->id;
+    else if (strcmp (column, "date") == 0)
+        return lines_export->date;
+    else if (strcmp (column, "date_printed") == 0)
+        return lines_export->date_printed;
+    else if (strcmp (column, "tags_count") == 0)
+        return lines_export->tags_count;
+    else if (strcmp (column, "tags_array") == 0)
+        return lines_export->tags_array;
+    else if (strcmp (column, "displayed") == 0)
+        return lines_export->displayed;
+    else if (strcmp (column, "highlight") == 0)
+        return lines_export->highlight;
+    else if (strcmp (column, "prefix") == 0)
+        return lines_export->prefix;
+    else if (strcmp (column, "message") == 0)
+        return lines_export->message;
+
+    if (count)
+        *count = 0;
+
+    return NULL;
+}
+
+/*
+ * Frees lines exported.
+ */
+
+void
+gui_line_export_free (struct t_gui_lines_export *lines_export)
+{
+    if (!lines_export)
+        return;
+
+    if (lines_export->columns)
+        free (lines_export->columns);
+
+    free (lines_export);
+}
+
 /*
  * Returns hdata for lines.
  */
@@ -1985,6 +2210,7 @@ gui_line_hdata_line_data_update_cb (void *data,
 
     if (rc > 0)
     {
+        line_data->layout_generation = 0;
         if (update_coords)
         {
             for (ptr_win = gui_windows; ptr_win; ptr_win = ptr_win->next_window)
@@ -2018,6 +2244,7 @@ gui_line_hdata_line_data_cb (const void *pointer, void *data,
     if (hdata)
     {
         HDATA_VAR(struct t_gui_line_data, buffer, POINTER, 0, NULL, "buffer");
+        HDATA_VAR(struct t_gui_line_data, id, LONG, 0, NULL, NULL);
         HDATA_VAR(struct t_gui_line_data, y, INTEGER, 0, NULL, NULL);
         HDATA_VAR(struct t_gui_line_data, date, TIME, 1, NULL, NULL);
         HDATA_VAR(struct t_gui_line_data, date_printed, TIME, 1, NULL, NULL);
@@ -2050,7 +2277,7 @@ gui_line_add_to_infolist (struct t_infolist *infolist,
 {
     struct t_infolist_item *ptr_item;
     int i, length;
-    char option_name[64], *tags;
+    char option_name[64], *tags, str_id[64];
 
     if (!infolist || !line)
         return 0;
@@ -2059,6 +2286,9 @@ gui_line_add_to_infolist (struct t_infolist *infolist,
     if (!ptr_item)
         return 0;
 
+    snprintf (str_id, sizeof (str_id), "%ld", line->data->id);
+    if (!infolist_new_var_string (ptr_item, "id", str_id))
+        return 0;
     if (!infolist_new_var_integer (ptr_item, "y", line->data->y))
         return 0;
     if (!infolist_new_var_time (ptr_item, "date", line->data->date))
@@ -25,11 +25,24 @@
 
 struct t_infolist;
 
+/* flags used to compute layout of a line (cached in line data) */
+
+#define GUI_LINE_LAYOUT_TIME           (1 << 0)
+#define GUI_LINE_LAYOUT_TAGS           (1 << 1)
+#define GUI_LINE_LAYOUT_MIXED          (1 << 2)
+#define GUI_LINE_LAYOUT_MIXED_LINE     (1 << 3)
+#define GUI_LINE_LAYOUT_TIME_SAME      (1 << 4)
+#define GUI_LINE_LAYOUT_SAME_NICK_PREV (1 << 5)
+#define GUI_LINE_LAYOUT_SAME_NICK_NEXT (1 << 6)
+#define GUI_LINE_LAYOUT_DAY_CHANGE     (1 << 7)
+
 /* line structures */
 
 struct t_gui_line_data
 {
     struct t_gui_buffer *buffer;       /* pointer to buffer                 */
+    long id;                           /* unique id of line (increasing,    */
+                                       /* kept on /upgrade)                 */
     int y;                             /* line position (for free buffer)   */
     time_t date;                       /* date/time of line (may be past)   */
     time_t date_printed;               /* date/time when weechat print it   */
@@ -43,6 +56,14 @@ struct t_gui_line_data
     char *prefix;                      /* prefix for line (may be NULL)     */
     int prefix_length;                 /* prefix length (on screen)         */
     char *message;                     /* line content (after prefix)       */
+    int layout_generation;             /* generation of cached layout       */
+                                       /* (0 = no layout cached)            */
+    int layout_width;                  /* chat width used for cached layout */
+    int layout_prefix_max_length;      /* prefix max length used for layout */
+    int layout_buffer_max_length;      /* buffer max length used for layout */
+    int layout_flags;                  /* display flags used for layout     */
+    int layout_num_lines;              /* number of lines on screen for     */
+                                       /* time, prefix and message          */
 };
 
 struct t_gui_line
@@ -67,6 +88,31 @@ struct t_gui_lines
     int prefix_max_length_refresh;     /* refresh asked for prefix max len. */
 };
 
+/*
+ * lines exported by columns (arrays indexed by line, oldest line first);
+ * strings and tags are not copied: they point to data in lines
+ */
+
+struct t_gui_lines_export
+{
+    int count;                         /* number of lines exported          */
+    time_t *date;                      /* date/time of lines                */
+    time_t *date_printed;              /* date/time when lines were printed */
+    struct t_gui_line_data **line_data; /* pointers to lines data           */
+    char ***tags_array;                /* tags of lines                     */
+    char **prefix;                     /* prefix of lines (may be NULL)     */
+    char **message;                    /* content of lines                  */
+    long *id;                          /* unique ids of lines               */
+    int *tags_count;                   /* number of tags of lines           */
+    char *displayed;                   /* 1 if line is displayed            */
+    char *highlight;                   /* 1 if line has highlight           */
+    void *columns;                     /* memory allocated for all columns  */
+};
+
+/* line variables */
+
+extern long gui_line_last_id;
+
 /* line functions */
 
 extern struct t_gui_lines *gui_lines_alloc ();
@@ -74,6 +120,8 @@ extern void gui_lines_free (struct t_gui_lines *lines);
 extern void gui_line_tags_alloc (struct t_gui_line_data *line_data,
                                  const char *tags);
 extern void gui_line_tags_free (struct t_gui_line_data *line_data);
+extern int gui_line_prefix_is_same_nick (struct t_gui_line *line,
+                                         int direction);
 extern void gui_line_get_prefix_for_display (struct t_gui_line *line,
                                              char **prefix, int *length,
                                              char **color, int *prefix_is_nick);
@@ -85,6 +133,8 @@ extern struct t_gui_line *gui_line_get_first_displayed (struct t_gui_buffer *buf
 extern struct t_gui_line *gui_line_get_last_displayed (struct t_gui_buffer *buffer);
 extern struct t_gui_line *gui_line_get_prev_displayed (struct t_gui_line *line);
 extern struct t_gui_line *gui_line_get_next_displayed (struct t_gui_line *line);
+extern int gui_line_search_string (const char *string, const char *text,
+                                   int exact, regex_t *regex);
 extern int gui_line_search_text (struct t_gui_buffer *buffer,
                                  struct t_gui_line *line);
 extern int gui_line_match_regex (struct t_gui_line_data *line_data,
@@ -122,6 +172,13 @@ extern void gui_line_add (struct t_gui_line *line);
 extern void gui_line_add_y (struct t_gui_line *line);
 extern void gui_line_clear (struct t_gui_line *line);
 extern void gui_line_mix_buffers (struct t_gui_buffer *buffer);
+extern struct t_gui_lines_export *gui_line_export (struct t_gui_buffer *buffer,
+                                                   long id_min,
+                                                   time_t date_min,
+                                                   int max_lines);
+extern void *gui_line_export_get (struct t_gui_lines_export *lines_export,
+                                  const char *column, int *count);
+extern void gui_line_export_free (struct t_gui_lines_export *lines_export);
 extern struct t_hdata *gui_line_hdata_lines_cb (const void *pointer,
                                                 void *data,
                                                 const char *hdata_name);
@@ -46,6 +46,7 @@
 #include "gui-nicklist.h"
 #include "gui-buffer.h"
 #include "gui-color.h"
+#include "gui-line.h"
 
 
 struct t_hashtable *gui_nicklist_hsignal = NULL;
@@ -64,6 +65,8 @@ gui_nicklist_send_signal (const char *signal, struct t_gui_buffer *buffer,
 
     if (buffer)
     {
+        buffer->nicklist_last_id = gui_line_last_id;
+
         length = 128 + ((arguments) ? strlen (arguments) : 0) + 1 + 1;
         str_args = malloc (length);
         if (str_args)
@@ -292,6 +295,7 @@ gui_nicklist_add_group (struct t_gui_buffer *buffer,
     {
         buffer->nicklist_root = new_group;
     }
+    hdata_registry_add ("nick_group", new_group);
 
     if (buffer->nicklist_display_groups && visible)
         buffer->nicklist_visible_count++;
@@ -450,6 +454,7 @@ gui_nicklist_add_nick (struct t_gui_buffer *buffer,
     new_nick->visible = visible;
 
     gui_nicklist_insert_nick_sorted (new_nick->group, new_nick);
+    hdata_registry_add ("nick", new_nick);
 
     buffer->nicklist_count++;
     buffer->nicklist_nicks_count++;
@@ -493,6 +498,7 @@ gui_nicklist_remove_nick (struct t_gui_buffer *buffer,
         (nick->group)->nicks = nick->next_nick;
     if ((nick->group)->last_nick == nick)
         (nick->group)->last_nick = nick->prev_nick;
+    hdata_registry_remove ("nick", nick);
 
     /* free data */
     if (nick->name)
@@ -573,6 +579,7 @@ gui_nicklist_remove_group (struct t_gui_buffer *buffer,
     {
         buffer->nicklist_root = NULL;
     }
+    hdata_registry_remove ("nick_group", group);
 
     /* free data */
     if (group->name)
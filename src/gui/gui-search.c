@@ -0,0 +1,1002 @@
+/*
+ * gui-search.c - search of text in lines of buffers (used by all GUI)
+ *
+ * Copyright (C) 2003-2020 Sébastien Helleu <flashcode@flashtux.org>
+ *
+ * This file is part of WeeChat, the extensible chat client.
+ *
+ * WeeChat is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WeeChat is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WeeChat.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <fcntl.h>
+#include <regex.h>
+#include <signal.h>
+#include <pthread.h>
+#include <sys/time.h>
+
+#include "../core/weechat.h"
+#include "../core/wee-hook.h"
+#include "../core/wee-log.h"
+#include "../core/wee-string.h"
+#include "../core/wee-util.h"
+#include "../plugins/plugin.h"
+#include "gui-search.h"
+#include "gui-buffer.h"
+#include "gui-chat.h"
+#include "gui-color.h"
+#include "gui-line.h"
+#include "gui-window.h"
+
+
+struct t_gui_buffer *gui_search_buffer = NULL;     /* buffer with results   */
+struct t_gui_search *gui_searches = NULL;          /* first search          */
+struct t_gui_search *last_gui_search = NULL;       /* last search           */
+struct t_gui_search *gui_search_current = NULL;    /* search displayed in   */
+                                                   /* the buffer            */
+
+/*
+ * the mutex protects the work shared by threads (next chunk, chunks done,
+ * flag "cancelled" and number of threads running); threads notify the main
+ * thread by writing in a pipe
+ */
+pthread_mutex_t gui_search_mutex = PTHREAD_MUTEX_INITIALIZER;
+int gui_search_pipe[2] = { -1, -1 };
+struct t_hook *gui_search_hook_fd = NULL;
+
+
+/*
+ * Checks if a buffer is searched.
+ *
+ * Returns:
+ *   1: buffer is searched
+ *   0: buffer is not searched
+ */
+
+int
+gui_search_buffer_is_searched (struct t_gui_buffer *buffer,
+                               struct t_gui_buffer *buffer_searched)
+{
+    if (buffer_searched && (buffer != buffer_searched))
+        return 0;
+
+    return ((buffer != gui_search_buffer)
+            && (buffer->type == GUI_BUFFER_TYPE_FORMATTED)) ? 1 : 0;
+}
+
+/*
+ * Creates a new search: the lines displayed in buffer (or in all buffers if
+ * buffer is NULL) are copied, so that they can be searched in threads while
+ * the buffers are changed in main thread.
+ *
+ * Returns pointer to new search, NULL if error.
+ */
+
+struct t_gui_search *
+gui_search_new (const char *text, int exact, int regex, int in_prefix,
+                struct t_gui_buffer *buffer)
+{
+    struct t_gui_search *new_search;
+    struct t_gui_buffer *ptr_buffer;
+    struct t_gui_line *ptr_line;
+    struct t_gui_search_line *ptr_search_line;
+    char *ptr_data;
+    int flags, num_lines, length;
+    size_t size_data;
+
+    if (!text || !text[0])
+        return NULL;
+
+    new_search = calloc (1, sizeof (*new_search));
+    if (!new_search)
+        return NULL;
+
+    new_search->text = strdup (text);
+    new_search->exact = exact;
+    new_search->regex = regex;
+    new_search->in_prefix = in_prefix;
+    new_search->all_buffers = (buffer) ? 0 : 1;
+    new_search->buffer_full_name = (buffer) ? strdup (buffer->full_name) : NULL;
+    if (!new_search->text || (buffer && !new_search->buffer_full_name))
+        goto error;
+
+    if (regex)
+    {
+        new_search->regex_compiled = malloc (
+            sizeof (*new_search->regex_compiled));
+        if (!new_search->regex_compiled)
+            goto error;
+        flags = REG_EXTENDED;
+        if (!exact)
+            flags |= REG_ICASE;
+        if (string_regcomp (new_search->regex_compiled, text, flags) != 0)
+        {
+            free (new_search->regex_compiled);
+            new_search->regex_compiled = NULL;
+            goto error;
+        }
+    }
+
+    /* count buffers, lines and size of data to copy */
+    size_data = 0;
+    for (ptr_buffer = gui_buffers; ptr_buffer;
+         ptr_buffer = ptr_buffer->next_buffer)
+    {
+        if (!gui_search_buffer_is_searched (ptr_buffer, buffer))
+            continue;
+        new_search->num_buffers++;
+        for (ptr_line = ptr_buffer->own_lines->first_line; ptr_line;
+             ptr_line = ptr_line->next_line)
+        {
+            if (!ptr_line->data->displayed || !ptr_line->data->message)
+                continue;
+            new_search->num_lines++;
+            if (ptr_line->data->prefix)
+                size_data += strlen (ptr_line->data->prefix) + 1;
+            size_data += strlen (ptr_line->data->message) + 1;
+        }
+    }
+
+    /* copy lines */
+    new_search->buffers = calloc (new_search->num_buffers + 1,
+                                  sizeof (*new_search->buffers));
+    new_search->lines = malloc ((new_search->num_lines + 1)
+                                * sizeof (*new_search->lines));
+    new_search->lines_data = malloc (size_data + 1);
+    new_search->matched = calloc (new_search->num_lines + 1, 1);
+    new_search->num_chunks = (new_search->num_lines
+                              + GUI_SEARCH_THREADS_CHUNK_LINES - 1)
+        / GUI_SEARCH_THREADS_CHUNK_LINES;
+    new_search->chunk_done = calloc (new_search->num_chunks + 1, 1);
+    if (!new_search->buffers || !new_search->lines || !new_search->lines_data
+        || !new_search->matched || !new_search->chunk_done)
+    {
+        goto error;
+    }
+    new_search->num_buffers = 0;
+    num_lines = 0;
+    ptr_data = new_search->lines_data;
+    for (ptr_buffer = gui_buffers; ptr_buffer;
+         ptr_buffer = ptr_buffer->next_buffer)
+    {
+        if (!gui_search_buffer_is_searched (ptr_buffer, buffer))
+            continue;
+        new_search->buffers[new_search->num_buffers] =
+            strdup (ptr_buffer->full_name);
+        if (!new_search->buffers[new_search->num_buffers])
+            goto error;
+        for (ptr_line = ptr_buffer->own_lines->first_line; ptr_line;
+             ptr_line = ptr_line->next_line)
+        {
+            if (!ptr_line->data->displayed || !ptr_line->data->message)
+                continue;
+            ptr_search_line = &new_search->lines[num_lines];
+            ptr_search_line->buffer = new_search->num_buffers;
+            ptr_search_line->id = ptr_line->data->id;
+            ptr_search_line->date = ptr_line->data->date;
+            ptr_search_line->prefix = NULL;
+            if (ptr_line->data->prefix)
+            {
+                length = strlen (ptr_line->data->prefix) + 1;
+                memcpy (ptr_data, ptr_line->data->prefix, length);
+                ptr_search_line->prefix = ptr_data;
+                ptr_data += length;
+            }
+            length = strlen (ptr_line->data->message) + 1;
+            memcpy (ptr_data, ptr_line->data->message, length);
+            ptr_search_line->message = ptr_data;
+            ptr_data += length;
+            num_lines++;
+        }
+        new_search->num_buffers++;
+    }
+
+    new_search->prev_search = last_gui_search;
+    new_search->next_search = NULL;
+    if (last_gui_search)
+        last_gui_search->next_search = new_search;
+    else
+        gui_searches = new_search;
+    last_gui_search = new_search;
+
+    return new_search;
+
+error:
+    gui_search_free (new_search);
+    return NULL;
+}
+
+/*
+ * Checks if a line of search matches the text searched.
+ *
+ * This function runs in threads: it must only read the search.
+ *
+ * Returns:
+ *   1: line matches
+ *   0: line does not match
+ */
+
+int
+gui_search_match_line (struct t_gui_search *search,
+                       struct t_gui_search_line *line)
+{
+    char *string;
+    int rc;
+
+    rc = 0;
+
+    if (search->in_prefix && line->prefix)
+    {
+        string = gui_color_decode (line->prefix, NULL);
+        if (string)
+        {
+            rc = gui_line_search_string (string, search->text, search->exact,
+                                         search->regex_compiled);
+            free (string);
+        }
+    }
+
+    if (!rc)
+    {
+        string = gui_color_decode (line->message, NULL);
+        if (string)
+        {
+            rc = gui_line_search_string (string, search->text, search->exact,
+                                         search->regex_compiled);
+            free (string);
+        }
+    }
+
+    return rc;
+}
+
+/*
+ * Notifies main thread that some lines have been searched.
+ */
+
+void
+gui_search_notify ()
+{
+    int num_written;
+
+    if (gui_search_pipe[1] >= 0)
+    {
+        /* the pipe is non-blocking: if it is full, main thread is notified */
+        num_written = write (gui_search_pipe[1], "x", 1);
+        (void) num_written;
+    }
+}
+
+/*
+ * Searches chunks of lines until all lines are searched or until search is
+ * cancelled.
+ *
+ * This function runs in threads: it must only read lines of search and set
+ * results of the chunk taken (other data is protected by the mutex).
+ */
+
+void *
+gui_search_thread (void *data)
+{
+    struct t_gui_search *search;
+    int chunk, index, end;
+
+    search = (struct t_gui_search *)data;
+
+    while (1)
+    {
+        pthread_mutex_lock (&gui_search_mutex);
+        if (search->cancelled || (search->next_chunk >= search->num_chunks))
+        {
+            pthread_mutex_unlock (&gui_search_mutex);
+            break;
+        }
+        chunk = search->next_chunk++;
+        pthread_mutex_unlock (&gui_search_mutex);
+
+        index = chunk * GUI_SEARCH_THREADS_CHUNK_LINES;
+        end = index + GUI_SEARCH_THREADS_CHUNK_LINES;
+        if (end > search->num_lines)
+            end = search->num_lines;
+        for (; index < end; index++)
+        {
+            search->matched[index] = (char)gui_search_match_line (
+                search, &search->lines[index]);
+        }
+
+        pthread_mutex_lock (&gui_search_mutex);
+        search->chunk_done[chunk] = 1;
+        pthread_mutex_unlock (&gui_search_mutex);
+        gui_search_notify ();
+    }
+
+    pthread_mutex_lock (&gui_search_mutex);
+    search->threads_running--;
+    pthread_mutex_unlock (&gui_search_mutex);
+    gui_search_notify ();
+
+    return NULL;
+}
+
+/*
+ * Joins threads of a search (they must have finished or the search must be
+ * cancelled).
+ */
+
+void
+gui_search_join_threads (struct t_gui_search *search)
+{
+    int i;
+
+    for (i = 0; i < search->num_threads; i++)
+    {
+        pthread_join (search->threads[i], NULL);
+    }
+    search->num_threads = 0;
+}
+
+/*
+ * Callback for pipe written by threads: displays new results of current
+ * search and frees searches cancelled when their threads have finished.
+ */
+
+int
+gui_search_fd_cb (const void *pointer, void *data, int fd)
+{
+    struct t_gui_search *ptr_search, *next_search;
+    char buffer[256];
+    int threads_running;
+
+    /* make C compiler happy */
+    (void) pointer;
+    (void) data;
+
+    while (read (fd, buffer, sizeof (buffer)) > 0)
+    {
+    }
+
+    ptr_search = gui_searches;
+    while (ptr_search)
+    {
+        next_search = ptr_search->next_search;
+        if (ptr_search->cancelled)
+        {
+            pthread_mutex_lock (&gui_search_mutex);
+            threads_running = ptr_search->threads_running;
+            pthread_mutex_unlock (&gui_search_mutex);
+            if (threads_running == 0)
+                gui_search_free (ptr_search);
+        }
+        else
+        {
+            gui_search_display_results (ptr_search);
+        }
+        ptr_search = next_search;
+    }
+
+    return WEECHAT_RC_OK;
+}
+
+/*
+ * Creates the pipe used by threads to notify main thread.
+ *
+ * Returns:
+ *   1: OK
+ *   0: error
+ */
+
+int
+gui_search_pipe_init ()
+{
+    if (gui_search_hook_fd)
+        return 1;
+
+    if (pipe (gui_search_pipe) < 0)
+    {
+        gui_search_pipe[0] = -1;
+        gui_search_pipe[1] = -1;
+        return 0;
+    }
+    fcntl (gui_search_pipe[0], F_SETFL,
+           fcntl (gui_search_pipe[0], F_GETFL) | O_NONBLOCK);
+    fcntl (gui_search_pipe[1], F_SETFL,
+           fcntl (gui_search_pipe[1], F_GETFL) | O_NONBLOCK);
+
+    gui_search_hook_fd = hook_fd (NULL, gui_search_pipe[0], 1, 0, 0,
+                                  &gui_search_fd_cb, NULL, NULL);
+    if (!gui_search_hook_fd)
+    {
+        close (gui_search_pipe[0]);
+        close (gui_search_pipe[1]);
+        gui_search_pipe[0] = -1;
+        gui_search_pipe[1] = -1;
+        return 0;
+    }
+
+    return 1;
+}
+
+/*
+ * Starts threads to search lines (at most GUI_SEARCH_THREADS_MAX threads);
+ * results are displayed by main thread when threads notify it.
+ *
+ * If no thread can be started, lines are searched in main thread.
+ *
+ * Returns:
+ *   1: OK
+ *   0: error
+ */
+
+int
+gui_search_start (struct t_gui_search *search)
+{
+    sigset_t set, old_set;
+    int i;
+
+    if (!search || !gui_search_pipe_init ())
+        return 0;
+
+    gettimeofday (&search->start_time, NULL);
+
+    /* start threads (signals are blocked in them) */
+    sigfillset (&set);
+    pthread_sigmask (SIG_SETMASK, &set, &old_set);
+    pthread_mutex_lock (&gui_search_mutex);
+    for (i = 0;
+         (i < GUI_SEARCH_THREADS_MAX) && (i < search->num_chunks);
+         i++)
+    {
+        if (pthread_create (&search->threads[search->num_threads], NULL,
+                            &gui_search_thread, search) == 0)
+        {
+            search->num_threads++;
+            search->threads_running++;
+        }
+    }
+    if (search->num_threads == 0)
+        search->threads_running = 1;
+    pthread_mutex_unlock (&gui_search_mutex);
+    pthread_sigmask (SIG_SETMASK, &old_set, NULL);
+
+    /* no thread started? then search lines now in main thread */
+    if (search->num_threads == 0)
+        gui_search_thread (search);
+
+    /* results are displayed in the callback of pipe */
+    gui_search_notify ();
+
+    return 1;
+}
+
+/*
+ * Cancels a search: its threads stop after the chunk of lines they are
+ * searching, and the search is freed when all threads have finished.
+ */
+
+void
+gui_search_cancel (struct t_gui_search *search)
+{
+    if (!search)
+        return;
+
+    pthread_mutex_lock (&gui_search_mutex);
+    search->cancelled = 1;
+    pthread_mutex_unlock (&gui_search_mutex);
+
+    if (search == gui_search_current)
+        gui_search_current = NULL;
+
+    gui_search_notify ();
+}
+
+/*
+ * Displays a line found in search buffer.
+ */
+
+void
+gui_search_display_line (struct t_gui_search *search, int index)
+{
+    struct t_gui_search_line *ptr_line;
+
+    if (!gui_search_buffer)
+        return;
+
+    ptr_line = &search->lines[index];
+
+    gui_chat_printf_date_tags (
+        gui_search_buffer,
+        ptr_line->date,
+        GUI_CHAT_TAG_NO_HIGHLIGHT,
+        "%s%d\t%s%s%s | %s%s%s%s",
+        GUI_COLOR(GUI_COLOR_CHAT_VALUE),
+        search->num_results,
+        GUI_COLOR(GUI_COLOR_CHAT_BUFFER),
+        search->buffers[ptr_line->buffer],
+        GUI_COLOR(GUI_COLOR_CHAT_DELIMITERS),
+        GUI_COLOR(GUI_COLOR_CHAT),
+        (ptr_line->prefix) ? ptr_line->prefix : "",
+        (ptr_line->prefix && ptr_line->prefix[0]) ? " " : "",
+        ptr_line->message);
+}
+
+/*
+ * Displays new results of a search (lines found in chunks searched since
+ * last call, in order of lines).
+ *
+ * At most GUI_SEARCH_DISPLAY_MAX_LINES lines are displayed: if there are
+ * more lines to display, main thread is notified again, so that the main
+ * loop is not blocked by a search with many results.
+ *
+ * Returns:
+ *   1: search is finished (all lines searched and displayed)
+ *   0: search is not finished
+ */
+
+int
+gui_search_display_results (struct t_gui_search *search)
+{
+    struct timeval tv_now;
+    int chunk_end, threads_running, index, end, count, new_size;
+    int *new_results;
+
+    if (!search || search->finished)
+        return 1;
+
+    pthread_mutex_lock (&gui_search_mutex);
+    chunk_end = search->next_line_displayed / GUI_SEARCH_THREADS_CHUNK_LINES;
+    while ((chunk_end < search->num_chunks) && search->chunk_done[chunk_end])
+    {
+        chunk_end++;
+    }
+    threads_running = search->threads_running;
+    pthread_mutex_unlock (&gui_search_mutex);
+
+    end = chunk_end * GUI_SEARCH_THREADS_CHUNK_LINES;
+    if (end > search->num_lines)
+        end = search->num_lines;
+    count = 0;
+    for (index = search->next_line_displayed;
+         (index < end) && (count < GUI_SEARCH_DISPLAY_MAX_LINES); index++)
+    {
+        if (!search->matched[index])
+            continue;
+        if (search->num_results >= search->size_results)
+        {
+            new_size = (search->size_results > 0) ?
+                search->size_results * 2 : 64;
+            new_results = realloc (search->results,
+                                   new_size * sizeof (search->results[0]));
+            if (!new_results)
+                continue;
+            search->results = new_results;
+            search->size_results = new_size;
+        }
+        search->results[search->num_results++] = index;
+        gui_search_display_line (search, index);
+        count++;
+    }
+    search->next_line_displayed = index;
+
+    if (index < end)
+    {
+        /* more lines to display: do it in next iteration of main loop */
+        gui_search_notify ();
+        return 0;
+    }
+
+    if ((threads_running > 0) || (index < search->num_lines))
+        return 0;
+
+    gui_search_join_threads (search);
+    search->finished = 1;
+
+    /* copy of lines is not needed any more (only ids are kept to jump) */
+    free (search->lines_data);
+    search->lines_data = NULL;
+    for (index = 0; index < search->num_lines; index++)
+    {
+        search->lines[index].prefix = NULL;
+        search->lines[index].message = NULL;
+    }
+
+    if (gui_search_buffer && (search == gui_search_current))
+    {
+        gettimeofday (&tv_now, NULL);
+        gui_chat_printf (gui_search_buffer,
+                         _("%d lines found (%d lines searched in %d buffers, "
+                           "%.3fs)"),
+                         search->num_results,
+                         search->num_lines,
+                         search->num_buffers,
+                         ((float)util_timeval_diff (&search->start_time,
+                                                    &tv_now)) / 1000000);
+    }
+
+    return 1;
+}
+
+/*
+ * Jumps to a line found by current search (number is the number of result,
+ * first is 1): switches to the buffer and scrolls to the line.
+ *
+ * Returns:
+ *   1: OK
+ *   0: result or line not found
+ */
+
+int
+gui_search_jump (int number)
+{
+    struct t_gui_search_line *ptr_search_line;
+    struct t_gui_buffer *ptr_buffer;
+    struct t_gui_line *ptr_line;
+    struct t_gui_window *ptr_window;
+
+    if (!gui_search_current || !gui_current_window
+        || (number < 1) || (number > gui_search_current->num_results))
+    {
+        return 0;
+    }
+
+    ptr_search_line = &gui_search_current->lines[
+        gui_search_current->results[number - 1]];
+    ptr_buffer = gui_buffer_search_by_full_name (
+        gui_search_current->buffers[ptr_search_line->buffer]);
+    if (!ptr_buffer)
+        return 0;
+
+    /* search line (with its id) in lines displayed in buffer */
+    for (ptr_line = ptr_buffer->lines->last_line; ptr_line;
+         ptr_line = ptr_line->prev_line)
+    {
+        if ((ptr_line->data->buffer == ptr_buffer)
+            && (ptr_line->data->id == ptr_search_line->id))
+        {
+            break;
+        }
+    }
+    if (!ptr_line)
+        return 0;
+
+    if (!ptr_buffer->active)
+        gui_buffer_set_active_buffer (ptr_buffer);
+    gui_window_switch_to_buffer (gui_current_window, ptr_buffer, 1);
+
+    ptr_window = gui_current_window;
+    ptr_window->scroll->start_line = ptr_line;
+    ptr_window->scroll->start_line_pos = 0;
+    ptr_window->scroll->first_line_displayed =
+        (ptr_line == gui_line_get_first_displayed (ptr_window->buffer));
+    gui_buffer_ask_chat_refresh (ptr_window->buffer, 2);
+
+    return 1;
+}
+
+/*
+ * Input callback for search buffer: a number jumps to the line found, "q"
+ * closes the buffer and any other text starts a new search (with same
+ * options as current search).
+ */
+
+int
+gui_search_buffer_input_cb (const void *pointer, void *data,
+                            struct t_gui_buffer *buffer,
+                            const char *input_data)
+{
+    struct t_gui_search *ptr_search;
+    char *error;
+    long number;
+
+    /* make C compiler happy */
+    (void) pointer;
+    (void) data;
+
+    if (string_strcasecmp (input_data, "q") == 0)
+    {
+        gui_buffer_close (buffer);
+        return WEECHAT_RC_OK;
+    }
+
+    error = NULL;
+    number = strtol (input_data, &error, 10);
+    if (error && !error[0])
+    {
+        if (!gui_search_jump ((int)number))
+        {
+            gui_chat_printf (buffer,
+                             _("%sLine #%ld not found"),
+                             gui_chat_prefix[GUI_CHAT_PREFIX_ERROR],
+                             number);
+        }
+        return WEECHAT_RC_OK;
+    }
+
+    ptr_search = gui_search_current;
+    gui_search_run (
+        input_data,
+        (ptr_search) ? ptr_search->exact : 0,
+        (ptr_search) ? ptr_search->regex : 0,
+        (ptr_search) ? ptr_search->in_prefix : 0,
+        (ptr_search && ptr_search->buffer_full_name) ?
+        gui_buffer_search_by_full_name (ptr_search->buffer_full_name) : NULL);
+
+    return WEECHAT_RC_OK;
+}
+
+/*
+ * Close callback for search buffer.
+ */
+
+int
+gui_search_buffer_close_cb (const void *pointer, void *data,
+                            struct t_gui_buffer *buffer)
+{
+    /* make C compiler happy */
+    (void) pointer;
+    (void) data;
+    (void) buffer;
+
+    gui_search_cancel (gui_search_current);
+    gui_search_buffer = NULL;
+
+    return WEECHAT_RC_OK;
+}
+
+/*
+ * Assigns search buffer to pointer if it is not yet set (after /upgrade).
+ */
+
+void
+gui_search_buffer_assign ()
+{
+    if (!gui_search_buffer)
+    {
+        gui_search_buffer = gui_buffer_search_by_name (NULL,
+                                                       GUI_SEARCH_BUFFER_NAME);
+        if (gui_search_buffer)
+        {
+            gui_search_buffer->input_callback = &gui_search_buffer_input_cb;
+            gui_search_buffer->close_callback = &gui_search_buffer_close_cb;
+        }
+    }
+}
+
+/*
+ * Opens search buffer (if not yet opened) and switches to it.
+ */
+
+void
+gui_search_buffer_open ()
+{
+    if (!gui_search_buffer)
+    {
+        gui_search_buffer = gui_buffer_new (NULL, GUI_SEARCH_BUFFER_NAME,
+                                            &gui_search_buffer_input_cb,
+                                            NULL, NULL,
+                                            &gui_search_buffer_close_cb,
+                                            NULL, NULL);
+        if (gui_search_buffer)
+        {
+            if (!gui_search_buffer->short_name)
+                gui_search_buffer->short_name = strdup (GUI_SEARCH_BUFFER_NAME);
+            gui_buffer_set (gui_search_buffer, "localvar_set_no_log", "1");
+        }
+    }
+
+    if (gui_search_buffer && gui_current_window
+        && (gui_current_window->buffer != gui_search_buffer))
+    {
+        gui_window_switch_to_buffer (gui_current_window, gui_search_buffer, 1);
+    }
+}
+
+/*
+ * Runs a new search (in a buffer or in all buffers if buffer is NULL): the
+ * current search is cancelled and the results of new search are displayed
+ * in search buffer.
+ *
+ * Returns pointer to new search, NULL if error.
+ */
+
+struct t_gui_search *
+gui_search_run (const char *text, int exact, int regex, int in_prefix,
+                struct t_gui_buffer *buffer)
+{
+    struct t_gui_search *new_search;
+    char *title;
+    int length;
+
+    gui_search_cancel (gui_search_current);
+
+    new_search = gui_search_new (text, exact, regex, in_prefix, buffer);
+    if (!new_search)
+        return NULL;
+
+    gui_search_buffer_open ();
+    if (!gui_search_buffer)
+    {
+        gui_search_free (new_search);
+        return NULL;
+    }
+    gui_search_current = new_search;
+
+    length = strlen (text) + 256
+        + ((buffer) ? strlen (buffer->full_name) : 0);
+    title = malloc (length);
+    if (title)
+    {
+        snprintf (title, length,
+                  _("Search %s\"%s\" in %s | Input: number = jump to line, "
+                    "text = new search, q = close"),
+                  (regex) ? _("regex ") : "",
+                  text,
+                  (buffer) ? buffer->full_name : _("all buffers"));
+        gui_buffer_set_title (gui_search_buffer, title);
+        free (title);
+    }
+    gui_buffer_clear (gui_search_buffer);
+
+    if (!gui_search_start (new_search))
+    {
+        gui_search_free (new_search);
+        return NULL;
+    }
+
+    return new_search;
+}
+
+/*
+ * Frees a search (threads are cancelled and joined).
+ */
+
+void
+gui_search_free (struct t_gui_search *search)
+{
+    int i;
+
+    if (!search)
+        return;
+
+    if (search->num_threads > 0)
+    {
+        pthread_mutex_lock (&gui_search_mutex);
+        search->cancelled = 1;
+        pthread_mutex_unlock (&gui_search_mutex);
+        gui_search_join_threads (search);
+    }
+
+    if (search == gui_search_current)
+        gui_search_current = NULL;
+
+    /* remove search from list (if it has been added) */
+    if (search->prev_search || (gui_searches == search))
+    {
+        if (last_gui_search == search)
+            last_gui_search = search->prev_search;
+        if (search->prev_search)
+            (search->prev_search)->next_search = search->next_search;
+        else
+            gui_searches = search->next_search;
+        if (search->next_search)
+            (search->next_search)->prev_search = search->prev_search;
+    }
+
+    /* free data */
+    if (search->text)
+        free (search->text);
+    if (search->regex_compiled)
+    {
+        regfree (search->regex_compiled);
+        free (search->regex_compiled);
+    }
+    if (search->buffer_full_name)
+        free (search->buffer_full_name);
+    if (search->buffers)
+    {
+        for (i = 0; i < search->num_buffers; i++)
+        {
+            if (search->buffers[i])
+                free (search->buffers[i]);
+        }
+        free (search->buffers);
+    }
+    if (search->lines)
+        free (search->lines);
+    if (search->lines_data)
+        free (search->lines_data);
+    if (search->matched)
+        free (search->matched);
+    if (search->chunk_done)
+        free (search->chunk_done);
+    if (search->results)
+        free (search->results);
+
+    free (search);
+}
+
+/*
+ * Frees all searches and the pipe used by threads.
+ */
+
+void
+gui_search_end ()
+{
+    while (gui_searches)
+    {
+        gui_search_free (gui_searches);
+    }
+
+    if (gui_search_hook_fd)
+    {
+        unhook (gui_search_hook_fd);
+        gui_search_hook_fd = NULL;
+    }
+    if (gui_search_pipe[0] >= 0)
+    {
+        close (gui_search_pipe[0]);
+        gui_search_pipe[0] = -1;
+    }
+    if (gui_search_pipe[1] >= 0)
+    {
+        close (gui_search_pipe[1]);
+        gui_search_pipe[1] = -1;
+    }
+}
+
+/*
+ * Prints searches in WeeChat log file (usually for crash dump).
+ */
+
+void
+gui_search_print_log ()
+{
+    struct t_gui_search *ptr_search;
+
+    log_printf ("");
+    log_printf ("gui_search_buffer. . . . : 0x%lx", gui_search_buffer);
+    log_printf ("gui_search_current . . . : 0x%lx", gui_search_current);
+
+    for (ptr_search = gui_searches; ptr_search;
+         ptr_search = ptr_search->next_search)
+    {
+        log_printf ("");
+        log_printf ("[search (addr:0x%lx)]", ptr_search);
+        log_printf ("  text . . . . . . . . . : '%s'", ptr_search->text);
+        log_printf ("  exact. . . . . . . . . : %d", ptr_search->exact);
+        log_printf ("  regex. . . . . . . . . : %d", ptr_search->regex);
+        log_printf ("  regex_compiled . . . . : 0x%lx", ptr_search->regex_compiled);
+        log_printf ("  in_prefix. . . . . . . : %d", ptr_search->in_prefix);
+        log_printf ("  all_buffers. . . . . . : %d", ptr_search->all_buffers);
+        log_printf ("  buffer_full_name . . . : '%s'", ptr_search->buffer_full_name);
+        log_printf ("  num_buffers. . . . . . : %d", ptr_search->num_buffers);
+        log_printf ("  num_lines. . . . . . . : %d", ptr_search->num_lines);
+        log_printf ("  num_chunks . . . . . . : %d", ptr_search->num_chunks);
+        log_printf ("  next_chunk . . . . . . : %d", ptr_search->next_chunk);
+        log_printf ("  cancelled. . . . . . . : %d", ptr_search->cancelled);
+        log_printf ("  num_threads. . . . . . : %d", ptr_search->num_threads);
+        log_printf ("  threads_running. . . . : %d", ptr_search->threads_running);
+        log_printf ("  next_line_displayed. . : %d", ptr_search->next_line_displayed);
+        log_printf ("  num_results. . . . . . : %d", ptr_search->num_results);
+        log_printf ("  size_results . . . . . : %d", ptr_search->size_results);
+        log_printf ("  finished . . . . . . . : %d", ptr_search->finished);
+        log_printf ("  prev_search. . . . . . : 0x%lx", ptr_search->prev_search);
+        log_printf ("  next_search. . . . . . : 0x%lx", ptr_search->next_search);
+    }
+}
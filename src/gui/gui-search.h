@@ -0,0 +1,116 @@
+/*
+ * Copyright (C) 2003-2020 Sébastien Helleu <flashcode@flashtux.org>
+ *
+ * This file is part of WeeChat, the extensible chat client.
+ *
+ * WeeChat is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WeeChat is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WeeChat.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#ifndef WEECHAT_GUI_SEARCH_H
+#define WEECHAT_GUI_SEARCH_H
+
+#include <time.h>
+#include <regex.h>
+#include <pthread.h>
+#include <sys/time.h>
+
+#define GUI_SEARCH_BUFFER_NAME "search"
+
+/* lines are searched in threads, by chunks of lines */
+#define GUI_SEARCH_THREADS_CHUNK_LINES 1024
+#define GUI_SEARCH_THREADS_MAX 4
+
+/* max lines found displayed at once (main loop runs between two displays) */
+#define GUI_SEARCH_DISPLAY_MAX_LINES 256
+
+/* search structures */
+
+struct t_gui_buffer;
+
+struct t_gui_search_line
+{
+    int buffer;                        /* index of buffer in search         */
+    long id;                           /* line id                           */
+    time_t date;                       /* date/time of line                 */
+    char *prefix;                      /* prefix (copy, with colors)        */
+    char *message;                     /* message (copy, with colors)       */
+};
+
+struct t_gui_search
+{
+    /* search arguments */
+    char *text;                        /* text (or regex) to search         */
+    int exact;                         /* 1 for case sensitive search       */
+    int regex;                         /* 1 if text is a regex              */
+    regex_t *regex_compiled;           /* compiled regex                    */
+    int in_prefix;                     /* 1 to search in prefix too         */
+    int all_buffers;                   /* 1 to search in all buffers        */
+    char *buffer_full_name;            /* buffer (if not all buffers)       */
+
+    /* snapshot of lines (taken in main thread) */
+    int num_buffers;                   /* number of buffers searched        */
+    char **buffers;                    /* full names of buffers searched    */
+    int num_lines;                     /* number of lines searched          */
+    struct t_gui_search_line *lines;   /* lines searched                    */
+    char *lines_data;                  /* copy of prefixes and messages     */
+    char *matched;                     /* result for each line (1 = match)  */
+
+    /* work done by threads */
+    int num_chunks;                    /* number of chunks of lines         */
+    int next_chunk;                    /* next chunk to search              */
+    char *chunk_done;                  /* 1 for each chunk searched         */
+    int cancelled;                     /* 1 if search has been cancelled    */
+    int num_threads;                   /* number of threads started         */
+    int threads_running;               /* number of threads still running   */
+    pthread_t threads[GUI_SEARCH_THREADS_MAX]; /* threads                   */
+
+    /* results (in main thread) */
+    int next_line_displayed;           /* next line to display (if found)   */
+    int num_results;                   /* number of lines found             */
+    int *results;                      /* index of lines found              */
+    int size_results;                  /* size of array "results"           */
+    int finished;                      /* 1 if all results are displayed    */
+    struct timeval start_time;         /* start of search                   */
+
+    struct t_gui_search *prev_search;  /* link to previous search           */
+    struct t_gui_search *next_search;  /* link to next search               */
+};
+
+/* search variables */
+
+extern struct t_gui_buffer *gui_search_buffer;
+extern struct t_gui_search *gui_searches;
+extern struct t_gui_search *last_gui_search;
+extern struct t_gui_search *gui_search_current;
+
+/* search functions */
+
+extern struct t_gui_search *gui_search_new (const char *text, int exact,
+                                            int regex, int in_prefix,
+                                            struct t_gui_buffer *buffer);
+extern void *gui_search_thread (void *data);
+extern int gui_search_start (struct t_gui_search *search);
+extern void gui_search_cancel (struct t_gui_search *search);
+extern int gui_search_display_results (struct t_gui_search *search);
+extern int gui_search_jump (int number);
+extern void gui_search_buffer_open ();
+extern struct t_gui_search *gui_search_run (const char *text, int exact,
+                                            int regex, int in_prefix,
+                                            struct t_gui_buffer *buffer);
+extern void gui_search_free (struct t_gui_search *search);
+extern void gui_search_buffer_assign ();
+extern void gui_search_end ();
+extern void gui_search_print_log ();
+
+#endif /* WEECHAT_GUI_SEARCH_H */
@@ -31,6 +31,7 @@
 #include <string.h>
 #include <signal.h>
 #include <time.h>
+#include <sys/time.h>
 #include <ctype.h>
 
 #include "../core/weechat.h"
@@ -41,6 +42,7 @@
 #include "../core/wee-log.h"
 #include "../core/wee-string.h"
 #include "../core/wee-utf8.h"
+#include "../core/wee-util.h"
 #include "../plugins/plugin.h"
 #include "gui-window.h"
 #include "gui-bar.h"
@@ -71,6 +73,22 @@ int gui_window_bare_display = 0;       /* 1 for bare disp. (disable ncurses)*/
 struct t_hook *gui_window_bare_display_timer = NULL;
                                        /* timer for bare display            */
 
+struct timeval gui_window_frame_last = { 0, 0 };
+                                       /* time of last screen update        */
+int gui_window_frame_pending = 0;      /* 1 if changes are staged for the   */
+                                       /* next screen update                */
+int gui_window_frame_delayed = 0;      /* 1 if refresh is delayed (because  */
+                                       /* of option refresh_max_fps)        */
+unsigned long long gui_window_frame_count = 0;
+                                       /* number of screen updates          */
+unsigned long long gui_window_frame_delayed_count = 0;
+                                       /* number of delayed refreshes       */
+long long gui_window_frame_bytes = 0;  /* bytes sent to terminal by screen  */
+                                       /* updates (-1 if unknown)           */
+unsigned long long gui_window_frame_bytes_count = 0;
+                                       /* number of updates measured        */
+                                       /* (only with debug for core)        */
+
 
 /*
  * Searches for a window by number.
@@ -282,6 +300,110 @@ gui_window_ask_refresh (int refresh)
         gui_window_refresh_needed = refresh;
 }
 
+/*
+ * Returns the delay (in milliseconds) before the next screen update is
+ * allowed, according to option "weechat.look.refresh_max_fps".
+ *
+ * Returns 0 if the screen can be updated now.
+ */
+
+int
+gui_window_frame_get_delay ()
+{
+    struct timeval tv_now;
+    long long diff, interval;
+
+    if ((CONFIG_INTEGER(config_look_refresh_max_fps) <= 0)
+        || (gui_window_frame_last.tv_sec == 0))
+    {
+        return 0;
+    }
+
+    interval = 1000000 / CONFIG_INTEGER(config_look_refresh_max_fps);
+
+    gettimeofday (&tv_now, NULL);
+    diff = util_timeval_diff (&gui_window_frame_last, &tv_now);
+    if ((diff < 0) || (diff >= interval))
+        return 0;
+
+    /* round up to next millisecond */
+    return (int)((interval - diff + 999) / 1000);
+}
+
+/*
+ * Returns the timeout for the poll of main loop (in milliseconds), lowered
+ * if a refresh has been delayed and must be done before.
+ */
+
+int
+gui_window_frame_get_time_to_next (int timeout)
+{
+    int delay;
+
+    if (!gui_window_frame_delayed || (timeout == 0))
+        return timeout;
+
+    delay = gui_window_frame_get_delay ();
+    if ((timeout < 0) || (delay < timeout))
+        timeout = delay;
+
+    return timeout;
+}
+
+/*
+ * Checks if the chat area of a window can be refreshed now.
+ *
+ * Returns:
+ *   1: chat area can be refreshed
+ *   0: refresh is postponed until the window becomes the current window
+ */
+
+int
+gui_window_chat_refresh_allowed (struct t_gui_window *window)
+{
+    return (CONFIG_BOOLEAN(config_look_refresh_inactive_windows)
+            || (window == gui_current_window)) ? 1 : 0;
+}
+
+/*
+ * Displays statistics about screen updates.
+ */
+
+void
+gui_window_frame_display_infos ()
+{
+    gui_chat_printf (NULL, "");
+    gui_chat_printf (NULL, _("Screen updates:"));
+    gui_chat_printf (NULL,
+                     _("  max fps: %d, inactive windows refreshed: %s"),
+                     CONFIG_INTEGER(config_look_refresh_max_fps),
+                     (CONFIG_BOOLEAN(config_look_refresh_inactive_windows)) ?
+                     _("yes") : _("no"));
+    gui_chat_printf (NULL,
+                     _("  updates: %llu, delayed refreshes: %llu"),
+                     gui_window_frame_count,
+                     gui_window_frame_delayed_count);
+    if (gui_window_frame_bytes < 0)
+    {
+        gui_chat_printf (NULL, _("  bytes sent to terminal: (unknown)"));
+    }
+    else if (gui_window_frame_bytes_count == 0)
+    {
+        gui_chat_printf (NULL,
+                         _("  bytes sent to terminal: (not measured, "
+                           "enable debug for core to measure them)"));
+    }
+    else
+    {
+        gui_chat_printf (NULL,
+                         _("  bytes sent to terminal: %lld in %llu updates "
+                           "(%lld per update)"),
+                         gui_window_frame_bytes,
+                         gui_window_frame_bytes_count,
+                         gui_window_frame_bytes / (long long)gui_window_frame_bytes_count);
+    }
+}
+
 /*
  * Creates first entry in windows tree.
  *
@@ -689,6 +811,7 @@ gui_window_new (struct t_gui_window *parent_window, struct t_gui_buffer *buffer,
         gui_windows = new_window;
     last_gui_window = new_window;
     new_window->next_window = NULL;
+    hdata_registry_add ("window", new_window);
 
     /* create bar windows */
     for (ptr_bar = gui_bars; ptr_bar; ptr_bar = ptr_bar->next_bar)
@@ -1033,6 +1156,7 @@ gui_window_free (struct t_gui_window *window)
         gui_windows = window->next_window;
     if (last_gui_window == window)
         last_gui_window = window->prev_window;
+    hdata_registry_remove ("window", window);
 
     if (gui_current_window == window)
         gui_current_window = gui_windows;
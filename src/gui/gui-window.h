@@ -127,6 +127,13 @@ extern int gui_window_cursor_x;
 extern int gui_window_cursor_y;
 extern int gui_window_bare_display;
 extern struct t_hook *gui_window_bare_display_timer;
+extern struct timeval gui_window_frame_last;
+extern int gui_window_frame_pending;
+extern int gui_window_frame_delayed;
+extern unsigned long long gui_window_frame_count;
+extern unsigned long long gui_window_frame_delayed_count;
+extern long long gui_window_frame_bytes;
+extern unsigned long long gui_window_frame_bytes_count;
 
 /* window functions */
 
@@ -141,6 +148,10 @@ extern void gui_window_get_context_at_xy (struct t_gui_window *window,
                                           char **beginning,
                                           char **end);
 extern void gui_window_ask_refresh (int refresh);
+extern int gui_window_frame_get_delay ();
+extern int gui_window_frame_get_time_to_next (int timeout);
+extern int gui_window_chat_refresh_allowed (struct t_gui_window *window);
+extern void gui_window_frame_display_infos ();
 extern int gui_window_tree_init (struct t_gui_window *window);
 extern void gui_window_tree_node_to_leaf (struct t_gui_window_tree *node,
                                           struct t_gui_window *window);
@@ -246,6 +257,8 @@ extern void gui_window_send_clipboard (const char *storage_unit,
                                        const char *text);
 extern void gui_window_set_bracketed_paste_mode (int enable);
 extern void gui_window_move_cursor ();
+extern void gui_window_frame_stage ();
+extern void gui_window_frame_update ();
 extern void gui_window_term_display_infos ();
 extern void gui_window_objects_print_log (struct t_gui_window *window);
 
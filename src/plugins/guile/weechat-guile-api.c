@@ -3173,6 +3173,67 @@ weechat_guile_api_hook_set (SCM hook, SCM property, SCM value)
     API_RETURN_OK;
 }
 
+int
+weechat_guile_api_hook_batch_cb (const void *pointer, void *data,
+                                struct t_infolist *events)
+{
+    struct t_plugin_script *script;
+    void *func_argv[2];
+    char empty_arg[1] = { '\0' };
+    const char *ptr_function, *ptr_data;
+    int *rc, ret;
+
+    script = (struct t_plugin_script *)pointer;
+    plugin_script_get_function_and_data (data, &ptr_function, &ptr_data);
+
+    if (ptr_function && ptr_function[0])
+    {
+        func_argv[0] = (ptr_data) ? (char *)ptr_data : empty_arg;
+        func_argv[1] = (char *)API_PTR2STR(events);
+
+        rc = (int *) weechat_guile_exec (script,
+                                         WEECHAT_SCRIPT_EXEC_INT,
+                                         ptr_function,
+                                         "ss", func_argv);
+
+        if (!rc)
+            ret = WEECHAT_RC_ERROR;
+        else
+        {
+            ret = *rc;
+            free (rc);
+        }
+
+        return ret;
+    }
+
+    return WEECHAT_RC_ERROR;
+}
+
+SCM
+weechat_guile_api_hook_batch (SCM hook, SCM max_size, SCM max_latency,
+                              SCM function, SCM data)
+{
+    int rc;
+
+    API_INIT_FUNC(1, "hook_batch", API_RETURN_INT(0));
+    if (!scm_is_string (hook) || !scm_is_integer (max_size)
+        || !scm_is_integer (max_latency) || !scm_is_string (function)
+        || !scm_is_string (data))
+        API_WRONG_ARGS(API_RETURN_INT(0));
+
+    rc = plugin_script_api_hook_batch (weechat_guile_plugin,
+                                       guile_current_script,
+                                       API_STR2PTR(API_SCM_TO_STRING(hook)),
+                                       scm_to_int (max_size),
+                                       scm_to_int (max_latency),
+                                       &weechat_guile_api_hook_batch_cb,
+                                       API_SCM_TO_STRING(function),
+                                       API_SCM_TO_STRING(data));
+
+    API_RETURN_INT(rc);
+}
+
 SCM
 weechat_guile_api_unhook (SCM hook)
 {
@@ -5006,6 +5067,7 @@ weechat_guile_api_module_init (void *data)
     API_DEF_FUNC(hook_infolist, 6);
     API_DEF_FUNC(hook_focus, 3);
     API_DEF_FUNC(hook_set, 3);
+    API_DEF_FUNC(hook_batch, 5);
     API_DEF_FUNC(unhook, 1);
     API_DEF_FUNC(unhook_all, 0);
     API_DEF_FUNC(buffer_new, 5);
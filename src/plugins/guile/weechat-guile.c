@@ -821,12 +821,12 @@ weechat_guile_command_cb (const void *pointer, void *data,
         }
         else if (weechat_strcasecmp (argv[1], "autoload") == 0)
         {
-            plugin_script_auto_load (weechat_guile_plugin, &weechat_guile_load_cb);
+            plugin_script_auto_load (weechat_guile_plugin, &guile_data);
         }
         else if (weechat_strcasecmp (argv[1], "reload") == 0)
         {
             weechat_guile_unload_all ();
-            plugin_script_auto_load (weechat_guile_plugin, &weechat_guile_load_cb);
+            plugin_script_auto_load (weechat_guile_plugin, &guile_data);
         }
         else if (weechat_strcasecmp (argv[1], "unload") == 0)
         {
@@ -3085,6 +3085,68 @@ API_FUNC(hook_set)
     API_RETURN_OK;
 }
 
+int
+weechat_js_api_hook_batch_cb (const void *pointer, void *data,
+                             struct t_infolist *events)
+{
+    struct t_plugin_script *script;
+    void *func_argv[2];
+    char empty_arg[1] = { '\0' };
+    const char *ptr_function, *ptr_data;
+    int *rc, ret;
+
+    script = (struct t_plugin_script *)pointer;
+    plugin_script_get_function_and_data (data, &ptr_function, &ptr_data);
+
+    if (ptr_function && ptr_function[0])
+    {
+        func_argv[0] = (ptr_data) ? (char *)ptr_data : empty_arg;
+        func_argv[1] = (char *)API_PTR2STR(events);
+
+        rc = (int *)weechat_js_exec (script,
+                                     WEECHAT_SCRIPT_EXEC_INT,
+                                     ptr_function,
+                                     "ss", func_argv);
+
+        if (!rc)
+            ret = WEECHAT_RC_ERROR;
+        else
+        {
+            ret = *rc;
+            free (rc);
+        }
+
+        return ret;
+    }
+
+    return WEECHAT_RC_ERROR;
+}
+
+API_FUNC(hook_batch)
+{
+    int max_size, max_latency, rc;
+
+    API_INIT_FUNC(1, "hook_batch", "siiss", API_RETURN_INT(0));
+
+    v8::String::Utf8Value hook(args[0]);
+    max_size = args[1]->IntegerValue();
+    max_latency = args[2]->IntegerValue();
+    v8::String::Utf8Value function(args[3]);
+    v8::String::Utf8Value data(args[4]);
+
+    rc = plugin_script_api_hook_batch (
+        weechat_js_plugin,
+        js_current_script,
+        (struct t_hook *)API_STR2PTR(*hook),
+        max_size,
+        max_latency,
+        &weechat_js_api_hook_batch_cb,
+        *function,
+        *data);
+
+    API_RETURN_INT(rc);
+}
+
 API_FUNC(unhook)
 {
     API_INIT_FUNC(1, "unhook", "s", API_RETURN_ERROR);
@@ -4943,6 +5005,7 @@ WeechatJsV8::loadLibs()
     API_DEF_FUNC(hook_infolist);
     API_DEF_FUNC(hook_focus);
     API_DEF_FUNC(hook_set);
+    API_DEF_FUNC(hook_batch);
     API_DEF_FUNC(unhook);
     API_DEF_FUNC(unhook_all);
     API_DEF_FUNC(buffer_new);
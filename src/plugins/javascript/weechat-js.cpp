@@ -602,12 +602,12 @@ weechat_js_command_cb (const void *pointer, void *data,
         }
         else if (weechat_strcasecmp (argv[1], "autoload") == 0)
         {
-            plugin_script_auto_load (weechat_js_plugin, &weechat_js_load_cb);
+            plugin_script_auto_load (weechat_js_plugin, &js_data);
         }
         else if (weechat_strcasecmp (argv[1], "reload") == 0)
         {
             weechat_js_unload_all ();
-            plugin_script_auto_load (weechat_js_plugin, &weechat_js_load_cb);
+            plugin_script_auto_load (weechat_js_plugin, &js_data);
         }
         else if (weechat_strcasecmp(argv[1], "unload") == 0)
         {
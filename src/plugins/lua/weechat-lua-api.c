@@ -3324,6 +3324,70 @@ API_FUNC(hook_set)
     API_RETURN_OK;
 }
 
+int
+weechat_lua_api_hook_batch_cb (const void *pointer, void *data,
+                              struct t_infolist *events)
+{
+    struct t_plugin_script *script;
+    void *func_argv[2];
+    char empty_arg[1] = { '\0' };
+    const char *ptr_function, *ptr_data;
+    int *rc, ret;
+
+    script = (struct t_plugin_script *)pointer;
+    plugin_script_get_function_and_data (data, &ptr_function, &ptr_data);
+
+    if (ptr_function && ptr_function[0])
+    {
+        func_argv[0] = (ptr_data) ? (char *)ptr_data : empty_arg;
+        func_argv[1] = (char *)API_PTR2STR(events);
+
+        rc = (int *) weechat_lua_exec (script,
+                                       WEECHAT_SCRIPT_EXEC_INT,
+                                       ptr_function,
+                                       "ss", func_argv);
+
+        if (!rc)
+            ret = WEECHAT_RC_ERROR;
+        else
+        {
+            ret = *rc;
+            free (rc);
+        }
+
+        return ret;
+    }
+
+    return WEECHAT_RC_ERROR;
+}
+
+API_FUNC(hook_batch)
+{
+    const char *hook, *function, *data;
+    int max_size, max_latency, rc;
+
+    API_INIT_FUNC(1, "hook_batch", API_RETURN_INT(0));
+    if (lua_gettop (L) < 5)
+        API_WRONG_ARGS(API_RETURN_INT(0));
+
+    hook = lua_tostring (L, -5);
+    max_size = lua_tonumber (L, -4);
+    max_latency = lua_tonumber (L, -3);
+    function = lua_tostring (L, -2);
+    data = lua_tostring (L, -1);
+
+    rc = plugin_script_api_hook_batch (weechat_lua_plugin,
+                                       lua_current_script,
+                                       API_STR2PTR(hook),
+                                       max_size,
+                                       max_latency,
+                                       &weechat_lua_api_hook_batch_cb,
+                                       function,
+                                       data);
+
+    API_RETURN_INT(rc);
+}
+
 API_FUNC(unhook)
 {
     const char *hook;
@@ -5297,6 +5361,7 @@ const struct luaL_Reg weechat_lua_api_funcs[] = {
     API_DEF_FUNC(hook_infolist),
     API_DEF_FUNC(hook_focus),
     API_DEF_FUNC(hook_set),
+    API_DEF_FUNC(hook_batch),
     API_DEF_FUNC(unhook),
     API_DEF_FUNC(unhook_all),
     API_DEF_FUNC(buffer_new),
@@ -77,6 +77,7 @@ struct t_plugin_script *lua_registered_script = NULL;
 const char *lua_current_script_filename = NULL;
 lua_State *lua_current_interpreter = NULL;
 char **lua_buffer_output = NULL;
+struct t_plugin_script_precompiled *lua_current_precompiled = NULL;
 
 /*
  * string used to execute action "install":
@@ -495,6 +496,101 @@ weechat_lua_register_lib (lua_State *L, const char *libname,
     lua_pop (L, 1);
 }
 
+#ifdef LUA_VERSION_NUM
+/*
+ * Writes a piece of chunk dumped by lua_dump in the buffer of a precompiled
+ * script.
+ *
+ * Returns:
+ *   0: OK
+ *   1: error
+ */
+
+int
+weechat_lua_precompile_writer (lua_State *L, const void *p, size_t sz,
+                               void *ud)
+{
+    struct t_lua_precompile_buffer *ptr_buffer;
+    char *new_buffer;
+    size_t new_size_alloc;
+
+    /* make C compiler happy */
+    (void) L;
+
+    ptr_buffer = (struct t_lua_precompile_buffer *)ud;
+
+    if (ptr_buffer->size + sz > ptr_buffer->size_alloc)
+    {
+        new_size_alloc = (ptr_buffer->size_alloc > 0) ?
+            ptr_buffer->size_alloc : 4096;
+        while (new_size_alloc < ptr_buffer->size + sz)
+        {
+            new_size_alloc *= 2;
+        }
+        new_buffer = realloc (ptr_buffer->buffer, new_size_alloc);
+        if (!new_buffer)
+            return 1;
+        ptr_buffer->buffer = new_buffer;
+        ptr_buffer->size_alloc = new_size_alloc;
+    }
+
+    memcpy (ptr_buffer->buffer + ptr_buffer->size, p, sz);
+    ptr_buffer->size += sz;
+
+    return 0;
+}
+
+/*
+ * Precompiles a lua script to a binary chunk (called in a thread, on
+ * autoload): the file is parsed in a separate lua state, so that the chunk
+ * can then be loaded in main thread without parsing it again.
+ *
+ * Returns:
+ *   1: OK
+ *   0: error
+ */
+
+int
+weechat_lua_precompile_cb (struct t_plugin_script_precompiled *precompiled)
+{
+    lua_State *interpreter;
+    struct t_lua_precompile_buffer buffer;
+    int rc;
+
+    interpreter = luaL_newstate ();
+    if (!interpreter)
+        return 0;
+
+    if (luaL_loadfile (interpreter, precompiled->filename) != 0)
+    {
+        /* error will be displayed when the script is loaded */
+        lua_close (interpreter);
+        return 0;
+    }
+
+    memset (&buffer, 0, sizeof (buffer));
+#if LUA_VERSION_NUM >= 503
+    rc = lua_dump (interpreter, &weechat_lua_precompile_writer, &buffer, 0);
+#else
+    rc = lua_dump (interpreter, &weechat_lua_precompile_writer, &buffer);
+#endif /* LUA_VERSION_NUM >= 503 */
+    lua_close (interpreter);
+
+    if ((rc != 0) || !buffer.buffer)
+    {
+        if (buffer.buffer)
+            free (buffer.buffer);
+        return 0;
+    }
+
+    precompiled->buffer = buffer.buffer;
+    precompiled->size = (int)buffer.size;
+    precompiled->bytecode = 1;
+
+    return 1;
+}
+#endif /* LUA_VERSION_NUM */
+
 /*
  * Loads a lua script.
  *
@@ -508,6 +604,7 @@ struct t_plugin_script *
 weechat_lua_load (const char *filename, const char *code)
 {
     FILE *fp;
+    int rc;
     char *lua_redirect_output = {
         "function weechat_output_string(str)\n"
         "    weechat.__output__(str)\n"
@@ -607,8 +704,21 @@ weechat_lua_load (const char *filename, const char *code)
     }
     else
     {
-        /* read and execute code from file */
-        if (luaL_loadfile (lua_current_interpreter, filename) != 0)
+        /* read and execute code from file (or precompiled on autoload) */
+#ifdef LUA_VERSION_NUM
+        if (lua_current_precompiled)
+        {
+            rc = luaL_loadbuffer (lua_current_interpreter,
+                                  lua_current_precompiled->buffer,
+                                  lua_current_precompiled->size,
+                                  filename);
+        }
+        else
+            rc = luaL_loadfile (lua_current_interpreter, filename);
+#else
+        rc = luaL_loadfile (lua_current_interpreter, filename);
+#endif /* LUA_VERSION_NUM */
+        if (rc != 0)
         {
             weechat_printf (NULL,
                             weechat_gettext ("%s%s: unable to load file \"%s\""),
@@ -693,15 +803,17 @@ weechat_lua_load (const char *filename, const char *code)
 
 /*
  * Callback for weechat_script_auto_load() function.
+ *
+ * Argument "data" is the script precompiled in a thread (NULL if the script
+ * was not precompiled).
  */
 
 void
 weechat_lua_load_cb (void *data, const char *filename)
 {
-    /* make C compiler happy */
-    (void) data;
-
+    lua_current_precompiled = (struct t_plugin_script_precompiled *)data;
     weechat_lua_load (filename, NULL);
+    lua_current_precompiled = NULL;
 }
 
 /*
@@ -922,12 +1034,12 @@ weechat_lua_command_cb (const void *pointer, void *data,
         }
         else if (weechat_strcasecmp (argv[1], "autoload") == 0)
         {
-            plugin_script_auto_load (weechat_lua_plugin, &weechat_lua_load_cb);
+            plugin_script_auto_load (weechat_lua_plugin, &lua_data);
         }
         else if (weechat_strcasecmp (argv[1], "reload") == 0)
         {
             weechat_lua_unload_all ();
-            plugin_script_auto_load (weechat_lua_plugin, &weechat_lua_load_cb);
+            plugin_script_auto_load (weechat_lua_plugin, &lua_data);
         }
         else if (weechat_strcasecmp (argv[1], "unload") == 0)
         {
@@ -1264,6 +1376,9 @@ weechat_plugin_init (struct t_weechat_plugin *plugin, int argc, char *argv[])
     lua_data.callback_signal_debug_dump = &weechat_lua_signal_debug_dump_cb;
     lua_data.callback_signal_script_action = &weechat_lua_signal_script_action_cb;
     lua_data.callback_load_file = &weechat_lua_load_cb;
+#ifdef LUA_VERSION_NUM
+    lua_data.callback_precompile_file = &weechat_lua_precompile_cb;
+#endif /* LUA_VERSION_NUM */
     lua_data.unload_all = &weechat_lua_unload_all;
 
     lua_quiet = 1;
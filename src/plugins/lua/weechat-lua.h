@@ -33,6 +33,13 @@ struct t_lua_const
     char *str_value;
 };
 
+struct t_lua_precompile_buffer
+{
+    char *buffer;                      /* binary chunk dumped by lua_dump   */
+    size_t size;                       /* size of chunk                     */
+    size_t size_alloc;                 /* allocated size for buffer         */
+};
+
 extern struct t_weechat_plugin *weechat_lua_plugin;
 
 extern struct t_plugin_script_data lua_data;
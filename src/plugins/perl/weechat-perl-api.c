@@ -3233,6 +3233,64 @@ API_FUNC(hook_set)
     API_RETURN_OK;
 }
 
+int
+weechat_perl_api_hook_batch_cb (const void *pointer, void *data,
+                               struct t_infolist *events)
+{
+    struct t_plugin_script *script;
+    void *func_argv[2];
+    char empty_arg[1] = { '\0' };
+    const char *ptr_function, *ptr_data;
+    int *rc, ret;
+
+    script = (struct t_plugin_script *)pointer;
+    plugin_script_get_function_and_data (data, &ptr_function, &ptr_data);
+
+    if (ptr_function && ptr_function[0])
+    {
+        func_argv[0] = (ptr_data) ? (char *)ptr_data : empty_arg;
+        func_argv[1] = (char *)API_PTR2STR(events);
+
+        rc = (int *) weechat_perl_exec (script,
+                                        WEECHAT_SCRIPT_EXEC_INT,
+                                        ptr_function,
+                                        "ss", func_argv);
+
+        if (!rc)
+            ret = WEECHAT_RC_ERROR;
+        else
+        {
+            ret = *rc;
+            free (rc);
+        }
+
+        return ret;
+    }
+
+    return WEECHAT_RC_ERROR;
+}
+
+API_FUNC(hook_batch)
+{
+    int rc;
+    dXSARGS;
+
+    API_INIT_FUNC(1, "hook_batch", API_RETURN_INT(0));
+    if (items < 5)
+        API_WRONG_ARGS(API_RETURN_INT(0));
+
+    rc = plugin_script_api_hook_batch (weechat_perl_plugin,
+                                       perl_current_script,
+                                       API_STR2PTR(SvPV_nolen (ST (0))), /* hook */
+                                       SvIV (ST (1)), /* max_size */
+                                       SvIV (ST (2)), /* max_latency */
+                                       &weechat_perl_api_hook_batch_cb,
+                                       SvPV_nolen (ST (3)), /* perl function */
+                                       SvPV_nolen (ST (4))); /* data */
+
+    API_RETURN_INT(rc);
+}
+
 API_FUNC(unhook)
 {
     dXSARGS;
@@ -5254,6 +5312,7 @@ weechat_perl_api_init (pTHX)
     API_DEF_FUNC(hook_infolist);
     API_DEF_FUNC(hook_focus);
     API_DEF_FUNC(hook_set);
+    API_DEF_FUNC(hook_batch);
     API_DEF_FUNC(unhook);
     API_DEF_FUNC(unhook_all);
     API_DEF_FUNC(buffer_new);
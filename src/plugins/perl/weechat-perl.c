@@ -904,12 +904,12 @@ weechat_perl_command_cb (const void *pointer, void *data,
         }
         else if (weechat_strcasecmp (argv[1], "autoload") == 0)
         {
-            plugin_script_auto_load (weechat_perl_plugin, &weechat_perl_load_cb);
+            plugin_script_auto_load (weechat_perl_plugin, &perl_data);
         }
         else if (weechat_strcasecmp (argv[1], "reload") == 0)
         {
             weechat_perl_unload_all ();
-            plugin_script_auto_load (weechat_perl_plugin, &weechat_perl_load_cb);
+            plugin_script_auto_load (weechat_perl_plugin, &perl_data);
         }
         else if (weechat_strcasecmp (argv[1], "unload") == 0)
         {
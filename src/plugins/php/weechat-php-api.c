@@ -3112,6 +3112,54 @@ API_FUNC(hook_set)
     API_RETURN_OK;
 }
 
+static int
+weechat_php_api_hook_batch_cb (const void *pointer, void *data,
+                               struct t_infolist *events)
+{
+    int rc;
+    void *func_argv[2];
+
+    func_argv[1] = (char *)API_PTR2STR(events);
+
+    weechat_php_cb (pointer, data, func_argv, "ss",
+                    WEECHAT_SCRIPT_EXEC_INT, &rc);
+
+    return rc;
+}
+
+API_FUNC(hook_batch)
+{
+    zend_string *z_hook, *z_data;
+    zend_long z_max_size, z_max_latency;
+    zval *z_callback;
+    struct t_hook *hook;
+    int max_size, max_latency, rc;
+    char *data;
+
+    API_INIT_FUNC(1, "hook_batch", API_RETURN_INT(0));
+    if (zend_parse_parameters (ZEND_NUM_ARGS(), "SllzS", &z_hook, &z_max_size,
+                               &z_max_latency, &z_callback,
+                               &z_data) == FAILURE)
+        API_WRONG_ARGS(API_RETURN_INT(0));
+
+    hook = (struct t_hook *)API_STR2PTR(ZSTR_VAL(z_hook));
+    max_size = (int)z_max_size;
+    max_latency = (int)z_max_latency;
+    weechat_php_get_function_name (z_callback, callback_name);
+    data = ZSTR_VAL(z_data);
+
+    rc = plugin_script_api_hook_batch (weechat_php_plugin,
+                                       php_current_script,
+                                       hook,
+                                       max_size,
+                                       max_latency,
+                                       &weechat_php_api_hook_batch_cb,
+                                       (const char *)callback_name,
+                                       (const char *)data);
+
+    API_RETURN_INT(rc);
+}
+
 API_FUNC(unhook)
 {
     zend_string *z_hook;
@@ -150,6 +150,7 @@ PHP_FUNCTION(weechat_hook_info_hashtable);
 PHP_FUNCTION(weechat_hook_infolist);
 PHP_FUNCTION(weechat_hook_focus);
 PHP_FUNCTION(weechat_hook_set);
+PHP_FUNCTION(weechat_hook_batch);
 PHP_FUNCTION(weechat_unhook);
 PHP_FUNCTION(weechat_unhook_all);
 PHP_FUNCTION(weechat_buffer_new);
@@ -203,6 +203,7 @@ const zend_function_entry weechat_functions[] = {
     PHP_FE(weechat_hook_infolist, NULL)
     PHP_FE(weechat_hook_focus, NULL)
     PHP_FE(weechat_hook_set, NULL)
+    PHP_FE(weechat_hook_batch, NULL)
     PHP_FE(weechat_unhook, NULL)
     PHP_FE(weechat_unhook_all, NULL)
     PHP_FE(weechat_buffer_new, NULL)
@@ -906,12 +907,12 @@ weechat_php_command_cb (const void *pointer, void *data,
         }
         else if (weechat_strcasecmp (argv[1], "autoload") == 0)
         {
-            plugin_script_auto_load (weechat_php_plugin, &weechat_php_load_cb);
+            plugin_script_auto_load (weechat_php_plugin, &php_data);
         }
         else if (weechat_strcasecmp (argv[1], "reload") == 0)
         {
             weechat_php_unload_all ();
-            plugin_script_auto_load (weechat_php_plugin, &weechat_php_load_cb);
+            plugin_script_auto_load (weechat_php_plugin, &php_data);
         }
         else if (weechat_strcasecmp (argv[1], "unload") == 0)
         {
@@ -32,6 +32,7 @@
 #include "../core/weechat.h"
 #include "../core/wee-config.h"
 #include "../core/wee-crypto.h"
+#include "../core/wee-debug.h"
 #include "../core/wee-hook.h"
 #include "../core/wee-infolist.h"
 #include "../core/wee-proxy.h"
@@ -888,6 +889,24 @@ error:
     return NULL;
 }
 
+/*
+ * Returns WeeChat info_hashtable "loop_stats": statistics on main loop.
+ */
+
+struct t_hashtable *
+plugin_api_info_hashtable_loop_stats_cb (const void *pointer, void *data,
+                                         const char *info_name,
+                                         struct t_hashtable *hashtable)
+{
+    /* make C compiler happy */
+    (void) pointer;
+    (void) data;
+    (void) info_name;
+    (void) hashtable;
+
+    return debug_loop_stats_hashtable ();
+}
+
 /*
  * Returns WeeChat infolist "bar".
  *
@@ -1300,6 +1319,37 @@ plugin_api_infolist_hook_cb (const void *pointer, void *data,
     return ptr_infolist;
 }
 
+/*
+ * Returns WeeChat infolist "hook_profile".
+ *
+ * Note: result must be freed after use with function weechat_infolist_free().
+ */
+
+struct t_infolist *
+plugin_api_infolist_hook_profile_cb (const void *pointer, void *data,
+                                     const char *infolist_name,
+                                     void *obj_pointer, const char *arguments)
+{
+    struct t_infolist *ptr_infolist;
+
+    /* make C compiler happy */
+    (void) pointer;
+    (void) data;
+    (void) infolist_name;
+    (void) obj_pointer;
+
+    ptr_infolist = infolist_new (NULL);
+    if (!ptr_infolist)
+        return NULL;
+
+    if (!hook_profile_add_to_infolist (ptr_infolist, arguments))
+    {
+        infolist_free (ptr_infolist);
+        return NULL;
+    }
+    return ptr_infolist;
+}
+
 /*
  * Returns WeeChat infolist "hotlist".
  *
@@ -1859,6 +1909,22 @@ plugin_api_info_init ()
                   "passwords before/after to test (optional, 0 by default)"),
                &plugin_api_info_totp_validate_cb, NULL, NULL);
 
+    /* WeeChat core info_hashtable hooks */
+    hook_info_hashtable (
+        NULL, "loop_stats",
+        N_("statistics on main loop (times are in microseconds)"),
+        NULL,
+        /* TRANSLATORS: please do not translate key names (enclosed by quotes) */
+        N_("\"iterations\": number of iterations, "
+           "\"stalls\": number of stalls detected, "
+           "\"stall_threshold\": stall threshold (in milliseconds), "
+           "\"xxx_avg\", \"xxx_p50\", \"xxx_p90\", \"xxx_p99\", "
+           "\"xxx_max\": average, percentiles and max time of phase "
+           "\"xxx\" in iterations, where \"xxx\" is one of: "
+           "\"timers\", \"refresh\", \"poll\", \"fd\", \"process\", "
+           "\"busy\" (all phases except poll)"),
+        &plugin_api_info_hashtable_loop_stats_cb, NULL, NULL);
+
     /* WeeChat core infolist hooks */
     hook_infolist (NULL, "bar",
                    N_("list of bars"),
@@ -1902,6 +1968,13 @@ plugin_api_info_init ()
                       "get only some hooks (wildcard \"*\" is allowed), "
                       "both are optional)"),
                    &plugin_api_infolist_hook_cb, NULL, NULL);
+    hook_infolist (NULL, "hook_profile",
+                   N_("profiling of hook callbacks by plugin/script (see "
+                      "/debug hooks_profile)"),
+                   NULL,
+                   N_("plugin or \"plugin/script\" name (wildcard \"*\" is "
+                      "allowed) (optional)"),
+                   &plugin_api_infolist_hook_profile_cb, NULL, NULL);
     hook_infolist (NULL, "hotlist",
                    N_("list of buffers in hotlist"),
                    NULL,
@@ -659,6 +659,9 @@ plugin_api_init ()
                 &gui_filter_hdata_filter_cb, NULL, NULL);
     hook_hdata (NULL, "history", N_("history of commands in buffer"),
                 &gui_history_hdata_history_cb, NULL, NULL);
+    hook_hdata (NULL, "hook_profile",
+                N_("profiling of hook callbacks by plugin/script"),
+                &hook_hdata_hook_profile_cb, NULL, NULL);
     hook_hdata (NULL, "hotlist", N_("hotlist"),
                 &gui_hotlist_hdata_hotlist_cb, NULL, NULL);
     hook_hdata (NULL, "input_undo", N_("structure with undo for input line"),
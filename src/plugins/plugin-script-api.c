@@ -1164,6 +1164,85 @@ plugin_script_api_hook_focus (struct t_weechat_plugin *weechat_plugin,
     return new_hook;
 }
 
+/*
+ * Checks if a hook has been created by a script (the hook "subplugin" is the
+ * script name).
+ *
+ * Returns:
+ *   1: hook created by the script
+ *   0: hook not found or created by another script or plugin
+ */
+
+int
+plugin_script_api_hook_is_script (struct t_weechat_plugin *weechat_plugin,
+                                  struct t_plugin_script *script,
+                                  struct t_hook *hook)
+{
+    struct t_infolist *infolist;
+    const char *ptr_subplugin;
+    int rc;
+
+    if (!script || !hook)
+        return 0;
+
+    rc = 0;
+
+    infolist = weechat_infolist_get ("hook", hook, NULL);
+    if (infolist)
+    {
+        if (weechat_infolist_next (infolist))
+        {
+            ptr_subplugin = weechat_infolist_string (infolist, "subplugin");
+            if (ptr_subplugin && (strcmp (ptr_subplugin, script->name) == 0))
+                rc = 1;
+        }
+        weechat_infolist_free (infolist);
+    }
+
+    return rc;
+}
+
+/*
+ * Enables (or disables if function is NULL or empty) delivery of events by
+ * batches in a print or signal hook.
+ *
+ * The hook must have been created by the script: the callback of batch
+ * receives the script pointer, so it must not outlive the script.
+ *
+ * Returns:
+ *   1: OK
+ *   0: error
+ */
+
+int
+plugin_script_api_hook_batch (struct t_weechat_plugin *weechat_plugin,
+                              struct t_plugin_script *script,
+                              struct t_hook *hook,
+                              int max_size,
+                              int max_latency,
+                              int (*callback)(const void *pointer,
+                                              void *data,
+                                              struct t_infolist *events),
+                              const char *function,
+                              const char *data)
+{
+    char *function_and_data;
+
+    if (!plugin_script_api_hook_is_script (weechat_plugin, script, hook))
+        return 0;
+
+    if (!function || !function[0])
+    {
+        return weechat_hook_batch (hook, max_size, max_latency,
+                                   NULL, NULL, NULL);
+    }
+
+    function_and_data = plugin_script_build_function_and_data (function, data);
+
+    return weechat_hook_batch (hook, max_size, max_latency,
+                               callback, script, function_and_data);
+}
+
 /*
  * Creates a new buffer.
  */
@@ -328,6 +328,19 @@ extern struct t_hook *plugin_script_api_hook_focus (struct t_weechat_plugin *wee
                                                                                     struct t_hashtable *info),
                                                     const char *function,
                                                     const char *data);
+extern int plugin_script_api_hook_is_script (struct t_weechat_plugin *weechat_plugin,
+                                             struct t_plugin_script *script,
+                                             struct t_hook *hook);
+extern int plugin_script_api_hook_batch (struct t_weechat_plugin *weechat_plugin,
+                                         struct t_plugin_script *script,
+                                         struct t_hook *hook,
+                                         int max_size,
+                                         int max_latency,
+                                         int (*callback)(const void *pointer,
+                                                         void *data,
+                                                         struct t_infolist *events),
+                                         const char *function,
+                                         const char *data);
 extern struct t_gui_buffer *plugin_script_api_buffer_new (struct t_weechat_plugin *weechat_plugin,
                                                           struct t_plugin_script *script,
                                                           const char *name,
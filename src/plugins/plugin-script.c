@@ -27,8 +27,11 @@
 #include <libgen.h>
 #include <string.h>
 #include <ctype.h>
+#include <signal.h>
+#include <pthread.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/time.h>
 #include <dirent.h>
 
 #include "weechat-plugin.h"
@@ -36,6 +39,23 @@
 #include "plugin-script-config.h"
 
 
+/*
+ * this file is linked in each script plugin and plugins are loaded with
+ * RTLD_GLOBAL: a global function may be resolved to the copy of another
+ * plugin, so the state of each plugin is in its t_plugin_script_data
+ */
+
+struct t_plugin_script_precompile_queue
+{
+    int (*callback_precompile) (struct t_plugin_script_precompiled *precompiled);
+                                         /* callback to precompile a script */
+    struct t_plugin_script_precompiled *scripts; /* scripts to precompile   */
+    int count;                           /* number of scripts               */
+    int next;                            /* next script to precompile       */
+    pthread_mutex_t mutex;               /* mutex to get next script        */
+};
+
+
 /*
  * Displays name and version of interpreter used.
  */
@@ -85,6 +105,81 @@ plugin_script_signal_debug_libs_cb (const void *pointer, void *data,
     return WEECHAT_RC_OK;
 }
 
+/*
+ * Callback for signal "debug_startup": displays time spent to precompile and
+ * load each script in last autoload.
+ */
+
+int
+plugin_script_signal_debug_startup_cb (const void *pointer, void *data,
+                                       const char *signal,
+                                       const char *type_data,
+                                       void *signal_data)
+{
+    struct t_weechat_plugin *weechat_plugin;
+    struct t_plugin_script_startups *startups;
+    struct t_plugin_script_startup *ptr_startup;
+    char str_precompile[64];
+    long total;
+    int count;
+
+    /* make C compiler happy */
+    (void) data;
+    (void) signal;
+    (void) type_data;
+    (void) signal_data;
+
+    startups = (struct t_plugin_script_startups *)pointer;
+    weechat_plugin = startups->weechat_plugin;
+
+    total = 0;
+    count = 0;
+    for (ptr_startup = startups->startup; ptr_startup;
+         ptr_startup = ptr_startup->next_startup)
+    {
+        total += ptr_startup->time_load;
+        count++;
+    }
+
+    weechat_printf (NULL, "  %s:", weechat_plugin->name);
+    if (startups->threads > 0)
+    {
+        weechat_printf (NULL,
+                        "    %12.3f ms  precompile of %d scripts "
+                        "(%d threads)",
+                        ((double)startups->time_precompile) / 1000,
+                        count,
+                        startups->threads);
+    }
+    weechat_printf (NULL, "    %12.3f ms  load of %d scripts",
+                    ((double)total) / 1000, count);
+    if (count == 0)
+        return WEECHAT_RC_OK;
+
+    weechat_printf (NULL, "    %12s %12s  %s",
+                    "precomp (ms)", "load (ms)", "script");
+    for (ptr_startup = startups->startup; ptr_startup;
+         ptr_startup = ptr_startup->next_startup)
+    {
+        if (ptr_startup->time_precompile >= 0)
+        {
+            snprintf (str_precompile, sizeof (str_precompile), "%12.3f",
+                      ((double)ptr_startup->time_precompile) / 1000);
+        }
+        else
+        {
+            snprintf (str_precompile, sizeof (str_precompile), "%12s", "-");
+        }
+        weechat_printf (NULL, "    %s %12.3f  %s%s",
+                        str_precompile,
+                        ((double)ptr_startup->time_load) / 1000,
+                        ptr_startup->filename,
+                        (ptr_startup->bytecode) ? " (bytecode)" : "");
+    }
+
+    return WEECHAT_RC_OK;
+}
+
 /*
  * Callback for info "xxx_interpreter".
  */
@@ -257,6 +352,12 @@ plugin_script_init (struct t_weechat_plugin *weechat_plugin,
                          plugin_script_signal_debug_libs_cb,
                          weechat_plugin, NULL);
 
+    /* add signal for "debug_startup" */
+    plugin_data->startups.weechat_plugin = weechat_plugin;
+    weechat_hook_signal ("debug_startup",
+                         plugin_script_signal_debug_startup_cb,
+                         &plugin_data->startups, NULL);
+
     /* add signals for script actions (install/remove/autoload) */
     for (i = 0; action_signals[i]; i++)
     {
@@ -290,10 +391,7 @@ plugin_script_init (struct t_weechat_plugin *weechat_plugin,
 
     /* autoload scripts */
     if (auto_load_scripts)
-    {
-        plugin_script_auto_load (weechat_plugin,
-                                 plugin_data->callback_load_file);
-    }
+        plugin_script_auto_load (weechat_plugin, plugin_data);
 }
 
 /*
@@ -327,6 +425,9 @@ plugin_script_valid (struct t_plugin_script *scripts,
 /*
  * Converts a pointer to a string for usage in a script.
  *
+ * The conversion is done without snprintf, because it is called for all
+ * pointers returned to scripts.
+ *
  * Returns string with format "0x12345678".
  */
 
@@ -335,6 +436,10 @@ plugin_script_ptr2str (void *pointer)
 {
     static char str_pointer[32][32];
     static int index_pointer = 0;
+    static const char *hex_digits = "0123456789abcdef";
+    char buffer[32];
+    unsigned long value;
+    int length, i;
 
     index_pointer = (index_pointer + 1) % 32;
     str_pointer[index_pointer][0] = '\0';
@@ -342,8 +447,22 @@ plugin_script_ptr2str (void *pointer)
     if (!pointer)
         return str_pointer[index_pointer];
 
-    snprintf (str_pointer[index_pointer], sizeof (str_pointer[index_pointer]),
-              "0x%lx", (unsigned long)pointer);
+    /* digits are built in reverse order */
+    value = (unsigned long)pointer;
+    length = 0;
+    while (value > 0)
+    {
+        buffer[length++] = hex_digits[value & 0xF];
+        value >>= 4;
+    }
+
+    str_pointer[index_pointer][0] = '0';
+    str_pointer[index_pointer][1] = 'x';
+    for (i = 0; i < length; i++)
+    {
+        str_pointer[index_pointer][2 + i] = buffer[length - 1 - i];
+    }
+    str_pointer[index_pointer][2 + length] = '\0';
 
     return str_pointer[index_pointer];
 }
@@ -351,7 +470,8 @@ plugin_script_ptr2str (void *pointer)
 /*
  * Converts a string to pointer for usage outside a script.
  *
- * Format of "str_pointer" is "0x12345678".
+ * Format of "str_pointer" is "0x12345678" (hexadecimal digits after "0x"
+ * are read until the first invalid char).
  */
 
 void *
@@ -360,7 +480,8 @@ plugin_script_str2ptr (struct t_weechat_plugin *weechat_plugin,
                        const char *str_pointer)
 {
     unsigned long value;
-    int rc;
+    const char *ptr_string;
+    int digits;
     struct t_gui_buffer *ptr_buffer;
 
     if (!str_pointer || !str_pointer[0])
@@ -369,8 +490,21 @@ plugin_script_str2ptr (struct t_weechat_plugin *weechat_plugin,
     if ((str_pointer[0] != '0') || (str_pointer[1] != 'x'))
         goto invalid;
 
-    rc = sscanf (str_pointer + 2, "%lx", &value);
-    if ((rc != EOF) && (rc >= 1))
+    value = 0;
+    digits = 0;
+    for (ptr_string = str_pointer + 2; ptr_string[0]; ptr_string++)
+    {
+        if ((ptr_string[0] >= '0') && (ptr_string[0] <= '9'))
+            value = (value << 4) | (unsigned long)(ptr_string[0] - '0');
+        else if ((ptr_string[0] >= 'a') && (ptr_string[0] <= 'f'))
+            value = (value << 4) | (unsigned long)(ptr_string[0] - 'a' + 10);
+        else if ((ptr_string[0] >= 'A') && (ptr_string[0] <= 'F'))
+            value = (value << 4) | (unsigned long)(ptr_string[0] - 'A' + 10);
+        else
+            break;
+        digits++;
+    }
+    if (digits > 0)
         return (void *)value;
 
 invalid:
@@ -452,17 +586,207 @@ plugin_script_get_function_and_data (void *callback_data,
     }
 }
 
+/*
+ * Frees time spent to load scripts in last autoload.
+ */
+
+void
+plugin_script_startup_free_all (struct t_plugin_script_startups *startups)
+{
+    struct t_plugin_script_startup *ptr_next_startup;
+
+    while (startups->startup)
+    {
+        ptr_next_startup = startups->startup->next_startup;
+        free (startups->startup->filename);
+        free (startups->startup);
+        startups->startup = ptr_next_startup;
+    }
+    startups->last_startup = NULL;
+    startups->threads = 0;
+    startups->time_precompile = 0;
+}
+
+/*
+ * Adds time spent to load a script in list (for "/debug startup").
+ */
+
+void
+plugin_script_startup_add (struct t_plugin_script_startups *startups,
+                           const char *filename, long time_precompile,
+                           int bytecode, long time_load)
+{
+    struct t_plugin_script_startup *new_startup;
+    const char *ptr_name;
+
+    new_startup = malloc (sizeof (*new_startup));
+    if (!new_startup)
+        return;
+
+    ptr_name = strrchr (filename, '/');
+    new_startup->filename = strdup ((ptr_name) ? ptr_name + 1 : filename);
+    if (!new_startup->filename)
+    {
+        free (new_startup);
+        return;
+    }
+    new_startup->time_precompile = time_precompile;
+    new_startup->bytecode = bytecode;
+    new_startup->time_load = time_load;
+    new_startup->next_startup = NULL;
+
+    if (startups->last_startup)
+        startups->last_startup->next_startup = new_startup;
+    else
+        startups->startup = new_startup;
+    startups->last_startup = new_startup;
+}
+
+/*
+ * Adds a file found in autoload directory to the list of scripts to load.
+ */
+
+void
+plugin_script_auto_load_add_file_cb (void *data, const char *filename)
+{
+    struct t_plugin_script_precompile_queue *queue;
+    struct t_plugin_script_precompiled *new_scripts;
+    char *name;
+
+    queue = (struct t_plugin_script_precompile_queue *)data;
+
+    name = strdup (filename);
+    if (!name)
+        return;
+
+    new_scripts = realloc (queue->scripts,
+                           (queue->count + 1) * sizeof (queue->scripts[0]));
+    if (!new_scripts)
+    {
+        free (name);
+        return;
+    }
+    queue->scripts = new_scripts;
+    memset (&queue->scripts[queue->count], 0, sizeof (queue->scripts[0]));
+    queue->scripts[queue->count].filename = name;
+    queue->scripts[queue->count].time_precompile = -1;
+    queue->count++;
+}
+
+/*
+ * Precompiles scripts of the queue, until the queue is empty.
+ *
+ * This function runs in threads (and in main thread): it must not use any
+ * WeeChat API function, except callback of precompile which must be
+ * thread-safe.
+ */
+
+void *
+plugin_script_precompile_thread (void *data)
+{
+    struct t_plugin_script_precompile_queue *queue;
+    struct t_plugin_script_precompiled *ptr_script;
+    struct timeval time_start, time_end;
+    struct stat st;
+    int index;
+
+    queue = (struct t_plugin_script_precompile_queue *)data;
+
+    while (1)
+    {
+        pthread_mutex_lock (&queue->mutex);
+        index = queue->next++;
+        pthread_mutex_unlock (&queue->mutex);
+
+        if (index >= queue->count)
+            break;
+
+        ptr_script = &queue->scripts[index];
+        gettimeofday (&time_start, NULL);
+        if (stat (ptr_script->filename, &st) == 0)
+        {
+            ptr_script->file_mtime = (long long)st.st_mtime;
+            ptr_script->file_size = (long long)st.st_size;
+            if (!(queue->callback_precompile) (ptr_script)
+                && ptr_script->buffer)
+            {
+                free (ptr_script->buffer);
+                ptr_script->buffer = NULL;
+                ptr_script->size = 0;
+            }
+        }
+        gettimeofday (&time_end, NULL);
+        ptr_script->time_precompile =
+            ((long)(time_end.tv_sec - time_start.tv_sec) * 1000000)
+            + (long)(time_end.tv_usec - time_start.tv_usec);
+    }
+
+    return NULL;
+}
+
+/*
+ * Precompiles scripts of the queue in threads (at most
+ * WEECHAT_SCRIPT_PRECOMPILE_MAX_THREADS threads).
+ *
+ * Returns the number of threads used (including main thread).
+ */
+
+int
+plugin_script_precompile (struct t_plugin_script_precompile_queue *queue)
+{
+    pthread_t threads[WEECHAT_SCRIPT_PRECOMPILE_MAX_THREADS];
+    sigset_t set, old_set;
+    int i, num_threads;
+
+    queue->next = 0;
+    pthread_mutex_init (&queue->mutex, NULL);
+
+    /* start threads (signals are blocked in them), main thread works too */
+    num_threads = 0;
+    sigfillset (&set);
+    pthread_sigmask (SIG_SETMASK, &set, &old_set);
+    for (i = 1;
+         (i < WEECHAT_SCRIPT_PRECOMPILE_MAX_THREADS) && (i < queue->count);
+         i++)
+    {
+        if (pthread_create (&threads[num_threads], NULL,
+                            &plugin_script_precompile_thread, queue) == 0)
+        {
+            num_threads++;
+        }
+    }
+    pthread_sigmask (SIG_SETMASK, &old_set, NULL);
+
+    plugin_script_precompile_thread (queue);
+
+    for (i = 0; i < num_threads; i++)
+    {
+        pthread_join (threads[i], NULL);
+    }
+
+    pthread_mutex_destroy (&queue->mutex);
+
+    return num_threads + 1;
+}
+
 /*
  * Auto-loads all scripts in a directory.
+ *
+ * If the plugin can precompile scripts, all scripts are first precompiled
+ * in threads, then loaded in main thread (the callback receives a pointer to
+ * the precompiled script in "data", or NULL if the script could not be
+ * precompiled: then it is loaded from file as usual).
  */
 
 void
 plugin_script_auto_load (struct t_weechat_plugin *weechat_plugin,
-                         void (*callback)(void *data,
-                                          const char *filename))
+                         struct t_plugin_script_data *plugin_data)
 {
+    struct t_plugin_script_precompile_queue queue;
+    struct t_plugin_script_precompiled *ptr_script;
+    struct timeval time_start, time_end;
     char *dir_home, *dir_name;
-    int dir_length;
+    int dir_length, i;
 
     /* build directory, adding WeeChat home */
     dir_home = weechat_info_get ("weechat_dir", "");
@@ -478,7 +802,46 @@ plugin_script_auto_load (struct t_weechat_plugin *weechat_plugin,
 
     snprintf (dir_name, dir_length,
               "%s/%s/autoload", dir_home, weechat_plugin->name);
-    weechat_exec_on_files (dir_name, 0, 0, callback, NULL);
+
+    /* get list of scripts */
+    memset (&queue, 0, sizeof (queue));
+    queue.callback_precompile = plugin_data->callback_precompile_file;
+    weechat_exec_on_files (dir_name, 0, 0,
+                           &plugin_script_auto_load_add_file_cb, &queue);
+
+    plugin_script_startup_free_all (&plugin_data->startups);
+
+    /* precompile all scripts in threads */
+    if (queue.callback_precompile && (queue.count > 0))
+    {
+        gettimeofday (&time_start, NULL);
+        plugin_data->startups.threads = plugin_script_precompile (&queue);
+        gettimeofday (&time_end, NULL);
+        plugin_data->startups.time_precompile = weechat_util_timeval_diff (
+            &time_start, &time_end);
+    }
+
+    /* load scripts in main thread */
+    for (i = 0; i < queue.count; i++)
+    {
+        ptr_script = &queue.scripts[i];
+        gettimeofday (&time_start, NULL);
+        (plugin_data->callback_load_file) (
+            (ptr_script->buffer) ? ptr_script : NULL,
+            ptr_script->filename);
+        gettimeofday (&time_end, NULL);
+        plugin_script_startup_add (
+            &plugin_data->startups,
+            ptr_script->filename,
+            ptr_script->time_precompile,
+            (ptr_script->buffer) ? ptr_script->bytecode : 0,
+            weechat_util_timeval_diff (&time_start, &time_end));
+        if (ptr_script->buffer)
+            free (ptr_script->buffer);
+        free (ptr_script->filename);
+    }
+    if (queue.scripts)
+        free (queue.scripts);
 
     free (dir_home);
     free (dir_name);
@@ -720,6 +1083,7 @@ plugin_script_alloc (const char *filename, const char *name,
         strdup (shutdown_func) : NULL;
     new_script->charset = (charset) ? strdup (charset) : NULL;
     new_script->unloading = 0;
+    new_script->callables = NULL;
     new_script->prev_script = NULL;
     new_script->next_script = NULL;
 
@@ -1059,6 +1423,13 @@ plugin_script_remove (struct t_weechat_plugin *weechat_plugin,
     /* remove all hooks created by this script */
     weechat_unhook_all (script->name);
 
+    /* free cache of callables */
+    if (script->callables)
+    {
+        weechat_hashtable_free (script->callables);
+        script->callables = NULL;
+    }
+
     /* remove script from list */
     if (script->prev_script)
         (script->prev_script)->next_script = script->next_script;
@@ -1661,6 +2032,7 @@ plugin_script_hdata_script (struct t_weechat_plugin *weechat_plugin,
         WEECHAT_HDATA_VAR(struct t_plugin_script, shutdown_func, STRING, 0, NULL, NULL);
         WEECHAT_HDATA_VAR(struct t_plugin_script, charset, STRING, 0, NULL, NULL);
         WEECHAT_HDATA_VAR(struct t_plugin_script, unloading, INTEGER, 0, NULL, NULL);
+        WEECHAT_HDATA_VAR(struct t_plugin_script, callables, HASHTABLE, 0, NULL, NULL);
         WEECHAT_HDATA_VAR(struct t_plugin_script, prev_script, POINTER, 0, NULL, hdata_name);
         WEECHAT_HDATA_VAR(struct t_plugin_script, next_script, POINTER, 0, NULL, hdata_name);
         weechat_hdata_new_list (hdata, "scripts", scripts,
@@ -1791,6 +2163,8 @@ plugin_script_end (struct t_weechat_plugin *weechat_plugin,
                         weechat_plugin->name);
     }
 
+    plugin_script_startup_free_all (&plugin_data->startups);
+
     /* write config file (file: "<language>.conf") */
     weechat_config_write (*(plugin_data->config_file));
     weechat_config_free (*(plugin_data->config_file));
@@ -1825,6 +2199,7 @@ plugin_script_print_log (struct t_weechat_plugin *weechat_plugin,
         weechat_log_printf ("  shutdown_func . . . : '%s'",  ptr_script->shutdown_func);
         weechat_log_printf ("  charset . . . . . . : '%s'",  ptr_script->charset);
         weechat_log_printf ("  unloading . . . . . : %d",    ptr_script->unloading);
+        weechat_log_printf ("  callables . . . . . : 0x%lx", ptr_script->callables);
         weechat_log_printf ("  prev_script . . . . : 0x%lx", ptr_script->prev_script);
         weechat_log_printf ("  next_script . . . . : 0x%lx", ptr_script->next_script);
     }
@@ -35,6 +35,9 @@ enum t_weechat_script_exec_type
 
 #define WEECHAT_SCRIPT_EVAL_NAME "__eval__"
 
+/* max number of threads used to precompile scripts on autoload */
+#define WEECHAT_SCRIPT_PRECOMPILE_MAX_THREADS 4
+
 #define WEECHAT_SCRIPT_MSG_NOT_INIT(__current_script,                   \
                                     __function)                         \
     weechat_printf (NULL,                                               \
@@ -66,10 +69,42 @@ struct t_plugin_script
     char *shutdown_func;                 /* function when script is unloaded*/
     char *charset;                       /* script charset                  */
     int unloading;                       /* script is being unloaded        */
+    struct t_hashtable *callables;       /* callables found by name (cache, */
+                                         /* values are set by plugin)       */
     struct t_plugin_script *prev_script; /* link to previous script         */
     struct t_plugin_script *next_script; /* link to next script             */
 };
 
+struct t_plugin_script_precompiled
+{
+    char *filename;                      /* name of script on disk          */
+    long long file_mtime;                /* modification time of file       */
+    long long file_size;                 /* size of file                    */
+    char *buffer;                        /* precompiled code (or source)    */
+    int size;                            /* size of buffer                  */
+    int bytecode;                        /* 1 if buffer contains bytecode   */
+    long time_precompile;                /* time spent in thread (µs)       */
+};
+
+struct t_plugin_script_startup
+{
+    char *filename;                      /* name of script on disk          */
+    long time_precompile;                /* time spent in thread (µs),      */
+                                         /* -1 if not precompiled           */
+    int bytecode;                        /* 1 if precompiled to bytecode    */
+    long time_load;                      /* time spent to load script (µs)  */
+    struct t_plugin_script_startup *next_startup; /* link to next script    */
+};
+
+struct t_plugin_script_startups
+{
+    struct t_weechat_plugin *weechat_plugin; /* plugin                      */
+    struct t_plugin_script_startup *startup; /* scripts loaded on autoload  */
+    struct t_plugin_script_startup *last_startup; /* last script loaded     */
+    int threads;                         /* threads used to precompile      */
+    long time_precompile;                /* time spent to precompile (µs)   */
+};
+
 struct t_plugin_script_data
 {
     /* variables */
@@ -108,9 +143,13 @@ struct t_plugin_script_data
                                           const char *type_data,
                                           void *signal_data);
     void (*callback_load_file) (void *data, const char *filename);
+    int (*callback_precompile_file) (struct t_plugin_script_precompiled *precompiled);
 
     /* functions */
     void (*unload_all) ();
+
+    /* time spent to load scripts in last autoload (for "/debug startup") */
+    struct t_plugin_script_startups startups;
 };
 
 extern void plugin_script_display_interpreter (struct t_weechat_plugin *plugin,
@@ -130,9 +169,9 @@ extern char *plugin_script_build_function_and_data (const char *function,
 extern void plugin_script_get_function_and_data (void *callback_data,
                                                  const char **function,
                                                  const char **data);
+extern void plugin_script_startup_free_all (struct t_plugin_script_startups *startups);
 extern void plugin_script_auto_load (struct t_weechat_plugin *weechat_plugin,
-                                     void (*callback)(void *data,
-                                                      const char *filename));
+                                     struct t_plugin_script_data *plugin_data);
 extern struct t_plugin_script *plugin_script_search (struct t_weechat_plugin *weechat_plugin,
                                                      struct t_plugin_script *scripts,
                                                      const char *name);
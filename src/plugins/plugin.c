@@ -32,12 +32,14 @@
 #include <string.h>
 #include <sys/types.h>
 #include <sys/stat.h>
+#include <sys/time.h>
 #include <dirent.h>
 #include <dlfcn.h>
 
 #include "../core/weechat.h"
 #include "../core/wee-arraylist.h"
 #include "../core/wee-config.h"
+#include "../core/wee-debug.h"
 #include "../core/wee-eval.h"
 #include "../core/wee-hashtable.h"
 #include "../core/wee-hdata.h"
@@ -56,6 +58,7 @@
 #include "../gui/gui-chat.h"
 #include "../gui/gui-color.h"
 #include "../gui/gui-key.h"
+#include "../gui/gui-line.h"
 #include "../gui/gui-nicklist.h"
 #include "../gui/gui-window.h"
 #include "plugin.h"
@@ -333,6 +336,7 @@ plugin_call_init (struct t_weechat_plugin *plugin, int argc, char **argv)
     t_weechat_init_func *init_func;
     int plugin_argc, no_connect, rc, old_auto_connect;
     char **plugin_argv;
+    struct timeval time_start, time_end;
 
     if (plugin->initialized)
         return 1;
@@ -357,11 +361,16 @@ plugin_call_init (struct t_weechat_plugin *plugin, int argc, char **argv)
                          plugin->name,
                          plugin->priority);
     }
+    gettimeofday (&time_start, NULL);
     rc = ((t_weechat_init_func *)init_func) (plugin,
                                              plugin_argc, plugin_argv);
+    gettimeofday (&time_end, NULL);
     if (rc == WEECHAT_RC_OK)
     {
         plugin->initialized = 1;
+        debug_startup_add_plugin (plugin->name,
+                                  (long)util_timeval_diff (&time_start,
+                                                           &time_end));
     }
     else
     {
@@ -795,6 +804,7 @@ plugin_load (const char *filename, int init_plugin, int argc, char **argv)
         new_plugin->hook_hdata = &hook_hdata;
         new_plugin->hook_focus = &hook_focus;
         new_plugin->hook_set = &hook_set;
+        new_plugin->hook_batch = &hook_batch;
         new_plugin->unhook = &unhook;
         new_plugin->unhook_all = &unhook_all_plugin;
 
@@ -812,6 +822,9 @@ plugin_load (const char *filename, int init_plugin, int argc, char **argv)
         new_plugin->buffer_set_pointer = &gui_buffer_set_pointer;
         new_plugin->buffer_string_replace_local_var = &gui_buffer_string_replace_local_var;
         new_plugin->buffer_match_list = &gui_buffer_match_list;
+        new_plugin->buffer_lines_export = &gui_line_export;
+        new_plugin->buffer_lines_export_get = &gui_line_export_get;
+        new_plugin->buffer_lines_export_free = &gui_line_export_free;
 
         new_plugin->window_search_with_buffer = &gui_window_search_with_buffer;
         new_plugin->window_get_integer = &gui_window_get_integer;
@@ -3281,6 +3281,70 @@ API_FUNC(hook_set)
     API_RETURN_OK;
 }
 
+int
+weechat_python_api_hook_batch_cb (const void *pointer, void *data,
+                                  struct t_infolist *events)
+{
+    struct t_plugin_script *script;
+    void *func_argv[2];
+    char empty_arg[1] = { '\0' };
+    const char *ptr_function, *ptr_data;
+    int *rc, ret;
+
+    script = (struct t_plugin_script *)pointer;
+    plugin_script_get_function_and_data (data, &ptr_function, &ptr_data);
+
+    if (ptr_function && ptr_function[0])
+    {
+        func_argv[0] = (ptr_data) ? (char *)ptr_data : empty_arg;
+        func_argv[1] = (char *)API_PTR2STR(events);
+
+        rc = (int *) weechat_python_exec (script,
+                                          WEECHAT_SCRIPT_EXEC_INT,
+                                          ptr_function,
+                                          "ss", func_argv);
+
+        if (!rc)
+            ret = WEECHAT_RC_ERROR;
+        else
+        {
+            ret = *rc;
+            free (rc);
+        }
+
+        return ret;
+    }
+
+    return WEECHAT_RC_ERROR;
+}
+
+API_FUNC(hook_batch)
+{
+    char *hook, *function, *data;
+    int max_size, max_latency, rc;
+
+    API_INIT_FUNC(1, "hook_batch", API_RETURN_INT(0));
+    hook = NULL;
+    max_size = 0;
+    max_latency = 0;
+    function = NULL;
+    data = NULL;
+    if (!PyArg_ParseTuple (args, "siiss", &hook, &max_size, &max_latency,
+                           &function, &data))
+        API_WRONG_ARGS(API_RETURN_INT(0));
+
+    rc = plugin_script_api_hook_batch (weechat_python_plugin,
+                                       python_current_script,
+                                       API_STR2PTR(hook),
+                                       max_size,
+                                       max_latency,
+                                       &weechat_python_api_hook_batch_cb,
+                                       function,
+                                       data);
+
+    API_RETURN_INT(rc);
+}
+
 API_FUNC(unhook)
 {
     char *hook;
@@ -5205,6 +5269,7 @@ PyMethodDef weechat_python_funcs[] =
     API_DEF_FUNC(hook_infolist),
     API_DEF_FUNC(hook_focus),
     API_DEF_FUNC(hook_set),
+    API_DEF_FUNC(hook_batch),
     API_DEF_FUNC(unhook),
     API_DEF_FUNC(unhook_all),
     API_DEF_FUNC(buffer_new),
@@ -24,6 +24,7 @@
 #undef _
 
 #include <Python.h>
+#include <marshal.h>
 #include <stdio.h>
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -75,6 +76,9 @@ PyThreadState *python_mainThreadState = NULL;
 PyThreadState *python_current_interpreter = NULL;
 char *python2_bin = NULL;
 char **python_buffer_output = NULL;
+struct t_plugin_script_precompiled *python_current_precompiled = NULL;
+char *python_cache_dir = NULL;         /* dir with bytecode of scripts      */
+long python_cache_magic = 0;           /* magic number of bytecode          */
 
 /* outputs subroutines */
 static PyObject *weechat_python_output (PyObject *self, PyObject *args);
@@ -439,6 +443,153 @@ weechat_python_output (PyObject *self, PyObject *args)
     return Py_None;
 }
 
+/*
+ * Frees a callable in cache of a script (the interpreter of script must be
+ * the current one).
+ */
+
+void
+weechat_python_callable_free_cb (struct t_hashtable *hashtable,
+                                 const void *key, void *value)
+{
+    struct t_python_callable *callable;
+
+    /* make C compiler happy */
+    (void) hashtable;
+    (void) key;
+
+    callable = (struct t_python_callable *)value;
+    if (!callable)
+        return;
+
+    Py_XDECREF(callable->name);
+    Py_XDECREF(callable->globals);
+    free (callable);
+}
+
+/*
+ * Gets a callable by name in a script (the interpreter of script must be the
+ * current one).
+ *
+ * The interned name and the globals of script are kept in cache of script,
+ * so that the callable is found with a single lookup in the dict, without
+ * building a python string on each call. The lookup is still made on each
+ * call, so a function redefined by the script is used.
+ *
+ * Returns a borrowed reference to the callable, NULL if not found.
+ */
+
+PyObject *
+weechat_python_get_callable (struct t_plugin_script *script,
+                             const char *function)
+{
+    struct t_python_callable *callable;
+    PyObject *module_main, *func;
+
+    if (!script->callables)
+    {
+        script->callables = weechat_hashtable_new (
+            32,
+            WEECHAT_HASHTABLE_STRING,
+            WEECHAT_HASHTABLE_POINTER,
+            NULL, NULL);
+        if (!script->callables)
+            return NULL;
+        weechat_hashtable_set_pointer (script->callables,
+                                       "callback_free_value",
+                                       &weechat_python_callable_free_cb);
+    }
+
+    callable = weechat_hashtable_get (script->callables, function);
+    if (!callable)
+    {
+        module_main = PyImport_AddModule ((char *) "__main__");
+        if (!module_main)
+            return NULL;
+        callable = malloc (sizeof (*callable));
+        if (!callable)
+            return NULL;
+#if PY_MAJOR_VERSION >= 3
+        callable->name = PyUnicode_InternFromString (function);
+#else
+        callable->name = PyString_InternFromString (function);
+#endif /* PY_MAJOR_VERSION >= 3 */
+        callable->globals = PyModule_GetDict (module_main);
+        Py_XINCREF(callable->globals);
+        if (!callable->name || !callable->globals)
+        {
+            PyErr_Clear ();
+            weechat_python_callable_free_cb (NULL, NULL, callable);
+            return NULL;
+        }
+        weechat_hashtable_set (script->callables, function, callable);
+    }
+
+    func = PyDict_GetItem (callable->globals, callable->name);
+
+    return (func && PyCallable_Check (func)) ? func : NULL;
+}
+
+/*
+ * Builds python arguments for a call to a script function.
+ *
+ * Format is a string with one char by argument:
+ *   's': string (str, or bytes with Python 3 if it is not valid UTF-8)
+ *   'O': python object
+ *
+ * Returns number of arguments built, -1 if error (args is then empty).
+ */
+
+int
+weechat_python_build_args (const char *format, void **argv,
+                           PyObject **args, int size)
+{
+    int i, argc;
+
+    argc = strlen (format);
+    if (argc > size)
+        return -1;
+
+    for (i = 0; i < argc; i++)
+    {
+        switch (format[i])
+        {
+            case 's':
+                if (!argv[i])
+                {
+                    Py_INCREF(Py_None);
+                    args[i] = Py_None;
+                }
+#if PY_MAJOR_VERSION >= 3
+                else if (weechat_utf8_is_valid (argv[i], -1, NULL))
+                    args[i] = PyUnicode_FromString (argv[i]); /* str */
+#endif /* PY_MAJOR_VERSION >= 3 */
+                else
+                    args[i] = PyBytes_FromString (argv[i]);
+                break;
+            case 'O':
+                args[i] = (PyObject *)argv[i];
+                Py_XINCREF(args[i]);
+                break;
+            default:
+                args[i] = NULL;
+                break;
+        }
+        if (!args[i])
+        {
+            while (i > 0)
+            {
+                i--;
+                Py_DECREF(args[i]);
+            }
+            PyErr_Clear ();
+            return -1;
+        }
+    }
+
+    return argc;
+}
+
 /*
  * Executes a python function.
  */
@@ -450,9 +601,11 @@ weechat_python_exec (struct t_plugin_script *script,
 {
     struct t_plugin_script *old_python_current_script;
     PyThreadState *old_interpreter;
-    PyObject *evMain, *evDict, *evFunc, *rc;
-    void *argv2[16], *ret_value, *ret_temp;
-    char format2[17];
+    PyObject *evFunc, *rc, *args[16];
+#if PY_VERSION_HEX < 0x03090000
+    PyObject *args_tuple;
+#endif /* PY_VERSION_HEX < 0x03090000 */
+    void *ret_value, *ret_temp;
     int i, argc, *ret_int;
 
     ret_value = NULL;
@@ -468,11 +621,9 @@ weechat_python_exec (struct t_plugin_script *script,
         PyThreadState_Swap (script->interpreter);
     }
 
-    evMain = PyImport_AddModule ((char *) "__main__");
-    evDict = PyModule_GetDict (evMain);
-    evFunc = PyDict_GetItemString (evDict, function);
+    evFunc = weechat_python_get_callable (script, function);
 
-    if ( !(evFunc && PyCallable_Check (evFunc)) )
+    if (!evFunc)
     {
         weechat_printf (NULL,
                         weechat_gettext ("%s%s: unable to run function \"%s\""),
@@ -481,50 +632,39 @@ weechat_python_exec (struct t_plugin_script *script,
         goto end;
     }
 
-    if (argv && argv[0])
+    argc = (argv && argv[0]) ?
+        weechat_python_build_args (format, argv, args, 16) : 0;
+    if (argc < 0)
     {
-        argc = strlen (format);
-        for (i = 0; i < 16; i++)
-        {
-            if (i < argc)
-            {
-                argv2[i] = argv[i];
-                if (format[i] == 's')
-                {
-#if PY_MAJOR_VERSION >= 3
-                    if (weechat_utf8_is_valid (argv2[i], -1, NULL))
-                        format2[i] = 's';  /* Python 3: str */
-                    else
-                        format2[i] = 'y';  /* Python 3: bytes */
+        weechat_printf (NULL,
+                        weechat_gettext ("%s%s: unable to run function \"%s\""),
+                        weechat_prefix ("error"), PYTHON_PLUGIN_NAME, function);
+        goto end;
+    }
+
+#if PY_VERSION_HEX >= 0x03090000
+    rc = PyObject_Vectorcall (evFunc, args, argc, NULL);
 #else
-                    format2[i] = 's';  /* Python 2: str */
-#endif
-                }
-                else
-                {
-                    format2[i] = format[i];
-                }
-            }
-            else
-            {
-                argv2[i] = NULL;
-            }
+    args_tuple = PyTuple_New (argc);
+    if (args_tuple)
+    {
+        /* references to arguments are stolen by the tuple */
+        for (i = 0; i < argc; i++)
+        {
+            PyTuple_SET_ITEM(args_tuple, i, args[i]);
         }
-        format2[argc] = '\0';
-
-        rc = PyObject_CallFunction (evFunc, format2,
-                                    argv2[0], argv2[1],
-                                    argv2[2], argv2[3],
-                                    argv2[4], argv2[5],
-                                    argv2[6], argv2[7],
-                                    argv2[8], argv2[9],
-                                    argv2[10], argv2[11],
-                                    argv2[12], argv2[13],
-                                    argv2[14], argv2[15]);
+        argc = 0;
+        rc = PyObject_Call (evFunc, args_tuple, NULL);
+        Py_DECREF(args_tuple);
     }
     else
     {
-        rc = PyObject_CallFunction (evFunc, NULL);
+        rc = NULL;
+    }
+#endif /* PY_VERSION_HEX >= 0x03090000 */
+    for (i = 0; i < argc; i++)
+    {
+        Py_DECREF(args[i]);
     }
 
     weechat_python_output_flush ();
@@ -761,6 +901,294 @@ weechat_python_set_output ()
     }
 }
 
+/*
+ * Builds path to bytecode cache of a script:
+ * "~/.weechat/python/__pycache__/<script>.weechat.pyc".
+ *
+ * Note: result must be freed after use.
+ */
+
+char *
+weechat_python_cache_path (const char *filename)
+{
+    const char *ptr_name;
+    char *path;
+    int length;
+
+    if (!python_cache_dir)
+        return NULL;
+
+    ptr_name = strrchr (filename, '/');
+    ptr_name = (ptr_name) ? ptr_name + 1 : filename;
+
+    length = strlen (python_cache_dir) + 1 + strlen (ptr_name) + 16;
+    path = malloc (length);
+    if (path)
+        snprintf (path, length, "%s/%s.weechat.pyc", python_cache_dir, ptr_name);
+
+    return path;
+}
+
+/*
+ * Reads content of a file (from current position to the end) in the buffer
+ * of a precompiled script.
+ *
+ * Returns:
+ *   1: OK
+ *   0: error
+ */
+
+int
+weechat_python_precompile_read (FILE *file,
+                                struct t_plugin_script_precompiled *precompiled)
+{
+    char *buffer, *buffer2;
+    size_t length, size_alloc, num_read;
+
+    size_alloc = 4096;
+    buffer = malloc (size_alloc);
+    if (!buffer)
+        return 0;
+    length = 0;
+
+    while (1)
+    {
+        if (length + 1 >= size_alloc)
+        {
+            size_alloc *= 2;
+            buffer2 = realloc (buffer, size_alloc);
+            if (!buffer2)
+            {
+                free (buffer);
+                return 0;
+            }
+            buffer = buffer2;
+        }
+        num_read = fread (buffer + length, 1, size_alloc - length - 1, file);
+        if (num_read == 0)
+            break;
+        length += num_read;
+    }
+
+    if (ferror (file))
+    {
+        free (buffer);
+        return 0;
+    }
+
+    buffer[length] = '\0';
+    precompiled->buffer = buffer;
+    precompiled->size = (int)length;
+
+    return 1;
+}
+
+/*
+ * Precompiles a python script (called in a thread, on autoload).
+ *
+ * Python can not compile code outside the main thread, so the bytecode is
+ * read from cache if it is up-to-date, otherwise the source is read (it is
+ * compiled in main thread, and then saved in cache).
+ *
+ * Returns:
+ *   1: OK
+ *   0: error
+ */
+
+int
+weechat_python_precompile_cb (struct t_plugin_script_precompiled *precompiled)
+{
+    struct t_python_cache_header header;
+    FILE *file;
+    char *cache_path, *cache_filename;
+    int rc;
+
+    /* read bytecode from cache if it was built for this version of file */
+    cache_path = weechat_python_cache_path (precompiled->filename);
+    if (cache_path)
+    {
+        file = fopen (cache_path, "rb");
+        free (cache_path);
+        if (file)
+        {
+            cache_filename = NULL;
+            if ((fread (&header, sizeof (header), 1, file) == 1)
+                && (header.magic == python_cache_magic)
+                && (header.file_mtime == precompiled->file_mtime)
+                && (header.file_size == precompiled->file_size)
+                && (header.length_filename == (int)strlen (precompiled->filename)))
+            {
+                cache_filename = malloc (header.length_filename + 1);
+            }
+            if (cache_filename
+                && (fread (cache_filename, 1, header.length_filename,
+                           file) == (size_t)header.length_filename))
+            {
+                cache_filename[header.length_filename] = '\0';
+                if ((strcmp (cache_filename, precompiled->filename) == 0)
+                    && weechat_python_precompile_read (file, precompiled))
+                {
+                    precompiled->bytecode = 1;
+                }
+            }
+            if (cache_filename)
+                free (cache_filename);
+            fclose (file);
+            if (precompiled->bytecode)
+                return 1;
+        }
+    }
+
+    /* read source */
+    file = fopen (precompiled->filename, "r");
+    if (!file)
+        return 0;
+    rc = weechat_python_precompile_read (file, precompiled);
+    fclose (file);
+
+    return rc;
+}
+
+/*
+ * Saves bytecode of a script in cache.
+ */
+
+void
+weechat_python_cache_write (struct t_plugin_script_precompiled *precompiled,
+                            PyObject *code)
+{
+    struct t_python_cache_header header;
+    PyObject *bytecode;
+    FILE *file;
+    char *cache_path, *cache_path_tmp;
+    int length, rc;
+
+    cache_path = weechat_python_cache_path (precompiled->filename);
+    if (!cache_path)
+        return;
+
+    length = strlen (cache_path) + 16;
+    cache_path_tmp = malloc (length);
+    if (!cache_path_tmp)
+    {
+        free (cache_path);
+        return;
+    }
+    snprintf (cache_path_tmp, length, "%s.%d", cache_path, (int)getpid ());
+
+    bytecode = PyMarshal_WriteObjectToString (code, Py_MARSHAL_VERSION);
+    if (!bytecode)
+    {
+        PyErr_Clear ();
+        free (cache_path);
+        free (cache_path_tmp);
+        return;
+    }
+
+    (void) weechat_mkdir_parents (python_cache_dir, 0755);
+
+    file = fopen (cache_path_tmp, "wb");
+    if (file)
+    {
+        memset (&header, 0, sizeof (header));
+        header.magic = python_cache_magic;
+        header.file_mtime = precompiled->file_mtime;
+        header.file_size = precompiled->file_size;
+        header.length_filename = strlen (precompiled->filename);
+        rc = ((fwrite (&header, sizeof (header), 1, file) == 1)
+              && (fwrite (precompiled->filename, 1, header.length_filename,
+                          file) == (size_t)header.length_filename)
+              && (fwrite (PyBytes_AsString (bytecode), 1,
+                          PyBytes_Size (bytecode),
+                          file) == (size_t)PyBytes_Size (bytecode)));
+        if (fclose (file) != 0)
+            rc = 0;
+        if (!rc || (rename (cache_path_tmp, cache_path) != 0))
+            unlink (cache_path_tmp);
+    }
+
+    Py_DECREF(bytecode);
+    free (cache_path);
+    free (cache_path_tmp);
+}
+
+/*
+ * Executes a precompiled script (bytecode or source read in a thread) in the
+ * current interpreter.
+ *
+ * If the bytecode can not be read, the script is executed from file.
+ *
+ * Returns:
+ *   0: OK
+ *  -1: error
+ */
+
+int
+weechat_python_run_precompiled (struct t_plugin_script_precompiled *precompiled,
+                                FILE *file)
+{
+    PyObject *module_main, *globals, *code, *filename, *rc;
+
+    if (precompiled->bytecode)
+    {
+        code = PyMarshal_ReadObjectFromString (precompiled->buffer,
+                                               precompiled->size);
+        if (!code || !PyCode_Check (code))
+        {
+            /* invalid cache: execute file */
+            if (code)
+                Py_DECREF(code);
+            PyErr_Clear ();
+            return PyRun_SimpleFile (file, precompiled->filename);
+        }
+    }
+    else
+    {
+        code = Py_CompileString (precompiled->buffer, precompiled->filename,
+                                 Py_file_input);
+        if (code)
+            weechat_python_cache_write (precompiled, code);
+    }
+
+    if (!code)
+    {
+        PyErr_Print ();
+        return -1;
+    }
+
+    module_main = PyImport_AddModule ("__main__");
+    globals = PyModule_GetDict (module_main);
+
+    /* like PyRun_SimpleFile, set "__file__" while the script is executed */
+#if PY_MAJOR_VERSION >= 3
+    filename = PyUnicode_DecodeFSDefault (precompiled->filename);
+#else
+    filename = PyBytes_FromString (precompiled->filename);
+#endif /* PY_MAJOR_VERSION >= 3 */
+    if (filename)
+    {
+        PyDict_SetItemString (globals, "__file__", filename);
+        Py_DECREF(filename);
+    }
+
+#if PY_MAJOR_VERSION >= 3
+    rc = PyEval_EvalCode (code, globals, globals);
+#else
+    rc = PyEval_EvalCode ((PyCodeObject *)code, globals, globals);
+#endif /* PY_MAJOR_VERSION >= 3 */
+    Py_DECREF(code);
+
+    if (!rc)
+        PyErr_Print ();
+    else
+        Py_DECREF(rc);
+
+    if (PyDict_DelItemString (globals, "__file__") != 0)
+        PyErr_Clear ();
+
+    return (rc) ? 0 : -1;
+}
+
 /*
  * Loads a python script.
  *
@@ -781,7 +1209,7 @@ weechat_python_load (const char *filename, const char *code)
     PyObject *python_path, *path, *module_main, *globals, *rc;
     char *weechat_home;
     char *str_home;
-    int len;
+    int len, rc_exec;
 
     fp = NULL;
 
@@ -910,8 +1338,13 @@ weechat_python_load (const char *filename, const char *code)
     }
     else
     {
-        /* read and execute code from file */
-        if (PyRun_SimpleFile (fp, filename) != 0)
+        /* read and execute code from file (or precompiled on autoload) */
+        if (python_current_precompiled)
+            rc_exec = weechat_python_run_precompiled (python_current_precompiled,
+                                                      fp);
+        else
+            rc_exec = PyRun_SimpleFile (fp, filename);
+        if (rc_exec != 0)
         {
             weechat_printf (NULL,
                             weechat_gettext ("%s%s: unable to parse file \"%s\""),
@@ -978,15 +1411,17 @@ weechat_python_load (const char *filename, const char *code)
 
 /*
  * Callback for script_auto_load() function.
+ *
+ * Argument "data" is the script precompiled in a thread (NULL if the script
+ * was not precompiled).
  */
 
 void
 weechat_python_load_cb (void *data, const char *filename)
 {
-    /* make C compiler happy */
-    (void) data;
-
+    python_current_precompiled = (struct t_plugin_script_precompiled *)data;
     weechat_python_load (filename, NULL);
+    python_current_precompiled = NULL;
 }
 
 /*
@@ -1024,6 +1459,15 @@ weechat_python_unload (struct t_plugin_script *script)
             python_current_script->prev_script : python_current_script->next_script;
     }
 
+    /* python objects in cache must be freed in the interpreter of script */
+    if (script->callables)
+    {
+        if (interpreter)
+            PyThreadState_Swap (interpreter);
+        weechat_hashtable_free (script->callables);
+        script->callables = NULL;
+    }
+
     plugin_script_remove (weechat_python_plugin, &python_scripts, &last_python_script,
                           script);
 
@@ -1211,12 +1655,12 @@ weechat_python_command_cb (const void *pointer, void *data,
         }
         else if (weechat_strcasecmp (argv[1], "autoload") == 0)
         {
-            plugin_script_auto_load (weechat_python_plugin, &weechat_python_load_cb);
+            plugin_script_auto_load (weechat_python_plugin, &python_data);
         }
         else if (weechat_strcasecmp (argv[1], "reload") == 0)
         {
             weechat_python_unload_all ();
-            plugin_script_auto_load (weechat_python_plugin, &weechat_python_load_cb);
+            plugin_script_auto_load (weechat_python_plugin, &python_data);
         }
         else if (weechat_strcasecmp (argv[1], "unload") == 0)
         {
@@ -1554,6 +1998,9 @@ weechat_python_signal_script_action_cb (const void *pointer, void *data,
 int
 weechat_plugin_init (struct t_weechat_plugin *plugin, int argc, char *argv[])
 {
+    char *weechat_home;
+    int length;
+
     weechat_python_plugin = plugin;
 
     /* set interpreter name and version */
@@ -1596,6 +2043,21 @@ weechat_plugin_init (struct t_weechat_plugin *plugin, int argc, char *argv[])
         return WEECHAT_RC_ERROR;
     }
 
+    /* bytecode of scripts is cached in ~/.weechat/python/__pycache__ */
+    python_cache_magic = PyImport_GetMagicNumber ();
+    weechat_home = weechat_info_get ("weechat_dir", "");
+    if (weechat_home)
+    {
+        length = strlen (weechat_home) + 1 + strlen (PYTHON_PLUGIN_NAME) + 16;
+        python_cache_dir = malloc (length);
+        if (python_cache_dir)
+        {
+            snprintf (python_cache_dir, length, "%s/%s/__pycache__",
+                      weechat_home, PYTHON_PLUGIN_NAME);
+        }
+        free (weechat_home);
+    }
+
     /* PyEval_InitThreads(); */
     /* python_mainThreadState = PyThreadState_Swap(NULL); */
 #if PY_VERSION_HEX >= 0x03070000
@@ -1628,6 +2090,7 @@ weechat_plugin_init (struct t_weechat_plugin *plugin, int argc, char *argv[])
     python_data.callback_signal_debug_dump = &weechat_python_signal_debug_dump_cb;
     python_data.callback_signal_script_action = &weechat_python_signal_script_action_cb;
     python_data.callback_load_file = &weechat_python_load_cb;
+    python_data.callback_precompile_file = &weechat_python_precompile_cb;
     python_data.unload_all = &weechat_python_unload_all;
 
     python_quiet = 1;
@@ -1678,6 +2141,11 @@ weechat_plugin_end (struct t_weechat_plugin *plugin)
     /* free some data */
     if (python2_bin)
         free (python2_bin);
+    if (python_cache_dir)
+    {
+        free (python_cache_dir);
+        python_cache_dir = NULL;
+    }
     if (python_action_install_list)
         free (python_action_install_list);
     if (python_action_remove_list)
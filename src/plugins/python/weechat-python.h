@@ -42,6 +42,21 @@
 #define PY_INTEGER_CHECK(x) (PyInt_Check(x) || PyLong_Check(x))
 #endif /* PY_MAJOR_VERSION >= 3 */
 
+struct t_python_callable
+{
+    PyObject *name;                    /* function name (interned string)   */
+    PyObject *globals;                 /* globals of script (dict)          */
+};
+
+struct t_python_cache_header
+{
+    long magic;                        /* magic number of python bytecode   */
+    long long file_mtime;              /* modification time of script       */
+    long long file_size;               /* size of script                    */
+    int length_filename;               /* length of script filename (after  */
+                                       /* header, followed by bytecode)     */
+};
+
 extern struct t_weechat_plugin *weechat_python_plugin;
 
 extern struct t_plugin_script_data python_data;
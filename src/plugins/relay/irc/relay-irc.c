@@ -591,8 +591,9 @@ relay_irc_hsignal_irc_redir_cb (const void *pointer, void *data,
  *   - host
  *   - message (without colors).
  *
- * Arguments hdata_line_data and line_data must be non NULL, the other arguments
- * can be NULL.
+ * Arguments line_date, line_tags_count, line_tags and line_message are the
+ * data of line (from lines exported with weechat_buffer_lines_export), the
+ * other arguments can be NULL.
  *
  * Note: tags and message (if given and filled) must be freed after use.
  */
@@ -600,7 +601,8 @@ relay_irc_hsignal_irc_redir_cb (const void *pointer, void *data,
 void
 relay_irc_get_line_info (struct t_relay_client *client,
                          struct t_gui_buffer *buffer,
-                         struct t_hdata *hdata_line_data, void *line_data,
+                         time_t line_date, int line_tags_count,
+                         char **line_tags, const char *line_message,
                          int *irc_command, int *irc_action, time_t *date,
                          const char **nick, const char **nick1,
                          const char **nick2, const char **host,
@@ -632,13 +634,12 @@ relay_irc_get_line_info (struct t_relay_client *client,
     if (message)
         *message = NULL;
 
-    msg_date = weechat_hdata_time (hdata_line_data, line_data, "date");
-    num_tags = weechat_hdata_get_var_array_size (hdata_line_data, line_data,
-                                                 "tags_array");
-    ptr_message = weechat_hdata_pointer (hdata_line_data, line_data, "message");
+    msg_date = line_date;
+    num_tags = line_tags_count;
+    ptr_message = line_message;
 
     /* no tag found, or no message? just exit */
-    if ((num_tags <= 0) || !ptr_message)
+    if ((num_tags <= 0) || !line_tags || !ptr_message)
         return;
 
     command = -1;
@@ -651,8 +652,7 @@ relay_irc_get_line_info (struct t_relay_client *client,
                                           "*");
     for (i = 0; i < num_tags; i++)
     {
-        snprintf (str_tag, sizeof (str_tag), "%d|tags_array", i);
-        ptr_tag = weechat_hdata_string (hdata_line_data, line_data, str_tag);
+        ptr_tag = line_tags[i];
         if (ptr_tag)
         {
             if (strcmp (ptr_tag, "irc_action") == 0)
@@ -773,35 +773,15 @@ relay_irc_send_channel_backlog (struct t_relay_client *client,
                                 struct t_gui_buffer *buffer)
 {
     struct t_relay_server *ptr_server;
-    void *ptr_own_lines, *ptr_line, *ptr_line_data;
-    void *ptr_hdata_line, *ptr_hdata_line_data;
-    char *tags, *message;
+    struct t_gui_lines_export *lines_export;
+    time_t *lines_date;
+    int *lines_tags_count;
+    char ***lines_tags, **lines_message, *tags, *message;
     const char *ptr_nick, *ptr_nick1, *ptr_nick2, *ptr_host, *localvar_nick;
     int irc_command, irc_action, count, max_number, max_minutes;
+    int i, num_lines, max_lines, stop;
     time_t date_min, date_min2, date;
 
-    /* get pointer on "own_lines" in buffer */
-    ptr_own_lines = weechat_hdata_pointer (weechat_hdata_get ("buffer"),
-                                           buffer, "own_lines");
-    if (!ptr_own_lines)
-        return;
-
-    /* get pointer on "last_line" in lines */
-    ptr_line = weechat_hdata_pointer (weechat_hdata_get ("lines"),
-                                      ptr_own_lines, "last_line");
-    if (!ptr_line)
-        return;
-
-    /* get hdata "line" */
-    ptr_hdata_line = weechat_hdata_get ("line");
-    if (!ptr_hdata_line)
-        return;
-
-    /* get hdata "line_data" */
-    ptr_hdata_line_data = weechat_hdata_get ("line_data");
-    if (!ptr_hdata_line_data)
-        return;
-
     localvar_nick = NULL;
     if (weechat_config_boolean (relay_config_irc_backlog_since_last_message))
         localvar_nick = weechat_buffer_get_string (buffer, "localvar_nick");
@@ -821,18 +801,48 @@ relay_irc_send_channel_backlog (struct t_relay_client *client,
     }
 
     /*
-     * loop on lines in buffer, from last to first, and stop when we have
-     * reached max number of lines (or max minutes)
+     * get lines of buffer by columns (strings are not copied), by blocks
+     * of lines from the end of buffer: the block is made bigger until we
+     * find where the backlog starts or all lines are exported, so that a big
+     * buffer is not fully exported; "date_min" is not given to the export
+     * (which would skip old lines): the backlog starts after the last irc
+     * message older than "date_min", checked in the loop below
      */
-    count = 0;
-    while (ptr_line)
+    max_lines = RELAY_IRC_BACKLOG_CHUNK_LINES;
+    if ((max_number > 0) && (max_lines <= max_number))
+        max_lines = max_number + 1;
+    while (1)
     {
-        ptr_line_data = weechat_hdata_pointer (ptr_hdata_line,
-                                               ptr_line, "data");
-        if (ptr_line_data)
+        lines_export = weechat_buffer_lines_export (buffer, 0, 0, max_lines);
+        if (!lines_export)
+            return;
+        lines_date = weechat_buffer_lines_export_get (lines_export, "date",
+                                                      &num_lines);
+        lines_tags_count = weechat_buffer_lines_export_get (lines_export,
+                                                            "tags_count",
+                                                            NULL);
+        lines_tags = weechat_buffer_lines_export_get (lines_export,
+                                                      "tags_array", NULL);
+        lines_message = weechat_buffer_lines_export_get (lines_export,
+                                                         "message", NULL);
+        if (num_lines == 0)
+        {
+            weechat_buffer_lines_export_free (lines_export);
+            return;
+        }
+
+        /*
+         * loop on lines exported, from last to first, and stop when we have
+         * reached max number of lines (or max minutes)
+         */
+        count = 0;
+        stop = 0;
+        i = num_lines - 1;
+        while (i >= 0)
         {
             relay_irc_get_line_info (client, buffer,
-                                     ptr_hdata_line_data, ptr_line_data,
+                                     lines_date[i], lines_tags_count[i],
+                                     lines_tags[i], lines_message[i],
                                      &irc_command,
                                      NULL, /* irc_action */
                                      &date,
@@ -846,12 +856,18 @@ relay_irc_send_channel_backlog (struct t_relay_client *client,
             {
                 /* if we have reached max minutes, exit loop */
                 if ((date_min > 0) && (date < date_min))
+                {
+                    stop = 1;
                     break;
+                }
                 count++;
             }
             /* if we have reached max number of messages, exit loop */
             if ((max_number > 0) && (count > max_number))
+            {
+                stop = 1;
                 break;
+            }
 
             if (localvar_nick && localvar_nick[0]
                 && ptr_nick && (strcmp (ptr_nick, localvar_nick) == 0))
@@ -860,110 +876,108 @@ relay_irc_send_channel_backlog (struct t_relay_client *client,
                  * stop when we find a line sent by the current nick
                  * (and include this line)
                  */
-                ptr_line = weechat_hdata_move (ptr_hdata_line, ptr_line, -1);
+                i--;
+                stop = 1;
                 break;
             }
+            i--;
         }
-        ptr_line = weechat_hdata_move (ptr_hdata_line, ptr_line, -1);
-    }
 
-    if (!ptr_line)
-    {
-        /* if we have reached beginning of buffer, start from first line */
-        ptr_line = weechat_hdata_pointer (weechat_hdata_get ("lines"),
-                                          ptr_own_lines, "first_line");
-    }
-    else
-    {
-        /* start from line + 1 (the current line must not be sent) */
-        ptr_line = weechat_hdata_move (ptr_hdata_line, ptr_line, 1);
+        /*
+         * stop if the beginning of backlog was found, or if there are no
+         * more lines to export (beginning of buffer reached)
+         */
+        if (stop || (num_lines < max_lines))
+            break;
+
+        /* export a bigger block of lines */
+        weechat_buffer_lines_export_free (lines_export);
+        max_lines *= 2;
     }
 
     /*
-     * loop on lines from line pointer until last line of buffer, and for each
-     * irc message, sends it to client
+     * loop on lines from line after the current one (or from first line if
+     * we have reached beginning of buffer) until last line of buffer, and for
+     * each irc message, sends it to client
      */
-    while (ptr_line)
+    for (i = i + 1; i < num_lines; i++)
     {
-        ptr_line_data = weechat_hdata_pointer (ptr_hdata_line,
-                                               ptr_line, "data");
-        if (ptr_line_data)
+        relay_irc_get_line_info (client, buffer,
+                                 lines_date[i], lines_tags_count[i],
+                                 lines_tags[i], lines_message[i],
+                                 &irc_command,
+                                 &irc_action,
+                                 &date,
+                                 &ptr_nick,
+                                 &ptr_nick1,
+                                 &ptr_nick2,
+                                 &ptr_host,
+                                 &tags,
+                                 &message);
+        switch (irc_command)
         {
-            relay_irc_get_line_info (client, buffer,
-                                     ptr_hdata_line_data, ptr_line_data,
-                                     &irc_command,
-                                     &irc_action,
-                                     &date,
-                                     &ptr_nick,
-                                     &ptr_nick1,
-                                     &ptr_nick2,
-                                     &ptr_host,
-                                     &tags,
-                                     &message);
-            switch (irc_command)
-            {
-                case RELAY_IRC_CMD_JOIN:
+            case RELAY_IRC_CMD_JOIN:
+                relay_irc_sendf (client,
+                                 "%s:%s%s%s JOIN :%s",
+                                 (tags) ? tags : "",
+                                 ptr_nick,
+                                 (ptr_host) ? "!" : "",
+                                 (ptr_host) ? ptr_host : "",
+                                 channel);
+                break;
+            case RELAY_IRC_CMD_PART:
+                relay_irc_sendf (client,
+                                 "%s:%s%s%s PART %s",
+                                 (tags) ? tags : "",
+                                 ptr_nick,
+                                 (ptr_host) ? "!" : "",
+                                 (ptr_host) ? ptr_host : "",
+                                 channel);
+                break;
+            case RELAY_IRC_CMD_QUIT:
+                relay_irc_sendf (client,
+                                 "%s:%s%s%s QUIT",
+                                 (tags) ? tags : "",
+                                 ptr_nick,
+                                 (ptr_host) ? "!" : "",
+                                 (ptr_host) ? ptr_host : "");
+                break;
+            case RELAY_IRC_CMD_NICK:
+                if (ptr_nick1 && ptr_nick2)
+                {
                     relay_irc_sendf (client,
-                                     "%s:%s%s%s JOIN :%s",
+                                     "%s:%s NICK :%s",
                                      (tags) ? tags : "",
-                                     ptr_nick,
-                                     (ptr_host) ? "!" : "",
-                                     (ptr_host) ? ptr_host : "",
-                                     channel);
-                    break;
-                case RELAY_IRC_CMD_PART:
+                                     ptr_nick1,
+                                     ptr_nick2);
+                }
+                break;
+            case RELAY_IRC_CMD_PRIVMSG:
+                if (ptr_nick && message)
+                {
                     relay_irc_sendf (client,
-                                     "%s:%s%s%s PART %s",
+                                     "%s:%s%s%s PRIVMSG %s :%s%s%s",
                                      (tags) ? tags : "",
                                      ptr_nick,
                                      (ptr_host) ? "!" : "",
                                      (ptr_host) ? ptr_host : "",
-                                     channel);
-                    break;
-                case RELAY_IRC_CMD_QUIT:
-                    relay_irc_sendf (client,
-                                     "%s:%s%s%s QUIT",
-                                     (tags) ? tags : "",
-                                     ptr_nick,
-                                     (ptr_host) ? "!" : "",
-                                     (ptr_host) ? ptr_host : "");
-                    break;
-                case RELAY_IRC_CMD_NICK:
-                    if (ptr_nick1 && ptr_nick2)
-                    {
-                        relay_irc_sendf (client,
-                                         "%s:%s NICK :%s",
-                                         (tags) ? tags : "",
-                                         ptr_nick1,
-                                         ptr_nick2);
-                    }
-                    break;
-                case RELAY_IRC_CMD_PRIVMSG:
-                    if (ptr_nick && message)
-                    {
-                        relay_irc_sendf (client,
-                                         "%s:%s%s%s PRIVMSG %s :%s%s%s",
-                                         (tags) ? tags : "",
-                                         ptr_nick,
-                                         (ptr_host) ? "!" : "",
-                                         (ptr_host) ? ptr_host : "",
-                                         channel,
-                                         (irc_action) ? "\01ACTION " : "",
-                                         message,
-                                         (irc_action) ? "\01": "");
-                    }
-                    break;
-                case RELAY_IRC_NUM_CMD:
-                    /* make C compiler happy */
-                    break;
-            }
-            if (tags)
-                free (tags);
-            if (message)
-                free (message);
+                                     channel,
+                                     (irc_action) ? "\01ACTION " : "",
+                                     message,
+                                     (irc_action) ? "\01": "");
+                }
+                break;
+            case RELAY_IRC_NUM_CMD:
+                /* make C compiler happy */
+                break;
         }
-        ptr_line = weechat_hdata_move (ptr_hdata_line, ptr_line, 1);
+        if (tags)
+            free (tags);
+        if (message)
+            free (message);
     }
+
+    weechat_buffer_lines_export_free (lines_export);
 }
 
 /*
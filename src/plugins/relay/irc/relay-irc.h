@@ -22,6 +22,9 @@
 
 struct t_relay_client;
 
+/* number of lines exported at once to send backlog (then doubled) */
+#define RELAY_IRC_BACKLOG_CHUNK_LINES 256
+
 #define RELAY_IRC_DATA(client, var)                              \
     (((struct t_relay_irc_data *)client->protocol_data)->var)
 
@@ -34,6 +34,7 @@
 #include "relay-raw.h"
 #include "relay-server.h"
 #include "relay-upgrade.h"
+#include "weechat/relay-weechat-msg.h"
 
 
 WEECHAT_PLUGIN_NAME(RELAY_PLUGIN_NAME);
@@ -147,6 +148,28 @@ relay_signal_upgrade_cb (const void *pointer, void *data,
     return WEECHAT_RC_OK;
 }
 
+/*
+ * Callback for signal "plugin_unloaded".
+ */
+
+int
+relay_signal_plugin_unloaded_cb (const void *pointer, void *data,
+                                 const char *signal, const char *type_data,
+                                 void *signal_data)
+{
+    /* make C compiler happy */
+    (void) pointer;
+    (void) data;
+    (void) signal;
+    (void) type_data;
+    (void) signal_data;
+
+    /* hdata of plugin have been freed: compiled hdata queries are invalid */
+    relay_weechat_msg_hdata_query_free_all ();
+
+    return WEECHAT_RC_OK;
+}
+
 /*
  * Callback for signal "debug_dump".
  */
@@ -207,6 +230,8 @@ weechat_plugin_init (struct t_weechat_plugin *plugin, int argc, char *argv[])
 
     weechat_hook_signal ("upgrade", &relay_signal_upgrade_cb, NULL, NULL);
     weechat_hook_signal ("debug_dump", &relay_debug_dump_cb, NULL, NULL);
+    weechat_hook_signal ("plugin_unloaded",
+                         &relay_signal_plugin_unloaded_cb, NULL, NULL);
 
     relay_info_init ();
 
@@ -250,6 +275,8 @@ weechat_plugin_end (struct t_weechat_plugin *plugin)
         relay_client_free_all ();
     }
 
+    relay_weechat_msg_hdata_query_free_all ();
+
     relay_network_end ();
 
     relay_config_free ();
@@ -41,6 +41,9 @@
 #include "../relay-raw.h"
 
 
+struct t_hashtable *relay_weechat_msg_hdata_queries = NULL; /* queries    */
+
+
 /*
  * Builds a new message (for sending to client).
  *
@@ -320,219 +323,665 @@ relay_weechat_msg_add_hashtable (struct t_relay_weechat_msg *msg,
 }
 
 /*
- * Adds recursively hdata for a path to a message.
+ * Gets offset of the variable used to move in list of a hdata ("var_prev" or
+ * "var_next").
  *
- * Returns the number of hdata objects added to message.
+ * Returns offset of variable, -1 if not found.
  */
 
 int
-relay_weechat_msg_add_hdata_path (struct t_relay_weechat_msg *msg,
-                                  char **list_path,
-                                  int index_path,
-                                  void **path_pointers,
-                                  struct t_hdata *hdata,
-                                  void *pointer,
-                                  char **list_keys)
+relay_weechat_msg_hdata_move_offset (struct t_hdata *hdata,
+                                     const char *property)
 {
-    int num_added, i, j, count, count_all, var_type, array_size, max_array_size;
-    int length;
-    char *pos, *pos2, *str_count, *error, *name;
-    void *sub_pointer;
-    struct t_hdata *sub_hdata;
-    const char *sub_hdata_name;
+    const char *var_name;
 
-    num_added = 0;
+    var_name = weechat_hdata_get_string (hdata, property);
+    if (!var_name)
+        return -1;
 
-    count_all = 0;
-    count = 0;
-    pos = strchr (list_path[index_path], '(');
-    if (pos)
+    return weechat_hdata_get_var_offset (hdata, var_name);
+}
+
+/*
+ * Builds a string with list of keys and their types, for a hdata object:
+ * "key1:type1,key2:type2,...".
+ *
+ * Note: result must be freed after use.
+ */
+
+char *
+relay_weechat_msg_hdata_keys_types (struct t_hdata *hdata, char **list_keys,
+                                    int num_keys)
+{
+    char *keys_types;
+    const char *array_size;
+    int i, length, type;
+
+    length = 1;
+    for (i = 0; i < num_keys; i++)
+    {
+        length += strlen (list_keys[i]) + 8;
+    }
+
+    keys_types = malloc (length);
+    if (!keys_types)
+        return NULL;
+    keys_types[0] = '\0';
+    for (i = 0; i < num_keys; i++)
+    {
+        type = weechat_hdata_get_var_type (hdata, list_keys[i]);
+        if ((type >= 0) && (type != WEECHAT_HDATA_OTHER))
+        {
+            if (keys_types[0])
+                strcat (keys_types, ",");
+            strcat (keys_types, list_keys[i]);
+            strcat (keys_types, ":");
+            array_size = weechat_hdata_get_var_array_size_string (hdata,
+                                                                  NULL,
+                                                                  list_keys[i]);
+            if (array_size)
+                strcat (keys_types, RELAY_WEECHAT_MSG_OBJ_ARRAY);
+            else
+            {
+                switch (type)
+                {
+                    case WEECHAT_HDATA_CHAR:
+                        strcat (keys_types, RELAY_WEECHAT_MSG_OBJ_CHAR);
+                        break;
+                    case WEECHAT_HDATA_INTEGER:
+                        strcat (keys_types, RELAY_WEECHAT_MSG_OBJ_INT);
+                        break;
+                    case WEECHAT_HDATA_LONG:
+                        strcat (keys_types, RELAY_WEECHAT_MSG_OBJ_LONG);
+                        break;
+                    case WEECHAT_HDATA_STRING:
+                    case WEECHAT_HDATA_SHARED_STRING:
+                        strcat (keys_types, RELAY_WEECHAT_MSG_OBJ_STRING);
+                        break;
+                    case WEECHAT_HDATA_POINTER:
+                        strcat (keys_types, RELAY_WEECHAT_MSG_OBJ_POINTER);
+                        break;
+                    case WEECHAT_HDATA_TIME:
+                        strcat (keys_types, RELAY_WEECHAT_MSG_OBJ_TIME);
+                        break;
+                    case WEECHAT_HDATA_HASHTABLE:
+                        strcat (keys_types, RELAY_WEECHAT_MSG_OBJ_HASHTABLE);
+                        break;
+                }
+            }
+        }
+    }
+
+    return keys_types;
+}
+
+/*
+ * Frees a compiled hdata query.
+ */
+
+void
+relay_weechat_msg_hdata_query_free (struct t_relay_weechat_msg_hdata_query *query)
+{
+    int i;
+
+    if (!query)
+        return;
+
+    if (query->steps)
     {
-        pos2 = strchr (pos + 1, ')');
-        if (pos2 && (pos2 > pos + 1))
+        for (i = 0; i < query->num_steps; i++)
         {
-            str_count = weechat_strndup (pos + 1, pos2 - (pos + 1));
-            if (str_count)
+            if (query->steps[i].hdata_name)
+                free (query->steps[i].hdata_name);
+        }
+        free (query->steps);
+    }
+    if (query->vars)
+    {
+        for (i = 0; i < query->num_vars; i++)
+        {
+            if (query->vars[i].name)
+                free (query->vars[i].name);
+        }
+        free (query->vars);
+    }
+    if (query->path_returned)
+        free (query->path_returned);
+    if (query->keys_types)
+        free (query->keys_types);
+
+    free (query);
+}
+
+/*
+ * Compiles a hdata query: hdata, offsets and types of variables are resolved
+ * once for the path and keys, so that objects can be added to messages
+ * without any lookup by name.
+ *
+ * Argument "list_path" is the path split on "/", the first item (list name
+ * or pointer) is used only for its count (for example "(*)").
+ *
+ * Returns pointer to compiled query, NULL if error (invalid path or no keys).
+ */
+
+struct t_relay_weechat_msg_hdata_query *
+relay_weechat_msg_hdata_query_compile (const char *hdata_head,
+                                       char **list_path, int num_path,
+                                       const char *keys)
+{
+    struct t_relay_weechat_msg_hdata_query *query;
+    struct t_relay_weechat_msg_hdata_step *ptr_step;
+    struct t_relay_weechat_msg_hdata_var *ptr_var;
+    struct t_hdata *ptr_hdata;
+    const char *hdata_name;
+    char *name, *pos, *pos2, *error, **list_keys;
+    int i, length, num_keys, type;
+
+    if (!hdata_head || !list_path || (num_path < 1))
+        return NULL;
+
+    query = calloc (1, sizeof (*query));
+    if (!query)
+        return NULL;
+
+    list_keys = NULL;
+
+    /* resolve hdata and offsets of pointers for each step of path */
+    query->steps = calloc (num_path, sizeof (*query->steps));
+    if (!query->steps)
+        goto error;
+    query->num_steps = num_path;
+    ptr_hdata = NULL;
+    length = 1;
+    for (i = 0; i < num_path; i++)
+    {
+        ptr_step = &(query->steps[i]);
+        pos = strchr (list_path[i], '(');
+        if (i == 0)
+        {
+            hdata_name = hdata_head;
+            ptr_step->offset = -1;
+        }
+        else
+        {
+            name = (pos) ?
+                weechat_strndup (list_path[i], pos - list_path[i]) :
+                strdup (list_path[i]);
+            if (!name)
+                goto error;
+            hdata_name = weechat_hdata_get_var_hdata (ptr_hdata, name);
+            ptr_step->offset = weechat_hdata_get_var_offset (ptr_hdata, name);
+            free (name);
+            if (!hdata_name || (ptr_step->offset < 0))
+                goto error;
+        }
+        ptr_step->hdata_name = strdup (hdata_name);
+        if (!ptr_step->hdata_name)
+            goto error;
+        ptr_step->hdata = weechat_hdata_get (hdata_name);
+        if (!ptr_step->hdata)
+            goto error;
+        ptr_step->offset_prev = relay_weechat_msg_hdata_move_offset (
+            ptr_step->hdata, "var_prev");
+        ptr_step->offset_next = relay_weechat_msg_hdata_move_offset (
+            ptr_step->hdata, "var_next");
+        if (pos)
+        {
+            pos2 = strchr (pos + 1, ')');
+            if (pos2 && (pos2 > pos + 1))
             {
-                if (strcmp (str_count, "*") == 0)
-                    count_all = 1;
+                if ((pos2 == pos + 2) && (pos[1] == '*'))
+                    ptr_step->count_all = 1;
                 else
                 {
                     error = NULL;
-                    count = (int)strtol (str_count, &error, 10);
-                    if (error && !error[0])
+                    ptr_step->count = (int)strtol (pos + 1, &error, 10);
+                    if (error && (error == pos2))
                     {
-                        if (count > 0)
-                            count--;
-                        else if (count < 0)
-                            count++;
+                        if (ptr_step->count > 0)
+                            ptr_step->count--;
+                        else if (ptr_step->count < 0)
+                            ptr_step->count++;
                     }
                     else
-                        count = 0;
+                        ptr_step->count = 0;
                 }
-                free (str_count);
             }
         }
+        length += strlen (hdata_name) + 1;
+        ptr_hdata = ptr_step->hdata;
+    }
+
+    /*
+     * build string with path where:
+     * - counters are removed
+     * - variable names are replaced by hdata name
+     */
+    query->path_returned = malloc (length);
+    if (!query->path_returned)
+        goto error;
+    query->path_returned[0] = '\0';
+    for (i = 0; i < num_path; i++)
+    {
+        if (i > 0)
+            strcat (query->path_returned, "/");
+        strcat (query->path_returned, query->steps[i].hdata_name);
+    }
+
+    /* resolve keys, in the hdata of last step */
+    if (!keys)
+        keys = weechat_hdata_get_string (ptr_hdata, "var_keys");
+    list_keys = weechat_string_split (keys, ",", NULL,
+                                      WEECHAT_STRING_SPLIT_STRIP_LEFT
+                                      | WEECHAT_STRING_SPLIT_STRIP_RIGHT
+                                      | WEECHAT_STRING_SPLIT_COLLAPSE_SEPS,
+                                      0, &num_keys);
+    if (!list_keys)
+        goto error;
+    query->keys_types = relay_weechat_msg_hdata_keys_types (ptr_hdata,
+                                                            list_keys,
+                                                            num_keys);
+    if (!query->keys_types || !query->keys_types[0])
+        goto error;
+    query->vars = calloc (num_keys, sizeof (*query->vars));
+    if (!query->vars)
+        goto error;
+    for (i = 0; i < num_keys; i++)
+    {
+        type = weechat_hdata_get_var_type (ptr_hdata, list_keys[i]);
+        if ((type < 0) || (type == WEECHAT_HDATA_OTHER))
+            continue;
+        ptr_var = &(query->vars[query->num_vars]);
+        ptr_var->name = strdup (list_keys[i]);
+        if (!ptr_var->name)
+            goto error;
+        query->num_vars++;
+        ptr_var->type = type;
+        ptr_var->offset = weechat_hdata_get_var_offset (ptr_hdata,
+                                                        list_keys[i]);
+        ptr_var->array = (weechat_hdata_get_var_array_size_string (
+                              ptr_hdata, NULL, list_keys[i])) ? 1 : 0;
+    }
+
+    weechat_string_free_split (list_keys);
+
+    return query;
+
+error:
+    if (list_keys)
+        weechat_string_free_split (list_keys);
+    relay_weechat_msg_hdata_query_free (query);
+    return NULL;
+}
+
+/*
+ * Frees a compiled hdata query in the hashtable of queries.
+ */
+
+void
+relay_weechat_msg_hdata_query_free_value_cb (struct t_hashtable *hashtable,
+                                             const void *key, void *value)
+{
+    /* make C compiler happy */
+    (void) hashtable;
+    (void) key;
+
+    relay_weechat_msg_hdata_query_free (
+        (struct t_relay_weechat_msg_hdata_query *)value);
+}
+
+/*
+ * Gets a compiled hdata query for a path and keys: the query is compiled
+ * on first use, then kept in a cache.
+ *
+ * The pointer (or list name) at beginning of path is not part of the key in
+ * the cache, so the same query is used for all objects of a given hdata.
+ *
+ * Returns pointer to compiled query, NULL if error.
+ */
+
+struct t_relay_weechat_msg_hdata_query *
+relay_weechat_msg_hdata_query_get (const char *hdata_head,
+                                   char **list_path, int num_path,
+                                   const char *keys)
+{
+    struct t_relay_weechat_msg_hdata_query *query;
+    char **key;
+    const char *pos;
+    int i;
+
+    if (!hdata_head || !list_path || (num_path < 1))
+        return NULL;
+
+    if (!relay_weechat_msg_hdata_queries)
+    {
+        relay_weechat_msg_hdata_queries = weechat_hashtable_new (
+            32,
+            WEECHAT_HASHTABLE_STRING,
+            WEECHAT_HASHTABLE_POINTER,
+            NULL, NULL);
+        if (!relay_weechat_msg_hdata_queries)
+            return NULL;
+        weechat_hashtable_set_pointer (
+            relay_weechat_msg_hdata_queries,
+            "callback_free_value",
+            &relay_weechat_msg_hdata_query_free_value_cb);
+    }
+
+    /* build key: "hdata:(count)/var/var...|keys" */
+    key = weechat_string_dyn_alloc (256);
+    if (!key)
+        return NULL;
+    weechat_string_dyn_concat (key, hdata_head);
+    weechat_string_dyn_concat (key, ":");
+    pos = strchr (list_path[0], '(');
+    if (pos)
+        weechat_string_dyn_concat (key, pos);
+    for (i = 1; i < num_path; i++)
+    {
+        weechat_string_dyn_concat (key, "/");
+        weechat_string_dyn_concat (key, list_path[i]);
+    }
+    weechat_string_dyn_concat (key, "|");
+    if (keys)
+        weechat_string_dyn_concat (key, keys);
+
+    query = weechat_hashtable_get (relay_weechat_msg_hdata_queries, *key);
+    if (!query)
+    {
+        query = relay_weechat_msg_hdata_query_compile (hdata_head,
+                                                       list_path, num_path,
+                                                       keys);
+        if (query)
+        {
+            if (weechat_hashtable_get_integer (relay_weechat_msg_hdata_queries,
+                                               "items_count") >= RELAY_WEECHAT_MSG_HDATA_QUERIES_MAX)
+            {
+                weechat_hashtable_remove_all (relay_weechat_msg_hdata_queries);
+            }
+            weechat_hashtable_set (relay_weechat_msg_hdata_queries,
+                                   *key, query);
+        }
+    }
+
+    weechat_string_dyn_free (key, 1);
+
+    return query;
+}
+
+/*
+ * Frees all compiled hdata queries.
+ *
+ * This must be called when a plugin is unloaded (its hdata are freed).
+ */
+
+void
+relay_weechat_msg_hdata_query_free_all ()
+{
+    if (relay_weechat_msg_hdata_queries)
+    {
+        weechat_hashtable_free (relay_weechat_msg_hdata_queries);
+        relay_weechat_msg_hdata_queries = NULL;
+    }
+}
+
+/*
+ * Adds value of a hdata variable to a message.
+ */
+
+void
+relay_weechat_msg_add_hdata_var (struct t_relay_weechat_msg *msg,
+                                 struct t_hdata *hdata,
+                                 void *pointer,
+                                 struct t_relay_weechat_msg_hdata_var *var)
+{
+    int i, array_size, length;
+    char *name;
+
+    if (!var->array)
+    {
+        /* read value directly at offset of variable */
+        switch (var->type)
+        {
+            case WEECHAT_HDATA_CHAR:
+                relay_weechat_msg_add_char (
+                    msg, RELAY_WEECHAT_MSG_VAR(char, pointer, var->offset));
+                break;
+            case WEECHAT_HDATA_INTEGER:
+                relay_weechat_msg_add_int (
+                    msg, RELAY_WEECHAT_MSG_VAR(int, pointer, var->offset));
+                break;
+            case WEECHAT_HDATA_LONG:
+                relay_weechat_msg_add_long (
+                    msg, RELAY_WEECHAT_MSG_VAR(long, pointer, var->offset));
+                break;
+            case WEECHAT_HDATA_STRING:
+            case WEECHAT_HDATA_SHARED_STRING:
+                relay_weechat_msg_add_string (
+                    msg, RELAY_WEECHAT_MSG_VAR(char *, pointer, var->offset));
+                break;
+            case WEECHAT_HDATA_POINTER:
+                relay_weechat_msg_add_pointer (
+                    msg, RELAY_WEECHAT_MSG_VAR(void *, pointer, var->offset));
+                break;
+            case WEECHAT_HDATA_TIME:
+                relay_weechat_msg_add_time (
+                    msg, RELAY_WEECHAT_MSG_VAR(time_t, pointer, var->offset));
+                break;
+            case WEECHAT_HDATA_HASHTABLE:
+                relay_weechat_msg_add_hashtable (
+                    msg,
+                    RELAY_WEECHAT_MSG_VAR(struct t_hashtable *, pointer,
+                                          var->offset));
+                break;
+        }
+        return;
+    }
+
+    /* array: type of items, size, then items */
+    array_size = weechat_hdata_get_var_array_size (hdata, pointer, var->name);
+    if (array_size < 0)
+        array_size = 1;
+    else
+    {
+        switch (var->type)
+        {
+            case WEECHAT_HDATA_CHAR:
+                relay_weechat_msg_add_type (msg, RELAY_WEECHAT_MSG_OBJ_CHAR);
+                break;
+            case WEECHAT_HDATA_INTEGER:
+                relay_weechat_msg_add_type (msg, RELAY_WEECHAT_MSG_OBJ_INT);
+                break;
+            case WEECHAT_HDATA_LONG:
+                relay_weechat_msg_add_type (msg, RELAY_WEECHAT_MSG_OBJ_LONG);
+                break;
+            case WEECHAT_HDATA_STRING:
+            case WEECHAT_HDATA_SHARED_STRING:
+                relay_weechat_msg_add_type (msg, RELAY_WEECHAT_MSG_OBJ_STRING);
+                break;
+            case WEECHAT_HDATA_POINTER:
+                relay_weechat_msg_add_type (msg, RELAY_WEECHAT_MSG_OBJ_POINTER);
+                break;
+            case WEECHAT_HDATA_TIME:
+                relay_weechat_msg_add_type (msg, RELAY_WEECHAT_MSG_OBJ_TIME);
+                break;
+            case WEECHAT_HDATA_HASHTABLE:
+                relay_weechat_msg_add_type (msg, RELAY_WEECHAT_MSG_OBJ_HASHTABLE);
+                break;
+        }
+        relay_weechat_msg_add_int (msg, array_size);
+    }
+    length = 16 + strlen (var->name) + 1;
+    name = malloc (length);
+    if (!name)
+        return;
+    for (i = 0; i < array_size; i++)
+    {
+        snprintf (name, length, "%d|%s", i, var->name);
+        switch (var->type)
+        {
+            case WEECHAT_HDATA_CHAR:
+                relay_weechat_msg_add_char (msg,
+                                            weechat_hdata_char (hdata,
+                                                                pointer,
+                                                                name));
+                break;
+            case WEECHAT_HDATA_INTEGER:
+                relay_weechat_msg_add_int (msg,
+                                           weechat_hdata_integer (hdata,
+                                                                  pointer,
+                                                                  name));
+                break;
+            case WEECHAT_HDATA_LONG:
+                relay_weechat_msg_add_long (msg,
+                                            weechat_hdata_long (hdata,
+                                                                pointer,
+                                                                name));
+                break;
+            case WEECHAT_HDATA_STRING:
+            case WEECHAT_HDATA_SHARED_STRING:
+                relay_weechat_msg_add_string (msg,
+                                              weechat_hdata_string (hdata,
+                                                                    pointer,
+                                                                    name));
+                break;
+            case WEECHAT_HDATA_POINTER:
+                relay_weechat_msg_add_pointer (msg,
+                                               weechat_hdata_pointer (hdata,
+                                                                      pointer,
+                                                                      name));
+                break;
+            case WEECHAT_HDATA_TIME:
+                relay_weechat_msg_add_time (msg,
+                                            weechat_hdata_time (hdata,
+                                                                pointer,
+                                                                name));
+                break;
+            case WEECHAT_HDATA_HASHTABLE:
+                relay_weechat_msg_add_hashtable (msg,
+                                                 weechat_hdata_hashtable (hdata,
+                                                                          pointer,
+                                                                          name));
+                break;
+        }
     }
+    free (name);
+}
+
+/*
+ * Adds recursively hdata for a step of a compiled query to a message.
+ *
+ * Returns the number of hdata objects added to message.
+ */
+
+int
+relay_weechat_msg_add_hdata_path (struct t_relay_weechat_msg *msg,
+                                  struct t_relay_weechat_msg_hdata_query *query,
+                                  int index_step,
+                                  void **path_pointers,
+                                  void *pointer)
+{
+    struct t_relay_weechat_msg_hdata_step *ptr_step;
+    void *sub_pointer;
+    int num_added, i, count;
+
+    num_added = 0;
+
+    ptr_step = &(query->steps[index_step]);
+    count = ptr_step->count;
 
     while (pointer)
     {
-        path_pointers[index_path] = pointer;
+        path_pointers[index_step] = pointer;
 
-        if (list_path[index_path + 1])
+        if (index_step < query->num_steps - 1)
         {
-            /* recursive call with next path */
-            pos = strchr (list_path[index_path + 1], '(');
-            if (pos)
-                pos[0] = '\0';
-            sub_pointer = weechat_hdata_pointer (hdata, pointer, list_path[index_path + 1]);
-            sub_hdata_name = weechat_hdata_get_var_hdata (hdata, list_path[index_path + 1]);
-            if (pos)
-                pos[0] = '(';
-            if (sub_pointer && sub_hdata_name)
+            /* recursive call with next step */
+            sub_pointer = RELAY_WEECHAT_MSG_VAR(
+                void *, pointer, query->steps[index_step + 1].offset);
+            if (sub_pointer)
             {
-                sub_hdata = weechat_hdata_get (sub_hdata_name);
-                if (sub_hdata)
-                {
-                    num_added += relay_weechat_msg_add_hdata_path (msg,
-                                                                   list_path,
-                                                                   index_path + 1,
-                                                                   path_pointers,
-                                                                   sub_hdata,
-                                                                   sub_pointer,
-                                                                   list_keys);
-                }
+                num_added += relay_weechat_msg_add_hdata_path (msg,
+                                                               query,
+                                                               index_step + 1,
+                                                               path_pointers,
+                                                               sub_pointer);
             }
         }
         else
         {
-            /* last path? then get pointer + values and fill message with them */
-            for (i = 0; list_path[i]; i++)
+            /* last step? then add pointers + values in message */
+            for (i = 0; i <= index_step; i++)
             {
                 relay_weechat_msg_add_pointer (msg, path_pointers[i]);
             }
-            for (i = 0; list_keys[i]; i++)
+            for (i = 0; i < query->num_vars; i++)
             {
-                var_type = weechat_hdata_get_var_type (hdata, list_keys[i]);
-                if ((var_type >= 0) && (var_type != WEECHAT_HDATA_OTHER))
-                {
-                    max_array_size = 1;
-                    array_size = weechat_hdata_get_var_array_size (hdata,
-                                                                   pointer,
-                                                                   list_keys[i]);
-                    if (array_size >= 0)
-                    {
-                        switch (var_type)
-                        {
-                            case WEECHAT_HDATA_CHAR:
-                                relay_weechat_msg_add_type (msg, RELAY_WEECHAT_MSG_OBJ_CHAR);
-                                break;
-                            case WEECHAT_HDATA_INTEGER:
-                                relay_weechat_msg_add_type (msg, RELAY_WEECHAT_MSG_OBJ_INT);
-                                break;
-                            case WEECHAT_HDATA_LONG:
-                                relay_weechat_msg_add_type (msg, RELAY_WEECHAT_MSG_OBJ_LONG);
-                                break;
-                            case WEECHAT_HDATA_STRING:
-                            case WEECHAT_HDATA_SHARED_STRING:
-                                relay_weechat_msg_add_type (msg, RELAY_WEECHAT_MSG_OBJ_STRING);
-                                break;
-                            case WEECHAT_HDATA_POINTER:
-                                relay_weechat_msg_add_type (msg, RELAY_WEECHAT_MSG_OBJ_POINTER);
-                                break;
-                            case WEECHAT_HDATA_TIME:
-                                relay_weechat_msg_add_type (msg, RELAY_WEECHAT_MSG_OBJ_TIME);
-                                break;
-                            case WEECHAT_HDATA_HASHTABLE:
-                                relay_weechat_msg_add_type (msg, RELAY_WEECHAT_MSG_OBJ_HASHTABLE);
-                                break;
-                        }
-                        relay_weechat_msg_add_int (msg, array_size);
-                        max_array_size = array_size;
-                    }
-                    length = 16 + strlen (list_keys[i]) + 1;
-                    name = malloc (length);
-                    if (name)
-                    {
-                        for (j = 0; j < max_array_size; j++)
-                        {
-                            snprintf (name, length, "%d|%s", j, list_keys[i]);
-                            switch (var_type)
-                            {
-                                case WEECHAT_HDATA_CHAR:
-                                    relay_weechat_msg_add_char (msg,
-                                                                weechat_hdata_char (hdata,
-                                                                                    pointer,
-                                                                                    name));
-                                    break;
-                                case WEECHAT_HDATA_INTEGER:
-                                    relay_weechat_msg_add_int (msg,
-                                                               weechat_hdata_integer (hdata,
-                                                                                      pointer,
-                                                                                      name));
-                                    break;
-                                case WEECHAT_HDATA_LONG:
-                                    relay_weechat_msg_add_long (msg,
-                                                                weechat_hdata_long (hdata,
-                                                                                    pointer,
-                                                                                    name));
-                                    break;
-                                case WEECHAT_HDATA_STRING:
-                                case WEECHAT_HDATA_SHARED_STRING:
-                                    relay_weechat_msg_add_string (msg,
-                                                                  weechat_hdata_string (hdata,
-                                                                                        pointer,
-                                                                                        name));
-                                    break;
-                                case WEECHAT_HDATA_POINTER:
-                                    relay_weechat_msg_add_pointer (msg,
-                                                                   weechat_hdata_pointer (hdata,
-                                                                                          pointer,
-                                                                                          name));
-                                    break;
-                                case WEECHAT_HDATA_TIME:
-                                    relay_weechat_msg_add_time (msg,
-                                                                weechat_hdata_time (hdata,
-                                                                                    pointer,
-                                                                                    name));
-                                    break;
-                                case WEECHAT_HDATA_HASHTABLE:
-                                    relay_weechat_msg_add_hashtable (msg,
-                                                                     weechat_hdata_hashtable (hdata,
-                                                                                              pointer,
-                                                                                              name));
-                                    break;
-                            }
-                        }
-                        free (name);
-                    }
-                }
+                relay_weechat_msg_add_hdata_var (msg, ptr_step->hdata,
+                                                 pointer,
+                                                 &(query->vars[i]));
             }
             num_added++;
         }
-        if (count_all)
+        if (ptr_step->count_all || (count > 0))
         {
-            pointer = weechat_hdata_move (hdata, pointer, 1);
+            pointer = (ptr_step->offset_next >= 0) ?
+                RELAY_WEECHAT_MSG_VAR(void *, pointer,
+                                      ptr_step->offset_next) : NULL;
+            if (count > 0)
+                count--;
         }
-        else if (count == 0)
-            pointer = NULL;
-        else if (count > 0)
+        else if (count < 0)
         {
-            pointer = weechat_hdata_move (hdata, pointer, 1);
-            count--;
-        }
-        else
-        {
-            pointer = weechat_hdata_move (hdata, pointer, -1);
+            pointer = (ptr_step->offset_prev >= 0) ?
+                RELAY_WEECHAT_MSG_VAR(void *, pointer,
+                                      ptr_step->offset_prev) : NULL;
             count++;
         }
-        if (!pointer)
-            break;
+        else
+            pointer = NULL;
     }
 
     return num_added;
 }
 
+/*
+ * Adds a hdata to a message, using a compiled query.
+ *
+ * Returns the number of hdata objects added to message.
+ */
+
+int
+relay_weechat_msg_add_hdata_query (struct t_relay_weechat_msg *msg,
+                                   struct t_relay_weechat_msg_hdata_query *query,
+                                   void *pointer)
+{
+    void **path_pointers;
+    int pos_count, count;
+    uint32_t count32;
+
+    /* start hdata in message */
+    relay_weechat_msg_add_type (msg, RELAY_WEECHAT_MSG_OBJ_HDATA);
+    relay_weechat_msg_add_string (msg, query->path_returned);
+    relay_weechat_msg_add_string (msg, query->keys_types);
+
+    /* "count" will be set later, with number of objects in hdata */
+    pos_count = msg->data_size;
+    count = 0;
+    relay_weechat_msg_add_int (msg, 0);
+    path_pointers = malloc (sizeof (*path_pointers) * query->num_steps);
+    if (path_pointers)
+    {
+        count = relay_weechat_msg_add_hdata_path (msg, query, 0,
+                                                  path_pointers, pointer);
+        free (path_pointers);
+    }
+    count32 = htonl ((uint32_t)count);
+    relay_weechat_msg_set_bytes (msg, pos_count, &count32, 4);
+
+    return count;
+}
+
 /*
  * Adds a hdata to a message.
  *
@@ -552,24 +1001,18 @@ int
 relay_weechat_msg_add_hdata (struct t_relay_weechat_msg *msg,
                              const char *path, const char *keys)
 {
-    struct t_hdata *ptr_hdata_head, *ptr_hdata;
-    char *hdata_head, *pos, **list_keys, *keys_types, **list_path;
-    char *path_returned;
-    const char *hdata_name, *array_size;
-    void *pointer, **path_pointers;
+    struct t_hdata *ptr_hdata_head;
+    struct t_relay_weechat_msg_hdata_query *query;
+    char *hdata_head, *pos, **list_path;
+    void *pointer;
     unsigned long value;
-    int rc, num_keys, num_path, i, type, pos_count, count, rc_sscanf;
-    uint32_t count32;
+    int rc, num_path, rc_sscanf;
 
     rc = 0;
 
     hdata_head = NULL;
-    list_keys = NULL;
-    num_keys = 0;
-    keys_types = NULL;
     list_path = NULL;
     num_path = 0;
-    path_returned = NULL;
 
     /* extract hdata name (head) from path */
     pos = strchr (path, ':');
@@ -623,131 +1066,19 @@ relay_weechat_msg_add_hdata (struct t_relay_weechat_msg *msg,
     if (!pointer)
         goto end;
 
-    /*
-     * build string with path where:
-     * - counters are removed
-     * - variable names are replaced by hdata name
-     */
-    path_returned = malloc (strlen (path) * 2);
-    if (!path_returned)
+    /* get compiled query (hdata, offsets and types of variables) */
+    query = relay_weechat_msg_hdata_query_get (hdata_head, list_path,
+                                               num_path, keys);
+    if (!query)
         goto end;
-    ptr_hdata = ptr_hdata_head;
-    strcpy (path_returned, hdata_head);
-    for (i = 1; i < num_path; i++)
-    {
-        pos = strchr (list_path[i], '(');
-        if (pos)
-            pos[0] = '\0';
-        hdata_name = weechat_hdata_get_var_hdata (ptr_hdata, list_path[i]);
-        if (!hdata_name)
-            goto end;
-        ptr_hdata = weechat_hdata_get (hdata_name);
-        if (!ptr_hdata)
-            goto end;
-        strcat (path_returned, "/");
-        strcat (path_returned, hdata_name);
-        if (pos)
-            pos[0] = '(';
-    }
 
-    /* split keys */
-    if (!keys)
-        keys = weechat_hdata_get_string (ptr_hdata, "var_keys");
-    list_keys = weechat_string_split (keys, ",", NULL,
-                                      WEECHAT_STRING_SPLIT_STRIP_LEFT
-                                      | WEECHAT_STRING_SPLIT_STRIP_RIGHT
-                                      | WEECHAT_STRING_SPLIT_COLLAPSE_SEPS,
-                                      0, &num_keys);
-    if (!list_keys)
-        goto end;
-
-    /* build string with list of keys with types: "key1:type1,key2:type2,..." */
-    keys_types = malloc (strlen (keys) + (num_keys * 8) + 1);
-    if (!keys_types)
-        goto end;
-    keys_types[0] = '\0';
-    for (i = 0; i < num_keys; i++)
-    {
-        type = weechat_hdata_get_var_type (ptr_hdata, list_keys[i]);
-        if ((type >= 0) && (type != WEECHAT_HDATA_OTHER))
-        {
-            if (keys_types[0])
-                strcat (keys_types, ",");
-            strcat (keys_types, list_keys[i]);
-            strcat (keys_types, ":");
-            array_size = weechat_hdata_get_var_array_size_string (ptr_hdata,
-                                                                  NULL,
-                                                                  list_keys[i]);
-            if (array_size)
-                strcat (keys_types, RELAY_WEECHAT_MSG_OBJ_ARRAY);
-            else
-            {
-                switch (type)
-                {
-                    case WEECHAT_HDATA_CHAR:
-                        strcat (keys_types, RELAY_WEECHAT_MSG_OBJ_CHAR);
-                        break;
-                    case WEECHAT_HDATA_INTEGER:
-                        strcat (keys_types, RELAY_WEECHAT_MSG_OBJ_INT);
-                        break;
-                    case WEECHAT_HDATA_LONG:
-                        strcat (keys_types, RELAY_WEECHAT_MSG_OBJ_LONG);
-                        break;
-                    case WEECHAT_HDATA_STRING:
-                    case WEECHAT_HDATA_SHARED_STRING:
-                        strcat (keys_types, RELAY_WEECHAT_MSG_OBJ_STRING);
-                        break;
-                    case WEECHAT_HDATA_POINTER:
-                        strcat (keys_types, RELAY_WEECHAT_MSG_OBJ_POINTER);
-                        break;
-                    case WEECHAT_HDATA_TIME:
-                        strcat (keys_types, RELAY_WEECHAT_MSG_OBJ_TIME);
-                        break;
-                    case WEECHAT_HDATA_HASHTABLE:
-                        strcat (keys_types, RELAY_WEECHAT_MSG_OBJ_HASHTABLE);
-                        break;
-                }
-            }
-        }
-    }
-    if (!keys_types[0])
-        goto end;
-
-    /* start hdata in message */
-    relay_weechat_msg_add_type (msg, RELAY_WEECHAT_MSG_OBJ_HDATA);
-    relay_weechat_msg_add_string (msg, path_returned);
-    relay_weechat_msg_add_string (msg, keys_types);
-
-    /* "count" will be set later, with number of objects in hdata */
-    pos_count = msg->data_size;
-    count = 0;
-    relay_weechat_msg_add_int (msg, 0);
-    path_pointers = malloc (sizeof (*path_pointers) * num_path);
-    if (path_pointers)
-    {
-        count = relay_weechat_msg_add_hdata_path (msg,
-                                                  list_path,
-                                                  0,
-                                                  path_pointers,
-                                                  ptr_hdata_head,
-                                                  pointer,
-                                                  list_keys);
-        free (path_pointers);
-    }
-    count32 = htonl ((uint32_t)count);
-    relay_weechat_msg_set_bytes (msg, pos_count, &count32, 4);
+    relay_weechat_msg_add_hdata_query (msg, query, pointer);
 
     rc = 1;
 
 end:
-    if (list_keys)
-        weechat_string_free_split (list_keys);
-    if (keys_types)
-        free (keys_types);
     if (list_path)
         weechat_string_free_split (list_path);
-    if (path_returned)
-        free (path_returned);
     if (hdata_head)
         free (hdata_head);
 
@@ -1026,6 +1357,128 @@ relay_weechat_msg_add_nicklist (struct t_relay_weechat_msg *msg,
     relay_weechat_msg_set_bytes (msg, pos_count, &count32, 4);
 }
 
+/*
+ * Adds nicklist of buffers changed after a line id, as hdata object.
+ *
+ * Argument "buffers" is a hashtable with pointers to buffers, if NULL all
+ * buffers are used.
+ */
+
+void
+relay_weechat_msg_add_nicklist_since (struct t_relay_weechat_msg *msg,
+                                      struct t_hashtable *buffers,
+                                      long id)
+{
+    struct t_hdata *ptr_hdata;
+    struct t_gui_buffer *ptr_buffer;
+    int pos_count, count;
+    uint32_t count32;
+
+    relay_weechat_msg_add_type (msg, RELAY_WEECHAT_MSG_OBJ_HDATA);
+    relay_weechat_msg_add_string (msg, "buffer/nicklist_item");
+    relay_weechat_msg_add_string (msg,
+                                  "group:chr,visible:chr,level:int,"
+                                  "name:str,color:str,"
+                                  "prefix:str,prefix_color:str");
+
+    /* "count" will be set later, with number of objects in hdata */
+    pos_count = msg->data_size;
+    count = 0;
+    relay_weechat_msg_add_int (msg, 0);
+
+    ptr_hdata = weechat_hdata_get ("buffer");
+    ptr_buffer = weechat_hdata_get_list (ptr_hdata, "gui_buffers");
+    while (ptr_buffer)
+    {
+        if ((!buffers || weechat_hashtable_has_key (buffers, ptr_buffer))
+            && (weechat_hdata_long (ptr_hdata, ptr_buffer,
+                                    "nicklist_last_id") >= id))
+        {
+            count += relay_weechat_msg_add_nicklist_buffer (msg, ptr_buffer,
+                                                            NULL);
+        }
+        ptr_buffer = weechat_hdata_move (ptr_hdata, ptr_buffer, 1);
+    }
+
+    count32 = htonl ((uint32_t)count);
+    relay_weechat_msg_set_bytes (msg, pos_count, &count32, 4);
+}
+
+/*
+ * Adds lines with an id greater than "id" to a message, as hdata object
+ * "line_data".
+ *
+ * Argument "buffers" is a hashtable with pointers to buffers, if NULL all
+ * buffers are used.
+ *
+ * Argument keys is a comma-separated list of keys to return for each line.
+ *
+ * Returns the number of lines added to message.
+ */
+
+int
+relay_weechat_msg_add_lines_since (struct t_relay_weechat_msg *msg,
+                                   struct t_hashtable *buffers,
+                                   long id, const char *keys)
+{
+    struct t_hdata *ptr_hdata_buffer;
+    struct t_relay_weechat_msg_hdata_query *query;
+    struct t_gui_buffer *ptr_buffer;
+    struct t_gui_lines_export *lines_export;
+    void **ptr_line_data;
+    void *path_pointers[1];
+    char *list_path[2] = { "line_data", NULL };
+    int i, num_lines, pos_count, count;
+    uint32_t count32;
+
+    ptr_hdata_buffer = weechat_hdata_get ("buffer");
+    if (!ptr_hdata_buffer)
+        return 0;
+
+    query = relay_weechat_msg_hdata_query_get ("line_data", list_path, 1,
+                                               keys);
+    if (!query)
+        return 0;
+
+    /* start hdata in message */
+    relay_weechat_msg_add_type (msg, RELAY_WEECHAT_MSG_OBJ_HDATA);
+    relay_weechat_msg_add_string (msg, query->path_returned);
+    relay_weechat_msg_add_string (msg, query->keys_types);
+
+    /* "count" will be set later, with number of objects in hdata */
+    pos_count = msg->data_size;
+    count = 0;
+    relay_weechat_msg_add_int (msg, 0);
+
+    ptr_buffer = weechat_hdata_get_list (ptr_hdata_buffer, "gui_buffers");
+    while (ptr_buffer)
+    {
+        if (!buffers || weechat_hashtable_has_key (buffers, ptr_buffer))
+        {
+            /* get lines with id > "id" (ids are increasing in buffer) */
+            lines_export = weechat_buffer_lines_export (ptr_buffer, id, 0, 0);
+            if (lines_export)
+            {
+                ptr_line_data = weechat_buffer_lines_export_get (lines_export,
+                                                                 "line_data",
+                                                                 &num_lines);
+                for (i = 0; i < num_lines; i++)
+                {
+                    count += relay_weechat_msg_add_hdata_path (
+                        msg, query, 0, path_pointers, ptr_line_data[i]);
+                }
+                weechat_buffer_lines_export_free (lines_export);
+            }
+        }
+        ptr_buffer = weechat_hdata_move (ptr_hdata_buffer, ptr_buffer, 1);
+    }
+
+    count32 = htonl ((uint32_t)count);
+    relay_weechat_msg_set_bytes (msg, pos_count, &count32, 4);
+
+    return count;
+}
+
 /*
  * Sends a message.
  */
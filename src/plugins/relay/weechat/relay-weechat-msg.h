@@ -26,6 +26,13 @@ struct t_relay_weechat_nicklist;
 
 #define RELAY_WEECHAT_MSG_INITIAL_ALLOC 4096
 
+/* max number of compiled hdata queries kept in cache */
+#define RELAY_WEECHAT_MSG_HDATA_QUERIES_MAX 256
+
+/* read a variable at an offset in a structure (for compiled hdata queries) */
+#define RELAY_WEECHAT_MSG_VAR(__type, __pointer, __offset)              \
+    (*((__type *)(((char *)(__pointer)) + (__offset))))
+
 /* object ids in binary messages */
 #define RELAY_WEECHAT_MSG_OBJ_CHAR      "chr"
 #define RELAY_WEECHAT_MSG_OBJ_INT       "int"
@@ -48,6 +55,41 @@ struct t_relay_weechat_msg
     int data_size;                     /* current size of buffer            */
 };
 
+/* compiled hdata query: hdata and offsets resolved once for a path */
+
+struct t_relay_weechat_msg_hdata_step
+{
+    char *hdata_name;                  /* name of hdata                     */
+    struct t_hdata *hdata;             /* hdata of objects in this step     */
+    int offset;                        /* offset of pointer in object of    */
+                                       /* previous step (-1 for 1st step)   */
+    int offset_prev;                   /* offset of pointer to prev object  */
+    int offset_next;                   /* offset of pointer to next object  */
+    int count_all;                     /* 1 for "(*)": all objects in list  */
+    int count;                         /* number of objects to move         */
+                                       /* (< 0 = move backward)             */
+};
+
+struct t_relay_weechat_msg_hdata_var
+{
+    char *name;                        /* name of variable                  */
+    int type;                          /* type (WEECHAT_HDATA_XXX)          */
+    int offset;                        /* offset of variable in object      */
+    int array;                         /* 1 if variable is an array         */
+};
+
+struct t_relay_weechat_msg_hdata_query
+{
+    char *path_returned;               /* path with hdata names             */
+    char *keys_types;                  /* "key1:type1,key2:type2,..."       */
+    int num_steps;                     /* number of steps in path           */
+    struct t_relay_weechat_msg_hdata_step *steps; /* steps in path          */
+    int num_vars;                      /* number of variables returned      */
+    struct t_relay_weechat_msg_hdata_var *vars;   /* variables returned     */
+};
+
+extern struct t_hashtable *relay_weechat_msg_hdata_queries;
+
 extern struct t_relay_weechat_msg *relay_weechat_msg_new (const char *id);
 extern void relay_weechat_msg_add_bytes (struct t_relay_weechat_msg *msg,
                                          const void *buffer, int size);
@@ -70,6 +112,22 @@ extern void relay_weechat_msg_add_pointer (struct t_relay_weechat_msg *msg,
                                            void *pointer);
 extern void relay_weechat_msg_add_time (struct t_relay_weechat_msg *msg,
                                         time_t time);
+extern char *relay_weechat_msg_hdata_keys_types (struct t_hdata *hdata,
+                                                 char **list_keys,
+                                                 int num_keys);
+extern struct t_relay_weechat_msg_hdata_query *relay_weechat_msg_hdata_query_compile (const char *hdata_head,
+                                                                                      char **list_path,
+                                                                                      int num_path,
+                                                                                      const char *keys);
+extern void relay_weechat_msg_hdata_query_free (struct t_relay_weechat_msg_hdata_query *query);
+extern struct t_relay_weechat_msg_hdata_query *relay_weechat_msg_hdata_query_get (const char *hdata_head,
+                                                                                  char **list_path,
+                                                                                  int num_path,
+                                                                                  const char *keys);
+extern void relay_weechat_msg_hdata_query_free_all ();
+extern int relay_weechat_msg_add_hdata_query (struct t_relay_weechat_msg *msg,
+                                              struct t_relay_weechat_msg_hdata_query *query,
+                                              void *pointer);
 extern int relay_weechat_msg_add_hdata (struct t_relay_weechat_msg *msg,
                                         const char *path, const char *keys);
 extern void relay_weechat_msg_add_infolist (struct t_relay_weechat_msg *msg,
@@ -79,6 +137,12 @@ extern void relay_weechat_msg_add_infolist (struct t_relay_weechat_msg *msg,
 extern void relay_weechat_msg_add_nicklist (struct t_relay_weechat_msg *msg,
                                             struct t_gui_buffer *buffer,
                                             struct t_relay_weechat_nicklist *nicklist);
+extern void relay_weechat_msg_add_nicklist_since (struct t_relay_weechat_msg *msg,
+                                                  struct t_hashtable *buffers,
+                                                  long id);
+extern int relay_weechat_msg_add_lines_since (struct t_relay_weechat_msg *msg,
+                                              struct t_hashtable *buffers,
+                                              long id, const char *keys);
 extern void relay_weechat_msg_send (struct t_relay_client *client,
                                     struct t_relay_weechat_msg *msg);
 extern void relay_weechat_msg_free (struct t_relay_weechat_msg *msg);
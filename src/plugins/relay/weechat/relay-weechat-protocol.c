@@ -951,7 +951,7 @@ relay_weechat_protocol_signal_buffer_cb (const void *pointer, void *data,
                           "line_data:0x%lx",
                           (unsigned long)ptr_line_data);
                 relay_weechat_msg_add_hdata (msg, cmd_hdata,
-                                             "buffer,date,date_printed,"
+                                             "id,buffer,date,date_printed,"
                                              "displayed,highlight,tags_array,"
                                              "prefix,message");
                 relay_weechat_msg_send (ptr_client, msg);
@@ -1492,6 +1492,91 @@ RELAY_WEECHAT_PROTOCOL_CALLBACK(test)
     return WEECHAT_RC_OK;
 }
 
+/*
+ * Callback for command "resume" (from client).
+ *
+ * Sends in a single message what changed since a line id (last line id
+ * received by client): list of buffers, nicklists changed and new lines.
+ *
+ * Message looks like:
+ *   resume 12345
+ *   resume 12345 irc.freenode.#weechat,irc.freenode.#test
+ *   resume 12345 0x12345678
+ */
+
+RELAY_WEECHAT_PROTOCOL_CALLBACK(resume)
+{
+    struct t_relay_weechat_msg *msg;
+    struct t_gui_buffer *ptr_buffer;
+    struct t_hashtable *buffers;
+    char *error, **list_buffers;
+    long line_id;
+    int i, num_buffers;
+
+    RELAY_WEECHAT_PROTOCOL_MIN_ARGS(1);
+
+    error = NULL;
+    line_id = strtol (argv[0], &error, 10);
+    if (!error || error[0] || (line_id < 0))
+    {
+        if (weechat_relay_plugin->debug >= 1)
+        {
+            weechat_printf (NULL,
+                            _("%s: invalid line id in message: \"%s %s\""),
+                            RELAY_PLUGIN_NAME,
+                            command,
+                            argv_eol[0]);
+        }
+        return WEECHAT_RC_OK;
+    }
+
+    buffers = NULL;
+    if (argc > 1)
+    {
+        buffers = weechat_hashtable_new (32,
+                                         WEECHAT_HASHTABLE_POINTER,
+                                         WEECHAT_HASHTABLE_POINTER,
+                                         NULL, NULL);
+        if (!buffers)
+            return WEECHAT_RC_OK;
+        list_buffers = weechat_string_split (argv[1], ",", NULL,
+                                             WEECHAT_STRING_SPLIT_STRIP_LEFT
+                                             | WEECHAT_STRING_SPLIT_STRIP_RIGHT
+                                             | WEECHAT_STRING_SPLIT_COLLAPSE_SEPS,
+                                             0, &num_buffers);
+        if (list_buffers)
+        {
+            for (i = 0; i < num_buffers; i++)
+            {
+                ptr_buffer = relay_weechat_protocol_get_buffer (list_buffers[i]);
+                if (ptr_buffer)
+                    weechat_hashtable_set (buffers, ptr_buffer, NULL);
+            }
+            weechat_string_free_split (list_buffers);
+        }
+    }
+
+    msg = relay_weechat_msg_new (id);
+    if (msg)
+    {
+        relay_weechat_msg_add_hdata (msg, "buffer:gui_buffers(*)",
+                                     "number,full_name,short_name,type,"
+                                     "nicklist,title,local_variables");
+        relay_weechat_msg_add_nicklist_since (msg, buffers, line_id);
+        relay_weechat_msg_add_lines_since (msg, buffers, line_id,
+                                           "id,buffer,date,date_printed,"
+                                           "displayed,highlight,tags_array,"
+                                           "prefix,message");
+        relay_weechat_msg_send (client, msg);
+        relay_weechat_msg_free (msg);
+    }
+
+    if (buffers)
+        weechat_hashtable_free (buffers);
+
+    return WEECHAT_RC_OK;
+}
+
 /*
  * Callback for command "ping" (from client).
  *
@@ -1555,6 +1640,7 @@ relay_weechat_protocol_recv (struct t_relay_client *client, const char *data)
           { "sync", &relay_weechat_protocol_cb_sync },
           { "desync", &relay_weechat_protocol_cb_desync },
           { "test", &relay_weechat_protocol_cb_test },
+          { "resume", &relay_weechat_protocol_cb_resume },
           { "ping", &relay_weechat_protocol_cb_ping },
           { "quit", &relay_weechat_protocol_cb_quit },
           { NULL, NULL }
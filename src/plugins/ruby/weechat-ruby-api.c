@@ -3892,6 +3892,79 @@ weechat_ruby_api_hook_set (VALUE class, VALUE hook, VALUE property,
     API_RETURN_OK;
 }
 
+int
+weechat_ruby_api_hook_batch_cb (const void *pointer, void *data,
+                               struct t_infolist *events)
+{
+    struct t_plugin_script *script;
+    void *func_argv[2];
+    char empty_arg[1] = { '\0' };
+    const char *ptr_function, *ptr_data;
+    int *rc, ret;
+
+    script = (struct t_plugin_script *)pointer;
+    plugin_script_get_function_and_data (data, &ptr_function, &ptr_data);
+
+    if (ptr_function && ptr_function[0])
+    {
+        func_argv[0] = (ptr_data) ? (char *)ptr_data : empty_arg;
+        func_argv[1] = (char *)API_PTR2STR(events);
+
+        rc = (int *) weechat_ruby_exec (script,
+                                        WEECHAT_SCRIPT_EXEC_INT,
+                                        ptr_function,
+                                        "ss", func_argv);
+
+        if (!rc)
+            ret = WEECHAT_RC_ERROR;
+        else
+        {
+            ret = *rc;
+            free (rc);
+        }
+
+        return ret;
+    }
+
+    return WEECHAT_RC_ERROR;
+}
+
+static VALUE
+weechat_ruby_api_hook_batch (VALUE class, VALUE hook, VALUE max_size,
+                             VALUE max_latency, VALUE function, VALUE data)
+{
+    char *c_hook, *c_function, *c_data;
+    int c_max_size, c_max_latency, rc;
+
+    API_INIT_FUNC(1, "hook_batch", API_RETURN_INT(0));
+    if (NIL_P (hook) || NIL_P (max_size) || NIL_P (max_latency)
+        || NIL_P (function) || NIL_P (data))
+        API_WRONG_ARGS(API_RETURN_INT(0));
+
+    Check_Type (hook, T_STRING);
+    CHECK_INTEGER(max_size);
+    CHECK_INTEGER(max_latency);
+    Check_Type (function, T_STRING);
+    Check_Type (data, T_STRING);
+
+    c_hook = StringValuePtr (hook);
+    c_max_size = NUM2INT (max_size);
+    c_max_latency = NUM2INT (max_latency);
+    c_function = StringValuePtr (function);
+    c_data = StringValuePtr (data);
+
+    rc = plugin_script_api_hook_batch (weechat_ruby_plugin,
+                                       ruby_current_script,
+                                       API_STR2PTR(c_hook),
+                                       c_max_size,
+                                       c_max_latency,
+                                       &weechat_ruby_api_hook_batch_cb,
+                                       c_function,
+                                       c_data);
+
+    API_RETURN_INT(rc);
+}
+
 static VALUE
 weechat_ruby_api_unhook (VALUE class, VALUE hook)
 {
@@ -6373,6 +6446,7 @@ weechat_ruby_api_init (VALUE ruby_mWeechat)
     API_DEF_FUNC(hook_infolist, 6);
     API_DEF_FUNC(hook_focus, 3);
     API_DEF_FUNC(hook_set, 3);
+    API_DEF_FUNC(hook_batch, 5);
     API_DEF_FUNC(unhook, 1);
     API_DEF_FUNC(unhook_all, 0);
     API_DEF_FUNC(buffer_new, 5);
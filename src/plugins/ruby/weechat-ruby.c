@@ -958,12 +958,12 @@ weechat_ruby_command_cb (const void *pointer, void *data,
         }
         else if (weechat_strcasecmp (argv[1], "autoload") == 0)
         {
-            plugin_script_auto_load (weechat_ruby_plugin, &weechat_ruby_load_cb);
+            plugin_script_auto_load (weechat_ruby_plugin, &ruby_data);
         }
         else if (weechat_strcasecmp (argv[1], "reload") == 0)
         {
             weechat_ruby_unload_all ();
-            plugin_script_auto_load (weechat_ruby_plugin, &weechat_ruby_load_cb);
+            plugin_script_auto_load (weechat_ruby_plugin, &ruby_data);
         }
         else if (weechat_strcasecmp (argv[1], "unload") == 0)
         {
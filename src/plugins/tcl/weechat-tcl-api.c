@@ -3536,6 +3536,68 @@ API_FUNC(hook_set)
     API_RETURN_OK;
 }
 
+int
+weechat_tcl_api_hook_batch_cb (const void *pointer, void *data,
+                              struct t_infolist *events)
+{
+    struct t_plugin_script *script;
+    void *func_argv[2];
+    char empty_arg[1] = { '\0' };
+    const char *ptr_function, *ptr_data;
+    int *rc, ret;
+
+    script = (struct t_plugin_script *)pointer;
+    plugin_script_get_function_and_data (data, &ptr_function, &ptr_data);
+
+    if (ptr_function && ptr_function[0])
+    {
+        func_argv[0] = (ptr_data) ? (char *)ptr_data : empty_arg;
+        func_argv[1] = (char *)API_PTR2STR(events);
+
+        rc = (int *) weechat_tcl_exec (script,
+                                       WEECHAT_SCRIPT_EXEC_INT,
+                                       ptr_function,
+                                       "ss", func_argv);
+
+        if (!rc)
+            ret = WEECHAT_RC_ERROR;
+        else
+        {
+            ret = *rc;
+            free (rc);
+        }
+
+        return ret;
+    }
+
+    return WEECHAT_RC_ERROR;
+}
+
+API_FUNC(hook_batch)
+{
+    Tcl_Obj *objp;
+    int i, max_size, max_latency, rc;
+
+    API_INIT_FUNC(1, "hook_batch", API_RETURN_INT(0));
+    if (objc < 6)
+        API_WRONG_ARGS(API_RETURN_INT(0));
+
+    if ((Tcl_GetIntFromObj (interp, objv[2], &max_size) != TCL_OK)
+        || (Tcl_GetIntFromObj (interp, objv[3], &max_latency) != TCL_OK))
+        API_WRONG_ARGS(API_RETURN_INT(0));
+
+    rc = plugin_script_api_hook_batch (weechat_tcl_plugin,
+                                       tcl_current_script,
+                                       API_STR2PTR(Tcl_GetStringFromObj (objv[1], &i)), /* hook */
+                                       max_size,
+                                       max_latency,
+                                       &weechat_tcl_api_hook_batch_cb,
+                                       Tcl_GetStringFromObj (objv[4], &i), /* tcl function */
+                                       Tcl_GetStringFromObj (objv[5], &i)); /* data */
+
+    API_RETURN_INT(rc);
+}
+
 API_FUNC(unhook)
 {
     Tcl_Obj *objp;
@@ -5732,6 +5794,7 @@ void weechat_tcl_api_init (Tcl_Interp *interp)
     API_DEF_FUNC(hook_infolist);
     API_DEF_FUNC(hook_focus);
     API_DEF_FUNC(hook_set);
+    API_DEF_FUNC(hook_batch);
     API_DEF_FUNC(unhook);
     API_DEF_FUNC(unhook_all);
     API_DEF_FUNC(buffer_new);
@@ -606,12 +606,12 @@ weechat_tcl_command_cb (const void *pointer, void *data,
         }
         else if (weechat_strcasecmp (argv[1], "autoload") == 0)
         {
-            plugin_script_auto_load (weechat_tcl_plugin, &weechat_tcl_load_cb);
+            plugin_script_auto_load (weechat_tcl_plugin, &tcl_data);
         }
         else if (weechat_strcasecmp (argv[1], "reload") == 0)
         {
             weechat_tcl_unload_all ();
-            plugin_script_auto_load (weechat_tcl_plugin, &weechat_tcl_load_cb);
+            plugin_script_auto_load (weechat_tcl_plugin, &tcl_data);
         }
         else if (weechat_strcasecmp (argv[1], "unload") == 0)
         {
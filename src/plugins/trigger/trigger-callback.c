@@ -36,6 +36,9 @@ struct t_hashtable *trigger_callback_hashtable_options_conditions = NULL;
 /* hashtable used to replace with regex */
 struct t_hashtable *trigger_callback_hashtable_options_regex = NULL;
 
+/* context of last event received, shared by triggers */
+struct t_trigger_context trigger_callback_context;
+
 
 /*
  * Parses an IRC message.
@@ -179,11 +182,721 @@ trigger_callback_set_tags (struct t_gui_buffer *buffer,
         }
         else if (strncmp (tags[i], "host_", 5) == 0)
         {
-            weechat_hashtable_set (extra_vars, "tg_tag_host", tags[i] + 5);
+            weechat_hashtable_set (extra_vars, "tg_tag_host", tags[i] + 5);
+        }
+    }
+
+    return 1;
+}
+
+/*
+ * Compares two strings (NULL strings are allowed).
+ *
+ * Returns:
+ *   1: strings are equal
+ *   0: strings are different
+ */
+
+int
+trigger_callback_context_string_equal (const char *string1,
+                                       const char *string2)
+{
+    if (!string1 || !string2)
+        return (string1 == string2) ? 1 : 0;
+
+    return (strcmp (string1, string2) == 0) ? 1 : 0;
+}
+
+/*
+ * Checks if tags are the same as tags in a string (tags separated by commas).
+ *
+ * Returns:
+ *   1: tags are the same
+ *   0: tags are different
+ */
+
+int
+trigger_callback_context_match_tags (const char *str_tags,
+                                     int tags_count, const char **tags)
+{
+    const char *ptr_tags;
+    int i, length;
+
+    if (tags_count == 0)
+        return 1;
+
+    if (!str_tags || !tags)
+        return 0;
+
+    ptr_tags = str_tags;
+    for (i = 0; i < tags_count; i++)
+    {
+        length = strlen (tags[i]);
+        if ((strncmp (ptr_tags, tags[i], length) != 0)
+            || (ptr_tags[length] != ((i < tags_count - 1) ? ',' : '\0')))
+        {
+            return 0;
+        }
+        ptr_tags += length + 1;
+    }
+
+    return 1;
+}
+
+/*
+ * Resets the context shared by triggers.
+ */
+
+void
+trigger_callback_context_reset ()
+{
+    int i;
+
+    trigger_callback_context.hook_type = -1;
+    trigger_callback_context.buffer = NULL;
+    trigger_callback_context.date = 0;
+    trigger_callback_context.displayed = 0;
+    trigger_callback_context.highlight = 0;
+    trigger_callback_context.tags_count = 0;
+    for (i = 0; i < TRIGGER_CONTEXT_NUM_KEYS; i++)
+    {
+        if (trigger_callback_context.keys[i])
+        {
+            free (trigger_callback_context.keys[i]);
+            trigger_callback_context.keys[i] = NULL;
+        }
+    }
+    if (trigger_callback_context.pointers)
+    {
+        weechat_hashtable_free (trigger_callback_context.pointers);
+        trigger_callback_context.pointers = NULL;
+    }
+    if (trigger_callback_context.extra_vars)
+    {
+        weechat_hashtable_free (trigger_callback_context.extra_vars);
+        trigger_callback_context.extra_vars = NULL;
+    }
+    trigger_callback_context.irc_message = 0;
+    trigger_callback_context.no_trigger = 0;
+    trigger_callback_context.nocolor = 0;
+}
+
+/*
+ * Checks if the context shared by triggers is for the given event.
+ *
+ * Returns:
+ *   1: context is for this event
+ *   0: context is for another event
+ */
+
+int
+trigger_callback_context_match (int hook_type, const char **keys)
+{
+    int i;
+
+    if (trigger_callback_context.hook_type != hook_type)
+        return 0;
+
+    for (i = 0; i < TRIGGER_CONTEXT_NUM_KEYS; i++)
+    {
+        if (!trigger_callback_context_string_equal (
+                trigger_callback_context.keys[i], keys[i]))
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/*
+ * Initializes the context shared by triggers for a new event.
+ *
+ * Returns pointer to context, NULL if error.
+ */
+
+struct t_trigger_context *
+trigger_callback_context_new (int hook_type, const char **keys)
+{
+    int i;
+
+    trigger_callback_context_reset ();
+
+    trigger_callback_context.pointers = weechat_hashtable_new (
+        32,
+        WEECHAT_HASHTABLE_STRING,
+        WEECHAT_HASHTABLE_POINTER,
+        NULL, NULL);
+    trigger_callback_context.extra_vars = weechat_hashtable_new (
+        32,
+        WEECHAT_HASHTABLE_STRING,
+        WEECHAT_HASHTABLE_STRING,
+        NULL, NULL);
+    if (!trigger_callback_context.pointers
+        || !trigger_callback_context.extra_vars)
+    {
+        trigger_callback_context_reset ();
+        return NULL;
+    }
+
+    trigger_callback_context.hook_type = hook_type;
+    for (i = 0; i < TRIGGER_CONTEXT_NUM_KEYS; i++)
+    {
+        trigger_callback_context.keys[i] = (keys[i]) ? strdup (keys[i]) : NULL;
+    }
+
+    return &trigger_callback_context;
+}
+
+/*
+ * Checks if a trigger uses variables without colors ("*_nocolor").
+ *
+ * Returns:
+ *   1: trigger uses variables without colors
+ *   0: trigger does not use variables without colors
+ */
+
+int
+trigger_callback_needs_nocolor (struct t_trigger *trigger)
+{
+    const char *conditions;
+    int i;
+
+    /* all variables are displayed on monitor buffer */
+    if (trigger_buffer || (weechat_trigger_plugin->debug >= 1))
+        return 1;
+
+    conditions = weechat_config_string (
+        trigger->options[TRIGGER_OPTION_CONDITIONS]);
+    if (conditions && strstr (conditions, "_nocolor"))
+        return 1;
+
+    for (i = 0; i < trigger->regex_count; i++)
+    {
+        if ((trigger->regex[i].variable
+             && strstr (trigger->regex[i].variable, "_nocolor"))
+            || (trigger->regex[i].replace
+                && strstr (trigger->regex[i].replace, "_nocolor")))
+        {
+            return 1;
+        }
+    }
+
+    for (i = 0; i < trigger->commands_count; i++)
+    {
+        if (strstr (trigger->commands[i], "_nocolor"))
+            return 1;
+    }
+
+    return 0;
+}
+
+/*
+ * Sets a variable without colors in the context shared by triggers.
+ */
+
+void
+trigger_callback_context_set_nocolor (struct t_trigger_context *context,
+                                      const char *var_name,
+                                      const char *var_name_nocolor)
+{
+    char *string_no_color;
+
+    string_no_color = weechat_string_remove_color (
+        weechat_hashtable_get (context->extra_vars, var_name), NULL);
+    if (string_no_color)
+    {
+        weechat_hashtable_set (context->extra_vars,
+                               var_name_nocolor, string_no_color);
+        free (string_no_color);
+    }
+}
+
+/*
+ * Sets variables without colors ("*_nocolor") in the context shared by
+ * triggers (they are computed only once per event, and only if a trigger
+ * uses them).
+ */
+
+void
+trigger_callback_context_add_nocolor (struct t_trigger_context *context)
+{
+    const char *ptr_modifier, *ptr_string, *pos;
+    char *prefix;
+
+    if (context->nocolor)
+        return;
+
+    context->nocolor = 1;
+
+    switch (context->hook_type)
+    {
+        case TRIGGER_HOOK_MODIFIER:
+            trigger_callback_context_set_nocolor (context,
+                                                  "tg_string",
+                                                  "tg_string_nocolor");
+            ptr_modifier = weechat_hashtable_get (context->extra_vars,
+                                                  "tg_modifier");
+            ptr_string = weechat_hashtable_get (context->extra_vars,
+                                                "tg_string_nocolor");
+            if (ptr_modifier && ptr_string
+                && (strcmp (ptr_modifier, "weechat_print") == 0))
+            {
+                /* set "tg_prefix_nocolor" and "tg_message_nocolor" */
+                pos = strchr (ptr_string, '\t');
+                if (pos)
+                {
+                    if (pos > ptr_string)
+                    {
+                        prefix = weechat_strndup (ptr_string,
+                                                  pos - ptr_string);
+                        if (prefix)
+                        {
+                            weechat_hashtable_set (context->extra_vars,
+                                                   "tg_prefix_nocolor",
+                                                   prefix);
+                            free (prefix);
+                        }
+                    }
+                    pos++;
+                    if (pos[0] == '\t')
+                        pos++;
+                    weechat_hashtable_set (context->extra_vars,
+                                           "tg_message_nocolor", pos);
+                }
+                else
+                {
+                    weechat_hashtable_set (context->extra_vars,
+                                           "tg_message_nocolor", ptr_string);
+                }
+            }
+            break;
+        case TRIGGER_HOOK_LINE:
+            trigger_callback_context_set_nocolor (context,
+                                                  "prefix",
+                                                  "tg_prefix_nocolor");
+            trigger_callback_context_set_nocolor (context,
+                                                  "message",
+                                                  "tg_message_nocolor");
+            break;
+        case TRIGGER_HOOK_PRINT:
+            trigger_callback_context_set_nocolor (context,
+                                                  "tg_prefix",
+                                                  "tg_prefix_nocolor");
+            trigger_callback_context_set_nocolor (context,
+                                                  "tg_message",
+                                                  "tg_message_nocolor");
+            break;
+        default:
+            break;
+    }
+}
+
+/*
+ * Duplicates variables of the context shared by triggers, so that they can
+ * be updated by the trigger.
+ *
+ * Returns:
+ *   1: OK
+ *   0: error
+ *
+ * Note: hashtables "pointers" and "extra_vars" must be freed after use.
+ */
+
+int
+trigger_callback_context_get_vars (struct t_trigger_context *context,
+                                   struct t_trigger *trigger,
+                                   struct t_hashtable **pointers,
+                                   struct t_hashtable **extra_vars)
+{
+    if (!context->nocolor && trigger_callback_needs_nocolor (trigger))
+        trigger_callback_context_add_nocolor (context);
+
+    *pointers = weechat_hashtable_dup (context->pointers);
+    *extra_vars = weechat_hashtable_dup (context->extra_vars);
+
+    return (*pointers && *extra_vars) ? 1 : 0;
+}
+
+/*
+ * Gets context shared by triggers for an IRC message received in a signal
+ * (the IRC message is parsed only once for all triggers).
+ *
+ * Returns pointer to context, NULL if error.
+ */
+
+struct t_trigger_context *
+trigger_callback_context_irc_message (const char *irc_server_name,
+                                      const char *irc_message)
+{
+    struct t_trigger_context *context;
+    struct t_hashtable *hashtable;
+    const char *keys[TRIGGER_CONTEXT_NUM_KEYS];
+
+    keys[0] = irc_server_name;
+    keys[1] = irc_message;
+    keys[2] = NULL;
+    keys[3] = NULL;
+
+    if (trigger_callback_context_match (TRIGGER_HOOK_SIGNAL, keys))
+        return &trigger_callback_context;
+
+    hashtable = trigger_callback_irc_message_parse (irc_message,
+                                                    irc_server_name);
+    if (!hashtable)
+        return NULL;
+
+    context = trigger_callback_context_new (TRIGGER_HOOK_SIGNAL, keys);
+    if (!context)
+    {
+        weechat_hashtable_free (hashtable);
+        return NULL;
+    }
+
+    weechat_hashtable_free (context->extra_vars);
+    context->extra_vars = hashtable;
+    weechat_hashtable_set (context->extra_vars, "server", irc_server_name);
+    context->irc_message = 1;
+
+    return context;
+}
+
+/*
+ * Gets context shared by triggers for a modifier.
+ *
+ * Returns pointer to context, NULL if error.
+ */
+
+struct t_trigger_context *
+trigger_callback_context_modifier (const char *modifier,
+                                   const char *modifier_data,
+                                   const char *string)
+{
+    struct t_trigger_context *context;
+    struct t_hashtable *hashtable;
+    struct t_gui_buffer *buffer;
+    const char *keys[TRIGGER_CONTEXT_NUM_KEYS];
+    char *pos, *pos2, *plugin_name, *buffer_name, *buffer_full_name;
+    char *str_tags, **tags, *prefix;
+    int length, num_tags;
+
+    keys[0] = modifier;
+    keys[1] = modifier_data;
+    keys[2] = string;
+    keys[3] = NULL;
+
+    if (trigger_callback_context_match (TRIGGER_HOOK_MODIFIER, keys))
+        return &trigger_callback_context;
+
+    context = trigger_callback_context_new (TRIGGER_HOOK_MODIFIER, keys);
+    if (!context)
+        return NULL;
+
+    buffer = NULL;
+    tags = NULL;
+    num_tags = 0;
+
+    /* split IRC message (if string is an IRC message) */
+    if ((strncmp (modifier, "irc_in_", 7) == 0)
+        || (strncmp (modifier, "irc_in2_", 8) == 0)
+        || (strncmp (modifier, "irc_out1_", 9) == 0)
+        || (strncmp (modifier, "irc_out_", 8) == 0))
+    {
+        hashtable = trigger_callback_irc_message_parse (string,
+                                                        modifier_data);
+        if (hashtable)
+        {
+            weechat_hashtable_free (context->extra_vars);
+            context->extra_vars = hashtable;
+            weechat_hashtable_set (context->extra_vars,
+                                   "server", modifier_data);
+            context->irc_message = 1;
+        }
+    }
+
+    /* add data in hashtable used for conditions/replace/command */
+    weechat_hashtable_set (context->extra_vars, "tg_modifier", modifier);
+    weechat_hashtable_set (context->extra_vars,
+                           "tg_modifier_data", modifier_data);
+    weechat_hashtable_set (context->extra_vars, "tg_string", string);
+
+    /* add special variables for a WeeChat message */
+    if (strcmp (modifier, "weechat_print") == 0)
+    {
+        /* set "tg_prefix" and "tg_message" */
+        pos = strchr (string, '\t');
+        if (pos)
+        {
+            if (pos > string)
+            {
+                prefix = weechat_strndup (string, pos - string);
+                if (prefix)
+                {
+                    weechat_hashtable_set (context->extra_vars,
+                                           "tg_prefix", prefix);
+                    free (prefix);
+                }
+            }
+            pos++;
+            if (pos[0] == '\t')
+                pos++;
+            weechat_hashtable_set (context->extra_vars, "tg_message", pos);
+        }
+        else
+            weechat_hashtable_set (context->extra_vars, "tg_message", string);
+
+        /*
+         * extract buffer/tags from modifier data
+         * (format: "plugin;buffer_name;tags")
+         */
+        pos = strchr (modifier_data, ';');
+        if (pos)
+        {
+            plugin_name = weechat_strndup (modifier_data, pos - modifier_data);
+            if (plugin_name)
+            {
+                weechat_hashtable_set (context->extra_vars,
+                                       "tg_plugin", plugin_name);
+                pos++;
+                pos2 = strchr (pos, ';');
+                if (pos2)
+                {
+                    buffer_name = weechat_strndup (pos, pos2 - pos);
+                    if (buffer_name)
+                    {
+                        buffer = weechat_buffer_search (plugin_name,
+                                                        buffer_name);
+                        length = strlen (plugin_name) + 1 + strlen (buffer_name) + 1;
+                        buffer_full_name = malloc (length);
+                        if (buffer_full_name)
+                        {
+                            snprintf (buffer_full_name, length,
+                                      "%s.%s", plugin_name, buffer_name);
+                            weechat_hashtable_set (context->extra_vars,
+                                                   "tg_buffer",
+                                                   buffer_full_name);
+                            free (buffer_full_name);
+                        }
+                        free (buffer_name);
+                    }
+                    pos2++;
+                    if (pos2[0])
+                    {
+                        tags = weechat_string_split (
+                            pos2,
+                            ",",
+                            NULL,
+                            WEECHAT_STRING_SPLIT_STRIP_LEFT
+                            | WEECHAT_STRING_SPLIT_STRIP_RIGHT
+                            | WEECHAT_STRING_SPLIT_COLLAPSE_SEPS,
+                            0,
+                            &num_tags);
+                        length = 1 + strlen (pos2) + 1 + 1;
+                        str_tags = malloc (length);
+                        if (str_tags)
+                        {
+                            snprintf (str_tags, length, ",%s,", pos2);
+                            weechat_hashtable_set (context->extra_vars,
+                                                   "tg_tags", str_tags);
+                            free (str_tags);
+                        }
+                    }
+                }
+                free (plugin_name);
+            }
+        }
+        weechat_hashtable_set (context->pointers, "buffer", buffer);
+    }
+
+    if (tags)
+    {
+        if (!trigger_callback_set_tags (buffer, (const char **)tags, num_tags,
+                                        context->extra_vars))
+        {
+            context->no_trigger = 1;
+        }
+        weechat_string_free_split (tags);
+    }
+
+    return context;
+}
+
+/*
+ * Gets context shared by triggers for a line.
+ *
+ * Returns pointer to context, NULL if error.
+ */
+
+struct t_trigger_context *
+trigger_callback_context_line (struct t_hashtable *line)
+{
+    struct t_trigger_context *context;
+    struct t_gui_buffer *buffer;
+    const char *keys[TRIGGER_CONTEXT_NUM_KEYS], *ptr_value;
+    char **tags, *str_tags;
+    unsigned long value;
+    int rc, num_tags, length;
+
+    /* all variables of line are part of the event */
+    keys[0] = weechat_hashtable_get_string (line, "keys_values");
+    keys[1] = NULL;
+    keys[2] = NULL;
+    keys[3] = NULL;
+
+    if (trigger_callback_context_match (TRIGGER_HOOK_LINE, keys))
+        return &trigger_callback_context;
+
+    ptr_value = weechat_hashtable_get (line, "buffer");
+    if (!ptr_value || (ptr_value[0] != '0') || (ptr_value[1] != 'x'))
+        return NULL;
+    rc = sscanf (ptr_value + 2, "%lx", &value);
+    if ((rc == EOF) || (rc < 1))
+        return NULL;
+    buffer = (void *)value;
+
+    context = trigger_callback_context_new (TRIGGER_HOOK_LINE, keys);
+    if (!context)
+        return NULL;
+
+    weechat_hashtable_free (context->extra_vars);
+    context->extra_vars = weechat_hashtable_dup (line);
+    if (!context->extra_vars)
+    {
+        trigger_callback_context_reset ();
+        return NULL;
+    }
+
+    weechat_hashtable_remove (context->extra_vars, "buffer");
+    weechat_hashtable_remove (context->extra_vars, "tags_count");
+    weechat_hashtable_remove (context->extra_vars, "tags");
+
+    /* add data in hashtables used for conditions/replace/command */
+    weechat_hashtable_set (context->pointers, "buffer", buffer);
+    ptr_value = weechat_hashtable_get (line, "tags");
+    tags = weechat_string_split ((ptr_value) ? ptr_value : "",
+                                 ",",
+                                 NULL,
+                                 WEECHAT_STRING_SPLIT_STRIP_LEFT
+                                 | WEECHAT_STRING_SPLIT_STRIP_RIGHT
+                                 | WEECHAT_STRING_SPLIT_COLLAPSE_SEPS,
+                                 0,
+                                 &num_tags);
+
+    /* build string with tags and commas around: ",tag1,tag2,tag3," */
+    length = 1 + strlen ((ptr_value) ? ptr_value : "") + 1 + 1;
+    str_tags = malloc (length);
+    if (str_tags)
+    {
+        snprintf (str_tags, length, ",%s,",
+                  (ptr_value) ? ptr_value : "");
+        weechat_hashtable_set (context->extra_vars, "tags", str_tags);
+        free (str_tags);
+    }
+
+    if (!trigger_callback_set_tags (buffer, (const char **)tags, num_tags,
+                                    context->extra_vars))
+    {
+        context->no_trigger = 1;
+    }
+
+    if (tags)
+        weechat_string_free_split (tags);
+
+    return context;
+}
+
+/*
+ * Gets context shared by triggers for a print.
+ *
+ * Returns pointer to context, NULL if error.
+ */
+
+struct t_trigger_context *
+trigger_callback_context_print (struct t_gui_buffer *buffer, time_t date,
+                                int tags_count, const char **tags,
+                                int displayed, int highlight,
+                                const char *prefix, const char *message)
+{
+    struct t_trigger_context *context;
+    const char *keys[TRIGGER_CONTEXT_NUM_KEYS];
+    char *str_tags, *str_tags2, str_temp[128];
+    int length;
+    struct tm *date_tmp;
+
+    context = &trigger_callback_context;
+
+    if ((context->hook_type == TRIGGER_HOOK_PRINT)
+        && (context->buffer == buffer)
+        && (context->date == date)
+        && (context->displayed == displayed)
+        && (context->highlight == highlight)
+        && (context->tags_count == tags_count)
+        && trigger_callback_context_string_equal (context->keys[0], prefix)
+        && trigger_callback_context_string_equal (context->keys[1], message)
+        && trigger_callback_context_match_tags (context->keys[2],
+                                                tags_count, tags))
+    {
+        return context;
+    }
+
+    str_tags = weechat_string_build_with_split_string (tags, ",");
+
+    keys[0] = prefix;
+    keys[1] = message;
+    keys[2] = str_tags;
+    keys[3] = NULL;
+
+    context = trigger_callback_context_new (TRIGGER_HOOK_PRINT, keys);
+    if (!context)
+    {
+        if (str_tags)
+            free (str_tags);
+        return NULL;
+    }
+
+    context->buffer = buffer;
+    context->date = date;
+    context->displayed = displayed;
+    context->highlight = highlight;
+    context->tags_count = tags_count;
+
+    /* add data in hashtables used for conditions/replace/command */
+    weechat_hashtable_set (context->pointers, "buffer", buffer);
+    date_tmp = localtime (&date);
+    if (date_tmp)
+    {
+        if (strftime (str_temp, sizeof (str_temp),
+                      "%Y-%m-%d %H:%M:%S", date_tmp) == 0)
+            str_temp[0] = '\0';
+        weechat_hashtable_set (context->extra_vars, "tg_date", str_temp);
+    }
+    snprintf (str_temp, sizeof (str_temp), "%d", displayed);
+    weechat_hashtable_set (context->extra_vars, "tg_displayed", str_temp);
+    snprintf (str_temp, sizeof (str_temp), "%d", highlight);
+    weechat_hashtable_set (context->extra_vars, "tg_highlight", str_temp);
+    weechat_hashtable_set (context->extra_vars, "tg_prefix", prefix);
+    weechat_hashtable_set (context->extra_vars, "tg_message", message);
+
+    if (str_tags)
+    {
+        /* build string with tags and commas around: ",tag1,tag2,tag3," */
+        length = 1 + strlen (str_tags) + 1 + 1;
+        str_tags2 = malloc (length);
+        if (str_tags2)
+        {
+            snprintf (str_tags2, length, ",%s,", str_tags);
+            weechat_hashtable_set (context->extra_vars, "tg_tags", str_tags2);
+            free (str_tags2);
         }
+        free (str_tags);
+    }
+    if (!trigger_callback_set_tags (buffer, tags, tags_count,
+                                    context->extra_vars))
+    {
+        context->no_trigger = 1;
     }
 
-    return 1;
+    return context;
 }
 
 /*
@@ -434,6 +1147,7 @@ trigger_callback_signal_cb (const void *pointer, void *data,
                             const char *signal, const char *type_data,
                             void *signal_data)
 {
+    struct t_trigger_context *context;
     const char *ptr_signal_data;
     char str_data[128], *irc_server_name;
     const char *pos, *ptr_irc_message;
@@ -476,11 +1190,12 @@ trigger_callback_signal_cb (const void *pointer, void *data,
     }
     if (irc_server_name && ptr_irc_message)
     {
-        extra_vars = trigger_callback_irc_message_parse (ptr_irc_message,
-                                                         irc_server_name);
+        context = trigger_callback_context_irc_message (irc_server_name,
+                                                        ptr_irc_message);
+        extra_vars = (context) ?
+            weechat_hashtable_dup (context->extra_vars) : NULL;
         if (extra_vars)
         {
-            weechat_hashtable_set (extra_vars, "server", irc_server_name);
             trigger_callback_get_irc_server_channel (
                 irc_server_name,
                 weechat_hashtable_get (extra_vars, "channel"),
@@ -592,195 +1307,46 @@ trigger_callback_modifier_cb (const void *pointer, void *data,
                               const char *modifier, const char *modifier_data,
                               const char *string)
 {
+    struct t_trigger_context *context;
     struct t_gui_buffer *buffer;
     const char *ptr_string;
-    char *string_modified, *pos, *pos2, *plugin_name, *buffer_name;
-    char *buffer_full_name, *str_tags, **tags, *prefix, *string_no_color;
-    int length, num_tags;
+    char *string_modified;
     void *ptr_irc_server, *ptr_irc_channel;
 
     TRIGGER_CALLBACK_CB_INIT(NULL);
 
-    buffer = NULL;
-    tags = NULL;
-    num_tags = 0;
-    string_no_color = NULL;
-
-    TRIGGER_CALLBACK_CB_NEW_POINTERS;
-
-    /* split IRC message (if string is an IRC message) */
-    if ((strncmp (modifier, "irc_in_", 7) == 0)
-        || (strncmp (modifier, "irc_in2_", 8) == 0)
-        || (strncmp (modifier, "irc_out1_", 9) == 0)
-        || (strncmp (modifier, "irc_out_", 8) == 0))
-    {
-        extra_vars = trigger_callback_irc_message_parse (string,
-                                                         modifier_data);
-        if (extra_vars)
-        {
-            weechat_hashtable_set (extra_vars, "server", modifier_data);
-            trigger_callback_get_irc_server_channel (
-                modifier_data,
-                weechat_hashtable_get (extra_vars, "channel"),
-                &ptr_irc_server,
-                &ptr_irc_channel);
-            weechat_hashtable_set (pointers, "irc_server", ptr_irc_server);
-            weechat_hashtable_set (pointers, "irc_channel", ptr_irc_channel);
-        }
-    }
-
-    if (!extra_vars)
-    {
-        TRIGGER_CALLBACK_CB_NEW_EXTRA_VARS;
-    }
-
-    /* add data in hashtable used for conditions/replace/command */
-    weechat_hashtable_set (extra_vars, "tg_modifier", modifier);
-    weechat_hashtable_set (extra_vars, "tg_modifier_data", modifier_data);
-    weechat_hashtable_set (extra_vars, "tg_string", string);
-    string_no_color = weechat_string_remove_color (string, NULL);
-    if (string_no_color)
-    {
-        weechat_hashtable_set (extra_vars,
-                               "tg_string_nocolor", string_no_color);
-    }
-
-    /* add special variables for a WeeChat message */
-    if (strcmp (modifier, "weechat_print") == 0)
-    {
-        /* set "tg_prefix" and "tg_message" */
-        pos = strchr (string, '\t');
-        if (pos)
-        {
-            if (pos > string)
-            {
-                prefix = weechat_strndup (string, pos - string);
-                if (prefix)
-                {
-                    weechat_hashtable_set (extra_vars, "tg_prefix", prefix);
-                    free (prefix);
-                }
-            }
-            pos++;
-            if (pos[0] == '\t')
-                pos++;
-            weechat_hashtable_set (extra_vars, "tg_message", pos);
-        }
-        else
-            weechat_hashtable_set (extra_vars, "tg_message", string);
-
-        /* set "tg_prefix_nocolor" and "tg_message_nocolor" */
-        if (string_no_color)
-        {
-            pos = strchr (string_no_color, '\t');
-            if (pos)
-            {
-                if (pos > string_no_color)
-                {
-                    prefix = weechat_strndup (string_no_color,
-                                              pos - string_no_color);
-                    if (prefix)
-                    {
-                        weechat_hashtable_set (extra_vars,
-                                               "tg_prefix_nocolor", prefix);
-                        free (prefix);
-                    }
-                }
-                pos++;
-                if (pos[0] == '\t')
-                    pos++;
-                weechat_hashtable_set (extra_vars, "tg_message_nocolor", pos);
-            }
-            else
-            {
-                weechat_hashtable_set (extra_vars,
-                                       "tg_message_nocolor", string_no_color);
-            }
-        }
+    /* get variables (built once for all triggers using this modifier) */
+    context = trigger_callback_context_modifier (modifier, modifier_data,
+                                                 string);
+    if (!context || context->no_trigger)
+        goto end;
+    if (!trigger_callback_context_get_vars (context, trigger,
+                                            &pointers, &extra_vars))
+        goto end;
 
-        /*
-         * extract buffer/tags from modifier data
-         * (format: "plugin;buffer_name;tags")
-         */
-        pos = strchr (modifier_data, ';');
-        if (pos)
-        {
-            plugin_name = weechat_strndup (modifier_data, pos - modifier_data);
-            if (plugin_name)
-            {
-                weechat_hashtable_set (extra_vars, "tg_plugin", plugin_name);
-                pos++;
-                pos2 = strchr (pos, ';');
-                if (pos2)
-                {
-                    buffer_name = weechat_strndup (pos, pos2 - pos);
-                    if (buffer_name)
-                    {
-                        buffer = weechat_buffer_search (plugin_name,
-                                                        buffer_name);
-                        length = strlen (plugin_name) + 1 + strlen (buffer_name) + 1;
-                        buffer_full_name = malloc (length);
-                        if (buffer_full_name)
-                        {
-                            snprintf (buffer_full_name, length,
-                                      "%s.%s", plugin_name, buffer_name);
-                            weechat_hashtable_set (extra_vars, "tg_buffer",
-                                                   buffer_full_name);
-                            free (buffer_full_name);
-                        }
-                        free (buffer_name);
-                    }
-                    pos2++;
-                    if (pos2[0])
-                    {
-                        tags = weechat_string_split (
-                            pos2,
-                            ",",
-                            NULL,
-                            WEECHAT_STRING_SPLIT_STRIP_LEFT
-                            | WEECHAT_STRING_SPLIT_STRIP_RIGHT
-                            | WEECHAT_STRING_SPLIT_COLLAPSE_SEPS,
-                            0,
-                            &num_tags);
-                        length = 1 + strlen (pos2) + 1 + 1;
-                        str_tags = malloc (length);
-                        if (str_tags)
-                        {
-                            snprintf (str_tags, length, ",%s,", pos2);
-                            weechat_hashtable_set (extra_vars, "tg_tags",
-                                                   str_tags);
-                            free (str_tags);
-                        }
-                    }
-                }
-                free (plugin_name);
-            }
-        }
-        weechat_hashtable_set (pointers, "buffer", buffer);
-    }
+    buffer = weechat_hashtable_get (pointers, "buffer");
 
-    if (tags)
+    /* search IRC server/channel (if string is an IRC message) */
+    if (context->irc_message)
     {
-        if (!trigger_callback_set_tags (buffer, (const char **)tags, num_tags,
-                                        extra_vars))
-        {
-            goto end;
-        }
+        trigger_callback_get_irc_server_channel (
+            modifier_data,
+            weechat_hashtable_get (extra_vars, "channel"),
+            &ptr_irc_server,
+            &ptr_irc_channel);
+        weechat_hashtable_set (pointers, "irc_server", ptr_irc_server);
+        weechat_hashtable_set (pointers, "irc_channel", ptr_irc_channel);
     }
 
     /* execute the trigger (conditions, regex, command) */
     trigger_callback_execute (trigger, buffer, pointers, extra_vars, NULL);
 
 end:
-    ptr_string = weechat_hashtable_get (extra_vars, "tg_string");
+    ptr_string = (extra_vars) ?
+        weechat_hashtable_get (extra_vars, "tg_string") : NULL;
     string_modified = (ptr_string && (strcmp (ptr_string, string) != 0)) ?
         strdup (ptr_string) : NULL;
 
-    if (tags)
-        weechat_string_free_split (tags);
-    if (string_no_color)
-        free (string_no_color);
-
     TRIGGER_CALLBACK_CB_END(string_modified);
 }
 
@@ -792,78 +1358,28 @@ struct t_hashtable *
 trigger_callback_line_cb (const void *pointer, void *data,
                           struct t_hashtable *line)
 {
+    struct t_trigger_context *context;
     struct t_hashtable *hashtable;
     struct t_gui_buffer *buffer;
     struct t_weelist_item *ptr_item;
-    unsigned long value;
     const char *ptr_key, *ptr_value;
-    char **tags, *str_tags, *string_no_color;
-    int rc, num_tags, length;
+    char *str_tags;
 
     TRIGGER_CALLBACK_CB_INIT(NULL);
 
     hashtable = NULL;
-    tags = NULL;
 
-    TRIGGER_CALLBACK_CB_NEW_POINTERS;
     TRIGGER_CALLBACK_CB_NEW_VARS_UPDATED;
 
-    extra_vars = weechat_hashtable_dup (line);
-
-    weechat_hashtable_remove (extra_vars, "buffer");
-    weechat_hashtable_remove (extra_vars, "tags_count");
-    weechat_hashtable_remove (extra_vars, "tags");
-
-    /* add data in hashtables used for conditions/replace/command */
-    ptr_value = weechat_hashtable_get (line, "buffer");
-    if (!ptr_value || (ptr_value[0] != '0') || (ptr_value[1] != 'x'))
+    /* get variables (built once for all triggers receiving this line) */
+    context = trigger_callback_context_line (line);
+    if (!context || context->no_trigger)
         goto end;
-    rc = sscanf (ptr_value + 2, "%lx", &value);
-    if ((rc == EOF) || (rc < 1))
+    if (!trigger_callback_context_get_vars (context, trigger,
+                                            &pointers, &extra_vars))
         goto end;
-    buffer = (void *)value;
-
-    weechat_hashtable_set (pointers, "buffer", buffer);
-    ptr_value = weechat_hashtable_get (line, "tags");
-    tags = weechat_string_split ((ptr_value) ? ptr_value : "",
-                                 ",",
-                                 NULL,
-                                 WEECHAT_STRING_SPLIT_STRIP_LEFT
-                                 | WEECHAT_STRING_SPLIT_STRIP_RIGHT
-                                 | WEECHAT_STRING_SPLIT_COLLAPSE_SEPS,
-                                 0,
-                                 &num_tags);
-
-    /* build string with tags and commas around: ",tag1,tag2,tag3," */
-    length = 1 + strlen ((ptr_value) ? ptr_value : "") + 1 + 1;
-    str_tags = malloc (length);
-    if (str_tags)
-    {
-        snprintf (str_tags, length, ",%s,",
-                  (ptr_value) ? ptr_value : "");
-        weechat_hashtable_set (extra_vars, "tags", str_tags);
-        free (str_tags);
-    }
-
-    /* build prefix without colors */
-    ptr_value = weechat_hashtable_get (line, "prefix");
-    string_no_color = weechat_string_remove_color (ptr_value, NULL);
-    weechat_hashtable_set (extra_vars, "tg_prefix_nocolor", string_no_color);
-    if (string_no_color)
-        free (string_no_color);
-
-    /* build message without colors */
-    ptr_value = weechat_hashtable_get (line, "message");
-    string_no_color = weechat_string_remove_color (ptr_value, NULL);
-    weechat_hashtable_set (extra_vars, "tg_message_nocolor", string_no_color);
-    if (string_no_color)
-        free (string_no_color);
 
-    if (!trigger_callback_set_tags (buffer, (const char **)tags, num_tags,
-                                    extra_vars))
-    {
-        goto end;
-    }
+    buffer = weechat_hashtable_get (pointers, "buffer");
 
     /* execute the trigger (conditions, regex, command) */
     trigger_callback_execute (trigger, buffer, pointers, extra_vars,
@@ -919,9 +1435,6 @@ trigger_callback_line_cb (const void *pointer, void *data,
     }
 
 end:
-    if (tags)
-        weechat_string_free_split (tags);
-
     TRIGGER_CALLBACK_CB_END(hashtable);
 }
 
@@ -936,9 +1449,7 @@ trigger_callback_print_cb  (const void *pointer, void *data,
                             int displayed, int highlight, const char *prefix,
                             const char *message)
 {
-    char *str_tags, *str_tags2, str_temp[128], *str_no_color;
-    int length;
-    struct tm *date_tmp;
+    struct t_trigger_context *context;
 
     TRIGGER_CALLBACK_CB_INIT(WEECHAT_RC_OK);
 
@@ -947,53 +1458,14 @@ trigger_callback_print_cb  (const void *pointer, void *data,
         && !weechat_buffer_match_list (buffer, trigger->hook_print_buffers))
         goto end;
 
-    TRIGGER_CALLBACK_CB_NEW_POINTERS;
-    TRIGGER_CALLBACK_CB_NEW_EXTRA_VARS;
-
-    /* add data in hashtables used for conditions/replace/command */
-    weechat_hashtable_set (pointers, "buffer", buffer);
-    date_tmp = localtime (&date);
-    if (date_tmp)
-    {
-        if (strftime (str_temp, sizeof (str_temp),
-                      "%Y-%m-%d %H:%M:%S", date_tmp) == 0)
-            str_temp[0] = '\0';
-        weechat_hashtable_set (extra_vars, "tg_date", str_temp);
-    }
-    snprintf (str_temp, sizeof (str_temp), "%d", displayed);
-    weechat_hashtable_set (extra_vars, "tg_displayed", str_temp);
-    snprintf (str_temp, sizeof (str_temp), "%d", highlight);
-    weechat_hashtable_set (extra_vars, "tg_highlight", str_temp);
-    weechat_hashtable_set (extra_vars, "tg_prefix", prefix);
-    str_no_color = weechat_string_remove_color (prefix, NULL);
-    if (str_no_color)
-    {
-        weechat_hashtable_set (extra_vars, "tg_prefix_nocolor", str_no_color);
-        free (str_no_color);
-    }
-    weechat_hashtable_set (extra_vars, "tg_message", message);
-    str_no_color = weechat_string_remove_color (message, NULL);
-    if (str_no_color)
-    {
-        weechat_hashtable_set (extra_vars, "tg_message_nocolor", str_no_color);
-        free (str_no_color);
-    }
-
-    str_tags = weechat_string_build_with_split_string (tags, ",");
-    if (str_tags)
-    {
-        /* build string with tags and commas around: ",tag1,tag2,tag3," */
-        length = 1 + strlen (str_tags) + 1 + 1;
-        str_tags2 = malloc (length);
-        if (str_tags2)
-        {
-            snprintf (str_tags2, length, ",%s,", str_tags);
-            weechat_hashtable_set (extra_vars, "tg_tags", str_tags2);
-            free (str_tags2);
-        }
-        free (str_tags);
-    }
-    if (!trigger_callback_set_tags (buffer, tags, tags_count, extra_vars))
+    /* get variables (built once for all triggers receiving this message) */
+    context = trigger_callback_context_print (buffer, date, tags_count, tags,
+                                              displayed, highlight,
+                                              prefix, message);
+    if (!context || context->no_trigger)
+        goto end;
+    if (!trigger_callback_context_get_vars (context, trigger,
+                                            &pointers, &extra_vars))
         goto end;
 
     /* execute the trigger (conditions, regex, command) */
@@ -1258,6 +1730,28 @@ end:
     TRIGGER_CALLBACK_CB_END(ret_hashtable);
 }
 
+/*
+ * Callback for signal "buffer_closed": resets the context shared by triggers
+ * (it may contain a pointer to the buffer closed).
+ */
+
+int
+trigger_callback_buffer_closed_cb (const void *pointer, void *data,
+                                   const char *signal,
+                                   const char *type_data, void *signal_data)
+{
+    /* make C compiler happy */
+    (void) pointer;
+    (void) data;
+    (void) signal;
+    (void) type_data;
+    (void) signal_data;
+
+    trigger_callback_context_reset ();
+
+    return WEECHAT_RC_OK;
+}
+
 /*
  * Initializes trigger callback.
  */
@@ -1281,6 +1775,10 @@ trigger_callback_init ()
         WEECHAT_HASHTABLE_STRING,
         WEECHAT_HASHTABLE_STRING,
         NULL, NULL);
+
+    trigger_callback_context_reset ();
+    weechat_hook_signal ("buffer_closed",
+                         &trigger_callback_buffer_closed_cb, NULL, NULL);
 }
 
 /*
@@ -1294,4 +1792,6 @@ trigger_callback_end ()
         weechat_hashtable_free (trigger_callback_hashtable_options_conditions);
     if (trigger_callback_hashtable_options_regex)
         weechat_hashtable_free (trigger_callback_hashtable_options_regex);
+
+    trigger_callback_context_reset ();
 }
@@ -22,6 +22,8 @@
 
 #include <time.h>
 
+#define TRIGGER_CONTEXT_NUM_KEYS 4
+
 #define TRIGGER_CALLBACK_CB_INIT(__rc)                          \
     struct t_trigger *trigger;                                  \
     struct t_hashtable *pointers, *extra_vars;                  \
@@ -92,6 +94,28 @@
     }                                                           \
     return __rc;
 
+/*
+ * context of the event being processed: it is built by the first trigger
+ * called for an event and then shared by all triggers receiving the same
+ * event (the variables are duplicated for each trigger before execution)
+ */
+
+struct t_trigger_context
+{
+    int hook_type;                     /* hook type (TRIGGER_HOOK_xxx)      */
+    struct t_gui_buffer *buffer;       /* buffer (print)                    */
+    time_t date;                       /* date (print)                      */
+    int displayed;                     /* line displayed? (print)           */
+    int highlight;                     /* line with highlight? (print)      */
+    int tags_count;                    /* number of tags (print)            */
+    char *keys[TRIGGER_CONTEXT_NUM_KEYS]; /* strings identifying the event  */
+    struct t_hashtable *pointers;      /* pointers shared by triggers       */
+    struct t_hashtable *extra_vars;    /* extra vars shared by triggers     */
+    int irc_message;                   /* 1 if an IRC message was parsed    */
+    int no_trigger;                    /* 1 if tag "no_trigger" found       */
+    int nocolor;                       /* 1 if vars "*_nocolor" are set     */
+};
+
 extern int trigger_callback_signal_cb (const void *pointer, void *data,
                                        const char *signal,
                                        const char *type_data,
@@ -41,6 +41,7 @@ struct t_config_section;
 struct t_config_file;
 struct t_gui_window;
 struct t_gui_buffer;
+struct t_gui_lines_export;
 struct t_gui_bar;
 struct t_gui_bar_item;
 struct t_gui_bar_window;
@@ -67,7 +68,7 @@ struct timeval;
  * please change the date with current one; for a second change at same
  * date, increment the 01, otherwise please keep 01.
  */
-#define WEECHAT_PLUGIN_API_VERSION "20200301-03"
+#define WEECHAT_PLUGIN_API_VERSION "20200301-05"
 
 /* macros for defining plugin infos */
 #define WEECHAT_PLUGIN_NAME(__name)                                     \
@@ -866,6 +867,15 @@ struct t_weechat_plugin
                                   void *callback_data);
     void (*hook_set) (struct t_hook *hook, const char *property,
                       const char *value);
+    int (*hook_batch) (struct t_weechat_plugin *plugin,
+                       struct t_hook *hook,
+                       int max_size,
+                       int max_latency,
+                       int (*callback)(const void *pointer,
+                                       void *data,
+                                       struct t_infolist *events),
+                       const void *callback_pointer,
+                       void *callback_data);
     void (*unhook) (struct t_hook *hook);
     void (*unhook_all) (struct t_weechat_plugin *plugin,
                         const char *subplugin);
@@ -904,6 +914,13 @@ struct t_weechat_plugin
     char *(*buffer_string_replace_local_var) (struct t_gui_buffer *buffer,
                                               const char *string);
     int (*buffer_match_list) (struct t_gui_buffer *buffer, const char *string);
+    struct t_gui_lines_export *(*buffer_lines_export) (struct t_gui_buffer *buffer,
+                                                       long id_min,
+                                                       time_t date_min,
+                                                       int max_lines);
+    void *(*buffer_lines_export_get) (struct t_gui_lines_export *lines_export,
+                                      const char *column, int *count);
+    void (*buffer_lines_export_free) (struct t_gui_lines_export *lines_export);
 
     /* windows */
     struct t_gui_window *(*window_search_with_buffer) (struct t_gui_buffer *buffer);
@@ -1782,6 +1799,11 @@ extern int weechat_plugin_end (struct t_weechat_plugin *plugin);
                                  __pointer, __data)
 #define weechat_hook_set(__hook, __property, __value)                   \
     (weechat_plugin->hook_set)(__hook, __property, __value)
+#define weechat_hook_batch(__hook, __max_size, __max_latency,           \
+                           __callback, __pointer, __data)               \
+    (weechat_plugin->hook_batch)(weechat_plugin, __hook, __max_size,    \
+                                 __max_latency, __callback, __pointer,  \
+                                 __data)
 #define weechat_unhook(__hook)                                          \
     (weechat_plugin->unhook)( __hook)
 #define weechat_unhook_all(__subplugin)                                 \
@@ -1831,6 +1853,16 @@ extern int weechat_plugin_end (struct t_weechat_plugin *plugin);
                                                       __string)
 #define weechat_buffer_match_list(__buffer, __string)                   \
     (weechat_plugin->buffer_match_list)(__buffer, __string)
+#define weechat_buffer_lines_export(__buffer, __id_min, __date_min,     \
+                                    __max_lines)                        \
+    (weechat_plugin->buffer_lines_export)(__buffer, __id_min,           \
+                                          __date_min, __max_lines)
+#define weechat_buffer_lines_export_get(__lines_export, __column,       \
+                                        __count)                        \
+    (weechat_plugin->buffer_lines_export_get)(__lines_export, __column, \
+                                              __count)
+#define weechat_buffer_lines_export_free(__lines_export)                \
+    (weechat_plugin->buffer_lines_export_free)(__lines_export)
 
 /* windows */
 #define weechat_window_search_with_buffer(__buffer)                     \
@@ -19,6 +19,10 @@
  * along with WeeChat.  If not, see <https://www.gnu.org/licenses/>.
  */
 
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
 #include <stdlib.h>
 #include <unistd.h>
 #include <stdio.h>
@@ -26,6 +30,10 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/socket.h>
+#include <sys/time.h>
+#ifdef HAVE_SYS_SENDFILE_H
+#include <sys/sendfile.h>
+#endif
 #include <poll.h>
 #include <netinet/in.h>
 #include <netinet/tcp.h>
@@ -38,10 +46,176 @@
 #include "../weechat-plugin.h"
 #include "xfer.h"
 #include "xfer-config.h"
+#include "xfer-dcc.h"
 #include "xfer-file.h"
 #include "xfer-network.h"
 
 
+/*
+ * Initializes a rate limit (token bucket).
+ *
+ * Argument "rate" is the max number of bytes per second (0 = no limit) and
+ * "burst" is the max number of bytes available at once.
+ */
+
+void
+xfer_dcc_rate_limit_init (struct t_xfer_dcc_rate_limit *rate_limit,
+                          unsigned long long rate,
+                          unsigned long long burst)
+{
+    if (!rate_limit)
+        return;
+
+    rate_limit->rate = rate;
+    rate_limit->burst = (burst > 0) ? burst : 1;
+    rate_limit->tokens = rate_limit->burst;
+    gettimeofday (&rate_limit->last_refill, NULL);
+}
+
+/*
+ * Adds tokens in a rate limit, according to time elapsed since last refill.
+ */
+
+void
+xfer_dcc_rate_limit_refill (struct t_xfer_dcc_rate_limit *rate_limit)
+{
+    struct timeval now;
+    long long diff;
+    unsigned long long new_tokens;
+
+    gettimeofday (&now, NULL);
+    diff = weechat_util_timeval_diff (&rate_limit->last_refill, &now);
+    if (diff < 0)
+    {
+        /* system clock has changed: restart from now */
+        rate_limit->last_refill = now;
+        return;
+    }
+
+    /* burst is <= rate, so after one second the bucket is always full */
+    if (diff >= 1000000)
+        new_tokens = rate_limit->burst;
+    else
+        new_tokens = (rate_limit->rate * (unsigned long long)diff) / 1000000;
+
+    /* keep last refill time if less than one byte was added */
+    if (new_tokens == 0)
+        return;
+
+    rate_limit->tokens += new_tokens;
+    if (rate_limit->tokens > rate_limit->burst)
+        rate_limit->tokens = rate_limit->burst;
+    rate_limit->last_refill = now;
+}
+
+/*
+ * Gets number of bytes that can be sent/received now (at most "max").
+ *
+ * Returns number of bytes allowed (>= 0), "max" if there is no limit.
+ */
+
+unsigned long long
+xfer_dcc_rate_limit_get (struct t_xfer_dcc_rate_limit *rate_limit,
+                         unsigned long long max)
+{
+    if (!rate_limit || (rate_limit->rate == 0))
+        return max;
+
+    xfer_dcc_rate_limit_refill (rate_limit);
+
+    return (rate_limit->tokens < max) ? rate_limit->tokens : max;
+}
+
+/*
+ * Uses bytes in a rate limit (after bytes have been sent/received).
+ */
+
+void
+xfer_dcc_rate_limit_use (struct t_xfer_dcc_rate_limit *rate_limit,
+                         unsigned long long bytes)
+{
+    if (!rate_limit || (rate_limit->rate == 0))
+        return;
+
+    rate_limit->tokens = (bytes < rate_limit->tokens) ?
+        rate_limit->tokens - bytes : 0;
+}
+
+/*
+ * Gets delay to wait before "bytes" bytes can be sent/received (this number
+ * is limited to the burst of rate limit).
+ *
+ * Returns delay in milliseconds, 0 if bytes can be sent/received now.
+ */
+
+int
+xfer_dcc_rate_limit_delay (struct t_xfer_dcc_rate_limit *rate_limit,
+                           unsigned long long bytes)
+{
+    unsigned long long delay;
+
+    if (!rate_limit || (rate_limit->rate == 0))
+        return 0;
+
+    if (bytes > rate_limit->burst)
+        bytes = rate_limit->burst;
+
+    xfer_dcc_rate_limit_refill (rate_limit);
+
+    if (rate_limit->tokens >= bytes)
+        return 0;
+
+    delay = (((bytes - rate_limit->tokens) * 1000) + rate_limit->rate - 1)
+        / rate_limit->rate;
+
+    return (delay > 0) ? (int)delay : 1;
+}
+
+/*
+ * Sends a block of file to receiver.
+ *
+ * If sendfile() is available, the block is sent from file to socket without
+ * copy in user space; if sendfile() is not supported for this file/socket,
+ * *use_sendfile is set to 0 and read/send are used.
+ *
+ * Returns number of bytes sent, -1 if error on socket (errno is set),
+ * -2 if error when reading file.
+ */
+
+int
+xfer_dcc_send_file_block (struct t_xfer *xfer, char *buffer,
+                          unsigned long long size, int *use_sendfile)
+{
+    int num_read;
+#ifdef HAVE_SYS_SENDFILE_H
+    off_t offset;
+    ssize_t num_sent;
+
+    if (*use_sendfile)
+    {
+        offset = (off_t)(xfer->pos);
+        num_sent = sendfile (xfer->sock, xfer->file, &offset, size);
+        if (num_sent > 0)
+            return (int)num_sent;
+        if (num_sent == 0)
+            return -2;
+        if ((errno != EINVAL) && (errno != ENOSYS))
+            return -1;
+        /* sendfile not supported for this file/socket: use read/send */
+        *use_sendfile = 0;
+    }
+#else
+    /* make C compiler happy */
+    (void) use_sendfile;
+#endif /* HAVE_SYS_SENDFILE_H */
+
+    lseek (xfer->file, xfer->pos, SEEK_SET);
+    num_read = read (xfer->file, buffer, size);
+    if (num_read < 1)
+        return -2;
+    return send (xfer->sock, buffer, num_read, 0);
+}
+
 /*
  * Child process for sending file with DCC protocol.
  */
@@ -49,11 +223,13 @@
 void
 xfer_dcc_send_file_child (struct t_xfer *xfer)
 {
-    int num_read, num_sent;
+    int num_read, num_sent, use_sendfile, timeout;
     static char buffer[XFER_BLOCKSIZE_MAX];
     uint32_t ack;
-    time_t last_sent, new_time, last_second, sent_ok;
-    unsigned long long blocksize, speed_limit, sent_last_second;
+    time_t last_sent, new_time, sent_ok;
+    unsigned long long blocksize, speed_limit, size;
+    struct t_xfer_dcc_rate_limit rate_limit;
+    struct pollfd poll_fd;
 
     /* empty file? just return immediately */
     if (xfer->pos >= xfer->size)
@@ -70,10 +246,16 @@ xfer_dcc_send_file_child (struct t_xfer *xfer)
     if ((speed_limit > 0) && (blocksize > speed_limit * 1024))
         blocksize = speed_limit * 1024;
 
+    xfer_dcc_rate_limit_init (&rate_limit, speed_limit * 1024, blocksize);
+
+#ifdef HAVE_SYS_SENDFILE_H
+    use_sendfile = 1;
+#else
+    use_sendfile = 0;
+#endif /* HAVE_SYS_SENDFILE_H */
+
     last_sent = time (NULL);
-    last_second = last_sent;
     sent_ok = 0;
-    sent_last_second = 0;
     while (1)
     {
         /* read DCC ACK (sent by receiver) */
@@ -109,26 +291,35 @@ xfer_dcc_send_file_child (struct t_xfer *xfer)
             }
         }
 
+        /* by default wait for an ACK (or timeout) on socket */
+        poll_fd.fd = xfer->sock;
+        poll_fd.events = POLLIN;
+        poll_fd.revents = 0;
+        timeout = 1000;
+
         /* send a block to receiver */
         if ((xfer->pos < xfer->size) &&
              (xfer->fast_send || (xfer->pos <= xfer->ack)))
         {
-            if ((speed_limit > 0) && (sent_last_second >= speed_limit * 1024))
-            {
-                /* we're sending too fast (according to speed limit set by user) */
-                usleep (100);
-            }
-            else
+            size = xfer->size - xfer->pos;
+            if (size > blocksize)
+                size = blocksize;
+
+            /*
+             * if we're sending too fast (according to speed limit set by
+             * user), wait until the block can be sent
+             */
+            timeout = xfer_dcc_rate_limit_delay (&rate_limit, size);
+            if (timeout == 0)
             {
-                lseek (xfer->file, xfer->pos, SEEK_SET);
-                num_read = read (xfer->file, buffer, blocksize);
-                if (num_read < 1)
+                num_sent = xfer_dcc_send_file_block (xfer, buffer, size,
+                                                     &use_sendfile);
+                if (num_sent == -2)
                 {
                     xfer_network_write_pipe (xfer, XFER_STATUS_FAILED,
                                              XFER_ERROR_READ_LOCAL);
                     return;
                 }
-                num_sent = send (xfer->sock, buffer, num_read, 0);
                 if (num_sent < 0)
                 {
                     /*
@@ -136,7 +327,10 @@ xfer_dcc_send_file_child (struct t_xfer *xfer)
                      * receive amount of data we sent ?!)
                      */
                     if ((errno == EAGAIN) || (errno == EWOULDBLOCK))
-                        usleep (1000);
+                    {
+                        poll_fd.events |= POLLOUT;
+                        timeout = 1000;
+                    }
                     else
                     {
                         xfer_network_write_pipe (xfer, XFER_STATUS_FAILED,
@@ -147,7 +341,8 @@ xfer_dcc_send_file_child (struct t_xfer *xfer)
                 if (num_sent > 0)
                 {
                     xfer->pos += (unsigned long long) num_sent;
-                    sent_last_second += (unsigned long long) num_sent;
+                    xfer_dcc_rate_limit_use (&rate_limit,
+                                             (unsigned long long) num_sent);
                     new_time = time (NULL);
                     if ((last_sent != new_time)
                         || ((sent_ok == 0) && (xfer->pos >= xfer->size)))
@@ -161,20 +356,19 @@ xfer_dcc_send_file_child (struct t_xfer *xfer)
                 }
             }
         }
-        else
-            usleep (1000);
 
-        new_time = time (NULL);
-        if (new_time > last_second)
-        {
-            last_second = new_time;
-            sent_last_second = 0;
-        }
+        /*
+         * nothing sent: wait for an ACK, for the socket to be writable or
+         * for the rate limit to allow the next block
+         */
+        if (timeout > 0)
+            poll (&poll_fd, 1, timeout);
 
         /*
          * if send if OK since 2 seconds or more, and that no ACK was received,
          * then consider it's OK
          */
+        new_time = time (NULL);
         if ((sent_ok != 0) && (new_time > sent_ok + 2))
         {
             xfer_network_write_pipe (xfer, XFER_STATUS_DONE,
@@ -308,10 +502,11 @@ xfer_dcc_resume_hash (struct t_xfer *xfer)
 void
 xfer_dcc_recv_file_child (struct t_xfer *xfer)
 {
-    int flags, num_read, ready;
+    int flags, num_read, ready, delay;
     static char buffer[XFER_BLOCKSIZE_MAX];
-    time_t last_sent, last_second, new_time;
-    unsigned long long blocksize, pos_last_ack, speed_limit, recv_last_second;
+    time_t last_sent, new_time;
+    unsigned long long blocksize, pos_last_ack, speed_limit;
+    struct t_xfer_dcc_rate_limit rate_limit;
     struct pollfd poll_fd;
     ssize_t written, total_written;
     unsigned char *bin_hash;
@@ -366,9 +561,9 @@ xfer_dcc_recv_file_child (struct t_xfer *xfer)
         flags = 0;
     fcntl (xfer->sock, F_SETFL, flags | O_NONBLOCK);
 
+    xfer_dcc_rate_limit_init (&rate_limit, speed_limit * 1024, blocksize);
+
     last_sent = time (NULL);
-    last_second = last_sent;
-    recv_last_second = 0;
     pos_last_ack = 0;
 
     while (1)
@@ -393,13 +588,14 @@ xfer_dcc_recv_file_child (struct t_xfer *xfer)
         /* read maximum data on socket (until nothing is available) */
         while (1)
         {
-            if ((speed_limit > 0) && (recv_last_second >= speed_limit * 1024))
+            delay = xfer_dcc_rate_limit_delay (&rate_limit, blocksize);
+            if (delay > 0)
             {
                 /*
-                 * we're receiving too fast
-                 * (according to speed limit set by user)
+                 * we're receiving too fast (according to speed limit set by
+                 * user): wait until next block can be received
                  */
-                usleep (100);
+                usleep (delay * 1000);
             }
             else
             {
@@ -455,7 +651,8 @@ xfer_dcc_recv_file_child (struct t_xfer *xfer)
                     }
 
                     xfer->pos += (unsigned long long) num_read;
-                    recv_last_second += (unsigned long long) num_read;
+                    xfer_dcc_rate_limit_use (&rate_limit,
+                                             (unsigned long long) num_read);
 
                     /* file received OK? */
                     if (xfer->pos >= xfer->size)
@@ -513,13 +710,6 @@ xfer_dcc_recv_file_child (struct t_xfer *xfer)
                     }
                 }
             }
-
-            new_time = time (NULL);
-            if (new_time > last_second)
-            {
-                last_second = new_time;
-                recv_last_second = 0;
-            }
         }
 
         /* send ACK to sender (if needed) */
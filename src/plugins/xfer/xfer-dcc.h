@@ -20,6 +20,27 @@
 #ifndef WEECHAT_PLUGIN_XFER_DCC_H
 #define WEECHAT_PLUGIN_XFER_DCC_H
 
+#include <sys/time.h>
+
+/* rate limit for a DCC transfer (token bucket) */
+
+struct t_xfer_dcc_rate_limit
+{
+    unsigned long long rate;           /* max bytes per second (0 = no limit)*/
+    unsigned long long burst;          /* max bytes available at once       */
+    unsigned long long tokens;         /* bytes that can be sent/received   */
+    struct timeval last_refill;        /* last time tokens were added       */
+};
+
+extern void xfer_dcc_rate_limit_init (struct t_xfer_dcc_rate_limit *rate_limit,
+                                      unsigned long long rate,
+                                      unsigned long long burst);
+extern unsigned long long xfer_dcc_rate_limit_get (struct t_xfer_dcc_rate_limit *rate_limit,
+                                                   unsigned long long max);
+extern void xfer_dcc_rate_limit_use (struct t_xfer_dcc_rate_limit *rate_limit,
+                                     unsigned long long bytes);
+extern int xfer_dcc_rate_limit_delay (struct t_xfer_dcc_rate_limit *rate_limit,
+                                      unsigned long long bytes);
 extern void xfer_dcc_send_file_child (struct t_xfer *xfer);
 extern void xfer_dcc_recv_file_child (struct t_xfer *xfer);
 
@@ -62,22 +62,29 @@ extern "C"
 IMPORT_TEST_GROUP(Plugins);
 IMPORT_TEST_GROUP(CoreArraylist);
 IMPORT_TEST_GROUP(CoreCalc);
+IMPORT_TEST_GROUP(CoreConfigFile);
 IMPORT_TEST_GROUP(CoreCrypto);
+IMPORT_TEST_GROUP(CoreDebug);
 IMPORT_TEST_GROUP(CoreEval);
 IMPORT_TEST_GROUP(CoreHashtable);
 IMPORT_TEST_GROUP(CoreHdata);
 IMPORT_TEST_GROUP(CoreHook);
 IMPORT_TEST_GROUP(CoreInfolist);
 IMPORT_TEST_GROUP(CoreList);
+IMPORT_TEST_GROUP(CoreNetwork);
 IMPORT_TEST_GROUP(CoreSecure);
 IMPORT_TEST_GROUP(CoreString);
 IMPORT_TEST_GROUP(CoreUrl);
+IMPORT_TEST_GROUP(CoreUpgrade);
 IMPORT_TEST_GROUP(CoreUtf8);
 IMPORT_TEST_GROUP(CoreUtil);
 /* GUI */
 IMPORT_TEST_GROUP(GuiColor);
+IMPORT_TEST_GROUP(GuiFilter);
 IMPORT_TEST_GROUP(GuiLine);
 IMPORT_TEST_GROUP(GuiNick);
+IMPORT_TEST_GROUP(GuiSearch);
+IMPORT_TEST_GROUP(GuiWindow);
 /* scripts */
 IMPORT_TEST_GROUP(Scripts);
 
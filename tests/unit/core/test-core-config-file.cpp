@@ -0,0 +1,212 @@
+/*
+ * test-core-config-file.cpp - test configuration file functions
+ *
+ * Copyright (C) 2020 Sébastien Helleu <flashcode@flashtux.org>
+ *
+ * This file is part of WeeChat, the extensible chat client.
+ *
+ * WeeChat is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WeeChat is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WeeChat.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "CppUTest/TestHarness.h"
+
+extern "C"
+{
+#include <stdio.h>
+#include <string.h>
+#include "src/core/wee-config-file.h"
+#include "src/core/wee-hashtable.h"
+#include "src/core/wee-string.h"
+#include "src/plugins/weechat-plugin.h"
+}
+
+#define TEST_CONFIG_NUM_OPTIONS 10000
+
+TEST_GROUP(CoreConfigFile)
+{
+};
+
+int
+test_config_file_create_option_cb (const void *pointer, void *data,
+                                   struct t_config_file *config_file,
+                                   struct t_config_section *section,
+                                   const char *option_name,
+                                   const char *value)
+{
+    struct t_config_option *ptr_option;
+
+    /* make C++ compiler happy */
+    (void) pointer;
+    (void) data;
+
+    ptr_option = config_file_new_option (
+        config_file, section,
+        option_name, "string", NULL,
+        NULL, 0, 0, "", value, 0,
+        NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
+
+    return (ptr_option) ?
+        WEECHAT_CONFIG_OPTION_SET_OK_SAME_VALUE : WEECHAT_CONFIG_OPTION_SET_ERROR;
+}
+
+/*
+ * Creates a configuration file with a section which accepts any option.
+ */
+
+struct t_config_file *
+test_config_file_new (struct t_config_section **section)
+{
+    struct t_config_file *config_file;
+
+    config_file = config_file_new (NULL, "test_config_file", NULL, NULL, NULL);
+    if (!config_file)
+        return NULL;
+
+    *section = config_file_new_section (
+        config_file, "test", 1, 1,
+        NULL, NULL, NULL,
+        NULL, NULL, NULL,
+        NULL, NULL, NULL,
+        &test_config_file_create_option_cb, NULL, NULL,
+        NULL, NULL, NULL);
+
+    return config_file;
+}
+
+/*
+ * Tests functions:
+ *   config_file_new_option
+ *   config_file_search_option
+ *   config_file_option_rename
+ *   config_file_option_free
+ */
+
+TEST(CoreConfigFile, SearchOption)
+{
+    struct t_config_file *config_file;
+    struct t_config_section *section;
+    struct t_config_option *option1, *option2, *option3;
+    const char *names[] = { "opt\xc3\xa9", "OPT\xc3\xa9", "Opt\xc3\xa9",
+                            "opt\xc3\x89", "OPT\xc3\x89", "opt\xc3",
+                            "opt\xc3\xa9x", NULL };
+    int i;
+
+    config_file = test_config_file_new (&section);
+    CHECK(config_file);
+    CHECK(section);
+    CHECK(section->options_hash);
+
+    option1 = config_file_new_option (
+        config_file, section, "option1", "string", NULL,
+        NULL, 0, 0, "", "value1", 0,
+        NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
+    CHECK(option1);
+    option2 = config_file_new_option (
+        config_file, section, "option2", "string", NULL,
+        NULL, 0, 0, "", "value2", 0,
+        NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
+    CHECK(option2);
+    LONGS_EQUAL(2, section->options_hash->items_count);
+
+    POINTERS_EQUAL(NULL, config_file_search_option (config_file, section,
+                                                    NULL));
+    POINTERS_EQUAL(NULL, config_file_search_option (config_file, section,
+                                                    "option3"));
+    POINTERS_EQUAL(option1, config_file_search_option (config_file, section,
+                                                       "option1"));
+    POINTERS_EQUAL(option1, config_file_search_option (config_file, section,
+                                                       "OPTION1"));
+    POINTERS_EQUAL(option2, config_file_search_option (config_file, NULL,
+                                                       "option2"));
+
+    /* non-ASCII names: same result as a search with string_strcasecmp */
+    option3 = config_file_new_option (
+        config_file, section, "opt\xc3\xa9", "string", NULL,   /* "opté" */
+        NULL, 0, 0, "", "value3", 0,
+        NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL);
+    CHECK(option3);
+    for (i = 0; names[i]; i++)
+    {
+        POINTERS_EQUAL(
+            (string_strcasecmp (names[i], "opt\xc3\xa9") == 0) ? option3 : NULL,
+            config_file_search_option (config_file, section, names[i]));
+    }
+    config_file_option_free (option3, 0);
+
+    /* rename option */
+    config_file_option_rename (option1, "option3");
+    POINTERS_EQUAL(NULL, config_file_search_option (config_file, section,
+                                                    "option1"));
+    POINTERS_EQUAL(option1, config_file_search_option (config_file, section,
+                                                       "option3"));
+    POINTERS_EQUAL(option2, section->options);
+    POINTERS_EQUAL(option1, section->last_option);
+    LONGS_EQUAL(2, section->options_hash->items_count);
+
+    /* free option */
+    config_file_option_free (option2, 0);
+    POINTERS_EQUAL(NULL, config_file_search_option (config_file, section,
+                                                    "option2"));
+    LONGS_EQUAL(1, section->options_hash->items_count);
+
+    config_file_free (config_file);
+}
+
+/*
+ * Tests functions:
+ *   config_file_write
+ *   config_file_read
+ *
+ * with many options in a section (like servers in irc.conf).
+ */
+
+TEST(CoreConfigFile, ManyOptions)
+{
+    struct t_config_file *config_file;
+    struct t_config_section *section;
+    struct t_config_option *ptr_option;
+    char name[64], value[64];
+    int i;
+
+    config_file = test_config_file_new (&section);
+    CHECK(config_file);
+    for (i = 0; i < TEST_CONFIG_NUM_OPTIONS; i++)
+    {
+        snprintf (name, sizeof (name), "server%04d.option%d", i / 80, i % 80);
+        snprintf (value, sizeof (value), "value%d", i);
+        CHECK(config_file_new_option (
+                  config_file, section, name, "string", NULL,
+                  NULL, 0, 0, "", value, 0,
+                  NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL));
+    }
+    LONGS_EQUAL(TEST_CONFIG_NUM_OPTIONS, section->options_hash->items_count);
+    LONGS_EQUAL(WEECHAT_CONFIG_WRITE_OK, config_file_write (config_file));
+    config_file_free (config_file);
+
+    /* read file: all options are created by the section callback */
+    config_file = test_config_file_new (&section);
+    CHECK(config_file);
+    LONGS_EQUAL(WEECHAT_CONFIG_READ_OK, config_file_read (config_file));
+    LONGS_EQUAL(TEST_CONFIG_NUM_OPTIONS, section->options_hash->items_count);
+    ptr_option = config_file_search_option (config_file, section,
+                                            "server0123.option45");
+    CHECK(ptr_option);
+    STRCMP_EQUAL("value9885", CONFIG_STRING(ptr_option));
+
+    /* read file again: all options already exist */
+    LONGS_EQUAL(WEECHAT_CONFIG_READ_OK, config_file_reload (config_file));
+    LONGS_EQUAL(TEST_CONFIG_NUM_OPTIONS, section->options_hash->items_count);
+
+    config_file_free (config_file);
+}
@@ -0,0 +1,162 @@
+/*
+ * test-core-debug.cpp - test debug functions
+ *
+ * Copyright (C) 2020 Sébastien Helleu <flashcode@flashtux.org>
+ *
+ * This file is part of WeeChat, the extensible chat client.
+ *
+ * WeeChat is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WeeChat is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WeeChat.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "CppUTest/TestHarness.h"
+
+extern "C"
+{
+#include <string.h>
+#include <sys/time.h>
+#include "src/core/wee-debug.h"
+#include "src/core/wee-hashtable.h"
+}
+
+TEST_GROUP(CoreDebug)
+{
+};
+
+/*
+ * Tests functions:
+ *   debug_histogram_bucket
+ *   debug_histogram_bucket_max
+ */
+
+TEST(CoreDebug, HistogramBucket)
+{
+    int i;
+    long value;
+
+    /* exact buckets for small values */
+    LONGS_EQUAL(0, debug_histogram_bucket (-5));
+    LONGS_EQUAL(0, debug_histogram_bucket (0));
+    LONGS_EQUAL(1, debug_histogram_bucket (1));
+    LONGS_EQUAL(15, debug_histogram_bucket (15));
+    LONGS_EQUAL(0, debug_histogram_bucket_max (0));
+    LONGS_EQUAL(15, debug_histogram_bucket_max (15));
+
+    /* 8 buckets per power of 2 */
+    LONGS_EQUAL(16, debug_histogram_bucket (16));
+    LONGS_EQUAL(16, debug_histogram_bucket (17));
+    LONGS_EQUAL(17, debug_histogram_bucket (18));
+    LONGS_EQUAL(23, debug_histogram_bucket (31));
+    LONGS_EQUAL(24, debug_histogram_bucket (32));
+    LONGS_EQUAL(17, debug_histogram_bucket_max (16));
+    LONGS_EQUAL(31, debug_histogram_bucket_max (23));
+    LONGS_EQUAL(35, debug_histogram_bucket_max (24));
+
+    /* each value is in its bucket, with a relative error <= 12.5% */
+    for (value = 0; value < 100000; value += 7)
+    {
+        i = debug_histogram_bucket (value);
+        CHECK(i < DEBUG_HISTOGRAM_NUM_BUCKETS);
+        CHECK(debug_histogram_bucket_max (i) >= value);
+        CHECK(debug_histogram_bucket_max (i) - value <= value / 8);
+        if (i > 0)
+            CHECK(debug_histogram_bucket_max (i - 1) < value);
+    }
+
+    /* large values */
+    CHECK(debug_histogram_bucket (0x7FFFFFFFFFFFFFFFL) < DEBUG_HISTOGRAM_NUM_BUCKETS);
+}
+
+/*
+ * Tests functions:
+ *   debug_histogram_add
+ *   debug_histogram_percentile
+ */
+
+TEST(CoreDebug, Histogram)
+{
+    struct t_debug_histogram histogram;
+    long i, value;
+
+    memset (&histogram, 0, sizeof (histogram));
+
+    LONGS_EQUAL(0, debug_histogram_percentile (NULL, 50));
+    LONGS_EQUAL(0, debug_histogram_percentile (&histogram, 50));
+
+    for (i = 1; i <= 1000; i++)
+    {
+        debug_histogram_add (&histogram, i);
+    }
+    LONGS_EQUAL(1000, histogram.count);
+    LONGS_EQUAL(500500, histogram.sum);
+    LONGS_EQUAL(1000, histogram.max);
+
+    value = debug_histogram_percentile (&histogram, 50);
+    CHECK((value >= 500) && (value <= 500 + 500 / 8));
+    value = debug_histogram_percentile (&histogram, 99);
+    CHECK((value >= 990) && (value <= 1000));
+    LONGS_EQUAL(1000, debug_histogram_percentile (&histogram, 100));
+    LONGS_EQUAL(1, debug_histogram_percentile (&histogram, 0));
+
+    /* negative value is counted as 0 */
+    debug_histogram_add (&histogram, -1);
+    LONGS_EQUAL(1001, histogram.count);
+    LONGS_EQUAL(0, debug_histogram_percentile (&histogram, 0));
+}
+
+/*
+ * Tests functions:
+ *   debug_loop_start
+ *   debug_loop_mark
+ *   debug_loop_end
+ *   debug_loop_reset
+ *   debug_loop_stats_hashtable
+ */
+
+TEST(CoreDebug, Loop)
+{
+    struct t_hashtable *hashtable;
+    long iterations;
+
+    iterations = debug_loop_histogram_busy.count;
+
+    debug_loop_start ();
+    debug_loop_mark (DEBUG_LOOP_PHASE_TIMERS);
+    debug_loop_mark (DEBUG_LOOP_PHASE_REFRESH);
+    debug_loop_mark (DEBUG_LOOP_PHASE_POLL);
+    debug_loop_mark (DEBUG_LOOP_PHASE_FD);
+    debug_loop_mark (DEBUG_LOOP_PHASE_PROCESS);
+    debug_loop_end ();
+
+    LONGS_EQUAL(iterations + 1, debug_loop_histogram_busy.count);
+    LONGS_EQUAL(iterations + 1,
+                debug_loop_histogram[DEBUG_LOOP_PHASE_POLL].count);
+
+    /* mark/end without start are ignored */
+    debug_loop_mark (DEBUG_LOOP_PHASE_TIMERS);
+    debug_loop_end ();
+    LONGS_EQUAL(iterations + 1, debug_loop_histogram_busy.count);
+
+    hashtable = debug_loop_stats_hashtable ();
+    CHECK(hashtable);
+    CHECK(hashtable_has_key (hashtable, "iterations"));
+    CHECK(hashtable_has_key (hashtable, "stalls"));
+    CHECK(hashtable_has_key (hashtable, "timers_p50"));
+    CHECK(hashtable_has_key (hashtable, "poll_max"));
+    CHECK(hashtable_has_key (hashtable, "busy_p99"));
+    hashtable_free (hashtable);
+
+    debug_loop_reset ();
+    LONGS_EQUAL(0, debug_loop_histogram_busy.count);
+    LONGS_EQUAL(0, debug_loop_stalls);
+}
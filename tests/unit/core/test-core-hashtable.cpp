@@ -34,6 +34,9 @@ extern "C"
 #define HASHTABLE_TEST_KEY_LONG_HASH 11232856562070989738ULL
 #define HASHTABLE_TEST_VALUE         "this is a value"
 
+const char *test_hashtable_words[] =
+{ "weechat", "fast", "light", "extensible", "chat", "client", NULL };
+
 TEST_GROUP(CoreHashtable)
 {
 };
@@ -192,7 +195,7 @@ TEST(CoreHashtable, SetGetRemove)
     CHECK(item);
     STRCMP_EQUAL(str_key, (const char *)item->key);
     STRCMP_EQUAL(str_value, (const char *)item->value);
-    LONGS_EQUAL(2, hash);
+    POINTERS_EQUAL(item, hashtable->htable[hash]);
 
     /* get value */
     ptr_value = (const char *)hashtable_get (hashtable, str_key);
@@ -235,41 +238,40 @@ TEST(CoreHashtable, SetGetRemove)
     for (i = 0; i < hashtable->size; i++)
     {
         if (hashtable->htable[i])
+            CHECK(hashtable2->htable[i]);
+        else
+            POINTERS_EQUAL(NULL, hashtable2->htable[i]);
+    }
+    ptr_item = hashtable->items;
+    ptr_item2 = hashtable2->items;
+    while (ptr_item && ptr_item2)
+    {
+        LONGS_EQUAL(ptr_item->key_size, ptr_item2->key_size);
+        LONGS_EQUAL(ptr_item->value_size, ptr_item2->value_size);
+        CHECK(ptr_item->hash == ptr_item2->hash);
+        if (ptr_item->key)
         {
-            ptr_item = hashtable->htable[i];
-            ptr_item2 = hashtable2->htable[i];
-            while (ptr_item && ptr_item2)
-            {
-                LONGS_EQUAL(ptr_item->key_size, ptr_item2->key_size);
-                LONGS_EQUAL(ptr_item->value_size, ptr_item2->value_size);
-                if (ptr_item->key)
-                {
-                    STRCMP_EQUAL((const char *)ptr_item->key,
-                                 (const char *)ptr_item2->key);
-                }
-                else
-                {
-                    POINTERS_EQUAL(ptr_item->key, ptr_item2->key);
-                }
-                if (ptr_item->value)
-                {
-                    STRCMP_EQUAL((const char *)ptr_item->value,
-                                 (const char *)ptr_item2->value);
-                }
-                else
-                {
-                    POINTERS_EQUAL(ptr_item->value, ptr_item2->value);
-                }
-                ptr_item = ptr_item->next_item;
-                ptr_item2 = ptr_item2->next_item;
-                CHECK((ptr_item && ptr_item2) || (!ptr_item && !ptr_item2));
-            }
+            STRCMP_EQUAL((const char *)ptr_item->key,
+                         (const char *)ptr_item2->key);
         }
         else
         {
-            POINTERS_EQUAL(hashtable->htable[i], hashtable2->htable[i]);
+            POINTERS_EQUAL(ptr_item->key, ptr_item2->key);
+        }
+        if (ptr_item->value)
+        {
+            STRCMP_EQUAL((const char *)ptr_item->value,
+                         (const char *)ptr_item2->value);
         }
+        else
+        {
+            POINTERS_EQUAL(ptr_item->value, ptr_item2->value);
+        }
+        ptr_item = ptr_item->next_item;
+        ptr_item2 = ptr_item2->next_item;
     }
+    POINTERS_EQUAL(NULL, ptr_item);
+    POINTERS_EQUAL(NULL, ptr_item2);
 
     /* remove all items */
     hashtable_remove_all (hashtable);
@@ -281,25 +283,8 @@ TEST(CoreHashtable, SetGetRemove)
 
     /*
      * create a hashtable with size 8, and add 6 items,
-     * to check if many items with same hashed key work fine,
-     * the expected htable inside hashtable is:
-     *   +-----+
-     *   |   0 |
-     *   +-----+
-     *   |   1 |
-     *   +-----+
-     *   |   2 | --> "extensible"
-     *   +-----+
-     *   |   3 | --> "fast" --> "light"
-     *   +-----+
-     *   |   4 |
-     *   +-----+
-     *   |   5 | --> "chat"
-     *   +-----+
-     *   |   6 | --> "client"
-     *   +-----+
-     *   |   7 | --> "weechat"
-     *   +-----+
+     * to check that items are in htable (at index returned by
+     * hashtable_get_item) and in the list of items, in order of creation
      */
     hashtable = hashtable_new (8,
                                WEECHAT_HASHTABLE_STRING,
@@ -309,34 +294,153 @@ TEST(CoreHashtable, SetGetRemove)
     LONGS_EQUAL(8, hashtable->size);
     LONGS_EQUAL(0, hashtable->items_count);
 
-    item = hashtable_set (hashtable, "weechat", NULL);
-    CHECK(item);
-    POINTERS_EQUAL(item, hashtable->htable[7]);
+    for (i = 0; i < 6; i++)
+    {
+        item = hashtable_set (hashtable, test_hashtable_words[i], NULL);
+        CHECK(item);
+        POINTERS_EQUAL(item, hashtable->last_item);
+    }
+    LONGS_EQUAL(8, hashtable->size);
+    LONGS_EQUAL(6, hashtable->items_count);
+    ptr_item = hashtable->items;
+    for (i = 0; i < 6; i++)
+    {
+        CHECK(ptr_item);
+        STRCMP_EQUAL(test_hashtable_words[i], (const char *)ptr_item->key);
+        item = hashtable_get_item (hashtable, test_hashtable_words[i], &hash);
+        POINTERS_EQUAL(ptr_item, item);
+        POINTERS_EQUAL(item, hashtable->htable[hash]);
+        ptr_item = ptr_item->next_item;
+    }
+    POINTERS_EQUAL(NULL, ptr_item);
 
-    item = hashtable_set (hashtable, "fast", NULL);
-    CHECK(item);
-    POINTERS_EQUAL(item, hashtable->htable[3]);
+    /* free hashtable */
+    hashtable_free (hashtable);
+}
 
-    item = hashtable_set (hashtable, "light", NULL);
-    CHECK(item);
-    POINTERS_EQUAL(item, hashtable->htable[3]->next_item);
+/*
+ * Tests functions:
+ *   hashtable_hash_mix
+ *   hashtable_resize
+ *   hashtable_remove_item
+ */
 
-    item = hashtable_set (hashtable, "extensible", NULL);
-    CHECK(item);
-    POINTERS_EQUAL(item, hashtable->htable[2]);
+TEST(CoreHashtable, Resize)
+{
+    struct t_hashtable *hashtable;
+    struct t_hashtable_item *item;
+    unsigned long long hash;
+    int i, value, count;
+    void *ptr;
 
-    item = hashtable_set (hashtable, "chat", NULL);
-    CHECK(item);
-    POINTERS_EQUAL(item, hashtable->htable[5]);
+    /* size is rounded to a power of 2 */
+    hashtable = hashtable_new (20,
+                               WEECHAT_HASHTABLE_INTEGER,
+                               WEECHAT_HASHTABLE_INTEGER,
+                               NULL, NULL);
+    CHECK(hashtable);
+    LONGS_EQUAL(32, hashtable->size);
+    LONGS_EQUAL(32, hashtable->size_min);
+    hashtable_free (hashtable);
 
-    item = hashtable_set (hashtable, "client", NULL);
-    CHECK(item);
-    POINTERS_EQUAL(item, hashtable->htable[6]);
+    /* hash of consecutive integers must not be consecutive */
+    CHECK(hashtable_hash_mix (1) != hashtable_hash_mix (2));
+    CHECK((hashtable_hash_mix (1) & 0xFF) != 1);
+
+    /* htable is enlarged when items are added */
+    hashtable = hashtable_new (8,
+                               WEECHAT_HASHTABLE_INTEGER,
+                               WEECHAT_HASHTABLE_INTEGER,
+                               NULL, NULL);
+    for (i = 0; i < 10000; i++)
+    {
+        value = i * 2;
+        item = hashtable_set (hashtable, &i, &value);
+        CHECK(item);
+        /* integer key is stored with item */
+        POINTERS_EQUAL(item + 1, item->key);
+    }
+    LONGS_EQUAL(10000, hashtable->items_count);
+    CHECK(hashtable->size >= 10000 * 4 / 3);
+    CHECK((hashtable->size & (hashtable->size - 1)) == 0);
+    for (i = 0; i < 10000; i++)
+    {
+        item = hashtable_get_item (hashtable, &i, &hash);
+        CHECK(item);
+        POINTERS_EQUAL(item, hashtable->htable[hash]);
+        LONGS_EQUAL(i * 2, *((int *)item->value));
+    }
+    i = 10000;
+    POINTERS_EQUAL(NULL, hashtable_get (hashtable, &i));
+
+    /* htable is reduced when items are removed, all items still found */
+    for (i = 0; i < 10000; i += 2)
+    {
+        hashtable_remove (hashtable, &i);
+    }
+    LONGS_EQUAL(5000, hashtable->items_count);
+    for (i = 0; i < 10000; i++)
+    {
+        ptr = hashtable_get (hashtable, &i);
+        if (i % 2 == 0)
+            POINTERS_EQUAL(NULL, ptr);
+        else
+            LONGS_EQUAL(i * 2, *((int *)ptr));
+    }
+    for (i = 1; i < 9990; i += 2)
+    {
+        hashtable_remove (hashtable, &i);
+    }
+    LONGS_EQUAL(5, hashtable->items_count);
+    LONGS_EQUAL(32, hashtable->size);
+    count = 0;
+    for (i = 0; i < hashtable->size; i++)
+    {
+        if (hashtable->htable[i])
+            count++;
+    }
+    LONGS_EQUAL(5, count);
+    for (i = 9991; i < 10000; i += 2)
+    {
+        CHECK(hashtable_has_key (hashtable, &i));
+    }
+
+    hashtable_remove_all (hashtable);
+    LONGS_EQUAL(0, hashtable->items_count);
+    LONGS_EQUAL(8, hashtable->size);
+    POINTERS_EQUAL(NULL, hashtable->items);
+    POINTERS_EQUAL(NULL, hashtable->last_item);
 
-    /* free hashtable */
     hashtable_free (hashtable);
 }
 
+/*
+ * Test callback for hashtable_map: adds key in a string and removes some
+ * items (including the current one).
+ */
+
+void
+test_hashtable_map_cb (void *data,
+                       struct t_hashtable *hashtable,
+                       const void *key, const void *value)
+{
+    char *keys;
+
+    /* make C++ compiler happy */
+    (void) value;
+
+    keys = (char *)data;
+    if (keys[0])
+        strcat (keys, ",");
+    strcat (keys, (const char *)key);
+
+    if ((strcmp ((const char *)key, "fast") == 0)
+        || (strcmp ((const char *)key, "chat") == 0))
+    {
+        hashtable_remove (hashtable, key);
+    }
+}
+
 /*
  * Tests functions:
  *   hashtable_map
@@ -345,7 +449,30 @@ TEST(CoreHashtable, SetGetRemove)
 
 TEST(CoreHashtable, Map)
 {
-    /* TODO: write tests */
+    struct t_hashtable *hashtable;
+    char keys[256];
+    int i;
+
+    hashtable = hashtable_new (8,
+                               WEECHAT_HASHTABLE_STRING,
+                               WEECHAT_HASHTABLE_STRING,
+                               NULL, NULL);
+    for (i = 0; test_hashtable_words[i]; i++)
+    {
+        hashtable_set (hashtable, test_hashtable_words[i], "value");
+    }
+
+    /* items are sent in order of creation, current item can be removed */
+    keys[0] = '\0';
+    hashtable_map (hashtable, &test_hashtable_map_cb, keys);
+    STRCMP_EQUAL("weechat,fast,light,extensible,chat,client", keys);
+    LONGS_EQUAL(4, hashtable->items_count);
+
+    keys[0] = '\0';
+    hashtable_map (hashtable, &test_hashtable_map_cb, keys);
+    STRCMP_EQUAL("weechat,light,extensible,client", keys);
+
+    hashtable_free (hashtable);
 }
 
 /*
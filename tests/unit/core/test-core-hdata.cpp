@@ -24,6 +24,13 @@
 extern "C"
 {
 #include "src/core/wee-hdata.h"
+#include "src/core/wee-hook.h"
+#include "src/gui/gui-buffer.h"
+#include "src/gui/gui-chat.h"
+#include "src/gui/gui-hotlist.h"
+#include "src/gui/gui-line.h"
+#include "src/gui/gui-nicklist.h"
+#include "src/gui/gui-window.h"
 }
 
 TEST_GROUP(CoreHdata)
@@ -62,12 +69,102 @@ TEST(CoreHdata, Get)
 
 /*
  * Tests functions:
+ *   hdata_registry_add
+ *   hdata_registry_remove
  *   hdata_check_pointer
  */
 
 TEST(CoreHdata, Check)
 {
-    /* TODO: write tests */
+    struct t_hdata *hdata_buffer, *hdata_window, *hdata_line, *hdata_line_data;
+    struct t_hdata *hdata_nick_group, *hdata_nick, *hdata_hotlist;
+    struct t_gui_buffer *buffer;
+    struct t_gui_line *line;
+    struct t_gui_line_data *line_data;
+    struct t_gui_nick_group *group;
+    struct t_gui_nick *nick;
+    struct t_gui_hotlist *hotlist;
+
+    hdata_buffer = hook_hdata_get (NULL, "buffer");
+    CHECK(hdata_buffer);
+    hdata_window = hook_hdata_get (NULL, "window");
+    CHECK(hdata_window);
+    hdata_line = hook_hdata_get (NULL, "line");
+    CHECK(hdata_line);
+    hdata_line_data = hook_hdata_get (NULL, "line_data");
+    CHECK(hdata_line_data);
+    hdata_nick_group = hook_hdata_get (NULL, "nick_group");
+    CHECK(hdata_nick_group);
+    hdata_nick = hook_hdata_get (NULL, "nick");
+    CHECK(hdata_nick);
+    hdata_hotlist = hook_hdata_get (NULL, "hotlist");
+    CHECK(hdata_hotlist);
+
+    LONGS_EQUAL(0, hdata_check_pointer (NULL, NULL, NULL));
+    LONGS_EQUAL(0, hdata_check_pointer (hdata_buffer, NULL, NULL));
+
+    /* core buffer and window */
+    LONGS_EQUAL(1, hdata_check_pointer (hdata_buffer, NULL, gui_buffers));
+    LONGS_EQUAL(1, hdata_check_pointer (hdata_buffer, gui_buffers,
+                                        gui_buffers));
+    LONGS_EQUAL(1, hdata_check_pointer (hdata_window, NULL, gui_windows));
+    LONGS_EQUAL(1, hdata_check_pointer (hdata_window, gui_windows,
+                                        gui_windows));
+
+    /* invalid pointers */
+    LONGS_EQUAL(0, hdata_check_pointer (hdata_buffer, NULL,
+                                        (void *)0x1));
+    LONGS_EQUAL(0, hdata_check_pointer (hdata_buffer, gui_buffers,
+                                        (void *)0x1));
+    LONGS_EQUAL(0, hdata_check_pointer (hdata_buffer, NULL, gui_windows));
+
+    /* new buffer, then closed */
+    buffer = gui_buffer_new (NULL, "test_hdata_check",
+                             NULL, NULL, NULL,
+                             NULL, NULL, NULL);
+    CHECK(buffer);
+    LONGS_EQUAL(1, hdata_check_pointer (hdata_buffer, NULL, buffer));
+    LONGS_EQUAL(1, hdata_check_pointer (hdata_buffer, gui_buffers, buffer));
+    LONGS_EQUAL(1, hdata_check_pointer (hdata_buffer, last_gui_buffer,
+                                        buffer));
+
+    /*
+     * line and line data: only line data are in registry (lines have no
+     * list with flag "check_pointers", so any line pointer is valid)
+     */
+    gui_chat_printf_date_tags (buffer, 0, NULL, "test");
+    line = buffer->own_lines->last_line;
+    CHECK(line);
+    line_data = line->data;
+    LONGS_EQUAL(1, hdata_check_pointer (hdata_line, NULL, line));
+    LONGS_EQUAL(1, hdata_check_pointer (hdata_line_data, NULL, line_data));
+    LONGS_EQUAL(0, hdata_check_pointer (hdata_line_data, NULL, line));
+
+    /* nick group and nick */
+    group = gui_nicklist_add_group (buffer, NULL, "test_group", NULL, 1);
+    CHECK(group);
+    nick = gui_nicklist_add_nick (buffer, group, "test_nick", NULL, NULL,
+                                  NULL, 1);
+    CHECK(nick);
+    LONGS_EQUAL(1, hdata_check_pointer (hdata_nick_group, NULL, group));
+    LONGS_EQUAL(1, hdata_check_pointer (hdata_nick, NULL, nick));
+    gui_nicklist_remove_nick (buffer, nick);
+    LONGS_EQUAL(0, hdata_check_pointer (hdata_nick, NULL, nick));
+    gui_nicklist_remove_group (buffer, group);
+    LONGS_EQUAL(0, hdata_check_pointer (hdata_nick_group, NULL, group));
+
+    /* hotlist */
+    hotlist = gui_hotlist_add (buffer, GUI_HOTLIST_HIGHLIGHT, NULL);
+    CHECK(hotlist);
+    LONGS_EQUAL(1, hdata_check_pointer (hdata_hotlist, NULL, hotlist));
+    LONGS_EQUAL(1, hdata_check_pointer (hdata_hotlist, gui_hotlist, hotlist));
+    gui_hotlist_remove_buffer (buffer, 1);
+    LONGS_EQUAL(0, hdata_check_pointer (hdata_hotlist, NULL, hotlist));
+
+    gui_buffer_close (buffer);
+    LONGS_EQUAL(0, hdata_check_pointer (hdata_buffer, NULL, buffer));
+    LONGS_EQUAL(0, hdata_check_pointer (hdata_buffer, gui_buffers, buffer));
+    LONGS_EQUAL(0, hdata_check_pointer (hdata_line_data, NULL, line_data));
 }
 
 /*
@@ -24,7 +24,10 @@
 extern "C"
 {
 #include <string.h>
+#include <unistd.h>
+#include <sys/wait.h>
 #include "src/core/wee-hook.h"
+#include "src/core/wee-infolist.h"
 #include "src/core/wee-string.h"
 #include "src/gui/gui-buffer.h"
 #include "src/gui/gui-chat.h"
@@ -362,15 +365,86 @@ TEST(CoreHook, Print)
     /* TODO: write tests */
 }
 
+int test_process_calls = 0;
+int test_process_rc = 0;
+char test_process_out[256];
+
+int
+test_process_cb (const void *pointer, void *data, const char *command,
+                 int return_code, const char *out, const char *err)
+{
+    /* make C++ compiler happy */
+    (void) pointer;
+    (void) data;
+    (void) command;
+    (void) err;
+
+    test_process_calls++;
+    test_process_rc = return_code;
+    if (out)
+    {
+        strncat (test_process_out, out,
+                 sizeof (test_process_out) - strlen (test_process_out) - 1);
+    }
+
+    return WEECHAT_RC_OK;
+}
+
 /*
  * Tests functions:
  *   hook_process
  *   hook_process_hashtable
+ *   hook_process_check_child_end
  */
 
 TEST(CoreHook, Process)
 {
-    /* TODO: write tests */
+    struct t_hook *hook;
+    pid_t pid;
+    int i, status;
+
+    /* command spawned, end of child detected with pidfd (or timer) */
+    test_process_calls = 0;
+    test_process_rc = 0;
+    test_process_out[0] = '\0';
+    hook = hook_process (NULL, "echo test", 10000,
+                         &test_process_cb, NULL, NULL);
+    CHECK(hook);
+    CHECK(HOOK_PROCESS(hook, child_pid) > 0);
+    if (HOOK_PROCESS(hook, child_pidfd) >= 0)
+        CHECK(HOOK_PROCESS(hook, hook_pidfd));
+    for (i = 0; (i < 500) && (test_process_calls == 0); i++)
+    {
+        usleep (10000);
+        hook_fd_exec ();
+        hook_timer_exec ();
+    }
+    LONGS_EQUAL(1, test_process_calls);
+    LONGS_EQUAL(0, test_process_rc);
+    STRCMP_EQUAL("test\n", test_process_out);
+
+    /* child already reaped (waitpid fails with ECHILD): error, hook removed */
+    test_process_calls = 0;
+    test_process_rc = 0;
+    test_process_out[0] = '\0';
+    hook = hook_process (NULL, "true", 10000,
+                         &test_process_cb, NULL, NULL);
+    CHECK(hook);
+    pid = HOOK_PROCESS(hook, child_pid);
+    CHECK(pid > 0);
+    LONGS_EQUAL(pid, waitpid (pid, &status, 0));
+    hook_process_check_child_end (hook);
+    LONGS_EQUAL(1, test_process_calls);
+    LONGS_EQUAL(WEECHAT_HOOK_PROCESS_ERROR, test_process_rc);
+    STRCMP_EQUAL("", test_process_out);
+    for (i = 0; i < 10; i++)
+    {
+        hook_fd_exec ();
+        hook_timer_exec ();
+    }
+    LONGS_EQUAL(1, test_process_calls);
+
+    hook_remove_deleted (1);
 }
 
 /*
@@ -392,3 +466,342 @@ TEST(CoreHook, Timer)
 {
     /* TODO: write tests */
 }
+
+int
+test_profile_signal_cb (const void *pointer, void *data,
+                        const char *signal, const char *type_data,
+                        void *signal_data)
+{
+    /* make C++ compiler happy */
+    (void) pointer;
+    (void) data;
+    (void) signal;
+    (void) type_data;
+    (void) signal_data;
+
+    return WEECHAT_RC_OK;
+}
+
+/*
+ * Tests functions:
+ *   hook_callback_start
+ *   hook_callback_end
+ *   hook_profile_enable
+ *   hook_profile_reset
+ */
+
+TEST(CoreHook, Profile)
+{
+    struct t_hook *hook;
+    struct t_hook_profile *ptr_profile;
+
+    hook_profile_reset ();
+
+    hook = hook_signal (NULL, "test_profile_signal",
+                        &test_profile_signal_cb, NULL, NULL);
+    CHECK(hook);
+
+    /* profiling disabled: no counters updated */
+    hook_signal_send ("test_profile_signal", WEECHAT_HOOK_SIGNAL_STRING, NULL);
+    LONGS_EQUAL(0, hook->profile_calls);
+    POINTERS_EQUAL(NULL, hook_profiles);
+
+    /* profiling enabled */
+    hook_profile_enable (1);
+    hook_signal_send ("test_profile_signal", WEECHAT_HOOK_SIGNAL_STRING, NULL);
+    hook_signal_send ("test_profile_signal", WEECHAT_HOOK_SIGNAL_STRING, NULL);
+    hook_profile_enable (0);
+    LONGS_EQUAL(2, hook->profile_calls);
+    LONGS_EQUAL(0, hook->running);
+    CHECK(hook->profile_time_total >= hook->profile_time_max);
+    for (ptr_profile = hook_profiles; ptr_profile;
+         ptr_profile = ptr_profile->next_profile)
+    {
+        if (strcmp (ptr_profile->name, "core") == 0)
+            break;
+    }
+    CHECK(ptr_profile);
+    CHECK(ptr_profile->calls >= 2);
+    STRCMP_EQUAL("test_profile_signal", hook_get_description (hook));
+
+    /* reset */
+    hook_profile_reset ();
+    LONGS_EQUAL(0, hook->profile_calls);
+    LONGS_EQUAL(0, hook->profile_time_total);
+    LONGS_EQUAL(0, hook->profile_time_max);
+    POINTERS_EQUAL(NULL, hook_profiles);
+    POINTERS_EQUAL(NULL, last_hook_profile);
+
+    unhook (hook);
+}
+
+int test_array_signal_calls[4];
+struct t_hook *test_array_hooks[4];
+struct t_hook *test_array_new_hook = NULL;
+
+int
+test_array_signal_cb (const void *pointer, void *data,
+                      const char *signal, const char *type_data,
+                      void *signal_data)
+{
+    long index;
+
+    /* make C++ compiler happy */
+    (void) data;
+    (void) signal;
+    (void) type_data;
+    (void) signal_data;
+
+    index = (long)pointer;
+    test_array_signal_calls[index]++;
+
+    if (index == 0)
+    {
+        /* remove hook #2 and add a hook with highest priority */
+        unhook (test_array_hooks[2]);
+        test_array_hooks[2] = NULL;
+        test_array_new_hook = hook_signal (NULL, "5000|test_array_signal",
+                                           &test_array_signal_cb,
+                                           (const void *)3, NULL);
+    }
+
+    return WEECHAT_RC_OK;
+}
+
+/*
+ * Tests functions:
+ *   hook_add_to_list
+ *   hook_remove_deleted
+ *   unhook
+ *   hook_iterator_init
+ *   hook_iterator_next
+ */
+
+TEST(CoreHook, Array)
+{
+    struct t_hook *ptr_hook;
+    int i, count_array, count_list;
+
+    memset (test_array_signal_calls, 0, sizeof (test_array_signal_calls));
+
+    /* remove hooks deleted by previous tests */
+    hook_remove_deleted (1);
+
+    test_array_hooks[0] = hook_signal (NULL, "2000|test_array_signal",
+                                       &test_array_signal_cb,
+                                       (const void *)0, NULL);
+    test_array_hooks[1] = hook_signal (NULL, "10|test_array_signal",
+                                       &test_array_signal_cb,
+                                       (const void *)1, NULL);
+    test_array_hooks[2] = hook_signal (NULL, "10|test_array_signal",
+                                       &test_array_signal_cb,
+                                       (const void *)2, NULL);
+
+    /* array and linked list are sorted by priority, in same order */
+    count_array = hook_arrays[HOOK_TYPE_SIGNAL].size;
+    count_list = 0;
+    for (ptr_hook = weechat_hooks[HOOK_TYPE_SIGNAL]; ptr_hook;
+         ptr_hook = ptr_hook->next_hook)
+    {
+        POINTERS_EQUAL(hook_arrays[HOOK_TYPE_SIGNAL].hooks[count_list],
+                       ptr_hook);
+        if (count_list > 0)
+        {
+            CHECK(ptr_hook->priority
+                  <= hook_arrays[HOOK_TYPE_SIGNAL].hooks[count_list - 1]->priority);
+        }
+        count_list++;
+    }
+    LONGS_EQUAL(count_array, count_list);
+    LONGS_EQUAL(count_array, hooks_count[HOOK_TYPE_SIGNAL]);
+    POINTERS_EQUAL(last_weechat_hook[HOOK_TYPE_SIGNAL],
+                   hook_arrays[HOOK_TYPE_SIGNAL].hooks[count_array - 1]);
+
+    /* same priority: kept in order of creation */
+    for (i = 0; i < count_array; i++)
+    {
+        if (hook_arrays[HOOK_TYPE_SIGNAL].hooks[i] == test_array_hooks[1])
+            break;
+    }
+    POINTERS_EQUAL(test_array_hooks[2],
+                   hook_arrays[HOOK_TYPE_SIGNAL].hooks[i + 1]);
+
+    /*
+     * hook removed by a callback is not called, hook added by a callback is
+     * not called during same signal
+     */
+    hook_signal_send ("test_array_signal", WEECHAT_HOOK_SIGNAL_STRING, NULL);
+    LONGS_EQUAL(1, test_array_signal_calls[0]);
+    LONGS_EQUAL(1, test_array_signal_calls[1]);
+    LONGS_EQUAL(0, test_array_signal_calls[2]);
+    LONGS_EQUAL(0, test_array_signal_calls[3]);
+    CHECK(test_array_new_hook);
+    LONGS_EQUAL(count_array + 1, hook_arrays[HOOK_TYPE_SIGNAL].size);
+    LONGS_EQUAL(1, hook_arrays[HOOK_TYPE_SIGNAL].deleted);
+    hook_remove_deleted (1);
+    LONGS_EQUAL(count_array, hook_arrays[HOOK_TYPE_SIGNAL].size);
+    LONGS_EQUAL(0, hook_arrays[HOOK_TYPE_SIGNAL].deleted);
+    POINTERS_EQUAL(test_array_new_hook, weechat_hooks[HOOK_TYPE_SIGNAL]);
+
+    /* array is compacted lazily (only when enough hooks are deleted) */
+    unhook (test_array_new_hook);
+    unhook (test_array_hooks[0]);
+    unhook (test_array_hooks[1]);
+    CHECK(hook_arrays[HOOK_TYPE_SIGNAL].deleted * HOOK_ARRAY_COMPACT_RATIO
+          < hook_arrays[HOOK_TYPE_SIGNAL].size);
+    LONGS_EQUAL(3, hook_arrays[HOOK_TYPE_SIGNAL].deleted);
+    LONGS_EQUAL(count_array, hook_arrays[HOOK_TYPE_SIGNAL].size);
+    CHECK(!hook_valid (test_array_hooks[0]));
+    hook_remove_deleted (0);
+    LONGS_EQUAL(3, hook_arrays[HOOK_TYPE_SIGNAL].deleted);
+
+    /* forced compaction (end of main loop iteration) */
+    hook_remove_deleted (1);
+    LONGS_EQUAL(0, hook_arrays[HOOK_TYPE_SIGNAL].deleted);
+    LONGS_EQUAL(count_array - 3, hook_arrays[HOOK_TYPE_SIGNAL].size);
+    LONGS_EQUAL(hooks_count[HOOK_TYPE_SIGNAL],
+                hook_arrays[HOOK_TYPE_SIGNAL].size);
+}
+
+int test_batch_signal_calls = 0;
+int test_batch_calls = 0;
+int test_batch_events = 0;
+char test_batch_last_data[64];
+
+int
+test_batch_signal_cb (const void *pointer, void *data,
+                      const char *signal, const char *type_data,
+                      void *signal_data)
+{
+    /* make C++ compiler happy */
+    (void) pointer;
+    (void) data;
+    (void) signal;
+    (void) type_data;
+    (void) signal_data;
+
+    test_batch_signal_calls++;
+
+    return WEECHAT_RC_OK;
+}
+
+int
+test_batch_timer_cb (const void *pointer, void *data, int remaining_calls)
+{
+    /* make C++ compiler happy */
+    (void) pointer;
+    (void) data;
+    (void) remaining_calls;
+
+    return WEECHAT_RC_OK;
+}
+
+int
+test_batch_cb (const void *pointer, void *data, struct t_infolist *events)
+{
+    const char *ptr_data;
+
+    /* make C++ compiler happy */
+    (void) pointer;
+    (void) data;
+
+    test_batch_calls++;
+    test_batch_last_data[0] = '\0';
+    while (infolist_next (events))
+    {
+        test_batch_events++;
+        ptr_data = infolist_string (events, "signal_data");
+        snprintf (test_batch_last_data, sizeof (test_batch_last_data),
+                  "%s", (ptr_data) ? ptr_data : "");
+    }
+
+    return WEECHAT_RC_OK;
+}
+
+/*
+ * Tests functions:
+ *   hook_batch
+ *   hook_batch_add_event
+ *   hook_batch_add_event_end
+ *   hook_batch_flush
+ *   hook_batch_exec
+ *   hook_batch_get_time_to_next
+ *   hook_batch_free
+ */
+
+TEST(CoreHook, Batch)
+{
+    struct t_hook *hook, *hook_other;
+
+    test_batch_signal_calls = 0;
+    test_batch_calls = 0;
+    test_batch_events = 0;
+
+    hook = hook_signal (NULL, "test_batch_signal",
+                        &test_batch_signal_cb, NULL, NULL);
+    CHECK(hook);
+
+    /* invalid hooks/arguments */
+    LONGS_EQUAL(0, hook_batch (NULL, NULL, 0, 0, &test_batch_cb, NULL, NULL));
+    LONGS_EQUAL(0, hook_batch (NULL, hook, -1, 0, &test_batch_cb, NULL, NULL));
+    LONGS_EQUAL(0, hook_batch (NULL, hook, 0, -1, &test_batch_cb, NULL, NULL));
+    hook_other = hook_timer (NULL, 60000, 0, 0, &test_batch_timer_cb,
+                             NULL, NULL);
+    CHECK(hook_other);
+    LONGS_EQUAL(0, hook_batch (NULL, hook_other, 0, 0, &test_batch_cb,
+                               NULL, NULL));
+    unhook (hook_other);
+
+    /* max size reached: batch delivered immediately */
+    LONGS_EQUAL(1, hook_batch (NULL, hook, 2, 60000, &test_batch_cb,
+                               NULL, NULL));
+    hook_signal_send ("test_batch_signal", WEECHAT_HOOK_SIGNAL_STRING,
+                      (void *)"a");
+    LONGS_EQUAL(0, test_batch_calls);
+    LONGS_EQUAL(1, hook_batch_pending);
+    hook_signal_send ("test_batch_signal", WEECHAT_HOOK_SIGNAL_STRING,
+                      (void *)"b");
+    LONGS_EQUAL(1, test_batch_calls);
+    LONGS_EQUAL(2, test_batch_events);
+    STRCMP_EQUAL("b", test_batch_last_data);
+    LONGS_EQUAL(0, hook_batch_pending);
+    LONGS_EQUAL(0, test_batch_signal_calls);
+
+    /* latency not reached: batch kept */
+    hook_signal_send ("test_batch_signal", WEECHAT_HOOK_SIGNAL_STRING,
+                      (void *)"c");
+    hook_batch_exec ();
+    LONGS_EQUAL(1, test_batch_calls);
+    CHECK(hook_batch_get_time_to_next (120000) <= 60000);
+    LONGS_EQUAL(0, hook_batch_get_time_to_next (0));
+
+    /* latency of 0: batch delivered at end of main loop iteration */
+    LONGS_EQUAL(1, hook_batch (NULL, hook, 0, 0, &test_batch_cb, NULL, NULL));
+    LONGS_EQUAL(0, hook_batch_get_time_to_next (1000));
+    hook_batch_exec ();
+    LONGS_EQUAL(2, test_batch_calls);
+    LONGS_EQUAL(3, test_batch_events);
+    STRCMP_EQUAL("c", test_batch_last_data);
+    LONGS_EQUAL(0, hook_batch_pending);
+
+    /* disable batch: pending events delivered, then callback of hook used */
+    hook_signal_send ("test_batch_signal", WEECHAT_HOOK_SIGNAL_STRING,
+                      (void *)"d");
+    LONGS_EQUAL(1, hook_batch (NULL, hook, 0, 0, NULL, NULL, NULL));
+    POINTERS_EQUAL(NULL, hook->batch);
+    LONGS_EQUAL(3, test_batch_calls);
+    STRCMP_EQUAL("d", test_batch_last_data);
+    hook_signal_send ("test_batch_signal", WEECHAT_HOOK_SIGNAL_STRING,
+                      (void *)"e");
+    LONGS_EQUAL(1, test_batch_signal_calls);
+
+    /* unhook with pending events: events are lost */
+    LONGS_EQUAL(1, hook_batch (NULL, hook, 0, 60000, &test_batch_cb,
+                               NULL, NULL));
+    hook_signal_send ("test_batch_signal", WEECHAT_HOOK_SIGNAL_STRING,
+                      (void *)"f");
+    LONGS_EQUAL(1, hook_batch_pending);
+    unhook (hook);
+    LONGS_EQUAL(0, hook_batch_pending);
+    LONGS_EQUAL(3, test_batch_calls);
+}
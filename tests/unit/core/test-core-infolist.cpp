@@ -24,6 +24,7 @@
 
 extern "C"
 {
+#include "src/core/wee-hashtable.h"
 #include "src/core/wee-hook.h"
 #include "src/core/wee-infolist.h"
 }
@@ -255,6 +256,83 @@ TEST(CoreInfolist, Valid)
     LONGS_EQUAL(0, infolist_valid (infolist));
 }
 
+/*
+ * Tests functions:
+ *   infolist_arena_alloc
+ *   infolist_arena_strdup
+ *   infolist_intern_name
+ */
+
+TEST(CoreInfolist, Arena)
+{
+    struct t_infolist *infolist;
+    struct t_infolist_item *item, *item1;
+    struct t_infolist_var *var1, *var2;
+    struct t_infolist_arena *ptr_arena;
+    char *str, big_string[INFOLIST_ARENA_BLOCK_SIZE * 3];
+    int i, count;
+
+    infolist = infolist_new (NULL);
+    CHECK(infolist);
+    POINTERS_EQUAL(NULL, infolist->arena);
+    POINTERS_EQUAL(NULL, infolist->names);
+
+    /* allocations are aligned */
+    str = (char *)infolist_arena_alloc (infolist, 1);
+    CHECK(str);
+    CHECK(infolist->arena);
+    LONGS_EQUAL(0, ((unsigned long)infolist_arena_alloc (infolist, 3)) % 8);
+
+    /* duplicate a string */
+    str = infolist_arena_strdup (infolist, "test");
+    STRCMP_EQUAL("test", str);
+
+    /* duplicate a string bigger than a block */
+    memset (big_string, 'a', sizeof (big_string) - 1);
+    big_string[sizeof (big_string) - 1] = '\0';
+    str = infolist_arena_strdup (infolist, big_string);
+    STRCMP_EQUAL(big_string, str);
+
+    /* names are interned */
+    STRCMP_EQUAL("name", infolist_intern_name (infolist, "name"));
+    POINTERS_EQUAL(infolist_intern_name (infolist, "name"),
+                   infolist_intern_name (infolist, "name"));
+    CHECK(infolist_intern_name (infolist, "name")
+          != infolist_intern_name (infolist, "name2"));
+
+    /* many items with same variables: names are shared */
+    item1 = NULL;
+    for (i = 0; i < 10000; i++)
+    {
+        item = infolist_new_item (infolist);
+        CHECK(item);
+        POINTERS_EQUAL(infolist, item->infolist);
+        if (!item1)
+            item1 = item;
+        CHECK(infolist_new_var_integer (item, "number", i));
+        CHECK(infolist_new_var_string (item, "string", "value"));
+    }
+    var1 = item1->vars;
+    var2 = infolist->last_item->vars;
+    POINTERS_EQUAL(var1->name, var2->name);
+    POINTERS_EQUAL(var1->next_var->name, var2->next_var->name);
+    LONGS_EQUAL(0, *((int *)var1->value));
+    LONGS_EQUAL(9999, *((int *)var2->value));
+    LONGS_EQUAL(4, infolist->names->items_count);
+
+    /* blocks are few and never bigger than the max (except big string) */
+    count = 0;
+    for (ptr_arena = infolist->arena; ptr_arena;
+         ptr_arena = ptr_arena->next_arena)
+    {
+        CHECK(ptr_arena->used <= ptr_arena->size);
+        count++;
+    }
+    CHECK(count < 16);
+
+    infolist_free (infolist);
+}
+
 /*
  * Tests functions:
  *   infolist_search_var
@@ -0,0 +1,292 @@
+/*
+ * test-core-network.cpp - test network functions
+ *
+ * Copyright (C) 2020 Sébastien Helleu <flashcode@flashtux.org>
+ *
+ * This file is part of WeeChat, the extensible chat client.
+ *
+ * WeeChat is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WeeChat is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WeeChat.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "CppUTest/TestHarness.h"
+
+extern "C"
+{
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netdb.h>
+#include "src/core/wee-hook.h"
+#include "src/core/wee-network.h"
+#include "src/plugins/plugin.h"
+
+extern int network_num_threads;
+}
+
+struct t_test_network_connect
+{
+    int calls;
+    int status;
+    int sock;
+};
+
+TEST_GROUP(CoreNetwork)
+{
+    /*
+     * Callback for connect hook used in tests.
+     */
+
+    static int
+    test_network_connect_cb (const void *pointer, void *data,
+                             int status, int gnutls_rc, int sock,
+                             const char *error, const char *ip_address)
+    {
+        struct t_test_network_connect *connect_data;
+
+        /* make C++ compiler happy */
+        (void) data;
+        (void) gnutls_rc;
+        (void) error;
+        (void) ip_address;
+
+        connect_data = (struct t_test_network_connect *)pointer;
+        connect_data->calls++;
+        connect_data->status = status;
+        connect_data->sock = sock;
+
+        return WEECHAT_RC_OK;
+    }
+
+    /*
+     * Creates a listening socket on 127.0.0.1 (random port).
+     *
+     * Returns the socket, and the port in "port".
+     */
+
+    static int
+    test_network_listen (int *port)
+    {
+        struct sockaddr_in addr;
+        socklen_t length;
+        int sock;
+
+        sock = socket (AF_INET, SOCK_STREAM, 0);
+        if (sock < 0)
+            return -1;
+        memset (&addr, 0, sizeof (addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl (INADDR_LOOPBACK);
+        length = sizeof (addr);
+        if ((bind (sock, (struct sockaddr *)&addr, sizeof (addr)) != 0)
+            || (listen (sock, 8) != 0)
+            || (getsockname (sock, (struct sockaddr *)&addr, &length) != 0))
+        {
+            close (sock);
+            return -1;
+        }
+        *port = ntohs (addr.sin_port);
+        return sock;
+    }
+};
+
+/*
+ * Tests functions:
+ *   network_addrinfo_dup
+ *   network_addrinfo_free
+ */
+
+TEST(CoreNetwork, AddrinfoDup)
+{
+    struct addrinfo hints, *res, *res2, *ptr_res, *ptr_res2;
+
+    POINTERS_EQUAL(NULL, network_addrinfo_dup (NULL));
+    network_addrinfo_free (NULL);
+
+    memset (&hints, 0, sizeof (hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_NUMERICHOST | AI_NUMERICSERV;
+    res = NULL;
+    LONGS_EQUAL(0, getaddrinfo ("127.0.0.1", "6667", &hints, &res));
+    CHECK(res);
+
+    res2 = network_addrinfo_dup (res);
+    CHECK(res2);
+    CHECK(res2 != res);
+    ptr_res = res;
+    ptr_res2 = res2;
+    while (ptr_res && ptr_res2)
+    {
+        LONGS_EQUAL(ptr_res->ai_family, ptr_res2->ai_family);
+        LONGS_EQUAL(ptr_res->ai_socktype, ptr_res2->ai_socktype);
+        LONGS_EQUAL(ptr_res->ai_addrlen, ptr_res2->ai_addrlen);
+        CHECK(ptr_res->ai_addr != ptr_res2->ai_addr);
+        MEMCMP_EQUAL(ptr_res->ai_addr, ptr_res2->ai_addr, ptr_res->ai_addrlen);
+        ptr_res = ptr_res->ai_next;
+        ptr_res2 = ptr_res2->ai_next;
+    }
+    POINTERS_EQUAL(NULL, ptr_res);
+    POINTERS_EQUAL(NULL, ptr_res2);
+
+    freeaddrinfo (res);
+    network_addrinfo_free (res2);
+}
+
+/*
+ * Tests functions:
+ *   network_getaddrinfo
+ *   network_dns_cache_free_all
+ */
+
+TEST(CoreNetwork, Getaddrinfo)
+{
+    struct addrinfo hints, *res, *res2;
+    struct sockaddr_in *addr;
+
+    memset (&hints, 0, sizeof (hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_NUMERICHOST | AI_NUMERICSERV;
+
+    /* without cache */
+    res = NULL;
+    LONGS_EQUAL(0, network_getaddrinfo ("127.0.0.1", "6667", &hints, 0, &res));
+    CHECK(res);
+    LONGS_EQUAL(AF_INET, res->ai_family);
+    addr = (struct sockaddr_in *)res->ai_addr;
+    LONGS_EQUAL(6667, ntohs (addr->sin_port));
+    network_addrinfo_free (res);
+
+    /* invalid address */
+    res = NULL;
+    CHECK(network_getaddrinfo ("invalid", "6667", &hints, 60, &res) != 0);
+    POINTERS_EQUAL(NULL, res);
+
+    /* with cache: each call returns a new copy */
+    res = NULL;
+    res2 = NULL;
+    LONGS_EQUAL(0, network_getaddrinfo ("127.0.0.1", "6697", &hints, 60, &res));
+    LONGS_EQUAL(0, network_getaddrinfo ("127.0.0.1", "6697", &hints, 60, &res2));
+    CHECK(res);
+    CHECK(res2);
+    CHECK(res != res2);
+    LONGS_EQUAL(res->ai_addrlen, res2->ai_addrlen);
+    MEMCMP_EQUAL(res->ai_addr, res2->ai_addr, res->ai_addrlen);
+    addr = (struct sockaddr_in *)res2->ai_addr;
+    LONGS_EQUAL(6697, ntohs (addr->sin_port));
+    network_addrinfo_free (res);
+    network_addrinfo_free (res2);
+
+    network_dns_cache_free_all ();
+}
+
+/*
+ * Tests functions:
+ *   network_connect_child_race
+ */
+
+TEST(CoreNetwork, ConnectRace)
+{
+    struct t_network_connect_job job;
+    struct addrinfo hints, *res, *res_connected;
+    char str_port[32];
+    int sock_listen, port, sock, status;
+
+    sock_listen = test_network_listen (&port);
+    CHECK(sock_listen >= 0);
+    snprintf (str_port, sizeof (str_port), "%d", port);
+
+    memset (&hints, 0, sizeof (hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_NUMERICHOST | AI_NUMERICSERV;
+    res = NULL;
+    LONGS_EQUAL(0, getaddrinfo ("127.0.0.1", str_port, &hints, &res));
+    CHECK(res);
+
+    memset (&job, 0, sizeof (job));
+    job.sock = -1;
+    job.write_fd = -1;
+    job.send_fd = -1;
+
+    /* connection OK */
+    job.timeout = 60;
+    status = WEECHAT_HOOK_CONNECT_IP_ADDRESS_NOT_FOUND;
+    res_connected = NULL;
+    sock = network_connect_child_race (&job, &res, 1, NULL, &status,
+                                       &res_connected);
+    CHECK(sock >= 0);
+    POINTERS_EQUAL(res, res_connected);
+    close (sock);
+
+    /* timeout reached: status is set */
+    job.timeout = 0;
+    status = WEECHAT_HOOK_CONNECT_IP_ADDRESS_NOT_FOUND;
+    res_connected = NULL;
+    LONGS_EQUAL(-1, network_connect_child_race (&job, &res, 1, NULL, &status,
+                                                &res_connected));
+    LONGS_EQUAL(WEECHAT_HOOK_CONNECT_TIMEOUT, status);
+    POINTERS_EQUAL(NULL, res_connected);
+
+    freeaddrinfo (res);
+    close (sock_listen);
+}
+
+/*
+ * Tests functions:
+ *   network_connect_with_thread
+ *   network_connect_thread
+ *   network_connect_threads_end
+ */
+
+TEST(CoreNetwork, ConnectThreads)
+{
+    struct t_test_network_connect connect_data;
+    struct t_hook *hook;
+    int sock_listen, port, i, count;
+
+    sock_listen = test_network_listen (&port);
+    CHECK(sock_listen >= 0);
+
+    network_connect_threads_end ();
+    LONGS_EQUAL(0, network_num_threads);
+
+    /* connect twice: a worker thread is started, then stopped and joined */
+    for (count = 0; count < 2; count++)
+    {
+        memset (&connect_data, 0, sizeof (connect_data));
+        connect_data.sock = -1;
+        hook = hook_connect (NULL, NULL, "127.0.0.1", port, 0, 0,
+                             NULL, NULL, 0, NULL, NULL,
+                             &test_network_connect_cb, &connect_data, NULL);
+        CHECK(hook);
+        LONGS_EQUAL(1, network_num_threads);
+        for (i = 0; (i < 500) && (connect_data.calls == 0); i++)
+        {
+            hook_fd_exec ();
+            hook_timer_exec ();
+        }
+        LONGS_EQUAL(1, connect_data.calls);
+        LONGS_EQUAL(WEECHAT_HOOK_CONNECT_OK, connect_data.status);
+        CHECK(connect_data.sock >= 0);
+        close (connect_data.sock);
+
+        network_connect_threads_end ();
+        LONGS_EQUAL(0, network_num_threads);
+    }
+
+    close (sock_listen);
+}
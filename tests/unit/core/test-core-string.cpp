@@ -1587,6 +1587,45 @@ TEST(CoreString, SplitBuildWithSplitString)
     string_free_split (argv);
 }
 
+/*
+ * Tests functions:
+ *    string_is_ascii
+ *    string_charset_is_utf8
+ *    string_charset_is_ascii_compatible
+ */
+
+TEST(CoreString, Charset)
+{
+    /* string_is_ascii */
+    LONGS_EQUAL(1, string_is_ascii (NULL, -1));
+    LONGS_EQUAL(1, string_is_ascii ("", -1));
+    LONGS_EQUAL(1, string_is_ascii ("abc", -1));
+    LONGS_EQUAL(1, string_is_ascii ("abcdefghijklmnopqrstuvwxyz", -1));
+    LONGS_EQUAL(0, string_is_ascii ("no\xc3\xabl", -1));
+    LONGS_EQUAL(1, string_is_ascii ("no\xc3\xabl", 2));
+    LONGS_EQUAL(0, string_is_ascii ("abcdefghijklmnop\xebq", -1));
+    LONGS_EQUAL(1, string_is_ascii ("abcdefghijklmnop\xebq", 16));
+    LONGS_EQUAL(0, string_is_ascii ("\xeb", -1));
+
+    /* string_charset_is_utf8 */
+    LONGS_EQUAL(0, string_charset_is_utf8 (NULL));
+    LONGS_EQUAL(0, string_charset_is_utf8 (""));
+    LONGS_EQUAL(0, string_charset_is_utf8 ("ISO-8859-15"));
+    LONGS_EQUAL(0, string_charset_is_utf8 ("UTF-16"));
+    LONGS_EQUAL(1, string_charset_is_utf8 ("UTF-8"));
+    LONGS_EQUAL(1, string_charset_is_utf8 ("utf8"));
+
+    /* string_charset_is_ascii_compatible */
+    LONGS_EQUAL(0, string_charset_is_ascii_compatible (NULL));
+    LONGS_EQUAL(0, string_charset_is_ascii_compatible (""));
+    LONGS_EQUAL(0, string_charset_is_ascii_compatible ("UTF-16"));
+    LONGS_EQUAL(0, string_charset_is_ascii_compatible ("UTF-7"));
+    LONGS_EQUAL(0, string_charset_is_ascii_compatible ("EBCDIC-US"));
+    LONGS_EQUAL(1, string_charset_is_ascii_compatible ("UTF-8"));
+    LONGS_EQUAL(1, string_charset_is_ascii_compatible ("iso-8859-15"));
+    LONGS_EQUAL(1, string_charset_is_ascii_compatible ("CP1252"));
+}
+
 /*
  * Tests functions:
  *    string_iconv
@@ -1609,6 +1648,9 @@ TEST(CoreString, Iconv)
     WEE_TEST_STR("abc", string_iconv (1, "UTF-8", "ISO-8859-15", "abc"));
     WEE_TEST_STR(noel_iso, string_iconv (1, "UTF-8", "ISO-8859-15", noel_utf8));
     WEE_TEST_STR(noel_utf8, string_iconv (0, "ISO-8859-15", "UTF-8", noel_iso));
+    WEE_TEST_STR(noel_utf8, string_iconv (0, "ISO-8859-15", "UTF-8", noel_iso));
+    WEE_TEST_STR(noel_utf8, string_iconv (0, "UTF8", "UTF-8", noel_utf8));
+    WEE_TEST_STR("no?", string_iconv (1, "UTF8", "UTF-8", "no\xebl"));
 
     /* string_iconv_to_internal */
     WEE_TEST_STR(NULL, string_iconv_to_internal (NULL, NULL));
@@ -0,0 +1,97 @@
+/*
+ * test-core-upgrade.cpp - test upgrade functions
+ *
+ * Copyright (C) 2020 Sébastien Helleu <flashcode@flashtux.org>
+ *
+ * This file is part of WeeChat, the extensible chat client.
+ *
+ * WeeChat is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WeeChat is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WeeChat.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "CppUTest/TestHarness.h"
+
+extern "C"
+{
+#ifndef HAVE_CONFIG_H
+#define HAVE_CONFIG_H
+#endif
+#include <stdio.h>
+#include <unistd.h>
+#include "src/core/weechat.h"
+#include "src/core/wee-upgrade.h"
+#include "src/core/wee-upgrade-file.h"
+#include "src/gui/gui-buffer.h"
+#include "src/gui/gui-chat.h"
+#include "src/gui/gui-line.h"
+}
+
+#define TEST_UPGRADE_FILENAME "test_upgrade"
+
+TEST_GROUP(CoreUpgrade)
+{
+};
+
+/*
+ * Tests functions:
+ *   upgrade_weechat_save_misc
+ *   upgrade_weechat_read_cb (misc info)
+ */
+
+TEST(CoreUpgrade, SaveRestoreMisc)
+{
+    struct t_upgrade_file *upgrade_file;
+    long saved_last_id;
+    int upgrade_count;
+    char filename[4096];
+
+    upgrade_count = weechat_upgrade_count;
+
+    /* save misc info with a last line id greater than current one */
+    gui_line_last_id += 1000;
+    saved_last_id = gui_line_last_id;
+    upgrade_file = upgrade_file_new (TEST_UPGRADE_FILENAME, NULL, NULL, NULL);
+    CHECK(upgrade_file);
+    LONGS_EQUAL(1, upgrade_weechat_save_misc (upgrade_file));
+    upgrade_file_close (upgrade_file);
+
+    /* simulate a new process where ids start again from 0 */
+    gui_line_last_id -= 1000;
+    weechat_upgrade_count = upgrade_count + 1;
+
+    /* read misc info: last line id is restored */
+    upgrade_file = upgrade_file_new (TEST_UPGRADE_FILENAME,
+                                     &upgrade_weechat_read_cb, NULL, NULL);
+    CHECK(upgrade_file);
+    LONGS_EQUAL(1, upgrade_file_read (upgrade_file));
+    upgrade_file_close (upgrade_file);
+    LONGS_EQUAL(saved_last_id, gui_line_last_id);
+    LONGS_EQUAL(upgrade_count, weechat_upgrade_count);
+
+    /* next line has an id greater than all lines saved */
+    gui_chat_printf (NULL, "test upgrade");
+    LONGS_EQUAL(saved_last_id + 1,
+                gui_buffers->own_lines->last_line->data->id);
+
+    /* last line id is never decreased when misc info is read */
+    upgrade_file = upgrade_file_new (TEST_UPGRADE_FILENAME,
+                                     &upgrade_weechat_read_cb, NULL, NULL);
+    CHECK(upgrade_file);
+    LONGS_EQUAL(1, upgrade_file_read (upgrade_file));
+    upgrade_file_close (upgrade_file);
+    LONGS_EQUAL(saved_last_id + 1, gui_line_last_id);
+
+    snprintf (filename, sizeof (filename), "%s/%s.upgrade",
+              weechat_home, TEST_UPGRADE_FILENAME);
+    unlink (filename);
+}
@@ -23,21 +23,422 @@
 
 extern "C"
 {
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <curl/curl.h>
+#include "src/core/wee-config.h"
+#include "src/core/wee-config-file.h"
+#include "src/core/wee-hashtable.h"
+#include "src/core/wee-hook.h"
 #include "src/core/wee-url.h"
+#include "src/plugins/plugin.h"
+
+extern struct t_hook *url_hook_timer;
+extern struct t_url_transfer *url_transfers;
+extern int url_transfers_processing;
+extern int weeurl_multi_init ();
+extern void weeurl_transfer_check ();
+extern int weeurl_fd_cb (const void *pointer, void *data, int fd);
+extern int weeurl_multi_timer_cb (CURLM *multi, long timeout_ms, void *userp);
+extern int weeurl_multi_socket_cb (CURL *curl, curl_socket_t sock, int what,
+                                   void *userp, void *socketp);
 }
 
+#define TEST_URL_FILE "/tmp/weechat_test_url.txt"
+#define TEST_URL_FILE_OUT "/tmp/weechat_test_url_out.txt"
+#define TEST_URL_CONTENT "test URL transfer\n"
+
+struct t_test_url_data
+{
+    char output[256];
+    int calls_write;
+    int calls_end;
+    int return_code;
+    char error[256];
+    struct t_url_transfer *transfer_to_cancel;
+};
+
 TEST_GROUP(CoreUrl)
 {
+    struct t_hook *hook_timer_wakeup;
+
+    /*
+     * Callback for timer used to wake up poll() in hook_fd_exec.
+     */
+
+    static int
+    test_url_timer_cb (const void *pointer, void *data, int remaining_calls)
+    {
+        /* make C++ compiler happy */
+        (void) pointer;
+        (void) data;
+        (void) remaining_calls;
+
+        return WEECHAT_RC_OK;
+    }
+
+    /*
+     * Callback for output of transfer.
+     */
+
+    static void
+    test_url_write_cb (void *data, const char *buffer, int size)
+    {
+        struct t_test_url_data *url_data;
+        int length;
+
+        url_data = (struct t_test_url_data *)data;
+        url_data->calls_write++;
+        length = strlen (url_data->output);
+        if (length + size < (int)sizeof (url_data->output))
+        {
+            memcpy (url_data->output + length, buffer, size);
+            url_data->output[length + size] = '\0';
+        }
+        if (url_data->transfer_to_cancel)
+        {
+            weeurl_transfer_cancel (url_data->transfer_to_cancel);
+            url_data->transfer_to_cancel = NULL;
+        }
+    }
+
+    /*
+     * Callback for end of transfer.
+     */
+
+    static void
+    test_url_end_cb (void *data, int return_code, const char *error)
+    {
+        struct t_test_url_data *url_data;
+
+        url_data = (struct t_test_url_data *)data;
+        url_data->calls_end++;
+        url_data->return_code = return_code;
+        snprintf (url_data->error, sizeof (url_data->error),
+                  "%s", (error) ? error : "");
+    }
+
+    /*
+     * Runs timers and fd hooks until end of transfer (or about 5 seconds).
+     */
+
+    static void
+    test_url_run (struct t_test_url_data *url_data)
+    {
+        int i;
+
+        for (i = 0; (i < 500) && (url_data->calls_end == 0); i++)
+        {
+            hook_timer_exec ();
+            hook_fd_exec ();
+        }
+    }
+
+    /*
+     * Returns number of fd hooks used by curl.
+     */
+
+    static int
+    test_url_count_fd ()
+    {
+        struct t_hook *ptr_hook;
+        int count;
+
+        count = 0;
+        for (ptr_hook = weechat_hooks[HOOK_TYPE_FD]; ptr_hook;
+             ptr_hook = ptr_hook->next_hook)
+        {
+            if (!ptr_hook->deleted
+                && (HOOK_FD(ptr_hook, callback) == &weeurl_fd_cb))
+            {
+                count++;
+            }
+        }
+        return count;
+    }
+
+    void setup ()
+    {
+        FILE *file;
+
+        /* poll() in hook_fd_exec waits at most 10ms */
+        hook_timer_wakeup = hook_timer (NULL, 10, 0, 0,
+                                        &test_url_timer_cb, NULL, NULL);
+
+        file = fopen (TEST_URL_FILE, "w");
+        if (file)
+        {
+            fputs (TEST_URL_CONTENT, file);
+            fclose (file);
+        }
+    }
+
+    void teardown ()
+    {
+        unhook (hook_timer_wakeup);
+        unlink (TEST_URL_FILE);
+        unlink (TEST_URL_FILE_OUT);
+    }
 };
 
 /*
  * Tests functions:
- *   weeurl_download
+ *   weeurl_transfer_new
+ *   weeurl_transfer_check
+ *   weeurl_multi_timer_cb
+ *   weeurl_timer_cb
  */
 
-TEST(CoreUrl, Download)
+TEST(CoreUrl, Transfer)
 {
-    /* TODO: write tests */
+    struct t_test_url_data url_data;
+    struct t_hashtable *options;
+    struct t_url_transfer *transfer;
+    FILE *file;
+    char line[1024];
+    int rc;
+
+    /* invalid URL */
+    rc = -1;
+    POINTERS_EQUAL(NULL, weeurl_transfer_new (NULL, NULL, NULL, NULL,
+                                              NULL, &rc));
+    LONGS_EQUAL(1, rc);
+    rc = -1;
+    POINTERS_EQUAL(NULL, weeurl_transfer_new ("", NULL, NULL, NULL,
+                                              NULL, &rc));
+    LONGS_EQUAL(1, rc);
+
+    /* input file not found */
+    options = hashtable_new (32,
+                             WEECHAT_HASHTABLE_STRING,
+                             WEECHAT_HASHTABLE_STRING,
+                             NULL, NULL);
+    CHECK(options);
+    hashtable_set (options, "file_in", "/tmp/weechat_test_url_not_found");
+    rc = -1;
+    POINTERS_EQUAL(NULL, weeurl_transfer_new ("file://" TEST_URL_FILE,
+                                              options, NULL, NULL, NULL,
+                                              &rc));
+    LONGS_EQUAL(4, rc);
+    POINTERS_EQUAL(NULL, url_transfers);
+    hashtable_remove_all (options);
+
+    /* read a file, output sent to callback */
+    memset (&url_data, 0, sizeof (url_data));
+    rc = -1;
+    transfer = weeurl_transfer_new ("file://" TEST_URL_FILE, NULL,
+                                    &test_url_write_cb, &test_url_end_cb,
+                                    &url_data, &rc);
+    CHECK(transfer);
+    LONGS_EQUAL(0, rc);
+    POINTERS_EQUAL(transfer, url_transfers);
+    CHECK(url_hook_timer);
+    test_url_run (&url_data);
+    LONGS_EQUAL(1, url_data.calls_write);
+    LONGS_EQUAL(1, url_data.calls_end);
+    LONGS_EQUAL(0, url_data.return_code);
+    STRCMP_EQUAL(TEST_URL_CONTENT, url_data.output);
+    STRCMP_EQUAL("", url_data.error);
+    POINTERS_EQUAL(NULL, url_transfers);
+
+    /* read a file, output written in a file */
+    memset (&url_data, 0, sizeof (url_data));
+    hashtable_set (options, "file_out", TEST_URL_FILE_OUT);
+    transfer = weeurl_transfer_new ("file://" TEST_URL_FILE, options,
+                                    &test_url_write_cb, &test_url_end_cb,
+                                    &url_data, &rc);
+    CHECK(transfer);
+    test_url_run (&url_data);
+    LONGS_EQUAL(0, url_data.calls_write);
+    LONGS_EQUAL(1, url_data.calls_end);
+    LONGS_EQUAL(0, url_data.return_code);
+    file = fopen (TEST_URL_FILE_OUT, "r");
+    CHECK(file);
+    CHECK(fgets (line, sizeof (line), file));
+    fclose (file);
+    STRCMP_EQUAL(TEST_URL_CONTENT, line);
+    hashtable_remove_all (options);
+
+    /* file not found: error sent to end callback */
+    memset (&url_data, 0, sizeof (url_data));
+    transfer = weeurl_transfer_new ("file:///tmp/weechat_test_url_not_found",
+                                    NULL,
+                                    &test_url_write_cb, &test_url_end_cb,
+                                    &url_data, &rc);
+    CHECK(transfer);
+    test_url_run (&url_data);
+    LONGS_EQUAL(0, url_data.calls_write);
+    LONGS_EQUAL(1, url_data.calls_end);
+    LONGS_EQUAL(2, url_data.return_code);
+    CHECK(strstr (url_data.error, "curl error"));
+    CHECK(strstr (url_data.error, "weechat_test_url_not_found"));
+    POINTERS_EQUAL(NULL, url_transfers);
+
+    /* timer requested by curl */
+    weeurl_multi_timer_cb (NULL, 1000, NULL);
+    CHECK(url_hook_timer);
+    weeurl_multi_timer_cb (NULL, -1, NULL);
+    POINTERS_EQUAL(NULL, url_hook_timer);
+
+    /* nothing to do if there is no transfer */
+    weeurl_transfer_check ();
+    POINTERS_EQUAL(NULL, url_transfers);
+
+    hashtable_free (options);
+}
+
+/*
+ * Tests functions:
+ *   weeurl_transfer_cancel
+ *   weeurl_transfer_free_cancelled
+ */
+
+TEST(CoreUrl, Cancel)
+{
+    struct t_test_url_data url_data1, url_data2;
+    struct t_url_transfer *transfer1, *transfer2;
+
+    weeurl_transfer_cancel (NULL);
+
+    /* cancel a transfer before it runs: it is freed immediately */
+    memset (&url_data1, 0, sizeof (url_data1));
+    transfer1 = weeurl_transfer_new ("file://" TEST_URL_FILE, NULL,
+                                     &test_url_write_cb, &test_url_end_cb,
+                                     &url_data1, NULL);
+    CHECK(transfer1);
+    weeurl_transfer_cancel (transfer1);
+    POINTERS_EQUAL(NULL, url_transfers);
+    test_url_run (&url_data1);
+    LONGS_EQUAL(0, url_data1.calls_write);
+    LONGS_EQUAL(0, url_data1.calls_end);
+
+    /*
+     * cancel a transfer in callback of another transfer: callbacks of
+     * cancelled transfer are not called, it is freed after callbacks
+     */
+    memset (&url_data1, 0, sizeof (url_data1));
+    memset (&url_data2, 0, sizeof (url_data2));
+    transfer1 = weeurl_transfer_new ("file://" TEST_URL_FILE, NULL,
+                                     &test_url_write_cb, &test_url_end_cb,
+                                     &url_data1, NULL);
+    CHECK(transfer1);
+    transfer2 = weeurl_transfer_new ("file://" TEST_URL_FILE, NULL,
+                                     &test_url_write_cb, &test_url_end_cb,
+                                     &url_data2, NULL);
+    CHECK(transfer2);
+    url_data1.transfer_to_cancel = transfer2;
+    test_url_run (&url_data1);
+    LONGS_EQUAL(1, url_data1.calls_write);
+    LONGS_EQUAL(1, url_data1.calls_end);
+    LONGS_EQUAL(0, url_data2.calls_write);
+    LONGS_EQUAL(0, url_data2.calls_end);
+    LONGS_EQUAL(0, url_transfers_processing);
+    POINTERS_EQUAL(NULL, url_transfers);
+}
+
+/*
+ * Tests functions:
+ *   weeurl_multi_init
+ *   weeurl_multi_socket_cb
+ *   weeurl_fd_cb
+ *   weeurl_set_max_connections
+ */
+
+TEST(CoreUrl, Socket)
+{
+    struct t_test_url_data url_data1, url_data2;
+    struct t_url_transfer *transfer1, *transfer2;
+    struct t_hook *ptr_hook;
+    struct sockaddr_in addr;
+    socklen_t length;
+    char url1[256], url2[256];
+    int sock, fds[2], count, i;
+
+    /* socket added, updated and removed by curl */
+    LONGS_EQUAL(1, weeurl_multi_init ());
+    CHECK(pipe (fds) == 0);
+    LONGS_EQUAL(0, test_url_count_fd ());
+    LONGS_EQUAL(0, weeurl_multi_socket_cb (NULL, fds[0], CURL_POLL_IN,
+                                           NULL, NULL));
+    LONGS_EQUAL(1, test_url_count_fd ());
+    ptr_hook = weechat_hooks[HOOK_TYPE_FD];
+    while (ptr_hook && (HOOK_FD(ptr_hook, callback) != &weeurl_fd_cb))
+    {
+        ptr_hook = ptr_hook->next_hook;
+    }
+    CHECK(ptr_hook);
+    LONGS_EQUAL(fds[0], HOOK_FD(ptr_hook, fd));
+    LONGS_EQUAL(HOOK_FD_FLAG_READ, HOOK_FD(ptr_hook, flags));
+    LONGS_EQUAL(0, weeurl_multi_socket_cb (NULL, fds[0], CURL_POLL_INOUT,
+                                           NULL, ptr_hook));
+    LONGS_EQUAL(HOOK_FD_FLAG_READ | HOOK_FD_FLAG_WRITE,
+                HOOK_FD(ptr_hook, flags));
+    LONGS_EQUAL(0, weeurl_multi_socket_cb (NULL, fds[0], CURL_POLL_REMOVE,
+                                           NULL, ptr_hook));
+    LONGS_EQUAL(0, test_url_count_fd ());
+    close (fds[0]);
+    close (fds[1]);
+
+    /*
+     * server which accepts connections (in backlog) but never replies;
+     * two different hosts are used, because a transfer waits for the
+     * connection to the same host (to multiplex requests)
+     */
+    sock = socket (AF_INET, SOCK_STREAM, 0);
+    CHECK(sock >= 0);
+    memset (&addr, 0, sizeof (addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl (INADDR_ANY);
+    addr.sin_port = 0;
+    CHECK(bind (sock, (struct sockaddr *)&addr, sizeof (addr)) == 0);
+    CHECK(listen (sock, 8) == 0);
+    length = sizeof (addr);
+    CHECK(getsockname (sock, (struct sockaddr *)&addr, &length) == 0);
+    snprintf (url1, sizeof (url1), "http://127.0.0.1:%d/1",
+              ntohs (addr.sin_port));
+    snprintf (url2, sizeof (url2), "http://127.0.0.2:%d/2",
+              ntohs (addr.sin_port));
+
+    /* max 1 connection, then unlimited */
+    for (count = 1; count <= 2; count++)
+    {
+        config_file_option_set (config_network_url_max_connections,
+                                (count == 1) ? "1" : "0", 1);
+        memset (&url_data1, 0, sizeof (url_data1));
+        memset (&url_data2, 0, sizeof (url_data2));
+        transfer1 = weeurl_transfer_new (url1, NULL,
+                                         &test_url_write_cb, &test_url_end_cb,
+                                         &url_data1, NULL);
+        CHECK(transfer1);
+        transfer2 = weeurl_transfer_new (url2, NULL,
+                                         &test_url_write_cb, &test_url_end_cb,
+                                         &url_data2, NULL);
+        CHECK(transfer2);
+        for (i = 0; (i < 50) && (test_url_count_fd () < count); i++)
+        {
+            hook_timer_exec ();
+            hook_fd_exec ();
+        }
+        for (i = 0; i < 10; i++)
+        {
+            hook_timer_exec ();
+            hook_fd_exec ();
+        }
+        LONGS_EQUAL(count, test_url_count_fd ());
+        LONGS_EQUAL(0, url_data1.calls_end);
+        LONGS_EQUAL(0, url_data2.calls_end);
+        weeurl_transfer_cancel (transfer1);
+        weeurl_transfer_cancel (transfer2);
+        POINTERS_EQUAL(NULL, url_transfers);
+        LONGS_EQUAL(0, test_url_count_fd ());
+    }
+
+    config_file_option_reset (config_network_url_max_connections, 1);
+    close (sock);
 }
 
 /*
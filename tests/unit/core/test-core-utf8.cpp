@@ -24,12 +24,19 @@
 extern "C"
 {
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <sys/time.h>
 #include <wctype.h>
 #include "tests/tests.h"
 #include "src/core/wee-utf8.h"
+#include "src/core/wee-util.h"
 }
 
+#define TEST_UTF8_SIMD_LENGTH 100
+#define TEST_UTF8_BENCHMARK_LENGTH (1024 * 1024)
+#define TEST_UTF8_BENCHMARK_LOOPS 20
+
 const char *noel_valid = "no\xc3\xabl";        /* noël */
 const char *noel_invalid = "no\xc3l";
 const char *noel_invalid2 = "no\xff\xffl";
@@ -51,6 +58,7 @@ TEST_GROUP(CoreUtf8)
 
 TEST(CoreUtf8, Validity)
 {
+    const char *str;
     char *error;
 
     /* check 8 bits */
@@ -58,6 +66,8 @@ TEST(CoreUtf8, Validity)
     LONGS_EQUAL(0, utf8_has_8bits (""));
     LONGS_EQUAL(0, utf8_has_8bits ("abc"));
     LONGS_EQUAL(1, utf8_has_8bits ("no\xc3\xabl"));
+    LONGS_EQUAL(0, utf8_has_8bits ("abcdefghijklmnopqrstuvwxyz"));
+    LONGS_EQUAL(1, utf8_has_8bits ("abcdefghijklmnop\xc3\xabqrstuvwxyz"));
 
     /* check validity */
     LONGS_EQUAL(1, utf8_is_valid (NULL, -1, NULL));
@@ -200,6 +210,173 @@ TEST(CoreUtf8, Validity)
     LONGS_EQUAL(1, utf8_is_valid ("\xf7\xbf\xbf\xbf", 0, NULL));
     LONGS_EQUAL(1, utf8_is_valid ("\xf7\xbf\xbf\xbf", 1, NULL));
     LONGS_EQUAL(1, utf8_is_valid ("\xf7\xbf\xbf\xbf", 2, NULL));
+
+    /* long strings (checked by blocks of 8 bytes) */
+    LONGS_EQUAL(1, utf8_is_valid ("abcdefghijklmnopqrstuvwxyz", -1, &error));
+    POINTERS_EQUAL(NULL, error);
+    str = "abcdefghijklmnop\xc3\xabqrstuvwxyz\xebz";
+    LONGS_EQUAL(0, utf8_is_valid (str, -1, &error));
+    POINTERS_EQUAL(str + 28, error);
+    LONGS_EQUAL(1, utf8_is_valid (str, 27, &error));
+    POINTERS_EQUAL(NULL, error);
+    LONGS_EQUAL(0, utf8_is_valid (str, 28, &error));
+    POINTERS_EQUAL(str + 28, error);
+    LONGS_EQUAL(1, utf8_is_valid (str, 10, &error));
+    POINTERS_EQUAL(NULL, error);
+}
+
+/*
+ * Tests functions:
+ *   utf8_ascii_length
+ *   utf8_ascii_printable_length
+ */
+
+TEST(CoreUtf8, Ascii)
+{
+    /* number of ASCII chars */
+    LONGS_EQUAL(0, utf8_ascii_length (NULL, 0));
+    LONGS_EQUAL(0, utf8_ascii_length (NULL, 10));
+    LONGS_EQUAL(0, utf8_ascii_length ("", 0));
+    LONGS_EQUAL(0, utf8_ascii_length ("abc", -1));
+    LONGS_EQUAL(2, utf8_ascii_length ("abc", 2));
+    LONGS_EQUAL(3, utf8_ascii_length ("abc", 3));
+    LONGS_EQUAL(2, utf8_ascii_length (noel_valid, 5));
+    LONGS_EQUAL(26,
+                utf8_ascii_length ("abcdefghijklmnopqrstuvwxyz", 26));
+    LONGS_EQUAL(7, utf8_ascii_length ("abcdefg\xc3\xabijklmnop", 17));
+    LONGS_EQUAL(8, utf8_ascii_length ("abcdefgh\xc3\xabjklmnop", 17));
+    LONGS_EQUAL(13, utf8_ascii_length ("abcdefghijklm\xc3\xabp", 16));
+    LONGS_EQUAL(10, utf8_ascii_length ("abcdefghijklm\xc3\xabp", 10));
+
+    /* number of printable ASCII chars */
+    LONGS_EQUAL(0, utf8_ascii_printable_length (NULL, 0));
+    LONGS_EQUAL(0, utf8_ascii_printable_length ("", 0));
+    LONGS_EQUAL(0, utf8_ascii_printable_length ("abc", -1));
+    LONGS_EQUAL(3, utf8_ascii_printable_length ("abc", 3));
+    LONGS_EQUAL(2, utf8_ascii_printable_length (noel_valid, 5));
+    LONGS_EQUAL(0, utf8_ascii_printable_length ("\x01", 1));
+    LONGS_EQUAL(0, utf8_ascii_printable_length ("\x7f", 1));
+    LONGS_EQUAL(26,
+                utf8_ascii_printable_length ("abcdefghijklmnopqrstuvwxyz",
+                                             26));
+    LONGS_EQUAL(18,
+                utf8_ascii_printable_length (" !\"#$%&'()*+,-./01~", 18));
+    LONGS_EQUAL(3, utf8_ascii_printable_length ("abc\tefghijklmnop", 16));
+    LONGS_EQUAL(11, utf8_ascii_printable_length ("abcdefghijk\x1fmnop", 16));
+    LONGS_EQUAL(9, utf8_ascii_printable_length ("abcdefghi\x7fklmnop", 16));
+    LONGS_EQUAL(12, utf8_ascii_printable_length ("abcdefghijkl\xc3\xab", 14));
+}
+
+/*
+ * Tests functions:
+ *   utf8_simd_set
+ *   utf8_ascii_length (with each SIMD instructions set)
+ *   utf8_ascii_printable_length (with each SIMD instructions set)
+ */
+
+TEST(CoreUtf8, AsciiSimd)
+{
+    char str[TEST_UTF8_SIMD_LENGTH + 1];
+    const unsigned char chars[] = { 0x01, 0x1F, 0x7F, 0x80, 0xC3, 0xFF };
+    int old_simd, simd, i, pos;
+
+    old_simd = utf8_simd;
+
+    LONGS_EQUAL(0, utf8_simd_set (UTF8_NUM_SIMD));
+    LONGS_EQUAL(old_simd, utf8_simd);
+
+    for (simd = 0; simd < UTF8_NUM_SIMD; simd++)
+    {
+        if (!utf8_simd_set (simd))
+            continue;
+        LONGS_EQUAL(simd, utf8_simd);
+        memset (str, 'a', TEST_UTF8_SIMD_LENGTH);
+        str[TEST_UTF8_SIMD_LENGTH] = '\0';
+        LONGS_EQUAL(TEST_UTF8_SIMD_LENGTH,
+                    utf8_ascii_length (str, TEST_UTF8_SIMD_LENGTH));
+        LONGS_EQUAL(TEST_UTF8_SIMD_LENGTH,
+                    utf8_ascii_printable_length (str, TEST_UTF8_SIMD_LENGTH));
+        for (pos = 0; pos < TEST_UTF8_SIMD_LENGTH; pos++)
+        {
+            LONGS_EQUAL(pos, utf8_ascii_length (str, pos));
+            LONGS_EQUAL(pos, utf8_ascii_printable_length (str, pos));
+            for (i = 0; i < (int)sizeof (chars); i++)
+            {
+                str[pos] = chars[i];
+                LONGS_EQUAL((chars[i] >= 0x80) ? pos : TEST_UTF8_SIMD_LENGTH,
+                            utf8_ascii_length (str, TEST_UTF8_SIMD_LENGTH));
+                LONGS_EQUAL(pos,
+                            utf8_ascii_printable_length (str,
+                                                         TEST_UTF8_SIMD_LENGTH));
+            }
+            str[pos] = 'a';
+        }
+    }
+
+    utf8_simd_set (old_simd);
+    LONGS_EQUAL(old_simd, utf8_simd);
+}
+
+/*
+ * Tests functions (benchmark, times are displayed if the environment variable
+ * "WEECHAT_TESTS_BENCHMARK" is set):
+ *   utf8_ascii_length (with each SIMD instructions set)
+ *   utf8_ascii_printable_length (with each SIMD instructions set)
+ */
+
+TEST(CoreUtf8, AsciiBenchmark)
+{
+    char *str;
+    struct timeval tv1, tv2, tv3;
+    int old_simd, simd, i, length, printable_length;
+
+    str = (char *)malloc (TEST_UTF8_BENCHMARK_LENGTH + 1);
+    CHECK(str);
+    for (i = 0; i < TEST_UTF8_BENCHMARK_LENGTH; i++)
+    {
+        str[i] = 32 + (i % 95);
+    }
+    str[TEST_UTF8_BENCHMARK_LENGTH] = '\0';
+
+    old_simd = utf8_simd;
+
+    for (simd = 0; simd < UTF8_NUM_SIMD; simd++)
+    {
+        if (!utf8_simd_set (simd))
+            continue;
+        length = 0;
+        printable_length = 0;
+        gettimeofday (&tv1, NULL);
+        for (i = 0; i < TEST_UTF8_BENCHMARK_LOOPS; i++)
+        {
+            length += utf8_ascii_length (str, TEST_UTF8_BENCHMARK_LENGTH);
+        }
+        gettimeofday (&tv2, NULL);
+        for (i = 0; i < TEST_UTF8_BENCHMARK_LOOPS; i++)
+        {
+            printable_length += utf8_ascii_printable_length (
+                str, TEST_UTF8_BENCHMARK_LENGTH);
+        }
+        gettimeofday (&tv3, NULL);
+        LONGS_EQUAL(TEST_UTF8_BENCHMARK_LOOPS * TEST_UTF8_BENCHMARK_LENGTH,
+                    length);
+        LONGS_EQUAL(TEST_UTF8_BENCHMARK_LOOPS * TEST_UTF8_BENCHMARK_LENGTH,
+                    printable_length);
+        if (getenv ("WEECHAT_TESTS_BENCHMARK"))
+        {
+            printf ("utf8 ascii (%s, %d x %d bytes): "
+                    "length: %lld us, printable length: %lld us\n",
+                    utf8_simd_string[simd],
+                    TEST_UTF8_BENCHMARK_LOOPS,
+                    TEST_UTF8_BENCHMARK_LENGTH,
+                    util_timeval_diff (&tv1, &tv2),
+                    util_timeval_diff (&tv2, &tv3));
+        }
+    }
+
+    utf8_simd_set (old_simd);
+
+    free (str);
 }
 
 /*
@@ -221,6 +398,11 @@ TEST(CoreUtf8, Normalize)
     utf8_normalize (str, '?');
     STRCMP_EQUAL(noel_invalid2_norm, str);
     free (str);
+
+    str = strdup ("abcdefghijklmnop\xebqrstuvwxyz\xc3\xab\xc3");
+    utf8_normalize (str, '?');
+    STRCMP_EQUAL("abcdefghijklmnop?qrstuvwxyz\xc3\xab?", str);
+    free (str);
 }
 
 /*
@@ -386,6 +568,9 @@ TEST(CoreUtf8, Size)
     LONGS_EQUAL(1, utf8_strlen ("€"));
     LONGS_EQUAL(1, utf8_strlen (cjk_yellow));
     LONGS_EQUAL(1, utf8_strlen (han_char));
+    LONGS_EQUAL(26, utf8_strlen ("abcdefghijklmnopqrstuvwxyz"));
+    LONGS_EQUAL(27, utf8_strlen ("abcdefghijklm\xc3\xabnopqrstuvwxyz"));
+    LONGS_EQUAL(3, utf8_strlen ("\xebl\xebl\xebl"));
 
     /* length of string (in chars, for max N bytes) */
     LONGS_EQUAL(0, utf8_strnlen (NULL, 0));
@@ -394,6 +579,10 @@ TEST(CoreUtf8, Size)
     LONGS_EQUAL(1, utf8_strnlen ("ëZ", 2));
     LONGS_EQUAL(1, utf8_strnlen ("€Z", 3));
     LONGS_EQUAL(1, utf8_strnlen (han_char_z, 4));
+    LONGS_EQUAL(10, utf8_strnlen ("abcdefghijklmnopqrstuvwxyz", 10));
+    LONGS_EQUAL(3, utf8_strnlen ("abc", 10));
+    LONGS_EQUAL(11,
+                utf8_strnlen ("abcdefghi\xc3\xabnopqrstuvwxyz", 12));
 
     /* length of string on screen (in chars) */
     LONGS_EQUAL(0, utf8_strlen_screen (NULL));
@@ -403,6 +592,12 @@ TEST(CoreUtf8, Size)
     LONGS_EQUAL(1, utf8_strlen_screen ("€"));
     LONGS_EQUAL(1, utf8_strlen_screen ("\x7f"));
     LONGS_EQUAL(2, utf8_strlen_screen (cjk_yellow));
+    LONGS_EQUAL(26, utf8_strlen_screen ("abcdefghijklmnopqrstuvwxyz"));
+    LONGS_EQUAL(27,
+                utf8_strlen_screen ("abcdefghijklm\xc3\xabnopqrstuvwxyz"));
+    LONGS_EQUAL(28,
+                utf8_strlen_screen ("abcdefghijklm" "\xe2\xbb\xa9"
+                                    "nopqrstuvwxyz"));
 }
 
 /*
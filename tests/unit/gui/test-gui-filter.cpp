@@ -0,0 +1,145 @@
+/*
+ * test-gui-filter.cpp - test filter functions
+ *
+ * Copyright (C) 2020 Sébastien Helleu <flashcode@flashtux.org>
+ *
+ * This file is part of WeeChat, the extensible chat client.
+ *
+ * WeeChat is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WeeChat is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WeeChat.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "CppUTest/TestHarness.h"
+
+extern "C"
+{
+#include "src/gui/gui-buffer.h"
+#include "src/gui/gui-chat.h"
+#include "src/gui/gui-filter.h"
+#include "src/gui/gui-line.h"
+}
+
+TEST_GROUP(GuiFilter)
+{
+};
+
+/*
+ * Tests functions:
+ *   gui_filter_buffer_update_cache
+ *   gui_filter_match_buffer
+ */
+
+TEST(GuiFilter, Cache)
+{
+    struct t_gui_buffer *buffer;
+    struct t_gui_filter *filter1, *filter2;
+    int generation;
+
+    buffer = gui_buffer_new (NULL, "test_filter",
+                             NULL, NULL, NULL, NULL, NULL, NULL);
+    CHECK(buffer);
+
+    generation = gui_filters_generation;
+    filter1 = gui_filter_new (1, "test1", "core.test_filter", "*", "abc");
+    CHECK(filter1);
+    CHECK(gui_filters_generation > generation);
+    filter2 = gui_filter_new (1, "test2", "core.other", "*", "abc");
+    CHECK(filter2);
+
+    LONGS_EQUAL(1, gui_filter_buffer_update_cache (buffer));
+    LONGS_EQUAL(gui_filters_generation, buffer->filters_cache_generation);
+    POINTERS_EQUAL(filter1, buffer->filters_cache[0]);
+    POINTERS_EQUAL(NULL, buffer->filters_cache[1]);
+    LONGS_EQUAL(1, gui_filter_match_buffer (NULL, buffer));
+    LONGS_EQUAL(1, gui_filter_match_buffer (filter1, buffer));
+    LONGS_EQUAL(0, gui_filter_match_buffer (filter2, buffer));
+
+    /* cache is rebuilt after buffer rename */
+    gui_buffer_set (buffer, "name", "other");
+    LONGS_EQUAL(0, buffer->filters_cache_generation);
+    LONGS_EQUAL(0, gui_filter_match_buffer (filter1, buffer));
+    LONGS_EQUAL(1, gui_filter_match_buffer (filter2, buffer));
+    POINTERS_EQUAL(filter2, buffer->filters_cache[0]);
+    POINTERS_EQUAL(NULL, buffer->filters_cache[1]);
+
+    /* cache is rebuilt after filter removal */
+    gui_filter_free (filter2);
+    LONGS_EQUAL(1, gui_filter_buffer_update_cache (buffer));
+    POINTERS_EQUAL(NULL, buffer->filters_cache[0]);
+
+    gui_filter_free (filter1);
+    gui_buffer_close (buffer);
+}
+
+/*
+ * Tests functions:
+ *   gui_filter_check_line
+ *   gui_filter_all_buffers
+ */
+
+TEST(GuiFilter, AllBuffers)
+{
+    struct t_gui_buffer *buffer;
+    struct t_gui_filter *filter;
+    struct t_gui_line *ptr_line;
+    int i, displayed_ok;
+
+    buffer = gui_buffer_new (NULL, "test_filter",
+                             NULL, NULL, NULL, NULL, NULL, NULL);
+    CHECK(buffer);
+
+    /* enough lines to filter them in threads */
+    for (i = 0; i < GUI_FILTER_THREADS_MIN_LINES; i++)
+    {
+        gui_chat_printf_date_tags (buffer, 0, (i % 2) ? "tag_odd" : NULL,
+                                   "line %d", i);
+    }
+    LONGS_EQUAL(GUI_FILTER_THREADS_MIN_LINES, buffer->lines->lines_count);
+    LONGS_EQUAL(0, buffer->lines->lines_hidden);
+
+    /* hide lines with tag "tag_odd" */
+    filter = gui_filter_new (1, "test", "core.test_filter", "tag_odd", "*");
+    CHECK(filter);
+    gui_filter_all_buffers (filter);
+    LONGS_EQUAL(GUI_FILTER_THREADS_MIN_LINES / 2,
+                buffer->lines->lines_hidden);
+    displayed_ok = 1;
+    i = 0;
+    for (ptr_line = buffer->lines->first_line; ptr_line;
+         ptr_line = ptr_line->next_line)
+    {
+        if (ptr_line->data->displayed != ((i % 2) ? 0 : 1))
+            displayed_ok = 0;
+        LONGS_EQUAL(ptr_line->data->displayed,
+                    gui_filter_check_line (ptr_line->data));
+        i++;
+    }
+    LONGS_EQUAL(1, displayed_ok);
+
+    /* disable filter: all lines are displayed */
+    filter->enabled = 0;
+    gui_filter_all_buffers (filter);
+    LONGS_EQUAL(0, buffer->lines->lines_hidden);
+
+    /* enable filter, then rename buffer: filter does not match any more */
+    filter->enabled = 1;
+    gui_filter_all_buffers (NULL);
+    LONGS_EQUAL(GUI_FILTER_THREADS_MIN_LINES / 2,
+                buffer->lines->lines_hidden);
+    gui_buffer_set (buffer, "name", "other");
+    gui_filter_all_buffers (NULL);
+    LONGS_EQUAL(0, buffer->lines->lines_hidden);
+
+    gui_filter_free (filter);
+    gui_buffer_close (buffer);
+}
@@ -23,8 +23,15 @@
 
 extern "C"
 {
+#include "src/core/wee-config.h"
+#include "src/core/wee-hashtable.h"
+#include "src/core/wee-hdata.h"
+#include "src/core/wee-hook.h"
 #include "src/core/wee-string.h"
+#include "src/gui/gui-buffer.h"
+#include "src/gui/gui-chat.h"
 #include "src/gui/gui-line.h"
+#include "src/plugins/plugin.h"
 }
 
 #define WEE_LINE_MATCH_TAGS(__result, __line_tags, __tags)              \
@@ -79,3 +86,271 @@ TEST(GuiLine, LineMatchTags)
     WEE_LINE_MATCH_TAGS(1, "irc_join,nick_test", "!irc_quit,!irc_302,!irc_notice");
     WEE_LINE_MATCH_TAGS(1, "irc_join,nick_test", "!irc_quit+!irc_302+!irc_notice");
 }
+
+/*
+ * Tests functions:
+ *   gui_line_search_string
+ */
+
+TEST(GuiLine, SearchString)
+{
+    regex_t regex;
+
+    LONGS_EQUAL(0, gui_line_search_string (NULL, NULL, 0, NULL));
+    LONGS_EQUAL(0, gui_line_search_string (NULL, "abc", 0, NULL));
+    LONGS_EQUAL(0, gui_line_search_string ("abc", NULL, 0, NULL));
+    LONGS_EQUAL(0, gui_line_search_string ("abc", "", 0, NULL));
+    LONGS_EQUAL(1, gui_line_search_string ("abc", "", 1, NULL));
+
+    /* substring */
+    LONGS_EQUAL(1, gui_line_search_string ("test abc def", "abc", 0, NULL));
+    LONGS_EQUAL(1, gui_line_search_string ("test ABC def", "abc", 0, NULL));
+    LONGS_EQUAL(1, gui_line_search_string ("test abc def", "abc", 1, NULL));
+    LONGS_EQUAL(0, gui_line_search_string ("test ABC def", "abc", 1, NULL));
+    LONGS_EQUAL(0, gui_line_search_string ("test abc def", "xyz", 0, NULL));
+
+    /* regex (text is ignored) */
+    LONGS_EQUAL(0, regcomp (&regex, "^t.*c", REG_EXTENDED));
+    LONGS_EQUAL(1, gui_line_search_string ("test abc def", NULL, 0, &regex));
+    LONGS_EQUAL(1, gui_line_search_string ("test abc def", "xyz", 0, &regex));
+    LONGS_EQUAL(0, gui_line_search_string ("a test abc", NULL, 0, &regex));
+    regfree (&regex);
+}
+
+/*
+ * Tests functions:
+ *   gui_line_search_text
+ */
+
+TEST(GuiLine, SearchText)
+{
+    struct t_gui_buffer *buffer;
+    struct t_gui_line *line;
+
+    buffer = gui_buffer_new (NULL, "test_search_text",
+                             NULL, NULL, NULL, NULL, NULL, NULL);
+    CHECK(buffer);
+    gui_chat_printf_date_tags (buffer, 0, NULL, "nick\tthe Message");
+    line = buffer->own_lines->last_line;
+
+    buffer->text_search = GUI_TEXT_SEARCH_BACKWARD;
+    buffer->text_search_exact = 0;
+    buffer->text_search_where = GUI_TEXT_SEARCH_IN_MESSAGE;
+
+    LONGS_EQUAL(0, gui_line_search_text (buffer, NULL));
+
+    /* empty input: no line is found (exact or not) */
+    gui_buffer_set (buffer, "input", "");
+    LONGS_EQUAL(0, gui_line_search_text (buffer, line));
+    buffer->text_search_exact = 1;
+    LONGS_EQUAL(0, gui_line_search_text (buffer, line));
+    buffer->text_search_exact = 0;
+
+    /* search in message */
+    gui_buffer_set (buffer, "input", "message");
+    LONGS_EQUAL(1, gui_line_search_text (buffer, line));
+    buffer->text_search_exact = 1;
+    LONGS_EQUAL(0, gui_line_search_text (buffer, line));
+    gui_buffer_set (buffer, "input", "Message");
+    LONGS_EQUAL(1, gui_line_search_text (buffer, line));
+    buffer->text_search_exact = 0;
+
+    /* search in prefix */
+    gui_buffer_set (buffer, "input", "nick");
+    LONGS_EQUAL(0, gui_line_search_text (buffer, line));
+    buffer->text_search_where = GUI_TEXT_SEARCH_IN_PREFIX;
+    LONGS_EQUAL(1, gui_line_search_text (buffer, line));
+
+    gui_buffer_set (buffer, "input", "");
+    buffer->text_search = GUI_TEXT_SEARCH_DISABLED;
+    gui_buffer_close (buffer);
+}
+
+/*
+ * Tests functions:
+ *   gui_chat_layout_changed
+ *   gui_line_hook_update
+ *   gui_line_hdata_line_data_update_cb
+ */
+
+TEST(GuiLine, LayoutInvalidate)
+{
+    struct t_gui_buffer *buffer;
+    struct t_gui_line_data *line_data;
+    struct t_hashtable *hashtable;
+    int generation;
+
+    buffer = gui_buffer_new (NULL, "test_layout",
+                             NULL, NULL, NULL, NULL, NULL, NULL);
+    CHECK(buffer);
+
+    gui_chat_printf_date_tags (buffer, 0, NULL, "nick\tmessage");
+    line_data = buffer->own_lines->last_line->data;
+
+    /* no layout cached on a new line */
+    LONGS_EQUAL(0, line_data->layout_generation);
+
+    /* layout is invalidated when a "look" option is changed */
+    generation = gui_chat_layout_generation;
+    gui_chat_layout_changed ();
+    CHECK(gui_chat_layout_generation != generation);
+    generation = gui_chat_layout_generation;
+    config_file_option_set (config_look_prefix_same_nick, "+", 1);
+    CHECK(gui_chat_layout_generation != generation);
+    config_file_option_reset (config_look_prefix_same_nick, 1);
+
+    /* layout of line is invalidated when the line is updated */
+    line_data->layout_generation = gui_chat_layout_generation;
+    hashtable = hashtable_new (8,
+                               WEECHAT_HASHTABLE_STRING,
+                               WEECHAT_HASHTABLE_STRING,
+                               NULL, NULL);
+    CHECK(hashtable);
+    hashtable_set (hashtable, "message", "a longer message");
+    LONGS_EQUAL(1, hdata_update (hook_hdata_get (NULL, "line_data"), line_data,
+                                 hashtable));
+    LONGS_EQUAL(0, line_data->layout_generation);
+    hashtable_free (hashtable);
+
+    gui_buffer_close (buffer);
+}
+
+/*
+ * Tests functions:
+ *   gui_line_new (line id)
+ */
+
+TEST(GuiLine, LineId)
+{
+    struct t_gui_buffer *buffer;
+    struct t_gui_line_data *line_data1, *line_data2;
+
+    buffer = gui_buffer_new (NULL, "test_line_id",
+                             NULL, NULL, NULL, NULL, NULL, NULL);
+    CHECK(buffer);
+
+    gui_chat_printf_date_tags (buffer, 0, NULL, "line 1");
+    line_data1 = buffer->own_lines->last_line->data;
+    LONGS_EQUAL(gui_line_last_id, line_data1->id);
+
+    gui_chat_printf_date_tags (NULL, 0, NULL, "line in core buffer");
+    gui_chat_printf_date_tags (buffer, 0, NULL, "line 2");
+    line_data2 = buffer->own_lines->last_line->data;
+    LONGS_EQUAL(gui_line_last_id, line_data2->id);
+    LONGS_EQUAL(line_data1->id + 2, line_data2->id);
+
+    gui_buffer_close (buffer);
+}
+
+/*
+ * Tests functions:
+ *   gui_line_export
+ *   gui_line_export_get
+ *   gui_line_export_free
+ */
+
+TEST(GuiLine, Export)
+{
+    struct t_gui_buffer *buffer;
+    struct t_gui_lines_export *lines_export;
+    struct t_gui_line_data **line_data;
+    long *ids, id_first;
+    time_t *dates;
+    char ***tags, **prefixes, **messages;
+    int *tags_count, count;
+
+    buffer = gui_buffer_new (NULL, "test_export",
+                             NULL, NULL, NULL, NULL, NULL, NULL);
+    CHECK(buffer);
+
+    POINTERS_EQUAL(NULL, gui_line_export (NULL, 0, 0, 0));
+
+    /* empty buffer */
+    lines_export = gui_line_export (buffer, 0, 0, 0);
+    CHECK(lines_export);
+    POINTERS_EQUAL(NULL, gui_line_export_get (lines_export, "message",
+                                              &count));
+    LONGS_EQUAL(0, count);
+    gui_line_export_free (lines_export);
+
+    gui_chat_printf_date_tags (buffer, 1000, "tag1,tag2", "nick1\tmessage 1");
+    id_first = buffer->own_lines->last_line->data->id;
+    gui_chat_printf_date_tags (buffer, 2000, NULL, "message 2");
+    gui_chat_printf_date_tags (buffer, 3000, "tag3", "nick3\tmessage 3");
+
+    /* all lines */
+    lines_export = gui_line_export (buffer, 0, 0, 0);
+    CHECK(lines_export);
+    POINTERS_EQUAL(NULL, gui_line_export_get (lines_export, "xxx", &count));
+    LONGS_EQUAL(0, count);
+    line_data = (struct t_gui_line_data **)gui_line_export_get (
+        lines_export, "line_data", &count);
+    LONGS_EQUAL(3, count);
+    POINTERS_EQUAL(buffer->own_lines->first_line->data, line_data[0]);
+    POINTERS_EQUAL(buffer->own_lines->last_line->data, line_data[2]);
+    ids = (long *)gui_line_export_get (lines_export, "id", NULL);
+    LONGS_EQUAL(id_first, ids[0]);
+    LONGS_EQUAL(id_first + 2, ids[2]);
+    dates = (time_t *)gui_line_export_get (lines_export, "date", NULL);
+    LONGS_EQUAL(1000, dates[0]);
+    LONGS_EQUAL(2000, dates[1]);
+    LONGS_EQUAL(3000, dates[2]);
+    tags_count = (int *)gui_line_export_get (lines_export, "tags_count",
+                                             NULL);
+    LONGS_EQUAL(2, tags_count[0]);
+    LONGS_EQUAL(0, tags_count[1]);
+    LONGS_EQUAL(1, tags_count[2]);
+    tags = (char ***)gui_line_export_get (lines_export, "tags_array", NULL);
+    STRCMP_EQUAL("tag2", tags[0][1]);
+    STRCMP_EQUAL("tag3", tags[2][0]);
+    prefixes = (char **)gui_line_export_get (lines_export, "prefix", NULL);
+    STRCMP_EQUAL("nick1", prefixes[0]);
+    messages = (char **)gui_line_export_get (lines_export, "message", NULL);
+    STRCMP_EQUAL("message 1", messages[0]);
+    STRCMP_EQUAL("message 2", messages[1]);
+    STRCMP_EQUAL("message 3", messages[2]);
+    /* strings are not copied */
+    POINTERS_EQUAL(buffer->own_lines->last_line->data->message, messages[2]);
+    gui_line_export_free (lines_export);
+
+    /* lines with id > first id */
+    lines_export = gui_line_export (buffer, id_first, 0, 0);
+    messages = (char **)gui_line_export_get (lines_export, "message", &count);
+    LONGS_EQUAL(2, count);
+    STRCMP_EQUAL("message 2", messages[0]);
+    gui_line_export_free (lines_export);
+
+    /* lines with date >= 3000 */
+    lines_export = gui_line_export (buffer, 0, 3000, 0);
+    messages = (char **)gui_line_export_get (lines_export, "message", &count);
+    LONGS_EQUAL(1, count);
+    STRCMP_EQUAL("message 3", messages[0]);
+    gui_line_export_free (lines_export);
+
+    /* last 2 lines */
+    lines_export = gui_line_export (buffer, 0, 0, 2);
+    messages = (char **)gui_line_export_get (lines_export, "message", &count);
+    LONGS_EQUAL(2, count);
+    STRCMP_EQUAL("message 2", messages[0]);
+    STRCMP_EQUAL("message 3", messages[1]);
+    gui_line_export_free (lines_export);
+
+    /* line with a date in the past: skipped, but older lines are exported */
+    gui_chat_printf_date_tags (buffer, 1500, NULL, "message 4");
+    lines_export = gui_line_export (buffer, 0, 2000, 0);
+    messages = (char **)gui_line_export_get (lines_export, "message", &count);
+    LONGS_EQUAL(2, count);
+    STRCMP_EQUAL("message 2", messages[0]);
+    STRCMP_EQUAL("message 3", messages[1]);
+    dates = (time_t *)gui_line_export_get (lines_export, "date", NULL);
+    LONGS_EQUAL(2000, dates[0]);
+    LONGS_EQUAL(3000, dates[1]);
+    gui_line_export_free (lines_export);
+    lines_export = gui_line_export (buffer, 0, 2000, 1);
+    messages = (char **)gui_line_export_get (lines_export, "message", &count);
+    LONGS_EQUAL(1, count);
+    STRCMP_EQUAL("message 3", messages[0]);
+    gui_line_export_free (lines_export);
+
+    gui_buffer_close (buffer);
+}
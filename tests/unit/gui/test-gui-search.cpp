@@ -0,0 +1,138 @@
+/*
+ * test-gui-search.cpp - test search functions
+ *
+ * Copyright (C) 2020 Sébastien Helleu <flashcode@flashtux.org>
+ *
+ * This file is part of WeeChat, the extensible chat client.
+ *
+ * WeeChat is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WeeChat is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WeeChat.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "CppUTest/TestHarness.h"
+
+extern "C"
+{
+#include "src/gui/gui-buffer.h"
+#include "src/gui/gui-chat.h"
+#include "src/gui/gui-line.h"
+#include "src/gui/gui-search.h"
+}
+
+TEST_GROUP(GuiSearch)
+{
+};
+
+/*
+ * Tests functions:
+ *   gui_search_new
+ *   gui_search_thread
+ *   gui_search_display_results
+ *   gui_search_free
+ */
+
+TEST(GuiSearch, Search)
+{
+    struct t_gui_buffer *buffer;
+    struct t_gui_search *search;
+    long id_found;
+    int i;
+
+    buffer = gui_buffer_new (NULL, "test_search",
+                             NULL, NULL, NULL, NULL, NULL, NULL);
+    CHECK(buffer);
+
+    for (i = 0; i < GUI_SEARCH_THREADS_CHUNK_LINES + 10; i++)
+    {
+        gui_chat_printf_date_tags (buffer, 0, NULL, "nick\tmessage %d", i);
+    }
+    gui_chat_printf_date_tags (buffer, 0, NULL, "other\tthe needle");
+    id_found = buffer->own_lines->last_line->data->id;
+
+    /* invalid arguments */
+    POINTERS_EQUAL(NULL, gui_search_new (NULL, 0, 0, 0, buffer));
+    POINTERS_EQUAL(NULL, gui_search_new ("", 0, 0, 0, buffer));
+
+    /* invalid regex */
+    POINTERS_EQUAL(NULL, gui_search_new ("(", 0, 1, 0, buffer));
+
+    /* copy of lines */
+    search = gui_search_new ("NEEDLE", 0, 0, 0, buffer);
+    CHECK(search);
+    POINTERS_EQUAL(search, last_gui_search);
+    LONGS_EQUAL(1, search->num_buffers);
+    STRCMP_EQUAL("core.test_search", search->buffers[0]);
+    LONGS_EQUAL(GUI_SEARCH_THREADS_CHUNK_LINES + 11, search->num_lines);
+    LONGS_EQUAL(2, search->num_chunks);
+    STRCMP_EQUAL("nick", search->lines[0].prefix);
+    STRCMP_EQUAL("message 0", search->lines[0].message);
+    LONGS_EQUAL(id_found,
+                search->lines[search->num_lines - 1].id);
+
+    /* search lines in this thread, then get results */
+    search->threads_running = 1;
+    gui_search_thread (search);
+    LONGS_EQUAL(0, search->threads_running);
+    LONGS_EQUAL(1, search->chunk_done[0]);
+    LONGS_EQUAL(1, search->chunk_done[1]);
+    LONGS_EQUAL(1, gui_search_display_results (search));
+    LONGS_EQUAL(1, search->finished);
+    LONGS_EQUAL(1, search->num_results);
+    LONGS_EQUAL(search->num_lines - 1, search->results[0]);
+    POINTERS_EQUAL(NULL, search->lines_data);
+    gui_search_free (search);
+
+    /* case sensitive search */
+    search = gui_search_new ("NEEDLE", 1, 0, 0, buffer);
+    CHECK(search);
+    search->threads_running = 1;
+    gui_search_thread (search);
+    LONGS_EQUAL(1, gui_search_display_results (search));
+    LONGS_EQUAL(0, search->num_results);
+    gui_search_free (search);
+
+    /* search in prefix */
+    search = gui_search_new ("nick", 0, 0, 1, buffer);
+    CHECK(search);
+    search->threads_running = 1;
+    gui_search_thread (search);
+    while (!gui_search_display_results (search))
+    {
+    }
+    LONGS_EQUAL(GUI_SEARCH_THREADS_CHUNK_LINES + 10, search->num_results);
+    gui_search_free (search);
+
+    /* regex */
+    search = gui_search_new ("^message 1[0-9]$", 0, 1, 0, buffer);
+    CHECK(search);
+    search->threads_running = 1;
+    gui_search_thread (search);
+    LONGS_EQUAL(1, gui_search_display_results (search));
+    LONGS_EQUAL(10, search->num_results);
+    LONGS_EQUAL(10, search->results[0]);
+    LONGS_EQUAL(19, search->results[9]);
+    gui_search_free (search);
+
+    /* cancelled search: no line is searched */
+    search = gui_search_new ("needle", 0, 0, 0, buffer);
+    CHECK(search);
+    search->cancelled = 1;
+    search->threads_running = 1;
+    gui_search_thread (search);
+    LONGS_EQUAL(0, search->chunk_done[0]);
+    gui_search_free (search);
+
+    POINTERS_EQUAL(NULL, gui_searches);
+
+    gui_buffer_close (buffer);
+}
@@ -0,0 +1,137 @@
+/*
+ * test-gui-window.cpp - test window functions
+ *
+ * Copyright (C) 2020 Sébastien Helleu <flashcode@flashtux.org>
+ *
+ * This file is part of WeeChat, the extensible chat client.
+ *
+ * WeeChat is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WeeChat is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WeeChat.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "CppUTest/TestHarness.h"
+
+extern "C"
+{
+#include <sys/time.h>
+#include "src/core/wee-config.h"
+#include "src/core/wee-config-file.h"
+#include "src/gui/gui-window.h"
+}
+
+TEST_GROUP(GuiWindow)
+{
+    struct timeval saved_frame_last;
+    int saved_frame_delayed;
+
+    void setup ()
+    {
+        saved_frame_last = gui_window_frame_last;
+        saved_frame_delayed = gui_window_frame_delayed;
+    }
+
+    void teardown ()
+    {
+        gui_window_frame_last = saved_frame_last;
+        gui_window_frame_delayed = saved_frame_delayed;
+        config_file_option_reset (config_look_refresh_max_fps, 1);
+    }
+};
+
+/*
+ * Tests functions:
+ *   gui_window_frame_get_delay
+ */
+
+TEST(GuiWindow, FrameGetDelay)
+{
+    struct timeval tv_now;
+    int delay;
+
+    /* no limit */
+    config_file_option_set (config_look_refresh_max_fps, "0", 1);
+    gettimeofday (&gui_window_frame_last, NULL);
+    LONGS_EQUAL(0, gui_window_frame_get_delay ());
+
+    /* max 10 fps: 100ms between two updates */
+    config_file_option_set (config_look_refresh_max_fps, "10", 1);
+
+    /* no update yet */
+    gui_window_frame_last.tv_sec = 0;
+    gui_window_frame_last.tv_usec = 0;
+    LONGS_EQUAL(0, gui_window_frame_get_delay ());
+
+    /* update just done */
+    gettimeofday (&gui_window_frame_last, NULL);
+    delay = gui_window_frame_get_delay ();
+    CHECK((delay > 0) && (delay <= 100));
+
+    /* update done 50ms ago */
+    gettimeofday (&tv_now, NULL);
+    gui_window_frame_last = tv_now;
+    if (gui_window_frame_last.tv_usec >= 50000)
+    {
+        gui_window_frame_last.tv_usec -= 50000;
+    }
+    else
+    {
+        gui_window_frame_last.tv_sec--;
+        gui_window_frame_last.tv_usec += 1000000 - 50000;
+    }
+    delay = gui_window_frame_get_delay ();
+    CHECK((delay > 0) && (delay <= 50));
+
+    /* update done 1 second ago */
+    gui_window_frame_last = tv_now;
+    gui_window_frame_last.tv_sec--;
+    LONGS_EQUAL(0, gui_window_frame_get_delay ());
+
+    /* update in future (system clock changed) */
+    gui_window_frame_last = tv_now;
+    gui_window_frame_last.tv_sec += 10;
+    LONGS_EQUAL(0, gui_window_frame_get_delay ());
+}
+
+/*
+ * Tests functions:
+ *   gui_window_frame_get_time_to_next
+ */
+
+TEST(GuiWindow, FrameGetTimeToNext)
+{
+    int timeout;
+
+    config_file_option_set (config_look_refresh_max_fps, "10", 1);
+    gettimeofday (&gui_window_frame_last, NULL);
+
+    /* no refresh delayed: timeout is unchanged */
+    gui_window_frame_delayed = 0;
+    LONGS_EQUAL(-1, gui_window_frame_get_time_to_next (-1));
+    LONGS_EQUAL(0, gui_window_frame_get_time_to_next (0));
+    LONGS_EQUAL(5, gui_window_frame_get_time_to_next (5));
+    LONGS_EQUAL(1000, gui_window_frame_get_time_to_next (1000));
+
+    /* refresh delayed: timeout is lowered to the delay */
+    gui_window_frame_delayed = 1;
+    LONGS_EQUAL(0, gui_window_frame_get_time_to_next (0));
+    LONGS_EQUAL(5, gui_window_frame_get_time_to_next (5));
+    timeout = gui_window_frame_get_time_to_next (-1);
+    CHECK((timeout > 0) && (timeout <= 100));
+    timeout = gui_window_frame_get_time_to_next (1000);
+    CHECK((timeout > 0) && (timeout <= 100));
+
+    /* refresh delayed but allowed now */
+    gui_window_frame_last.tv_sec--;
+    LONGS_EQUAL(0, gui_window_frame_get_time_to_next (-1));
+    LONGS_EQUAL(0, gui_window_frame_get_time_to_next (1000));
+}
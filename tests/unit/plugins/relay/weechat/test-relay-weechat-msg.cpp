@@ -0,0 +1,202 @@
+/*
+ * test-relay-weechat-msg.cpp - test relay weechat messages
+ *
+ * Copyright (C) 2020 Sébastien Helleu <flashcode@flashtux.org>
+ *
+ * This file is part of WeeChat, the extensible chat client.
+ *
+ * WeeChat is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WeeChat is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WeeChat.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "CppUTest/TestHarness.h"
+
+extern "C"
+{
+#include <stdio.h>
+#include <string.h>
+#include "src/core/wee-hashtable.h"
+#include "src/core/wee-hook.h"
+#include "src/gui/gui-buffer.h"
+#include "src/gui/gui-chat.h"
+#include "src/gui/gui-line.h"
+#include "src/plugins/plugin.h"
+#include "src/plugins/relay/weechat/relay-weechat-msg.h"
+}
+
+#define WEE_CHECK_MSG_EQUAL(__msg_expected, __msg)                      \
+    LONGS_EQUAL(__msg_expected->data_size, __msg->data_size);           \
+    MEMCMP_EQUAL(__msg_expected->data, __msg->data,                     \
+                 __msg_expected->data_size);
+
+TEST_GROUP(RelayWeechatMsg)
+{
+};
+
+/*
+ * Adds hdata of a buffer (number and full name) to a message, without
+ * compiled query.
+ */
+
+void
+test_relay_weechat_msg_add_buffer (struct t_relay_weechat_msg *msg,
+                                   struct t_gui_buffer *buffer)
+{
+    relay_weechat_msg_add_pointer (msg, buffer);
+    relay_weechat_msg_add_int (msg, buffer->number);
+    relay_weechat_msg_add_string (msg, buffer->full_name);
+}
+
+/*
+ * Tests functions:
+ *   relay_weechat_msg_add_hdata
+ *   relay_weechat_msg_add_hdata_query
+ *   relay_weechat_msg_hdata_query_get
+ *   relay_weechat_msg_hdata_query_compile
+ *   relay_weechat_msg_hdata_query_free_all
+ */
+
+TEST(RelayWeechatMsg, AddHdata)
+{
+    struct t_relay_weechat_msg *msg, *msg_expected;
+    struct t_gui_buffer *buffer;
+    struct t_gui_line *ptr_line;
+    char path[128];
+    int i;
+
+    relay_weechat_msg_hdata_query_free_all ();
+
+    buffer = gui_buffer_new (NULL, "test_relay_msg",
+                             NULL, NULL, NULL, NULL, NULL, NULL);
+    CHECK(buffer);
+    gui_chat_printf_date_tags (buffer, 0, "tag1,tag2", "line 1");
+    gui_chat_printf_date_tags (buffer, 0, NULL, "line 2");
+    CHECK(gui_buffers->next_buffer);
+
+    /* invalid hdata, list, variable and pointer */
+    msg = relay_weechat_msg_new (NULL);
+    CHECK(msg);
+    LONGS_EQUAL(0, relay_weechat_msg_add_hdata (msg, "gui_buffers", NULL));
+    LONGS_EQUAL(0, relay_weechat_msg_add_hdata (msg, "xxx:gui_buffers",
+                                                NULL));
+    LONGS_EQUAL(0, relay_weechat_msg_add_hdata (msg, "buffer:xxx", NULL));
+    LONGS_EQUAL(0, relay_weechat_msg_add_hdata (msg, "buffer:gui_buffers/xxx",
+                                                NULL));
+    LONGS_EQUAL(0, relay_weechat_msg_add_hdata (msg, "buffer:gui_buffers",
+                                                "xxx"));
+    LONGS_EQUAL(0, relay_weechat_msg_add_hdata (msg, "buffer:0x1", NULL));
+    relay_weechat_msg_free (msg);
+
+    /* list with count: first two buffers */
+    msg_expected = relay_weechat_msg_new (NULL);
+    CHECK(msg_expected);
+    relay_weechat_msg_add_type (msg_expected, RELAY_WEECHAT_MSG_OBJ_HDATA);
+    relay_weechat_msg_add_string (msg_expected, "buffer");
+    relay_weechat_msg_add_string (msg_expected, "number:int,full_name:str");
+    relay_weechat_msg_add_int (msg_expected, 2);
+    test_relay_weechat_msg_add_buffer (msg_expected, gui_buffers);
+    test_relay_weechat_msg_add_buffer (msg_expected, gui_buffers->next_buffer);
+    for (i = 0; i < 2; i++)
+    {
+        /* second time: the compiled query is read from the cache */
+        msg = relay_weechat_msg_new (NULL);
+        CHECK(msg);
+        LONGS_EQUAL(1, relay_weechat_msg_add_hdata (msg,
+                                                    "buffer:gui_buffers(2)",
+                                                    "number,full_name"));
+        WEE_CHECK_MSG_EQUAL(msg_expected, msg);
+        relay_weechat_msg_free (msg);
+    }
+    relay_weechat_msg_free (msg_expected);
+
+    /* list with negative count: last two buffers (from the last one) */
+    msg_expected = relay_weechat_msg_new (NULL);
+    CHECK(msg_expected);
+    relay_weechat_msg_add_type (msg_expected, RELAY_WEECHAT_MSG_OBJ_HDATA);
+    relay_weechat_msg_add_string (msg_expected, "buffer");
+    relay_weechat_msg_add_string (msg_expected, "number:int,full_name:str");
+    relay_weechat_msg_add_int (msg_expected, 2);
+    test_relay_weechat_msg_add_buffer (msg_expected, last_gui_buffer);
+    test_relay_weechat_msg_add_buffer (msg_expected,
+                                       last_gui_buffer->prev_buffer);
+    msg = relay_weechat_msg_new (NULL);
+    CHECK(msg);
+    LONGS_EQUAL(1, relay_weechat_msg_add_hdata (msg,
+                                                "buffer:last_gui_buffer(-2)",
+                                                "number,full_name"));
+    WEE_CHECK_MSG_EQUAL(msg_expected, msg);
+    relay_weechat_msg_free (msg);
+    relay_weechat_msg_free (msg_expected);
+
+    /* pointer with path to all lines, with an array (tags) */
+    msg_expected = relay_weechat_msg_new (NULL);
+    CHECK(msg_expected);
+    relay_weechat_msg_add_type (msg_expected, RELAY_WEECHAT_MSG_OBJ_HDATA);
+    relay_weechat_msg_add_string (msg_expected, "buffer/lines/line/line_data");
+    relay_weechat_msg_add_string (msg_expected,
+                                  "message:str,tags_array:arr");
+    relay_weechat_msg_add_int (msg_expected, 2);
+    for (ptr_line = buffer->own_lines->first_line; ptr_line;
+         ptr_line = ptr_line->next_line)
+    {
+        relay_weechat_msg_add_pointer (msg_expected, buffer);
+        relay_weechat_msg_add_pointer (msg_expected, buffer->own_lines);
+        relay_weechat_msg_add_pointer (msg_expected, ptr_line);
+        relay_weechat_msg_add_pointer (msg_expected, ptr_line->data);
+        relay_weechat_msg_add_string (msg_expected, ptr_line->data->message);
+        relay_weechat_msg_add_type (msg_expected, RELAY_WEECHAT_MSG_OBJ_STRING);
+        relay_weechat_msg_add_int (msg_expected, ptr_line->data->tags_count);
+        for (i = 0; i < ptr_line->data->tags_count; i++)
+        {
+            relay_weechat_msg_add_string (msg_expected,
+                                          ptr_line->data->tags_array[i]);
+        }
+    }
+    snprintf (path, sizeof (path),
+              "buffer:0x%lx/own_lines/first_line(*)/data",
+              (unsigned long)buffer);
+    msg = relay_weechat_msg_new (NULL);
+    CHECK(msg);
+    LONGS_EQUAL(1, relay_weechat_msg_add_hdata (msg, path,
+                                                "message,tags_array"));
+    WEE_CHECK_MSG_EQUAL(msg_expected, msg);
+    relay_weechat_msg_free (msg);
+
+    /* compiled queries are kept in cache (pointer is not in the key) */
+    CHECK(relay_weechat_msg_hdata_queries);
+    LONGS_EQUAL(3, relay_weechat_msg_hdata_queries->items_count);
+    CHECK(hashtable_has_key (relay_weechat_msg_hdata_queries,
+                             "buffer:/own_lines/first_line(*)/data"
+                             "|message,tags_array"));
+
+    /* cache is flushed when a plugin is unloaded */
+    hook_signal_send ("plugin_unloaded",
+                      WEECHAT_HOOK_SIGNAL_STRING, (void *)"test");
+    POINTERS_EQUAL(NULL, relay_weechat_msg_hdata_queries);
+
+    /* query is compiled again after flush of cache */
+    msg = relay_weechat_msg_new (NULL);
+    CHECK(msg);
+    LONGS_EQUAL(1, relay_weechat_msg_add_hdata (msg, path,
+                                                "message,tags_array"));
+    WEE_CHECK_MSG_EQUAL(msg_expected, msg);
+    relay_weechat_msg_free (msg);
+    relay_weechat_msg_free (msg_expected);
+    CHECK(relay_weechat_msg_hdata_queries);
+    LONGS_EQUAL(1, relay_weechat_msg_hdata_queries->items_count);
+
+    relay_weechat_msg_hdata_query_free_all ();
+    POINTERS_EQUAL(NULL, relay_weechat_msg_hdata_queries);
+
+    gui_buffer_close (buffer);
+}
@@ -0,0 +1,162 @@
+/*
+ * test-plugin-script.cpp - test script plugin functions
+ *
+ * Copyright (C) 2020 Sébastien Helleu <flashcode@flashtux.org>
+ *
+ * This file is part of WeeChat, the extensible chat client.
+ *
+ * WeeChat is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * WeeChat is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with WeeChat.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+#include "CppUTest/TestHarness.h"
+
+extern "C"
+{
+#include <string.h>
+#include "src/core/wee-hook.h"
+#include "src/plugins/plugin.h"
+#include "src/plugins/plugin-script.h"
+#include "src/plugins/plugin-script-api.h"
+}
+
+TEST_GROUP(PluginScript)
+{
+};
+
+/*
+ * Tests functions:
+ *   plugin_script_ptr2str
+ *   plugin_script_str2ptr
+ */
+
+TEST(PluginScript, Pointer)
+{
+    STRCMP_EQUAL("", plugin_script_ptr2str (NULL));
+    STRCMP_EQUAL("0x1a2b", plugin_script_ptr2str ((void *)0x1a2b));
+
+    POINTERS_EQUAL(NULL, plugin_script_str2ptr (weechat_plugins, NULL, NULL,
+                                                NULL));
+    POINTERS_EQUAL(NULL, plugin_script_str2ptr (weechat_plugins, NULL, NULL,
+                                                ""));
+    POINTERS_EQUAL(NULL, plugin_script_str2ptr (weechat_plugins, NULL, NULL,
+                                                "0x"));
+    POINTERS_EQUAL(NULL, plugin_script_str2ptr (weechat_plugins, NULL, NULL,
+                                                "1a2b"));
+    POINTERS_EQUAL(0x1a2b, plugin_script_str2ptr (weechat_plugins, NULL, NULL,
+                                                  "0x1a2b"));
+    POINTERS_EQUAL(0x1a2b, plugin_script_str2ptr (weechat_plugins, NULL, NULL,
+                                                  "0x1A2Bz"));
+}
+
+/*
+ * Callback of signal hook (used in test of batches).
+ */
+
+int
+test_plugin_script_signal_cb (const void *pointer, void *data,
+                              const char *signal, const char *type_data,
+                              void *signal_data)
+{
+    /* make C compiler happy */
+    (void) pointer;
+    (void) data;
+    (void) signal;
+    (void) type_data;
+    (void) signal_data;
+
+    return WEECHAT_RC_OK;
+}
+
+/*
+ * Callback of batch.
+ */
+
+int
+test_plugin_script_batch_cb (const void *pointer, void *data,
+                             struct t_infolist *events)
+{
+    /* make C compiler happy */
+    (void) pointer;
+    (void) data;
+    (void) events;
+
+    return WEECHAT_RC_OK;
+}
+
+/*
+ * Tests functions:
+ *   plugin_script_api_hook_is_script
+ *   plugin_script_api_hook_batch
+ */
+
+TEST(PluginScript, HookBatch)
+{
+    struct t_plugin_script script1, script2;
+    struct t_hook *hook, *hook_plugin;
+
+    memset (&script1, 0, sizeof (script1));
+    script1.name = (char *)"script1";
+    memset (&script2, 0, sizeof (script2));
+    script2.name = (char *)"script2";
+
+    hook = hook_signal (weechat_plugins, "test_plugin_script_batch",
+                        &test_plugin_script_signal_cb, NULL, NULL);
+    CHECK(hook);
+    hook_set (hook, "subplugin", "script1");
+    hook_plugin = hook_signal (weechat_plugins, "test_plugin_script_batch",
+                               &test_plugin_script_signal_cb, NULL, NULL);
+    CHECK(hook_plugin);
+
+    LONGS_EQUAL(0, plugin_script_api_hook_is_script (weechat_plugins, NULL,
+                                                     hook));
+    LONGS_EQUAL(0, plugin_script_api_hook_is_script (weechat_plugins,
+                                                     &script1, NULL));
+    LONGS_EQUAL(1, plugin_script_api_hook_is_script (weechat_plugins,
+                                                     &script1, hook));
+    LONGS_EQUAL(0, plugin_script_api_hook_is_script (weechat_plugins,
+                                                     &script2, hook));
+    LONGS_EQUAL(0, plugin_script_api_hook_is_script (weechat_plugins,
+                                                     &script1, hook_plugin));
+
+    /* hook of another script or of the plugin: refused */
+    LONGS_EQUAL(0, plugin_script_api_hook_batch (weechat_plugins, &script2,
+                                                 hook, 10, 0,
+                                                 &test_plugin_script_batch_cb,
+                                                 "func", ""));
+    POINTERS_EQUAL(NULL, hook->batch);
+    LONGS_EQUAL(0, plugin_script_api_hook_batch (weechat_plugins, &script1,
+                                                 hook_plugin, 10, 0,
+                                                 &test_plugin_script_batch_cb,
+                                                 "func", ""));
+    POINTERS_EQUAL(NULL, hook_plugin->batch);
+
+    /* hook of the script */
+    LONGS_EQUAL(1, plugin_script_api_hook_batch (weechat_plugins, &script1,
+                                                 hook, 10, 0,
+                                                 &test_plugin_script_batch_cb,
+                                                 "func", ""));
+    CHECK(hook->batch);
+    POINTERS_EQUAL(&script1, hook->batch->callback_pointer);
+
+    /* batches can not be disabled by another script */
+    LONGS_EQUAL(0, plugin_script_api_hook_batch (weechat_plugins, &script2,
+                                                 hook, 0, 0, NULL, NULL, NULL));
+    CHECK(hook->batch);
+    LONGS_EQUAL(1, plugin_script_api_hook_batch (weechat_plugins, &script1,
+                                                 hook, 0, 0, NULL, NULL, NULL));
+    POINTERS_EQUAL(NULL, hook->batch);
+
+    unhook (hook);
+    unhook (hook_plugin);
+}